@@ -34,6 +34,8 @@ namespace lsp
     {
         /**
          * This is helper class for reading audio content from LSPC files.
+         * Both PCM (LSPC_CODEC_PCM) and lossless (LSPC_CODEC_LOSSLESS) audio data is supported,
+         * the blocks of lossless audio data are decoded one by one by the calling thread.
          */
         class AudioReader
         {
@@ -47,7 +49,9 @@ namespace lsp
                     F_CLOSE_READER  = 1 << 1,
                     F_CLOSE_FILE    = 1 << 2,
                     F_REV_BYTES     = 1 << 3,
-                    F_DROP_READER   = 1 << 4
+                    F_DROP_READER   = 1 << 4,
+                    F_LOSSLESS      = 1 << 5,
+                    F_NATIVE        = 1 << 6
                 };
 
                 typedef struct buffer_t
@@ -58,6 +62,8 @@ namespace lsp
                 } buffer_t;
 
                 typedef void (*decode_func_t)(float *vp, const void *src, size_t ns);
+                typedef void (*convert_func_t)(void *dst, const void *src, size_t ns);
+                typedef void (*deinterleave_func_t)(float * const *dst, size_t off, const void *src, size_t channels, size_t frames);
 
             private:
                 audio_parameters_t          sParams;
@@ -67,9 +73,19 @@ namespace lsp
                 size_t                      nBPS;           // Bytes per sample
                 size_t                      nFrameSize;     // Size of frame
                 size_t                      nBytesLeft;
+                wsize_t                     nDataOff;       // Offset of the first frame in the chunk
                 buffer_t                    sBuf;
                 decode_func_t               pDecode;
+                convert_func_t              pConvert;       // Optimized decoding of samples including byte reversal
+                deinterleave_func_t         pDeinterleave;  // Optimized decoding of samples to planar buffers
                 float                      *pFBuffer;       // frame buffer
+                uint8_t                    *pCBuffer;       // Encoded block of the lossless codec
+                int32_t                    *pWork;          // Work buffer of the lossless codec
+                wsize_t                    *vBlocks;        // Offsets of the discovered blocks in the chunk
+                size_t                      nBlocks;        // Number of discovered blocks
+                size_t                      nBlockCap;      // Capacity of the list of blocks
+                size_t                      nBlock;         // Index of the next block to decode
+                wsize_t                     nBufFrame;      // Index of the first frame of the decoded block
 
             protected:
                 static void     decode_u8(float *vp, const void *src, size_t ns);
@@ -89,6 +105,10 @@ namespace lsp
                 status_t    read_audio_header(ChunkReader *rd);
                 status_t    apply_params(const audio_parameters_t *p);
                 status_t    fill_buffer();
+                void        drop_buffers();
+                status_t    add_block(wsize_t offset);
+                status_t    decode_block();
+                status_t    seek_block(wsize_t frame);
 
             public:
                 explicit AudioReader();
@@ -171,6 +191,23 @@ namespace lsp
                  */
                 ssize_t skip_frames(size_t frames);
 
+                /**
+                 * Set the read position to the specified frame. The frame is mapped to the fragment
+                 * of the chunk by the chunk index, so the data before the frame is not read. Seeking
+                 * backward is supported for all chunks opened by the LSPC file. After the seek,
+                 * read_samples(), read_frames() and skip_frames() continue from the specified frame.
+                 *
+                 * @param frame the index of the frame to seek
+                 * @return status of operation, STATUS_EOF if the frame is beyond the end of the stream
+                 */
+                status_t seek(wsize_t frame);
+
+                /**
+                 * Get the current read position
+                 * @return index of the next frame to read or error code as a negative value
+                 */
+                wssize_t position() const;
+
                 /**
                  * Obtain current audio parameters of the stream
                  * @param dst pointer to store audio parameters
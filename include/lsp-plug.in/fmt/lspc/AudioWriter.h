@@ -36,6 +36,8 @@ namespace lsp
     {
         /**
          * This is helper class for writing audio content to LSPC files.
+         * The audio data is stored as PCM (LSPC_CODEC_PCM) or as independently decodable
+         * blocks of the lossless codec (LSPC_CODEC_LOSSLESS).
          */
         class AudioWriter
         {
@@ -51,10 +53,14 @@ namespace lsp
                     F_REV_BYTES         = 1 << 3,
                     F_DROP_WRITER       = 1 << 4,
                     F_INTEGER_SAMPLE    = 1 << 5,
-                    F_DROP_FILE         = 1 << 6
+                    F_DROP_FILE         = 1 << 6,
+                    F_LOSSLESS          = 1 << 7,
+                    F_NATIVE            = 1 << 8
                 };
 
                 typedef void (* encode_func_t)(void *dst, const float *src, size_t ns);
+                typedef void (* convert_func_t)(void *dst, const void *src, size_t ns);
+                typedef void (* interleave_func_t)(void *dst, const float * const *src, size_t off, size_t channels, size_t frames);
 
             protected:
                 audio_parameters_t          sParams;
@@ -64,8 +70,14 @@ namespace lsp
                 size_t                      nBPS;           // Bytes per sample
                 size_t                      nFrameChannels; // Size of frame in channels
                 encode_func_t               pEncode;
+                convert_func_t              pConvert;       // Optimized encoding of samples including byte reversal
+                interleave_func_t           pInterleave;    // Optimized encoding of planar samples
                 float                      *pBuffer;
                 uint8_t                    *pFBuffer;       // frame buffer
+                uint8_t                    *pBlock;         // Pending block of the lossless codec
+                size_t                      nBlockFrames;   // Number of frames in the pending block
+                uint8_t                    *pCBuffer;       // Encoded block of the lossless codec
+                int32_t                    *pWork;          // Work buffer of the lossless codec
 
             protected:
                 static void     encode_u8(void *vp, const float *src, size_t ns);
@@ -85,6 +97,9 @@ namespace lsp
                 status_t parse_parameters(const audio_parameters_t *p);
                 status_t free_resources();
                 status_t write_header(ChunkWriter *wr);
+                status_t write_block(const uint8_t *data, size_t frames);
+                status_t write_encoded(const uint8_t *data, size_t frames);
+                status_t flush_block();
 
             public:
                 explicit AudioWriter();
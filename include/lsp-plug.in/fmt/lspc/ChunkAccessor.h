@@ -24,26 +24,61 @@
 
 #include <lsp-plug.in/runtime/version.h>
 #include <lsp-plug.in/common/types.h>
+#include <lsp-plug.in/common/atomic.h>
 #include <lsp-plug.in/common/status.h>
+#include <lsp-plug.in/ipc/Mutex.h>
 #include <lsp-plug.in/stdlib/stdio.h>
 
 namespace lsp
 {
     namespace lspc
     {
+        typedef struct chunk_fragment_t
+        {
+            uint32_t        magic;          // Chunk type
+            uint32_t        uid;            // Unique chunk identifier
+            uint32_t        flags;          // Chunk flags
+            uint32_t        size;           // Size of fragment data
+            wsize_t         offset;         // Offset of fragment data in file
+            wsize_t         position;       // Offset of fragment data in chunk, valid after indexing
+        } chunk_fragment_t;
+
+        typedef struct chunk_info_t
+        {
+            uint32_t        uid;            // Unique chunk identifier
+            uint32_t        magic;          // Chunk type
+            size_t          first;          // Index of the first fragment of the chunk
+            size_t          count;          // Number of fragments of the chunk
+        } chunk_info_t;
+
         typedef struct Resource
         {
             fhandle_t       fd;             // File handle
-            size_t          refs;           // Number of references
+            atomic_t        refs;           // Number of references, the resource is deleted on the last release()
             size_t          bufsize;        // Default buffer size
             uint32_t        chunk_id;       // Chunk identifier allocator
-            wsize_t         length;         // Length of the output file
+            wsize_t         length;         // Length of the output file or size of the input file
+            ipc::Mutex      lock;           // Lock for the allocation of identifiers and file space by writers
+
+            chunk_fragment_t   *frags;      // Fragments in the order of file, sorted by chunk identifier after indexing
+            size_t          nfrags;         // Number of fragments
+            size_t          capfrags;       // Capacity of the fragment list
+            chunk_info_t   *chunks;         // Chunks sorted by unique identifier, NULL if not indexed
+            size_t          nchunks;        // Number of chunks
 
             status_t        acquire();
             status_t        release();
             status_t        allocate(uint32_t *id);
+            status_t        reserve(wsize_t *pos, size_t count);
             status_t        write(const void *buf, size_t count);
+            status_t        write(wsize_t pos, const void *buf, size_t count);
             ssize_t         read(wsize_t pos, void *buf, size_t count);
+
+            status_t        write_fragment(uint32_t magic, uint32_t uid, uint32_t flags, const void *buf, size_t count);
+            status_t        add_fragment(uint32_t magic, uint32_t uid, uint32_t flags, uint32_t size, wsize_t offset);
+            status_t        build_index();
+            void            drop_index();
+            const chunk_info_t *find(uint32_t uid) const;
         } Resource;
 
         class ChunkAccessor
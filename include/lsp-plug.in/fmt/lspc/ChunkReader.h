@@ -41,11 +41,17 @@ namespace lsp
                 uint32_t            nUnread;            // Number of bytes still not read from chunk
                 size_t              nBufTail;           // Buffer tail
                 wsize_t             nFileOff;           // File read offset
+                wsize_t             nPosition;          // Read position within the chunk data
                 bool                bLast;
+                const chunk_info_t *pChunk;             // Index entry of the chunk, NULL if not indexed
+                size_t              nFragment;          // Current fragment of the indexed chunk
 
             protected:
                 explicit ChunkReader(Resource *fd, uint32_t magic, uint32_t uid);
 
+                void                set_chunk(const chunk_info_t *chunk);
+                status_t            next_fragment();
+
             public:
                 virtual ~ChunkReader();
 
@@ -73,6 +79,30 @@ namespace lsp
                  * @return number of skipped bytes or error code (negative)
                  */
                 virtual ssize_t     skip(size_t count);
+
+                /**
+                 * Set the read position within the chunk data. The position is mapped to the
+                 * fragment and the file offset by the chunk index, so both forward and backward
+                 * seeks are performed without reading the data. Chunks that were opened without
+                 * the index support only forward seeks.
+                 *
+                 * @param offset offset from the beginning of the chunk data, including the chunk header
+                 * @return status of operation, STATUS_NOT_SUPPORTED on backward seek of not indexed chunk
+                 */
+                virtual status_t    seek(wsize_t offset);
+
+                /**
+                 * Get the read position within the chunk data
+                 * @return read position within the chunk data
+                 */
+                inline wsize_t      position() const        { return nPosition;     }
+
+                /**
+                 * Get the number of bytes remaining in the chunk data
+                 * @return number of remaining bytes or error code (negative), -STATUS_NOT_SUPPORTED
+                 *   if the chunk has been opened without the index
+                 */
+                wssize_t            remaining() const;
         };
     }
 
@@ -27,11 +27,23 @@
 #include <lsp-plug.in/fmt/lspc/ChunkReader.h>
 #include <lsp-plug.in/fmt/lspc/ChunkWriter.h>
 #include <lsp-plug.in/io/Path.h>
+#include <lsp-plug.in/ipc/Mutex.h>
 
 namespace lsp
 {
     namespace lspc
     {
+        /**
+         * LSPC file. When the file is opened for reading, chunk readers use positional
+         * reads and do not share the file position, so several ChunkReader or AudioReader
+         * instances may read different chunks concurrently from different threads.
+         * When the file is opened for writing, each fragment atomically reserves the space
+         * at the end of file and is written with positional writes, so several ChunkWriter or
+         * AudioWriter instances may write different chunks concurrently from different threads,
+         * the fragments of chunks become interleaved in the file. All writers should be closed
+         * before the file is closed.
+         * The lookup of chunks is synchronized, open(), create() and close() are not.
+         */
         class File
         {
             protected:
@@ -44,10 +56,18 @@ namespace lsp
             protected:
                 Resource       *pFile;      // Shared resource
                 bool                bWrite;     // Read/Write mode
+                bool                bEmitIndex; // Emit index chunk on close
                 size_t              nHdrSize;   // Size of header
+                ipc::Mutex          sMutex;     // Mutex for the lookup of chunks
 
             protected:
                 Resource       *create_resource(fhandle_t fd);
+                status_t        load_index();
+                status_t        read_index();
+                status_t        read_index_entries(ChunkReader *rd, wsize_t offset);
+                status_t        scan_chunks();
+                status_t        write_index();
+                ChunkReader    *open_chunk(const chunk_info_t *chunk);
 
             public:
                 explicit File();
@@ -103,7 +123,7 @@ namespace lsp
                 status_t    close();
 
             public:
-                /** Write chunk
+                /** Write chunk, may be called concurrently from different threads
                  *
                  * @param magic magic number of the chunk type
                  * @return pointer to chunk writer
@@ -142,6 +162,22 @@ namespace lsp
                  * @return pointer to chunk reader
                  */
                 inline ChunkReader *find_chunk(uint32_t magic, uint32_t start_id = 1) { return find_chunk(magic, NULL, start_id); }
+
+            public:
+                /**
+                 * Enable or disable writing of the index chunk when the file opened for writing
+                 * is closed. The index allows readers to locate chunks without scanning the whole file.
+                 * Files without the index or with the outdated index are indexed by scanning the
+                 * chunk headers on the first lookup.
+                 * @param emit emit index flag
+                 */
+                inline void     set_emit_index(bool emit)   { bEmitIndex = emit;    }
+
+                /**
+                 * Check that the index chunk is written when the file is closed
+                 * @return true if the index chunk is written when the file is closed
+                 */
+                inline bool     emit_index() const          { return bEmitIndex;    }
         };
     }
 
@@ -97,12 +97,66 @@ namespace lsp
             uint32_t        reserved[6];    // Some reserved data for future use
         } chunk_audio_profile_t;
 
+        typedef struct chunk_waveform_header_t // Magic number: 'LCWH'
+        {
+            header_t        common;         // Common header data
+            uint16_t        channels;       // Number of channels
+            uint16_t        levels;         // Number of levels of the overview
+            uint32_t        chunk_id;       // Chunk identifier of related audio data, 0 if not present
+            uint32_t        sample_rate;    // Sample rate
+            uint32_t        base;           // Number of frames per entry at the first level
+            uint64_t        frames;         // Overall number of frames covered by the overview
+            uint32_t        reserved[4];    // Some reserved data for future use
+        } chunk_waveform_header_t;
+
+        typedef struct chunk_index_header_t // Magic number: 'INDX'
+        {
+            header_t        common;         // Common header data
+            uint32_t        fragments;      // Number of fragments stored in the index
+            uint32_t        reserved[4];    // Some reserved data for future use
+        } chunk_index_header_t;
+
+        typedef struct chunk_index_entry_t
+        {
+            uint32_t        magic;          // Chunk type of the fragment
+            uint32_t        uid;            // Unique chunk identifier of the fragment
+            uint32_t        flags;          // Chunk flags of the fragment
+            uint32_t        size;           // The size of fragment data after header
+            uint64_t        offset;         // Offset of the fragment header from the beginning of file
+        } chunk_index_entry_t;
+
+        /**
+         * The index chunk is written as the last chunk of the file, and the footer
+         * is stored as the last bytes of the index chunk data (and the file).
+         * The index chunk does not describe itself.
+         */
+        typedef struct chunk_index_footer_t
+        {
+            uint32_t        magic;          // Magic number, should be 'INDX'
+            uint32_t        reserved;       // Reserved data
+            uint64_t        offset;         // Offset of the index chunk header from the beginning of file
+        } chunk_index_footer_t;
+
+        /**
+         * The audio data encoded with LSPC_CODEC_LOSSLESS is stored as a sequence of blocks,
+         * each block consists of the block header and the encoded data. All blocks except
+         * the last one hold LSPC_LOSSLESS_BLOCK_FRAMES frames, each block can be decoded
+         * independently of other blocks.
+         */
+        typedef struct chunk_audio_block_t
+        {
+            uint32_t        size;           // Size of the encoded data after header
+            uint32_t        frames;         // Number of frames in the block
+        } chunk_audio_block_t;
+
     #pragma pack(pop)
 
     // Different chunk types
     #define LSPC_ROOT_MAGIC             0x4C535043
     #define LSPC_CHUNK_AUDIO            0x41554449
     #define LSPC_CHUNK_PROFILE          0x50524F46
+    #define LSPC_CHUNK_WAVEFORM         0x57415645
+    #define LSPC_CHUNK_INDEX            0x494E4458
 
     // Chunk flags
     #define LSPC_CHUNK_FLAG_LAST        (1 << 0)
@@ -148,6 +202,10 @@ namespace lsp
 
     // Different codec types
     #define LSPC_CODEC_PCM              0
+    #define LSPC_CODEC_LOSSLESS         1
+
+    // Number of frames per block of the lossless codec
+    #define LSPC_LOSSLESS_BLOCK_FRAMES  0x1000
 
     }
 } /* lsp */
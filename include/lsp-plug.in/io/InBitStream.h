@@ -39,13 +39,17 @@ namespace lsp
                 size_t          nWrapFlags;     // Wrap flags
                 umword_t        nBuffer;        // Fixed-size buffer
                 size_t          nBits;          // Number of bits stored
+                const uint8_t  *pHead;          // Current read position in the memory block
+                const uint8_t  *pTail;          // End of the memory block
 
             private:
                 InBitStream & operator = (const InBitStream &);
 
             protected:
                 status_t        fill();
+                void            refill();
                 void            unread(umword_t v, size_t bits);
+                inline bool     is_closed() const   { return (pIS == NULL) && (pHead == NULL);  }
 
             public:
                 explicit InBitStream();
@@ -84,6 +88,16 @@ namespace lsp
                  */
                 status_t wrap(IInStream *is, size_t flags = 0);
 
+                /** Wrap memory block. The bits are read directly from the block with machine
+                 * words which is much faster than reading from the stream. The block should
+                 * remain valid until the stream is closed.
+                 *
+                 * @param data pointer to the memory block
+                 * @param size size of the memory block in bytes
+                 * @return status of operation
+                 */
+                status_t wrap(const void *data, size_t size);
+
                 /** Open input stream associated with file. The Reader should be in closed state.
                  *
                  * @param path file location path
@@ -126,6 +140,17 @@ namespace lsp
                 inline ssize_t      readv(int32_t *value, size_t bits = sizeof(int32_t)*8)      { return readv(reinterpret_cast<uint32_t *>(value), bits);      }
                 ssize_t             readv(uint64_t *value, size_t bits = sizeof(uint64_t)*8);
                 inline ssize_t      readv(int64_t *value, size_t bits = sizeof(int64_t)*8)      { return readv(reinterpret_cast<uint64_t *>(value), bits);      }
+
+                /**
+                 * Read variable-length unsigned integer: the sequence of '1' bits terminated by '0' bit
+                 * (each '1' bit increases the size of the value by stepping bits) followed by the value
+                 *
+                 * @param value pointer to store the value
+                 * @param initial initial number of bits for the value
+                 * @param stepping number of bits to add to the value size for each '1' bit
+                 * @return status of operation
+                 */
+                status_t            read_uint(size_t *value, size_t initial, size_t stepping);
         };
     }
 }
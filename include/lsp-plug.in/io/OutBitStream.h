@@ -45,6 +45,9 @@ namespace lsp
                 size_t          nWrapFlags;     // Wrapping flags
                 umword_t        nBuffer;        // Fixed-size buffer
                 size_t          nBits;          // Number of bits stored
+                uint8_t        *pBlock;         // Memory block for collecting machine words
+                size_t          nBlockOff;      // Number of bytes stored in the memory block
+                status_t        nBlockError;    // Error of the output stream, further writes are refused
 
             public:
                 explicit OutBitStream();
@@ -52,6 +55,8 @@ namespace lsp
 
             protected:
                 status_t            do_flush_buffer();
+                status_t            flush_block();
+                status_t            put(umword_t value, size_t bits);
 
             public:
                 status_t            open(const char *path, size_t mode);
@@ -83,6 +88,17 @@ namespace lsp
                 inline status_t     writev(int32_t value, size_t bits = sizeof(int32_t)*8)      { return writev(uint32_t(value), bits);  }
                 status_t            writev(uint64_t value, size_t bits = sizeof(uint64_t)*8);
                 inline status_t     writev(int64_t value, size_t bits = sizeof(int64_t)*8)      { return writev(uint64_t(value), bits);  }
+
+                /**
+                 * Write variable-length unsigned integer: the sequence of '1' bits terminated by '0' bit
+                 * (each '1' bit increases the size of the value by stepping bits) followed by the value
+                 *
+                 * @param value value to write
+                 * @param initial initial number of bits for the value
+                 * @param stepping number of bits to add to the value size for each '1' bit
+                 * @return status of operation
+                 */
+                status_t            write_uint(size_t value, size_t initial, size_t stepping);
         };
     }
 }
@@ -35,13 +35,43 @@ namespace lsp
     {
         class OutFileStream: public IOutStream
         {
+            public:
+                enum latency_t
+                {
+                    LATENCY_BUCKETS     = 24
+                };
+
+                /**
+                 * Statistics of time spent by the caller while waiting for
+                 * the background writer in the asynchronous mode
+                 */
+                typedef struct latency_stats_t
+                {
+                    wsize_t     calls;                          // Number of write(), flush() and close() calls
+                    wsize_t     blocked;                        // Number of calls that have been blocked
+                    wsize_t     time;                           // Overall blocking time in microseconds
+                    wsize_t     histogram[LATENCY_BUCKETS];     // Element i > 0 counts calls blocked for [2^(i-1), 2^i) us, element 0 - non-blocked calls
+                } latency_stats_t;
+
+            protected:
+                struct async_t;
+
             private:
                 File       *pFD;
                 size_t      nWrapFlags;
+                async_t    *pAsync;
 
             private:
                 OutFileStream & operator = (const OutFileStream &);
 
+            protected:
+                static status_t async_writer(void *arg);
+
+                status_t    queue_buffer(size_t limit, wsize_t *wait);
+                status_t    drain(wsize_t *wait);
+                status_t    drop_async();
+                void        commit_latency(wsize_t wait);
+
             public:
                 explicit OutFileStream();
                 virtual ~OutFileStream();
@@ -59,6 +89,41 @@ namespace lsp
 
                 status_t open(const Path *path, size_t mode);
 
+                /**
+                 * Enable asynchronous write-behind mode: the written data is collected
+                 * into the bounded set of buffers which are written to the file by the
+                 * background thread. flush() and close() wait until all buffers are written,
+                 * errors of the background thread are reported by subsequent calls
+                 *
+                 * @param buffers number of buffers, should be at least 2
+                 * @param size size of each buffer in bytes
+                 * @return status of operation
+                 */
+                status_t    start_async(size_t buffers = 4, size_t size = 0x10000);
+
+                /**
+                 * Write all pending data, stop the background thread and
+                 * return to the synchronous mode
+                 * @return status of operation
+                 */
+                status_t    stop_async();
+
+                /**
+                 * Check that the stream operates in asynchronous mode
+                 * @return true if the stream operates in asynchronous mode
+                 */
+                inline bool async() const       { return pAsync != NULL; }
+
+                /**
+                 * Get statistics of time spent by the caller while waiting for free buffers
+                 * and write completion in asynchronous mode. Statistics are collected
+                 * since the last call of start_async()
+                 *
+                 * @param stats pointer to store statistics
+                 * @return status of operation
+                 */
+                status_t    get_latency(latency_stats_t *stats) const;
+
                 virtual wssize_t    position();
 
                 virtual ssize_t     write(const void *buf, size_t count);
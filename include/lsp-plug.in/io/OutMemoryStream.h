@@ -32,24 +32,50 @@ namespace lsp
         
         class OutMemoryStream: public IOutStream
         {
+            protected:
+                typedef struct segment_t
+                {
+                    uint8_t    *data;       // Segment data
+                    size_t      offset;     // Offset of the segment from the beginning of the stream
+                    size_t      size;       // Size of the segment
+                } segment_t;
+
             private:
-                uint8_t    *pData;
-                size_t      nSize;
-                size_t      nCapacity;
-                size_t      nQuantity;
-                size_t      nPosition;
+                uint8_t            *pData;
+                size_t              nSize;
+                mutable size_t      nCapacity;
+                size_t              nQuantity;
+                size_t              nPosition;
+                mutable segment_t  *vSegments;      // List of segments (segmented mode)
+                mutable size_t      nSegments;      // Number of segments
+                size_t              nSegCap;        // Capacity of the list of segments
+                bool                bSegmented;     // Segmented mode
+
+            protected:
+                status_t        add_segment(size_t size);
+                ssize_t         find_segment(size_t offset) const;
+                bool            flatten() const;
 
             public:
                 explicit OutMemoryStream();
                 explicit OutMemoryStream(size_t quantity);
+
+                /**
+                 * Create memory stream
+                 * @param quantity grow quantity of the memory buffer or the size of the segment
+                 * @param segmented segmented mode: the data is stored in the list of segments which are
+                 *   allocated as the stream grows, so the already written data is never copied
+                 */
+                explicit OutMemoryStream(size_t quantity, bool segmented);
                 virtual ~OutMemoryStream();
 
             public:
                 /**
-                 * Get current contents of the memory buffer
+                 * Get current contents of the memory buffer. In segmented mode the segments
+                 * are merged into the single memory buffer on demand
                  * @return contents of the memory buffer, may be NULL if there is no data
                  */
-                const uint8_t  *data() const        { return pData; }
+                const uint8_t  *data() const;
 
                 /**
                  * Get current size of memory buffer
@@ -69,6 +95,26 @@ namespace lsp
                  */
                 const size_t    quantity() const    { return nQuantity; }
 
+                /**
+                 * Check that stream operates in segmented mode
+                 * @return true if stream operates in segmented mode
+                 */
+                const bool      segmented() const   { return bSegmented; }
+
+                /**
+                 * Get number of segments that contain data
+                 * @return number of segments that contain data
+                 */
+                size_t          segments() const;
+
+                /**
+                 * Get the data of the segment without copying it
+                 * @param index index of the segment
+                 * @param size pointer to store the amount of data in the segment
+                 * @return pointer to the segment data or NULL if index is invalid
+                 */
+                const uint8_t  *segment(size_t index, size_t *size) const;
+
                 /**
                  * Release the internal buffer and return it's contents
                  * @return the pointer to data that should be free()'d after use
@@ -97,6 +143,13 @@ namespace lsp
                  */
                 status_t        reserve(size_t amount);
 
+                /**
+                 * Write all data to the output stream without intermediate copying
+                 * @param os pointer to the output stream
+                 * @return number of bytes written or negative error code
+                 */
+                wssize_t        sink(IOutStream *os);
+
             public:
                 virtual ssize_t     write(const void *buf, size_t count);
 
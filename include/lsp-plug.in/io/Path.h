@@ -25,6 +25,7 @@
 #include <lsp-plug.in/runtime/version.h>
 #include <lsp-plug.in/runtime/LSPString.h>
 #include <lsp-plug.in/common/status.h>
+#include <lsp-plug.in/io/PathView.h>
 #include <lsp-plug.in/lltl/types.h>
 #include <stdarg.h>
 
@@ -64,6 +65,8 @@ namespace lsp
 
                 inline void     fixup_path();
                 status_t        compute_relative(Path *base);
+                status_t        complete_parent(size_t len);
+                status_t        complete_child(size_t len, size_t off, bool success);
 
             public:
                 explicit Path();
@@ -76,6 +79,7 @@ namespace lsp
                 status_t        set(const char *path);
                 status_t        set(const LSPString *path);
                 status_t        set(const Path *path);
+                status_t        set(const PathView *path);
 
                 status_t        set(const char *path, const char *child);
                 status_t        set(const char *path, const LSPString *child);
@@ -137,6 +141,7 @@ namespace lsp
                 status_t        append_child(const char *path);
                 status_t        append_child(const LSPString *path);
                 status_t        append_child(const Path *path);
+                status_t        append_child(const PathView *path);
 
                 status_t        append(const char *path);
                 status_t        append(const LSPString *path);
@@ -194,8 +199,10 @@ namespace lsp
                 bool            equals(const Path *path) const;
                 bool            equals(const LSPString *path) const;
                 bool            equals(const char *path) const;
+                bool            equals(const PathView *path) const;
 
                 inline const    LSPString *as_string() const                        { return &sPath;                    }
+                inline void     view(PathView *dst) const                           { dst->set(&sPath);                 }
                 inline const    char *as_utf8() const                               { return sPath.get_utf8();          }
                 inline const    char *as_native(const char *charset = NULL) const   { return sPath.get_native(charset); }
                 inline void     take(Path *src)                                     { sPath.take(&src->sPath);          }
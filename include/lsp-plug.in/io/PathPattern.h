@@ -171,17 +171,85 @@ namespace lsp
                     lltl::darray<mregion_t> items;      // Matching regions
                 } brute_matcher_t;
 
+                enum dfa_context_t
+                {
+                    DFA_CTX_START,      // Region starts at the beginning of the string
+                    DFA_CTX_SEP,        // Region follows the path separator
+                    DFA_CTX_OTHER,      // Region follows any other character
+
+                    DFA_CTX_TOTAL
+                };
+
+                /**
+                 * The alphabet of the automaton: the character class 0 is the path separator,
+                 * class 1 is any character not mentioned in the pattern, classes 2 and above
+                 * are the literal characters of the pattern. Each class produces two input
+                 * symbols: the regular one and the one for the last character of the string.
+                 */
+                typedef struct alphabet_t
+                {
+                    lsp_wchar_t            *vChars;     // Sorted list of literal characters
+                    size_t                  nChars;     // Number of literal characters
+                    size_t                  nSymbols;   // Number of input symbols
+                    bool                    bFold;      // Fold character case
+                } alphabet_t;
+
+                typedef struct fa_t
+                {
+                    size_t                  nStates;    // Number of states
+                    size_t                  nCapacity;  // Capacity in states
+                    size_t                  nSymbols;   // Number of input symbols
+                    uint32_t               *vTrans;     // Transition table [nStates x nSymbols]
+                    uint8_t                *vAccept;    // Accept flag for each state
+                    uint32_t                vInit[DFA_CTX_TOTAL];   // Initial state for each context
+                } fa_t;
+
+                typedef struct fa_index_t
+                {
+                    uint32_t               *vData;      // Key data
+                    size_t                  nData;      // Size of key data
+                    size_t                  nDataCap;   // Capacity of key data
+                    uint32_t               *vItems;     // Items: offset, length, next item in bin
+                    size_t                  nItems;     // Number of items
+                    size_t                  nItemsCap;  // Capacity of items
+                    uint32_t               *vBins;      // Hash bins
+                    size_t                  nBins;      // Number of hash bins
+                } fa_index_t;
+
+                /**
+                 * Compiled deterministic finite automaton, stored as a single memory chunk
+                 */
+                typedef struct dfa_t
+                {
+                    size_t                  nStates;    // Number of states
+                    size_t                  nSymbols;   // Number of input symbols
+                    size_t                  nChars;     // Number of literal characters
+                    uint32_t                nStart;     // Initial state
+                    uint32_t                nReject;    // State that never leads to match
+                    uint32_t                nAccept;    // State that always leads to match
+                    bool                    bFold;      // Fold character case
+                    uint32_t                vAscii[0x80];   // Character classes for ASCII characters
+                    const lsp_wchar_t      *vChars;     // Sorted list of literal characters
+                    const uint32_t         *vTrans;     // Transition table [nStates x nSymbols]
+                    const uint8_t          *vAccept;    // Accept flag for each state
+                } dfa_t;
+
             protected:
                 LSPString                   sMask;
                 cmd_t                      *pRoot;
+                dfa_t                      *pDFA;
                 size_t                      nFlags;
 
             private:
                 PathPattern & operator = (const PathPattern &);
 
+                friend class PathPatternSet;
+
             protected:
                 status_t                    parse(const LSPString *pattern, size_t flags = NONE);
                 bool                        match_full(const LSPString *path) const;
+                bool                        match_string(const lsp_wchar_t *s, size_t len) const;
+                void                        compile();
 
                 static ssize_t              get_token(tokenizer_t *it);
                 static inline void          next_token(tokenizer_t *it);
@@ -220,6 +288,39 @@ namespace lsp
                 static bool                 brute_match_variable(brute_matcher_t *bm, size_t start, size_t count);
                 static bool                 brute_next_variable(brute_matcher_t *bm, size_t start, size_t count);
 
+                static ssize_t              decode_char(const lsp_wchar_t *pat, size_t *off, size_t len);
+                static status_t             collect_chars(lltl::darray<lsp_wchar_t> *dst, const LSPString *mask, const cmd_t *cmd, bool fold);
+                static uint32_t             char_class(const alphabet_t *ab, lsp_wchar_t ch);
+                static size_t               decode_items(uint32_t *items, const LSPString *mask, const cmd_t *cmd, const alphabet_t *ab);
+                static status_t             compile_cmd(fa_t *fa, const LSPString *mask, const cmd_t *cmd, const alphabet_t *ab);
+                static dfa_t               *build_dfa(const fa_t *fa, const alphabet_t *ab);
+                static void                 destroy_dfa(dfa_t *dfa);
+                static uint32_t             dfa_class(const dfa_t *dfa, lsp_wchar_t ch);
+                static uint32_t             dfa_step(const dfa_t *dfa, uint32_t state, lsp_wchar_t ch, bool last);
+                static bool                 dfa_match(const dfa_t *dfa, const lsp_wchar_t *s, size_t len);
+                static size_t               name_offset(const lsp_wchar_t *s, size_t len);
+
+                static void                 fa_init(fa_t *fa, size_t symbols);
+                static void                 fa_destroy(fa_t *fa);
+                static void                 fa_swap(fa_t *a, fa_t *b);
+                static ssize_t              fa_add_state(fa_t *fa, bool accept);
+                static void                 fa_invert(fa_t *fa);
+                static uint32_t             fa_dead_state(const fa_t *fa);
+                static status_t             fa_constant(fa_t *fa, bool empty, bool accept);
+                static status_t             fa_pattern(fa_t *fa, const uint32_t *items, size_t count);
+                static status_t             fa_any(fa_t *fa, const uint32_t *items, ssize_t count);
+                static status_t             fa_anypath(fa_t *fa, bool inverse);
+                static status_t             fa_combine(fa_t *fa, const fa_t *a, const fa_t *b, bool conj);
+                static status_t             fa_concat(fa_t *fa, const fa_t *a, const fa_t *b);
+                static status_t             fa_minimize(fa_t *fa);
+                static status_t             fa_reduce(fa_t *fa, dfa_context_t ctx);
+
+                static void                 fa_index_init(fa_index_t *idx);
+                static void                 fa_index_destroy(fa_index_t *idx);
+                static void                 fa_index_clear(fa_index_t *idx);
+                static ssize_t              fa_index_get(fa_index_t *idx, const uint32_t *key, size_t len);
+                static const uint32_t      *fa_index_key(const fa_index_t *idx, size_t id);
+
             public:
                 explicit PathPattern();
                 ~PathPattern();
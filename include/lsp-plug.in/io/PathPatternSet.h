@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 22 мар. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LSP_PLUG_IN_IO_PATHPATTERNSET_H_
+#define LSP_PLUG_IN_IO_PATHPATTERNSET_H_
+
+#include <lsp-plug.in/runtime/version.h>
+#include <lsp-plug.in/io/PathPattern.h>
+#include <lsp-plug.in/lltl/parray.h>
+
+namespace lsp
+{
+    namespace io
+    {
+        /**
+         * The set of path patterns which are tested against the path
+         * in a single pass over the characters of the path
+         */
+        class PathPatternSet
+        {
+            private:
+                PathPatternSet & operator = (const PathPatternSet &);
+
+            protected:
+                lltl::parray<PathPattern>   vItems;
+
+            protected:
+                ssize_t                     match_string(const LSPString *path, bool *matched, bool first) const;
+
+            public:
+                explicit PathPatternSet();
+                ~PathPatternSet();
+
+            public:
+                /**
+                 * Add pattern to the set
+                 * @param pattern pattern to add
+                 * @param flags pattern flags
+                 * @return status of operation
+                 */
+                status_t                    add(const char *pattern, size_t flags = PathPattern::NONE);
+                status_t                    add(const LSPString *pattern, size_t flags = PathPattern::NONE);
+                status_t                    add(const Path *pattern, size_t flags = PathPattern::NONE);
+                status_t                    add(const PathPattern *pattern);
+
+                /**
+                 * Remove pattern from the set
+                 * @param index index of the pattern
+                 * @return status of operation
+                 */
+                status_t                    remove(size_t index);
+
+                /**
+                 * Remove all patterns from the set
+                 */
+                void                        clear();
+
+                inline size_t               size() const                    { return vItems.size();         }
+                inline const PathPattern   *get(size_t index) const         { return vItems.get(index);     }
+
+                /**
+                 * Test the path for match
+                 * @param path path to test
+                 * @return index of the first matched pattern or negative value if there is no match
+                 */
+                ssize_t                     test(const char *path) const;
+                ssize_t                     test(const LSPString *path) const;
+                ssize_t                     test(const Path *path) const;
+
+                /**
+                 * Test the path for match and get match result for each pattern
+                 * @param path path to test
+                 * @param matched array of size() elements to store the match result of each pattern, may be NULL
+                 * @return number of matched patterns
+                 */
+                size_t                      match(const char *path, bool *matched) const;
+                size_t                      match(const LSPString *path, bool *matched) const;
+                size_t                      match(const Path *path, bool *matched) const;
+
+                void                        swap(PathPatternSet *dst);
+                inline void                 swap(PathPatternSet &dst)       { swap(&dst);                   }
+        };
+    }
+}
+
+#endif /* LSP_PLUG_IN_IO_PATHPATTERNSET_H_ */
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 24 мар. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LSP_PLUG_IN_IO_PATHVIEW_H_
+#define LSP_PLUG_IN_IO_PATHVIEW_H_
+
+#include <lsp-plug.in/runtime/version.h>
+#include <lsp-plug.in/runtime/LSPString.h>
+#include <lsp-plug.in/common/status.h>
+
+namespace lsp
+{
+    namespace io
+    {
+        class Path;
+
+        /**
+         * Non-owning view of the path: refers to the characters of the path or
+         * string without copying them. All operations with the view do not perform
+         * any memory allocations. The path separators of the viewed data are expected
+         * to be native (as stored by the io::Path object). The view becomes invalid
+         * when the viewed object is modified or destroyed.
+         */
+        class PathView
+        {
+            private:
+                const lsp_wchar_t  *pData;
+                size_t              nLength;
+
+            protected:
+                ssize_t             index_of_sep(size_t start) const;
+                ssize_t             rindex_of_sep() const;
+                ssize_t             rindex_of_sep(size_t end) const;
+                inline void         assign(const lsp_wchar_t *data, size_t length)  { pData = data; nLength = length;  }
+
+            public:
+                explicit PathView();
+                explicit PathView(const Path *path);
+                explicit PathView(const LSPString *path);
+                ~PathView();
+
+            public:
+                void                set(const lsp_wchar_t *path, size_t length);
+                void                set(const LSPString *path);
+                void                set(const LSPString *path, size_t first, size_t last);
+                void                set(const Path *path);
+                void                set(const PathView *path);
+
+                status_t            get(LSPString *path) const;
+                status_t            get(Path *path) const;
+
+                inline const lsp_wchar_t   *characters() const      { return pData;             }
+                inline size_t       length() const                  { return nLength;           }
+                inline bool         is_empty() const                { return nLength <= 0;      }
+                inline void         clear()                         { nLength = 0;              }
+                inline void         swap(PathView *dst)             { lsp::swap(pData, dst->pData); lsp::swap(nLength, dst->nLength); }
+
+            public:
+                status_t            get_last(PathView *path) const;
+                status_t            get_first(PathView *path) const;
+                status_t            get_ext(PathView *path) const;
+                status_t            get_noext(PathView *path) const;
+                status_t            get_parent(PathView *path) const;
+                status_t            get_root(PathView *path) const;
+
+                status_t            pop_last(PathView *path);
+                status_t            pop_first(PathView *path);
+
+                status_t            remove_last();
+                status_t            remove_first();
+                status_t            remove_base();
+                status_t            remove_root();
+                status_t            parent();
+
+                bool                is_absolute() const;
+                bool                is_relative() const;
+                bool                is_canonical() const;
+                bool                is_root() const;
+                bool                is_dot() const;
+                bool                is_dotdot() const;
+                bool                is_dots() const;
+
+                bool                equals(const PathView *path) const;
+                bool                equals(const LSPString *path) const;
+                bool                equals(const Path *path) const;
+
+                size_t              hash() const;
+        };
+    }
+}
+
+#endif /* LSP_PLUG_IN_IO_PATHVIEW_H_ */
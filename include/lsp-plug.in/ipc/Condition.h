@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 27 мар. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LSP_PLUG_IN_IPC_CONDITION_H_
+#define LSP_PLUG_IN_IPC_CONDITION_H_
+
+#include <lsp-plug.in/runtime/version.h>
+#include <lsp-plug.in/common/types.h>
+
+#if defined(PLATFORM_WINDOWS)
+    #include <synchapi.h>
+#else
+    #include <pthread.h>
+#endif /* PLATFORM_WINDOWS */
+
+namespace lsp
+{
+    namespace ipc
+    {
+        /**
+         * Condition variable bound to its own non-recursive mutex.
+         * All wait() and notify() calls should be issued while the
+         * condition is locked by the calling thread.
+         */
+        class Condition
+        {
+            private:
+#if defined(PLATFORM_WINDOWS)
+                mutable CRITICAL_SECTION        sMutex;
+                mutable CONDITION_VARIABLE      sCond;
+#else
+                mutable pthread_mutex_t         sMutex;
+                mutable pthread_cond_t          sCond;
+#endif /* PLATFORM_WINDOWS */
+
+            private:
+                Condition & operator = (const Condition & m);   // Deny copying
+
+            public:
+                explicit Condition();
+                ~Condition();
+
+            public:
+                /** Lock the mutex associated with the condition
+                 *
+                 * @return true on success
+                 */
+                bool lock() const;
+
+                /** Unlock the mutex associated with the condition
+                 *
+                 * @return true on success
+                 */
+                bool unlock() const;
+
+                /** Atomically unlock the mutex and wait for the notification,
+                 * the mutex is locked again before the method returns.
+                 * Spurious wake-ups are possible, so the caller should
+                 * check the waited state in a loop
+                 *
+                 * @return true on success
+                 */
+                bool wait() const;
+
+                /** Wake up one of the waiting threads
+                 *
+                 * @return true on success
+                 */
+                bool notify() const;
+
+                /** Wake up all waiting threads
+                 *
+                 * @return true on success
+                 */
+                bool notify_all() const;
+        };
+
+    } /* namespace ipc */
+} /* namespace lsp */
+
+#endif /* LSP_PLUG_IN_IPC_CONDITION_H_ */
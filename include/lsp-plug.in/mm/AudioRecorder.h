@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 3 апр. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LSP_PLUG_IN_MM_AUDIORECORDER_H_
+#define LSP_PLUG_IN_MM_AUDIORECORDER_H_
+
+#include <lsp-plug.in/runtime/version.h>
+#include <lsp-plug.in/common/types.h>
+#include <lsp-plug.in/common/atomic.h>
+#include <lsp-plug.in/common/status.h>
+#include <lsp-plug.in/ipc/Thread.h>
+#include <lsp-plug.in/mm/IOutAudioStream.h>
+
+namespace lsp
+{
+    namespace mm
+    {
+        /**
+         * Real-time safe audio recorder. The audio thread writes frames to the pre-allocated
+         * lock-free ring buffer which never blocks and never allocates memory, the background
+         * thread drains the buffer to the output audio stream. If the buffer is full, the frames
+         * that do not fit are dropped and the overflow is counted in the statistics.
+         *
+         * Only one thread is allowed to call write() and write_planar() at a time, all other
+         * methods should be called from the non-realtime thread.
+         */
+        class AudioRecorder
+        {
+            private:
+                AudioRecorder & operator = (const AudioRecorder &);
+
+            public:
+                static const size_t DEFAULT_CAPACITY    = 0x10000;      // Default capacity of the buffer in frames
+                static const size_t MAX_CAPACITY        = 0x40000000;   // Maximum capacity of the buffer in frames
+                static const size_t DEFAULT_PERIOD      = 10;           // Default polling period of the writer thread in milliseconds
+
+                typedef struct stats_t
+                {
+                    wsize_t         written;        // Number of frames accepted by the buffer
+                    wsize_t         stored;         // Number of frames passed to the output stream
+                    wsize_t         dropped;        // Number of frames dropped because of buffer overflow
+                    wsize_t         overflows;      // Number of write requests that caused buffer overflow
+                    size_t          peak;           // Maximum number of frames held by the buffer
+                    size_t          capacity;       // Capacity of the buffer in frames
+                    status_t        error;          // The first error reported by the output stream
+                } stats_t;
+
+            protected:
+                IOutAudioStream    *pOut;           // Output stream
+                size_t              nWrapFlags;     // Wrap flags
+                ipc::Thread        *pThread;        // Writer thread
+                f32_t              *vData;          // Ring buffer, interleaved samples
+                size_t              nChannels;      // Number of channels
+                size_t              nCapacity;      // Capacity of the buffer in frames, power of 2
+                size_t              nPeriod;        // Polling period in milliseconds
+                atomic_t            nHead;          // Number of frames written to the buffer, modified by the producer
+                atomic_t            nTail;          // Number of frames read from the buffer, modified by the consumer
+                volatile bool       bStop;          // Stop request
+                volatile status_t   nError;         // Error reported by the output stream
+
+                atomic_t            nProdSeq;       // Sequence of producer statistics, odd while being updated
+                atomic_t            nConsSeq;       // Sequence of consumer statistics, odd while being updated
+                volatile wsize_t    nWritten;       // Statistics, modified by the producer
+                volatile wsize_t    nDropped;
+                volatile wsize_t    nOverflows;
+                volatile size_t     nPeak;
+                volatile wsize_t    nStored;        // Statistics, modified by the consumer
+
+            protected:
+                static status_t     writer_proc(void *arg);
+
+                void                do_close();
+                status_t            run();
+                size_t              drain();
+                void                commit(size_t fill, size_t written, size_t frames);
+
+            public:
+                explicit AudioRecorder();
+                ~AudioRecorder();
+
+            public:
+                /**
+                 * Open the recorder, the ring buffer is allocated here
+                 * @param os output stream to write the audio data
+                 * @param capacity capacity of the ring buffer in frames, rounded up to the power of 2
+                 * @param flags wrapping flags that define what to do with the stream on close
+                 * @return status of operation
+                 */
+                status_t            open(IOutAudioStream *os, size_t capacity = DEFAULT_CAPACITY, size_t flags = 0);
+
+                /**
+                 * Launch the writer thread
+                 * @return status of operation
+                 */
+                status_t            start();
+
+                /**
+                 * Stop the writer thread, all frames stored in the buffer are written
+                 * to the output stream and the output stream is flushed
+                 * @return status of operation, the error reported by the output stream if any
+                 */
+                status_t            stop();
+
+                /**
+                 * Stop the recording and close the recorder
+                 * @return status of operation
+                 */
+                status_t            close();
+
+                /**
+                 * Write interleaved frames to the buffer, the method is real-time safe
+                 * @param src interleaved 32-bit floating-point samples
+                 * @param frames number of frames to write
+                 * @return number of frames stored in the buffer or negative error code
+                 */
+                ssize_t             write(const f32_t *src, size_t frames);
+
+                /**
+                 * Write planar frames to the buffer, the method is real-time safe
+                 * @param src array of channels() pointers to 32-bit floating-point samples
+                 * @param frames number of frames to write
+                 * @return number of frames stored in the buffer or negative error code
+                 */
+                ssize_t             write_planar(const f32_t * const *src, size_t frames);
+
+                /**
+                 * Obtain the statistics of the recorder, can be called concurrently with
+                 * the producer and the writer thread
+                 * @param dst pointer to store the statistics
+                 */
+                void                get_stats(stats_t *dst) const;
+
+                /**
+                 * Set the polling period of the writer thread
+                 * @param millis polling period in milliseconds
+                 */
+                void                set_period(size_t millis);
+
+            public:
+                inline bool         is_opened() const           { return vData != NULL;     }
+                inline bool         is_running() const          { return pThread != NULL;   }
+                inline size_t       channels() const            { return nChannels;         }
+                inline size_t       capacity() const            { return nCapacity;         }
+                inline size_t       period() const              { return nPeriod;           }
+        };
+
+    } /* namespace mm */
+} /* namespace lsp */
+
+#endif /* LSP_PLUG_IN_MM_AUDIORECORDER_H_ */
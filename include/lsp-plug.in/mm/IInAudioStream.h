@@ -190,6 +190,14 @@ namespace lsp
                 inline ssize_t      read_s32(void *dst, size_t nframes)     { return read(static_cast<int32_t *>(dst), nframes);    }
                 inline ssize_t      read_f32(void *dst, size_t nframes)     { return read(static_cast<f32_t *>(dst), nframes);      }
                 inline ssize_t      read_f64(void *dst, size_t nframes)     { return read(static_cast<f64_t *>(dst), nframes);      }
+
+                /**
+                 * Read frames and store samples of each channel to the separate buffer
+                 * @param dst array of buffers, one buffer per channel, NULL buffers are skipped
+                 * @param nframes number of frames to read
+                 * @return number of frames actually read or negative status of operation
+                 */
+                virtual ssize_t     read_planar(f32_t * const *dst, size_t nframes);
         };
     
     } /* namespace mm */
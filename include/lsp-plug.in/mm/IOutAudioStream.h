@@ -44,6 +44,7 @@ namespace lsp
                 uint8_t            *pBuffer;            // Buffer for sample format conversion
                 size_t              nBufSize;           // Size of buffer
                 audio_stream_t      sFormat;            // Audio stream format
+                size_t              nQuantize;          // Quantization mode
 
             protected:
                 void                do_close();
@@ -83,6 +84,28 @@ namespace lsp
                  */
                 virtual size_t      select_format(size_t rfmt);
 
+                /**
+                 * Select intermediate integer format for quantization of floating-point
+                 * samples when the actual format is wider than the sample format of the stream
+                 * @param afmt actual sample format
+                 * @param rfmt requested sample format
+                 * @return intermediate sample format or SFMT_NONE if not required
+                 */
+                size_t              select_quantize_format(size_t afmt, size_t rfmt);
+
+                /**
+                 * Convert samples to the actual sample format, the result is stored
+                 * at the beginning of the internal buffer
+                 * @param qbuf buffer to store intermediate quantized samples
+                 * @param src source samples, may be modified if not in CPU byte order
+                 * @param samples number of samples to convert
+                 * @param afmt actual sample format
+                 * @param qfmt intermediate sample format or SFMT_NONE
+                 * @param rfmt sample format of source samples
+                 * @return true on success
+                 */
+                bool                encode_samples(void *qbuf, void *src, size_t samples, size_t afmt, size_t qfmt, size_t rfmt);
+
             public:
                 explicit IOutAudioStream();
                 virtual ~IOutAudioStream();
@@ -132,6 +155,21 @@ namespace lsp
                  */
                 inline size_t       format() const              { return sFormat.format;        }
 
+                /**
+                 * Get quantization mode applied when floating-point samples are
+                 * written to the stream with integer sample format
+                 * @return quantization mode, see quantize_t
+                 */
+                inline size_t       quantize() const            { return nQuantize;             }
+
+                /**
+                 * Set quantization mode applied when floating-point samples are
+                 * written to the stream with integer sample format
+                 * @param mode quantization mode, see quantize_t
+                 * @return status of operation
+                 */
+                virtual status_t    set_quantize(size_t mode);
+
                 /**
                  * Flush audio stream
                  * @return status of operations
@@ -186,6 +224,14 @@ namespace lsp
                 inline ssize_t      write_s32(const void *dst, size_t nframes)    { return write(static_cast<const int32_t *>(dst), nframes);   }
                 inline ssize_t      write_f32(const void *dst, size_t nframes)    { return write(static_cast<const f32_t *>(dst), nframes);     }
                 inline ssize_t      write_f64(const void *dst, size_t nframes)    { return write(static_cast<const f64_t *>(dst), nframes);     }
+
+                /**
+                 * Write frames formed of samples stored in separate buffers
+                 * @param src array of buffers, one buffer per channel, NULL buffers are written as silence
+                 * @param nframes number of frames to write
+                 * @return number of frames actually written or negative status of operation
+                 */
+                virtual ssize_t     write_planar(const f32_t * const *src, size_t nframes);
         };
     
     } /* namespace mm */
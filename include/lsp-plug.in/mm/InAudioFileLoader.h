@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 31 мар. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LSP_PLUG_IN_MM_INAUDIOFILELOADER_H_
+#define LSP_PLUG_IN_MM_INAUDIOFILELOADER_H_
+
+#include <lsp-plug.in/runtime/version.h>
+#include <lsp-plug.in/common/types.h>
+#include <lsp-plug.in/common/status.h>
+#include <lsp-plug.in/runtime/LSPString.h>
+#include <lsp-plug.in/io/Path.h>
+#include <lsp-plug.in/mm/types.h>
+
+namespace lsp
+{
+    namespace mm
+    {
+        /**
+         * Loader of the whole audio file (or its range) into memory. The range of frames
+         * is split into segments which are decoded by several threads, each thread uses
+         * its own instance of InAudioFileStream and converts samples directly into the
+         * destination buffer. Files that do not support random access are decoded by
+         * the caller's thread.
+         */
+        class InAudioFileLoader
+        {
+            private:
+                InAudioFileLoader & operator = (const InAudioFileLoader &);
+
+            public:
+                /**
+                 * Progress callback, is always called from the thread that issued the load() call
+                 * @param loaded number of frames loaded
+                 * @param total total number of frames to load
+                 * @param arg argument passed to the load() call
+                 * @return status of operation, any value other than STATUS_OK cancels loading
+                 */
+                typedef status_t (*progress_t)(wsize_t loaded, wsize_t total, void *arg);
+
+                static const size_t MIN_SEGMENT     = 0x4000;       // Minimum number of frames per segment
+                static const size_t MAX_SEGMENT     = 0x100000;     // Maximum number of frames per segment
+
+            protected:
+                struct worker_t;
+                struct task_t;
+
+            protected:
+                LSPString           sPath;              // Path to the file
+                audio_stream_t      sFormat;            // Format of the file
+                bool                bSeekable;          // File supports random access
+                bool                bOpened;            // Loader is opened
+                size_t              nThreads;           // Number of threads, 0 for automatic
+
+            protected:
+                static status_t     worker_proc(void *arg);
+
+            public:
+                explicit InAudioFileLoader();
+                ~InAudioFileLoader();
+
+            public:
+                /**
+                 * Open audio file
+                 * @param path path to the audio file
+                 * @return status of operation
+                 */
+                status_t            open(const char *path);
+
+                /**
+                 * Open audio file
+                 * @param path path to the audio file
+                 * @return status of operation
+                 */
+                status_t            open(const LSPString *path);
+
+                /**
+                 * Open audio file
+                 * @param path path to the audio file
+                 * @return status of operation
+                 */
+                status_t            open(const io::Path *path);
+
+                /**
+                 * Close the loader
+                 * @return status of operation
+                 */
+                status_t            close();
+
+                /**
+                 * Obtain the format of the audio file
+                 * @param dst pointer to store the format
+                 * @return status of operation
+                 */
+                status_t            info(audio_stream_t *dst) const;
+
+                inline size_t       sample_rate() const         { return sFormat.srate;         }
+                inline size_t       channels() const            { return sFormat.channels;      }
+                inline wssize_t     length() const              { return sFormat.frames;        }
+                inline bool         is_seekable() const         { return bSeekable;             }
+
+                /**
+                 * Get number of threads used for decoding
+                 * @return number of threads, 0 means the number of available processors
+                 */
+                inline size_t       threads() const             { return nThreads;              }
+
+                /**
+                 * Set number of threads used for decoding
+                 * @param threads number of threads, 0 means the number of available processors
+                 */
+                inline void         set_threads(size_t threads) { nThreads = threads;           }
+
+                /**
+                 * Load the range of frames into the memory buffer
+                 * @param dst destination buffer for interleaved samples, should be
+                 *   of at least count * channels() samples size
+                 * @param fmt sample format of the destination buffer, the format should have
+                 *   CPU byte order, 24-bit formats are not supported
+                 * @param first index of the first frame to load
+                 * @param count number of frames to load
+                 * @param progress progress callback, may be NULL
+                 * @param arg argument to pass to the progress callback
+                 * @return number of frames loaded or negative error code, the number of frames
+                 *   is less than count only if the range exceeds the length of the file
+                 */
+                wssize_t            load(void *dst, size_t fmt, wsize_t first, wsize_t count,
+                                         progress_t progress = NULL, void *arg = NULL);
+        };
+
+    } /* namespace mm */
+} /* namespace lsp */
+
+#endif /* LSP_PLUG_IN_MM_INAUDIOFILELOADER_H_ */
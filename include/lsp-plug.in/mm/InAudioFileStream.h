@@ -39,6 +39,8 @@ namespace lsp
 {
     namespace mm
     {
+        class RIFFReader;
+
     #ifndef USE_LIBSNDFILE
         class ACMStream;
         class MMIOReader;
@@ -60,6 +62,7 @@ namespace lsp
             #endif
 
                 // Common parameters
+                RIFFReader         *pRIFF;
                 bool                bSeekable;
 
             protected:
@@ -70,10 +73,14 @@ namespace lsp
                 ssize_t             read_acm_convert(void *dst, size_t nframes, size_t fmt);
             #endif
 
+                status_t            open_riff(const LSPString *path);
+
                 virtual ssize_t     direct_read(void *dst, size_t nframes, size_t fmt);
 
                 virtual size_t      select_format(size_t fmt);
 
+                virtual ssize_t     conv_read(void *dst, size_t nframes, size_t fmt);
+
                 status_t            close_handle();
 
             public:
@@ -104,6 +111,12 @@ namespace lsp
 
                 virtual status_t    close();
 
+                /**
+                 * Check that the stream supports random access with seek()
+                 * @return true if the stream supports random access
+                 */
+                inline bool         is_seekable() const         { return bSeekable;     }
+
                 virtual wssize_t    skip(wsize_t nframes);
 
                 virtual wssize_t    seek(wsize_t nframes);
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 29 мар. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LSP_PLUG_IN_MM_INAUDIORESAMPLER_H_
+#define LSP_PLUG_IN_MM_INAUDIORESAMPLER_H_
+
+#include <lsp-plug.in/runtime/version.h>
+#include <lsp-plug.in/common/types.h>
+#include <lsp-plug.in/mm/IInAudioStream.h>
+
+namespace lsp
+{
+    namespace mm
+    {
+        /**
+         * Input audio stream that converts the sample rate of another audio stream
+         * on the fly. The conversion is performed by the polyphase windowed-sinc
+         * filter, the stream yields 32-bit floating-point samples. The amount of
+         * memory used by the stream does not depend on the length of the wrapped stream.
+         */
+        class InAudioResampler: public IInAudioStream
+        {
+            private:
+                InAudioResampler & operator = (const InAudioResampler &);
+
+            public:
+                static const size_t MAX_PHASES          = 0x400;    // Maximum number of filter phases
+                static const size_t MAX_RATIO           = 16;       // Maximum ratio between sample rates
+
+            protected:
+                IInAudioStream     *pIn;                // Wrapped stream
+                size_t              nWrapFlags;         // Wrap flags
+                wssize_t            nInOrigin;          // Position of the wrapped stream treated as the first frame
+
+                size_t              nUp;                // Interpolation factor
+                size_t              nDown;              // Decimation factor
+                size_t              nPhases;            // Number of filter phases
+                size_t              nTaps;              // Number of filter taps per phase, 0 if no conversion needed
+                f32_t              *vFilter;            // Filter coefficients, nPhases * nTaps
+
+                wssize_t            nInPos;             // Integer part of input position of the current output frame
+                size_t              nPhase;             // Fractional part of input position, in 1/nUp units
+                wssize_t            nInLength;          // Length of the wrapped stream, negative if EOF has not been reached
+
+                f32_t             **vChannels;          // Buffers with de-interleaved input samples
+                f32_t             **vTail;              // Temporary pointers to the tail of input buffers
+                wssize_t            nBufStart;          // Input position of the first frame in the buffer
+                size_t              nBufFrames;         // Number of frames in the buffer
+                size_t              nBufCap;            // Capacity of the buffer in frames
+                uint8_t            *pData;              // Allocated data
+
+            protected:
+                void                do_close();
+                status_t            fill_buffer(wssize_t first);
+                void                reset_buffer(wssize_t first);
+
+                virtual ssize_t     direct_read(void *dst, size_t nframes, size_t fmt);
+
+                virtual size_t      select_format(size_t fmt);
+
+            public:
+                explicit InAudioResampler();
+                virtual ~InAudioResampler();
+
+            public:
+                /**
+                 * Wrap audio stream, the current position of the wrapped
+                 * stream becomes the beginning of the resampled stream
+                 * @param is audio stream to wrap
+                 * @param srate the desired sample rate
+                 * @param quality conversion quality, see resample_t
+                 * @param flags wrapping flags
+                 * @return status of operation
+                 */
+                status_t            wrap(IInAudioStream *is, size_t srate, size_t quality = RESAMPLE_NORMAL, size_t flags = 0);
+
+                virtual status_t    close();
+
+                virtual wssize_t    skip(wsize_t nframes);
+
+                virtual wssize_t    seek(wsize_t nframes);
+        };
+
+    } /* namespace mm */
+} /* namespace lsp */
+
+#endif /* LSP_PLUG_IN_MM_INAUDIORESAMPLER_H_ */
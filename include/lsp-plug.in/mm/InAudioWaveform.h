@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 2 апр. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LSP_PLUG_IN_MM_INAUDIOWAVEFORM_H_
+#define LSP_PLUG_IN_MM_INAUDIOWAVEFORM_H_
+
+#include <lsp-plug.in/runtime/version.h>
+#include <lsp-plug.in/common/types.h>
+#include <lsp-plug.in/mm/IInAudioStream.h>
+#include <lsp-plug.in/mm/Waveform.h>
+
+namespace lsp
+{
+    namespace mm
+    {
+        /**
+         * Input audio stream that passes through the frames of another audio stream
+         * and builds the overview of the frames being read. The stream yields 32-bit
+         * floating-point samples and supports only forward positioning: skipped
+         * frames are read and added to the overview too.
+         */
+        class InAudioWaveform: public IInAudioStream
+        {
+            private:
+                InAudioWaveform & operator = (const InAudioWaveform &);
+
+            protected:
+                IInAudioStream     *pIn;                // Wrapped stream
+                size_t              nWrapFlags;         // Wrap flags
+                Waveform           *pWaveform;          // Overview to build
+
+            protected:
+                void                do_close();
+
+                virtual ssize_t     direct_read(void *dst, size_t nframes, size_t fmt);
+
+                virtual size_t      select_format(size_t fmt);
+
+            public:
+                explicit InAudioWaveform();
+                virtual ~InAudioWaveform();
+
+            public:
+                /**
+                 * Wrap audio stream, the overview is initialized with the format of the
+                 * stream and the current base() value, and is finished when the end of
+                 * the wrapped stream is reached or the stream is closed
+                 * @param is audio stream to wrap
+                 * @param wf overview to build
+                 * @param flags wrapping flags
+                 * @return status of operation
+                 */
+                status_t            wrap(IInAudioStream *is, Waveform *wf, size_t flags = 0);
+
+                virtual status_t    close();
+        };
+
+    } /* namespace mm */
+} /* namespace lsp */
+
+#endif /* LSP_PLUG_IN_MM_INAUDIOWAVEFORM_H_ */
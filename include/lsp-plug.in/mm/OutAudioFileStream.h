@@ -35,6 +35,8 @@ namespace lsp
 {
     namespace mm
     {
+        class RIFFWriter;
+
     #ifndef USE_LIBSNDFILE
         class MMIOWriter;
         class ACMStream;
@@ -57,6 +59,7 @@ namespace lsp
                 wsize_t             nTotalFrames;   // Total frames written
             #endif
                 // Common fields
+                RIFFWriter         *pRIFF;          // Writer of PCM and floating-point WAV files
                 size_t              nCodec;
                 bool                bSeekable;
 
@@ -71,6 +74,8 @@ namespace lsp
                 status_t            flush_internal(bool eof);
             #endif
 
+                status_t            open_riff(const LSPString *path, const audio_stream_t *fmt, size_t codec);
+
                 virtual ssize_t     direct_write(const void *src, size_t nframes, size_t fmt);
 
                 virtual size_t      select_format(size_t rfmt);
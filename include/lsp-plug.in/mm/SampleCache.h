@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 1 апр. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LSP_PLUG_IN_MM_SAMPLECACHE_H_
+#define LSP_PLUG_IN_MM_SAMPLECACHE_H_
+
+#include <lsp-plug.in/runtime/version.h>
+#include <lsp-plug.in/common/types.h>
+#include <lsp-plug.in/common/status.h>
+#include <lsp-plug.in/runtime/LSPString.h>
+#include <lsp-plug.in/io/Path.h>
+#include <lsp-plug.in/ipc/Condition.h>
+#include <lsp-plug.in/lltl/pphash.h>
+#include <lsp-plug.in/mm/types.h>
+
+namespace lsp
+{
+    namespace mm
+    {
+        /**
+         * Cache of decoded audio files. The decoded samples are identified by the canonical
+         * path of the file, the modification time of the file, the sample format and the sample
+         * rate. Samples are reference-counted, the samples which are not referenced are evicted
+         * in least-recently-used order when the total size of samples exceeds the limit.
+         * Concurrent requests of the same sample are coalesced into one decoding. The cache
+         * is thread-safe and is intended to be shared between all consumers in the process.
+         */
+        class SampleCache
+        {
+            private:
+                SampleCache & operator = (const SampleCache &);
+
+            public:
+                static const wsize_t DEFAULT_LIMIT  = 0x10000000;   // Default limit of memory: 256 MiB
+
+                typedef struct stats_t
+                {
+                    wsize_t         hits;           // Number of requests served from the cache
+                    wsize_t         misses;         // Number of requests that caused decoding
+                    wsize_t         coalesced;      // Number of hits that waited for the decoding by another request
+                    wsize_t         evictions;      // Number of evicted samples
+                    size_t          items;          // Number of samples in the cache
+                    size_t          used;           // Number of samples referenced by consumers
+                    wsize_t         bytes;          // Total size of samples in the cache
+                    wsize_t         limit;          // Limit of the total size of samples
+                } stats_t;
+
+                /**
+                 * Decoded sample, the data is immutable and is valid until the
+                 * sample has been released
+                 */
+                class Sample
+                {
+                    private:
+                        friend class SampleCache;
+                        Sample & operator = (const Sample &);
+
+                    private:
+                        LSPString       sKey;           // Key of the sample
+                        audio_stream_t  sFormat;        // Format of the sample
+                        uint8_t        *pData;          // Interleaved samples
+                        size_t          nBytes;         // Size of data
+                        size_t          nRefs;          // Number of references
+                        status_t        nStatus;        // Status of loading
+                        Sample         *pPrev;          // Previous sample in LRU list
+                        Sample         *pNext;          // Next sample in LRU list
+
+                    private:
+                        explicit Sample();
+                        ~Sample();
+
+                    public:
+                        inline const void  *data() const           { return pData;             }
+                        inline size_t       bytes() const           { return nBytes;            }
+                        inline size_t       format() const          { return sFormat.format;    }
+                        inline size_t       channels() const        { return sFormat.channels;  }
+                        inline size_t       sample_rate() const     { return sFormat.srate;     }
+                        inline wsize_t      frames() const          { return sFormat.frames;    }
+                        inline const audio_stream_t *info() const   { return &sFormat;          }
+
+                        template <class T>
+                            inline const T *data() const            { return reinterpret_cast<const T *>(pData); }
+                };
+
+            protected:
+                mutable ipc::Condition              sCond;      // Synchronization primitive
+                lltl::pphash<LSPString, Sample>     vItems;     // All samples
+                Sample                             *pHead;      // Most recently used sample which is not referenced
+                Sample                             *pTail;      // Least recently used sample which is not referenced
+                stats_t                             sStats;     // Statistics
+
+            protected:
+                static status_t     make_key(LSPString *key, const io::Path *path, size_t format, size_t srate);
+                static status_t     decode(Sample *s, const io::Path *path, size_t format, size_t srate);
+
+                void                lru_link(Sample *s);
+                void                lru_unlink(Sample *s);
+                void                evict(wsize_t limit);
+                void                drop(Sample *s);
+
+            public:
+                explicit SampleCache();
+
+                /**
+                 * Destroy the cache, all samples should be released before. Samples that are
+                 * still referenced are reported as an error and deleted
+                 */
+                ~SampleCache();
+
+            public:
+                /**
+                 * Obtain the decoded audio file from the cache, decode the file if it is
+                 * not present in the cache
+                 * @param dst pointer to store the sample, should be released by the release() call
+                 * @param path path to the audio file
+                 * @param format sample format, the format should have CPU byte order,
+                 *   24-bit formats are not supported
+                 * @param srate sample rate to convert the sample to, 0 for the original sample rate
+                 * @return status of operation
+                 */
+                status_t            acquire(Sample **dst, const char *path, size_t format, size_t srate = 0);
+                status_t            acquire(Sample **dst, const LSPString *path, size_t format, size_t srate = 0);
+                status_t            acquire(Sample **dst, const io::Path *path, size_t format, size_t srate = 0);
+
+                /**
+                 * Release the sample obtained by the acquire() call
+                 * @param s sample to release
+                 * @return status of operation
+                 */
+                status_t            release(Sample *s);
+
+                /**
+                 * Set the limit of the total size of samples
+                 * @param bytes limit of the total size of samples in bytes
+                 */
+                void                set_limit(wsize_t bytes);
+
+                /**
+                 * Get the limit of the total size of samples
+                 * @return limit of the total size of samples in bytes
+                 */
+                wsize_t             limit() const;
+
+                /**
+                 * Get statistics of the cache
+                 * @param dst pointer to store statistics
+                 */
+                void                get_stats(stats_t *dst) const;
+
+                /**
+                 * Reset the hits, misses, coalesced and evictions counters
+                 */
+                void                reset_stats();
+
+                /**
+                 * Evict all samples which are not referenced
+                 */
+                void                clear();
+        };
+
+    } /* namespace mm */
+} /* namespace lsp */
+
+#endif /* LSP_PLUG_IN_MM_SAMPLECACHE_H_ */
@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 2 апр. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LSP_PLUG_IN_MM_WAVEFORM_H_
+#define LSP_PLUG_IN_MM_WAVEFORM_H_
+
+#include <lsp-plug.in/runtime/version.h>
+#include <lsp-plug.in/common/types.h>
+#include <lsp-plug.in/common/status.h>
+#include <lsp-plug.in/fmt/lspc/File.h>
+#include <lsp-plug.in/mm/types.h>
+
+namespace lsp
+{
+    namespace mm
+    {
+        /**
+         * Multi-resolution overview of the audio data: the pyramid of levels where each entry
+         * of the level stores the minimum, the maximum and the RMS value of the range of frames
+         * for each channel. Entries of the first level cover base() frames, each next level
+         * covers twice more frames per entry than the previous one. The overview is built
+         * incrementally while the audio data streams through, and can be stored in the LSPC
+         * file to render the audio data later without decoding it.
+         */
+        class Waveform
+        {
+            private:
+                Waveform & operator = (const Waveform &);
+
+            public:
+                static const size_t DEFAULT_BASE        = 0x100;    // Default number of frames per entry at the first level
+                static const size_t MIN_BASE            = 0x10;     // Minimum number of frames per entry at the first level
+                static const size_t MAX_BASE            = 0x10000;  // Maximum number of frames per entry at the first level
+                static const size_t MAX_LEVELS          = 32;       // Maximum number of levels
+
+                typedef struct peak_t
+                {
+                    f32_t           min;            // Minimum value
+                    f32_t           max;            // Maximum value
+                    f32_t           rms;            // RMS value
+                } peak_t;
+
+            protected:
+                typedef struct acc_t
+                {
+                    f32_t           min;            // Minimum value
+                    f32_t           max;            // Maximum value
+                    double          sum;            // Sum of squares
+                } acc_t;
+
+                typedef struct level_t
+                {
+                    peak_t         *vData;          // Entries, channels() records per entry
+                    size_t          nItems;         // Number of entries
+                    size_t          nCap;           // Capacity in entries
+                    wsize_t         nFrames;        // Number of frames in the pending entry
+                } level_t;
+
+            protected:
+                size_t              nChannels;      // Number of channels
+                size_t              nSampleRate;    // Sample rate
+                size_t              nBase;          // Number of frames per entry at the first level
+                size_t              nLevels;        // Number of levels
+                wsize_t             nFrames;        // Number of processed frames
+                bool                bFinished;      // Finished flag
+                level_t             vLevels[MAX_LEVELS];
+                acc_t              *vAcc;           // Accumulators of pending entries, MAX_LEVELS * nChannels
+                f32_t             **vBuf;           // De-interleaved input samples
+                uint8_t            *pData;          // Allocated data
+
+            protected:
+                void                do_close();
+                bool                emit(size_t level);
+                status_t            read_levels(lspc::ChunkReader *rd, const uint32_t *chunk_id);
+
+            public:
+                explicit Waveform();
+                ~Waveform();
+
+            public:
+                /**
+                 * Initialize the overview, drop all previously collected data
+                 * @param channels number of channels
+                 * @param srate sample rate of the audio data
+                 * @param base number of frames per entry at the first level
+                 * @return status of operation
+                 */
+                status_t            init(size_t channels, size_t srate, size_t base = DEFAULT_BASE);
+
+                /**
+                 * Drop all data and release resources
+                 */
+                void                destroy();
+
+                /**
+                 * Process interleaved frames, should be called until finish()
+                 * @param src interleaved 32-bit floating-point samples
+                 * @param frames number of frames to process
+                 * @return status of operation
+                 */
+                status_t            process(const f32_t *src, size_t frames);
+
+                /**
+                 * Finish processing, the pending entries are stored even if they do not
+                 * cover the whole range of frames
+                 * @return status of operation
+                 */
+                status_t            finish();
+
+                /**
+                 * Compute the overview of the range of frames, the level with the most
+                 * appropriate resolution is selected for the requested number of columns
+                 * @param dst array of columns to store the overview
+                 * @param channel index of the channel
+                 * @param first the first frame of the range
+                 * @param count number of frames in the range
+                 * @param columns number of columns
+                 * @return status of operation
+                 */
+                status_t            query(peak_t *dst, size_t channel, wsize_t first, wsize_t count, size_t columns) const;
+
+                /**
+                 * Store the overview to the LSPC file as a separate chunk,
+                 * the overview should be finished
+                 * @param fd LSPC file opened for writing
+                 * @param chunk_id identifier of the related audio chunk, 0 if not present
+                 * @param uid pointer to store the identifier of the written chunk, may be NULL
+                 * @return status of operation
+                 */
+                status_t            save(lspc::File *fd, uint32_t chunk_id = 0, uint32_t *uid = NULL) const;
+
+                /**
+                 * Load the overview from the LSPC chunk
+                 * @param fd LSPC file opened for reading
+                 * @param uid identifier of the chunk
+                 * @return status of operation
+                 */
+                status_t            load(lspc::File *fd, uint32_t uid);
+
+                /**
+                 * Find the overview related to the audio chunk and load it
+                 * @param fd LSPC file opened for reading
+                 * @param chunk_id identifier of the audio chunk
+                 * @return status of operation, STATUS_NOT_FOUND if there is no overview
+                 */
+                status_t            load_related(lspc::File *fd, uint32_t chunk_id);
+
+            public:
+                inline size_t       channels() const            { return nChannels;     }
+                inline size_t       sample_rate() const         { return nSampleRate;   }
+                inline size_t       base() const                { return nBase;         }
+                inline size_t       levels() const              { return nLevels;       }
+                inline wsize_t      frames() const              { return nFrames;       }
+                inline bool         finished() const            { return bFinished;     }
+
+                /**
+                 * Get number of entries at the specified level
+                 * @param level index of the level
+                 * @return number of entries
+                 */
+                inline size_t       entries(size_t level) const { return (level < nLevels) ? vLevels[level].nItems : 0; }
+
+                /**
+                 * Get entries of the specified level
+                 * @param level index of the level
+                 * @return entries, channels() records per entry, NULL if level does not exist
+                 */
+                inline const peak_t *data(size_t level) const   { return (level < nLevels) ? vLevels[level].vData : NULL; }
+        };
+
+    } /* namespace mm */
+} /* namespace lsp */
+
+#endif /* LSP_PLUG_IN_MM_WAVEFORM_H_ */
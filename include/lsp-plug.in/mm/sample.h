@@ -48,6 +48,22 @@ namespace lsp
          * @return true if conversion is possible
          */
         bool convert_samples(void *dst, void *src, size_t samples, size_t to, size_t from);
+
+        /**
+         * Convert sample format and apply the specified quantization mode when
+         * converting floating-point samples to integer samples. 64-bit floating-point
+         * samples are quantized with 32-bit floating-point precision, the dither noise
+         * generator is maintained per thread.
+         *
+         * @param dst destination buffer to store samples
+         * @param src source buffer to convert samples (contents may be modified during processing)
+         * @param samples number of samples to convert
+         * @param to target sample format
+         * @param from source sample format
+         * @param quantize quantization mode, see quantize_t
+         * @return true if conversion is possible
+         */
+        bool convert_samples(void *dst, void *src, size_t samples, size_t to, size_t from, size_t quantize);
     }
 }
 
@@ -165,6 +165,24 @@ namespace lsp
             CFMT_MASK       = 0x0000ffff
         };
 
+        /**
+         * Quantization mode applied when converting floating-point samples
+         * to integer samples
+         */
+        enum quantize_t
+        {
+            QUANTIZE_TRUNCATE,      /* Truncate samples towards zero, no clipping */
+            QUANTIZE_ROUND,         /* Round samples to nearest integer and clip them */
+            QUANTIZE_DITHER         /* Apply TPDF dither, round samples to nearest integer and clip them */
+        };
+
+        enum resample_t
+        {
+            RESAMPLE_FAST,          /* Short filter, suitable for previews */
+            RESAMPLE_NORMAL,        /* Medium length filter */
+            RESAMPLE_HIGH           /* Long filter with the steepest transition band */
+        };
+
         typedef float       f32_t;
         typedef double      f64_t;
 
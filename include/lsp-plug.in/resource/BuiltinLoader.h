@@ -48,8 +48,17 @@ namespace lsp
                 const raw_resource_t           *pCatalog;   // Catalog
                 size_t                          nCatSize;   // Catalog size
                 size_t                          nBufSize;   // Size of compression buffer
+                size_t                         *vChildren;  // Indices of entries grouped by the parent directory
+                size_t                         *vFirst;     // Offsets of groups in vChildren, the first group is root
+                ssize_t                        *vHash;      // Hash table of entries by full path
+                uint32_t                       *vKeys;      // Hash of the full path for each entry
+                size_t                          nHashCap;   // Capacity of the hash table
+                uint8_t                        *pIndex;     // Allocated data of the index
 
             protected:
+                status_t                        build_index();
+                void                            drop_index();
+                bool                            match_entry(size_t index, const char *path, size_t len) const;
                 status_t                        find_entry(ssize_t *out, const io::Path *path);
 
             public:
@@ -58,7 +67,7 @@ namespace lsp
 
             public:
                 /**
-                 * Initialize builtin loader
+                 * Initialize builtin loader, build the index of entries by the full path
                  *
                  * @param data compression data
                  * @param data_size size of compression data
@@ -38,13 +38,24 @@ namespace lsp
     namespace resource
     {
         /**
-         * Interface for resource compressor
+         * Interface for resource compressor. By default all entries of the segment are compressed
+         * one after another with the shared dictionary window. In the parallel mode entries are
+         * grouped into independent blocks, each block is a separate segment with its own window,
+         * and blocks are compressed by several threads when the segment is flushed.
          */
         class Compressor
         {
             private:
                 Compressor & operator = (const Compressor &);
 
+            public:
+                static const size_t DEFAULT_BLOCK_SIZE  = 0x40000;      // Default amount of source data per block
+
+            protected:
+                struct block_t;
+                struct task_t;
+                struct worker_t;
+
             protected:
                 lltl::darray<raw_resource_t>    vEntries;
                 io::OutMemoryStream             sTemp;          // Temporary buffer
@@ -53,12 +64,20 @@ namespace lsp
                 size_t                          nSegment;       // Start of data segment
                 size_t                          nOffset;        // Current offset in segment
                 cbuffer_t                       sBuffer;        // Buffer for caching
+                size_t                          nThreads;       // Number of threads, 0 for automatic
+                size_t                          nBlockSize;     // Amount of source data per block, 0 for sequential mode
+                lltl::parray<block_t>           vBlocks;        // Blocks pending for compression
 
             protected:
                 status_t            alloc_entry(raw_resource_t **r, io::Path *path, resource_type_t type);
                 wssize_t            write_entry(raw_resource_t *r, io::IInStream *is);
+                wssize_t            buffer_entry(raw_resource_t *r, io::IInStream *is);
+                status_t            flush_blocks();
+                void                drop_blocks();
+                static status_t     compress(cbuffer_t *buf, io::OutBitStream *out, const uint8_t *head, const uint8_t *tail);
+                static status_t     compress_block(cbuffer_t *buf, block_t *b, const raw_resource_t *entries);
+                static status_t     worker_proc(void *arg);
                 static size_t       calc_repeats(const uint8_t *head, const uint8_t *tail);
-                status_t            emit_uint(size_t value, size_t initial, size_t stepping);
                 static size_t       est_uint(size_t value, size_t initial, size_t stepping);
 
             public:
@@ -81,9 +100,51 @@ namespace lsp
                  */
                 status_t                init(size_t buf_size, io::IOutStream *os, size_t flags = WRAP_NONE);
 
+                /**
+                 * Set the maximum number of candidates checked by the match finder for each
+                 * lookup. The unlimited depth produces the same output as the exhaustive search,
+                 * the limited depth makes compression faster at the cost of the compression ratio.
+                 * @param depth maximum number of candidates, 0 means unlimited
+                 */
+                inline void             set_chain_depth(size_t depth)   { sBuffer.depth = depth;                            }
+
+                /**
+                 * Get the maximum number of candidates checked by the match finder for each lookup
+                 * @return maximum number of candidates, 0 means unlimited
+                 */
+                inline size_t           chain_depth() const             { return sBuffer.depth;                             }
+
+                /**
+                 * Set the amount of source data per block for the parallel mode. Entries are never
+                 * split between blocks, so the block is closed when it reaches the specified size.
+                 * Smaller blocks give better parallelism at the cost of the compression ratio.
+                 * Should be set before the first entry of the segment is created.
+                 * @param size amount of source data per block, 0 means sequential mode
+                 */
+                inline void             set_block_size(size_t size)     { nBlockSize = size;                                }
+
+                /**
+                 * Get the amount of source data per block for the parallel mode
+                 * @return amount of source data per block, 0 means sequential mode
+                 */
+                inline size_t           block_size() const              { return nBlockSize;                                }
+
+                /**
+                 * Set number of threads used for compression of blocks in the parallel mode
+                 * @param threads number of threads, 0 means the number of available processors
+                 */
+                inline void             set_threads(size_t threads)     { nThreads = threads;                               }
+
+                /**
+                 * Get number of threads used for compression of blocks in the parallel mode
+                 * @return number of threads, 0 means the number of available processors
+                 */
+                inline size_t           threads() const                 { return nThreads;                                  }
+
             public:
                 /**
-                 * Get all resource entries
+                 * Get all resource entries. In the parallel mode the location of entries
+                 * is known only after the segment is flushed
                  * @return all resource entries
                  */
                 inline const raw_resource_t *entries() const    { return vEntries.array();                                  }
@@ -95,7 +156,8 @@ namespace lsp
                 inline size_t           num_entires() const     { return vEntries.size();                                   }
 
                 /**
-                 * Start a new segment of data. May be useful for sorting data by different types
+                 * Start a new segment of data. May be useful for sorting data by different types.
+                 * In the parallel mode compresses all pending blocks and writes them to the output
                  * @return status of operation
                  */
                 status_t                flush();
@@ -24,13 +24,18 @@
 
 #include <lsp-plug.in/runtime/version.h>
 #include <lsp-plug.in/io/IInStream.h>
-#include <lsp-plug.in/io/InBitStream.h>
 #include <lsp-plug.in/resource/buffer.h>
 
 namespace lsp
 {
     namespace resource
     {
+        /**
+         * Decompressor of the data produced by resource::Compressor. The compressed data is
+         * decoded directly from memory: codes are extracted from the 64-bit bit buffer with
+         * lookup tables, commands that completely fit into the destination buffer of read()
+         * are decoded directly into it
+         */
         class Decompressor: public io::IInStream
         {
             private:
@@ -46,8 +51,24 @@ namespace lsp
                     size_t          rep;            // Number of repeats
                 } cbuf_t;
 
+                typedef struct ucode_t
+                {
+                    uint64_t        base;           // Minimum value encoded with the prefix
+                    uint8_t         bits;           // Number of value bits after the prefix
+                    uint8_t         length;         // Overall length of the code in bits
+                } ucode_t;
+
+                static const size_t VALUE_CODES     = 9;    // Number of prefixes of offsets, lengths and octets
+                static const size_t REPEAT_CODES    = 12;   // Number of prefixes of repeat counters
+
+                static const ucode_t    vValueCodes[VALUE_CODES];
+                static const ucode_t    vRepeatCodes[REPEAT_CODES];
+
             protected:
-                io::InBitStream     sIn;            // Input stream
+                const uint8_t      *pData;          // Current position of the compressed data
+                size_t              nAvail;         // Number of compressed bytes available
+                uint64_t            nBitBuf;        // Bit buffer, the next bit is the most significant one
+                size_t              nBits;          // Number of bits in the bit buffer
                 dbuffer_t           sBuffer;        // Buffer for caching
                 cbuf_t              sReplay;        // Replay buffer
 
@@ -55,12 +76,16 @@ namespace lsp
                 size_t              nLast;          // Last byte
 
             protected:
-                status_t            read_uint(size_t *out, size_t initial, size_t stepping);
+                void                refill();
+                status_t            read_code(wsize_t *out, const ucode_t *codes, size_t count);
+                static inline bool  take_code(uint64_t *buf, size_t *bits, wsize_t *out, const ucode_t *codes, size_t count);
+                inline void         append_buf(const uint8_t *src, size_t count);
+                size_t              decode_direct(uint8_t *dst, size_t avail);
                 size_t              get_buf(uint8_t *dst, size_t count);
                 ssize_t             get_bufc();
                 status_t            set_buf(size_t off, size_t count, size_t rep);
                 status_t            set_bufc(uint8_t c, size_t rep);
-                status_t            fill_buf();
+                status_t            fill_buf(uint8_t *dst, size_t avail, size_t *emitted);
                 status_t            do_close();
 
             public:
@@ -68,8 +93,25 @@ namespace lsp
                 virtual ~Decompressor();
 
             public:
+                /**
+                 * Initialize decompressor with the compressed data of unknown size
+                 * @param data compressed data
+                 * @param last number of bytes to decompress
+                 * @param buf_sz size of the buffer, should match the buffer size of the compressor
+                 * @return status of operation
+                 */
                 status_t            init(const void *data, size_t last, size_t buf_sz);
 
+                /**
+                 * Initialize decompressor
+                 * @param data compressed data
+                 * @param size size of compressed data
+                 * @param last number of bytes to decompress
+                 * @param buf_sz size of the buffer, should match the buffer size of the compressor
+                 * @return status of operation
+                 */
+                status_t            init(const void *data, size_t size, size_t last, size_t buf_sz);
+
             public:
                 virtual ssize_t     read_byte();
                 virtual ssize_t     read(void *dst, size_t count);
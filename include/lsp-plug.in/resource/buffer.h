@@ -41,16 +41,43 @@ namespace lsp
         } location_t;
 
         /**
-         * Compression buffer
+         * Compression buffer. The lookup of matches uses hash chains over 3-byte prefixes and
+         * lists of positions of 2-byte and 1-byte prefixes. With unlimited chain depth the result
+         * is the same as for the exhaustive search: the longest match, the earliest one among
+         * matches of the same length.
          */
         typedef struct cbuffer_t
         {
+            public:
+                static const size_t HASH_BITS       = 16;
+                static const size_t HASH_SIZE       = 1 << HASH_BITS;
+                static const size_t PAIR_SIZE       = 0x10000;
+                static const size_t BYTE_SIZE       = 0x100;
+
             public:
                 uint8_t    *data;       // Buffer data (2 x capacity)
-                uint32_t   *index;      // Index
+                int32_t    *prev3;      // Previous position with the same hash of 3-byte prefix (2 x capacity)
+                int32_t    *next2;      // Next position with the same 2-byte prefix (2 x capacity)
+                int32_t    *next1;      // Next position with the same byte (2 x capacity)
+                int32_t    *hash3;      // The most recent position for each hash of 3-byte prefix
+                int32_t    *first2;     // The earliest position for each 2-byte prefix
+                int32_t    *last2;      // The most recent position for each 2-byte prefix
+                int32_t    *first1;     // The earliest position for each byte
+                int32_t    *last1;      // The most recent position for each byte
                 ssize_t     head;       // Head of the buffer
                 ssize_t     tail;       // Buffer tail
                 ssize_t     cap;        // Buffer capacity
+                ssize_t     ix3;        // Number of positions indexed by 3-byte prefixes
+                ssize_t     ix2;        // Number of positions indexed by 2-byte prefixes
+                ssize_t     ix1;        // Number of positions indexed by bytes
+                size_t      depth;      // Maximum number of checked hash chain entries, 0 means unlimited
+
+            protected:
+                void            reset_index();
+                void            update_index();
+                void            shift();
+                ssize_t         first_of(int32_t *first, int32_t *last, const int32_t *next, size_t key);
+                size_t          match(ssize_t pos, const uint8_t *s, size_t avail) const;
 
             public:
                 explicit cbuffer_t();
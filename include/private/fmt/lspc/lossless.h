@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 3 апр. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PRIVATE_FMT_LSPC_LOSSLESS_H_
+#define PRIVATE_FMT_LSPC_LOSSLESS_H_
+
+#include <lsp-plug.in/runtime/version.h>
+#include <lsp-plug.in/common/types.h>
+#include <lsp-plug.in/common/status.h>
+
+namespace lsp
+{
+    namespace lspc
+    {
+        /**
+         * Lossless codec of the audio data: each channel of the block is predicted with the
+         * quantized linear predictor and the prediction residual is coded with the Rice code.
+         *
+         * The codec operates on the samples produced by the encoding routines of the AudioWriter:
+         * 8, 16 and 32-bit samples are stored in the CPU byte order, 24-bit samples are stored in
+         * the byte order of the sample format. 32-bit floating-point samples are coded as integers
+         * of the same bit width, 64-bit floating-point samples are not supported.
+         *
+         * All routines are stateless, so the caller can encode and decode different blocks in parallel.
+         * Both the bit unpacking and the restoration of samples are sequential within the block.
+         */
+        namespace lossless
+        {
+            static const size_t MAX_ORDER       = 16;       // Maximum order of the linear predictor
+
+            /**
+             * Check that the sample format is supported by the codec
+             * @param sample_format sample format
+             * @return true if the sample format is supported
+             */
+            bool        supported(size_t sample_format);
+
+            /**
+             * Get the maximum size of the encoded block
+             * @param channels number of channels
+             * @param sample_format sample format
+             * @param frames number of frames in the block
+             * @return maximum size of the encoded block in bytes, including the block header
+             */
+            size_t      block_bound(size_t channels, size_t sample_format, size_t frames);
+
+            /**
+             * Get the size of the work buffer required by the encoder and the decoder
+             * @param frames number of frames in the block
+             * @return number of 32-bit integers in the work buffer
+             */
+            size_t      work_size(size_t frames);
+
+            /**
+             * Encode the block of audio frames
+             * @param dst destination buffer of at least block_bound() bytes
+             * @param src interleaved samples
+             * @param channels number of channels
+             * @param sample_format sample format
+             * @param frames number of frames in the block
+             * @param work work buffer of at least work_size() integers
+             * @return size of the encoded block including the block header or negative error code
+             */
+            ssize_t     encode(void *dst, const void *src, size_t channels, size_t sample_format, size_t frames, int32_t *work);
+
+            /**
+             * Decode the block of audio frames
+             * @param dst destination buffer to store interleaved samples
+             * @param src encoded data of the block after the block header
+             * @param size size of the encoded data
+             * @param channels number of channels
+             * @param sample_format sample format
+             * @param frames number of frames in the block
+             * @param work work buffer of at least work_size() integers
+             * @return status of operation
+             */
+            status_t    decode(void *dst, const void *src, size_t size, size_t channels, size_t sample_format, size_t frames, int32_t *work);
+
+        } /* namespace lossless */
+    } /* namespace lspc */
+} /* namespace lsp */
+
+#endif /* PRIVATE_FMT_LSPC_LOSSLESS_H_ */
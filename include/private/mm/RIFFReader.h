@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 30 мар. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PRIVATE_MM_RIFFREADER_H_
+#define PRIVATE_MM_RIFFREADER_H_
+
+#include <lsp-plug.in/runtime/version.h>
+#include <lsp-plug.in/common/types.h>
+#include <lsp-plug.in/common/status.h>
+#include <lsp-plug.in/runtime/LSPString.h>
+#include <lsp-plug.in/io/NativeFile.h>
+
+namespace lsp
+{
+    namespace mm
+    {
+        /**
+         * Portable reader of WAV files that contain PCM or floating-point samples.
+         * The file is memory-mapped if possible, so the sample data can be accessed
+         * directly without copying. Otherwise the data is read from the file.
+         */
+        class RIFFReader
+        {
+            private:
+                RIFFReader & operator = (const RIFFReader &);
+
+            protected:
+                io::NativeFile     *pFD;            // File descriptor if the file is not mapped
+                uint8_t            *pMap;           // Pointer to the memory-mapped file
+                wsize_t             nMapSize;       // Size of the memory-mapped area
+                wsize_t             nFileSize;      // Size of the file
+
+                wsize_t             nDataOffset;    // Offset of the sample data from the beginning of the file
+                wsize_t             nDataSize;      // Size of the sample data
+                wsize_t             nReadPos;       // Read position relative to the beginning of the sample data
+
+                size_t              nFormat;        // Sample format
+                size_t              nChannels;      // Number of channels
+                size_t              nSampleRate;    // Sample rate
+                size_t              nFrameSize;     // Size of frame in bytes
+
+            protected:
+                status_t            map_file(const LSPString *path);
+                void                unmap_file();
+                ssize_t             read_at(wsize_t offset, void *buf, size_t count);
+                status_t            parse_header();
+                status_t            parse_format(const void *buf, size_t size);
+
+            public:
+                explicit RIFFReader();
+                ~RIFFReader();
+
+            public:
+                /**
+                 * Open WAV file for reading
+                 * @param path path to the file
+                 * @param mmap try to map the file into memory
+                 * @return status of operation: STATUS_BAD_FORMAT if the file is not a WAV file,
+                 *   STATUS_UNSUPPORTED_FORMAT if the file contains samples in unsupported encoding
+                 */
+                status_t            open(const LSPString *path, bool mmap = true);
+
+                /**
+                 * Close the file
+                 * @param code the code to return
+                 * @return the passed code
+                 */
+                status_t            close(status_t code = STATUS_OK);
+
+                /**
+                 * Get sample format, the samples of 24-bit formats are packed into 3 bytes
+                 * @return sample format in little-endian byte order
+                 */
+                inline size_t       format() const          { return nFormat;       }
+
+                /**
+                 * Get number of channels
+                 * @return number of channels
+                 */
+                inline size_t       channels() const        { return nChannels;     }
+
+                /**
+                 * Get sample rate
+                 * @return sample rate
+                 */
+                inline size_t       sample_rate() const     { return nSampleRate;   }
+
+                /**
+                 * Get size of frame in bytes
+                 * @return size of frame in bytes
+                 */
+                inline size_t       frame_size() const      { return nFrameSize;    }
+
+                /**
+                 * Get number of frames
+                 * @return number of frames
+                 */
+                inline wsize_t      frames() const          { return (nFrameSize > 0) ? nDataSize / nFrameSize : 0; }
+
+                /**
+                 * Check that the file is memory-mapped
+                 * @return true if the file is memory-mapped
+                 */
+                inline bool         mapped() const          { return pMap != NULL;  }
+
+                /**
+                 * Get pointer to the sample data at the current read position and move
+                 * the read position forward, works only for memory-mapped files
+                 * @param count maximum number of bytes to fetch
+                 * @param ptr pointer to store the pointer to the sample data
+                 * @return number of bytes available at the pointer or negative error code
+                 */
+                ssize_t             fetch(const void **ptr, size_t count);
+
+                /**
+                 * Seek to the specified location
+                 * @param offset offset in bytes from the beginning of data chunk
+                 * @return actual offset in bytes from the beginning of data chunk
+                 */
+                wssize_t            seek(wsize_t offset);
+
+                /**
+                 * Read number of bytes into buffer
+                 * @param buf pointer to buffer to store data
+                 * @param count number of bytes to read
+                 * @return actual bytes read or negative error code
+                 */
+                ssize_t             read(void *buf, size_t count);
+        };
+
+    } /* namespace mm */
+} /* namespace lsp */
+
+#endif /* PRIVATE_MM_RIFFREADER_H_ */
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 30 мар. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PRIVATE_MM_RIFFWRITER_H_
+#define PRIVATE_MM_RIFFWRITER_H_
+
+#include <lsp-plug.in/runtime/version.h>
+#include <lsp-plug.in/common/types.h>
+#include <lsp-plug.in/common/status.h>
+#include <lsp-plug.in/runtime/LSPString.h>
+#include <lsp-plug.in/io/NativeFile.h>
+#include <lsp-plug.in/mm/types.h>
+
+namespace lsp
+{
+    namespace mm
+    {
+        /**
+         * Portable writer of WAV files that contain PCM or floating-point samples.
+         * The sizes of chunks are updated in the header when the file is closed.
+         */
+        class RIFFWriter
+        {
+            private:
+                RIFFWriter & operator = (const RIFFWriter &);
+
+            protected:
+                io::NativeFile     *pFD;            // File descriptor
+                wsize_t             nDataOffset;    // Offset of the sample data from the beginning of the file
+                wsize_t             nFactOffset;    // Offset of the 'fact' chunk data, 0 if not present
+                wsize_t             nDataSize;      // Size of the sample data
+                wsize_t             nWritePos;      // Write position relative to the beginning of the sample data
+
+                size_t              nFormat;        // Sample format
+                size_t              nChannels;      // Number of channels
+                size_t              nFrameSize;     // Size of frame in bytes
+
+            protected:
+                status_t            write_header(const audio_stream_t *fmt);
+                status_t            update_header();
+
+            public:
+                explicit RIFFWriter();
+                ~RIFFWriter();
+
+            public:
+                /**
+                 * Select the sample format that can be stored in the WAV file
+                 * @param format the desired sample format
+                 * @return sample format in little-endian byte order or SFMT_NONE if not supported
+                 */
+                static size_t       select_format(size_t format);
+
+                /**
+                 * Create WAV file for writing
+                 * @param path path to the file
+                 * @param fmt audio stream format, the sample format should be supported
+                 * @return status of operation
+                 */
+                status_t            open(const LSPString *path, const audio_stream_t *fmt);
+
+                /**
+                 * Update the header and close the file
+                 * @return status of operation
+                 */
+                status_t            close();
+
+                /**
+                 * Get sample format, the samples of 24-bit formats are packed into 3 bytes
+                 * @return sample format in little-endian byte order
+                 */
+                inline size_t       format() const          { return nFormat;       }
+
+                /**
+                 * Get size of frame in bytes
+                 * @return size of frame in bytes
+                 */
+                inline size_t       frame_size() const      { return nFrameSize;    }
+
+                /**
+                 * Get number of frames written
+                 * @return number of frames written
+                 */
+                inline wsize_t      frames() const          { return (nFrameSize > 0) ? nDataSize / nFrameSize : 0; }
+
+                /**
+                 * Write number of bytes to the sample data
+                 * @param buf pointer to the data
+                 * @param count number of bytes to write
+                 * @return actual bytes written or negative error code
+                 */
+                ssize_t             write(const void *buf, size_t count);
+
+                /**
+                 * Seek to the specified location, the location should not be
+                 * greater than the size of the sample data
+                 * @param offset offset in bytes from the beginning of data chunk
+                 * @return actual offset in bytes from the beginning of data chunk
+                 */
+                wssize_t            seek(wsize_t offset);
+
+                /**
+                 * Update the header and flush the data to the storage
+                 * @return status of operation
+                 */
+                status_t            flush();
+        };
+
+    } /* namespace mm */
+} /* namespace lsp */
+
+#endif /* PRIVATE_MM_RIFFWRITER_H_ */
@@ -0,0 +1,232 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 28 мар. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PRIVATE_MM_CVT_H_
+#define PRIVATE_MM_CVT_H_
+
+#include <lsp-plug.in/runtime/version.h>
+#include <lsp-plug.in/common/types.h>
+#include <lsp-plug.in/mm/types.h>
+
+namespace lsp
+{
+    namespace mm
+    {
+        /**
+         * Sample conversion routine, operates on samples in CPU byte order
+         * @param dst destination buffer
+         * @param src source buffer
+         * @param samples number of samples to convert
+         */
+        typedef void (*cvt_sample_t) (void *dst, const void *src, size_t samples);
+
+        /**
+         * State of the dither noise generator: eight independent xorshift32
+         * generators, the generator (i & 7) is used for the i-th sample
+         */
+        typedef struct cvt_dither_t
+        {
+            uint32_t        seed[8];
+        } cvt_dither_t;
+
+        /**
+         * Quantizing conversion routine from floating-point samples to integer samples,
+         * rounds samples to nearest integer and clips them to the range of the target format
+         * @param dst destination buffer
+         * @param src source buffer
+         * @param samples number of samples to convert
+         * @param dither dither noise generator to apply TPDF dither, NULL if no dither required
+         */
+        typedef void (*cvt_quant_t) (void *dst, const void *src, size_t samples, cvt_dither_t *dither);
+
+        /**
+         * Conversion routine from interleaved samples in CPU byte order to separate
+         * buffers of 32-bit floating-point samples, one buffer per channel
+         * @param dst array of channel buffers, NULL buffers are skipped
+         * @param off offset in samples from the beginning of each channel buffer
+         * @param src source buffer with interleaved samples
+         * @param channels number of channels
+         * @param frames number of frames to convert
+         */
+        typedef void (*cvt_deinterleave_t) (f32_t * const *dst, size_t off, const void *src, size_t channels, size_t frames);
+
+        /**
+         * Conversion routine from separate buffers of 32-bit floating-point samples,
+         * one buffer per channel, to interleaved samples in CPU byte order
+         * @param dst destination buffer to store interleaved samples
+         * @param src array of channel buffers, NULL buffers are treated as silence
+         * @param off offset in samples from the beginning of each channel buffer
+         * @param channels number of channels
+         * @param frames number of frames to convert
+         */
+        typedef void (*cvt_interleave_t) (void *dst, const f32_t * const *src, size_t off, size_t channels, size_t frames);
+
+        /**
+         * Scalar product of two vectors of 32-bit floating-point samples, the inner
+         * loop of the polyphase resampling filter
+         * @param a first vector
+         * @param b second vector
+         * @param count number of elements in each vector
+         * @return scalar product
+         */
+        typedef f32_t (*cvt_dot_t) (const f32_t *a, const f32_t *b, size_t count);
+
+        /**
+         * Update the peak statistics with the vector of 32-bit floating-point samples,
+         * the inner loop of the waveform overview builder
+         * @param dst statistics to update: the minimum, the maximum and the sum of squares
+         * @param src source vector
+         * @param count number of elements in the vector
+         */
+        typedef void (*cvt_peak_t) (f32_t *dst, const f32_t *src, size_t count);
+
+        /**
+         * Set of sample conversion routines for the most commonly used
+         * combinations of sample formats, 24-bit samples are packed
+         * into 3 bytes. Routines with 'x' prefix of the integer format
+         * operate on samples stored in foreign (non-CPU) byte order
+         */
+        typedef struct cvt_kernels_t
+        {
+            const char     *name;           // Name of the instruction set
+
+            cvt_sample_t    u8_to_f32;
+            cvt_sample_t    s16_to_f32;
+            cvt_sample_t    s24_to_f32;
+            cvt_sample_t    s32_to_f32;
+            cvt_sample_t    f64_to_f32;
+
+            cvt_sample_t    f32_to_u8;
+            cvt_sample_t    f32_to_s16;
+            cvt_sample_t    f32_to_s24;
+            cvt_sample_t    f32_to_s32;
+            cvt_sample_t    f32_to_f64;
+
+            cvt_quant_t     f32_to_u8_round;
+            cvt_quant_t     f32_to_s16_round;
+            cvt_quant_t     f32_to_s24_round;
+            cvt_quant_t     f32_to_s32_round;
+
+            cvt_sample_t    xs16_to_f32;
+            cvt_sample_t    xs24_to_f32;
+            cvt_sample_t    xs32_to_f32;
+            cvt_sample_t    f32_to_xs16;
+            cvt_sample_t    f32_to_xs24;
+            cvt_sample_t    f32_to_xs32;
+            cvt_sample_t    swap_f32;       // Copy 32-bit floating-point samples with reversed byte order
+
+            cvt_deinterleave_t  s16_to_f32_planar;
+            cvt_deinterleave_t  f32_to_f32_planar;
+            cvt_interleave_t    f32_planar_to_s16;
+            cvt_interleave_t    f32_planar_to_f32;
+
+            cvt_dot_t           dot_f32;
+            cvt_peak_t          peak_f32;
+        } cvt_kernels_t;
+
+        namespace generic
+        {
+            void u8_to_f32(void *dst, const void *src, size_t samples);
+            void s16_to_f32(void *dst, const void *src, size_t samples);
+            void s24_to_f32(void *dst, const void *src, size_t samples);
+            void s32_to_f32(void *dst, const void *src, size_t samples);
+            void f64_to_f32(void *dst, const void *src, size_t samples);
+
+            void f32_to_u8(void *dst, const void *src, size_t samples);
+            void f32_to_s16(void *dst, const void *src, size_t samples);
+            void f32_to_s24(void *dst, const void *src, size_t samples);
+            void f32_to_s32(void *dst, const void *src, size_t samples);
+            void f32_to_f64(void *dst, const void *src, size_t samples);
+
+            void f32_to_u8_round(void *dst, const void *src, size_t samples, cvt_dither_t *dither);
+            void f32_to_s16_round(void *dst, const void *src, size_t samples, cvt_dither_t *dither);
+            void f32_to_s24_round(void *dst, const void *src, size_t samples, cvt_dither_t *dither);
+            void f32_to_s32_round(void *dst, const void *src, size_t samples, cvt_dither_t *dither);
+
+            void xs16_to_f32(void *dst, const void *src, size_t samples);
+            void xs24_to_f32(void *dst, const void *src, size_t samples);
+            void xs32_to_f32(void *dst, const void *src, size_t samples);
+            void f32_to_xs16(void *dst, const void *src, size_t samples);
+            void f32_to_xs24(void *dst, const void *src, size_t samples);
+            void f32_to_xs32(void *dst, const void *src, size_t samples);
+            void swap_f32(void *dst, const void *src, size_t samples);
+
+            void s16_to_f32_planar(f32_t * const *dst, size_t off, const void *src, size_t channels, size_t frames);
+            void f32_to_f32_planar(f32_t * const *dst, size_t off, const void *src, size_t channels, size_t frames);
+            void f32_planar_to_s16(void *dst, const f32_t * const *src, size_t off, size_t channels, size_t frames);
+            void f32_planar_to_f32(void *dst, const f32_t * const *src, size_t off, size_t channels, size_t frames);
+
+            f32_t dot_f32(const f32_t *a, const f32_t *b, size_t count);
+            void peak_f32(f32_t *dst, const f32_t *src, size_t count);
+
+            extern const cvt_kernels_t  kernels;
+        }
+
+    #if defined(ARCH_X86)
+        namespace sse2
+        {
+            extern const cvt_kernels_t  kernels;
+        }
+
+        namespace ssse3
+        {
+            extern const cvt_kernels_t  kernels;
+        }
+
+        namespace avx2
+        {
+            extern const cvt_kernels_t  kernels;
+        }
+    #endif /* ARCH_X86 */
+
+    #if defined(ARCH_AARCH64) && defined(ARCH_LE)
+        namespace asimd
+        {
+            extern const cvt_kernels_t  kernels;
+        }
+    #endif /* ARCH_AARCH64 && ARCH_LE */
+
+        /**
+         * Get the fastest set of conversion routines supported by the CPU,
+         * the set is selected once at the first call
+         * @return set of conversion routines
+         */
+        const cvt_kernels_t *cvt_kernels();
+
+        /**
+         * Get all sets of conversion routines supported by the CPU,
+         * the generic set always goes first and the fastest set goes last
+         * @param sets array to store pointers to the sets
+         * @param max maximum number of elements to store
+         * @return number of stored elements
+         */
+        size_t cvt_supported_kernels(const cvt_kernels_t **sets, size_t max);
+
+        /**
+         * Initialize state of the dither noise generator
+         * @param dither dither noise generator
+         * @param seed initial seed
+         */
+        void cvt_init_dither(cvt_dither_t *dither, uint32_t seed);
+    }
+}
+
+#endif /* PRIVATE_MM_CVT_H_ */
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 30 мар. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PRIVATE_MM_RIFF_H_
+#define PRIVATE_MM_RIFF_H_
+
+#include <lsp-plug.in/runtime/version.h>
+#include <lsp-plug.in/common/types.h>
+
+/**
+ * Make four-character code of RIFF chunk, the value should be compared
+ * with the chunk identifier converted to the CPU byte order from little-endian
+ */
+#define RIFF_FOURCC(a, b, c, d)     \
+    (uint32_t(uint8_t(a)) | (uint32_t(uint8_t(b)) << 8) | (uint32_t(uint8_t(c)) << 16) | (uint32_t(uint8_t(d)) << 24))
+
+namespace lsp
+{
+    namespace mm
+    {
+        /** @note All data is stored in little-endian format!
+         * Structure of the WAV file:
+         *
+         *      1. RIFF header
+         *      2. 'fmt ' chunk
+         *      3. Optional chunks ('fact', 'LIST', etc.)
+         *      4. 'data' chunk
+         *      5. Optional chunks
+         *
+         * Each chunk is padded to the even number of bytes
+         */
+        enum riff_fourcc_t
+        {
+            RIFF_ID_RIFF                = RIFF_FOURCC('R', 'I', 'F', 'F'),
+            RIFF_ID_WAVE                = RIFF_FOURCC('W', 'A', 'V', 'E'),
+            RIFF_ID_FMT                 = RIFF_FOURCC('f', 'm', 't', ' '),
+            RIFF_ID_FACT                = RIFF_FOURCC('f', 'a', 'c', 't'),
+            RIFF_ID_DATA                = RIFF_FOURCC('d', 'a', 't', 'a')
+        };
+
+        enum wav_format_tag_t
+        {
+            WAV_FORMAT_PCM              = 0x0001,
+            WAV_FORMAT_IEEE_FLOAT       = 0x0003,
+            WAV_FORMAT_EXTENSIBLE       = 0xfffe
+        };
+
+    #pragma pack(push, 1)
+        typedef struct riff_chunk_t
+        {
+            uint32_t        id;             // Chunk identifier
+            uint32_t        size;           // Size of chunk data without padding
+        } riff_chunk_t;
+
+        typedef struct riff_header_t
+        {
+            riff_chunk_t    chunk;          // Chunk header, identifier should be 'RIFF'
+            uint32_t        type;           // Type of file, should be 'WAVE'
+        } riff_header_t;
+
+        typedef struct wav_format_t
+        {
+            uint16_t        format_tag;     // Format tag
+            uint16_t        channels;       // Number of channels
+            uint32_t        srate;          // Sample rate
+            uint32_t        byte_rate;      // Number of bytes per second
+            uint16_t        block_align;    // Size of frame in bytes
+            uint16_t        bits;           // Number of bits per sample
+            // Fields below are present for WAV_FORMAT_EXTENSIBLE only
+            uint16_t        ext_size;       // Size of extension
+            uint16_t        valid_bits;     // Number of valid bits per sample
+            uint32_t        channel_mask;   // Speaker position mask
+            uint8_t         sub_format[16]; // Sub-format GUID, first two bytes contain the format tag
+        } wav_format_t;
+    #pragma pack(pop)
+
+        /**
+         * Tail of sub-format GUID of WAV_FORMAT_EXTENSIBLE format that follows the format tag
+         */
+        static const uint8_t wav_subformat_guid[14] =
+        {
+            0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71
+        };
+
+        /**
+         * Size of the 'fmt ' chunk data for the plain PCM format
+         */
+        static const size_t WAV_FORMAT_PCM_SIZE     = 16;
+
+        /**
+         * Size of the 'fmt ' chunk data for the WAV_FORMAT_EXTENSIBLE format
+         */
+        static const size_t WAV_FORMAT_EXT_SIZE     = sizeof(wav_format_t);
+    }
+}
+
+#endif /* PRIVATE_MM_RIFF_H_ */
@@ -22,6 +22,8 @@
 #include <lsp-plug.in/common/endian.h>
 #include <lsp-plug.in/fmt/lspc/AudioReader.h>
 #include <lsp-plug.in/stdlib/string.h>
+#include <private/mm/cvt.h>
+#include <private/fmt/lspc/lossless.h>
 #include <stdlib.h>
 
 #define BUFFER_SIZE     0x2000
@@ -171,11 +173,21 @@ namespace lsp
             nBPS                    = 0;
             nFrameSize              = 0;
             nBytesLeft              = 0;
+            nDataOff                = 0;
             sBuf.vData              = NULL;
             sBuf.nOff               = 0;
             sBuf.nSize              = 0;
             pDecode                 = NULL;
+            pConvert                = NULL;
+            pDeinterleave           = NULL;
             pFBuffer                = NULL;
+            pCBuffer                = NULL;
+            pWork                   = NULL;
+            vBlocks                 = NULL;
+            nBlocks                 = 0;
+            nBlockCap               = 0;
+            nBlock                  = 0;
+            nBufFrame               = 0;
         }
 
         AudioReader::~AudioReader()
@@ -211,27 +223,57 @@ namespace lsp
             }
 
             // Drop buffers
+            drop_buffers();
+
+            nFlags          = 0;
+            nBPS            = 0;
+            nFrameSize      = 0;
+            nBytesLeft      = 0;
+            nDataOff        = 0;
+            sBuf.nOff       = 0;
+            sBuf.nSize      = 0;
+            pDecode         = NULL;
+            pConvert        = NULL;
+            pDeinterleave   = NULL;
+            return res;
+        }
+
+        void AudioReader::drop_buffers()
+        {
             if (sBuf.vData != NULL)
             {
                 delete [] sBuf.vData;
                 sBuf.vData      = NULL;
             }
 
-            // Drop buffers
             if (pFBuffer != NULL)
             {
                 delete [] pFBuffer;
                 pFBuffer        = NULL;
             }
 
-            nFlags          = 0;
-            nBPS            = 0;
-            nFrameSize      = 0;
-            nBytesLeft      = 0;
-            sBuf.nOff       = 0;
-            sBuf.nSize      = 0;
-            pDecode         = NULL;
-            return res;
+            if (pCBuffer != NULL)
+            {
+                delete [] pCBuffer;
+                pCBuffer        = NULL;
+            }
+
+            if (pWork != NULL)
+            {
+                delete [] pWork;
+                pWork           = NULL;
+            }
+
+            if (vBlocks != NULL)
+            {
+                free(vBlocks);
+                vBlocks         = NULL;
+            }
+
+            nBlocks         = 0;
+            nBlockCap       = 0;
+            nBlock          = 0;
+            nBufFrame       = 0;
         }
 
         status_t AudioReader::read_audio_header(ChunkReader *rd)
@@ -265,7 +307,9 @@ namespace lsp
                 return STATUS_BAD_FORMAT;
             if (p->sample_rate == 0)
                 return STATUS_BAD_FORMAT;
-            if (p->codec != LSPC_CODEC_PCM)
+            if ((p->codec != LSPC_CODEC_PCM) && (p->codec != LSPC_CODEC_LOSSLESS))
+                return STATUS_UNSUPPORTED_FORMAT;
+            if ((p->codec == LSPC_CODEC_LOSSLESS) && (!lossless::supported(p->sample_format)))
                 return STATUS_UNSUPPORTED_FORMAT;
 
             // Check sample format support
@@ -361,20 +405,68 @@ namespace lsp
             size_t fz               = sb * p->channels;
             size_t bytes_left       = fz * p->frames;
 
-            // Allocate buffers
-            sBuf.vData      = new uint8_t[BUFFER_SIZE];
-            if (sBuf.vData == NULL)
-                return STATUS_NO_MEM;
-
+            // Allocate buffers, the buffer should hold the whole decoded block of the lossless codec
+            size_t bufsize  = BUFFER_SIZE;
+            if (p->codec == LSPC_CODEC_LOSSLESS)
+            {
+                bufsize         = lsp_max(bufsize, fz * LSPC_LOSSLESS_BLOCK_FRAMES);
+                pCBuffer        = new uint8_t[lossless::block_bound(p->channels, p->sample_format, LSPC_LOSSLESS_BLOCK_FRAMES)];
+                pWork           = new int32_t[lossless::work_size(LSPC_LOSSLESS_BLOCK_FRAMES)];
+            }
+            sBuf.vData      = new uint8_t[bufsize];
             pFBuffer        = new float[p->channels * BUFFER_FRAMES];
-            if (pFBuffer == NULL)
+
+            if ((sBuf.vData == NULL) || (pFBuffer == NULL) ||
+                ((p->codec == LSPC_CODEC_LOSSLESS) && ((pCBuffer == NULL) || (pWork == NULL))))
             {
-                delete [] sBuf.vData;
-                sBuf.vData = NULL;
+                drop_buffers();
                 return STATUS_NO_MEM;
             }
 
-            if (le != arch_le)
+            // Select optimized conversion routines, the lossless codec produces samples in CPU byte order
+            const mm::cvt_kernels_t *k  = mm::cvt_kernels();
+            bool rev                    = (le != arch_le) && (p->codec != LSPC_CODEC_LOSSLESS);
+            convert_func_t cf           = NULL;
+            deinterleave_func_t dif     = NULL;
+
+            switch (p->sample_format)
+            {
+                case LSPC_SAMPLE_FMT_U8LE:
+                case LSPC_SAMPLE_FMT_U8BE:
+                    cf  = k->u8_to_f32;
+                    break;
+                case LSPC_SAMPLE_FMT_S16LE:
+                case LSPC_SAMPLE_FMT_S16BE:
+                    cf  = (rev) ? k->xs16_to_f32 : k->s16_to_f32;
+                    dif = (rev) ? NULL : k->s16_to_f32_planar;
+                    break;
+                case LSPC_SAMPLE_FMT_S24LE:
+                case LSPC_SAMPLE_FMT_S24BE:
+                    // The lossless codec also keeps 24-bit samples in the byte order of the format
+                    cf  = (le != arch_le) ? k->xs24_to_f32 : k->s24_to_f32;
+                    break;
+                case LSPC_SAMPLE_FMT_S32LE:
+                case LSPC_SAMPLE_FMT_S32BE:
+                    cf  = (rev) ? k->xs32_to_f32 : k->s32_to_f32;
+                    break;
+                case LSPC_SAMPLE_FMT_F32LE:
+                case LSPC_SAMPLE_FMT_F32BE:
+                    cf  = (rev) ? k->swap_f32 : NULL;
+                    dif = (rev) ? NULL : k->f32_to_f32_planar;
+                    if ((!rev) && (p->codec != LSPC_CODEC_LOSSLESS))
+                        nFlags     |= F_NATIVE;
+                    break;
+                case LSPC_SAMPLE_FMT_F64LE:
+                case LSPC_SAMPLE_FMT_F64BE:
+                    cf  = (rev) ? NULL : k->f64_to_f32;
+                    break;
+                default:
+                    break;
+            }
+
+            if (p->codec == LSPC_CODEC_LOSSLESS)
+                nFlags     |= F_LOSSLESS;
+            else if ((le != arch_le) && (cf == NULL))
                 nFlags     |= F_REV_BYTES; // Set-up byte-reversal flag
 
             sParams         = *p;
@@ -384,6 +476,8 @@ namespace lsp
             sBuf.nOff       = 0;
             sBuf.nSize      = 0;
             pDecode         = df;
+            pConvert        = cf;
+            pDeinterleave   = dif;
 
             return STATUS_OK;
         }
@@ -407,6 +501,7 @@ namespace lsp
 
             pFD         = lspc;
             pRD         = rd;
+            nDataOff    = rd->position();
             nFlags     |= F_OPENED | F_CLOSE_READER | F_DROP_READER;
             if (auto_close)
                 nFlags     |= F_CLOSE_FILE;
@@ -437,6 +532,7 @@ namespace lsp
 
             pFD         = lspc;
             pRD         = rd;
+            nDataOff    = rd->position();
             nFlags     |= F_OPENED | F_CLOSE_READER | F_DROP_READER;
             if (auto_close)
                 nFlags     |= F_CLOSE_FILE;
@@ -464,6 +560,7 @@ namespace lsp
 
             pFD         = lspc;
             pRD         = rd;
+            nDataOff    = rd->position();
             nFlags     |= F_OPENED | F_CLOSE_READER | F_DROP_READER;
             if (auto_close)
                 nFlags     |= F_CLOSE_FILE;
@@ -491,6 +588,7 @@ namespace lsp
 
             pFD         = lspc;
             pRD         = rd;
+            nDataOff    = rd->position();
             nFlags     |= F_OPENED | F_CLOSE_READER | F_DROP_READER;
             if (auto_close)
                 nFlags     |= F_CLOSE_FILE;
@@ -511,6 +609,7 @@ namespace lsp
 
             pFD         = NULL;
             pRD         = rd;
+            nDataOff    = rd->position();
             nFlags     |= F_OPENED;
             if (auto_close)
                 nFlags     |= F_CLOSE_READER;
@@ -528,8 +627,72 @@ namespace lsp
             return STATUS_OK;
         }
 
+        status_t AudioReader::add_block(wsize_t offset)
+        {
+            if (nBlocks >= nBlockCap)
+            {
+                size_t cap          = (nBlockCap > 0) ? nBlockCap << 1 : 0x40;
+                wsize_t *list       = static_cast<wsize_t *>(realloc(vBlocks, cap * sizeof(wsize_t)));
+                if (list == NULL)
+                    return STATUS_NO_MEM;
+                vBlocks             = list;
+                nBlockCap           = cap;
+            }
+
+            vBlocks[nBlocks++]  = offset;
+            return STATUS_OK;
+        }
+
+        status_t AudioReader::decode_block()
+        {
+            // Remember the offset of each block to seek it later
+            if (nBlock >= nBlocks)
+            {
+                status_t res    = add_block(pRD->position());
+                if (res != STATUS_OK)
+                    return res;
+            }
+
+            // Read the block
+            chunk_audio_block_t hdr;
+            ssize_t n       = pRD->read(&hdr, sizeof(hdr));
+            if (n < 0)
+                return status_t(-n);
+            else if (n == 0)
+                return STATUS_EOF;
+            else if (n < ssize_t(sizeof(hdr)))
+                return STATUS_CORRUPTED_FILE;
+
+            size_t size     = BE_TO_CPU(hdr.size);
+            size_t frames   = BE_TO_CPU(hdr.frames);
+            if ((frames <= 0) || (frames > LSPC_LOSSLESS_BLOCK_FRAMES) ||
+                (size > lossless::block_bound(sParams.channels, sParams.sample_format, frames) - sizeof(hdr)))
+                return STATUS_CORRUPTED_FILE;
+
+            n               = pRD->read(pCBuffer, size);
+            if (n < 0)
+                return status_t(-n);
+            else if (n < ssize_t(size))
+                return STATUS_CORRUPTED_FILE;
+
+            // Decode the block
+            status_t res    = lossless::decode(sBuf.vData, pCBuffer, size, sParams.channels, sParams.sample_format, frames, pWork);
+            if (res != STATUS_OK)
+                return res;
+
+            sBuf.nOff       = 0;
+            sBuf.nSize      = frames * nFrameSize;
+            nBufFrame       = wsize_t(nBlock++) * LSPC_LOSSLESS_BLOCK_FRAMES;
+
+            return STATUS_OK;
+        }
+
         status_t AudioReader::fill_buffer()
         {
+            // Blocks of the lossless codec contain whole frames
+            if (nFlags & F_LOSSLESS)
+                return (sBuf.nOff >= sBuf.nSize) ? decode_block() : STATUS_CORRUPTED_FILE;
+
             // Move buffer data from end to the beginning
             size_t bsize = sBuf.nSize - sBuf.nOff;
             if ((sBuf.nSize > 0) && (bsize > 0))
@@ -567,37 +730,53 @@ namespace lsp
                 return STATUS_CLOSED;
 
             size_t nc       = sParams.channels;
-            float **vp = reinterpret_cast<float **>(alloca(nc * sizeof(float *)));
-            for (size_t i=0; i<nc; ++i)
-                vp[i]       = data[i];
 
-            size_t n_read   = 0;
+            // Single channel in CPU byte order does not need any conversion
+            if ((nFlags & F_NATIVE) && (nc == 1) && (data[0] != NULL))
+                return read_frames(data[0], frames);
 
+            size_t n_read   = 0;
             while (n_read < frames)
             {
-                // Estimate number of frames to read
                 size_t to_read = frames - n_read;
-                if (to_read > BUFFER_FRAMES)
-                    to_read = BUFFER_FRAMES;
 
-                // Read frames to temporary buffer
-                ssize_t n   = read_frames(pFBuffer, to_read);
-                if (n <= 0)
-                    return (n_read > 0) ? n_read : n;
+                // Read frames to temporary buffer and unpack them if there is no optimized routine
+                if (pDeinterleave == NULL)
+                {
+                    if (to_read > BUFFER_FRAMES)
+                        to_read = BUFFER_FRAMES;
+
+                    ssize_t n   = read_frames(pFBuffer, to_read);
+                    if (n <= 0)
+                        return (n_read > 0) ? n_read : n;
 
-                n_read     += n;
+                    mm::cvt_kernels()->f32_to_f32_planar(data, n_read, pFBuffer, nc, n);
+                    n_read     += n;
+                    continue;
+                }
 
-                // Unpack frames
-                float *p    = pFBuffer;
-                while (n--)
+                // Ensure that we have enough bytes to read at least one frame
+                size_t avail = sBuf.nSize - sBuf.nOff;
+                if (avail < nFrameSize)
                 {
-                    for (size_t j=0; j<nc; ++j, ++p)
-                    {
-                        if (!vp[j])
-                            continue;
-                        *(vp[j]++)      = *p;
-                    }
+                    // Try to fill buffer with new data
+                    status_t st = fill_buffer();
+                    if (st != STATUS_OK)
+                        return (n_read > 0) ? n_read : -st;
+                    avail = sBuf.nSize - sBuf.nOff;
+                    if (avail < nFrameSize)
+                        return (n_read > 0) ? n_read : STATUS_CORRUPTED_FILE;
                 }
+
+                // Decode frames directly to the destination buffers
+                avail   /= nFrameSize;
+                if (avail > to_read)
+                    avail   = to_read;
+                pDeinterleave(data, n_read, &sBuf.vData[sBuf.nOff], nc, avail);
+
+                // Update pointers
+                n_read         += avail;
+                sBuf.nOff      += avail * nFrameSize;
             }
 
             return n_read;
@@ -615,6 +794,30 @@ namespace lsp
 
                 // Ensure that we have enough bytes to read at least one frame
                 size_t avail = sBuf.nSize - sBuf.nOff;
+
+                // Samples in CPU byte order are read directly to the destination buffer
+                if ((nFlags & F_NATIVE) && (avail == 0) && (to_read >= BUFFER_FRAMES))
+                {
+                    uint8_t *dst    = reinterpret_cast<uint8_t *>(data);
+                    ssize_t n       = pRD->read(dst, to_read * nFrameSize);
+                    if (n < 0)
+                        return (n_read > 0) ? n_read : n;
+                    else if (n > 0)
+                    {
+                        // Keep the incomplete frame in the buffer
+                        size_t count    = n / nFrameSize;
+                        size_t tail     = n - count * nFrameSize;
+                        if (tail > 0)
+                            ::memcpy(sBuf.vData, &dst[count * nFrameSize], tail);
+                        sBuf.nOff       = 0;
+                        sBuf.nSize      = tail;
+
+                        n_read         += count;
+                        data           += count * sParams.channels;
+                        continue;
+                    }
+                }
+
                 if (avail < nFrameSize)
                 {
                     // Try to fill buffer with new data
@@ -653,7 +856,10 @@ namespace lsp
                 }
 
                 // Perform decode
-                pDecode(data, &sBuf.vData[sBuf.nOff], floats);
+                if (pConvert != NULL)
+                    pConvert(data, &sBuf.vData[sBuf.nOff], floats);
+                else
+                    pDecode(data, &sBuf.vData[sBuf.nOff], floats);
 
                 // Update pointers
                 n_read         += avail;
@@ -700,6 +906,131 @@ namespace lsp
             return n_skip;
         }
 
+        status_t AudioReader::seek_block(wsize_t frame)
+        {
+            // The frame is within the decoded block?
+            if ((sBuf.nSize > 0) && (frame >= nBufFrame) && (frame <= nBufFrame + sBuf.nSize / nFrameSize))
+            {
+                sBuf.nOff       = (frame - nBufFrame) * nFrameSize;
+                return STATUS_OK;
+            }
+
+            // Seek for the nearest known block
+            if (nBlocks <= 0)
+            {
+                status_t res    = add_block(nDataOff);
+                if (res != STATUS_OK)
+                    return res;
+            }
+
+            size_t index    = frame / LSPC_LOSSLESS_BLOCK_FRAMES;
+            size_t known    = lsp_min(index, nBlocks - 1);
+            status_t res    = pRD->seek(vBlocks[known]);
+            if (res != STATUS_OK)
+                return res;
+
+            nBlock          = known;
+            nBufFrame       = wsize_t(known) * LSPC_LOSSLESS_BLOCK_FRAMES;
+            sBuf.nOff       = 0;
+            sBuf.nSize      = 0;
+
+            // Walk through the headers of blocks that have not been discovered yet
+            chunk_audio_block_t hdr;
+            while (nBlock < index)
+            {
+                if (nBlock >= nBlocks)
+                {
+                    if ((res = add_block(pRD->position())) != STATUS_OK)
+                        return res;
+                }
+
+                ssize_t n       = pRD->read(&hdr, sizeof(hdr));
+                if (n < 0)
+                    return status_t(-n);
+                else if (n == 0)
+                    return STATUS_EOF;
+                else if (n < ssize_t(sizeof(hdr)))
+                    return STATUS_CORRUPTED_FILE;
+                else if (BE_TO_CPU(hdr.frames) != LSPC_LOSSLESS_BLOCK_FRAMES)
+                    return (BE_TO_CPU(hdr.frames) < LSPC_LOSSLESS_BLOCK_FRAMES) ? STATUS_EOF : STATUS_CORRUPTED_FILE;
+
+                size_t size     = BE_TO_CPU(hdr.size);
+                if ((n = pRD->skip(size)) < 0)
+                    return status_t(-n);
+                else if (n < ssize_t(size))
+                    return STATUS_CORRUPTED_FILE;
+
+                nBufFrame      += LSPC_LOSSLESS_BLOCK_FRAMES;
+                ++nBlock;
+            }
+
+            // Decode the block and position to the frame
+            res             = decode_block();
+            if (res == STATUS_EOF)
+                return (frame == nBufFrame) ? STATUS_OK : STATUS_EOF;
+            else if (res != STATUS_OK)
+                return res;
+
+            wsize_t offset  = (frame - nBufFrame) * nFrameSize;
+            if (offset > sBuf.nSize)
+                return STATUS_EOF;
+            sBuf.nOff       = offset;
+
+            return STATUS_OK;
+        }
+
+        status_t AudioReader::seek(wsize_t frame)
+        {
+            if (!(nFlags & F_OPENED))
+                return STATUS_CLOSED;
+            if (nFlags & F_LOSSLESS)
+                return seek_block(frame);
+
+            // The buffer holds the chunk data right before the current position of the chunk reader
+            wsize_t offset  = nDataOff + frame * nFrameSize;
+            wsize_t tail    = pRD->position();
+            wsize_t head    = tail - sBuf.nSize;
+
+            // Bytes before the read pointer may be already reversed, so they can not be re-used
+            if (nFlags & F_REV_BYTES)
+                head           += sBuf.nOff;
+
+            if ((offset >= head) && (offset <= tail))
+            {
+                sBuf.nOff       = offset - (tail - sBuf.nSize);
+                return STATUS_OK;
+            }
+
+            // Re-position the chunk reader and drop the buffered data
+            // The buffer remains valid if the chunk reader has kept its position on error
+            status_t res    = pRD->seek(offset);
+            if (res != STATUS_OK)
+            {
+                if (pRD->position() != tail)
+                {
+                    sBuf.nOff       = 0;
+                    sBuf.nSize      = 0;
+                }
+                return res;
+            }
+
+            sBuf.nOff       = 0;
+            sBuf.nSize      = 0;
+
+            return STATUS_OK;
+        }
+
+        wssize_t AudioReader::position() const
+        {
+            if (!(nFlags & F_OPENED))
+                return -STATUS_CLOSED;
+            if (nFlags & F_LOSSLESS)
+                return nBufFrame + sBuf.nOff / nFrameSize;
+
+            wsize_t offset  = pRD->position() - (sBuf.nSize - sBuf.nOff);
+            return (offset - nDataOff) / nFrameSize;
+        }
+
         uint32_t AudioReader::unique_id() const
         {
             if (!(nFlags & F_OPENED))
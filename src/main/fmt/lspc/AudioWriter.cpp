@@ -21,6 +21,8 @@
 
 #include <lsp-plug.in/common/endian.h>
 #include <lsp-plug.in/fmt/lspc/AudioWriter.h>
+#include <private/mm/cvt.h>
+#include <private/fmt/lspc/lossless.h>
 #include <stdlib.h>
 
 #define BUFFER_FRAMES   0x400
@@ -149,8 +151,14 @@ namespace lsp
             nBPS                    = 0;
             nFrameChannels          = 0;
             pEncode                 = NULL;
+            pConvert                = NULL;
+            pInterleave             = NULL;
             pBuffer                 = NULL;
             pFBuffer                = NULL;
+            pBlock                  = NULL;
+            nBlockFrames            = 0;
+            pCBuffer                = NULL;
+            pWork                   = NULL;
         }
 
         AudioWriter::~AudioWriter()
@@ -161,7 +169,8 @@ namespace lsp
 
         status_t AudioWriter::free_resources()
         {
-            status_t res = STATUS_OK;
+            // Write the pending block of the lossless codec
+            status_t res = ((pWD != NULL) && (nFlags & F_OPENED)) ? flush_block() : STATUS_OK;
             if (pWD != NULL)
             {
                 status_t xr = STATUS_OK;
@@ -201,10 +210,31 @@ namespace lsp
                 pBuffer = NULL;
             }
 
+            if (pBlock != NULL)
+            {
+                delete [] pBlock;
+                pBlock = NULL;
+            }
+
+            if (pCBuffer != NULL)
+            {
+                delete [] pCBuffer;
+                pCBuffer = NULL;
+            }
+
+            if (pWork != NULL)
+            {
+                delete [] pWork;
+                pWork = NULL;
+            }
+            nBlockFrames            = 0;
+
             nFlags                  = 0;
             nBPS                    = 0;
             nFrameChannels          = 0;
             pEncode                 = NULL;
+            pConvert                = NULL;
+            pInterleave             = NULL;
 
             return res;
         }
@@ -225,8 +255,10 @@ namespace lsp
                 return STATUS_BAD_FORMAT;
             else if (p->sample_rate == 0)
                 return STATUS_BAD_FORMAT;
-            else if (p->codec != LSPC_CODEC_PCM)
+            else if ((p->codec != LSPC_CODEC_PCM) && (p->codec != LSPC_CODEC_LOSSLESS))
                 return STATUS_BAD_FORMAT;
+            else if ((p->codec == LSPC_CODEC_LOSSLESS) && (!lossless::supported(p->sample_format)))
+                return STATUS_UNSUPPORTED_FORMAT;
 
             size_t sb           = 0;
             encode_func_t ef    = NULL;
@@ -335,7 +367,63 @@ namespace lsp
                 return STATUS_NO_MEM;
             }
 
-            if (le != arch_le)
+            // Select optimized conversion routines, the lossless codec operates on samples in CPU byte order
+            const mm::cvt_kernels_t *k  = mm::cvt_kernels();
+            bool rev                    = (le != arch_le) && (p->codec != LSPC_CODEC_LOSSLESS);
+            convert_func_t cf           = NULL;
+            interleave_func_t inf       = NULL;
+
+            switch (p->sample_format)
+            {
+                case LSPC_SAMPLE_FMT_U8LE:
+                case LSPC_SAMPLE_FMT_U8BE:
+                    cf  = k->f32_to_u8;
+                    break;
+                case LSPC_SAMPLE_FMT_S16LE:
+                case LSPC_SAMPLE_FMT_S16BE:
+                    cf  = (rev) ? k->f32_to_xs16 : k->f32_to_s16;
+                    inf = (rev) ? NULL : k->f32_planar_to_s16;
+                    break;
+                case LSPC_SAMPLE_FMT_S24LE:
+                case LSPC_SAMPLE_FMT_S24BE:
+                    // The lossless codec also keeps 24-bit samples in the byte order of the format
+                    cf  = (le != arch_le) ? k->f32_to_xs24 : k->f32_to_s24;
+                    break;
+                case LSPC_SAMPLE_FMT_S32LE:
+                case LSPC_SAMPLE_FMT_S32BE:
+                    cf  = (rev) ? k->f32_to_xs32 : k->f32_to_s32;
+                    break;
+                case LSPC_SAMPLE_FMT_F32LE:
+                case LSPC_SAMPLE_FMT_F32BE:
+                    cf  = (rev) ? k->swap_f32 : NULL;
+                    inf = (rev) ? NULL : k->f32_planar_to_f32;
+                    if (!rev)
+                        nFlags     |= F_NATIVE;
+                    break;
+                case LSPC_SAMPLE_FMT_F64LE:
+                case LSPC_SAMPLE_FMT_F64BE:
+                    cf  = (rev) ? NULL : k->f32_to_f64;
+                    break;
+                default:
+                    break;
+            }
+
+            // The lossless codec stores samples block by block
+            if (p->codec == LSPC_CODEC_LOSSLESS)
+            {
+                pBlock          = new uint8_t[fz * LSPC_LOSSLESS_BLOCK_FRAMES];
+                pCBuffer        = new uint8_t[lossless::block_bound(p->channels, p->sample_format, LSPC_LOSSLESS_BLOCK_FRAMES)];
+                pWork           = new int32_t[lossless::work_size(LSPC_LOSSLESS_BLOCK_FRAMES)];
+                nBlockFrames    = 0;
+                if ((pBlock == NULL) || (pCBuffer == NULL) || (pWork == NULL))
+                {
+                    free_resources();
+                    return STATUS_NO_MEM;
+                }
+
+                nFlags         |= F_LOSSLESS;
+            }
+            else if ((le != arch_le) && (cf == NULL))
                 nFlags     |= F_REV_BYTES; // Set-up byte-reversal flag
             if (int_sample)
                 nFlags     |= F_INTEGER_SAMPLE;
@@ -344,6 +432,8 @@ namespace lsp
             nBPS            = sb;
             nFrameChannels  = p->channels;
             pEncode         = ef;
+            pConvert        = cf;
+            pInterleave     = inf;
 
             return STATUS_OK;
         }
@@ -532,6 +622,7 @@ namespace lsp
                 return res;
             }
 
+            pWD         = wr;
             nFlags     |= F_OPENED;
             if (auto_close)
                 nFlags     |= F_CLOSE_WRITER;
@@ -548,6 +639,7 @@ namespace lsp
             if (res != STATUS_OK)
                 return res;
 
+            pWD         = wr;
             nFlags     |= F_OPENED;
             if (auto_close)
                 nFlags     |= F_CLOSE_WRITER;
@@ -560,9 +652,10 @@ namespace lsp
                 return STATUS_CLOSED;
 
             size_t nc       = sParams.channels;
-            const float **vp = reinterpret_cast<const float **>(alloca(nc * sizeof(float *)));
-            for (size_t i=0; i<nc; ++i)
-                vp[i]       = data[i];
+
+            // Single channel in CPU byte order does not need any conversion
+            if ((nFlags & F_NATIVE) && (nc == 1) && (data[0] != NULL))
+                return write_frames(data[0], frames);
 
             size_t n_written = 0;
             while (n_written < frames)
@@ -572,16 +665,21 @@ namespace lsp
                 if (to_write > BUFFER_FRAMES)
                     to_write = BUFFER_FRAMES;
 
-                // Pack frames
-                float *p    = pBuffer;
-                for (size_t i=0; i<to_write; ++i)
-                    for (size_t j=0; j<nc; ++j, ++p)
-                        *p = (vp[j]) ? *(vp[j]++) : 0.0f;
-
-                // Write frames
-                status_t res    = write_frames(pBuffer, to_write);
+                // Pack frames directly to the output format if possible
+                status_t res;
+                if (pInterleave != NULL)
+                {
+                    pInterleave(pFBuffer, data, n_written, nc, to_write);
+                    res             = write_encoded(pFBuffer, to_write);
+                }
+                else
+                {
+                    mm::cvt_kernels()->f32_planar_to_f32(pBuffer, data, n_written, nc, to_write);
+                    res             = write_frames(pBuffer, to_write);
+                }
                 if (res != STATUS_OK)
                     return res;
+
                 n_written  += to_write;
             }
 
@@ -593,6 +691,10 @@ namespace lsp
             if (!(nFlags & F_OPENED))
                 return STATUS_CLOSED;
 
+            // Samples in CPU byte order are written without copying
+            if (nFlags & F_NATIVE)
+                return write_encoded(reinterpret_cast<const uint8_t *>(data), frames);
+
             size_t n_written = 0;
             while (n_written < frames)
             {
@@ -603,7 +705,10 @@ namespace lsp
 
                 // Copy frames to buffer
                 size_t floats = to_write * nFrameChannels;
-                pEncode(pFBuffer, pBuffer, floats);
+                if (pConvert != NULL)
+                    pConvert(pFBuffer, data, floats);
+                else
+                    pEncode(pFBuffer, data, floats);
 
                 // Reverse bytes (if required)
                 if (nFlags & F_REV_BYTES)
@@ -628,7 +733,7 @@ namespace lsp
                 }
 
                 // Write data to LSPC
-                status_t res = pWD->write(pFBuffer, floats * nBPS);
+                status_t res = write_encoded(pFBuffer, to_write);
                 if (res != STATUS_OK)
                     return res;
 
@@ -639,6 +744,51 @@ namespace lsp
             return STATUS_OK;
         }
 
+        status_t AudioWriter::write_encoded(const uint8_t *data, size_t frames)
+        {
+            return (nFlags & F_LOSSLESS) ?
+                write_block(data, frames) :
+                pWD->write(data, frames * nBPS * nFrameChannels);
+        }
+
+        status_t AudioWriter::write_block(const uint8_t *data, size_t frames)
+        {
+            size_t fz       = nBPS * nFrameChannels;
+
+            while (frames > 0)
+            {
+                // Append frames to the pending block
+                size_t to_copy  = lsp_min(frames, LSPC_LOSSLESS_BLOCK_FRAMES - nBlockFrames);
+                ::memcpy(&pBlock[nBlockFrames * fz], data, to_copy * fz);
+                nBlockFrames   += to_copy;
+                data           += to_copy * fz;
+                frames         -= to_copy;
+
+                // Encode and write the block if it is complete
+                if (nBlockFrames >= LSPC_LOSSLESS_BLOCK_FRAMES)
+                {
+                    status_t res    = flush_block();
+                    if (res != STATUS_OK)
+                        return res;
+                }
+            }
+
+            return STATUS_OK;
+        }
+
+        status_t AudioWriter::flush_block()
+        {
+            if (nBlockFrames <= 0)
+                return STATUS_OK;
+
+            ssize_t size    = lossless::encode(pCBuffer, pBlock, nFrameChannels, sParams.sample_format, nBlockFrames, pWork);
+            nBlockFrames    = 0;
+            if (size < 0)
+                return status_t(-size);
+
+            return pWD->write(pCBuffer, size);
+        }
+
         status_t AudioWriter::get_parameters(audio_parameters_t *dst) const
         {
             if (!(nFlags & F_OPENED))
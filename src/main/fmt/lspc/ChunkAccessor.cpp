@@ -20,7 +20,11 @@
  */
 
 #include <lsp-plug.in/fmt/lspc/ChunkAccessor.h>
+#include <lsp-plug.in/fmt/lspc/lspc.h>
+#include <lsp-plug.in/common/atomic.h>
 #include <lsp-plug.in/common/debug.h>
+#include <lsp-plug.in/common/endian.h>
+#include <lsp-plug.in/stdlib/string.h>
 
 #include <errno.h>
 #include <stdlib.h>
@@ -40,7 +44,7 @@ namespace lsp
         {
             if (FD_INVALID(fd))
                 return STATUS_CLOSED;
-            ++refs;
+            atomic_add(&refs, 1);
             return STATUS_OK;
         }
 
@@ -48,41 +52,85 @@ namespace lsp
         {
             if (FD_INVALID(fd))
                 return STATUS_CLOSED;
-            if ((--refs) <= 0)
-            {
+            if (atomic_add(&refs, -1) > 1)
+                return STATUS_OK;
+
+            // The last reference has been released, destroy the resource
     #if defined(PLATFORM_WINDOWS)
-                CloseHandle(fd);
-                fd      = INVALID_HANDLE_VALUE;
+            CloseHandle(fd);
+            fd      = INVALID_HANDLE_VALUE;
     #else
-                close(fd);
-                fd      = -1;
+            close(fd);
+            fd      = -1;
     #endif /* PLATFORM_WINDOWS */
+
+            drop_index();
+            if (frags != NULL)
+            {
+                free(frags);
+                frags       = NULL;
             }
+            nfrags      = 0;
+            capfrags    = 0;
 
+            delete this;
             return STATUS_OK;
         }
     
         status_t Resource::allocate(uint32_t *id)
         {
-            uint32_t cid = chunk_id + 1;
-            if (cid == 0)
-                return STATUS_OVERFLOW;
-            *id = chunk_id = cid;
+            status_t res    = STATUS_OK;
+
+            lock.lock();
+            uint32_t cid    = chunk_id + 1;
+            if (cid != 0)
+                *id             = chunk_id = cid;
+            else
+                res             = STATUS_OVERFLOW;
+            lock.unlock();
+
+            return res;
+        }
+
+        status_t Resource::reserve(wsize_t *pos, size_t count)
+        {
+            if (FD_INVALID(fd))
+                return STATUS_CLOSED;
+
+            lock.lock();
+            *pos            = length;
+            length         += count;
+            lock.unlock();
+
             return STATUS_OK;
         }
 
         status_t Resource::write(const void *buf, size_t count)
+        {
+            // Write data at the end of file
+            wsize_t pos;
+            status_t res    = reserve(&pos, count);
+            return (res == STATUS_OK) ? write(pos, buf, count) : res;
+        }
+
+        status_t Resource::write(wsize_t pos, const void *buf, size_t count)
         {
             if (FD_INVALID(fd))
                 return STATUS_CLOSED;
 
-            // Write data at the end of file
+            // Write data at the specified position, positional writes do not modify the state
+            // of the file handle, so several writers may write reserved areas concurrently
             const uint8_t *bptr = static_cast<const uint8_t *>(buf);
             while (count > 0)
             {
     #if defined(PLATFORM_WINDOWS)
+                OVERLAPPED ov;
+                ::memset(&ov, 0, sizeof(ov));
+                ov.Offset       = DWORD(pos & 0xffffffff);
+                ov.OffsetHigh   = DWORD(pos >> 32);
+
                 DWORD written = 0;
-                if (!WriteFile(fd, bptr, count, &written, NULL))
+                if (!WriteFile(fd, bptr, count, &written, &ov))
                 {
                     DWORD error = GetLastError();
                     if (error != ERROR_IO_PENDING)
@@ -95,20 +143,19 @@ namespace lsp
     #else
                 errno       = 0;
 
-                ssize_t written  = pwrite(fd, bptr, count, length);
-                if (written < ssize_t(count))
+                ssize_t written  = pwrite(fd, bptr, count, pos);
+                if (written <= 0)
                 {
                     int error = errno;
-                    if (error != 0)
-                    {
-                        lsp_trace("Error write: errno=%d", error);
-                        return STATUS_IO_ERROR;
-                    }
+                    if ((written < 0) && (error == EINTR))
+                        continue;
+                    lsp_trace("Error write: errno=%d", error);
+                    return STATUS_IO_ERROR;
                 }
     #endif /* PLATFORM_WINDOWS */
 
                 bptr       += written;
-                length     += written;
+                pos        += written;
                 count      -= written;
             }
 
@@ -120,39 +167,42 @@ namespace lsp
             if (FD_INVALID(fd))
                 return -STATUS_CLOSED;
 
-            // Write data at the end of file
+            // Read data at the specified position, positional reads do not modify the state
+            // of the file handle, so several readers may read the same resource concurrently
             uint8_t *bptr   = static_cast<uint8_t *>(buf);
             ssize_t total   = 0;
 
-    #if defined(PLATFORM_WINDOWS)
-            LARGE_INTEGER set_pos;
-            LARGE_INTEGER seek_pos;
-
-            set_pos.QuadPart    = pos;
-            if (!SetFilePointerEx(fd, set_pos, &seek_pos, FILE_BEGIN))
-                return -STATUS_IO_ERROR;
-            else if (seek_pos.QuadPart != set_pos.QuadPart)
-                return -STATUS_IO_ERROR;
-    #endif /* PLATFORM_WINDOWS */
-
             while (count > 0)
             {
     #if defined(PLATFORM_WINDOWS)
+                OVERLAPPED ov;
+                ::memset(&ov, 0, sizeof(ov));
+                ov.Offset       = DWORD(pos & 0xffffffff);
+                ov.OffsetHigh   = DWORD(pos >> 32);
+
                 DWORD read = 0;
-                if (!ReadFile(fd, bptr, count, &read, NULL))
+                if (!ReadFile(fd, bptr, count, &read, &ov))
                 {
                     DWORD error = GetLastError();
-                    if (error != ERROR_IO_PENDING)
-                        return -STATUS_IO_ERROR;
-                    read = 0;
+                    if (error == ERROR_HANDLE_EOF)
+                        break;
+                    return (total > 0) ? total : -STATUS_IO_ERROR;
                 }
     #else
-                size_t read = pread(fd, bptr, count, pos);
+                ssize_t read = pread(fd, bptr, count, pos);
+                if (read < 0)
+                {
+                    int error = errno;
+                    if (error == EINTR)
+                        continue;
+                    return (total > 0) ? total : -STATUS_IO_ERROR;
+                }
     #endif /* PLATFORM_WINDOWS */
-                if (read < count)
-                    return total;
+                if (read == 0)
+                    break;
 
                 bptr       += read;
+                pos        += read;
                 count      -= read;
                 total      += read;
             }
@@ -160,6 +210,152 @@ namespace lsp
             return total;
         }
 
+        status_t Resource::write_fragment(uint32_t magic, uint32_t uid, uint32_t flags, const void *buf, size_t count)
+        {
+            if (FD_INVALID(fd))
+                return STATUS_CLOSED;
+
+            chunk_header_t hdr;
+            hdr.magic       = CPU_TO_BE(magic);
+            hdr.uid         = CPU_TO_BE(uid);
+            hdr.flags       = CPU_TO_BE(flags);
+            hdr.size        = CPU_TO_BE(uint32_t(count));
+
+            // Reserve the space for the fragment and remember it for the index atomically,
+            // the fragment itself is written outside of the critical section
+            lock.lock();
+            wsize_t pos     = length;
+            status_t res    = add_fragment(magic, uid, flags, count, pos + sizeof(chunk_header_t));
+            if (res == STATUS_OK)
+                length         += sizeof(chunk_header_t) + count;
+            lock.unlock();
+            if (res != STATUS_OK)
+                return res;
+
+            // Write fragment header and data to file
+            res             = write(pos, &hdr, sizeof(chunk_header_t));
+            if ((res == STATUS_OK) && (count > 0))
+                res             = write(pos + sizeof(chunk_header_t), buf, count);
+
+            return res;
+        }
+
+        status_t Resource::add_fragment(uint32_t magic, uint32_t uid, uint32_t flags, uint32_t size, wsize_t offset)
+        {
+            if (nfrags >= capfrags)
+            {
+                size_t cap          = (capfrags > 0) ? capfrags << 1 : 0x100;
+                chunk_fragment_t *f = static_cast<chunk_fragment_t *>(realloc(frags, cap * sizeof(chunk_fragment_t)));
+                if (f == NULL)
+                    return STATUS_NO_MEM;
+                frags               = f;
+                capfrags            = cap;
+            }
+
+            chunk_fragment_t *f = &frags[nfrags++];
+            f->magic        = magic;
+            f->uid          = uid;
+            f->flags        = flags;
+            f->size         = size;
+            f->offset       = offset;
+            f->position     = 0;
+
+            return STATUS_OK;
+        }
+
+        static int cmp_fragments(const void *a, const void *b)
+        {
+            const chunk_fragment_t *fa = static_cast<const chunk_fragment_t *>(a);
+            const chunk_fragment_t *fb = static_cast<const chunk_fragment_t *>(b);
+
+            if (fa->uid != fb->uid)
+                return (fa->uid < fb->uid) ? -1 : 1;
+            if (fa->offset != fb->offset)
+                return (fa->offset < fb->offset) ? -1 : 1;
+            return 0;
+        }
+
+        status_t Resource::build_index()
+        {
+            drop_index();
+
+            // Group fragments by chunk keeping the order of fragments in file
+            if (nfrags > 1)
+                qsort(frags, nfrags, sizeof(chunk_fragment_t), cmp_fragments);
+
+            size_t count    = 0;
+            for (size_t i=0; i<nfrags; ++i)
+                if ((i == 0) || (frags[i].uid != frags[i-1].uid))
+                    ++count;
+
+            chunk_info_t *list  = static_cast<chunk_info_t *>(malloc(lsp_max(count, size_t(1)) * sizeof(chunk_info_t)));
+            if (list == NULL)
+                return STATUS_NO_MEM;
+
+            chunk_info_t *c = NULL;
+            wsize_t position    = 0;
+            for (size_t i=0; i<nfrags; ++i)
+            {
+                chunk_fragment_t *f = &frags[i];
+                if ((c == NULL) || (c->uid != f->uid))
+                {
+                    c               = (c == NULL) ? list : &c[1];
+                    c->uid          = f->uid;
+                    c->magic        = f->magic;
+                    c->first        = i;
+                    c->count        = 0;
+                    position        = 0;
+                }
+                ++c->count;
+
+                // Compute the offset of the fragment data within the chunk
+                f->position     = position;
+                position       += f->size;
+            }
+
+            chunks          = list;
+            nchunks         = count;
+
+            return STATUS_OK;
+        }
+
+        void Resource::drop_index()
+        {
+            if (chunks != NULL)
+            {
+                free(chunks);
+                chunks      = NULL;
+            }
+            nchunks     = 0;
+        }
+
+        const chunk_info_t *Resource::find(uint32_t uid) const
+        {
+            if (nchunks <= 0)
+                return NULL;
+
+            // Identifiers are allocated sequentially by writers, so try the direct lookup first
+            size_t idx      = uint32_t(uid - chunks[0].uid);
+            if ((idx < nchunks) && (chunks[idx].uid == uid))
+                return &chunks[idx];
+
+            // Perform binary search
+            ssize_t first = 0, last = nchunks - 1;
+            while (first <= last)
+            {
+                ssize_t mid     = (first + last) >> 1;
+                uint32_t cuid   = chunks[mid].uid;
+                if (cuid == uid)
+                    return &chunks[mid];
+                else if (cuid < uid)
+                    first           = mid + 1;
+                else
+                    last            = mid - 1;
+            }
+
+            return NULL;
+        }
+
         ChunkAccessor::ChunkAccessor(Resource *fd, uint32_t magic)
         {
             pFile           = fd;
@@ -203,8 +399,6 @@ namespace lsp
             if (pFile == NULL)
                 return set_error(STATUS_CLOSED);
             set_error(pFile->release());
-            if (pFile->refs <= 0)
-                delete pFile;
             pFile = NULL;
             return last_error();
         }
@@ -34,21 +34,81 @@ namespace lsp
             nUnread     = 0;
             nBufTail    = 0;
             nFileOff    = 0;
+            nPosition   = 0;
             nUID        = uid;
             bLast       = false;
+            pChunk      = NULL;
+            nFragment   = 0;
         }
 
         ChunkReader::~ChunkReader()
         {
         }
+
+        void ChunkReader::set_chunk(const chunk_info_t *chunk)
+        {
+            const chunk_fragment_t *f = &pFile->frags[chunk->first];
+
+            pChunk      = chunk;
+            nFragment   = 0;
+            nPosition   = 0;
+            nFileOff    = f->offset;
+            nUnread     = f->size;
+            bLast       = f->flags & LSPC_CHUNK_FLAG_LAST;
+        }
+
+        status_t ChunkReader::next_fragment()
+        {
+            // There is no chunk after current
+            if (bLast)
+                return STATUS_EOF;
+
+            // Use the index of the file if it is present
+            if (pChunk != NULL)
+            {
+                if ((++nFragment) >= pChunk->count)
+                    return STATUS_EOF;
+
+                const chunk_fragment_t *f = &pFile->frags[pChunk->first + nFragment];
+                nFileOff        = f->offset;
+                nUnread         = f->size;
+                bLast           = f->flags & LSPC_CHUNK_FLAG_LAST;
+                return STATUS_OK;
+            }
+
+            // Scan the file for the next fragment
+            chunk_header_t hdr;
+            while (true)
+            {
+                // Read chunk header
+                ssize_t n   = pFile->read(nFileOff, &hdr, sizeof(chunk_header_t));
+                if (n < ssize_t(sizeof(chunk_header_t)))
+                    return STATUS_EOF;
+                nFileOff   += sizeof(chunk_header_t);
+
+                hdr.magic       = BE_TO_CPU(hdr.magic);
+                hdr.flags       = BE_TO_CPU(hdr.flags);
+                hdr.size        = BE_TO_CPU(hdr.size);
+                hdr.uid         = BE_TO_CPU(hdr.uid);
+
+                // Validate chunk header
+                if ((hdr.magic == nMagic) && (hdr.uid == nUID)) // We've found our chunk, remember unread bytes count
+                {
+                    bLast           = hdr.flags & LSPC_CHUNK_FLAG_LAST;
+                    nUnread         = hdr.size;
+                    return STATUS_OK;
+                }
+
+                // Skip this chunk
+                nFileOff       += hdr.size;
+            }
+        }
     
         ssize_t ChunkReader::read(void *buf, size_t count)
         {
             if (pFile == NULL)
                 return -set_error(STATUS_CLOSED);
 
-            chunk_header_t hdr;
-
             uint8_t *dst        = static_cast<uint8_t *>(buf);
             ssize_t total       = 0;
 
@@ -67,6 +127,7 @@ namespace lsp
                     // Update pointer
                     dst        += to_read;
                     nBufPos    += to_read;
+                    nPosition  += to_read;
                     count      -= to_read;
                     total      += to_read;
                 }
@@ -85,6 +146,7 @@ namespace lsp
                         total      += n;
                         nUnread    -= n;
                         nFileOff   += n;
+                        nPosition  += n;
                     }
                     else // Fill buffer
                     {
@@ -104,35 +166,12 @@ namespace lsp
                 }
                 else // Seek for the next valid chunk
                 {
-                    // There is no chunk after current
-                    if (bLast)
-                    {
-                        set_error(STATUS_EOF);
-                        return total;
-                    }
-
-                    // Read chunk header
-                    ssize_t n   = pFile->read(nFileOff, &hdr, sizeof(chunk_header_t));
-                    if (n < ssize_t(sizeof(chunk_header_t)))
+                    status_t res    = next_fragment();
+                    if (res != STATUS_OK)
                     {
-                        set_error(STATUS_EOF);
+                        set_error(res);
                         return total;
                     }
-                    nFileOff   += sizeof(chunk_header_t);
-
-                    hdr.magic       = BE_TO_CPU(hdr.magic);
-                    hdr.flags       = BE_TO_CPU(hdr.flags);
-                    hdr.size        = BE_TO_CPU(hdr.size);
-                    hdr.uid         = BE_TO_CPU(hdr.uid);
-
-                    // Validate chunk header
-                    if ((hdr.magic == nMagic) && (hdr.uid == nUID)) // We've found our chunk, remember unread bytes count
-                    {
-                        bLast           = hdr.flags & LSPC_CHUNK_FLAG_LAST;
-                        nUnread         = hdr.size;
-                    }
-                    else // Skip this chunk
-                        nFileOff       += hdr.size;
                 }
             }
 
@@ -195,8 +234,6 @@ namespace lsp
             if (pFile == NULL)
                 return -set_error(STATUS_CLOSED);
 
-            chunk_header_t hdr;
-
             ssize_t total       = 0;
 
             while (count > 0)
@@ -210,6 +247,7 @@ namespace lsp
 
                     // Update pointer
                     nBufPos    += to_read;
+                    nPosition  += to_read;
                     count      -= to_read;
                     total      += to_read;
                 }
@@ -221,51 +259,95 @@ namespace lsp
                         count      -= nUnread;
                         total      += nUnread;
                         nFileOff   += nUnread;
+                        nPosition  += nUnread;
                         nUnread     = 0;
                     }
                     else // Fill buffer
                     {
                         nUnread    -= count;
                         nFileOff   += count;
+                        nPosition  += count;
                         total      += count;
                         count       = 0;
                     }
                 }
                 else // Seek for the next valid chunk
                 {
-                    // There is no chunk after current
-                    if (bLast)
+                    status_t res    = next_fragment();
+                    if (res != STATUS_OK)
                     {
-                        set_error(STATUS_EOF);
+                        set_error(res);
                         return total;
                     }
+                }
+            }
 
-                    // Read chunk header
-                    ssize_t n   = pFile->read(nFileOff, &hdr, sizeof(chunk_header_t));
-                    if (n < ssize_t(sizeof(chunk_header_t)))
-                    {
-                        set_error(STATUS_EOF);
-                        return 0;
-                    }
-                    nFileOff   += sizeof(chunk_header_t);
+            return total;
+        }
 
-                    hdr.magic       = BE_TO_CPU(hdr.magic);
-                    hdr.flags       = BE_TO_CPU(hdr.flags);
-                    hdr.size        = BE_TO_CPU(hdr.size);
-                    hdr.uid         = BE_TO_CPU(hdr.uid);
+        wssize_t ChunkReader::remaining() const
+        {
+            if (pFile == NULL)
+                return -STATUS_CLOSED;
+            if (pChunk == NULL)
+                return -STATUS_NOT_SUPPORTED;
 
-                    // Validate chunk header
-                    if ((hdr.magic == nMagic) && (hdr.uid == nUID)) // We've found our chunk, remember unread bytes count
-                    {
-                        bLast           = hdr.flags & LSPC_CHUNK_FLAG_LAST;
-                        nUnread         = hdr.size;
-                    }
-                    else // Skip this chunk
-                        nFileOff       += hdr.size;
+            const chunk_fragment_t *f = &pFile->frags[pChunk->first + pChunk->count - 1];
+            wsize_t size    = f->position + f->size;
+            return (nPosition < size) ? size - nPosition : 0;
+        }
+
+        status_t ChunkReader::seek(wsize_t offset)
+        {
+            if (pFile == NULL)
+                return set_error(STATUS_CLOSED);
+
+            // Without the index the chunk can be only read forward
+            if (pChunk == NULL)
+            {
+                if (offset < nPosition)
+                    return set_error(STATUS_NOT_SUPPORTED);
+
+                while (nPosition < offset)
+                {
+                    wsize_t delta   = offset - nPosition;
+                    size_t count    = (delta > wsize_t(SIZE_MAX)) ? SIZE_MAX : size_t(delta);
+                    ssize_t n       = skip(count);
+                    if (n < 0)
+                        return status_t(-n);
+                    else if (size_t(n) < count)
+                        return set_error(STATUS_EOF);
                 }
+                return STATUS_OK;
             }
 
-            return total;
+            // Find the last fragment that starts at or before the requested offset
+            const chunk_fragment_t *list = &pFile->frags[pChunk->first];
+            size_t first = 0, last = pChunk->count - 1;
+            while (first < last)
+            {
+                size_t mid      = (first + last + 1) >> 1;
+                if (list[mid].position <= offset)
+                    first           = mid;
+                else
+                    last            = mid - 1;
+            }
+
+            const chunk_fragment_t *f = &list[first];
+            wsize_t delta   = offset - f->position;
+            if ((offset < f->position) || (delta > f->size))
+                return set_error(STATUS_EOF);
+
+            // Position to the fragment and drop the buffered data
+            nFragment       = first;
+            nFileOff        = f->offset + delta;
+            nUnread         = f->size - delta;
+            nPosition       = offset;
+            bLast           = f->flags & LSPC_CHUNK_FLAG_LAST;
+            nBufPos         = 0;
+            nBufTail        = 0;
+
+            return STATUS_OK;
         }
     }
 
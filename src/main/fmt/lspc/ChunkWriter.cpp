@@ -48,22 +48,8 @@ namespace lsp
 
             if ((nBufPos > 0) || ((flags & F_FORCE) && (nChunksOut <= 0)) || (flags & F_LAST))
             {
-                chunk_header_t hdr;
-                hdr.magic       = nMagic;
-                hdr.size        = nBufPos;
-                hdr.flags       = (flags & F_LAST) ? LSPC_CHUNK_FLAG_LAST : 0;
-                hdr.uid         = nUID;
-
-                // Convert CPU -> BE
-                hdr.magic       = CPU_TO_BE(hdr.magic);
-                hdr.size        = CPU_TO_BE(hdr.size);
-                hdr.flags       = CPU_TO_BE(hdr.flags);
-                hdr.uid         = CPU_TO_BE(hdr.uid);
-
                 // Write buffer header and data to file
-                status_t res    = pFile->write(&hdr, sizeof(chunk_header_t));
-                if (res == STATUS_OK)
-                    pFile->write(pBuffer, nBufPos);
+                status_t res    = pFile->write_fragment(nMagic, nUID, (flags & F_LAST) ? LSPC_CHUNK_FLAG_LAST : 0, pBuffer, nBufPos);
                 if (set_error(res) != STATUS_OK)
                     return res;
 
@@ -80,7 +66,6 @@ namespace lsp
             if (pFile == NULL)
                 return set_error(STATUS_CLOSED);
 
-            chunk_header_t hdr;
             const uint8_t *src = static_cast<const uint8_t *>(buf);
 
             while (count > 0)
@@ -101,21 +86,8 @@ namespace lsp
                     // Check buffer size
                     if (nBufPos >= nBufSize)
                     {
-                        hdr.magic       = nMagic;
-                        hdr.size        = nBufSize;
-                        hdr.flags       = 0;
-                        hdr.uid         = nUID;
-
-                        // Convert CPU -> BE
-                        hdr.magic       = CPU_TO_BE(hdr.magic);
-                        hdr.size        = CPU_TO_BE(hdr.size);
-                        hdr.flags       = CPU_TO_BE(hdr.flags);
-                        hdr.uid         = CPU_TO_BE(hdr.uid);
-
                         // Write buffer header and data to file
-                        status_t res    = pFile->write(&hdr, sizeof(chunk_header_t));
-                        if (res == STATUS_OK)
-                            res             = pFile->write(pBuffer, nBufSize);
+                        status_t res    = pFile->write_fragment(nMagic, nUID, 0, pBuffer, nBufSize);
                         if (set_error(res) != STATUS_OK)
                             return res;
 
@@ -126,21 +98,8 @@ namespace lsp
                 }
                 else // Write directly avoiding buffer
                 {
-                    hdr.magic       = nMagic;
-                    hdr.size        = can_write;
-                    hdr.flags       = 0;
-                    hdr.uid         = nUID;
-
-                    // Convert CPU -> BE
-                    hdr.magic       = CPU_TO_BE(hdr.magic);
-                    hdr.size        = CPU_TO_BE(hdr.size);
-                    hdr.flags       = CPU_TO_BE(hdr.flags);
-                    hdr.uid         = CPU_TO_BE(hdr.uid);
-
                     // Write buffer header and data to file
-                    status_t res    = pFile->write(&hdr, sizeof(chunk_header_t));
-                    if (res == STATUS_OK)
-                        pFile->write(src, can_write);
+                    status_t res    = pFile->write_fragment(nMagic, nUID, 0, src, can_write);
                     if (set_error(res) != STATUS_OK)
                         return res;
 
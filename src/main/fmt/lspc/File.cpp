@@ -35,6 +35,7 @@ namespace lsp
         {
             pFile       = NULL;
             bWrite      = false;
+            bEmitIndex  = false;
             nHdrSize    = 0;
         }
 
@@ -54,6 +55,11 @@ namespace lsp
             res->bufsize    = 0x10000;
             res->chunk_id   = 0;
             res->length     = 0;
+            res->frags      = NULL;
+            res->nfrags     = 0;
+            res->capfrags   = 0;
+            res->chunks     = NULL;
+            res->nchunks    = 0;
 
             return res;
         }
@@ -107,6 +113,10 @@ namespace lsp
                 CloseHandle(fd);
                 return STATUS_NO_MEM;
             }
+
+            LARGE_INTEGER fsize;
+            if (GetFileSizeEx(fd, &fsize))
+                res->length     = fsize.QuadPart;
     #else
             fhandle_t fd        = ::open(path->get_utf8(), O_RDONLY);
             if (fd < 0)
@@ -118,6 +128,10 @@ namespace lsp
                 ::close(fd);
                 return STATUS_NO_MEM;
             }
+
+            struct stat st;
+            if (::fstat(fd, &st) == 0)
+                res->length     = st.st_size;
     #endif /* PLATFORM_WINDOWS */
 
             ssize_t bytes = res->read(0, &hdr, sizeof(root_header_t));
@@ -128,7 +142,6 @@ namespace lsp
                 (BE_TO_CPU(hdr.version) != 1))
             {
                 res->release();
-                delete res;
                 return STATUS_BAD_FORMAT;
             }
 
@@ -213,7 +226,6 @@ namespace lsp
             if (io_res != STATUS_OK)
             {
                 res->release();
-                delete res;
                 return io_res;
             }
 
@@ -228,35 +240,191 @@ namespace lsp
         {
             if (pFile == NULL)
                 return STATUS_BAD_STATE;
-            status_t res = pFile->release();
-            if (pFile->refs <= 0)
-                delete pFile;
+
+            status_t res = ((bWrite) && (bEmitIndex)) ? write_index() : STATUS_OK;
+            status_t xres = pFile->release();
+            if (res == STATUS_OK)
+                res     = xres;
             pFile   = NULL;
             return res;
         }
 
-        ChunkWriter *File::write_chunk(uint32_t magic)
+        status_t File::write_index()
         {
-            if ((pFile == NULL) || (!bWrite))
-                return NULL;
+            // The index chunk does not describe itself
+            size_t count        = pFile->nfrags;
+            if (wsize_t(count) > wsize_t(0xffffffffU))
+                return STATUS_OVERFLOW;
 
-            ChunkWriter *wr = new ChunkWriter(pFile, magic);
-            return wr;
+            ChunkWriter *wr     = write_chunk(LSPC_CHUNK_INDEX);
+            if (wr == NULL)
+                return STATUS_NO_MEM;
+            uint32_t uid        = wr->unique_id();
+            status_t res        = wr->last_error();
+
+            // Write the header
+            chunk_index_header_t hdr;
+            ::bzero(&hdr, sizeof(hdr));
+            hdr.common.version  = 0;
+            hdr.common.size     = sizeof(hdr);
+            hdr.fragments       = CPU_TO_BE(uint32_t(count));
+            if (res == STATUS_OK)
+                res                 = wr->write_header(&hdr);
+
+            // Write the entries, the list of fragments may be reallocated while writing
+            for (size_t i=0; (i<count) && (res == STATUS_OK); ++i)
+            {
+                const chunk_fragment_t *f = &pFile->frags[i];
+                chunk_index_entry_t e;
+                e.magic             = CPU_TO_BE(f->magic);
+                e.uid               = CPU_TO_BE(f->uid);
+                e.flags             = CPU_TO_BE(f->flags);
+                e.size              = CPU_TO_BE(f->size);
+                e.offset            = CPU_TO_BE(uint64_t(f->offset - sizeof(chunk_header_t)));
+
+                res                 = wr->write(&e, sizeof(e));
+            }
+
+            // Flush the data to obtain the position of the index chunk
+            if (res == STATUS_OK)
+                res                 = wr->flush();
+            if (res == STATUS_OK)
+            {
+                chunk_index_footer_t ftr;
+                ftr.magic           = CPU_TO_BE(uint32_t(LSPC_CHUNK_INDEX));
+                ftr.reserved        = 0;
+                ftr.offset          = 0;
+
+                for (size_t i=count; i<pFile->nfrags; ++i)
+                    if (pFile->frags[i].uid == uid)
+                    {
+                        ftr.offset          = CPU_TO_BE(uint64_t(pFile->frags[i].offset - sizeof(chunk_header_t)));
+                        break;
+                    }
+
+                // The footer is the last fragment of the chunk and the last bytes of the file
+                res                 = wr->write(&ftr, sizeof(ftr));
+            }
+
+            status_t xres       = wr->close();
+            delete wr;
+
+            return (res == STATUS_OK) ? xres : res;
         }
 
-        ChunkReader *File::read_chunk(uint32_t uid)
+        status_t File::load_index()
         {
-            if ((pFile == NULL) || (bWrite))
-                return NULL;
+            if (pFile->chunks != NULL)
+                return STATUS_OK;
 
-            // Find the initial position of the chunk in file
+            // Try to load the index chunk, scan the whole file if it is not present
+            pFile->nfrags       = 0;
+            status_t res        = read_index();
+            if (res != STATUS_OK)
+            {
+                pFile->nfrags       = 0;
+                res                 = scan_chunks();
+            }
+
+            return (res == STATUS_OK) ? pFile->build_index() : res;
+        }
+
+        status_t File::read_index()
+        {
+            // Read the footer of the index chunk
+            chunk_index_footer_t ftr;
+            wsize_t length      = pFile->length;
+            if (length < nHdrSize + sizeof(chunk_header_t) + sizeof(chunk_index_header_t) + sizeof(ftr))
+                return STATUS_NOT_FOUND;
+            if (pFile->read(length - sizeof(ftr), &ftr, sizeof(ftr)) != ssize_t(sizeof(ftr)))
+                return STATUS_NOT_FOUND;
+
+            ftr.magic           = BE_TO_CPU(ftr.magic);
+            ftr.offset          = BE_TO_CPU(ftr.offset);
+            if ((ftr.magic != LSPC_CHUNK_INDEX) || (ftr.offset < nHdrSize) || (ftr.offset >= length))
+                return STATUS_NOT_FOUND;
+
+            // Read the header of the index chunk
+            chunk_header_t hdr;
+            if (pFile->read(ftr.offset, &hdr, sizeof(chunk_header_t)) != ssize_t(sizeof(chunk_header_t)))
+                return STATUS_NOT_FOUND;
+            hdr.magic           = BE_TO_CPU(hdr.magic);
+            hdr.uid             = BE_TO_CPU(hdr.uid);
+            hdr.flags           = BE_TO_CPU(hdr.flags);
+            hdr.size            = BE_TO_CPU(hdr.size);
+            if (hdr.magic != LSPC_CHUNK_INDEX)
+                return STATUS_NOT_FOUND;
+
+            // Read the contents of the index chunk
+            ChunkReader *rd     = new ChunkReader(pFile, hdr.magic, hdr.uid);
+            if (rd == NULL)
+                return STATUS_NO_MEM;
+            status_t res        = rd->last_error();
+            if (res == STATUS_OK)
+            {
+                rd->nFileOff        = ftr.offset + sizeof(chunk_header_t);
+                rd->nUnread         = hdr.size;
+                rd->bLast           = hdr.flags & LSPC_CHUNK_FLAG_LAST;
+                res                 = read_index_entries(rd, ftr.offset);
+            }
+
+            rd->close();
+            delete rd;
+
+            return res;
+        }
+
+        status_t File::read_index_entries(ChunkReader *rd, wsize_t offset)
+        {
+            chunk_index_header_t hdr;
+            ssize_t n           = rd->read_header(&hdr, sizeof(hdr));
+            if (n < 0)
+                return status_t(-n);
+
+            // All fragments should be located before the index chunk
+            wsize_t count       = BE_TO_CPU(hdr.fragments);
+            if (count * sizeof(chunk_index_entry_t) > offset)
+                return STATUS_CORRUPTED_FILE;
+
+            chunk_index_entry_t e;
+            for (wsize_t i=0; i<count; ++i)
+            {
+                if (rd->read(&e, sizeof(e)) != ssize_t(sizeof(e)))
+                    return STATUS_CORRUPTED_FILE;
+
+                e.magic             = BE_TO_CPU(e.magic);
+                e.uid               = BE_TO_CPU(e.uid);
+                e.flags             = BE_TO_CPU(e.flags);
+                e.size              = BE_TO_CPU(e.size);
+                e.offset            = BE_TO_CPU(e.offset);
+
+                if ((e.offset < nHdrSize) || ((e.offset + sizeof(chunk_header_t) + e.size) > offset))
+                    return STATUS_CORRUPTED_FILE;
+
+                status_t res        = pFile->add_fragment(e.magic, e.uid, e.flags, e.size, e.offset + sizeof(chunk_header_t));
+                if (res != STATUS_OK)
+                    return res;
+            }
+
+            // Validate the footer
+            chunk_index_footer_t ftr;
+            if (rd->read(&ftr, sizeof(ftr)) != ssize_t(sizeof(ftr)))
+                return STATUS_CORRUPTED_FILE;
+            if ((BE_TO_CPU(ftr.magic) != LSPC_CHUNK_INDEX) || (BE_TO_CPU(ftr.offset) != offset))
+                return STATUS_CORRUPTED_FILE;
+
+            return STATUS_OK;
+        }
+
+        status_t File::scan_chunks()
+        {
             chunk_header_t hdr;
             wsize_t pos         = nHdrSize;
             while (true)
             {
                 ssize_t res = pFile->read(pos, &hdr, sizeof(chunk_header_t));
                 if (res != sizeof(chunk_header_t))
-                    return NULL;
+                    break;
                 pos        += sizeof(chunk_header_t);
 
                 hdr.magic   = BE_TO_CPU(hdr.magic);
@@ -264,53 +432,70 @@ namespace lsp
                 hdr.flags   = BE_TO_CPU(hdr.flags);
                 hdr.size    = BE_TO_CPU(hdr.size);
 
-    //            lsp_trace("chunk header uid=%x, magic=%x, flags=%x, search_uid=%x, size=%llx",
-    //                    int(hdr.uid), int(hdr.magic), int(hdr.flags), int(uid), (long long)(hdr.size));
-                if (hdr.uid == uid)
-                    break;
+                // The index chunks are not indexed
+                if (hdr.magic != LSPC_CHUNK_INDEX)
+                {
+                    status_t xres = pFile->add_fragment(hdr.magic, hdr.uid, hdr.flags, hdr.size, pos);
+                    if (xres != STATUS_OK)
+                        return xres;
+                }
                 pos        += hdr.size;
             }
 
-            // Create reader
-            ChunkReader *rd = new ChunkReader(pFile, hdr.magic, uid);
+            return STATUS_OK;
+        }
+
+        ChunkReader *File::open_chunk(const chunk_info_t *chunk)
+        {
+            ChunkReader *rd = new ChunkReader(pFile, chunk->magic, chunk->uid);
             if (rd == NULL)
                 return NULL;
-            rd->nFileOff        = pos;
-            rd->nUnread         = hdr.size;
+            rd->set_chunk(chunk);
             return rd;
         }
 
-        ChunkReader *File::read_chunk(uint32_t uid, uint32_t magic)
+        ChunkWriter *File::write_chunk(uint32_t magic)
+        {
+            if ((pFile == NULL) || (!bWrite))
+                return NULL;
+
+            ChunkWriter *wr = new ChunkWriter(pFile, magic);
+            return wr;
+        }
+
+        ChunkReader *File::read_chunk(uint32_t uid)
         {
             if ((pFile == NULL) || (bWrite))
                 return NULL;
 
-            // Find the initial position of the chunk in file
-            chunk_header_t hdr;
-            wsize_t pos         = nHdrSize;
-            while (true)
+            ChunkReader *rd = NULL;
+            sMutex.lock();
+            if (load_index() == STATUS_OK)
             {
-                ssize_t res = pFile->read(pos, &hdr, sizeof(chunk_header_t));
-                if (res != sizeof(chunk_header_t))
-                    return NULL;
-                pos        += sizeof(chunk_header_t);
+                const chunk_info_t *chunk = pFile->find(uid);
+                if (chunk != NULL)
+                    rd              = open_chunk(chunk);
+            }
+            sMutex.unlock();
 
-                hdr.magic   = BE_TO_CPU(hdr.magic);
-                hdr.uid     = BE_TO_CPU(hdr.uid);
-                hdr.flags   = BE_TO_CPU(hdr.flags);
-                hdr.size    = BE_TO_CPU(hdr.size);
+            return rd;
+        }
 
-                if ((hdr.uid == uid) && (hdr.magic == magic))
-                    break;
-                pos        += hdr.size;
+        ChunkReader *File::read_chunk(uint32_t uid, uint32_t magic)
+        {
+            if ((pFile == NULL) || (bWrite))
+                return NULL;
+
+            ChunkReader *rd = NULL;
+            sMutex.lock();
+            if (load_index() == STATUS_OK)
+            {
+                const chunk_info_t *chunk = pFile->find(uid);
+                if ((chunk != NULL) && (chunk->magic == magic))
+                    rd              = open_chunk(chunk);
             }
+            sMutex.unlock();
 
-            // Create reader
-            ChunkReader *rd = new ChunkReader(pFile, hdr.magic, uid);
-            if (rd == NULL)
-                return NULL;
-            rd->nFileOff        = pos;
-            rd->nUnread         = hdr.size;
             return rd;
         }
 
@@ -319,34 +504,35 @@ namespace lsp
             if ((pFile == NULL) || (bWrite))
                 return NULL;
 
-            // Find the initial position of the chunk in file
-            chunk_header_t hdr;
-            wsize_t pos         = nHdrSize;
-            while (true)
+            ChunkReader *rd = NULL;
+            sMutex.lock();
+            if (load_index() == STATUS_OK)
             {
-                ssize_t res = pFile->read(pos, &hdr, sizeof(chunk_header_t));
-                if (res != sizeof(chunk_header_t))
-                    return NULL;
-                pos        += sizeof(chunk_header_t);
-
-                hdr.magic   = BE_TO_CPU(hdr.magic);
-                hdr.uid     = BE_TO_CPU(hdr.uid);
-                hdr.flags   = BE_TO_CPU(hdr.flags);
-                hdr.size    = BE_TO_CPU(hdr.size);
-
-                if ((hdr.uid >= start_id) && (hdr.magic == magic))
-                    break;
-                pos        += hdr.size;
+                // Find the chunk which starts first in the file
+                const chunk_info_t *found = NULL;
+                wsize_t offset      = 0;
+                for (size_t i=0; i<pFile->nchunks; ++i)
+                {
+                    const chunk_info_t *c = &pFile->chunks[i];
+                    if ((c->uid < start_id) || (c->magic != magic))
+                        continue;
+
+                    wsize_t coff        = pFile->frags[c->first].offset;
+                    if ((found == NULL) || (coff < offset))
+                    {
+                        found               = c;
+                        offset              = coff;
+                    }
+                }
+
+                // Create reader
+                if (found != NULL)
+                    rd                  = open_chunk(found);
             }
+            sMutex.unlock();
 
-            // Create reader
-            ChunkReader *rd = new ChunkReader(pFile, hdr.magic, hdr.uid);
-            if (rd == NULL)
-                return NULL;
-            if (id != NULL)
+            if ((rd != NULL) && (id != NULL))
                 *id                 = rd->unique_id();
-            rd->nFileOff        = pos;
-            rd->nUnread         = hdr.size;
             return rd;
         }
     }
@@ -0,0 +1,698 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 3 апр. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <lsp-plug.in/common/bits.h>
+#include <lsp-plug.in/common/endian.h>
+#include <lsp-plug.in/fmt/lspc/lspc.h>
+#include <private/fmt/lspc/lossless.h>
+
+#include <math.h>
+
+namespace lsp
+{
+    namespace lspc
+    {
+        namespace lossless
+        {
+            static const size_t PARTITION       = 0x100;    // Number of samples per partition of the Rice code
+            static const size_t RICE_BITS       = 5;        // Number of bits of the Rice parameter
+            static const size_t RICE_MAX        = 31;       // Maximum value of the Rice parameter
+            static const size_t ESCAPE          = 31;       // Length of the unary prefix that escapes the raw value
+            static const size_t ORDER_BITS      = 6;        // Number of bits of the predictor order
+            static const size_t ORDER_RAW       = 0x3f;     // Order code of the channel stored without prediction
+            static const size_t SHIFT_BITS      = 5;        // Number of bits of the coefficient shift
+            static const size_t COEFF_BITS      = 16;       // Number of bits of the quantized coefficient
+            static const int32_t COEFF_MAX      = 0x7fff;   // Maximum value of the quantized coefficient
+
+            // Predictor orders that are tried by the encoder
+            static const size_t orders[]        = { 1, 2, 4, 8, 16 };
+
+            //-----------------------------------------------------------------
+            // Bit I/O, bits are stored starting with the most significant one
+            typedef struct bit_writer_t
+            {
+                uint8_t        *p;              // Current write position
+                uint64_t        acc;            // Bit accumulator
+                size_t          bits;           // Number of pending bits in the accumulator
+            } bit_writer_t;
+
+            typedef struct bit_reader_t
+            {
+                const uint8_t  *p;              // Current read position
+                const uint8_t  *end;            // End of data
+                uint64_t        acc;            // Bit cache aligned to the most significant bit
+                size_t          bits;           // Number of bits in the cache
+            } bit_reader_t;
+
+            static inline void put_bits(bit_writer_t *bw, uint32_t value, size_t bits)
+            {
+                bw->acc         = (bw->acc << bits) | (value & ((uint64_t(1) << bits) - 1));
+                bw->bits       += bits;
+                while (bw->bits >= 8)
+                {
+                    bw->bits       -= 8;
+                    *(bw->p++)      = uint8_t(bw->acc >> bw->bits);
+                }
+            }
+
+            static inline void flush_bits(bit_writer_t *bw)
+            {
+                if (bw->bits > 0)
+                    *(bw->p++)      = uint8_t(bw->acc << (8 - bw->bits));
+                bw->bits        = 0;
+            }
+
+            static inline void put_rice(bit_writer_t *bw, uint32_t value, size_t k)
+            {
+                uint32_t q      = value >> k;
+                if (q < ESCAPE)
+                {
+                    put_bits(bw, 1, q + 1);
+                    put_bits(bw, value, k);
+                }
+                else
+                {
+                    put_bits(bw, 1, ESCAPE + 1);
+                    put_bits(bw, value, 32);
+                }
+            }
+
+            static inline void refill(bit_reader_t *br)
+            {
+                while ((br->bits <= 56) && (br->p < br->end))
+                {
+                    br->acc        |= uint64_t(*(br->p++)) << (56 - br->bits);
+                    br->bits       += 8;
+                }
+            }
+
+            static inline void consume(bit_reader_t *br, size_t bits)
+            {
+                br->acc         = (bits < 64) ? br->acc << bits : 0;
+                br->bits       -= bits;
+            }
+
+            static inline bool get_bits(bit_reader_t *br, uint32_t *value, size_t bits)
+            {
+                if (br->bits < bits)
+                {
+                    refill(br);
+                    if (br->bits < bits)
+                        return false;
+                }
+
+                *value          = (bits > 0) ? uint32_t(br->acc >> (64 - bits)) : 0;
+                consume(br, bits);
+                return true;
+            }
+
+            static inline bool get_rice(bit_reader_t *br, uint32_t *value, size_t k)
+            {
+                // Count leading zeros of the unary prefix
+                size_t q        = 0;
+                while (true)
+                {
+                    if (br->bits < 32)
+                        refill(br);
+                    if (br->acc != 0)
+                    {
+                        size_t zeros    = 63 - int_log2(br->acc);
+                        if (zeros >= br->bits)
+                            return false;
+                        q              += zeros;
+                        consume(br, zeros + 1);
+                        break;
+                    }
+                    else if (br->bits <= 0)
+                        return false;
+
+                    q              += br->bits;
+                    consume(br, br->bits);
+                    if (q > ESCAPE)
+                        return false;
+                }
+
+                if (q > ESCAPE)
+                    return false;
+                else if (q == ESCAPE)
+                    return get_bits(br, value, 32);
+
+                uint32_t low;
+                if (!get_bits(br, &low, k))
+                    return false;
+                *value          = (uint32_t(q) << k) | low;
+                return true;
+            }
+
+            //-----------------------------------------------------------------
+            // Sample conversion
+            static size_t sample_bits(size_t sample_format)
+            {
+                switch (sample_format)
+                {
+                    case LSPC_SAMPLE_FMT_U8LE:
+                    case LSPC_SAMPLE_FMT_U8BE:
+                    case LSPC_SAMPLE_FMT_S8LE:
+                    case LSPC_SAMPLE_FMT_S8BE:
+                        return 8;
+                    case LSPC_SAMPLE_FMT_U16LE:
+                    case LSPC_SAMPLE_FMT_U16BE:
+                    case LSPC_SAMPLE_FMT_S16LE:
+                    case LSPC_SAMPLE_FMT_S16BE:
+                        return 16;
+                    case LSPC_SAMPLE_FMT_U24LE:
+                    case LSPC_SAMPLE_FMT_U24BE:
+                    case LSPC_SAMPLE_FMT_S24LE:
+                    case LSPC_SAMPLE_FMT_S24BE:
+                        return 24;
+                    case LSPC_SAMPLE_FMT_U32LE:
+                    case LSPC_SAMPLE_FMT_U32BE:
+                    case LSPC_SAMPLE_FMT_S32LE:
+                    case LSPC_SAMPLE_FMT_S32BE:
+                    case LSPC_SAMPLE_FMT_F32LE:
+                    case LSPC_SAMPLE_FMT_F32BE:
+                        return 32;
+                    default:
+                        break;
+                }
+                return 0;
+            }
+
+            template <class U, class S, U X>
+                static void load_int(int32_t *dst, const void *src, size_t channel, size_t channels, size_t frames)
+                {
+                    const U *p = static_cast<const U *>(src) + channel;
+                    for (size_t i=0; i<frames; ++i, p += channels)
+                        dst[i]      = S(*p ^ X);
+                }
+
+            template <class U, U X>
+                static void store_int(void *dst, const int32_t *src, size_t channel, size_t channels, size_t frames)
+                {
+                    U *p = static_cast<U *>(dst) + channel;
+                    for (size_t i=0; i<frames; ++i, p += channels)
+                        *p          = U(src[i]) ^ X;
+                }
+
+            template <bool LE, uint32_t X>
+                static void load_int24(int32_t *dst, const void *src, size_t channel, size_t channels, size_t frames)
+                {
+                    const uint8_t *p = static_cast<const uint8_t *>(src) + channel * 3;
+                    for (size_t i=0; i<frames; ++i, p += channels * 3)
+                    {
+                        uint32_t v  = (LE) ?
+                            p[0] | (p[1] << 8) | (p[2] << 16) :
+                            p[2] | (p[1] << 8) | (p[0] << 16);
+                        dst[i]      = int32_t((v ^ X) << 8) >> 8;
+                    }
+                }
+
+            template <bool LE, uint32_t X>
+                static void store_int24(void *dst, const int32_t *src, size_t channel, size_t channels, size_t frames)
+                {
+                    uint8_t *p = static_cast<uint8_t *>(dst) + channel * 3;
+                    for (size_t i=0; i<frames; ++i, p += channels * 3)
+                    {
+                        uint32_t v  = (uint32_t(src[i]) ^ X) & 0xffffff;
+                        p[(LE) ? 0 : 2] = uint8_t(v);
+                        p[1]            = uint8_t(v >> 8);
+                        p[(LE) ? 2 : 0] = uint8_t(v >> 16);
+                    }
+                }
+
+            static void load_samples(int32_t *dst, const void *src, size_t channel, size_t channels, size_t sample_format, size_t frames)
+            {
+                switch (sample_format)
+                {
+                    case LSPC_SAMPLE_FMT_U8LE:
+                    case LSPC_SAMPLE_FMT_U8BE:
+                        load_int<uint8_t, int8_t, 0x80>(dst, src, channel, channels, frames);
+                        break;
+                    case LSPC_SAMPLE_FMT_S8LE:
+                    case LSPC_SAMPLE_FMT_S8BE:
+                        load_int<uint8_t, int8_t, 0>(dst, src, channel, channels, frames);
+                        break;
+                    case LSPC_SAMPLE_FMT_U16LE:
+                    case LSPC_SAMPLE_FMT_U16BE:
+                        load_int<uint16_t, int16_t, 0x8000>(dst, src, channel, channels, frames);
+                        break;
+                    case LSPC_SAMPLE_FMT_S16LE:
+                    case LSPC_SAMPLE_FMT_S16BE:
+                        load_int<uint16_t, int16_t, 0>(dst, src, channel, channels, frames);
+                        break;
+                    case LSPC_SAMPLE_FMT_U24LE:
+                        load_int24<true, 0x800000>(dst, src, channel, channels, frames);
+                        break;
+                    case LSPC_SAMPLE_FMT_U24BE:
+                        load_int24<false, 0x800000>(dst, src, channel, channels, frames);
+                        break;
+                    case LSPC_SAMPLE_FMT_S24LE:
+                        load_int24<true, 0>(dst, src, channel, channels, frames);
+                        break;
+                    case LSPC_SAMPLE_FMT_S24BE:
+                        load_int24<false, 0>(dst, src, channel, channels, frames);
+                        break;
+                    case LSPC_SAMPLE_FMT_U32LE:
+                    case LSPC_SAMPLE_FMT_U32BE:
+                        load_int<uint32_t, int32_t, 0x80000000U>(dst, src, channel, channels, frames);
+                        break;
+                    default:
+                        load_int<uint32_t, int32_t, 0>(dst, src, channel, channels, frames);
+                        break;
+                }
+            }
+
+            static void store_samples(void *dst, const int32_t *src, size_t channel, size_t channels, size_t sample_format, size_t frames)
+            {
+                switch (sample_format)
+                {
+                    case LSPC_SAMPLE_FMT_U8LE:
+                    case LSPC_SAMPLE_FMT_U8BE:
+                        store_int<uint8_t, 0x80>(dst, src, channel, channels, frames);
+                        break;
+                    case LSPC_SAMPLE_FMT_S8LE:
+                    case LSPC_SAMPLE_FMT_S8BE:
+                        store_int<uint8_t, 0>(dst, src, channel, channels, frames);
+                        break;
+                    case LSPC_SAMPLE_FMT_U16LE:
+                    case LSPC_SAMPLE_FMT_U16BE:
+                        store_int<uint16_t, 0x8000>(dst, src, channel, channels, frames);
+                        break;
+                    case LSPC_SAMPLE_FMT_S16LE:
+                    case LSPC_SAMPLE_FMT_S16BE:
+                        store_int<uint16_t, 0>(dst, src, channel, channels, frames);
+                        break;
+                    case LSPC_SAMPLE_FMT_U24LE:
+                        store_int24<true, 0x800000>(dst, src, channel, channels, frames);
+                        break;
+                    case LSPC_SAMPLE_FMT_U24BE:
+                        store_int24<false, 0x800000>(dst, src, channel, channels, frames);
+                        break;
+                    case LSPC_SAMPLE_FMT_S24LE:
+                        store_int24<true, 0>(dst, src, channel, channels, frames);
+                        break;
+                    case LSPC_SAMPLE_FMT_S24BE:
+                        store_int24<false, 0>(dst, src, channel, channels, frames);
+                        break;
+                    case LSPC_SAMPLE_FMT_U32LE:
+                    case LSPC_SAMPLE_FMT_U32BE:
+                        store_int<uint32_t, 0x80000000U>(dst, src, channel, channels, frames);
+                        break;
+                    default:
+                        store_int<uint32_t, 0>(dst, src, channel, channels, frames);
+                        break;
+                }
+            }
+
+            //-----------------------------------------------------------------
+            // Prediction
+            static inline uint32_t predict(const int32_t *x, const int32_t *c, size_t order, size_t shift)
+            {
+                int64_t acc     = 0;
+                for (size_t j=0; j<order; ++j)
+                    acc            += int64_t(c[j]) * x[j];
+                return uint32_t(acc >> shift);
+            }
+
+            static inline uint32_t zigzag(uint32_t v)
+            {
+                return (v << 1) ^ uint32_t(int32_t(v) >> 31);
+            }
+
+            static inline uint32_t unzigzag(uint32_t v)
+            {
+                return (v >> 1) ^ (-(v & 1));
+            }
+
+            /**
+             * Compute coefficients of the linear predictor for all orders up to max_order
+             * with the Levinson-Durbin recursion, coefficients of the order i are stored
+             * at the row (i-1) of the lpc matrix
+             * @return maximum order for which the coefficients have been computed
+             */
+            static size_t compute_lpc(double lpc[][MAX_ORDER], const int32_t *x, size_t frames, size_t max_order)
+            {
+                double r[MAX_ORDER + 1];
+                for (size_t l=0; l<=max_order; ++l)
+                {
+                    double acc      = 0.0;
+                    for (size_t i=l; i<frames; ++i)
+                        acc            += double(x[i]) * double(x[i-l]);
+                    r[l]            = acc;
+                }
+
+                double err      = r[0];
+                double a[MAX_ORDER];
+                for (size_t i=0; i<max_order; ++i)
+                {
+                    if (err <= 0.0)
+                        return i;
+
+                    double acc      = r[i+1];
+                    for (size_t j=0; j<i; ++j)
+                        acc            -= a[j] * r[i-j];
+                    double k        = acc / err;
+
+                    for (size_t j=0; j<(i >> 1); ++j)
+                    {
+                        double t        = a[j];
+                        a[j]           -= k * a[i-1-j];
+                        a[i-1-j]       -= k * t;
+                    }
+                    if (i & 1)
+                        a[i >> 1]      -= k * a[i >> 1];
+                    a[i]            = k;
+                    err            *= 1.0 - k * k;
+
+                    for (size_t j=0; j<=i; ++j)
+                        lpc[i][j]       = a[j];
+                }
+
+                return max_order;
+            }
+
+            /**
+             * Quantize coefficients of the predictor, coefficients are stored in the reverse
+             * order to compute the prediction as the dot product with the history of samples
+             * @return true on success
+             */
+            static bool quantize_lpc(int32_t *dst, size_t *shift, const double *lpc, size_t order)
+            {
+                double cmax     = 0.0;
+                for (size_t j=0; j<order; ++j)
+                    cmax            = lsp_max(cmax, fabs(lpc[j]));
+                if ((cmax <= 0.0) || (cmax >= COEFF_MAX))
+                    return false;
+
+                size_t s        = 0;
+                while ((s < ((1 << SHIFT_BITS) - 1)) && ((cmax * double(uint32_t(2) << s)) <= COEFF_MAX))
+                    ++s;
+
+                // Quantize with error feedback
+                double scale    = double(uint32_t(1) << s);
+                double e        = 0.0;
+                for (size_t j=0; j<order; ++j)
+                {
+                    double v        = lpc[j] * scale + e;
+                    double q        = floor(v + 0.5);
+                    q               = lsp_limit(q, double(-COEFF_MAX - 1), double(COEFF_MAX));
+                    e               = v - q;
+                    dst[order - 1 - j]  = int32_t(q);
+                }
+
+                *shift          = s;
+                return true;
+            }
+
+            static void compute_residual(uint32_t *dst, const int32_t *x, size_t frames, const int32_t *c, size_t order, size_t shift)
+            {
+                if (order <= 0)
+                {
+                    for (size_t i=0; i<frames; ++i)
+                        dst[i]          = zigzag(x[i]);
+                    return;
+                }
+
+                for (size_t i=0; i<frames; ++i)
+                    dst[i]          = zigzag(uint32_t(x[i]) - predict(&x[i - order], c, order, shift));
+            }
+
+            static inline size_t rice_param(uint64_t sum, size_t count)
+            {
+                size_t k        = 0;
+                while ((k < RICE_MAX) && ((uint64_t(count) << (k + 1)) < sum))
+                    ++k;
+                return k;
+            }
+
+            static size_t residual_cost(const uint32_t *r, size_t frames)
+            {
+                size_t bits     = 0;
+                for (size_t off=0; off<frames; off += PARTITION)
+                {
+                    size_t count    = lsp_min(frames - off, PARTITION);
+                    const uint32_t *p = &r[off];
+
+                    uint64_t sum    = 0;
+                    for (size_t i=0; i<count; ++i)
+                        sum            += p[i];
+                    size_t k        = rice_param(sum, count);
+
+                    bits           += RICE_BITS;
+                    for (size_t i=0; i<count; ++i)
+                    {
+                        uint32_t q      = p[i] >> k;
+                        bits           += (q < ESCAPE) ? q + 1 + k : ESCAPE + 1 + 32;
+                    }
+                }
+                return bits;
+            }
+
+            static void write_residual(bit_writer_t *bw, const uint32_t *r, size_t frames)
+            {
+                for (size_t off=0; off<frames; off += PARTITION)
+                {
+                    size_t count    = lsp_min(frames - off, PARTITION);
+                    const uint32_t *p = &r[off];
+
+                    uint64_t sum    = 0;
+                    for (size_t i=0; i<count; ++i)
+                        sum            += p[i];
+                    size_t k        = rice_param(sum, count);
+
+                    put_bits(bw, k, RICE_BITS);
+                    for (size_t i=0; i<count; ++i)
+                        put_rice(bw, p[i], k);
+                }
+            }
+
+            static void encode_channel(bit_writer_t *bw, int32_t *x, size_t frames, size_t bits, int32_t *work)
+            {
+                uint32_t *res       = reinterpret_cast<uint32_t *>(work);
+                uint32_t *best      = &res[frames];
+                int32_t c[MAX_ORDER], bc[MAX_ORDER];
+                double lpc[MAX_ORDER][MAX_ORDER];
+
+                // Storing the samples as is
+                size_t b_cost       = frames * bits;
+                size_t b_order      = ORDER_RAW;
+                size_t b_shift      = 0;
+
+                // Prediction of order 0
+                compute_residual(res, x, frames, NULL, 0, 0);
+                size_t cost         = residual_cost(res, frames);
+                if (cost < b_cost)
+                {
+                    b_cost              = cost;
+                    b_order             = 0;
+                    lsp::swap(res, best);
+                }
+
+                // Linear prediction
+                size_t max_order    = compute_lpc(lpc, x, frames, MAX_ORDER);
+                for (size_t i=0; i<sizeof(orders)/sizeof(size_t); ++i)
+                {
+                    size_t order        = orders[i];
+                    size_t shift        = 0;
+                    if (order > max_order)
+                        break;
+                    if (!quantize_lpc(c, &shift, lpc[order-1], order))
+                        continue;
+
+                    compute_residual(res, x, frames, c, order, shift);
+                    cost                = SHIFT_BITS + order * COEFF_BITS + residual_cost(res, frames);
+                    if (cost < b_cost)
+                    {
+                        b_cost              = cost;
+                        b_order             = order;
+                        b_shift             = shift;
+                        for (size_t j=0; j<order; ++j)
+                            bc[j]               = c[j];
+                        lsp::swap(res, best);
+                    }
+                }
+
+                // Emit the data
+                put_bits(bw, b_order, ORDER_BITS);
+                if (b_order == ORDER_RAW)
+                {
+                    for (size_t i=0; i<frames; ++i)
+                        put_bits(bw, x[i], bits);
+                    return;
+                }
+
+                if (b_order > 0)
+                {
+                    put_bits(bw, b_shift, SHIFT_BITS);
+                    for (size_t j=0; j<b_order; ++j)
+                        put_bits(bw, bc[j], COEFF_BITS);
+                }
+                write_residual(bw, best, frames);
+            }
+
+            static status_t decode_channel(bit_reader_t *br, int32_t *x, size_t frames, size_t bits)
+            {
+                uint32_t v;
+                if (!get_bits(br, &v, ORDER_BITS))
+                    return STATUS_CORRUPTED_FILE;
+
+                // Samples stored as is
+                size_t order    = v;
+                if (order == ORDER_RAW)
+                {
+                    size_t ext      = 32 - bits;
+                    for (size_t i=0; i<frames; ++i)
+                    {
+                        if (!get_bits(br, &v, bits))
+                            return STATUS_CORRUPTED_FILE;
+                        x[i]            = int32_t(v << ext) >> ext;
+                    }
+                    return STATUS_OK;
+                }
+                else if (order > MAX_ORDER)
+                    return STATUS_CORRUPTED_FILE;
+
+                // Read coefficients of the predictor
+                int32_t c[MAX_ORDER];
+                size_t shift    = 0;
+                if (order > 0)
+                {
+                    if (!get_bits(br, &v, SHIFT_BITS))
+                        return STATUS_CORRUPTED_FILE;
+                    shift           = v;
+                    for (size_t j=0; j<order; ++j)
+                    {
+                        if (!get_bits(br, &v, COEFF_BITS))
+                            return STATUS_CORRUPTED_FILE;
+                        c[j]            = int16_t(v);
+                    }
+                }
+
+                // Read the residual
+                for (size_t off=0; off<frames; off += PARTITION)
+                {
+                    size_t count    = lsp_min(frames - off, PARTITION);
+                    int32_t *p      = &x[off];
+
+                    if (!get_bits(br, &v, RICE_BITS))
+                        return STATUS_CORRUPTED_FILE;
+                    size_t k        = v;
+
+                    for (size_t i=0; i<count; ++i)
+                    {
+                        if (!get_rice(br, &v, k))
+                            return STATUS_CORRUPTED_FILE;
+                        p[i]            = int32_t(unzigzag(v));
+                    }
+                }
+
+                // Restore the samples, the history before the first sample is zero. The filter is
+                // recursive: each sample depends on the previously restored ones, so it is not vectorized
+                if (order > 0)
+                {
+                    for (size_t i=0; i<frames; ++i)
+                        x[i]            = int32_t(uint32_t(x[i]) + predict(&x[i - order], c, order, shift));
+                }
+
+                return STATUS_OK;
+            }
+
+            //-----------------------------------------------------------------
+            // Interface
+            bool supported(size_t sample_format)
+            {
+                return sample_bits(sample_format) > 0;
+            }
+
+            size_t block_bound(size_t channels, size_t sample_format, size_t frames)
+            {
+                // The encoder never emits more bits than needed to store the samples as is
+                size_t bits     = channels * (ORDER_BITS + frames * sample_bits(sample_format));
+                return sizeof(chunk_audio_block_t) + ((bits + 7) >> 3);
+            }
+
+            size_t work_size(size_t frames)
+            {
+                return MAX_ORDER + frames * 3;
+            }
+
+            ssize_t encode(void *dst, const void *src, size_t channels, size_t sample_format, size_t frames, int32_t *work)
+            {
+                size_t bits     = sample_bits(sample_format);
+                if (bits <= 0)
+                    return -STATUS_UNSUPPORTED_FORMAT;
+
+                // The history of samples before the first sample is zero
+                int32_t *x      = &work[MAX_ORDER];
+                for (size_t i=0; i<MAX_ORDER; ++i)
+                    work[i]         = 0;
+
+                chunk_audio_block_t *hdr = static_cast<chunk_audio_block_t *>(dst);
+                bit_writer_t bw;
+                bw.p            = reinterpret_cast<uint8_t *>(&hdr[1]);
+                bw.acc          = 0;
+                bw.bits         = 0;
+
+                for (size_t i=0; i<channels; ++i)
+                {
+                    load_samples(x, src, i, channels, sample_format, frames);
+                    encode_channel(&bw, x, frames, bits, &x[frames]);
+                }
+                flush_bits(&bw);
+
+                size_t size     = bw.p - reinterpret_cast<uint8_t *>(&hdr[1]);
+                hdr->size       = CPU_TO_BE(uint32_t(size));
+                hdr->frames     = CPU_TO_BE(uint32_t(frames));
+
+                return size + sizeof(chunk_audio_block_t);
+            }
+
+            status_t decode(void *dst, const void *src, size_t size, size_t channels, size_t sample_format, size_t frames, int32_t *work)
+            {
+                size_t bits     = sample_bits(sample_format);
+                if (bits <= 0)
+                    return STATUS_UNSUPPORTED_FORMAT;
+
+                int32_t *x      = &work[MAX_ORDER];
+                for (size_t i=0; i<MAX_ORDER; ++i)
+                    work[i]         = 0;
+
+                bit_reader_t br;
+                br.p            = static_cast<const uint8_t *>(src);
+                br.end          = &br.p[size];
+                br.acc          = 0;
+                br.bits         = 0;
+
+                for (size_t i=0; i<channels; ++i)
+                {
+                    status_t res    = decode_channel(&br, x, frames, bits);
+                    if (res != STATUS_OK)
+                        return res;
+                    store_samples(dst, x, i, channels, sample_format, frames);
+                }
+
+                return STATUS_OK;
+            }
+
+        } /* namespace lossless */
+    } /* namespace lspc */
+} /* namespace lsp */
@@ -19,9 +19,11 @@
  * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <lsp-plug.in/common/bits.h>
 #include <lsp-plug.in/common/endian.h>
 #include <lsp-plug.in/io/InBitStream.h>
 #include <lsp-plug.in/io/InFileStream.h>
+#include <lsp-plug.in/stdlib/string.h>
 
 #define BITSTREAM_BUFSZ         (sizeof(umword_t) * 8)
 
@@ -35,6 +37,8 @@ namespace lsp
             nWrapFlags  = 0;
             nBuffer     = 0;
             nBits       = 0;
+            pHead       = NULL;
+            pTail       = NULL;
         }
 
         InBitStream::~InBitStream()
@@ -165,7 +169,7 @@ namespace lsp
 
         status_t InBitStream::wrap(IInStream *is, size_t flags)
         {
-            if (pIS != NULL)
+            if (!is_closed())
                 return set_error(STATUS_BAD_STATE);
             else if (is == NULL)
                 return set_error(STATUS_BAD_ARGUMENTS);
@@ -179,6 +183,23 @@ namespace lsp
             return set_error(STATUS_OK);
         }
 
+        status_t InBitStream::wrap(const void *data, size_t size)
+        {
+            if (!is_closed())
+                return set_error(STATUS_BAD_STATE);
+            else if (data == NULL)
+                return set_error(STATUS_BAD_ARGUMENTS);
+
+            // Store pointers
+            pHead       = reinterpret_cast<const uint8_t *>(data);
+            pTail       = &pHead[size];
+            nWrapFlags  = 0;
+            nBuffer     = 0;
+            nBits       = 0;
+
+            return set_error(STATUS_OK);
+        }
+
         status_t InBitStream::close()
         {
             status_t res = STATUS_OK;
@@ -194,6 +215,8 @@ namespace lsp
                 pIS         = NULL;
             }
 
+            pHead       = NULL;
+            pTail       = NULL;
             nWrapFlags  = 0;
             nBuffer     = 0;
             nBits       = 0;
@@ -204,6 +227,15 @@ namespace lsp
 
         ssize_t InBitStream::read(void *dst, size_t count)
         {
+            // Memory block does not need unread(): limit the amount of data to read
+            if (pHead != NULL)
+            {
+                size_t avail    = (nBits + ((pTail - pHead) << 3)) >> 3;
+                if ((avail <= 0) && (count > 0))
+                    return -set_error(STATUS_EOF);
+                count           = lsp_min(count, avail);
+            }
+
             ssize_t nread   = bread(dst, count * 8);
             if (nread < 0)
                 return nread;
@@ -220,12 +252,30 @@ namespace lsp
 
         ssize_t InBitStream::bread(void *buf, size_t bits)
         {
-            if (pIS == NULL)
+            if (is_closed())
                 return -set_error(STATUS_CLOSED);
 
             uint8_t *dst        = reinterpret_cast<uint8_t *>(buf);
             size_t nread        = 0;
 
+            // Memory block: the amount of data is known, read with machine words
+            if (pHead != NULL)
+            {
+                size_t avail        = nBits + ((pTail - pHead) << 3);
+                if ((avail <= 0) && (bits > 0))
+                    return -set_error(STATUS_EOF);
+                bits                = lsp_min(bits, avail);
+
+                for ( ; (bits - nread) >= BITSTREAM_BUFSZ; nread += BITSTREAM_BUFSZ)
+                {
+                    umword_t v;
+                    readv(&v, BITSTREAM_BUFSZ);
+                    v                   = CPU_TO_BE(v);
+                    ::memcpy(dst, &v, sizeof(v));
+                    dst                += sizeof(v);
+                }
+            }
+
             while (nread < bits)
             {
                 size_t to_read      = lsp_min(bits - nread, 8u);
@@ -249,7 +299,7 @@ namespace lsp
 
         wssize_t InBitStream::bskip(wsize_t amount)
         {
-            if (pIS == NULL)
+            if (is_closed())
                 return -set_error(STATUS_CLOSED);
 
             wsize_t skipped = 0;
@@ -268,6 +318,30 @@ namespace lsp
                 amount     -= skipped;
             }
 
+            // Memory block: just move the pointer
+            if (pHead != NULL)
+            {
+                amount      = lsp_min(amount, wsize_t(pTail - pHead) << 3);
+                pHead      += amount >> 3;
+                nBuffer     = 0;
+                skipped    += amount;
+
+                // Skip the tail bits
+                amount     &= 7;
+                if (amount > 0)
+                {
+                    refill();
+                    nBuffer   <<= amount;
+                    nBits      -= amount;
+                }
+
+                if (skipped <= 0)
+                    return -set_error(STATUS_EOF);
+
+                set_error(STATUS_OK);
+                return skipped;
+            }
+
             // Can skip bytes?
             wssize_t bytes  = amount >> 3;
             while (bytes > 0)
@@ -304,7 +378,7 @@ namespace lsp
         ssize_t InBitStream::readb(bool *value)
         {
             status_t res;
-            if (pIS == NULL)
+            if (is_closed())
                 return -set_error(STATUS_CLOSED);
 
             // Fill buffer with new data
@@ -339,12 +413,12 @@ namespace lsp
 
         ssize_t InBitStream::readv(uint32_t *value, size_t bits)
         {
-            if (pIS == NULL)
+            if (is_closed())
                 return -set_error(STATUS_CLOSED);
 
             size_t nread    = 0;
             status_t res;
-            uint32_t v      = 0;
+            uint64_t v      = 0;    // Allows to shift by 32 bits
 
             while (nread < bits)
             {
@@ -364,14 +438,14 @@ namespace lsp
                 nread              += to_read;
             }
 
-            *value          = v;
+            *value          = uint32_t(v);
             set_error(STATUS_OK);
             return nread;
         }
 
         ssize_t InBitStream::readv(uint64_t *value, size_t bits)
         {
-            if (pIS == NULL)
+            if (is_closed())
                 return -set_error(STATUS_CLOSED);
 
             size_t nread    = 0;
@@ -401,14 +475,113 @@ namespace lsp
             return nread;
         }
 
+        status_t InBitStream::read_uint(size_t *value, size_t initial, size_t stepping)
+        {
+            size_t bits     = initial;
+            size_t base     = 0;
+            bool prefix     = true;
+
+            if (pHead != NULL)
+            {
+                // Memory block: count the leading '1' bits of the buffer at once
+                refill();
+                umword_t inv    = ~nBuffer;
+                size_t ones     = (inv != 0) ? BITSTREAM_BUFSZ - 1 - int_log2(inv) : BITSTREAM_BUFSZ;
+                if (ones < nBits)
+                {
+                    nBuffer       <<= ones + 1;
+                    nBits          -= ones + 1;
+                    for (size_t i=0; i<ones; ++i, bits += stepping)
+                        base           += size_t(1) << bits;
+                    prefix          = false;
+
+                    // The value is in the buffer?
+                    if (bits <= 0)
+                    {
+                        *value          = base;
+                        return set_error(STATUS_OK);
+                    }
+                    else if (bits <= nBits)
+                    {
+                        *value          = base + size_t(nBuffer >> (BITSTREAM_BUFSZ - bits));
+                        nBuffer       <<= bits;
+                        nBits          -= bits;
+                        return set_error(STATUS_OK);
+                    }
+                }
+                else if (nBits <= 0)
+                    return set_error(STATUS_EOF);
+            }
+
+            // Generic case: read the prefix bit-by-bit
+            while (prefix)
+            {
+                bool flag;
+                ssize_t n;
+                if ((n = readb(&flag)) != 1)
+                    return set_error((n < 0) ? status_t(-n) : STATUS_IO_ERROR);
+                if (!flag)
+                    break;
+
+                base           += size_t(1) << bits;
+                bits           += stepping;
+            }
+
+            uint64_t v      = 0;
+            ssize_t n       = readv(&v, bits);
+            if (n != ssize_t(bits))
+                return set_error((n < 0) ? status_t(-n) : STATUS_IO_ERROR);
+
+            *value          = base + size_t(v);
+            return set_error(STATUS_OK);
+        }
+
         void InBitStream::unread(umword_t v, size_t bits)
         {
             nBuffer     = (nBuffer >> bits) | (v << (BITSTREAM_BUFSZ - bits));
             nBits      += bits;
         }
 
+        void InBitStream::refill()
+        {
+            size_t avail    = pTail - pHead;
+            if (avail >= sizeof(umword_t))
+            {
+                // Load the whole machine word but account only complete bytes: the rest
+                // bits of the word are the same data and will be merged again on next refill
+                umword_t v;
+                #if defined(ARCH_X86)
+                    // x86 allows unaligned memory access
+                    v           = *reinterpret_cast<const umword_t *>(pHead);
+                #else
+                    ::memcpy(&v, pHead, sizeof(v));
+                #endif /* ARCH_X86 */
+
+                size_t bytes    = (BITSTREAM_BUFSZ - 1 - nBits) >> 3;
+                nBuffer        |= BE_TO_CPU(v) >> nBits;
+                pHead          += bytes;
+                nBits          += bytes << 3;
+                return;
+            }
+
+            // Tail of the block, read with bytes
+            for ( ; (avail > 0) && (nBits < (BITSTREAM_BUFSZ - 8)); --avail)
+            {
+                nBuffer        |= umword_t(*(pHead++)) << (BITSTREAM_BUFSZ - 8 - nBits);
+                nBits          += 8;
+            }
+        }
+
         status_t InBitStream::fill()
         {
+            // Memory block?
+            if (pHead != NULL)
+            {
+                if (nBits < (BITSTREAM_BUFSZ - 8))
+                    refill();
+                return (nBits > 0) ? STATUS_OK : STATUS_EOF;
+            }
+
             if (nBits > 0)
                 return STATUS_OK;
 
@@ -425,5 +598,3 @@ namespace lsp
 
     }
 }
-
-
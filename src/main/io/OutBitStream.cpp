@@ -21,10 +21,13 @@
 
 #include <lsp-plug.in/io/OutBitStream.h>
 #include <lsp-plug.in/io/OutFileStream.h>
+#include <lsp-plug.in/common/alloc.h>
 #include <lsp-plug.in/common/endian.h>
+#include <lsp-plug.in/stdlib/string.h>
 
 #define BITSTREAM_BUFSZ     (sizeof(umword_t) * 8)
 #define BITSTREAM_BUFSZ32   (sizeof(uint32_t) * 8)
+#define BITSTREAM_BLKSZ     0x1000
 
 namespace lsp
 {
@@ -36,6 +39,9 @@ namespace lsp
             nWrapFlags  = 0;
             nBuffer     = 0;
             nBits       = 0;
+            pBlock      = NULL;
+            nBlockOff   = 0;
+            nBlockError = STATUS_OK;
         }
 
         OutBitStream::~OutBitStream()
@@ -51,8 +57,15 @@ namespace lsp
                 pOS         = NULL;
             }
 
-            nBuffer = 0;
-            nBits   = 0;
+            if (pBlock != NULL)
+            {
+                free(pBlock);
+                pBlock      = NULL;
+            }
+
+            nBuffer     = 0;
+            nBits       = 0;
+            nBlockOff   = 0;
         }
 
         status_t OutBitStream::close()
@@ -76,7 +89,16 @@ namespace lsp
                     delete pOS;
                 pOS         = NULL;
             }
+
+            if (pBlock != NULL)
+            {
+                free(pBlock);
+                pBlock      = NULL;
+            }
             nWrapFlags  = 0;
+            nBuffer     = 0;
+            nBits       = 0;
+            nBlockOff   = 0;
 
             // Return result
             return set_error(res);
@@ -218,11 +240,21 @@ namespace lsp
             else if (os == NULL)
                 return set_error(STATUS_BAD_ARGUMENTS);
 
+            // Allocate memory block for collecting machine words
+            if (pBlock == NULL)
+            {
+                pBlock      = reinterpret_cast<uint8_t *>(malloc(BITSTREAM_BLKSZ));
+                if (pBlock == NULL)
+                    return set_error(STATUS_NO_MEM);
+            }
+
             // Store pointers
             pOS         = os;
             nWrapFlags  = flags;
             nBuffer     = 0;
             nBits       = 0;
+            nBlockOff   = 0;
+            nBlockError = STATUS_OK;
 
             return set_error(STATUS_OK);
         }
@@ -308,41 +340,52 @@ namespace lsp
             return written;
         }
 
-        status_t OutBitStream::do_flush_buffer()
+        status_t OutBitStream::flush_block()
         {
-            if (nBits == 0)
-                return set_error(STATUS_OK);
-
-            size_t written, bytes;
-            umword_t buf;
+            if (nBlockError != STATUS_OK)
+                return nBlockError;
 
-            if (nBits == sizeof(umword_t) * 8)
+            size_t off      = 0;
+            while (off < nBlockOff)
             {
-                buf         = CPU_TO_BE(nBuffer);
-                written     = pOS->write(&buf, sizeof(umword_t));
-
-                if (written != sizeof(umword_t))
-                    return -set_error(-written);
+                ssize_t written = pOS->write(&pBlock[off], nBlockOff - off);
+                if (written <= 0)
+                {
+                    // The state of the output stream is unknown, refuse further writes
+                    nBlockError     = (written < 0) ? status_t(-written) : STATUS_IO_ERROR;
+                    return nBlockError;
+                }
+                off            += written;
             }
-            else
+
+            nBlockOff       = 0;
+            return STATUS_OK;
+        }
+
+        status_t OutBitStream::do_flush_buffer()
+        {
+            // Emit the tail bits to the block, the last byte is padded with zeros
+            if (nBits > 0)
             {
-                uint8_t data[sizeof(umword_t)];
+                umword_t buf    = nBuffer << (BITSTREAM_BUFSZ - nBits);
+                size_t bytes    = (nBits + 7) >> 3;
+                size_t s        = BITSTREAM_BUFSZ - 8;
 
-                bytes       = (nBits + 7) >> 3; // Overall number of bytes to write
-                buf         = nBuffer << (BITSTREAM_BUFSZ - nBits);
-                size_t s    = BITSTREAM_BUFSZ - 8;
+                if (nBlockOff + bytes > BITSTREAM_BLKSZ)
+                {
+                    status_t res    = flush_block();
+                    if (res != STATUS_OK)
+                        return set_error(res);
+                }
 
                 for (size_t i=0; i<bytes; ++i, s -= 8)
-                    data[i]     = buf >> s;
+                    pBlock[nBlockOff++] = uint8_t(buf >> s);
 
-                written     = pOS->write(data, bytes);
-                if (written != bytes)
-                    return -set_error(-written);
+                nBuffer         = 0;
+                nBits           = 0;
             }
 
-            nBits       = 0;
-
-            return set_error(STATUS_OK);
+            return set_error(flush_block());
         }
 
         status_t OutBitStream::flush()
@@ -353,81 +396,77 @@ namespace lsp
             return do_flush_buffer();
         }
 
-        status_t OutBitStream::writeb(bool value)
+        status_t OutBitStream::put(umword_t value, size_t bits)
         {
-            status_t res;
-            if (pOS == NULL)
-                return set_error(STATUS_CLOSED);
+            if (nBlockError != STATUS_OK)
+                return nBlockError;
+
+            // Only 'bits' lower bits of the value are meaningful
+            value          &= umword_t(-1) >> (BITSTREAM_BUFSZ - bits);
+            size_t avail    = BITSTREAM_BUFSZ - nBits;
+
+            // The value fits into the buffer?
+            if (bits < avail)
+            {
+                nBuffer         = (nBuffer << bits) | value;
+                nBits          += bits;
+                return STATUS_OK;
+            }
 
-            // Need to flush?
-            if (nBits >= BITSTREAM_BUFSZ)
+            // Flush the block if there is no room for the machine word
+            if (nBlockOff + sizeof(umword_t) > BITSTREAM_BLKSZ)
             {
-                if ((res = flush()) != STATUS_OK)
+                status_t res    = flush_block();
+                if (res != STATUS_OK)
                     return res;
             }
 
-            nBuffer     = (nBuffer << 1) | umword_t(value);
-            ++nBits;
+            // Complete the machine word and store it to the block. The higher bits
+            // of the buffer above nBits are not cleared since they will be shifted out
+            bits           -= avail;
+            umword_t word   = (avail < BITSTREAM_BUFSZ) ? (nBuffer << avail) | (value >> bits) : value;
+            nBuffer         = value;
+            nBits           = bits;
 
-            return set_error(STATUS_OK);
+            word            = CPU_TO_BE(word);
+            ::memcpy(&pBlock[nBlockOff], &word, sizeof(umword_t));
+            nBlockOff      += sizeof(umword_t);
+
+            return STATUS_OK;
         }
 
-        status_t OutBitStream::writev(uint32_t value, size_t bits)
+        status_t OutBitStream::writeb(bool value)
         {
-            status_t res;
             if (pOS == NULL)
                 return set_error(STATUS_CLOSED);
 
-            value  <<= BITSTREAM_BUFSZ32 - bits;
-            while (bits > 0)
-            {
-                // Need to flush?
-                if (nBits >= BITSTREAM_BUFSZ)
-                {
-                    if ((res = flush()) != STATUS_OK)
-                        return res;
-                }
+            return set_error(put(umword_t(value), 1));
+        }
 
-                size_t avail    = lsp_min(bits, BITSTREAM_BUFSZ - nBits);
-                nBuffer         = (nBuffer << avail) | (value >> (BITSTREAM_BUFSZ32 - avail));
-                nBits          += avail;
-                bits           -= avail;
-                value         <<= avail;
-            }
+        status_t OutBitStream::writev(uint32_t value, size_t bits)
+        {
+            if (pOS == NULL)
+                return set_error(STATUS_CLOSED);
+            else if (bits <= 0)
+                return set_error(STATUS_OK);
 
-            return set_error(STATUS_OK);
+            return set_error(put(umword_t(value), lsp_min(bits, BITSTREAM_BUFSZ32)));
         }
 
         status_t OutBitStream::writev(uint64_t value, size_t bits)
         {
-            status_t res;
             if (pOS == NULL)
                 return set_error(STATUS_CLOSED);
-
-            #if defined(ARCH_64BIT)
-                value  <<= (BITSTREAM_BUFSZ - bits);
-                while (bits > 0)
-                {
-                    // Need to flush?
-                    if (nBits >= BITSTREAM_BUFSZ)
-                    {
-                        if ((res = flush()) != STATUS_OK)
-                            return res;
-                    }
-
-                    size_t avail    = lsp_min(bits, BITSTREAM_BUFSZ - nBits);
-                    nBuffer         = (nBuffer << avail) | (value >> (BITSTREAM_BUFSZ - avail));
-                    nBits          += avail;
-                    bits           -= avail;
-                    value         <<= avail;
-                }
-
+            else if (bits <= 0)
                 return set_error(STATUS_OK);
 
+            #if defined(ARCH_64BIT)
+                return set_error(put(value, lsp_min(bits, BITSTREAM_BUFSZ)));
             #else
                 // Need to write high part?
                 if (bits > BITSTREAM_BUFSZ)
                 {
+                    status_t res;
                     if ((res = writev(uint32_t(value >> BITSTREAM_BUFSZ), bits - BITSTREAM_BUFSZ)) != STATUS_OK)
                         return res;
                     bits    = BITSTREAM_BUFSZ;
@@ -438,7 +477,38 @@ namespace lsp
             #endif
         }
 
-    }
-}
+        status_t OutBitStream::write_uint(size_t value, size_t initial, size_t stepping)
+        {
+            status_t res;
+            if (pOS == NULL)
+                return set_error(STATUS_CLOSED);
+
+            // Compute the length of the prefix
+            size_t bits     = initial;
+            size_t prefix   = 0;
+            while (true)
+            {
+                size_t max      = size_t(1) << bits;
+                if (value < max)
+                    break;
+
+                value          -= max;
+                bits           += stepping;
+                ++prefix;
+            }
+
+            // Emit the prefix: the sequence of '1' bits terminated by '0' bit
+            for ( ; prefix >= BITSTREAM_BUFSZ32; prefix -= BITSTREAM_BUFSZ32)
+            {
+                if ((res = put(umword_t(0xffffffff), BITSTREAM_BUFSZ32)) != STATUS_OK)
+                    return set_error(res);
+            }
+            if ((res = put(((umword_t(1) << prefix) - 1) << 1, prefix + 1)) != STATUS_OK)
+                return set_error(res);
 
+            // Emit the value
+            return (bits > 0) ? writev(uint64_t(value), bits) : set_error(STATUS_OK);
+        }
 
+    }
+}
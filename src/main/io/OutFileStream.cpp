@@ -22,21 +22,144 @@
 #include <lsp-plug.in/io/StdioFile.h>
 #include <lsp-plug.in/io/NativeFile.h>
 #include <lsp-plug.in/io/OutFileStream.h>
+#include <lsp-plug.in/ipc/Thread.h>
+#include <lsp-plug.in/ipc/Condition.h>
+#include <lsp-plug.in/runtime/system.h>
+#include <lsp-plug.in/common/bits.h>
 #include <lsp-plug.in/stdlib/stdio.h>
+#include <lsp-plug.in/stdlib/string.h>
+
+#include <stdlib.h>
 
 namespace lsp
 {
     namespace io
     {
-        
+        /**
+         * State of the asynchronous write-behind mode. The caller fills the buffer
+         * with index nTail while the background thread writes nQueued buffers starting
+         * with index nHead. All fields shared between threads are protected by sCond
+         */
+        struct OutFileStream::async_t
+        {
+            ipc::Thread         sThread;        // Background writer thread
+            ipc::Condition      sCond;          // Synchronization primitive
+            File               *pFD;            // File to write
+            uint8_t            *pData;          // Data of all buffers
+            size_t             *vSizes;         // Size of data stored in each buffer
+            size_t              nBuffers;       // Number of buffers
+            size_t              nBufSize;       // Size of each buffer
+            size_t              nHead;          // Index of the first queued buffer
+            size_t              nQueued;        // Number of queued buffers
+            size_t              nTail;          // Index of the buffer filled by the caller
+            size_t              nFill;          // Number of bytes in the buffer filled by the caller
+            wssize_t            nPosition;      // Logical position of the stream
+            status_t            nError;         // Error reported by the background thread
+            bool                bShutdown;      // Shutdown request
+            latency_stats_t     sStats;         // Latency statistics
+
+            explicit async_t(): sThread(async_writer, this)
+            {
+                pFD             = NULL;
+                pData           = NULL;
+                vSizes          = NULL;
+                nBuffers        = 0;
+                nBufSize        = 0;
+                nHead           = 0;
+                nQueued         = 0;
+                nTail           = 0;
+                nFill           = 0;
+                nPosition       = 0;
+                nError          = STATUS_OK;
+                bShutdown       = false;
+                ::bzero(&sStats, sizeof(sStats));
+            }
+
+            ~async_t()
+            {
+                if (pData != NULL)
+                    free(pData);
+                if (vSizes != NULL)
+                    free(vSizes);
+                pData           = NULL;
+                vSizes          = NULL;
+            }
+        };
+
+        static status_t write_fully(File *fd, const uint8_t *buf, size_t count)
+        {
+            while (count > 0)
+            {
+                ssize_t n = fd->write(buf, count);
+                if (n < 0)
+                    return status_t(-n);
+                else if (n == 0)
+                    return STATUS_IO_ERROR;
+                buf        += n;
+                count      -= n;
+            }
+            return STATUS_OK;
+        }
+
+        status_t OutFileStream::async_writer(void *arg)
+        {
+            async_t *a = static_cast<async_t *>(arg);
+
+            a->sCond.lock();
+            while (true)
+            {
+                // Wait for the queued buffer
+                while ((a->nQueued <= 0) && (!a->bShutdown))
+                    a->sCond.wait();
+                if (a->nQueued <= 0)
+                    break;
+
+                // Write the buffer outside of the critical section,
+                // skip all data after the first error
+                size_t idx          = a->nHead;
+                const uint8_t *buf  = &a->pData[idx * a->nBufSize];
+                size_t size         = a->vSizes[idx];
+                bool skip           = a->nError != STATUS_OK;
+                a->sCond.unlock();
+
+                status_t res        = (skip) ? STATUS_OK : write_fully(a->pFD, buf, size);
+
+                // Release the buffer
+                a->sCond.lock();
+                if ((res != STATUS_OK) && (a->nError == STATUS_OK))
+                    a->nError           = res;
+                a->nHead            = (idx + 1) % a->nBuffers;
+                --a->nQueued;
+                a->sCond.notify_all();
+            }
+            a->sCond.unlock();
+
+            return STATUS_OK;
+        }
+
+        static inline wsize_t time_diff(const system::time_t *start)
+        {
+            system::time_t end;
+            system::get_time(&end);
+
+            wssize_t us = (wssize_t(end.seconds) - wssize_t(start->seconds)) * 1000000 +
+                          (wssize_t(end.nanos) - wssize_t(start->nanos)) / 1000;
+            return (us > 0) ? us : 1;
+        }
+
         OutFileStream::OutFileStream()
         {
             pFD         = NULL;
             nWrapFlags  = 0;
+            pAsync      = NULL;
         }
         
         OutFileStream::~OutFileStream()
         {
+            // Stop the background writer
+            if (pAsync != NULL)
+                drop_async();
+
             // Close file descriptor
             if (pFD != NULL)
             {
@@ -53,11 +176,26 @@ namespace lsp
         {
             status_t res = STATUS_OK;
 
+            // Write all pending data and stop the background writer
+            if (pAsync != NULL)
+            {
+                wsize_t wait    = 0;
+                res             = drain(&wait);
+                commit_latency(wait);
+                status_t xres   = drop_async();
+                if (res == STATUS_OK)
+                    res             = xres;
+            }
+
             if (pFD != NULL)
             {
                 // Perform close
                 if (nWrapFlags & WRAP_CLOSE)
-                    res = pFD->close();
+                {
+                    status_t xres   = pFD->close();
+                    if (res == STATUS_OK)
+                        res             = xres;
+                }
                 if (nWrapFlags & WRAP_DELETE)
                     delete pFD;
                 pFD         = NULL;
@@ -173,10 +311,161 @@ namespace lsp
             return open(path->as_string(), mode);
         }
 
+        status_t OutFileStream::start_async(size_t buffers, size_t size)
+        {
+            if (pFD == NULL)
+                return set_error(STATUS_CLOSED);
+            else if (pAsync != NULL)
+                return set_error(STATUS_BAD_STATE);
+            else if ((buffers < 2) || (size <= 0))
+                return set_error(STATUS_BAD_ARGUMENTS);
+
+            wssize_t pos    = pFD->position();
+            if (pos < 0)
+                return -set_error(status_t(-pos));
+
+            async_t *a      = new async_t();
+            if (a == NULL)
+                return set_error(STATUS_NO_MEM);
+
+            a->pFD          = pFD;
+            a->pData        = static_cast<uint8_t *>(malloc(buffers * size));
+            a->vSizes       = static_cast<size_t *>(malloc(buffers * sizeof(size_t)));
+            a->nBuffers     = buffers;
+            a->nBufSize     = size;
+            a->nPosition    = pos;
+            if ((a->pData == NULL) || (a->vSizes == NULL))
+            {
+                delete a;
+                return set_error(STATUS_NO_MEM);
+            }
+
+            status_t res    = a->sThread.start();
+            if (res != STATUS_OK)
+            {
+                delete a;
+                return set_error(res);
+            }
+
+            pAsync          = a;
+            return set_error(STATUS_OK);
+        }
+
+        status_t OutFileStream::stop_async()
+        {
+            if (pAsync == NULL)
+                return set_error(STATUS_BAD_STATE);
+
+            wsize_t wait    = 0;
+            status_t res    = drain(&wait);
+            commit_latency(wait);
+            status_t xres   = drop_async();
+            return set_error((res == STATUS_OK) ? xres : res);
+        }
+
+        status_t OutFileStream::drop_async()
+        {
+            async_t *a      = pAsync;
+            pAsync          = NULL;
+
+            // Request the writer to finish: all queued buffers will be written.
+            // The buffer filled by the caller is always free for queueing
+            a->sCond.lock();
+            if (a->nFill > 0)
+            {
+                a->vSizes[a->nTail] = a->nFill;
+                a->nFill        = 0;
+                ++a->nQueued;
+            }
+            a->bShutdown    = true;
+            a->sCond.notify_all();
+            a->sCond.unlock();
+            a->sThread.join();
+
+            status_t res    = a->nError;
+            delete a;
+
+            return res;
+        }
+
+        status_t OutFileStream::queue_buffer(size_t limit, wsize_t *wait)
+        {
+            async_t *a      = pAsync;
+
+            a->sCond.lock();
+
+            // Pass the filled buffer to the writer
+            if (a->nFill > 0)
+            {
+                a->vSizes[a->nTail] = a->nFill;
+                a->nTail        = (a->nTail + 1) % a->nBuffers;
+                a->nFill        = 0;
+                ++a->nQueued;
+                a->sCond.notify_all();
+            }
+
+            // Wait until number of queued buffers becomes not greater than limit
+            if (a->nQueued > limit)
+            {
+                system::time_t start;
+                system::get_time(&start);
+
+                do
+                {
+                    a->sCond.wait();
+                } while (a->nQueued > limit);
+
+                *wait          += time_diff(&start);
+            }
+
+            status_t res    = a->nError;
+            a->sCond.unlock();
+
+            return res;
+        }
+
+        status_t OutFileStream::drain(wsize_t *wait)
+        {
+            return queue_buffer(0, wait);
+        }
+
+        void OutFileStream::commit_latency(wsize_t wait)
+        {
+            latency_stats_t *st = &pAsync->sStats;
+
+            ++st->calls;
+            if (wait <= 0)
+            {
+                ++st->histogram[0];
+                return;
+            }
+
+            size_t idx      = int_log2(uint64_t(wait)) + 1;
+            ++st->blocked;
+            st->time       += wait;
+            ++st->histogram[lsp_min(idx, size_t(LATENCY_BUCKETS - 1))];
+        }
+
+        status_t OutFileStream::get_latency(latency_stats_t *stats) const
+        {
+            if (stats == NULL)
+                return STATUS_BAD_ARGUMENTS;
+            else if (pAsync == NULL)
+                return STATUS_BAD_STATE;
+
+            *stats          = pAsync->sStats;
+            return STATUS_OK;
+        }
+
         wssize_t OutFileStream::position()
         {
             if (pFD == NULL)
                 return set_error(STATUS_CLOSED);
+            if (pAsync != NULL)
+            {
+                set_error(STATUS_OK);
+                return pAsync->nPosition;
+            }
             wssize_t pos = pFD->position();
             set_error((pos < 0) ? status_t(-pos) : STATUS_OK);
             return pos;
@@ -186,6 +475,39 @@ namespace lsp
         {
             if (pFD == NULL)
                 return set_error(STATUS_CLOSED);
+            if (pAsync != NULL)
+            {
+                // Copy data to the buffers and pass them to the writer,
+                // errors of the writer are reported when passing the buffer
+                async_t *a          = pAsync;
+                const uint8_t *src  = static_cast<const uint8_t *>(buf);
+                wsize_t wait        = 0;
+                status_t res        = STATUS_OK;
+
+                for (size_t left = count; left > 0; )
+                {
+                    size_t n        = lsp_min(left, a->nBufSize - a->nFill);
+                    ::memcpy(&a->pData[a->nTail * a->nBufSize + a->nFill], src, n);
+                    a->nFill       += n;
+                    src            += n;
+                    left           -= n;
+
+                    if (a->nFill >= a->nBufSize)
+                    {
+                        if ((res = queue_buffer(a->nBuffers - 1, &wait)) != STATUS_OK)
+                            break;
+                    }
+                }
+
+                commit_latency(wait);
+                if (res != STATUS_OK)
+                    return -set_error(res);
+
+                a->nPosition   += count;
+                set_error(STATUS_OK);
+                return count;
+            }
+
             ssize_t res = pFD->write(buf, count);
             set_error((res < 0) ? status_t(-res) : STATUS_OK);
             return res;
@@ -195,11 +517,23 @@ namespace lsp
         {
             if (pFD == NULL)
                 return set_error(STATUS_CLOSED);
+            if (pAsync != NULL)
+            {
+                // The file can be accessed only after all pending data is written
+                wsize_t wait    = 0;
+                status_t res    = drain(&wait);
+                commit_latency(wait);
+                if (res != STATUS_OK)
+                    return -set_error(res);
+            }
+
             status_t res = pFD->seek(position, File::FSK_SET);
             if (res != STATUS_OK)
                 return -set_error(res);
             wssize_t pos = pFD->position();
             set_error((pos < 0) ? status_t(-pos) : STATUS_OK);
+            if ((pAsync != NULL) && (pos >= 0))
+                pAsync->nPosition   = pos;
             return pos;
         }
 
@@ -207,6 +541,14 @@ namespace lsp
         {
             if (pFD == NULL)
                 return set_error(STATUS_CLOSED);
+            if (pAsync != NULL)
+            {
+                wsize_t wait    = 0;
+                status_t res    = drain(&wait);
+                commit_latency(wait);
+                if (res != STATUS_OK)
+                    return set_error(res);
+            }
             return set_error(pFD->flush());
         }
 
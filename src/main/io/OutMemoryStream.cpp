@@ -35,6 +35,10 @@ namespace lsp
             nCapacity   = 0;
             nQuantity   = 0x1000;
             nPosition   = 0;
+            vSegments   = NULL;
+            nSegments   = 0;
+            nSegCap     = 0;
+            bSegmented  = false;
         }
         
         OutMemoryStream::OutMemoryStream(size_t quantity)
@@ -44,6 +48,23 @@ namespace lsp
             nCapacity   = 0;
             nQuantity   = quantity;
             nPosition   = 0;
+            vSegments   = NULL;
+            nSegments   = 0;
+            nSegCap     = 0;
+            bSegmented  = false;
+        }
+
+        OutMemoryStream::OutMemoryStream(size_t quantity, bool segmented)
+        {
+            pData       = NULL;
+            nSize       = 0;
+            nCapacity   = 0;
+            nQuantity   = quantity;
+            nPosition   = 0;
+            vSegments   = NULL;
+            nSegments   = 0;
+            nSegCap     = 0;
+            bSegmented  = segmented;
         }
 
         OutMemoryStream::~OutMemoryStream()
@@ -51,15 +72,187 @@ namespace lsp
             drop();
         }
 
+        status_t OutMemoryStream::add_segment(size_t size)
+        {
+            // Extend the list of segments
+            if (nSegments >= nSegCap)
+            {
+                size_t ncap     = nSegCap + 0x20;
+                segment_t *v    = reinterpret_cast<segment_t *>(::realloc(vSegments, ncap * sizeof(segment_t)));
+                if (v == NULL)
+                    return STATUS_NO_MEM;
+                vSegments       = v;
+                nSegCap         = ncap;
+            }
+
+            // Allocate the segment
+            uint8_t *data   = reinterpret_cast<uint8_t *>(::malloc(size));
+            if (data == NULL)
+                return STATUS_NO_MEM;
+
+            segment_t *s    = &vSegments[nSegments++];
+            s->data         = data;
+            s->offset       = nCapacity;
+            s->size         = size;
+            nCapacity      += size;
+
+            return STATUS_OK;
+        }
+
+        ssize_t OutMemoryStream::find_segment(size_t offset) const
+        {
+            if ((nSegments <= 0) || (offset >= nCapacity))
+                return -1;
+
+            // Writes are usually performed at the end of the stream
+            ssize_t last    = nSegments - 1;
+            if (offset >= vSegments[last].offset)
+                return last;
+
+            // Binary search
+            ssize_t first   = 0;
+            while (first < last)
+            {
+                ssize_t mid     = (first + last + 1) >> 1;
+                if (vSegments[mid].offset <= offset)
+                    first           = mid;
+                else
+                    last            = mid - 1;
+            }
+
+            return first;
+        }
+
+        bool OutMemoryStream::flatten() const
+        {
+            if (nSegments <= 1)
+                return true;
+
+            // Allocate the single segment for all data
+            size_t cap      = ((nCapacity + nQuantity - 1) / nQuantity) * nQuantity;
+            uint8_t *data   = reinterpret_cast<uint8_t *>(::malloc(cap));
+            if (data == NULL)
+                return false;
+
+            // Copy data and free segments
+            for (size_t i=0; i<nSegments; ++i)
+            {
+                segment_t *s    = &vSegments[i];
+                if (s->offset < nSize)
+                    ::memcpy(&data[s->offset], s->data, lsp_min(s->size, nSize - s->offset));
+                ::free(s->data);
+            }
+
+            vSegments[0].data   = data;
+            vSegments[0].offset = 0;
+            vSegments[0].size   = cap;
+            nSegments           = 1;
+            nCapacity           = cap;
+
+            return true;
+        }
+
+        const uint8_t *OutMemoryStream::data() const
+        {
+            if (!bSegmented)
+                return pData;
+
+            if ((nSegments <= 0) || (!flatten()))
+                return NULL;
+            return vSegments[0].data;
+        }
+
+        size_t OutMemoryStream::segments() const
+        {
+            if (!bSegmented)
+                return (pData != NULL) ? 1 : 0;
+
+            ssize_t idx     = (nSize > 0) ? find_segment(nSize - 1) : -1;
+            return idx + 1;
+        }
+
+        const uint8_t *OutMemoryStream::segment(size_t index, size_t *size) const
+        {
+            if (!bSegmented)
+            {
+                if ((index > 0) || (pData == NULL))
+                    return NULL;
+                if (size != NULL)
+                    *size           = nSize;
+                return pData;
+            }
+
+            if (index >= nSegments)
+                return NULL;
+
+            const segment_t *s  = &vSegments[index];
+            if (size != NULL)
+                *size           = (s->offset < nSize) ? lsp_min(s->size, nSize - s->offset) : 0;
+            return s->data;
+        }
+
+        wssize_t OutMemoryStream::sink(IOutStream *os)
+        {
+            if (os == NULL)
+                return -set_error(STATUS_BAD_ARGUMENTS);
+
+            wssize_t written    = 0;
+            for (size_t i=0, n=segments(); i<n; ++i)
+            {
+                size_t count        = 0;
+                const uint8_t *src  = segment(i, &count);
+
+                while (count > 0)
+                {
+                    ssize_t nw          = os->write(src, count);
+                    if (nw <= 0)
+                    {
+                        // The sink that accepts no data would never be drained
+                        if (nw == 0)
+                            nw                  = -STATUS_IO_ERROR;
+                        set_error(-nw);
+                        return (written > 0) ? written : nw;
+                    }
+                    src                += nw;
+                    count              -= nw;
+                    written            += nw;
+                }
+            }
+
+            set_error(STATUS_OK);
+            return written;
+        }
+
         ssize_t OutMemoryStream::write(const void *buf, size_t count)
         {
+            if (count <= 0)
+            {
+                set_error(STATUS_OK);
+                return 0;
+            }
+
             size_t sz       = nPosition + count;
             status_t res    = reserve(sz);
             if (res != STATUS_OK)
                 return -res;
 
             // Append data
-            ::memcpy(&pData[nPosition], buf, count);
+            if (bSegmented)
+            {
+                const uint8_t *src  = reinterpret_cast<const uint8_t *>(buf);
+                segment_t *s        = &vSegments[find_segment(nPosition)];
+                for (size_t left = count; left > 0; ++s)
+                {
+                    size_t off          = nPosition + count - left - s->offset;
+                    size_t n            = lsp_min(left, s->size - off);
+                    ::memcpy(&s->data[off], src, n);
+                    src                += n;
+                    left               -= n;
+                }
+            }
+            else
+                ::memcpy(&pData[nPosition], buf, count);
+
             nPosition   = sz;
             if (nSize < sz)
                 nSize       = sz;
@@ -74,7 +267,17 @@ namespace lsp
             if (res != STATUS_OK)
                 return -res;
 
-            pData[nPosition++]  = v;
+            if (bSegmented)
+            {
+                const segment_t *s  = &vSegments[find_segment(nPosition)];
+                s->data[nPosition - s->offset]  = v;
+                ++nPosition;
+            }
+            else
+                pData[nPosition++]  = v;
+
+            if (nSize < nPosition)
+                nSize       = nPosition;
             return 1;
         }
 
@@ -94,6 +297,14 @@ namespace lsp
         uint8_t *OutMemoryStream::release()
         {
             uint8_t *data   = pData;
+            if (bSegmented)
+            {
+                if (!flatten())
+                    return NULL;
+                data            = (nSegments > 0) ? vSegments[0].data : NULL;
+                nSegments       = 0;
+            }
+
             pData           = NULL;
             nSize           = 0;
             nCapacity       = 0;
@@ -106,7 +317,17 @@ namespace lsp
         {
             if (pData != NULL)
                 ::free(pData);
+            if (vSegments != NULL)
+            {
+                for (size_t i=0; i<nSegments; ++i)
+                    ::free(vSegments[i].data);
+                ::free(vSegments);
+            }
+
             pData       = NULL;
+            vSegments   = NULL;
+            nSegments   = 0;
+            nSegCap     = 0;
             nSize       = 0;
             nCapacity   = 0;
             nPosition   = 0;
@@ -136,6 +357,11 @@ namespace lsp
                 return set_error(STATUS_OK);
 
             size_t ncap = ((amount + nQuantity - 1) / nQuantity) * nQuantity; // Quantify capacity
+
+            // Segmented mode: allocate new segment for the missing space, keep the data in place
+            if (bSegmented)
+                return set_error(add_segment(lsp_max(ncap - nCapacity, nQuantity)));
+
             uint8_t *p  = reinterpret_cast<uint8_t *>(::realloc(pData, ncap));
             if (p == NULL)
                 return set_error(STATUS_NO_MEM);
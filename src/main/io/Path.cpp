@@ -105,6 +105,18 @@ namespace lsp
             return STATUS_OK;
         }
 
+        status_t Path::set(const PathView *path)
+        {
+            if (path == NULL)
+                return STATUS_BAD_ARGUMENTS;
+            // The view may refer to our own data: LSPString::set() moves characters
+            // without reallocation since the length does not exceed the capacity
+            if (!sPath.set(path->characters(), path->length()))
+                return STATUS_NO_MEM;
+            fixup_path();
+            return STATUS_OK;
+        }
+
         status_t Path::set(const char *path, const char *child)
         {
             Path tmp;
@@ -425,16 +437,7 @@ namespace lsp
 
         status_t Path::get_first(Path *path) const
         {
-            if (path == NULL)
-                return STATUS_BAD_ARGUMENTS;
-
-            ssize_t idx         = sPath.index_of(FILE_SEPARATOR_C);
-            if (idx < 0)
-                return STATUS_NOT_FOUND;
-            if (is_absolute())
-                ++idx;
-
-            return path->sPath.set(&sPath, 0, idx);
+            return (path != NULL) ? get_first(&path->sPath) : STATUS_BAD_ARGUMENTS;
         }
 
         status_t Path::pop_first(char *path, size_t maxlen)
@@ -683,21 +686,11 @@ namespace lsp
             else if (is_root())
                 return STATUS_BAD_STATE;
 
-            LSPString tmp;
-            if (!tmp.set_utf8(path))
+            size_t len = sPath.length();
+            if (!sPath.prepend_utf8(path, ::strlen(path)))
                 return STATUS_NO_MEM;
-            while (tmp.ends_with(FILE_SEPARATOR_C))
-                tmp.set_length(tmp.length() - 1);
 
-            bool success = tmp.append(FILE_SEPARATOR_C);
-            if (success)
-                success = tmp.append(&sPath);
-            if (success)
-            {
-                sPath.swap(&tmp);
-                fixup_path();
-            }
-            return (success) ? STATUS_OK : STATUS_NO_MEM;
+            return complete_parent(sPath.length() - len);
         }
 
         status_t Path::set_parent(LSPString *path)
@@ -707,21 +700,10 @@ namespace lsp
             else if (is_root())
                 return STATUS_BAD_STATE;
 
-            LSPString tmp;
-            if (!tmp.set(path))
+            if (!sPath.prepend(path))
                 return STATUS_NO_MEM;
-            while (tmp.ends_with(FILE_SEPARATOR_C))
-                tmp.set_length(tmp.length() - 1);
 
-            bool success = tmp.append(FILE_SEPARATOR_C);
-            if (success)
-                success = tmp.append(&sPath);
-            if (success)
-            {
-                sPath.swap(&tmp);
-                fixup_path();
-            }
-            return (success) ? STATUS_OK : STATUS_NO_MEM;
+            return complete_parent(path->length());
         }
 
         status_t Path::set_parent(Path *path)
@@ -731,21 +713,28 @@ namespace lsp
             else if (is_root())
                 return STATUS_BAD_STATE;
 
-            LSPString tmp;
-            if (!tmp.set(&path->sPath))
+            if (!sPath.prepend(&path->sPath))
                 return STATUS_NO_MEM;
-            while (tmp.ends_with(FILE_SEPARATOR_C))
-                tmp.set_length(tmp.length() - 1);
 
-            bool success = tmp.append(FILE_SEPARATOR_C);
-            if (success)
-                success = tmp.append(&sPath);
-            if (success)
+            return complete_parent(path->sPath.length());
+        }
+
+        status_t Path::complete_parent(size_t len)
+        {
+            // Strip trailing separators of the prepended parent and insert single one
+            size_t tail = len;
+            while ((tail > 0) && (sPath.char_at(tail - 1) == FILE_SEPARATOR_C))
+                --tail;
+            if ((tail < len) && (!sPath.remove(tail, len)))
+                return STATUS_NO_MEM;
+            if (!sPath.insert(tail, lsp_wchar_t(FILE_SEPARATOR_C)))
             {
-                sPath.swap(&tmp);
-                fixup_path();
+                sPath.remove(0, tail);
+                return STATUS_NO_MEM;
             }
-            return (success) ? STATUS_OK : STATUS_NO_MEM;
+
+            fixup_path();
+            return STATUS_OK;
         }
 
         status_t Path::concat(const char *path)
@@ -780,42 +769,57 @@ namespace lsp
 
         status_t Path::append_child(const char *path)
         {
-            Path tmp;
-            status_t res = tmp.set(path);
-            if (res != STATUS_OK)
-                return res;
-            else if (tmp.is_empty())
-                return STATUS_OK;
-            else if (tmp.is_absolute())
-                return STATUS_INVALID_VALUE;
+            if (path == NULL)
+                return STATUS_BAD_ARGUMENTS;
 
             size_t len = sPath.length();
             bool success = ((len <= 0) || (sPath.ends_with(FILE_SEPARATOR_C))) ? true : sPath.append(FILE_SEPARATOR_C);
+            size_t off = sPath.length();
             if (success)
-                success = sPath.append(&tmp.sPath);
-            if (success)
-                fixup_path();
-            else
-                sPath.set_length(len);
+                success = sPath.append_utf8(path);
 
-            return (success) ? STATUS_OK : STATUS_NO_MEM;
+            return complete_child(len, off, success);
         }
 
         status_t Path::append_child(const LSPString *path)
         {
-            Path tmp;
-            status_t res = tmp.set(path);
-            if (res != STATUS_OK)
-                return res;
-            else if (tmp.is_empty())
+            if (path == NULL)
+                return STATUS_BAD_ARGUMENTS;
+
+            size_t len = sPath.length();
+            bool success = ((len <= 0) || (sPath.ends_with(FILE_SEPARATOR_C))) ? true : sPath.append(FILE_SEPARATOR_C);
+            size_t off = sPath.length();
+            if (success)
+                success = sPath.append(path);
+
+            return complete_child(len, off, success);
+        }
+
+        status_t Path::append_child(const PathView *path)
+        {
+            if (path == NULL)
+                return STATUS_BAD_ARGUMENTS;
+            else if (path->is_empty())
                 return STATUS_OK;
-            else if (tmp.is_absolute())
+            else if (path->is_absolute())
                 return STATUS_INVALID_VALUE;
 
-            size_t len = sPath.length();
+            // The view may refer to our own data, keep it's position before reallocation
+            const lsp_wchar_t *data = sPath.characters();
+            const lsp_wchar_t *src  = path->characters();
+            size_t count            = path->length();
+            size_t len              = sPath.length();
+            if ((data != NULL) && (src >= data) && (src < &data[len]))
+            {
+                size_t first = src - data;
+                if (!sPath.reserve(len + count + 1))
+                    return STATUS_NO_MEM;
+                src          = &sPath.characters()[first];
+            }
+
             bool success = ((len <= 0) || (sPath.ends_with(FILE_SEPARATOR_C))) ? true : sPath.append(FILE_SEPARATOR_C);
             if (success)
-                success = sPath.append(&tmp.sPath);
+                success = sPath.append(src, count);
             if (success)
                 fixup_path();
             else
@@ -824,6 +828,32 @@ namespace lsp
             return (success) ? STATUS_OK : STATUS_NO_MEM;
         }
 
+        status_t Path::complete_child(size_t len, size_t off, bool success)
+        {
+            if (!success)
+            {
+                sPath.set_length(len);
+                return STATUS_NO_MEM;
+            }
+
+            // Validate the appended child path
+            fixup_path();
+            PathView child;
+            child.set(&sPath, off, sPath.length());
+            if (child.is_empty())
+            {
+                sPath.set_length(len);
+                return STATUS_OK;
+            }
+            else if (child.is_absolute())
+            {
+                sPath.set_length(len);
+                return STATUS_INVALID_VALUE;
+            }
+
+            return STATUS_OK;
+        }
+
         status_t Path::append_child(const Path *path)
         {
             if (path == NULL)
@@ -906,10 +936,11 @@ namespace lsp
 
         status_t Path::remove_last(LSPString *path) const
         {
-            Path tmp;
-            status_t res = tmp.set(&this->sPath);
-            if (res == STATUS_OK)
-                res         = tmp.remove_last();
+            if (path == NULL)
+                return STATUS_BAD_ARGUMENTS;
+
+            PathView tmp(this);
+            status_t res = tmp.remove_last();
             if (res == STATUS_OK)
                 res         = tmp.get(path);
             return res;
@@ -917,12 +948,13 @@ namespace lsp
 
         status_t Path::remove_last(Path *path) const
         {
-            Path tmp;
-            status_t res = tmp.set(&this->sPath);
-            if (res == STATUS_OK)
-                res         = tmp.remove_last();
+            if (path == NULL)
+                return STATUS_BAD_ARGUMENTS;
+
+            PathView tmp(this);
+            status_t res = tmp.remove_last();
             if (res == STATUS_OK)
-                res         = tmp.get(path);
+                res         = path->set(&tmp);
             return res;
         }
 
@@ -932,7 +964,10 @@ namespace lsp
             if (is_relative())
             {
                 if (idx < 0)
-                    idx             = 0;
+                {
+                    sPath.clear();
+                    return STATUS_OK;
+                }
                 return (sPath.remove(0, idx + 1)) ? STATUS_OK : STATUS_NO_MEM;
             }
             else if (idx < 0)
@@ -954,10 +989,11 @@ namespace lsp
 
         status_t Path::remove_first(LSPString *path) const
         {
-            Path tmp;
-            status_t res = tmp.set(&this->sPath);
-            if (res == STATUS_OK)
-                res         = tmp.remove_first();
+            if (path == NULL)
+                return STATUS_BAD_ARGUMENTS;
+
+            PathView tmp(this);
+            status_t res = tmp.remove_first();
             if (res == STATUS_OK)
                 res         = tmp.get(path);
             return res;
@@ -965,12 +1001,13 @@ namespace lsp
 
         status_t Path::remove_first(Path *path) const
         {
-            Path tmp;
-            status_t res = tmp.set(&this->sPath);
-            if (res == STATUS_OK)
-                res         = tmp.remove_first();
+            if (path == NULL)
+                return STATUS_BAD_ARGUMENTS;
+
+            PathView tmp(this);
+            status_t res = tmp.remove_first();
             if (res == STATUS_OK)
-                res         = tmp.get(path);
+                res         = path->set(&tmp);
             return res;
         }
 
@@ -1052,11 +1089,7 @@ namespace lsp
             if (removed <= 0)
                 return STATUS_INVALID_VALUE;
 
-            LSPString tmp;
-            if (!tmp.set(&sPath, index, max))
-                return STATUS_NO_MEM;
-            sPath.swap(&tmp);
-            return STATUS_OK;
+            return (sPath.remove(0, index)) ? STATUS_OK : STATUS_NO_MEM;
         }
 
         status_t Path::remove_base(const Path *path)
@@ -1235,13 +1268,11 @@ namespace lsp
                         if (c == FILE_SEPARATOR_C)
                         {
                             state       = S_SEPARATOR;
-                            do // Roll-back path
-                            {
-                                if (w <= s)
-                                    break;
+                            // Roll-back path
+                            if (w > s)
+                                --w;
+                            while ((w > s) && (w[-1] != FILE_SEPARATOR_C))
                                 --w;
-                            }
-                            while (w[-1] != FILE_SEPARATOR_C);
                         }
                         else
                         {
@@ -1279,6 +1310,7 @@ namespace lsp
         {
             if (path == NULL)
                 return STATUS_BAD_ARGUMENTS;
+
             Path tmp;
             status_t res = tmp.set(&sPath);
             if (res == STATUS_OK)
@@ -1292,12 +1324,12 @@ namespace lsp
         {
             if (path == NULL)
                 return STATUS_BAD_ARGUMENTS;
-            Path tmp;
-            status_t res = tmp.set(&sPath);
-            if (res == STATUS_OK)
-                res     = tmp.canonicalize();
+            else if (path == this)
+                return const_cast<Path *>(this)->canonicalize();
+
+            status_t res = path->set(this);
             if (res == STATUS_OK)
-                tmp.swap(path);
+                res     = path->canonicalize();
             return res;
         }
 
@@ -1311,6 +1343,11 @@ namespace lsp
             return (path != NULL) ? sPath.equals(path) : false;
         }
 
+        bool Path::equals(const PathView *path) const
+        {
+            return (path != NULL) ? sPath.equals(path->characters(), path->length()) : false;
+        }
+
         bool Path::equals(const char *path) const
         {
             if (path == NULL)
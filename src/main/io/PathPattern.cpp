@@ -21,24 +21,43 @@
 
 #include <lsp-plug.in/io/PathPattern.h>
 #include <lsp-plug.in/io/charset.h>
+#include <lsp-plug.in/common/alloc.h>
 #include <lsp-plug.in/common/debug.h>
+#include <lsp-plug.in/stdlib/string.h>
 
+#include <stdlib.h>
 #include <wctype.h>
 
 namespace lsp
 {
     namespace io
     {
+        static const size_t     DFA_MAX_STATES      = 0x1000;       // Maximum number of states in automaton
+        static const uint32_t   DFA_NONE            = uint32_t(-1); // Undefined state
+        static const uint32_t   DFA_CLASS_SEP       = 0;            // Character class for path separator
+        static const uint32_t   DFA_CLASS_OTHER     = 1;            // Character class for any other character
+        static const uint32_t   DFA_CLASS_CHAR      = 2;            // First character class for literal characters
+        static const uint32_t   DFA_ITEM_ANY        = uint32_t(-1); // Pattern item matching any non-separator character
+
+        enum pattern_char_t
+        {
+            PCHAR_SEP       = -1,
+            PCHAR_ANY       = -2
+        };
+
         PathPattern::PathPattern()
         {
             nFlags      = 0;
             pRoot       = NULL;
+            pDFA        = NULL;
         }
 
         PathPattern::~PathPattern()
         {
             destroy_cmd(pRoot);
+            destroy_dfa(pDFA);
             pRoot   = NULL;
+            pDFA    = NULL;
         }
 
         void PathPattern::destroy_cmd(cmd_t *cmd)
@@ -396,7 +415,10 @@ namespace lsp
 
                 // Merge command and parse next sub-expression
                 if ((res = merge_step(&out, next, CMD_AND)) == STATUS_OK)
-                    res = parse_not(&next, it);
+                {
+                    next    = NULL; // Now the command is owned by the output expression
+                    res     = parse_not(&next, it);
+                }
 
                 // Parse command
                 if (res != STATUS_OK)
@@ -431,7 +453,10 @@ namespace lsp
 
                 // Merge command and parse next sub-expression
                 if ((res = merge_step(&out, next, CMD_OR)) == STATUS_OK)
-                    res = parse_and(&next, it);
+                {
+                    next    = NULL; // Now the command is owned by the output expression
+                    res     = parse_and(&next, it);
+                }
 
                 // Parse command
                 if (res != STATUS_OK)
@@ -476,6 +501,7 @@ namespace lsp
                 else if (tok != T_EOF)
                     return STATUS_BAD_FORMAT;
 
+                tmp.compile();
                 tmp.swap(this); // Apply new value on success
             }
 
@@ -685,7 +711,7 @@ namespace lsp
 
             // Last character in sequence should be a path separator
             ch  = str[count-1];
-            if ((ch == '/') || (ch == '/'))
+            if ((ch == '/') || (ch == '\\'))
                 return !cmd->bInverse;
 
             // The separator is not necessary if we are at the end of line
@@ -950,14 +976,12 @@ namespace lsp
         bool PathPattern::brute_matcher_match(matcher_t *m, size_t start, size_t count)
         {
             brute_matcher_t *bm = static_cast<brute_matcher_t *>(m);
-            const cmd_t *cmd    = bm->cmd;
 
             // Only one element?
             if (bm->items.size() <= 1)
             {
                 mregion_t *r            = bm->items.first();
-                bool match              = r->matcher->match(r->matcher, start, count);
-                return match ^ cmd->bInverse;
+                return r->matcher->match(r->matcher, start, count);
             }
 
             // Initialize positions
@@ -970,16 +994,15 @@ namespace lsp
                 r->start                = last;
             }
 
-            // Iterate over all variants
+            // Iterate over all variants, the inversion is applied by the owning sequence matcher
             while (true)
             {
-                bool match              = brute_match_variable(bm, start, count);
-                if (match)
-                    return !cmd->bInverse;
+                if (brute_match_variable(bm, start, count))
+                    return true;
 
                 // Try to search next fixed pattern
                 if (!brute_next_variable(bm, start, count))
-                    return cmd->bInverse;
+                    return false;
             }
 
             return false;
@@ -1309,74 +1332,1089 @@ namespace lsp
             return match;
         }
 
-        status_t PathPattern::set(const char *pattern, size_t flags)
+        bool PathPattern::match_string(const lsp_wchar_t *s, size_t len) const
         {
+            // Use compiled automaton if possible
+            if (pDFA != NULL)
+                return dfa_match(pDFA, s, len) ^ bool(nFlags & INVERSE);
+
+            // Fall back to the interpreter
             LSPString tmp;
-            return (tmp.set_utf8(pattern)) ? parse(&tmp, flags) : STATUS_NO_MEM;
+            if (!tmp.set(s, len))
+                return false;
+
+            return match_full(&tmp);
         }
 
-        size_t PathPattern::set_flags(size_t flags)
+        static inline bool item_match(uint32_t item, uint32_t cls)
         {
-            size_t old  = nFlags;
-            nFlags      = flags & (INVERSE | MATCH_CASE | FULL_PATH);
-            return old;
+            return (item == DFA_ITEM_ANY) ? (cls != DFA_CLASS_SEP) : (item == cls);
         }
 
-        bool PathPattern::test(const char *path) const
+        static uint32_t find_class(const lsp_wchar_t *v, size_t n, lsp_wchar_t ch)
         {
-            if (pRoot == NULL)
-                return false;
+            ssize_t first = 0, last = ssize_t(n) - 1;
+            while (first <= last)
+            {
+                ssize_t mid = (first + last) >> 1;
+                if (ch < v[mid])
+                    last    = mid - 1;
+                else if (ch > v[mid])
+                    first   = mid + 1;
+                else
+                    return DFA_CLASS_CHAR + mid;
+            }
 
-            Path tmp;
-            if (tmp.set(path) != STATUS_OK)
-                return false;
+            return DFA_CLASS_OTHER;
+        }
 
-            if (!(nFlags & FULL_PATH))
+        static int compare_chars(const void *a, const void *b)
+        {
+            lsp_wchar_t ca = *static_cast<const lsp_wchar_t *>(a);
+            lsp_wchar_t cb = *static_cast<const lsp_wchar_t *>(b);
+            return (ca < cb) ? -1 : (ca > cb) ? 1 : 0;
+        }
+
+        static void insert_state(uint32_t *key, size_t *len, uint32_t state)
+        {
+            // The first element of the key is not a part of the sorted set
+            size_t i = 1, n = *len;
+            while ((i < n) && (key[i] < state))
+                ++i;
+            if ((i < n) && (key[i] == state))
+                return;
+
+            for (size_t j=n; j > i; --j)
+                key[j]      = key[j-1];
+            key[i]      = state;
+            *len        = n + 1;
+        }
+
+        ssize_t PathPattern::decode_char(const lsp_wchar_t *pat, size_t *off, size_t len)
+        {
+            lsp_wchar_t pc = pat[(*off)++];
+
+            switch (pc)
             {
-                if (tmp.remove_base() != STATUS_OK)
-                    return false;
+                case '/':
+                case '\\':
+                    return PCHAR_SEP;
+                case '?':
+                    return PCHAR_ANY;
+                case '`':
+                    if (*off >= len)
+                        break;
+                    switch (pat[*off])
+                    {
+                        // Special symbols
+                        case '*': case '(': case ')': case '|':
+                        case '&': case '!': case '`':
+                            return pat[(*off)++];
+                        default:
+                            break;
+                    }
+                    break;
+                default:
+                    break;
             }
 
-            return match_full(tmp.as_string());
+            return pc;
         }
 
-        bool PathPattern::test(const LSPString *path) const
+        status_t PathPattern::collect_chars(lltl::darray<lsp_wchar_t> *dst, const LSPString *mask, const cmd_t *cmd, bool fold)
         {
-            if (pRoot == NULL)
-                return false;
+            if ((cmd->nCommand == CMD_PATTERN) || ((cmd->nCommand == CMD_ANY) && (cmd->nChars > 0)))
+            {
+                const lsp_wchar_t *pat  = mask->characters() + cmd->nStart;
+                for (size_t off=0; off < cmd->nLength; )
+                {
+                    ssize_t ch      = decode_char(pat, &off, cmd->nLength);
+                    if (ch < 0)
+                        continue;
+
+                    lsp_wchar_t *dc = dst->add();
+                    if (dc == NULL)
+                        return STATUS_NO_MEM;
+                    *dc             = (fold) ? lsp_wchar_t(towlower(ch)) : lsp_wchar_t(ch);
+                }
+            }
 
-            Path tmp;
-            if (tmp.set(path) != STATUS_OK)
-                return false;
+            for (size_t i=0, n=cmd->sChildren.size(); i<n; ++i)
+            {
+                status_t res = collect_chars(dst, mask, cmd->sChildren.uget(i), fold);
+                if (res != STATUS_OK)
+                    return res;
+            }
+
+            return STATUS_OK;
+        }
+
+        uint32_t PathPattern::char_class(const alphabet_t *ab, lsp_wchar_t ch)
+        {
+            if ((ch == '/') || (ch == '\\'))
+                return DFA_CLASS_SEP;
+            if (ab->bFold)
+                ch      = towlower(ch);
+            return find_class(ab->vChars, ab->nChars, ch);
+        }
 
-            if (!(nFlags & FULL_PATH))
+        size_t PathPattern::decode_items(uint32_t *items, const LSPString *mask, const cmd_t *cmd, const alphabet_t *ab)
+        {
+            const lsp_wchar_t *pat  = mask->characters() + cmd->nStart;
+            size_t count            = 0;
+
+            for (size_t off=0; off < cmd->nLength; )
             {
-                if (tmp.remove_base() != STATUS_OK)
-                    return false;
+                ssize_t ch              = decode_char(pat, &off, cmd->nLength);
+                items[count++]          =
+                    (ch == PCHAR_SEP) ? DFA_CLASS_SEP :
+                    (ch == PCHAR_ANY) ? DFA_ITEM_ANY :
+                    char_class(ab, ch);
             }
 
-            return match_full(tmp.as_string());
+            return count;
         }
 
-        bool PathPattern::test(const Path *path) const
+        void PathPattern::fa_init(fa_t *fa, size_t symbols)
+        {
+            fa->nStates         = 0;
+            fa->nCapacity       = 0;
+            fa->nSymbols        = symbols;
+            fa->vTrans          = NULL;
+            fa->vAccept         = NULL;
+            for (size_t i=0; i<DFA_CTX_TOTAL; ++i)
+                fa->vInit[i]        = DFA_NONE;
+        }
+
+        void PathPattern::fa_destroy(fa_t *fa)
+        {
+            if (fa->vTrans != NULL)
+            {
+                free(fa->vTrans);
+                fa->vTrans          = NULL;
+            }
+            if (fa->vAccept != NULL)
+            {
+                free(fa->vAccept);
+                fa->vAccept         = NULL;
+            }
+            fa->nStates         = 0;
+            fa->nCapacity       = 0;
+        }
+
+        void PathPattern::fa_swap(fa_t *a, fa_t *b)
+        {
+            lsp::swap(a->nStates, b->nStates);
+            lsp::swap(a->nCapacity, b->nCapacity);
+            lsp::swap(a->nSymbols, b->nSymbols);
+            lsp::swap(a->vTrans, b->vTrans);
+            lsp::swap(a->vAccept, b->vAccept);
+            for (size_t i=0; i<DFA_CTX_TOTAL; ++i)
+                lsp::swap(a->vInit[i], b->vInit[i]);
+        }
+
+        ssize_t PathPattern::fa_add_state(fa_t *fa, bool accept)
+        {
+            if (fa->nStates >= DFA_MAX_STATES)
+                return -STATUS_OVERFLOW;
+
+            // Ensure that there is enough space
+            if (fa->nStates >= fa->nCapacity)
+            {
+                size_t cap          = (fa->nCapacity > 0) ? fa->nCapacity << 1 : 0x10;
+                uint32_t *trans     = static_cast<uint32_t *>(realloc(fa->vTrans, cap * fa->nSymbols * sizeof(uint32_t)));
+                if (trans == NULL)
+                    return -STATUS_NO_MEM;
+                fa->vTrans          = trans;
+
+                uint8_t *acc        = static_cast<uint8_t *>(realloc(fa->vAccept, cap * sizeof(uint8_t)));
+                if (acc == NULL)
+                    return -STATUS_NO_MEM;
+                fa->vAccept         = acc;
+                fa->nCapacity       = cap;
+            }
+
+            // Initialize the state: all transitions lead to itself
+            size_t id           = fa->nStates++;
+            uint32_t *t         = &fa->vTrans[id * fa->nSymbols];
+            for (size_t i=0; i<fa->nSymbols; ++i)
+                t[i]                = id;
+            fa->vAccept[id]     = (accept) ? 1 : 0;
+
+            return id;
+        }
+
+        void PathPattern::fa_invert(fa_t *fa)
+        {
+            for (size_t i=0; i<fa->nStates; ++i)
+                fa->vAccept[i]      = !fa->vAccept[i];
+        }
+
+        uint32_t PathPattern::fa_dead_state(const fa_t *fa)
+        {
+            for (size_t i=0; i<fa->nStates; ++i)
+            {
+                if (fa->vAccept[i])
+                    continue;
+
+                const uint32_t *t   = &fa->vTrans[i * fa->nSymbols];
+                size_t j            = 0;
+                while ((j < fa->nSymbols) && (t[j] == i))
+                    ++j;
+                if (j >= fa->nSymbols)
+                    return i;
+            }
+
+            return DFA_NONE;
+        }
+
+        status_t PathPattern::fa_constant(fa_t *fa, bool empty, bool accept)
+        {
+            ssize_t s0      = fa_add_state(fa, accept);
+            if (s0 < 0)
+                return -s0;
+
+            for (size_t i=0; i<DFA_CTX_TOTAL; ++i)
+                fa->vInit[i]    = s0;
+
+            // Non-empty strings have the opposite result
+            if (empty)
+            {
+                ssize_t s1      = fa_add_state(fa, !accept);
+                if (s1 < 0)
+                    return -s1;
+
+                uint32_t *t     = &fa->vTrans[s0 * fa->nSymbols];
+                for (size_t i=0; i<fa->nSymbols; ++i)
+                    t[i]            = s1;
+            }
+
+            return STATUS_OK;
+        }
+
+        status_t PathPattern::fa_pattern(fa_t *fa, const uint32_t *items, size_t count)
+        {
+            // Each state is a number of matched items, the last one is the dead state
+            for (size_t i=0; i<=count+1; ++i)
+            {
+                ssize_t s       = fa_add_state(fa, i == count);
+                if (s < 0)
+                    return -s;
+            }
+
+            size_t dead     = count + 1;
+            for (size_t i=0; i<=count; ++i)
+            {
+                uint32_t *t     = &fa->vTrans[i * fa->nSymbols];
+                for (size_t j=0; j<fa->nSymbols; ++j)
+                    t[j]            = ((i < count) && (item_match(items[i], j >> 1))) ? i + 1 : dead;
+            }
+
+            for (size_t i=0; i<DFA_CTX_TOTAL; ++i)
+                fa->vInit[i]    = 0;
+
+            return STATUS_OK;
+        }
+
+        status_t PathPattern::fa_any(fa_t *fa, const uint32_t *items, ssize_t count)
+        {
+            // The dead state is always the first one
+            ssize_t dead    = fa_add_state(fa, false);
+            if (dead < 0)
+                return -dead;
+
+            // Simple cases: any sequence and any non-empty sequence of characters
+            if (count <= 0)
+            {
+                ssize_t s0      = fa_add_state(fa, count < 0);
+                if (s0 < 0)
+                    return -s0;
+                ssize_t s1      = (count < 0) ? s0 : fa_add_state(fa, true);
+                if (s1 < 0)
+                    return -s1;
+
+                for (ssize_t i=s0; i<=s1; ++i)
+                {
+                    uint32_t *t     = &fa->vTrans[i * fa->nSymbols];
+                    for (size_t j=0; j<fa->nSymbols; ++j)
+                        t[j]            = ((j >> 1) == DFA_CLASS_SEP) ? dead : s1;
+                }
+
+                for (size_t i=0; i<DFA_CTX_TOTAL; ++i)
+                    fa->vInit[i]    = s0;
+
+                return STATUS_OK;
+            }
+
+            // Any sequence which does not contain the excluded text: each state
+            // is a set of partially matched lengths of the excluded text
+            fa_index_t idx;
+            fa_index_init(&idx);
+
+            uint32_t *set   = static_cast<uint32_t *>(malloc((count + 1) * 2 * sizeof(uint32_t)));
+            if (set == NULL)
+                return STATUS_NO_MEM;
+            uint32_t *next  = &set[count + 1];
+
+            status_t res    = STATUS_OK;
+            next[0]         = 0;
+            ssize_t id      = fa_index_get(&idx, next, 1);
+            if (id < 0)
+                res             = -id;
+            else if ((id = fa_add_state(fa, true)) < 0)
+                res             = -id;
+
+            for (size_t i=0; (res == STATUS_OK) && (i < idx.nItems); ++i)
+            {
+                size_t len          = idx.vItems[i*4 + 1];
+                ::memcpy(set, fa_index_key(&idx, i), len * sizeof(uint32_t));
+
+                for (size_t cls=0, nclasses = fa->nSymbols >> 1; cls < nclasses; ++cls)
+                {
+                    uint32_t target     = dead;
+
+                    if (cls != DFA_CLASS_SEP)
+                    {
+                        size_t n            = 0;
+                        bool found          = false;
+                        next[n++]           = 0;
+                        for (size_t j=0; j<len; ++j)
+                        {
+                            uint32_t p          = set[j];
+                            if (!item_match(items[p], cls))
+                                continue;
+                            if (ssize_t(p + 1) >= count)
+                                found               = true;
+                            else
+                                next[n++]           = p + 1;
+                        }
+
+                        if (!found)
+                        {
+                            if ((id = fa_index_get(&idx, next, n)) < 0)
+                            {
+                                res                 = -id;
+                                break;
+                            }
+                            // New item in index produces new state
+                            if (size_t(id + 1) >= fa->nStates)
+                            {
+                                ssize_t s           = fa_add_state(fa, true);
+                                if (s < 0)
+                                {
+                                    res                 = -s;
+                                    break;
+                                }
+                            }
+                            target              = id + 1;
+                        }
+                    }
+
+                    uint32_t *t         = &fa->vTrans[(i + 1) * fa->nSymbols + (cls << 1)];
+                    t[0]                = target;
+                    t[1]                = target;
+                }
+            }
+
+            for (size_t i=0; i<DFA_CTX_TOTAL; ++i)
+                fa->vInit[i]    = 1;
+
+            free(set);
+            fa_index_destroy(&idx);
+
+            return res;
+        }
+
+        status_t PathPattern::fa_anypath(fa_t *fa, bool inverse)
+        {
+            // The region should follow the separator or start the string. It
+            // matches when it is empty, ends with separator or ends the string.
+            // The empty region at the start of the string always matches.
+            ssize_t e0      = fa_add_state(fa, true);           // Empty region, start of the string
+            ssize_t e1      = fa_add_state(fa, !inverse);       // Empty region after separator
+            ssize_t sep     = fa_add_state(fa, !inverse);       // Region ends with separator or end of string
+            ssize_t chr     = fa_add_state(fa, inverse);        // Region ends with other character
+            ssize_t bad     = fa_add_state(fa, inverse);        // Region does not follow the separator
+            if ((e0 < 0) || (e1 < 0) || (sep < 0) || (chr < 0) || (bad < 0))
+                return STATUS_NO_MEM;
+
+            for (ssize_t i=e0; i<=chr; ++i)
+            {
+                uint32_t *t     = &fa->vTrans[i * fa->nSymbols];
+                for (size_t j=0; j<fa->nSymbols; ++j)
+                    t[j]            = ((j & 1) || ((j >> 1) == DFA_CLASS_SEP)) ? sep : chr;
+            }
+
+            fa->vInit[DFA_CTX_START]    = e0;
+            fa->vInit[DFA_CTX_SEP]      = e1;
+            fa->vInit[DFA_CTX_OTHER]    = bad;
+
+            return STATUS_OK;
+        }
+
+        status_t PathPattern::fa_combine(fa_t *fa, const fa_t *a, const fa_t *b, bool conj)
+        {
+            fa_index_t idx;
+            uint32_t key[2];
+            ssize_t id      = 0;
+            size_t ns       = fa->nSymbols;
+
+            fa_index_init(&idx);
+
+            // Each state is a pair of states of both automatons, the number
+            // of the state matches the number of the pair in the index
+            for (size_t i=0; (id >= 0) && (i < DFA_CTX_TOTAL); ++i)
+            {
+                key[0]          = a->vInit[i];
+                key[1]          = b->vInit[i];
+                if ((id = fa_index_get(&idx, key, 2)) < 0)
+                    break;
+                if (size_t(id) >= fa->nStates)
+                    id              = fa_add_state(fa, (conj) ?
+                                        (a->vAccept[key[0]] && b->vAccept[key[1]]) :
+                                        (a->vAccept[key[0]] || b->vAccept[key[1]]));
+                fa->vInit[i]    = id;
+            }
+
+            for (size_t i=0; (id >= 0) && (i < fa->nStates); ++i)
+            {
+                for (size_t j=0; j<ns; ++j)
+                {
+                    const uint32_t *pk  = fa_index_key(&idx, i);
+                    key[0]              = a->vTrans[pk[0] * ns + j];
+                    key[1]              = b->vTrans[pk[1] * ns + j];
+                    if ((id = fa_index_get(&idx, key, 2)) < 0)
+                        break;
+                    if (size_t(id) >= fa->nStates)
+                    {
+                        id                  = fa_add_state(fa, (conj) ?
+                                                (a->vAccept[key[0]] && b->vAccept[key[1]]) :
+                                                (a->vAccept[key[0]] || b->vAccept[key[1]]));
+                        if (id < 0)
+                            break;
+                    }
+                    fa->vTrans[i * ns + j]  = id;
+                }
+            }
+
+            fa_index_destroy(&idx);
+            return (id < 0) ? -id : STATUS_OK;
+        }
+
+        status_t PathPattern::fa_concat(fa_t *fa, const fa_t *a, const fa_t *b)
         {
+            fa_index_t idx;
+            ssize_t id      = 0;
+            size_t ns       = fa->nSymbols;
+            uint32_t a_dead = fa_dead_state(a);
+            uint32_t b_dead = fa_dead_state(b);
+
+            // Each state is a state of the first automaton followed by the sorted
+            // set of states of the second automaton, dead states are omitted
+            uint32_t *key   = static_cast<uint32_t *>(malloc((b->nStates + 1) * 2 * sizeof(uint32_t)));
+            if (key == NULL)
+                return STATUS_NO_MEM;
+            uint32_t *cur   = &key[b->nStates + 1];
+
+            fa_index_init(&idx);
+
+            for (size_t i=0; (id >= 0) && (i < DFA_CTX_TOTAL + fa->nStates); ++i)
+            {
+                size_t klen, clen   = 0;
+                if (i >= DFA_CTX_TOTAL)
+                {
+                    clen                = idx.vItems[(i - DFA_CTX_TOTAL)*4 + 1];
+                    ::memcpy(cur, fa_index_key(&idx, i - DFA_CTX_TOTAL), clen * sizeof(uint32_t));
+                }
+
+                for (size_t j=0, n=(i < DFA_CTX_TOTAL) ? 1 : ns; j<n; ++j)
+                {
+                    uint32_t sa, ctx;
+
+                    // Compute the next state of the first automaton and the context for the second one
+                    if (i < DFA_CTX_TOTAL)
+                    {
+                        sa                  = a->vInit[i];
+                        ctx                 = i;
+                    }
+                    else
+                    {
+                        sa                  = (cur[0] != DFA_NONE) ? a->vTrans[cur[0] * ns + j] : DFA_NONE;
+                        ctx                 = ((j >> 1) == DFA_CLASS_SEP) ? DFA_CTX_SEP : DFA_CTX_OTHER;
+                    }
+                    key[0]              = (sa != a_dead) ? sa : DFA_NONE;
+                    klen                = 1;
+
+                    // Advance the second automaton
+                    for (size_t k=1; k<clen; ++k)
+                    {
+                        uint32_t sb         = b->vTrans[cur[k] * ns + j];
+                        if (sb != b_dead)
+                            insert_state(key, &klen, sb);
+                    }
+
+                    // Start the second automaton if the first one matches
+                    if ((key[0] != DFA_NONE) && (a->vAccept[key[0]]) && (b->vInit[ctx] != b_dead))
+                        insert_state(key, &klen, b->vInit[ctx]);
+
+                    // Lookup for the state
+                    if ((id = fa_index_get(&idx, key, klen)) < 0)
+                        break;
+                    if (size_t(id) >= fa->nStates)
+                    {
+                        bool accept         = false;
+                        for (size_t k=1; (!accept) && (k<klen); ++k)
+                            accept              = b->vAccept[key[k]];
+                        if ((id = fa_add_state(fa, accept)) < 0)
+                            break;
+                    }
+
+                    if (i < DFA_CTX_TOTAL)
+                        fa->vInit[i]        = id;
+                    else
+                        fa->vTrans[(i - DFA_CTX_TOTAL) * ns + j] = id;
+                }
+            }
+
+            fa_index_destroy(&idx);
+            free(key);
+
+            return (id < 0) ? -id : STATUS_OK;
+        }
+
+        status_t PathPattern::fa_minimize(fa_t *fa)
+        {
+            fa_index_t idx;
+            fa_t res;
+            size_t ns       = fa->nSymbols;
+            size_t n        = fa->nStates;
+            ssize_t id      = 0;
+
+            // Allocate memory for classes of equivalence
+            uint32_t *cls   = static_cast<uint32_t *>(malloc((n * 2 + ns + 1) * sizeof(uint32_t)));
+            if (cls == NULL)
+                return STATUS_NO_MEM;
+            uint32_t *ncls  = &cls[n];
+            uint32_t *key   = &ncls[n];
+
+            // Initial partition: accepting and non-accepting states
+            size_t count    = 0;
+            bool has[2]     = { false, false };
+            for (size_t i=0; i<n; ++i)
+            {
+                cls[i]          = fa->vAccept[i];
+                has[cls[i]]     = true;
+            }
+            count           = size_t(has[0]) + size_t(has[1]);
+
+            // Refine partition until it becomes stable
+            fa_index_init(&idx);
+            while (true)
+            {
+                fa_index_clear(&idx);
+                for (size_t i=0; i<n; ++i)
+                {
+                    const uint32_t *t   = &fa->vTrans[i * ns];
+                    key[0]              = cls[i];
+                    for (size_t j=0; j<ns; ++j)
+                        key[j+1]            = cls[t[j]];
+                    if ((id = fa_index_get(&idx, key, ns + 1)) < 0)
+                        break;
+                    ncls[i]             = id;
+                }
+                if (id < 0)
+                    break;
+
+                lsp::swap(cls, ncls);
+                if (idx.nItems <= count)
+                    break;
+                count           = idx.nItems;
+            }
+            fa_index_destroy(&idx);
+
+            // Build the minimized automaton
+            fa_init(&res, ns);
+            for (size_t i=0; (id >= 0) && (i<count); ++i)
+                id              = fa_add_state(&res, false);
+
+            if (id >= 0)
+            {
+                for (size_t i=0; i<n; ++i)
+                {
+                    const uint32_t *t   = &fa->vTrans[i * ns];
+                    uint32_t *dt        = &res.vTrans[cls[i] * ns];
+                    for (size_t j=0; j<ns; ++j)
+                        dt[j]               = cls[t[j]];
+                    res.vAccept[cls[i]] = fa->vAccept[i];
+                }
+                for (size_t i=0; i<DFA_CTX_TOTAL; ++i)
+                    res.vInit[i]        = cls[fa->vInit[i]];
+
+                fa_swap(fa, &res);
+            }
+
+            // The pointers may be swapped, release the lowest one
+            free(lsp_min(cls, ncls));
+            fa_destroy(&res);
+
+            return (id < 0) ? -id : STATUS_OK;
+        }
+
+        status_t PathPattern::fa_reduce(fa_t *fa, dfa_context_t ctx)
+        {
+            fa_t res;
+            size_t ns       = fa->nSymbols;
+            ssize_t id      = 0;
+
+            uint32_t *map   = static_cast<uint32_t *>(malloc((fa->nStates * 2) * sizeof(uint32_t)));
+            if (map == NULL)
+                return STATUS_NO_MEM;
+            uint32_t *queue = &map[fa->nStates];
+            for (size_t i=0; i<fa->nStates; ++i)
+                map[i]          = DFA_NONE;
+
+            // Enumerate all states reachable from the initial state
+            size_t count    = 0;
+            uint32_t start  = fa->vInit[ctx];
+            map[start]      = count;
+            queue[count++]  = start;
+
+            for (size_t i=0; i<count; ++i)
+            {
+                const uint32_t *t   = &fa->vTrans[queue[i] * ns];
+                for (size_t j=0; j<ns; ++j)
+                {
+                    if (map[t[j]] != DFA_NONE)
+                        continue;
+                    map[t[j]]           = count;
+                    queue[count++]      = t[j];
+                }
+            }
+
+            // Build the reduced automaton
+            fa_init(&res, ns);
+            for (size_t i=0; (id >= 0) && (i<count); ++i)
+            {
+                if ((id = fa_add_state(&res, fa->vAccept[queue[i]])) < 0)
+                    break;
+
+                const uint32_t *t   = &fa->vTrans[queue[i] * ns];
+                uint32_t *dt        = &res.vTrans[i * ns];
+                for (size_t j=0; j<ns; ++j)
+                    dt[j]               = map[t[j]];
+            }
+            for (size_t i=0; i<DFA_CTX_TOTAL; ++i)
+                res.vInit[i]    = 0;
+
+            if (id >= 0)
+                fa_swap(fa, &res);
+
+            free(map);
+            fa_destroy(&res);
+
+            return (id < 0) ? -id : STATUS_OK;
+        }
+
+        void PathPattern::fa_index_init(fa_index_t *idx)
+        {
+            idx->vData          = NULL;
+            idx->nData          = 0;
+            idx->nDataCap       = 0;
+            idx->vItems         = NULL;
+            idx->nItems         = 0;
+            idx->nItemsCap      = 0;
+            idx->vBins          = NULL;
+            idx->nBins          = 0;
+        }
+
+        void PathPattern::fa_index_destroy(fa_index_t *idx)
+        {
+            if (idx->vData != NULL)
+                free(idx->vData);
+            if (idx->vItems != NULL)
+                free(idx->vItems);
+            if (idx->vBins != NULL)
+                free(idx->vBins);
+
+            fa_index_init(idx);
+        }
+
+        void PathPattern::fa_index_clear(fa_index_t *idx)
+        {
+            idx->nData          = 0;
+            idx->nItems         = 0;
+            for (size_t i=0; i<idx->nBins; ++i)
+                idx->vBins[i]       = DFA_NONE;
+        }
+
+        const uint32_t *PathPattern::fa_index_key(const fa_index_t *idx, size_t id)
+        {
+            return &idx->vData[idx->vItems[id * 4]];
+        }
+
+        ssize_t PathPattern::fa_index_get(fa_index_t *idx, const uint32_t *key, size_t len)
+        {
+            // Compute the hash of the key
+            uint32_t hash   = 0x811c9dc5;
+            for (size_t i=0; i<len; ++i)
+                hash            = (hash ^ key[i]) * 0x01000193;
+
+            // Lookup for existing item
+            if (idx->nBins > 0)
+            {
+                for (uint32_t id = idx->vBins[hash & (idx->nBins - 1)]; id != DFA_NONE; )
+                {
+                    const uint32_t *item    = &idx->vItems[id * 4];
+                    if ((item[1] == len) && (item[2] == hash) &&
+                        (::memcmp(&idx->vData[item[0]], key, len * sizeof(uint32_t)) == 0))
+                        return id;
+                    id                      = item[3];
+                }
+            }
+
+            // Grow the hash table if needed
+            if (idx->nItems >= idx->nBins)
+            {
+                size_t nbins        = (idx->nBins > 0) ? idx->nBins << 1 : 0x40;
+                uint32_t *bins      = static_cast<uint32_t *>(realloc(idx->vBins, nbins * sizeof(uint32_t)));
+                if (bins == NULL)
+                    return -STATUS_NO_MEM;
+                idx->vBins          = bins;
+                idx->nBins          = nbins;
+
+                for (size_t i=0; i<nbins; ++i)
+                    bins[i]             = DFA_NONE;
+                for (size_t i=0; i<idx->nItems; ++i)
+                {
+                    uint32_t *item      = &idx->vItems[i * 4];
+                    uint32_t *bin       = &bins[item[2] & (nbins - 1)];
+                    item[3]             = *bin;
+                    *bin                = i;
+                }
+
+                uint32_t *items     = static_cast<uint32_t *>(realloc(idx->vItems, nbins * 4 * sizeof(uint32_t)));
+                if (items == NULL)
+                    return -STATUS_NO_MEM;
+                idx->vItems         = items;
+                idx->nItemsCap      = nbins;
+            }
+
+            // Ensure that there is enough space for the key
+            if ((idx->nData + len) > idx->nDataCap)
+            {
+                size_t cap          = lsp_max(idx->nDataCap << 1, idx->nData + len + 0x100);
+                uint32_t *data      = static_cast<uint32_t *>(realloc(idx->vData, cap * sizeof(uint32_t)));
+                if (data == NULL)
+                    return -STATUS_NO_MEM;
+                idx->vData          = data;
+                idx->nDataCap       = cap;
+            }
+
+            // Add new item
+            size_t id           = idx->nItems++;
+            uint32_t *item      = &idx->vItems[id * 4];
+            uint32_t *bin       = &idx->vBins[hash & (idx->nBins - 1)];
+            ::memcpy(&idx->vData[idx->nData], key, len * sizeof(uint32_t));
+
+            item[0]             = idx->nData;
+            item[1]             = len;
+            item[2]             = hash;
+            item[3]             = *bin;
+            *bin                = id;
+            idx->nData         += len;
+
+            return id;
+        }
+
+        status_t PathPattern::compile_cmd(fa_t *fa, const LSPString *mask, const cmd_t *cmd, const alphabet_t *ab)
+        {
+            status_t res        = STATUS_OK;
+            bool inverse        = cmd->bInverse;
+
+            switch (cmd->nCommand)
+            {
+                case CMD_PATTERN:
+                case CMD_ANY:
+                {
+                    if ((cmd->nCommand == CMD_ANY) && (cmd->nChars <= 0))
+                    {
+                        res                 = fa_any(fa, NULL, cmd->nChars);
+                        break;
+                    }
+
+                    uint32_t *items     = static_cast<uint32_t *>(malloc((cmd->nLength + 1) * sizeof(uint32_t)));
+                    if (items == NULL)
+                        return STATUS_NO_MEM;
+
+                    size_t count        = decode_items(items, mask, cmd, ab);
+                    res                 = (cmd->nCommand == CMD_ANY) ?
+                                            fa_any(fa, items, count) :
+                                            fa_pattern(fa, items, count);
+                    free(items);
+                    break;
+                }
+
+                case CMD_ANYPATH:
+                    res                 = fa_anypath(fa, inverse);
+                    inverse             = false;
+                    break;
+
+                case CMD_AND:
+                case CMD_OR:
+                case CMD_SEQUENCE:
+                {
+                    size_t n            = cmd->sChildren.size();
+                    if (n <= 0)
+                    {
+                        res                 = fa_constant(fa, cmd->nCommand == CMD_SEQUENCE, cmd->nCommand != CMD_OR);
+                        break;
+                    }
+
+                    // Fold all child automatons
+                    res                 = compile_cmd(fa, mask, cmd->sChildren.uget(0), ab);
+                    for (size_t i=1; (res == STATUS_OK) && (i<n); ++i)
+                    {
+                        fa_t next, out;
+                        fa_init(&next, fa->nSymbols);
+                        fa_init(&out, fa->nSymbols);
+
+                        res                 = compile_cmd(&next, mask, cmd->sChildren.uget(i), ab);
+                        if (res == STATUS_OK)
+                            res                 = (cmd->nCommand == CMD_SEQUENCE) ?
+                                                    fa_concat(&out, fa, &next) :
+                                                    fa_combine(&out, fa, &next, cmd->nCommand == CMD_AND);
+                        if (res == STATUS_OK)
+                            res                 = fa_minimize(&out);
+                        if (res == STATUS_OK)
+                            fa_swap(fa, &out);
+
+                        fa_destroy(&next);
+                        fa_destroy(&out);
+                    }
+                    break;
+                }
+
+                default:
+                    return STATUS_BAD_STATE;
+            }
+
+            if (res != STATUS_OK)
+                return res;
+            if (inverse)
+                fa_invert(fa);
+
+            return fa_minimize(fa);
+        }
+
+        PathPattern::dfa_t *PathPattern::build_dfa(const fa_t *fa, const alphabet_t *ab)
+        {
+            size_t szof_dfa     = align_size(sizeof(dfa_t), DEFAULT_ALIGN);
+            size_t szof_trans   = fa->nStates * fa->nSymbols * sizeof(uint32_t);
+            size_t szof_chars   = ab->nChars * sizeof(lsp_wchar_t);
+            size_t szof_accept  = fa->nStates * sizeof(uint8_t);
+
+            uint8_t *ptr        = static_cast<uint8_t *>(malloc(szof_dfa + szof_trans + szof_chars + szof_accept));
+            if (ptr == NULL)
+                return NULL;
+
+            dfa_t *dfa          = reinterpret_cast<dfa_t *>(ptr);
+            ptr                += szof_dfa;
+            uint32_t *trans     = reinterpret_cast<uint32_t *>(ptr);
+            ptr                += szof_trans;
+            lsp_wchar_t *chars  = reinterpret_cast<lsp_wchar_t *>(ptr);
+            ptr                += szof_chars;
+            uint8_t *accept     = ptr;
+
+            ::memcpy(trans, fa->vTrans, szof_trans);
+            ::memcpy(accept, fa->vAccept, szof_accept);
+            if (szof_chars > 0)
+                ::memcpy(chars, ab->vChars, szof_chars);
+
+            dfa->nStates        = fa->nStates;
+            dfa->nSymbols       = fa->nSymbols;
+            dfa->nChars         = ab->nChars;
+            dfa->nStart         = fa->vInit[DFA_CTX_START];
+            dfa->nReject        = fa_dead_state(fa);
+            dfa->nAccept        = DFA_NONE;
+            dfa->bFold          = ab->bFold;
+            dfa->vChars         = chars;
+            dfa->vTrans         = trans;
+            dfa->vAccept        = accept;
+
+            for (size_t i=0; i<0x80; ++i)
+                dfa->vAscii[i]      = char_class(ab, i);
+
+            // Find the state which always leads to match
+            for (size_t i=0; i<fa->nStates; ++i)
+            {
+                if (!accept[i])
+                    continue;
+
+                const uint32_t *t   = &trans[i * fa->nSymbols];
+                size_t j            = 0;
+                while ((j < fa->nSymbols) && (t[j] == i))
+                    ++j;
+                if (j >= fa->nSymbols)
+                {
+                    dfa->nAccept        = i;
+                    break;
+                }
+            }
+
+            return dfa;
+        }
+
+        void PathPattern::destroy_dfa(dfa_t *dfa)
+        {
+            if (dfa != NULL)
+                free(dfa);
+        }
+
+        void PathPattern::compile()
+        {
+            destroy_dfa(pDFA);
+            pDFA                = NULL;
             if (pRoot == NULL)
+                return;
+
+            // Collect the alphabet of the pattern
+            lltl::darray<lsp_wchar_t> chars;
+            alphabet_t ab;
+
+            ab.bFold            = !(nFlags & MATCH_CASE);
+            if (collect_chars(&chars, &sMask, pRoot, ab.bFold) != STATUS_OK)
+                return;
+
+            ab.vChars           = chars.first();
+            ab.nChars           = chars.size();
+            if (ab.nChars > 0)
+            {
+                // Sort characters and remove duplicates
+                ::qsort(ab.vChars, ab.nChars, sizeof(lsp_wchar_t), compare_chars);
+                size_t n            = 1;
+                for (size_t i=1; i<ab.nChars; ++i)
+                {
+                    if (ab.vChars[i] != ab.vChars[n-1])
+                        ab.vChars[n++]      = ab.vChars[i];
+                }
+                ab.nChars           = n;
+            }
+            ab.nSymbols         = (DFA_CLASS_CHAR + ab.nChars) * 2;
+
+            // Build the automaton, fall back to the interpreter on failure
+            fa_t fa;
+            fa_init(&fa, ab.nSymbols);
+
+            status_t res        = compile_cmd(&fa, &sMask, pRoot, &ab);
+            if (res == STATUS_OK)
+                res                 = fa_reduce(&fa, DFA_CTX_START);
+            if (res == STATUS_OK)
+                pDFA                = build_dfa(&fa, &ab);
+
+            fa_destroy(&fa);
+        }
+
+        uint32_t PathPattern::dfa_class(const dfa_t *dfa, lsp_wchar_t ch)
+        {
+            if (ch < 0x80)
+                return dfa->vAscii[ch];
+            if (dfa->bFold)
+            {
+                ch                  = towlower(ch);
+                if (ch < 0x80)
+                    return dfa->vAscii[ch];
+            }
+            return find_class(dfa->vChars, dfa->nChars, ch);
+        }
+
+        uint32_t PathPattern::dfa_step(const dfa_t *dfa, uint32_t state, lsp_wchar_t ch, bool last)
+        {
+            return dfa->vTrans[state * dfa->nSymbols + (dfa_class(dfa, ch) << 1) + size_t(last)];
+        }
+
+        bool PathPattern::dfa_match(const dfa_t *dfa, const lsp_wchar_t *s, size_t len)
+        {
+            uint32_t state      = dfa->nStart;
+            if (len > 0)
+            {
+                for (const lsp_wchar_t *end = &s[len - 1]; s < end; ++s)
+                {
+                    state               = dfa_step(dfa, state, *s, false);
+                    if (state == dfa->nReject)
+                        return false;
+                    else if (state == dfa->nAccept)
+                        return true;
+                }
+                state               = dfa_step(dfa, state, *s, true);
+            }
+
+            return dfa->vAccept[state];
+        }
+
+        size_t PathPattern::name_offset(const lsp_wchar_t *s, size_t len)
+        {
+            while (len > 0)
+            {
+                lsp_wchar_t ch      = s[len - 1];
+                if ((ch == '/') || (ch == '\\'))
+                    break;
+                --len;
+            }
+            return len;
+        }
+
+        status_t PathPattern::set(const char *pattern, size_t flags)
+        {
+            LSPString tmp;
+            return (tmp.set_utf8(pattern)) ? parse(&tmp, flags) : STATUS_NO_MEM;
+        }
+
+        size_t PathPattern::set_flags(size_t flags)
+        {
+            size_t old  = nFlags;
+            nFlags      = flags & (INVERSE | MATCH_CASE | FULL_PATH);
+
+            // Character case affects the alphabet of the automaton
+            if ((old ^ nFlags) & MATCH_CASE)
+                compile();
+
+            return old;
+        }
+
+        bool PathPattern::test(const char *path) const
+        {
+            if ((pRoot == NULL) || (path == NULL))
+                return false;
+
+            LSPString tmp;
+            if (!tmp.set_utf8(path))
                 return false;
 
-            if (nFlags & FULL_PATH)
-                return match_full(path->as_string());
+            return test(&tmp);
+        }
 
-            Path tmp;
-            if (tmp.get_last(&tmp) != STATUS_OK)
+        bool PathPattern::test(const LSPString *path) const
+        {
+            if ((pRoot == NULL) || (path == NULL))
                 return false;
 
-            return match_full(tmp.as_string());
+            const lsp_wchar_t *s    = path->characters();
+            size_t len              = path->length();
+            size_t off              = (nFlags & FULL_PATH) ? 0 : name_offset(s, len);
+
+            return match_string(&s[off], len - off);
+        }
+
+        bool PathPattern::test(const Path *path) const
+        {
+            return (path != NULL) ? test(path->as_string()) : false;
         }
 
         void PathPattern::swap(PathPattern *dst)
         {
             sMask.swap(dst->sMask);
             lsp::swap(pRoot, dst->pRoot);
+            lsp::swap(pDFA, dst->pDFA);
             lsp::swap(nFlags, dst->nFlags);
         }
     }
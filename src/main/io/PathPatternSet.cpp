@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 22 мар. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/io/PathPatternSet.h>
+#include <stdlib.h>
+
+namespace lsp
+{
+    namespace io
+    {
+        // Number of patterns processed without extra memory allocation
+        static const size_t PATTERN_SET_STATIC      = 0x20;
+
+        PathPatternSet::PathPatternSet()
+        {
+        }
+
+        PathPatternSet::~PathPatternSet()
+        {
+            clear();
+        }
+
+        status_t PathPatternSet::add(const char *pattern, size_t flags)
+        {
+            LSPString tmp;
+            if (pattern == NULL)
+                return STATUS_BAD_ARGUMENTS;
+            if (!tmp.set_utf8(pattern))
+                return STATUS_NO_MEM;
+            return add(&tmp, flags);
+        }
+
+        status_t PathPatternSet::add(const Path *pattern, size_t flags)
+        {
+            return (pattern != NULL) ? add(pattern->as_string(), flags) : STATUS_BAD_ARGUMENTS;
+        }
+
+        status_t PathPatternSet::add(const PathPattern *pattern)
+        {
+            return (pattern != NULL) ? add(pattern->get(), pattern->flags()) : STATUS_BAD_ARGUMENTS;
+        }
+
+        status_t PathPatternSet::add(const LSPString *pattern, size_t flags)
+        {
+            if (pattern == NULL)
+                return STATUS_BAD_ARGUMENTS;
+
+            PathPattern *p  = new PathPattern();
+            if (p == NULL)
+                return STATUS_NO_MEM;
+
+            status_t res    = p->set(pattern, flags);
+            if (res == STATUS_OK)
+            {
+                if (vItems.add(p))
+                    return STATUS_OK;
+                res             = STATUS_NO_MEM;
+            }
+
+            delete p;
+            return res;
+        }
+
+        status_t PathPatternSet::remove(size_t index)
+        {
+            PathPattern *p  = vItems.get(index);
+            if (p == NULL)
+                return STATUS_INVALID_VALUE;
+            if (!vItems.remove(index))
+                return STATUS_NO_MEM;
+
+            delete p;
+            return STATUS_OK;
+        }
+
+        void PathPatternSet::clear()
+        {
+            for (size_t i=0, n=vItems.size(); i<n; ++i)
+            {
+                PathPattern *p  = vItems.uget(i);
+                if (p != NULL)
+                    delete p;
+            }
+            vItems.flush();
+        }
+
+        ssize_t PathPatternSet::match_string(const LSPString *path, bool *matched, bool first) const
+        {
+            uint32_t xstate[PATTERN_SET_STATIC], xactive[PATTERN_SET_STATIC];
+            size_t n                = vItems.size();
+            if (n <= 0)
+                return (first) ? -1 : 0;
+
+            // Allocate memory for automaton states and list of active patterns
+            uint32_t *vstate        = xstate;
+            uint32_t *vactive       = xactive;
+            uint32_t *buf           = NULL;
+            if (n > PATTERN_SET_STATIC)
+            {
+                buf                     = static_cast<uint32_t *>(malloc(n * 2 * sizeof(uint32_t)));
+                if (buf == NULL)
+                {
+                    for (size_t i=0; (matched != NULL) && (i<n); ++i)
+                        matched[i]              = false;
+                    return (first) ? -1 : 0;
+                }
+                vstate                  = buf;
+                vactive                 = &buf[n];
+            }
+
+            const lsp_wchar_t *s    = path->characters();
+            size_t len              = path->length();
+            size_t name             = PathPattern::name_offset(s, len);
+            size_t nactive          = 0;
+            size_t count            = 0;
+            ssize_t index           = -1;
+
+            // Initialize states, patterns which have not been compiled are tested immediately
+            for (size_t i=0; i<n; ++i)
+            {
+                const PathPattern *p    = vItems.uget(i);
+                if (p->pRoot == NULL)
+                    vstate[i]               = 0;
+                else if (p->pDFA == NULL)
+                    vstate[i]               = p->test(path);
+                else
+                {
+                    vstate[i]               = p->pDFA->nStart;
+                    vactive[nactive++]      = i;
+                }
+            }
+
+            // Run all automatons simultaneously in one pass
+            for (size_t i=0; (i < len) && (nactive > 0); ++i)
+            {
+                lsp_wchar_t ch          = s[i];
+                bool last               = (i + 1) >= len;
+
+                for (size_t j=0; j<nactive; )
+                {
+                    size_t idx              = vactive[j];
+                    const PathPattern *p    = vItems.uget(idx);
+                    const PathPattern::dfa_t *dfa = p->pDFA;
+
+                    // Skip the base path if pattern matches only the last path entry
+                    if ((i < name) && (!(p->nFlags & PathPattern::FULL_PATH)))
+                    {
+                        ++j;
+                        continue;
+                    }
+
+                    uint32_t state          = PathPattern::dfa_step(dfa, vstate[idx], ch, last);
+                    vstate[idx]             = state;
+                    if ((state == dfa->nReject) || (state == dfa->nAccept))
+                        vactive[j]              = vactive[--nactive]; // The result is already known
+                    else
+                        ++j;
+                }
+            }
+
+            // Collect results
+            for (size_t i=0; i<n; ++i)
+            {
+                const PathPattern *p    = vItems.uget(i);
+                bool match              = false;
+                if (p->pRoot != NULL)
+                {
+                    match                   = (p->pDFA != NULL) ?
+                                                p->pDFA->vAccept[vstate[i]] ^ bool(p->nFlags & PathPattern::INVERSE) :
+                                                bool(vstate[i]);
+                }
+
+                if (matched != NULL)
+                    matched[i]              = match;
+                if (match)
+                {
+                    ++count;
+                    if (index < 0)
+                        index                   = i;
+                }
+            }
+
+            if (buf != NULL)
+                free(buf);
+
+            return (first) ? index : count;
+        }
+
+        ssize_t PathPatternSet::test(const char *path) const
+        {
+            LSPString tmp;
+            if ((path == NULL) || (!tmp.set_utf8(path)))
+                return -1;
+            return match_string(&tmp, NULL, true);
+        }
+
+        ssize_t PathPatternSet::test(const LSPString *path) const
+        {
+            return (path != NULL) ? match_string(path, NULL, true) : -1;
+        }
+
+        ssize_t PathPatternSet::test(const Path *path) const
+        {
+            return (path != NULL) ? match_string(path->as_string(), NULL, true) : -1;
+        }
+
+        size_t PathPatternSet::match(const char *path, bool *matched) const
+        {
+            LSPString tmp;
+            if ((path == NULL) || (!tmp.set_utf8(path)))
+                return 0;
+            return match_string(&tmp, matched, false);
+        }
+
+        size_t PathPatternSet::match(const LSPString *path, bool *matched) const
+        {
+            return (path != NULL) ? match_string(path, matched, false) : 0;
+        }
+
+        size_t PathPatternSet::match(const Path *path, bool *matched) const
+        {
+            return (path != NULL) ? match_string(path->as_string(), matched, false) : 0;
+        }
+
+        void PathPatternSet::swap(PathPatternSet *dst)
+        {
+            vItems.swap(&dst->vItems);
+        }
+    }
+}
@@ -0,0 +1,489 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 24 мар. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/io/PathView.h>
+#include <lsp-plug.in/io/Path.h>
+#include <lsp-plug.in/stdlib/string.h>
+
+namespace lsp
+{
+    namespace io
+    {
+        PathView::PathView()
+        {
+            pData       = NULL;
+            nLength     = 0;
+        }
+
+        PathView::PathView(const Path *path)
+        {
+            set(path);
+        }
+
+        PathView::PathView(const LSPString *path)
+        {
+            set(path);
+        }
+
+        PathView::~PathView()
+        {
+            pData       = NULL;
+            nLength     = 0;
+        }
+
+        void PathView::set(const lsp_wchar_t *path, size_t length)
+        {
+            pData       = path;
+            nLength     = (path != NULL) ? length : 0;
+        }
+
+        void PathView::set(const LSPString *path)
+        {
+            if (path != NULL)
+                assign(path->characters(), path->length());
+            else
+                assign(NULL, 0);
+        }
+
+        void PathView::set(const LSPString *path, size_t first, size_t last)
+        {
+            if (path == NULL)
+            {
+                assign(NULL, 0);
+                return;
+            }
+
+            size_t len  = path->length();
+            last        = lsp_min(last, len);
+            first       = lsp_min(first, last);
+            assign(&path->characters()[first], last - first);
+        }
+
+        void PathView::set(const Path *path)
+        {
+            set((path != NULL) ? path->as_string() : NULL);
+        }
+
+        void PathView::set(const PathView *path)
+        {
+            if (path != NULL)
+                assign(path->pData, path->nLength);
+            else
+                assign(NULL, 0);
+        }
+
+        status_t PathView::get(LSPString *path) const
+        {
+            if (path == NULL)
+                return STATUS_BAD_ARGUMENTS;
+            if (nLength <= 0)
+            {
+                path->clear();
+                return STATUS_OK;
+            }
+            return (path->set(pData, nLength)) ? STATUS_OK : STATUS_NO_MEM;
+        }
+
+        status_t PathView::get(Path *path) const
+        {
+            return (path != NULL) ? path->set(this) : STATUS_BAD_ARGUMENTS;
+        }
+
+        ssize_t PathView::index_of_sep(size_t start) const
+        {
+            for (size_t i=start; i<nLength; ++i)
+                if (pData[i] == FILE_SEPARATOR_C)
+                    return i;
+            return -1;
+        }
+
+        ssize_t PathView::rindex_of_sep() const
+        {
+            return rindex_of_sep(nLength);
+        }
+
+        ssize_t PathView::rindex_of_sep(size_t end) const
+        {
+            for (ssize_t i=lsp_min(end, nLength) - 1; i >= 0; --i)
+                if (pData[i] == FILE_SEPARATOR_C)
+                    return i;
+            return -1;
+        }
+
+        status_t PathView::get_last(PathView *path) const
+        {
+            if (path == NULL)
+                return STATUS_BAD_ARGUMENTS;
+
+            ssize_t idx = rindex_of_sep();
+            idx         = (idx < 0) ? 0 : idx + 1;
+            path->assign(&pData[idx], nLength - idx);
+
+            return STATUS_OK;
+        }
+
+        status_t PathView::get_first(PathView *path) const
+        {
+            if (path == NULL)
+                return STATUS_BAD_ARGUMENTS;
+
+            ssize_t idx = index_of_sep(0);
+            if (idx < 0)
+            {
+                if (nLength <= 0)
+                    return STATUS_NOT_FOUND;
+                idx         = nLength;
+            }
+            else if (is_absolute())
+                ++idx;
+
+            path->assign(pData, idx);
+            return STATUS_OK;
+        }
+
+        status_t PathView::get_ext(PathView *path) const
+        {
+            if (path == NULL)
+                return STATUS_BAD_ARGUMENTS;
+
+            ssize_t start   = rindex_of_sep();
+            start           = (start < 0) ? 0 : start + 1;
+
+            // Lookup for last dot
+            ssize_t dot     = -1;
+            for (size_t i=start; i<nLength; ++i)
+                if (pData[i] == '.')
+                    dot             = i;
+            start           = (dot >= 0) ? dot + 1 : nLength;
+
+            path->assign(&pData[start], nLength - start);
+            return STATUS_OK;
+        }
+
+        status_t PathView::get_noext(PathView *path) const
+        {
+            if (path == NULL)
+                return STATUS_BAD_ARGUMENTS;
+
+            ssize_t start   = rindex_of_sep();
+            start           = (start < 0) ? 0 : start + 1;
+
+            // Lookup for last dot
+            ssize_t end     = -1;
+            for (size_t i=start; i<nLength; ++i)
+                if (pData[i] == '.')
+                    end             = i;
+            if (end < 0)
+                end             = nLength;
+
+            path->assign(&pData[start], end - start);
+            return STATUS_OK;
+        }
+
+        status_t PathView::get_parent(PathView *path) const
+        {
+            if (path == NULL)
+                return STATUS_BAD_ARGUMENTS;
+            else if (is_root())
+                return STATUS_NOT_FOUND;
+
+            ssize_t idx = rindex_of_sep();
+            if (idx < 0)
+                return STATUS_NOT_FOUND;
+
+            path->assign(pData, idx);
+            return STATUS_OK;
+        }
+
+        status_t PathView::get_root(PathView *path) const
+        {
+            if (path == NULL)
+                return STATUS_BAD_ARGUMENTS;
+            else if (!is_absolute())
+                return STATUS_NOT_FOUND;
+
+            ssize_t idx = index_of_sep(0);
+            path->assign(pData, (idx < 0) ? nLength : idx + 1);
+            return STATUS_OK;
+        }
+
+        status_t PathView::pop_last(PathView *path)
+        {
+            if (path == NULL)
+                return STATUS_BAD_ARGUMENTS;
+
+            ssize_t idx = rindex_of_sep();
+            size_t off  = (idx < 0) ? 0 : idx + 1;
+            path->assign(&pData[off], nLength - off);
+            nLength     = (idx < 0) ? 0 : idx;
+
+            return STATUS_OK;
+        }
+
+        status_t PathView::pop_first(PathView *path)
+        {
+            if (path == NULL)
+                return STATUS_BAD_ARGUMENTS;
+
+            size_t tail;
+            ssize_t idx = index_of_sep(0);
+            if (idx < 0)
+            {
+                if (nLength <= 0)
+                    return STATUS_NOT_FOUND;
+                tail        = nLength;
+                idx         = tail;
+            }
+            else
+            {
+                tail        = (is_absolute()) ? idx + 1 : idx;
+                idx        += 1;
+            }
+
+            path->assign(pData, tail);
+            assign(&pData[idx], nLength - idx);
+
+            return STATUS_OK;
+        }
+
+        status_t PathView::remove_last()
+        {
+            if (is_root())
+                return STATUS_OK;
+
+            ssize_t idx     = rindex_of_sep();
+            if (is_relative())
+            {
+                if (idx < 0)
+                    idx             = 0;
+                nLength         = idx;
+            }
+            else if (idx >= 0)
+            {
+                ssize_t idx2    = (idx > 0) ? rindex_of_sep(idx) : -1;
+                if (idx2 < 0)
+                    idx             = idx + 1;
+                nLength         = idx;
+            }
+            return STATUS_OK;
+        }
+
+        status_t PathView::remove_first()
+        {
+            ssize_t idx     = index_of_sep(0);
+            if (is_relative())
+            {
+                if (idx < 0)
+                    idx             = nLength - 1;
+            }
+            else if (idx < 0)
+                return STATUS_NOT_FOUND;
+
+            assign(&pData[idx + 1], nLength - idx - 1);
+            return STATUS_OK;
+        }
+
+        status_t PathView::remove_base()
+        {
+            ssize_t idx     = rindex_of_sep();
+            if (idx >= 0)
+                assign(&pData[idx + 1], nLength - idx - 1);
+            return STATUS_OK;
+        }
+
+        status_t PathView::remove_root()
+        {
+            if (!is_absolute())
+                return STATUS_OK;
+
+            ssize_t idx     = index_of_sep(0);
+            if (idx < 0)
+                nLength         = 0;
+            else
+                assign(&pData[idx + 1], nLength - idx - 1);
+
+            return STATUS_OK;
+        }
+
+        status_t PathView::parent()
+        {
+            if (is_root())
+                return STATUS_OK;
+
+            ssize_t idx     = rindex_of_sep();
+            nLength         = (idx < 0) ? 0 : idx;
+            return STATUS_OK;
+        }
+
+        bool PathView::is_absolute() const
+        {
+            if (nLength <= 0)
+                return false;
+#if defined(PLATFORM_WINDOWS)
+            if (pData[0] == FILE_SEPARATOR_C)
+                return true;
+            return (nLength >= 2) && (pData[1] == ':') &&
+                (((pData[0] >= 'a') && (pData[0] <= 'z')) || ((pData[0] >= 'A') && (pData[0] <= 'Z')));
+#else
+            return pData[0] == FILE_SEPARATOR_C;
+#endif
+        }
+
+        bool PathView::is_relative() const
+        {
+            return !is_absolute();
+        }
+
+        bool PathView::is_root() const
+        {
+#if defined(PLATFORM_WINDOWS)
+            if ((nLength == 1) && (pData[0] == FILE_SEPARATOR_C))
+                return true;
+            return (is_absolute()) && (nLength <= 3) && (pData[0] != FILE_SEPARATOR_C) &&
+                ((nLength == 2) || (pData[2] == FILE_SEPARATOR_C));
+#else
+            return (nLength == 1) && (pData[0] == FILE_SEPARATOR_C);
+#endif
+        }
+
+        bool PathView::is_canonical() const
+        {
+            enum state_t
+            {
+                S_SEEK,
+                S_SEPARATOR,
+                S_DOT,
+                S_DOTDOT
+            };
+
+            if (is_root())
+                return true;
+
+            const lsp_wchar_t *p    = pData;
+            const lsp_wchar_t *e    = &p[nLength];
+            state_t state           = S_SEEK;
+
+            while (p < e)
+            {
+                lsp_wchar_t c   = *p++;
+
+                switch (state)
+                {
+                    case S_SEEK:
+                        if (c == FILE_SEPARATOR_C)
+                            state       = S_SEPARATOR;
+                        else if (c == '.')
+                            state       = S_DOT;
+                        break;
+                    case S_SEPARATOR:
+                        if (c == FILE_SEPARATOR_C)
+                            return false;
+                        else if (c == '.')
+                            state       = S_DOT;
+                        else
+                            state       = S_SEEK;
+                        break;
+                    case S_DOT:
+                        if (c == FILE_SEPARATOR_C)
+                            return false;
+                        else if (c == '.')
+                            state       = S_DOTDOT;
+                        else
+                            state       = S_SEEK;
+                        break;
+                    case S_DOTDOT:
+                        if (c == FILE_SEPARATOR_C)
+                            return false;
+                        else
+                            state       = S_SEEK;
+                        break;
+                }
+            }
+
+            return state == S_SEEK;
+        }
+
+        bool PathView::is_dot() const
+        {
+            if (nLength < 1)
+                return false;
+            else if (nLength == 1)
+                return pData[0] == '.';
+
+            return (pData[nLength-2] == FILE_SEPARATOR_C) &&
+                    (pData[nLength-1] == '.');
+        }
+
+        bool PathView::is_dotdot() const
+        {
+            if (nLength < 2)
+                return false;
+            else if (nLength == 2)
+                return (pData[0] == '.') &&
+                        (pData[1] == '.');
+
+            return (pData[nLength-3] == FILE_SEPARATOR_C) &&
+                    (pData[nLength-2] == '.') &&
+                    (pData[nLength-1] == '.');
+        }
+
+        bool PathView::is_dots() const
+        {
+            return is_dot() || is_dotdot();
+        }
+
+        bool PathView::equals(const PathView *path) const
+        {
+            if (path == NULL)
+                return false;
+            else if (nLength != path->nLength)
+                return false;
+            else if (nLength <= 0)
+                return true;
+
+            return ::memcmp(pData, path->pData, nLength * sizeof(lsp_wchar_t)) == 0;
+        }
+
+        bool PathView::equals(const LSPString *path) const
+        {
+            if (path == NULL)
+                return false;
+
+            PathView tmp(path);
+            return equals(&tmp);
+        }
+
+        bool PathView::equals(const Path *path) const
+        {
+            return (path != NULL) ? equals(path->as_string()) : false;
+        }
+
+        size_t PathView::hash() const
+        {
+            // Same as LSPString::hash() to allow lookups of Path objects by the view
+            size_t hash = 0;
+            for (size_t i=0; i<nLength; ++i)
+                hash = (hash * 0x10015) ^ pData[i];
+
+            return hash;
+        }
+    }
+}
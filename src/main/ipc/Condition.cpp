@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 27 мар. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/ipc/Condition.h>
+
+namespace lsp
+{
+    namespace ipc
+    {
+#if defined(PLATFORM_WINDOWS)
+        Condition::Condition()
+        {
+            InitializeCriticalSection(&sMutex);
+            InitializeConditionVariable(&sCond);
+        }
+
+        Condition::~Condition()
+        {
+            DeleteCriticalSection(&sMutex);
+        }
+
+        bool Condition::lock() const
+        {
+            EnterCriticalSection(&sMutex);
+            return true;
+        }
+
+        bool Condition::unlock() const
+        {
+            LeaveCriticalSection(&sMutex);
+            return true;
+        }
+
+        bool Condition::wait() const
+        {
+            return SleepConditionVariableCS(&sCond, &sMutex, INFINITE);
+        }
+
+        bool Condition::notify() const
+        {
+            WakeConditionVariable(&sCond);
+            return true;
+        }
+
+        bool Condition::notify_all() const
+        {
+            WakeAllConditionVariable(&sCond);
+            return true;
+        }
+#else
+        Condition::Condition()
+        {
+            pthread_mutex_init(&sMutex, NULL);
+            pthread_cond_init(&sCond, NULL);
+        }
+
+        Condition::~Condition()
+        {
+            pthread_cond_destroy(&sCond);
+            pthread_mutex_destroy(&sMutex);
+        }
+
+        bool Condition::lock() const
+        {
+            return pthread_mutex_lock(&sMutex) == 0;
+        }
+
+        bool Condition::unlock() const
+        {
+            return pthread_mutex_unlock(&sMutex) == 0;
+        }
+
+        bool Condition::wait() const
+        {
+            return pthread_cond_wait(&sCond, &sMutex) == 0;
+        }
+
+        bool Condition::notify() const
+        {
+            return pthread_cond_signal(&sCond) == 0;
+        }
+
+        bool Condition::notify_all() const
+        {
+            return pthread_cond_broadcast(&sCond) == 0;
+        }
+#endif /* PLATFORM_WINDOWS */
+
+    } /* namespace ipc */
+} /* namespace lsp */
@@ -127,16 +127,16 @@ namespace lsp
             while (!atomic_cas(&_this->enState, TS_PENDING, TS_RUNNING)) {}
 
             // Execute the thread
-            status_t res    = _this->run();
+            _this->nResult  = _this->run();
 
-            // Commit the 'FINISHED' status
+            // Commit the 'FINISHED' status, the thread object should not be
+            // accessed after that because it may be already destroyed
             int state;
             do
             {
                 state       = _this->enState;
             } while (!atomic_cas(&_this->enState, state, TS_FINISHED));
 
-            _this->nResult  = res;
             return 0;
         }
 
@@ -225,16 +225,16 @@ namespace lsp
             while (!atomic_cas(&_this->enState, TS_PENDING, TS_RUNNING)) {}
 
             // Execute the thread
-            status_t res    = _this->run();
+            _this->nResult  = _this->run();
 
-            // Commit the 'FINISHED' status
+            // Commit the 'FINISHED' status, the thread object should not be
+            // accessed after that because it may be already destroyed
             int state;
             do
             {
                 state       = _this->enState;
             } while (!atomic_cas(&_this->enState, state, TS_FINISHED));
 
-            _this->nResult  = res;
             return NULL;
         }
 
@@ -0,0 +1,362 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 3 апр. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/mm/AudioRecorder.h>
+#include <lsp-plug.in/common/alloc.h>
+#include <lsp-plug.in/stdlib/string.h>
+#include <private/mm/cvt.h>
+
+#include <stdlib.h>
+
+namespace lsp
+{
+    namespace mm
+    {
+        // The counters are monotonic and wrap around, the distance is computed in 32-bit arithmetic
+        static inline size_t distance(atomic_t head, atomic_t tail)
+        {
+            return uint32_t(uint32_t(head) - uint32_t(tail));
+        }
+
+        AudioRecorder::AudioRecorder()
+        {
+            pOut            = NULL;
+            nWrapFlags      = 0;
+            pThread         = NULL;
+            vData           = NULL;
+            nChannels       = 0;
+            nCapacity       = 0;
+            nPeriod         = DEFAULT_PERIOD;
+            nHead           = 0;
+            nTail           = 0;
+            bStop           = false;
+            nError          = STATUS_OK;
+
+            nProdSeq        = 0;
+            nConsSeq        = 0;
+            nWritten        = 0;
+            nDropped        = 0;
+            nOverflows      = 0;
+            nPeak           = 0;
+            nStored         = 0;
+        }
+
+        AudioRecorder::~AudioRecorder()
+        {
+            close();
+        }
+
+        void AudioRecorder::do_close()
+        {
+            if (pOut != NULL)
+            {
+                if (nWrapFlags & WRAP_CLOSE)
+                    pOut->close();
+                if (nWrapFlags & WRAP_DELETE)
+                    delete pOut;
+                pOut            = NULL;
+            }
+            nWrapFlags      = 0;
+
+            if (vData != NULL)
+            {
+                ::free(vData);
+                vData           = NULL;
+            }
+
+            nChannels       = 0;
+            nCapacity       = 0;
+            nHead           = 0;
+            nTail           = 0;
+            bStop           = false;
+            nError          = STATUS_OK;
+        }
+
+        status_t AudioRecorder::open(IOutAudioStream *os, size_t capacity, size_t flags)
+        {
+            if (vData != NULL)
+                return STATUS_OPENED;
+            if ((os == NULL) || (capacity <= 0) || (capacity > MAX_CAPACITY))
+                return STATUS_BAD_ARGUMENTS;
+            if (os->is_closed())
+                return STATUS_CLOSED;
+
+            size_t channels = os->channels();
+            if (channels <= 0)
+                return STATUS_BAD_FORMAT;
+
+            // Round the capacity up to the power of 2
+            size_t cap      = 1;
+            while (cap < capacity)
+                cap           <<= 1;
+
+            f32_t *data     = static_cast<f32_t *>(::malloc(cap * channels * sizeof(f32_t)));
+            if (data == NULL)
+                return STATUS_NO_MEM;
+            // Touch the memory to avoid page faults in the realtime thread
+            ::memset(data, 0, cap * channels * sizeof(f32_t));
+
+            pOut            = os;
+            nWrapFlags      = flags;
+            vData           = data;
+            nChannels       = channels;
+            nCapacity       = cap;
+            nHead           = 0;
+            nTail           = 0;
+            bStop           = false;
+            nError          = STATUS_OK;
+
+            nProdSeq        = 0;
+            nConsSeq        = 0;
+            nWritten        = 0;
+            nDropped        = 0;
+            nOverflows      = 0;
+            nPeak           = 0;
+            nStored         = 0;
+
+            return STATUS_OK;
+        }
+
+        status_t AudioRecorder::start()
+        {
+            if (vData == NULL)
+                return STATUS_CLOSED;
+            if (pThread != NULL)
+                return STATUS_BAD_STATE;
+
+            ipc::Thread *t  = new ipc::Thread(writer_proc, this);
+            if (t == NULL)
+                return STATUS_NO_MEM;
+
+            bStop           = false;
+            status_t res    = t->start();
+            if (res != STATUS_OK)
+            {
+                delete t;
+                return res;
+            }
+
+            pThread         = t;
+            return STATUS_OK;
+        }
+
+        status_t AudioRecorder::stop()
+        {
+            if (vData == NULL)
+                return STATUS_CLOSED;
+            if (pThread == NULL)
+                return STATUS_BAD_STATE;
+
+            // The writer thread drains the buffer before leaving
+            bStop           = true;
+            status_t res    = pThread->join();
+            delete pThread;
+            pThread         = NULL;
+            bStop           = false;
+
+            if (res == STATUS_OK)
+                res             = nError;
+            if (res == STATUS_OK)
+                res             = pOut->flush();
+            return res;
+        }
+
+        status_t AudioRecorder::close()
+        {
+            if (vData == NULL)
+                return STATUS_OK;
+
+            status_t res    = (pThread != NULL) ? stop() : STATUS_OK;
+            if ((pOut != NULL) && (nWrapFlags & WRAP_CLOSE))
+            {
+                status_t xr     = pOut->close();
+                if (res == STATUS_OK)
+                    res             = xr;
+                nWrapFlags     &= ~size_t(WRAP_CLOSE);
+            }
+
+            do_close();
+            return res;
+        }
+
+        status_t AudioRecorder::writer_proc(void *arg)
+        {
+            AudioRecorder *self = static_cast<AudioRecorder *>(arg);
+            return self->run();
+        }
+
+        status_t AudioRecorder::run()
+        {
+            while (true)
+            {
+                // Read the flag before draining: all frames written before the stop request
+                // will be drained before the thread leaves
+                bool stop       = bStop;
+                if (drain() > 0)
+                    continue;
+                if (stop)
+                    break;
+
+                ipc::Thread::sleep(nPeriod);
+            }
+
+            return STATUS_OK;
+        }
+
+        size_t AudioRecorder::drain()
+        {
+            atomic_t tail   = atomic_add(&nTail, 0);
+            size_t avail    = distance(atomic_add(&nHead, 0), tail);
+            size_t done     = 0;
+
+            while (done < avail)
+            {
+                size_t off      = uint32_t(tail + done) & (nCapacity - 1);
+                size_t count    = lsp_min(avail - done, nCapacity - off);
+
+                // After the error the frames are discarded to keep the producer running
+                if (nError == STATUS_OK)
+                {
+                    ssize_t n       = pOut->write(&vData[off * nChannels], count);
+
+                    atomic_add(&nConsSeq, 1);
+                    if (n > 0)
+                    {
+                        count           = n;
+                        nStored        += count;
+                    }
+                    else
+                        nError          = (n < 0) ? status_t(-n) : STATUS_IO_ERROR;
+                    atomic_add(&nConsSeq, 1);
+                }
+
+                // Release the space after the data has been written
+                atomic_add(&nTail, atomic_t(count));
+                done           += count;
+            }
+
+            return done;
+        }
+
+        void AudioRecorder::commit(size_t fill, size_t written, size_t frames)
+        {
+            // Publish the data after it has been stored
+            atomic_add(&nHead, atomic_t(written));
+
+            // Statistics are published with the odd sequence number while being updated
+            atomic_add(&nProdSeq, 1);
+            nWritten       += written;
+            if (written < frames)
+            {
+                nDropped       += frames - written;
+                ++nOverflows;
+            }
+            fill           += written;
+            if (fill > nPeak)
+                nPeak           = fill;
+            atomic_add(&nProdSeq, 1);
+        }
+
+        ssize_t AudioRecorder::write(const f32_t *src, size_t frames)
+        {
+            if (vData == NULL)
+                return -STATUS_CLOSED;
+            if (src == NULL)
+                return -STATUS_BAD_ARGUMENTS;
+
+            atomic_t head   = atomic_add(&nHead, 0);
+            size_t fill     = distance(head, atomic_add(&nTail, 0));
+            size_t count    = lsp_min(frames, nCapacity - fill);
+            size_t off      = uint32_t(head) & (nCapacity - 1);
+            size_t first    = lsp_min(count, nCapacity - off);
+
+            ::memcpy(&vData[off * nChannels], src, first * nChannels * sizeof(f32_t));
+            if (count > first)
+                ::memcpy(vData, &src[first * nChannels], (count - first) * nChannels * sizeof(f32_t));
+
+            commit(fill, count, frames);
+            return count;
+        }
+
+        ssize_t AudioRecorder::write_planar(const f32_t * const *src, size_t frames)
+        {
+            if (vData == NULL)
+                return -STATUS_CLOSED;
+            if (src == NULL)
+                return -STATUS_BAD_ARGUMENTS;
+
+            const cvt_kernels_t *k  = cvt_kernels();
+            atomic_t head   = atomic_add(&nHead, 0);
+            size_t fill     = distance(head, atomic_add(&nTail, 0));
+            size_t count    = lsp_min(frames, nCapacity - fill);
+            size_t off      = uint32_t(head) & (nCapacity - 1);
+            size_t first    = lsp_min(count, nCapacity - off);
+
+            k->f32_planar_to_f32(&vData[off * nChannels], src, 0, nChannels, first);
+            if (count > first)
+                k->f32_planar_to_f32(vData, src, first, nChannels, count - first);
+
+            commit(fill, count, frames);
+            return count;
+        }
+
+        void AudioRecorder::get_stats(stats_t *dst) const
+        {
+            if (dst == NULL)
+                return;
+
+            // Retry reading until the consistent snapshot of each group of counters is obtained
+            atomic_t *seq   = const_cast<atomic_t *>(&nProdSeq);
+            for (atomic_t first = atomic_add(seq, 0); ; )
+            {
+                dst->written    = nWritten;
+                dst->dropped    = nDropped;
+                dst->overflows  = nOverflows;
+                dst->peak       = nPeak;
+
+                atomic_t last   = atomic_add(seq, 0);
+                if ((first == last) && (!(first & 1)))
+                    break;
+                first           = last;
+            }
+
+            seq             = const_cast<atomic_t *>(&nConsSeq);
+            for (atomic_t first = atomic_add(seq, 0); ; )
+            {
+                dst->stored     = nStored;
+                dst->error      = nError;
+
+                atomic_t last   = atomic_add(seq, 0);
+                if ((first == last) && (!(first & 1)))
+                    break;
+                first           = last;
+            }
+
+            dst->capacity   = nCapacity;
+        }
+
+        void AudioRecorder::set_period(size_t millis)
+        {
+            nPeriod         = lsp_max(millis, size_t(1));
+        }
+
+    } /* namespace mm */
+} /* namespace lsp */
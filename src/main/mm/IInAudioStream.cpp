@@ -22,6 +22,7 @@
 #include <lsp-plug.in/mm/IInAudioStream.h>
 #include <lsp-plug.in/mm/sample.h>
 #include <lsp-plug.in/common/alloc.h>
+#include <private/mm/cvt.h>
 #include <stdlib.h>
 
 namespace lsp
@@ -95,17 +96,18 @@ namespace lsp
                     return -set_error(STATUS_NO_MEM);
 
                 // Perform read
-                ssize_t read        = direct_read(pBuffer, to_read, 0);
+                ssize_t read        = direct_read(pBuffer, to_read, afmt);
                 if (read < 0)
                 {
                     if (nread > 0)
                         break;
-                    set_error(-nread);
-                    return nread;
+                    set_error(-read);
+                    return read;
                 }
 
                 // Update position
                 nframes    -= read;
+                nread      += read;
             } while (nframes > 0);
 
             // Update statistics
@@ -276,5 +278,73 @@ namespace lsp
             return conv_read(dst, nframes, SFMT_F64 | SFMT_CPU);
         }
 
+        ssize_t IInAudioStream::read_planar(f32_t * const *dst, size_t nframes)
+        {
+            if (nOffset < 0)
+                return -set_error(STATUS_CLOSED);
+            else if (dst == NULL)
+                return -set_error(STATUS_BAD_ARGUMENTS);
+
+            size_t channels = sFormat.channels;
+            if ((channels == 1) && (dst[0] != NULL))
+                return read(dst[0], nframes);
+
+            size_t afmt     = select_format(SFMT_F32_CPU);
+            size_t asize    = sformat_size_of(afmt) * channels;
+            if (asize <= 0)
+                return -set_error(STATUS_UNSUPPORTED_FORMAT);
+
+            // Formats that can be converted and de-interleaved at one pass
+            const cvt_kernels_t *k      = cvt_kernels();
+            cvt_deinterleave_t unpack   = NULL;
+            if (afmt == SFMT_F32_CPU)
+                unpack      = k->f32_to_f32_planar;
+            else if (afmt == SFMT_S16_CPU)
+                unpack      = k->s16_to_f32_planar;
+
+            // Other formats are converted to interleaved 32-bit floating-point samples first
+            size_t fsize    = (unpack != NULL) ? 0 : sizeof(f32_t) * channels;
+            size_t nread    = 0;
+
+            while (nframes > 0)
+            {
+                // Ensure capacity, the buffer layout is: [converted samples | raw samples]
+                size_t to_read      = (nframes > IO_BUF_SIZE) ? IO_BUF_SIZE : nframes;
+                size_t ftotal       = align_size(to_read * fsize, DEFAULT_ALIGN);
+                if (!ensure_capacity(ftotal + to_read * asize))
+                    return -set_error(STATUS_NO_MEM);
+
+                // Perform direct read
+                uint8_t *abuf       = &pBuffer[ftotal];
+                ssize_t read        = direct_read(abuf, to_read, afmt);
+                if (read < 0)
+                {
+                    if (nread > 0)
+                        break;
+                    set_error(-read);
+                    return read;
+                }
+
+                // Perform sample conversion
+                if (unpack != NULL)
+                    unpack(dst, nread, abuf, channels, read);
+                else
+                {
+                    if (!convert_samples(pBuffer, abuf, read * channels, SFMT_F32_CPU, afmt))
+                        return -set_error(STATUS_UNSUPPORTED_FORMAT);
+                    k->f32_to_f32_planar(dst, nread, pBuffer, channels, read);
+                }
+
+                // Update position
+                nframes    -= read;
+                nread      += read;
+            }
+
+            // Update statistics
+            set_error(STATUS_OK);
+            nOffset    += nread;
+            return nread;
+        }
+
     } /* namespace mm */
 } /* namespace lsp */
@@ -23,6 +23,7 @@
 #include <lsp-plug.in/mm/sample.h>
 #include <lsp-plug.in/common/alloc.h>
 #include <lsp-plug.in/stdlib/string.h>
+#include <private/mm/cvt.h>
 #include <stdlib.h>
 
 namespace lsp
@@ -40,6 +41,7 @@ namespace lsp
             sFormat.channels    = 0;
             sFormat.frames      = -1;
             sFormat.format      = SFMT_NONE;
+            nQuantize           = QUANTIZE_TRUNCATE;
         }
         
         IOutAudioStream::~IOutAudioStream()
@@ -79,6 +81,15 @@ namespace lsp
             return -STATUS_NOT_IMPLEMENTED;
         }
 
+        bool IOutAudioStream::encode_samples(void *qbuf, void *src, size_t samples, size_t afmt, size_t qfmt, size_t rfmt)
+        {
+            if (qfmt == SFMT_NONE)
+                return convert_samples(pBuffer, src, samples, afmt, rfmt, nQuantize);
+
+            return (convert_samples(qbuf, src, samples, qfmt, rfmt, nQuantize)) &&
+                   (convert_samples(pBuffer, qbuf, samples, afmt, qfmt));
+        }
+
         ssize_t IOutAudioStream::conv_write(const void *src, size_t nframes, size_t fmt)
         {
             if (nOffset < 0)
@@ -93,6 +104,11 @@ namespace lsp
             if (fsize <= 0)
                 return -set_error(STATUS_UNSUPPORTED_FORMAT);
 
+            // When the actual format is wider than the integer format of the stream,
+            // quantize samples to the format of the stream first
+            size_t qfmt     = select_quantize_format(afmt, fmt);
+            size_t qsize    = (qfmt != SFMT_NONE) ? sformat_size_of(qfmt) * sFormat.channels : 0;
+
             // Perform conversion loop
             const uint8_t *sptr = static_cast<const uint8_t *>(src);
             size_t nwritten = 0;
@@ -100,19 +116,30 @@ namespace lsp
             while (nframes > 0)
             {
                 size_t to_write = (nframes > IO_BUF_SIZE) ? IO_BUF_SIZE : nframes;
+                size_t samples  = to_write * sFormat.channels;
 
                 // Need to perform encoding?
                 if (afmt != fmt)
                 {
+                    // Samples in CPU byte order are not modified by the conversion,
+                    // so there is no need to copy them to the temporary buffer
+                    bool native   = sformat_endian(fmt) == SFMT_CPU;
+
                     // Check that we have enough place
                     size_t atotal = to_write * fsize;
-                    size_t rtotal = to_write * rsize;
-                    if (!ensure_capacity(to_write * (fsize + rsize)))
+                    size_t qtotal = to_write * qsize;
+                    size_t rtotal = (native) ? 0 : to_write * rsize;
+                    if (!ensure_capacity(atotal + qtotal + rtotal))
                         return -set_error(STATUS_NO_MEM);
 
                     // Perform conversion
-                    ::memcpy(&pBuffer[atotal], src, rtotal);
-                    if (!convert_samples(pBuffer, &pBuffer[atotal], to_write * sFormat.channels, afmt, fmt))
+                    uint8_t *rbuf = const_cast<uint8_t *>(sptr);
+                    if (!native)
+                    {
+                        rbuf            = &pBuffer[atotal + qtotal];
+                        ::memcpy(rbuf, sptr, rtotal);
+                    }
+                    if (!encode_samples(&pBuffer[atotal], rbuf, samples, afmt, qfmt, fmt))
                         return -set_error(STATUS_UNSUPPORTED_FORMAT);
                     src = pBuffer;
                 }
@@ -132,7 +159,7 @@ namespace lsp
                 // Update pointers
                 nwritten   += written;
                 nframes    -= written;
-                sptr       += fsize * written;
+                sptr       += rsize * written;
             }
 
             set_error(STATUS_OK);
@@ -140,11 +167,70 @@ namespace lsp
             return nwritten;
         }
 
+        size_t IOutAudioStream::select_quantize_format(size_t afmt, size_t rfmt)
+        {
+            if (nQuantize == QUANTIZE_TRUNCATE)
+                return SFMT_NONE;
+
+            // Source samples should be floating-point, target samples should be integer
+            switch (sformat_format(rfmt))
+            {
+                case SFMT_F32: case SFMT_F64: break;
+                default: return SFMT_NONE;
+            }
+
+            size_t qfmt = sformat_format(sFormat.format);
+            switch (qfmt)
+            {
+                case SFMT_U8: case SFMT_S8:
+                case SFMT_U16: case SFMT_S16:
+                case SFMT_U24: case SFMT_S24:
+                    break;
+                default:
+                    return SFMT_NONE;
+            }
+
+            // The intermediate format is required only if the actual format is wider
+            switch (sformat_format(afmt))
+            {
+                case SFMT_U16: case SFMT_S16:
+                    if ((qfmt != SFMT_U8) && (qfmt != SFMT_S8))
+                        return SFMT_NONE;
+                    break;
+                case SFMT_U24: case SFMT_S24:
+                    if ((qfmt != SFMT_U8) && (qfmt != SFMT_S8) && (qfmt != SFMT_U16) && (qfmt != SFMT_S16))
+                        return SFMT_NONE;
+                    break;
+                case SFMT_U32: case SFMT_S32:
+                    break;
+                default:
+                    return SFMT_NONE;
+            }
+
+            return qfmt | SFMT_CPU;
+        }
+
         size_t IOutAudioStream::select_format(size_t rfmt)
         {
             return 0;
         }
 
+        status_t IOutAudioStream::set_quantize(size_t mode)
+        {
+            switch (mode)
+            {
+                case QUANTIZE_TRUNCATE:
+                case QUANTIZE_ROUND:
+                case QUANTIZE_DITHER:
+                    nQuantize   = mode;
+                    return set_error(STATUS_OK);
+                default:
+                    break;
+            }
+
+            return set_error(STATUS_BAD_ARGUMENTS);
+        }
+
         status_t IOutAudioStream::info(audio_stream_t *dst) const
         {
             if (dst == NULL)
@@ -213,5 +299,78 @@ namespace lsp
         {
             return conv_write(dst, nframes, SFMT_F64 | SFMT_CPU);
         }
+
+        ssize_t IOutAudioStream::write_planar(const f32_t * const *src, size_t nframes)
+        {
+            if (nOffset < 0)
+                return -set_error(STATUS_CLOSED);
+            else if (src == NULL)
+                return -set_error(STATUS_BAD_ARGUMENTS);
+
+            size_t channels = sFormat.channels;
+            if ((channels == 1) && (src[0] != NULL))
+                return write(src[0], nframes);
+
+            size_t afmt     = select_format(SFMT_F32_CPU);
+            size_t fsize    = sformat_size_of(afmt) * channels;
+            if (fsize <= 0)
+                return -set_error(STATUS_UNSUPPORTED_FORMAT);
+
+            // Formats that can be interleaved and converted at one pass
+            const cvt_kernels_t *k      = cvt_kernels();
+            cvt_interleave_t pack       = NULL;
+            if (afmt == SFMT_F32_CPU)
+                pack        = k->f32_planar_to_f32;
+            else if ((afmt == SFMT_S16_CPU) && (nQuantize == QUANTIZE_TRUNCATE))
+                pack        = k->f32_planar_to_s16;
+
+            // Other formats are interleaved to 32-bit floating-point samples first
+            size_t qfmt     = (pack != NULL) ? SFMT_NONE : select_quantize_format(afmt, SFMT_F32_CPU);
+            size_t qsize    = (qfmt != SFMT_NONE) ? sformat_size_of(qfmt) * channels : 0;
+            size_t rsize    = (pack != NULL) ? 0 : sizeof(f32_t) * channels;
+            size_t nwritten = 0;
+
+            while (nframes > 0)
+            {
+                size_t to_write = (nframes > IO_BUF_SIZE) ? IO_BUF_SIZE : nframes;
+                size_t samples  = to_write * channels;
+
+                // Check that we have enough place, the buffer layout is the same to conv_write()
+                size_t atotal = to_write * fsize;
+                size_t qtotal = align_size(atotal + to_write * qsize, DEFAULT_ALIGN);
+                size_t rtotal = to_write * rsize;
+                if (!ensure_capacity(qtotal + rtotal))
+                    return -set_error(STATUS_NO_MEM);
+
+                // Perform conversion
+                if (pack != NULL)
+                    pack(pBuffer, src, nwritten, channels, to_write);
+                else
+                {
+                    uint8_t *rbuf = &pBuffer[qtotal];
+                    k->f32_planar_to_f32(rbuf, src, nwritten, channels, to_write);
+                    if (!encode_samples(&pBuffer[atotal], rbuf, samples, afmt, qfmt, SFMT_F32_CPU))
+                        return -set_error(STATUS_UNSUPPORTED_FORMAT);
+                }
+
+                // Call direct write
+                ssize_t written = direct_write(pBuffer, to_write, afmt);
+                if (written < 0)
+                {
+                    if (nwritten > 0)
+                        break;
+                    set_error(-written);
+                    return written;
+                }
+
+                // Update position
+                nwritten   += written;
+                nframes    -= written;
+            }
+
+            set_error(STATUS_OK);
+            nOffset    += nwritten;
+            return nwritten;
+        }
     } /* namespace mm */
 } /* namespace lsp */
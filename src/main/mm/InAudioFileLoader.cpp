@@ -0,0 +1,368 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 31 мар. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/mm/InAudioFileLoader.h>
+#include <lsp-plug.in/mm/InAudioFileStream.h>
+#include <lsp-plug.in/ipc/Thread.h>
+#include <lsp-plug.in/ipc/Condition.h>
+
+namespace lsp
+{
+    namespace mm
+    {
+        /**
+         * State of the load() call. Segments are taken by workers in ascending order,
+         * all fields except constant parameters are protected by sCond
+         */
+        struct InAudioFileLoader::task_t
+        {
+            ipc::Condition      sCond;          // Synchronization primitive
+            const LSPString    *pPath;          // Path to the file
+            uint8_t            *pDst;           // Destination buffer
+            size_t              nFormat;        // Destination sample format
+            size_t              nFrameSize;     // Size of destination frame in bytes
+            wsize_t             nFirst;         // First frame to load
+            wsize_t             nCount;         // Number of frames to load
+            wsize_t             nSegment;       // Number of frames per segment
+            wsize_t             nNext;          // Offset of the next segment to load
+            wsize_t             nLoaded;        // Number of frames loaded
+            size_t              nActive;        // Number of active workers
+            status_t            nError;         // Error code
+
+            explicit task_t()
+            {
+                pPath           = NULL;
+                pDst            = NULL;
+                nFormat         = SFMT_NONE;
+                nFrameSize      = 0;
+                nFirst          = 0;
+                nCount          = 0;
+                nSegment        = 0;
+                nNext           = 0;
+                nLoaded         = 0;
+                nActive         = 0;
+                nError          = STATUS_OK;
+            }
+        };
+
+        struct InAudioFileLoader::worker_t
+        {
+            ipc::Thread         sThread;        // Worker thread
+            task_t             *pTask;          // Task to process
+
+            explicit worker_t(): sThread(worker_proc, this)
+            {
+                pTask           = NULL;
+            }
+        };
+
+        static ssize_t read_frames(IInAudioStream *is, void *dst, size_t nframes, size_t fmt)
+        {
+            switch (sformat_format(fmt))
+            {
+                case SFMT_U8:   return is->read_u8(dst, nframes);
+                case SFMT_S8:   return is->read_s8(dst, nframes);
+                case SFMT_U16:  return is->read_u16(dst, nframes);
+                case SFMT_S16:  return is->read_s16(dst, nframes);
+                case SFMT_U32:  return is->read_u32(dst, nframes);
+                case SFMT_S32:  return is->read_s32(dst, nframes);
+                case SFMT_F32:  return is->read_f32(dst, nframes);
+                case SFMT_F64:  return is->read_f64(dst, nframes);
+                default: break;
+            }
+            return -STATUS_UNSUPPORTED_FORMAT;
+        }
+
+        static status_t load_segment(InAudioFileStream *is, uint8_t *dst, size_t fmt, size_t fsize,
+            wsize_t first, wsize_t count)
+        {
+            wssize_t pos    = is->seek(first);
+            if (pos < 0)
+                return status_t(-pos);
+            else if (pos != wssize_t(first))
+                return STATUS_IO_ERROR;
+
+            while (count > 0)
+            {
+                ssize_t n       = read_frames(is, dst, count, fmt);
+                if (n < 0)
+                    return (n == -STATUS_EOF) ? STATUS_CORRUPTED_FILE : status_t(-n);
+                else if (n == 0)
+                    return STATUS_CORRUPTED_FILE;
+
+                dst            += n * fsize;
+                count          -= n;
+            }
+
+            return STATUS_OK;
+        }
+
+        status_t InAudioFileLoader::worker_proc(void *arg)
+        {
+            worker_t *w     = static_cast<worker_t *>(arg);
+            task_t *t       = w->pTask;
+
+            // Each worker decodes the file with its own stream. The path is copied
+            // because LSPString caches the native representation of the string
+            LSPString path;
+            InAudioFileStream is;
+            status_t res    = (path.set(t->pPath)) ? is.open(&path) : STATUS_NO_MEM;
+
+            t->sCond.lock();
+            if ((res != STATUS_OK) && (t->nError == STATUS_OK))
+                t->nError       = res;
+
+            while ((t->nError == STATUS_OK) && (t->nNext < t->nCount))
+            {
+                // Take the next segment and load it outside of the critical section
+                wsize_t offset  = t->nNext;
+                wsize_t count   = lsp_min(t->nSegment, t->nCount - offset);
+                t->nNext       += count;
+                t->sCond.unlock();
+
+                res             = load_segment(&is, &t->pDst[offset * t->nFrameSize], t->nFormat,
+                                                t->nFrameSize, t->nFirst + offset, count);
+
+                t->sCond.lock();
+                if (res == STATUS_OK)
+                    t->nLoaded     += count;
+                else if (t->nError == STATUS_OK)
+                    t->nError       = res;
+                t->sCond.notify_all();
+            }
+
+            --t->nActive;
+            t->sCond.notify_all();
+            t->sCond.unlock();
+
+            is.close();
+
+            return STATUS_OK;
+        }
+
+        InAudioFileLoader::InAudioFileLoader()
+        {
+            sFormat.srate       = 0;
+            sFormat.channels    = 0;
+            sFormat.frames      = 0;
+            sFormat.format      = SFMT_NONE;
+            bSeekable           = false;
+            bOpened             = false;
+            nThreads            = 0;
+        }
+
+        InAudioFileLoader::~InAudioFileLoader()
+        {
+            close();
+        }
+
+        status_t InAudioFileLoader::open(const char *path)
+        {
+            if (path == NULL)
+                return STATUS_BAD_ARGUMENTS;
+            LSPString xpath;
+            if (!xpath.set_utf8(path))
+                return STATUS_NO_MEM;
+            return open(&xpath);
+        }
+
+        status_t InAudioFileLoader::open(const io::Path *path)
+        {
+            if (path == NULL)
+                return STATUS_BAD_ARGUMENTS;
+            return open(path->as_string());
+        }
+
+        status_t InAudioFileLoader::open(const LSPString *path)
+        {
+            if (path == NULL)
+                return STATUS_BAD_ARGUMENTS;
+            if (bOpened)
+                return STATUS_OPENED;
+
+            // Obtain the format of the file, the stream is not needed anymore
+            InAudioFileStream is;
+            status_t res        = is.open(path);
+            if (res != STATUS_OK)
+                return res;
+
+            res                 = is.info(&sFormat);
+            bSeekable           = is.is_seekable();
+            is.close();
+            if (res != STATUS_OK)
+                return res;
+
+            if (!sPath.set(path))
+                return STATUS_NO_MEM;
+            bOpened             = true;
+
+            return STATUS_OK;
+        }
+
+        status_t InAudioFileLoader::close()
+        {
+            sPath.truncate();
+            sFormat.srate       = 0;
+            sFormat.channels    = 0;
+            sFormat.frames      = 0;
+            sFormat.format      = SFMT_NONE;
+            bSeekable           = false;
+            bOpened             = false;
+
+            return STATUS_OK;
+        }
+
+        status_t InAudioFileLoader::info(audio_stream_t *dst) const
+        {
+            if (dst == NULL)
+                return STATUS_BAD_ARGUMENTS;
+            if (!bOpened)
+                return STATUS_CLOSED;
+
+            *dst                = sFormat;
+            return STATUS_OK;
+        }
+
+        wssize_t InAudioFileLoader::load(void *dst, size_t fmt, wsize_t first, wsize_t count,
+                                         progress_t progress, void *arg)
+        {
+            if (!bOpened)
+                return -STATUS_CLOSED;
+            if (dst == NULL)
+                return -STATUS_BAD_ARGUMENTS;
+
+            // Only formats with CPU byte order supported by IInAudioStream::read() are allowed
+            size_t endian       = sformat_endian(fmt);
+            size_t format       = sformat_format(fmt);
+            if (((endian != SFMT_DFL) && (endian != SFMT_CPU)) ||
+                (format == SFMT_U24) || (format == SFMT_S24) ||
+                (sformat_size_of(format) <= 0))
+                return -STATUS_UNSUPPORTED_FORMAT;
+
+            // Limit the range with the length of the file
+            if (sFormat.frames >= 0)
+            {
+                wsize_t length      = sFormat.frames;
+                first               = lsp_min(first, length);
+                count               = lsp_min(count, length - first);
+            }
+            if (count <= 0)
+                return 0;
+
+            // Compute the size of segment and number of threads
+            size_t threads      = (nThreads > 0) ? nThreads : ipc::Thread::system_cores();
+            if ((!bSeekable) || (threads <= 0))
+                threads             = 1;
+            wsize_t segment     = count / (threads * 4);
+            segment             = lsp_limit(segment, wsize_t(MIN_SEGMENT), wsize_t(MAX_SEGMENT));
+            threads             = lsp_min(wsize_t(threads), (count + segment - 1) / segment);
+
+            task_t t;
+            t.pPath             = &sPath;
+            t.pDst              = static_cast<uint8_t *>(dst);
+            t.nFormat           = format;
+            t.nFrameSize        = sformat_size_of(format) * sFormat.channels;
+            t.nFirst            = first;
+            t.nCount            = count;
+            t.nSegment          = segment;
+
+            // Single thread: load segments by the caller's thread
+            if (threads <= 1)
+            {
+                InAudioFileStream is;
+                status_t res        = is.open(&sPath);
+                while ((res == STATUS_OK) && (t.nLoaded < count))
+                {
+                    wsize_t n           = lsp_min(segment, count - t.nLoaded);
+                    res                 = load_segment(&is, &t.pDst[t.nLoaded * t.nFrameSize], t.nFormat,
+                                                       t.nFrameSize, first + t.nLoaded, n);
+                    if (res != STATUS_OK)
+                        break;
+                    t.nLoaded          += n;
+                    if (progress != NULL)
+                        res                 = progress(t.nLoaded, count, arg);
+                }
+                is.close();
+
+                return (res == STATUS_OK) ? wssize_t(count) : -res;
+            }
+
+            // Launch workers
+            worker_t *workers   = new worker_t[threads];
+            if (workers == NULL)
+                return -STATUS_NO_MEM;
+
+            size_t started      = 0;
+            status_t res        = STATUS_OK;
+            t.sCond.lock();
+            for ( ; started < threads; ++started)
+            {
+                workers[started].pTask  = &t;
+                if ((res = workers[started].sThread.start()) != STATUS_OK)
+                    break;
+                ++t.nActive;
+            }
+            if ((res != STATUS_OK) && (started <= 0))
+            {
+                t.sCond.unlock();
+                delete [] workers;
+                return -res;
+            }
+
+            // Report progress until all workers finish
+            wsize_t reported    = 0;
+            while (t.nActive > 0)
+            {
+                if ((progress != NULL) && (t.nLoaded != reported) && (t.nError == STATUS_OK))
+                {
+                    reported            = t.nLoaded;
+                    t.sCond.unlock();
+                    res                 = progress(reported, count, arg);
+                    t.sCond.lock();
+                    if ((res != STATUS_OK) && (t.nError == STATUS_OK))
+                        t.nError            = res;
+                }
+                else
+                    t.sCond.wait();
+            }
+
+            if ((progress != NULL) && (t.nLoaded != reported) && (t.nError == STATUS_OK))
+            {
+                reported            = t.nLoaded;
+                t.sCond.unlock();
+                res                 = progress(reported, count, arg);
+                t.sCond.lock();
+                if ((res != STATUS_OK) && (t.nError == STATUS_OK))
+                    t.nError            = res;
+            }
+            res                 = t.nError;
+            t.sCond.unlock();
+
+            // Wait for threads and release resources
+            for (size_t i=0; i<started; ++i)
+                workers[i].sThread.join();
+            delete [] workers;
+
+            return (res == STATUS_OK) ? wssize_t(count) : -res;
+        }
+
+    } /* namespace mm */
+} /* namespace lsp */
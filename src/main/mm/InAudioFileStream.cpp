@@ -25,8 +25,10 @@
 #include <lsp-plug.in/common/debug.h>
 #include <lsp-plug.in/stdlib/stdio.h>
 #include <lsp-plug.in/lltl/parray.h>
+#include <lsp-plug.in/mm/sample.h>
 #include <private/mm/ACMStream.h>
 #include <private/mm/MMIOReader.h>
+#include <private/mm/RIFFReader.h>
 
 #ifdef USE_LIBSNDFILE
     #if (__SIZEOF_INT__ == 4)
@@ -54,6 +56,7 @@ namespace lsp
             pACM        = NULL;
             pFormat     = NULL;
         #endif /* USE_LIBSNDFILE */
+            pRIFF       = NULL;
             bSeekable   = false;
         }
         
@@ -65,6 +68,17 @@ namespace lsp
 
         status_t InAudioFileStream::close_handle()
         {
+            if (pRIFF != NULL)
+            {
+                pRIFF->close();
+                delete pRIFF;
+                pRIFF       = NULL;
+                bSeekable   = false;
+                nOffset     = -1;       // Mark as closed
+
+                return set_error(STATUS_OK);
+            }
+
         #ifdef USE_LIBSNDFILE
             if (hHandle == NULL)
                 return STATUS_OK;
@@ -214,11 +228,51 @@ namespace lsp
             return open(path->as_string());
         }
 
+        status_t InAudioFileStream::open_riff(const LSPString *path)
+        {
+            RIFFReader *riff    = new RIFFReader();
+            if (riff == NULL)
+                return STATUS_NO_MEM;
+
+            status_t res        = riff->open(path);
+            if (res != STATUS_OK)
+            {
+                delete riff;
+                return res;
+            }
+
+            // Commit new state
+            pRIFF               = riff;
+            sFormat.srate       = riff->sample_rate();
+            sFormat.channels    = riff->channels();
+            sFormat.frames      = riff->frames();
+            sFormat.format      = riff->format();
+            nOffset             = 0;
+            bSeekable           = true;
+
+            return STATUS_OK;
+        }
+
         status_t InAudioFileStream::open(const LSPString *path)
         {
             if (!is_closed())
                 return -set_error(STATUS_OPENED);
 
+            // PCM and floating-point WAV files are read without additional libraries,
+            // other files are passed to the platform-specific implementation
+            status_t res        = open_riff(path);
+            switch (res)
+            {
+                case STATUS_OK:
+                    return set_error(STATUS_OK);
+                case STATUS_BAD_FORMAT:
+                case STATUS_UNSUPPORTED_FORMAT:
+                case STATUS_CORRUPTED_FILE:
+                    break;
+                default:
+                    return set_error(res);
+            }
+
         #ifdef USE_LIBSNDFILE
             SF_INFO info;
             SNDFILE *sf;
@@ -252,7 +306,7 @@ namespace lsp
 
             return set_error(STATUS_OK);
         #else
-            status_t res        = STATUS_OK;
+            res                 = STATUS_OK;
 
             // Try to load data using MMIO
             MMIOReader *mmio    = new MMIOReader();
@@ -337,6 +391,10 @@ namespace lsp
 
         size_t InAudioFileStream::select_format(size_t fmt)
         {
+            // Samples of WAV files are provided in their native format
+            if (pRIFF != NULL)
+                return sFormat.format;
+
         #ifdef USE_LIBSNDFILE
             // libsndfile allows to do some sample conversions internally
             // we trust it more than our own sample converison routines
@@ -377,6 +435,13 @@ namespace lsp
 
         ssize_t InAudioFileStream::direct_read(void *dst, size_t nframes, size_t fmt)
         {
+            if (pRIFF != NULL)
+            {
+                size_t fsize    = pRIFF->frame_size();
+                ssize_t nread   = pRIFF->read(dst, fsize * nframes);
+                return (nread < 0) ? nread : nread / fsize;
+            }
+
         #ifdef USE_LIBSNDFILE
             sf_count_t count;
             status_t res;
@@ -425,10 +490,58 @@ namespace lsp
         #endif /* USE_LIBSNDFILE */
         }
 
+        ssize_t InAudioFileStream::conv_read(void *dst, size_t nframes, size_t fmt)
+        {
+            // Samples of memory-mapped WAV files are converted without intermediate copying,
+            // the source data stays untouched if it is stored in the CPU byte order
+            if ((pRIFF == NULL) || (!pRIFF->mapped()) || (sformat_endian(sFormat.format) != SFMT_CPU))
+                return IInAudioStream::conv_read(dst, nframes, fmt);
+            if (nOffset < 0)
+                return -set_error(STATUS_CLOSED);
+            if (sformat_size_of(fmt) <= 0)
+                return -set_error(STATUS_BAD_FORMAT);
+
+            const void *src;
+            size_t fsize    = pRIFF->frame_size();
+            ssize_t nread   = pRIFF->fetch(&src, fsize * nframes);
+            if (nread < 0)
+            {
+                set_error(-nread);
+                return nread;
+            }
+
+            nframes         = nread / fsize;
+            if (fmt == sFormat.format)
+                ::memcpy(dst, src, nread);
+            else if (!convert_samples(dst, const_cast<void *>(src), nframes * sFormat.channels, fmt, sFormat.format))
+            {
+                pRIFF->seek(nOffset * fsize);
+                return -set_error(STATUS_UNSUPPORTED_FORMAT);
+            }
+
+            // Update statistics
+            set_error(STATUS_OK);
+            nOffset        += nframes;
+            return nframes;
+        }
+
         wssize_t InAudioFileStream::skip(wsize_t nframes)
         {
             if (is_closed())
                 return -set_error(STATUS_CLOSED);
+            if (pRIFF != NULL)
+            {
+                size_t fsize    = pRIFF->frame_size();
+                wssize_t res    = pRIFF->seek((nOffset + nframes) * fsize);
+                if (res < 0)
+                    return -set_error(status_t(-res));
+
+                res            /= fsize;
+                nframes         = res - nOffset;
+                nOffset         = res;
+                set_error(STATUS_OK);
+                return nframes;
+            }
             if (!bSeekable)
                 return IInAudioStream::skip(nframes);
 
@@ -464,6 +577,17 @@ namespace lsp
         {
             if (is_closed())
                 return -set_error(STATUS_CLOSED);
+            if (pRIFF != NULL)
+            {
+                size_t fsize    = pRIFF->frame_size();
+                wssize_t res    = pRIFF->seek(nframes * fsize);
+                if (res < 0)
+                    return -set_error(status_t(-res));
+
+                nOffset         = res / fsize;
+                set_error(STATUS_OK);
+                return nOffset;
+            }
             if (!bSeekable)
                 return IInAudioStream::seek(nframes);
 
@@ -0,0 +1,415 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 29 мар. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/mm/InAudioResampler.h>
+#include <lsp-plug.in/common/alloc.h>
+#include <lsp-plug.in/stdlib/math.h>
+#include <lsp-plug.in/stdlib/string.h>
+#include <private/mm/cvt.h>
+#include <stdlib.h>
+
+#define BUF_FRAMES          0x400
+
+namespace lsp
+{
+    namespace mm
+    {
+        typedef struct resample_params_t
+        {
+            size_t      zeros;          // Number of zero crossings of the sinc function at each side
+            double      beta;           // Kaiser window parameter
+            double      cutoff;         // Cutoff frequency relative to the Nyquist frequency
+        } resample_params_t;
+
+        static const resample_params_t resample_params[] =
+        {
+            {  8,   6.0,    0.85 },     // RESAMPLE_FAST
+            { 16,   8.0,    0.90 },     // RESAMPLE_NORMAL
+            { 32,   10.0,   0.94 }      // RESAMPLE_HIGH
+        };
+
+        static size_t gcd(size_t a, size_t b)
+        {
+            while (b > 0)
+            {
+                size_t t    = a % b;
+                a           = b;
+                b           = t;
+            }
+            return a;
+        }
+
+        static double bessel_i0(double x)
+        {
+            double s = 1.0, t = 1.0, q = x * x * 0.25;
+            for (size_t k=1; t > s * 1e-12; ++k)
+            {
+                t          *= q / double(k * k);
+                s          += t;
+            }
+            return s;
+        }
+
+        InAudioResampler::InAudioResampler()
+        {
+            pIn             = NULL;
+            nWrapFlags      = 0;
+            nInOrigin       = 0;
+
+            nUp             = 1;
+            nDown           = 1;
+            nPhases         = 0;
+            nTaps           = 0;
+            vFilter         = NULL;
+
+            nInPos          = 0;
+            nPhase          = 0;
+            nInLength       = -1;
+
+            vChannels       = NULL;
+            vTail           = NULL;
+            nBufStart       = 0;
+            nBufFrames      = 0;
+            nBufCap         = 0;
+            pData           = NULL;
+        }
+
+        InAudioResampler::~InAudioResampler()
+        {
+            do_close();
+        }
+
+        void InAudioResampler::do_close()
+        {
+            if (pIn != NULL)
+            {
+                if (nWrapFlags & WRAP_CLOSE)
+                    pIn->close();
+                if (nWrapFlags & WRAP_DELETE)
+                    delete pIn;
+                pIn         = NULL;
+            }
+            nWrapFlags  = 0;
+
+            if (pData != NULL)
+            {
+                ::free(pData);
+                pData       = NULL;
+            }
+            vFilter     = NULL;
+            vChannels   = NULL;
+            vTail       = NULL;
+            nTaps       = 0;
+
+            IInAudioStream::do_close();
+        }
+
+        status_t InAudioResampler::close()
+        {
+            status_t res    = STATUS_OK;
+            if ((pIn != NULL) && (nWrapFlags & WRAP_CLOSE))
+            {
+                res             = pIn->close();
+                nWrapFlags     &= ~size_t(WRAP_CLOSE);
+            }
+
+            do_close();
+            return set_error(res);
+        }
+
+        status_t InAudioResampler::wrap(IInAudioStream *is, size_t srate, size_t quality, size_t flags)
+        {
+            if (pIn != NULL)
+                return set_error(STATUS_BAD_STATE);
+            else if ((is == NULL) || (srate <= 0) || (quality > RESAMPLE_HIGH))
+                return set_error(STATUS_BAD_ARGUMENTS);
+
+            audio_stream_t info;
+            status_t res    = is->info(&info);
+            if (res != STATUS_OK)
+                return set_error(res);
+            else if ((info.channels <= 0) || (info.srate <= 0))
+                return set_error(STATUS_BAD_FORMAT);
+
+            wssize_t origin = is->position();
+            if (origin < 0)
+                return set_error(status_t(-origin));
+
+            // Compute the ratio between sample rates
+            size_t k        = gcd(srate, info.srate);
+            nUp             = srate / k;
+            nDown           = info.srate / k;
+            if ((nUp > nDown * MAX_RATIO) || (nDown > nUp * MAX_RATIO))
+                return set_error(STATUS_UNSUPPORTED_FORMAT);
+
+            // Compute the size of buffers
+            const resample_params_t *p = &resample_params[quality];
+            size_t half     = (nUp >= nDown) ? p->zeros : (p->zeros * nDown + nUp - 1) / nUp;
+            nTaps           = (nUp != nDown) ? half * 2 : 0;
+            nPhases         = lsp_min(nUp, size_t(MAX_PHASES));
+            nBufCap         = nTaps + BUF_FRAMES;
+
+            size_t szof_filter  = align_size(nPhases * nTaps * sizeof(f32_t), DEFAULT_ALIGN);
+            size_t szof_buf     = align_size(nBufCap * sizeof(f32_t), DEFAULT_ALIGN);
+            size_t szof_ptrs    = align_size(info.channels * sizeof(f32_t *), DEFAULT_ALIGN);
+            size_t to_alloc     = szof_filter + szof_buf * info.channels + szof_ptrs * 2;
+
+            uint8_t *ptr    = static_cast<uint8_t *>(::malloc(to_alloc));
+            if (ptr == NULL)
+                return set_error(STATUS_NO_MEM);
+            pData           = ptr;
+
+            vFilter         = reinterpret_cast<f32_t *>(ptr);
+            ptr            += szof_filter;
+            vChannels       = reinterpret_cast<f32_t **>(ptr);
+            ptr            += szof_ptrs;
+            vTail           = reinterpret_cast<f32_t **>(ptr);
+            ptr            += szof_ptrs;
+            for (size_t i=0; i<info.channels; ++i)
+            {
+                vChannels[i]    = reinterpret_cast<f32_t *>(ptr);
+                ptr            += szof_buf;
+            }
+
+            // Build the filter
+            if (nTaps > 0)
+            {
+                double fc       = p->cutoff * lsp_min(1.0, double(nUp) / double(nDown));
+                double kw       = 1.0 / bessel_i0(p->beta);
+
+                for (size_t i=0; i<nPhases; ++i)
+                {
+                    f32_t *h        = &vFilter[i * nTaps];
+                    double f        = double(i) / double(nPhases);
+                    double sum      = 0.0;
+
+                    for (size_t j=0; j<nTaps; ++j)
+                    {
+                        double t        = double(j) - double(half - 1) - f;
+                        double x        = t / double(half);
+                        double w        = (fabs(x) < 1.0) ? bessel_i0(p->beta * sqrt(1.0 - x*x)) * kw : 0.0;
+                        double a        = M_PI * fc * t;
+                        double v        = (fabs(a) > 1e-12) ? fc * sin(a) / a : fc;
+
+                        h[j]            = v * w;
+                        sum            += h[j];
+                    }
+
+                    // Normalize the gain of each phase
+                    for (size_t j=0; j<nTaps; ++j)
+                        h[j]            = h[j] / sum;
+                }
+            }
+
+            // Store parameters
+            pIn             = is;
+            nWrapFlags      = flags;
+            nInOrigin       = origin;
+
+            sFormat.srate   = srate;
+            sFormat.channels= info.channels;
+            sFormat.format  = SFMT_F32_CPU;
+            sFormat.frames  = (info.frames >= 0) ?
+                ((info.frames - origin) * nUp + nDown - 1) / nDown : -1;
+
+            nInPos          = 0;
+            nPhase          = 0;
+            nInLength       = -1;
+            nOffset         = 0;
+            reset_buffer(wssize_t(1) - wssize_t(nTaps >> 1));
+
+            return set_error(STATUS_OK);
+        }
+
+        void InAudioResampler::reset_buffer(wssize_t first)
+        {
+            nBufStart       = first;
+            nBufFrames      = 0;
+
+            // Frames before the beginning of the stream are zeros
+            if (first < 0)
+            {
+                nBufFrames      = -first;
+                for (size_t i=0; i<sFormat.channels; ++i)
+                    ::memset(vChannels[i], 0, nBufFrames * sizeof(f32_t));
+            }
+        }
+
+        status_t InAudioResampler::fill_buffer(wssize_t first)
+        {
+            // Drop frames that are not needed anymore
+            if (first > nBufStart)
+            {
+                size_t shift    = lsp_min(wsize_t(first - nBufStart), wsize_t(nBufFrames));
+                nBufFrames     -= shift;
+                nBufStart      += shift;
+                if (nBufFrames > 0)
+                {
+                    for (size_t i=0; i<sFormat.channels; ++i)
+                        ::memmove(vChannels[i], &vChannels[i][shift], nBufFrames * sizeof(f32_t));
+                }
+            }
+
+            size_t avail    = nBufCap - nBufFrames;
+            if (avail <= 0)
+                return STATUS_OK;
+
+            // Frames after the end of the stream are zeros
+            if (nInLength >= 0)
+            {
+                for (size_t i=0; i<sFormat.channels; ++i)
+                    ::memset(&vChannels[i][nBufFrames], 0, avail * sizeof(f32_t));
+                nBufFrames     += avail;
+                return STATUS_OK;
+            }
+
+            // Read frames from the wrapped stream
+            for (size_t i=0; i<sFormat.channels; ++i)
+                vTail[i]        = &vChannels[i][nBufFrames];
+
+            ssize_t n       = pIn->read_planar(vTail, avail);
+            if (n < 0)
+            {
+                if (n != -STATUS_EOF)
+                    return status_t(-n);
+                nInLength       = nBufStart + nBufFrames;
+                return STATUS_OK;
+            }
+
+            nBufFrames     += n;
+            return STATUS_OK;
+        }
+
+        size_t InAudioResampler::select_format(size_t fmt)
+        {
+            return SFMT_F32_CPU;
+        }
+
+        ssize_t InAudioResampler::direct_read(void *dst, size_t nframes, size_t fmt)
+        {
+            if (pIn == NULL)
+                return -STATUS_CLOSED;
+
+            // The sample rate matches, just read samples
+            if (nTaps <= 0)
+                return pIn->read(static_cast<f32_t *>(dst), nframes);
+
+            const cvt_kernels_t *k  = cvt_kernels();
+            f32_t *d                = static_cast<f32_t *>(dst);
+            size_t channels         = sFormat.channels;
+            wssize_t half           = nTaps >> 1;
+            size_t count            = 0;
+
+            while (count < nframes)
+            {
+                // All frames of the input stream have been processed?
+                if ((nInLength >= 0) && (nInPos >= nInLength))
+                    break;
+
+                // Ensure that the buffer contains all frames covered by the filter
+                wssize_t first      = nInPos - (half - 1);
+                if (first + wssize_t(nTaps) > nBufStart + wssize_t(nBufFrames))
+                {
+                    status_t res        = fill_buffer(first);
+                    if (res != STATUS_OK)
+                    {
+                        if (count > 0)
+                            break;
+                        return -res;
+                    }
+                    continue;
+                }
+
+                // Apply the filter phase to each channel
+                size_t phase        = (nPhases == nUp) ? nPhase : (nPhase * nPhases) / nUp;
+                const f32_t *h      = &vFilter[phase * nTaps];
+                size_t off          = first - nBufStart;
+                for (size_t i=0; i<channels; ++i)
+                    *(d++)              = k->dot_f32(h, &vChannels[i][off], nTaps);
+
+                // Move to the next frame
+                ++count;
+                nPhase             += nDown;
+                nInPos             += nPhase / nUp;
+                nPhase             %= nUp;
+            }
+
+            return (count > 0) ? count : -STATUS_EOF;
+        }
+
+        wssize_t InAudioResampler::seek(wsize_t nframes)
+        {
+            if (pIn == NULL)
+                return -set_error(STATUS_CLOSED);
+
+            // Do not seek beyond the end of the stream
+            wssize_t pos        = nframes;
+            if ((sFormat.frames >= 0) && (pos > sFormat.frames))
+                pos                 = sFormat.frames;
+
+            // The sample rate matches, just seek the wrapped stream
+            if (nTaps <= 0)
+            {
+                wssize_t res        = pIn->seek(nInOrigin + pos);
+                if (res < 0)
+                    return -set_error(status_t(-res));
+                nOffset             = pos;
+                set_error(STATUS_OK);
+                return pos;
+            }
+
+            if ((nInLength >= 0) && (pos * nDown > nInLength * nUp))
+                pos                 = (nInLength * nUp + nDown - 1) / nDown;
+
+            wssize_t ipos       = (pos * nDown) / nUp;
+            wssize_t first      = ipos - wssize_t(nTaps >> 1) + 1;
+
+            // Reposition the wrapped stream if buffered frames can not be re-used
+            if ((first < nBufStart) || (first > nBufStart + wssize_t(nBufFrames)))
+            {
+                wssize_t res        = pIn->seek(nInOrigin + lsp_max(first, wssize_t(0)));
+                if (res < 0)
+                    return -set_error(status_t(-res));
+
+                nInLength           = -1;
+                reset_buffer(first);
+            }
+
+            nInPos              = ipos;
+            nPhase              = (pos * nDown) % nUp;
+            nOffset             = pos;
+            set_error(STATUS_OK);
+
+            return pos;
+        }
+
+        wssize_t InAudioResampler::skip(wsize_t nframes)
+        {
+            if (pIn == NULL)
+                return -set_error(STATUS_CLOSED);
+
+            wssize_t pos        = nOffset;
+            wssize_t res        = seek(nOffset + nframes);
+            return (res >= 0) ? res - pos : res;
+        }
+
+    } /* namespace mm */
+} /* namespace lsp */
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 2 апр. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/mm/InAudioWaveform.h>
+
+namespace lsp
+{
+    namespace mm
+    {
+        InAudioWaveform::InAudioWaveform()
+        {
+            pIn             = NULL;
+            nWrapFlags      = 0;
+            pWaveform       = NULL;
+        }
+
+        InAudioWaveform::~InAudioWaveform()
+        {
+            do_close();
+        }
+
+        void InAudioWaveform::do_close()
+        {
+            if (pIn != NULL)
+            {
+                if (nWrapFlags & WRAP_CLOSE)
+                    pIn->close();
+                if (nWrapFlags & WRAP_DELETE)
+                    delete pIn;
+                pIn         = NULL;
+            }
+            nWrapFlags  = 0;
+
+            if (pWaveform != NULL)
+            {
+                pWaveform->finish();
+                pWaveform   = NULL;
+            }
+
+            IInAudioStream::do_close();
+        }
+
+        status_t InAudioWaveform::close()
+        {
+            status_t res    = STATUS_OK;
+            if ((pIn != NULL) && (nWrapFlags & WRAP_CLOSE))
+            {
+                res             = pIn->close();
+                nWrapFlags     &= ~size_t(WRAP_CLOSE);
+            }
+            if (pWaveform != NULL)
+            {
+                status_t xr     = pWaveform->finish();
+                if (res == STATUS_OK)
+                    res             = xr;
+            }
+
+            do_close();
+            return set_error(res);
+        }
+
+        status_t InAudioWaveform::wrap(IInAudioStream *is, Waveform *wf, size_t flags)
+        {
+            if (pIn != NULL)
+                return set_error(STATUS_BAD_STATE);
+            else if ((is == NULL) || (wf == NULL))
+                return set_error(STATUS_BAD_ARGUMENTS);
+
+            audio_stream_t info;
+            status_t res    = is->info(&info);
+            if (res != STATUS_OK)
+                return set_error(res);
+            else if ((info.channels <= 0) || (info.srate <= 0))
+                return set_error(STATUS_BAD_FORMAT);
+
+            wssize_t origin = is->position();
+            if (origin < 0)
+                return set_error(status_t(-origin));
+
+            if ((res = wf->init(info.channels, info.srate, wf->base())) != STATUS_OK)
+                return set_error(res);
+
+            // Store parameters
+            pIn             = is;
+            nWrapFlags      = flags;
+            pWaveform       = wf;
+
+            sFormat.srate   = info.srate;
+            sFormat.channels= info.channels;
+            sFormat.format  = SFMT_F32_CPU;
+            sFormat.frames  = (info.frames >= 0) ? info.frames - origin : -1;
+            nOffset         = 0;
+
+            return set_error(STATUS_OK);
+        }
+
+        size_t InAudioWaveform::select_format(size_t fmt)
+        {
+            return SFMT_F32_CPU;
+        }
+
+        ssize_t InAudioWaveform::direct_read(void *dst, size_t nframes, size_t fmt)
+        {
+            if (pIn == NULL)
+                return -STATUS_CLOSED;
+
+            f32_t *d        = static_cast<f32_t *>(dst);
+            ssize_t n       = pIn->read(d, nframes);
+            if (n > 0)
+            {
+                status_t res    = pWaveform->process(d, n);
+                if (res != STATUS_OK)
+                    return -res;
+            }
+            else if (n == -STATUS_EOF)
+                pWaveform->finish();
+
+            return n;
+        }
+
+    } /* namespace mm */
+} /* namespace lsp */
@@ -22,6 +22,7 @@
 #include <lsp-plug.in/mm/OutAudioFileStream.h>
 #include <private/mm/MMIOWriter.h>
 #include <private/mm/ACMStream.h>
+#include <private/mm/RIFFWriter.h>
 
 #ifdef USE_LIBSNDFILE
     #if (__SIZEOF_INT__ == 4)
@@ -51,6 +52,7 @@ namespace lsp
             pFormat         = NULL;
         #endif /* USE_LIBSNDFILE */
 
+            pRIFF           = NULL;
             nCodec          = 0;
             bSeekable       = false;
         }
@@ -211,6 +213,30 @@ namespace lsp
             return open(path->as_string(), fmt, codec);
         }
 
+        status_t OutAudioFileStream::open_riff(const LSPString *path, const audio_stream_t *fmt, size_t codec)
+        {
+            RIFFWriter *riff    = new RIFFWriter();
+            if (riff == NULL)
+                return STATUS_NO_MEM;
+
+            status_t res        = riff->open(path, fmt);
+            if (res != STATUS_OK)
+            {
+                delete riff;
+                return res;
+            }
+
+            // Commit new state
+            sFormat             = *fmt;
+            sFormat.format      = riff->format();
+            pRIFF               = riff;
+            nCodec              = codec;
+            nOffset             = 0;
+            bSeekable           = true;
+
+            return STATUS_OK;
+        }
+
         status_t OutAudioFileStream::open(const LSPString *path, const audio_stream_t *fmt, size_t codec)
         {
             if (!is_closed())
@@ -218,6 +244,11 @@ namespace lsp
             if (fmt == NULL)
                 return set_error(STATUS_BAD_ARGUMENTS);
 
+            // PCM and floating-point WAV files are written without additional libraries
+            if (((codec & AFMT_MASK) == AFMT_WAV) && ((codec & CFMT_MASK) == CFMT_PCM) &&
+                (RIFFWriter::select_format(fmt->format) != SFMT_NONE))
+                return set_error(open_riff(path, fmt, codec));
+
         #ifdef USE_LIBSNDFILE
             audio_stream_t tmp;
             SF_INFO info;
@@ -345,6 +376,19 @@ namespace lsp
 
         status_t OutAudioFileStream::close_handle()
         {
+            if (pRIFF != NULL)
+            {
+                status_t res    = pRIFF->close();
+                delete pRIFF;
+
+                pRIFF           = NULL;
+                bSeekable       = false;
+                nOffset         = -1;       // Mark as closed
+                nCodec          = 0;
+
+                return set_error(res);
+            }
+
         #ifdef USE_LIBSNDFILE
             if (hHandle == NULL)
                 return STATUS_OK;
@@ -388,6 +432,8 @@ namespace lsp
         {
             if (is_closed())
                 return -set_error(STATUS_CLOSED);
+            if (pRIFF != NULL)
+                return set_error(pRIFF->flush());
 
         #ifdef USE_LIBSNDFILE
             sf_write_sync(hHandle);
@@ -410,6 +456,13 @@ namespace lsp
 
         ssize_t OutAudioFileStream::direct_write(const void *src, size_t nframes, size_t fmt)
         {
+            if (pRIFF != NULL)
+            {
+                size_t fsize        = pRIFF->frame_size();
+                ssize_t nwritten    = pRIFF->write(src, fsize * nframes);
+                return (nwritten < 0) ? nwritten : nwritten / fsize;
+            }
+
         #ifdef USE_LIBSNDFILE
             sf_count_t count;
             status_t res;
@@ -559,7 +612,38 @@ namespace lsp
 
         size_t OutAudioFileStream::select_format(size_t rfmt)
         {
+            // Samples of WAV files are stored in their native format
+            if (pRIFF != NULL)
+                return sFormat.format;
+
         #ifdef USE_LIBSNDFILE
+            // Floating-point samples should be quantized before passing them to the library
+            if ((nQuantize != QUANTIZE_TRUNCATE) &&
+                ((sformat_format(rfmt) == SFMT_F32) || (sformat_format(rfmt) == SFMT_F64)))
+            {
+                switch (sformat_format(sFormat.format))
+                {
+                #ifdef AFS_S16_CPU
+                    case SFMT_S16:
+                    case SFMT_U16:
+                    case SFMT_S8:
+                    case SFMT_U8:
+                        return SFMT_S16_CPU;
+                #endif
+
+                #ifdef AFS_S32_CPU
+                    case SFMT_S32:
+                    case SFMT_U32:
+                    case SFMT_S24:
+                    case SFMT_U24:
+                        return SFMT_S32_CPU;
+                #endif
+
+                    default:
+                        break;
+                }
+            }
+
             switch (sformat_format(rfmt))
             {
             #ifdef AFS_S32_CPU
@@ -614,6 +698,16 @@ namespace lsp
         {
             if (is_closed())
                 return -set_error(STATUS_CLOSED);
+            if (pRIFF != NULL)
+            {
+                size_t fsize    = pRIFF->frame_size();
+                wssize_t res    = pRIFF->seek(nframes * fsize);
+                if (res < 0)
+                    return -set_error(status_t(-res));
+
+                set_error(STATUS_OK);
+                return nOffset = res / fsize;
+            }
 
         #ifdef USE_LIBSNDFILE
             sf_count_t offset = sf_seek(hHandle, nframes, SEEK_SET);
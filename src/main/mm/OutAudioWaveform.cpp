@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 2 апр. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/mm/OutAudioWaveform.h>
+
+namespace lsp
+{
+    namespace mm
+    {
+        OutAudioWaveform::OutAudioWaveform()
+        {
+            pOut            = NULL;
+            nWrapFlags      = 0;
+            pWaveform       = NULL;
+        }
+
+        OutAudioWaveform::~OutAudioWaveform()
+        {
+            do_close();
+        }
+
+        void OutAudioWaveform::do_close()
+        {
+            if (pOut != NULL)
+            {
+                if (nWrapFlags & WRAP_CLOSE)
+                    pOut->close();
+                if (nWrapFlags & WRAP_DELETE)
+                    delete pOut;
+                pOut        = NULL;
+            }
+            nWrapFlags  = 0;
+
+            if (pWaveform != NULL)
+            {
+                pWaveform->finish();
+                pWaveform   = NULL;
+            }
+
+            IOutAudioStream::do_close();
+        }
+
+        status_t OutAudioWaveform::close()
+        {
+            status_t res    = STATUS_OK;
+            if ((pOut != NULL) && (nWrapFlags & WRAP_CLOSE))
+            {
+                res             = pOut->close();
+                nWrapFlags     &= ~size_t(WRAP_CLOSE);
+            }
+            if (pWaveform != NULL)
+            {
+                status_t xr     = pWaveform->finish();
+                if (res == STATUS_OK)
+                    res             = xr;
+            }
+
+            do_close();
+            return set_error(res);
+        }
+
+        status_t OutAudioWaveform::flush()
+        {
+            if (pOut == NULL)
+                return set_error(STATUS_CLOSED);
+            return set_error(pOut->flush());
+        }
+
+        status_t OutAudioWaveform::wrap(IOutAudioStream *os, Waveform *wf, size_t flags)
+        {
+            if (pOut != NULL)
+                return set_error(STATUS_BAD_STATE);
+            else if ((os == NULL) || (wf == NULL))
+                return set_error(STATUS_BAD_ARGUMENTS);
+
+            audio_stream_t info;
+            status_t res    = os->info(&info);
+            if (res != STATUS_OK)
+                return set_error(res);
+            else if ((info.channels <= 0) || (info.srate <= 0))
+                return set_error(STATUS_BAD_FORMAT);
+
+            if ((res = wf->init(info.channels, info.srate, wf->base())) != STATUS_OK)
+                return set_error(res);
+
+            // Store parameters
+            pOut            = os;
+            nWrapFlags      = flags;
+            pWaveform       = wf;
+
+            sFormat.srate   = info.srate;
+            sFormat.channels= info.channels;
+            sFormat.format  = SFMT_F32_CPU;
+            sFormat.frames  = info.frames;
+            nOffset         = 0;
+
+            return set_error(STATUS_OK);
+        }
+
+        size_t OutAudioWaveform::select_format(size_t rfmt)
+        {
+            return SFMT_F32_CPU;
+        }
+
+        ssize_t OutAudioWaveform::direct_write(const void *src, size_t nframes, size_t fmt)
+        {
+            if (pOut == NULL)
+                return -STATUS_CLOSED;
+
+            const f32_t *s  = static_cast<const f32_t *>(src);
+            ssize_t n       = pOut->write(s, nframes);
+            if (n > 0)
+            {
+                status_t res    = pWaveform->process(s, n);
+                if (res != STATUS_OK)
+                    return -res;
+            }
+
+            return n;
+        }
+
+    } /* namespace mm */
+} /* namespace lsp */
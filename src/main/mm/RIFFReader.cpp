@@ -0,0 +1,395 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 30 мар. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/common/endian.h>
+#include <lsp-plug.in/mm/types.h>
+#include <private/mm/riff.h>
+#include <private/mm/RIFFReader.h>
+
+#if defined(PLATFORM_WINDOWS)
+    #include <windows.h>
+#else
+    #include <sys/types.h>
+    #include <sys/stat.h>
+    #include <sys/mman.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <errno.h>
+#endif /* PLATFORM_WINDOWS */
+
+namespace lsp
+{
+    namespace mm
+    {
+        RIFFReader::RIFFReader()
+        {
+            pFD         = NULL;
+            pMap        = NULL;
+            nMapSize    = 0;
+            nFileSize   = 0;
+
+            nDataOffset = 0;
+            nDataSize   = 0;
+            nReadPos    = 0;
+
+            nFormat     = SFMT_NONE;
+            nChannels   = 0;
+            nSampleRate = 0;
+            nFrameSize  = 0;
+        }
+
+        RIFFReader::~RIFFReader()
+        {
+            close();
+        }
+
+        status_t RIFFReader::close(status_t code)
+        {
+            unmap_file();
+
+            if (pFD != NULL)
+            {
+                pFD->close();
+                delete pFD;
+                pFD         = NULL;
+            }
+
+            nFileSize   = 0;
+            nDataOffset = 0;
+            nDataSize   = 0;
+            nReadPos    = 0;
+
+            nFormat     = SFMT_NONE;
+            nChannels   = 0;
+            nSampleRate = 0;
+            nFrameSize  = 0;
+
+            return code;
+        }
+
+    #if defined(PLATFORM_WINDOWS)
+        status_t RIFFReader::map_file(const LSPString *path)
+        {
+            HANDLE fd   = ::CreateFileW(path->get_utf16(), GENERIC_READ, FILE_SHARE_READ,
+                    NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+            if (fd == INVALID_HANDLE_VALUE)
+                return STATUS_IO_ERROR;
+
+            LARGE_INTEGER size;
+            if ((!::GetFileSizeEx(fd, &size)) || (size.QuadPart <= 0) ||
+                (wsize_t(size_t(size.QuadPart)) != wsize_t(size.QuadPart)))
+            {
+                ::CloseHandle(fd);
+                return STATUS_NOT_SUPPORTED;
+            }
+
+            HANDLE map  = ::CreateFileMappingW(fd, NULL, PAGE_READONLY, 0, 0, NULL);
+            ::CloseHandle(fd);
+            if (map == NULL)
+                return STATUS_NOT_SUPPORTED;
+
+            // The view keeps the mapping alive after closing the handle
+            void *ptr   = ::MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+            ::CloseHandle(map);
+            if (ptr == NULL)
+                return STATUS_NO_MEM;
+
+            pMap        = static_cast<uint8_t *>(ptr);
+            nMapSize    = size.QuadPart;
+            return STATUS_OK;
+        }
+
+        void RIFFReader::unmap_file()
+        {
+            if (pMap == NULL)
+                return;
+
+            ::UnmapViewOfFile(pMap);
+            pMap        = NULL;
+            nMapSize    = 0;
+        }
+    #else
+        status_t RIFFReader::map_file(const LSPString *path)
+        {
+            int fd      = ::open(path->get_native(), O_RDONLY);
+            if (fd < 0)
+                return (errno == ENOENT) ? STATUS_NOT_FOUND : STATUS_IO_ERROR;
+
+            // Only non-empty regular files which fit into the address space can be mapped
+            struct stat st;
+            if ((::fstat(fd, &st) != 0) || (!S_ISREG(st.st_mode)) || (st.st_size <= 0) ||
+                (wsize_t(size_t(st.st_size)) != wsize_t(st.st_size)))
+            {
+                ::close(fd);
+                return STATUS_NOT_SUPPORTED;
+            }
+
+            // The mapping remains valid after closing the file descriptor
+            void *ptr   = ::mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (ptr == MAP_FAILED)
+                return STATUS_NO_MEM;
+
+        #ifdef MADV_SEQUENTIAL
+            ::madvise(ptr, st.st_size, MADV_SEQUENTIAL);
+        #endif /* MADV_SEQUENTIAL */
+
+            pMap        = static_cast<uint8_t *>(ptr);
+            nMapSize    = st.st_size;
+            return STATUS_OK;
+        }
+
+        void RIFFReader::unmap_file()
+        {
+            if (pMap == NULL)
+                return;
+
+            ::munmap(pMap, nMapSize);
+            pMap        = NULL;
+            nMapSize    = 0;
+        }
+    #endif /* PLATFORM_WINDOWS */
+
+        status_t RIFFReader::open(const LSPString *path, bool mmap)
+        {
+            if (path == NULL)
+                return STATUS_BAD_ARGUMENTS;
+            if ((pMap != NULL) || (pFD != NULL))
+                return STATUS_OPENED;
+
+            // Try to map file into memory first, read the file otherwise
+            if ((mmap) && (map_file(path) == STATUS_OK))
+                nFileSize       = nMapSize;
+            else
+            {
+                pFD             = new io::NativeFile();
+                if (pFD == NULL)
+                    return STATUS_NO_MEM;
+
+                status_t res    = pFD->open(path, io::File::FM_READ);
+                if (res != STATUS_OK)
+                    return close(res);
+
+                wssize_t size   = pFD->size();
+                if (size < 0)
+                    return close(status_t(-size));
+                nFileSize       = size;
+            }
+
+            status_t res    = parse_header();
+            return (res == STATUS_OK) ? res : close(res);
+        }
+
+        ssize_t RIFFReader::read_at(wsize_t offset, void *buf, size_t count)
+        {
+            if (pMap == NULL)
+                return pFD->pread(offset, buf, count);
+
+            if (offset >= nMapSize)
+                return 0;
+            count   = lsp_min(wsize_t(count), nMapSize - offset);
+            ::memcpy(buf, &pMap[offset], count);
+            return count;
+        }
+
+        status_t RIFFReader::parse_header()
+        {
+            riff_header_t hdr;
+            riff_chunk_t chunk;
+            wav_format_t fmt;
+
+            // Check the RIFF header
+            if (read_at(0, &hdr, sizeof(hdr)) != sizeof(hdr))
+                return STATUS_BAD_FORMAT;
+            if ((LE_TO_CPU(hdr.chunk.id) != RIFF_ID_RIFF) || (LE_TO_CPU(hdr.type) != RIFF_ID_WAVE))
+                return STATUS_BAD_FORMAT;
+
+            // The size of RIFF chunk may be invalid for files that have not been properly closed
+            wsize_t end     = wsize_t(LE_TO_CPU(hdr.chunk.size)) + sizeof(riff_chunk_t);
+            if ((end > nFileSize) || (end <= sizeof(hdr)))
+                end             = nFileSize;
+
+            // Lookup for 'fmt ' and 'data' chunks
+            bool has_format = false, has_data = false;
+            for (wsize_t off = sizeof(hdr); off + sizeof(riff_chunk_t) <= end; )
+            {
+                if (read_at(off, &chunk, sizeof(chunk)) != sizeof(chunk))
+                    return STATUS_CORRUPTED_FILE;
+
+                wsize_t size    = LE_TO_CPU(chunk.size);
+                off            += sizeof(chunk);
+
+                switch (LE_TO_CPU(chunk.id))
+                {
+                    case RIFF_ID_FMT:
+                    {
+                        if (has_format)
+                            return STATUS_CORRUPTED_FILE;
+
+                        size_t count    = lsp_min(size, wsize_t(sizeof(fmt)));
+                        ::memset(&fmt, 0, sizeof(fmt));
+                        if (read_at(off, &fmt, count) != ssize_t(count))
+                            return STATUS_CORRUPTED_FILE;
+
+                        status_t res    = parse_format(&fmt, count);
+                        if (res != STATUS_OK)
+                            return res;
+                        has_format      = true;
+                        break;
+                    }
+
+                    case RIFF_ID_DATA:
+                        if (has_data)
+                            return STATUS_CORRUPTED_FILE;
+
+                        // The size of data chunk may be invalid for files that have not been properly closed
+                        nDataOffset     = off;
+                        nDataSize       = lsp_min(size, nFileSize - off);
+                        has_data        = true;
+                        break;
+
+                    default:
+                        break;
+                }
+
+                if ((has_format) && (has_data))
+                    break;
+
+                off            += size + (size & 1);
+            }
+
+            if ((!has_format) || (!has_data))
+                return STATUS_CORRUPTED_FILE;
+
+            // Drop the incomplete frame at the end
+            nDataSize      -= nDataSize % nFrameSize;
+            nReadPos        = 0;
+
+            return STATUS_OK;
+        }
+
+        status_t RIFFReader::parse_format(const void *buf, size_t size)
+        {
+            if (size < WAV_FORMAT_PCM_SIZE)
+                return STATUS_CORRUPTED_FILE;
+
+            const wav_format_t *fmt = static_cast<const wav_format_t *>(buf);
+            size_t tag          = LE_TO_CPU(fmt->format_tag);
+            size_t channels     = LE_TO_CPU(fmt->channels);
+            size_t srate        = LE_TO_CPU(fmt->srate);
+            size_t bits         = LE_TO_CPU(fmt->bits);
+            size_t block_align  = LE_TO_CPU(fmt->block_align);
+
+            // The extensible format stores actual format tag in the sub-format GUID
+            if (tag == WAV_FORMAT_EXTENSIBLE)
+            {
+                if (size < WAV_FORMAT_EXT_SIZE)
+                    return STATUS_CORRUPTED_FILE;
+                if (::memcmp(&fmt->sub_format[2], wav_subformat_guid, sizeof(wav_subformat_guid)) != 0)
+                    return STATUS_UNSUPPORTED_FORMAT;
+                tag                 = fmt->sub_format[0] | (fmt->sub_format[1] << 8);
+            }
+
+            if ((channels <= 0) || (srate <= 0))
+                return STATUS_CORRUPTED_FILE;
+
+            // Decode sample format
+            size_t format       = SFMT_NONE;
+            if (tag == WAV_FORMAT_PCM)
+            {
+                switch (bits)
+                {
+                    case 8:  format = SFMT_U8_LE;  break;
+                    case 16: format = SFMT_S16_LE; break;
+                    case 24: format = SFMT_S24_LE; break;
+                    case 32: format = SFMT_S32_LE; break;
+                    default: return STATUS_UNSUPPORTED_FORMAT;
+                }
+            }
+            else if (tag == WAV_FORMAT_IEEE_FLOAT)
+            {
+                switch (bits)
+                {
+                    case 32: format = SFMT_F32_LE; break;
+                    case 64: format = SFMT_F64_LE; break;
+                    default: return STATUS_UNSUPPORTED_FORMAT;
+                }
+            }
+            else
+                return STATUS_UNSUPPORTED_FORMAT;
+
+            // Samples should be tightly packed
+            if (block_align != channels * (bits >> 3))
+                return STATUS_UNSUPPORTED_FORMAT;
+
+            nFormat             = format;
+            nChannels           = channels;
+            nSampleRate         = srate;
+            nFrameSize          = block_align;
+
+            return STATUS_OK;
+        }
+
+        ssize_t RIFFReader::fetch(const void **ptr, size_t count)
+        {
+            if (pMap == NULL)
+                return (pFD != NULL) ? -STATUS_NOT_SUPPORTED : -STATUS_CLOSED;
+
+            wsize_t can_read    = nDataSize - nReadPos;
+            if (can_read <= 0)
+                return -STATUS_EOF;
+            count               = lsp_min(wsize_t(count), can_read);
+
+            *ptr                = &pMap[nDataOffset + nReadPos];
+            nReadPos           += count;
+            return count;
+        }
+
+        wssize_t RIFFReader::seek(wsize_t offset)
+        {
+            if ((pMap == NULL) && (pFD == NULL))
+                return -STATUS_CLOSED;
+
+            return nReadPos = lsp_min(offset, nDataSize);
+        }
+
+        ssize_t RIFFReader::read(void *buf, size_t count)
+        {
+            if ((pMap == NULL) && (pFD == NULL))
+                return -STATUS_CLOSED;
+
+            // Compute how many bytes we can read
+            wsize_t can_read    = nDataSize - nReadPos;
+            if (can_read <= 0)
+                return -STATUS_EOF;
+            count               = lsp_min(wsize_t(count), can_read);
+
+            // Perform read
+            ssize_t res         = read_at(nDataOffset + nReadPos, buf, count);
+            if (res <= 0)
+                return (res < 0) ? res : -STATUS_EOF;
+
+            nReadPos           += res;
+            return res;
+        }
+
+    } /* namespace mm */
+} /* namespace lsp */
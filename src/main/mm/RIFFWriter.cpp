@@ -0,0 +1,302 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 30 мар. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/common/endian.h>
+#include <private/mm/riff.h>
+#include <private/mm/RIFFWriter.h>
+
+namespace lsp
+{
+    namespace mm
+    {
+        // RIFF chunk sizes are 32-bit
+        static const wsize_t RIFF_MAX_SIZE      = 0xffffffffU;
+
+        RIFFWriter::RIFFWriter()
+        {
+            pFD         = NULL;
+            nDataOffset = 0;
+            nFactOffset = 0;
+            nDataSize   = 0;
+            nWritePos   = 0;
+
+            nFormat     = SFMT_NONE;
+            nChannels   = 0;
+            nFrameSize  = 0;
+        }
+
+        RIFFWriter::~RIFFWriter()
+        {
+            close();
+        }
+
+        size_t RIFFWriter::select_format(size_t format)
+        {
+            // Only little-endian RIFF files are supported
+            if (sformat_endian(format) == SFMT_BE)
+                return SFMT_NONE;
+
+            switch (sformat_format(format))
+            {
+                case SFMT_U8:
+                case SFMT_S8:
+                    return SFMT_U8_LE;
+                case SFMT_U16:
+                case SFMT_S16:
+                    return SFMT_S16_LE;
+                case SFMT_U24:
+                case SFMT_S24:
+                    return SFMT_S24_LE;
+                case SFMT_U32:
+                case SFMT_S32:
+                    return SFMT_S32_LE;
+                case SFMT_F32:
+                    return SFMT_F32_LE;
+                case SFMT_F64:
+                    return SFMT_F64_LE;
+                default:
+                    break;
+            }
+
+            return SFMT_NONE;
+        }
+
+        status_t RIFFWriter::open(const LSPString *path, const audio_stream_t *fmt)
+        {
+            if ((path == NULL) || (fmt == NULL))
+                return STATUS_BAD_ARGUMENTS;
+            if (pFD != NULL)
+                return STATUS_OPENED;
+            if ((fmt->channels <= 0) || (fmt->channels > 0xffff) || (fmt->srate <= 0))
+                return STATUS_BAD_ARGUMENTS;
+            if (select_format(fmt->format) == SFMT_NONE)
+                return STATUS_UNSUPPORTED_FORMAT;
+
+            pFD             = new io::NativeFile();
+            if (pFD == NULL)
+                return STATUS_NO_MEM;
+
+            status_t res    = pFD->open(path, io::File::FM_WRITE_NEW);
+            if (res == STATUS_OK)
+                res             = write_header(fmt);
+            if (res != STATUS_OK)
+            {
+                pFD->close();
+                delete pFD;
+                pFD             = NULL;
+            }
+
+            return res;
+        }
+
+        status_t RIFFWriter::write_header(const audio_stream_t *fmt)
+        {
+            size_t format   = select_format(fmt->format);
+            bool fp         = (sformat_format(format) == SFMT_F32) || (sformat_format(format) == SFMT_F64);
+            size_t bits     = (sformat_format(format) == SFMT_S24) ? 24 : sformat_size_of(format) * 8;
+            size_t fsize    = (bits >> 3) * fmt->channels;
+            size_t tag      = (fp) ? WAV_FORMAT_IEEE_FLOAT : WAV_FORMAT_PCM;
+
+            // The extensible format is required for more than two channels,
+            // the floating-point format requires the extension size field
+            size_t fmt_size = (fmt->channels > 2) ? WAV_FORMAT_EXT_SIZE :
+                              (fp) ? WAV_FORMAT_PCM_SIZE + sizeof(uint16_t) : WAV_FORMAT_PCM_SIZE;
+
+            wav_format_t wfmt;
+            ::memset(&wfmt, 0, sizeof(wfmt));
+            wfmt.format_tag     = CPU_TO_LE(uint16_t((fmt->channels > 2) ? WAV_FORMAT_EXTENSIBLE : tag));
+            wfmt.channels       = CPU_TO_LE(uint16_t(fmt->channels));
+            wfmt.srate          = CPU_TO_LE(uint32_t(fmt->srate));
+            wfmt.byte_rate      = CPU_TO_LE(uint32_t(fmt->srate * fsize));
+            wfmt.block_align    = CPU_TO_LE(uint16_t(fsize));
+            wfmt.bits           = CPU_TO_LE(uint16_t(bits));
+            if (fmt->channels > 2)
+            {
+                wfmt.ext_size       = CPU_TO_LE(uint16_t(WAV_FORMAT_EXT_SIZE - WAV_FORMAT_PCM_SIZE - sizeof(uint16_t)));
+                wfmt.valid_bits     = CPU_TO_LE(uint16_t(bits));
+                wfmt.channel_mask   = 0;
+                wfmt.sub_format[0]  = uint8_t(tag);
+                wfmt.sub_format[1]  = uint8_t(tag >> 8);
+                ::memcpy(&wfmt.sub_format[2], wav_subformat_guid, sizeof(wav_subformat_guid));
+            }
+
+            // Build the header, chunk sizes will be updated later
+            uint8_t buf[0x80];
+            uint8_t *ptr    = buf;
+
+            riff_header_t hdr;
+            hdr.chunk.id    = CPU_TO_LE(uint32_t(RIFF_ID_RIFF));
+            hdr.chunk.size  = 0;
+            hdr.type        = CPU_TO_LE(uint32_t(RIFF_ID_WAVE));
+            ::memcpy(ptr, &hdr, sizeof(hdr));
+            ptr            += sizeof(hdr);
+
+            riff_chunk_t chunk;
+            chunk.id        = CPU_TO_LE(uint32_t(RIFF_ID_FMT));
+            chunk.size      = CPU_TO_LE(uint32_t(fmt_size));
+            ::memcpy(ptr, &chunk, sizeof(chunk));
+            ptr            += sizeof(chunk);
+            ::memcpy(ptr, &wfmt, fmt_size);
+            ptr            += fmt_size;
+
+            // Non-PCM files should contain the 'fact' chunk with number of frames
+            nFactOffset     = 0;
+            if (fp)
+            {
+                uint32_t frames = 0;
+                chunk.id        = CPU_TO_LE(uint32_t(RIFF_ID_FACT));
+                chunk.size      = CPU_TO_LE(uint32_t(sizeof(frames)));
+                ::memcpy(ptr, &chunk, sizeof(chunk));
+                ptr            += sizeof(chunk);
+                nFactOffset     = ptr - buf;
+                ::memcpy(ptr, &frames, sizeof(frames));
+                ptr            += sizeof(frames);
+            }
+
+            chunk.id        = CPU_TO_LE(uint32_t(RIFF_ID_DATA));
+            chunk.size      = 0;
+            ::memcpy(ptr, &chunk, sizeof(chunk));
+            ptr            += sizeof(chunk);
+
+            // Write the header
+            size_t count    = ptr - buf;
+            ssize_t res     = pFD->write(buf, count);
+            if (res < 0)
+                return status_t(-res);
+            else if (size_t(res) != count)
+                return STATUS_IO_ERROR;
+
+            nDataOffset     = count;
+            nDataSize       = 0;
+            nWritePos       = 0;
+            nFormat         = format;
+            nChannels       = fmt->channels;
+            nFrameSize      = fsize;
+
+            return update_header();
+        }
+
+        status_t RIFFWriter::update_header()
+        {
+            uint32_t size;
+            ssize_t res;
+
+            // The data chunk should be padded to the even number of bytes
+            wsize_t padding     = nDataSize & 1;
+            if (padding > 0)
+            {
+                uint8_t pad         = 0;
+                res                 = pFD->pwrite(nDataOffset + nDataSize, &pad, sizeof(pad));
+                if (res < 0)
+                    return status_t(-res);
+            }
+
+            // Update the size of RIFF chunk
+            size                = CPU_TO_LE(uint32_t(nDataOffset + nDataSize + padding - sizeof(riff_chunk_t)));
+            res                 = pFD->pwrite(offsetof(riff_chunk_t, size), &size, sizeof(size));
+            if (res < 0)
+                return status_t(-res);
+
+            // Update the size of data chunk
+            size                = CPU_TO_LE(uint32_t(nDataSize));
+            res                 = pFD->pwrite(nDataOffset - sizeof(uint32_t), &size, sizeof(size));
+            if (res < 0)
+                return status_t(-res);
+
+            // Update number of frames
+            if (nFactOffset > 0)
+            {
+                size                = CPU_TO_LE(uint32_t(nDataSize / nFrameSize));
+                res                 = pFD->pwrite(nFactOffset, &size, sizeof(size));
+                if (res < 0)
+                    return status_t(-res);
+            }
+
+            return STATUS_OK;
+        }
+
+        status_t RIFFWriter::close()
+        {
+            if (pFD == NULL)
+                return STATUS_OK;
+
+            status_t res    = update_header();
+            status_t res2   = pFD->close();
+            delete pFD;
+            pFD             = NULL;
+
+            nDataOffset     = 0;
+            nFactOffset     = 0;
+            nDataSize       = 0;
+            nWritePos       = 0;
+            nFormat         = SFMT_NONE;
+            nChannels       = 0;
+            nFrameSize      = 0;
+
+            return (res != STATUS_OK) ? res : res2;
+        }
+
+        ssize_t RIFFWriter::write(const void *buf, size_t count)
+        {
+            if (pFD == NULL)
+                return -STATUS_CLOSED;
+
+            // Do not exceed the maximum size of RIFF file, keep the data aligned to frames
+            wsize_t limit   = RIFF_MAX_SIZE - nDataOffset - 1;
+            if (nFrameSize > 0)
+                limit          -= limit % nFrameSize;
+            if (nWritePos + count > limit)
+            {
+                if (nWritePos >= limit)
+                    return -STATUS_OVERFLOW;
+                count           = limit - nWritePos;
+            }
+
+            ssize_t res     = pFD->pwrite(nDataOffset + nWritePos, buf, count);
+            if (res <= 0)
+                return (res < 0) ? res : -STATUS_IO_ERROR;
+
+            nWritePos      += res;
+            if (nWritePos > nDataSize)
+                nDataSize       = nWritePos;
+
+            return res;
+        }
+
+        wssize_t RIFFWriter::seek(wsize_t offset)
+        {
+            if (pFD == NULL)
+                return -STATUS_CLOSED;
+
+            return nWritePos = lsp_min(offset, nDataSize);
+        }
+
+        status_t RIFFWriter::flush()
+        {
+            if (pFD == NULL)
+                return STATUS_CLOSED;
+
+            status_t res    = update_header();
+            return (res == STATUS_OK) ? pFD->flush() : res;
+        }
+
+    } /* namespace mm */
+} /* namespace lsp */
@@ -0,0 +1,424 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 1 апр. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/common/debug.h>
+#include <lsp-plug.in/mm/SampleCache.h>
+#include <lsp-plug.in/mm/InAudioFileStream.h>
+#include <lsp-plug.in/mm/InAudioResampler.h>
+#include <lsp-plug.in/runtime/system.h>
+
+#include <stdlib.h>
+
+namespace lsp
+{
+    namespace mm
+    {
+        static const size_t DECODE_FRAMES       = 0x10000;
+
+        SampleCache::Sample::Sample()
+        {
+            sFormat.srate       = 0;
+            sFormat.channels    = 0;
+            sFormat.frames      = 0;
+            sFormat.format      = SFMT_NONE;
+            pData               = NULL;
+            nBytes              = 0;
+            nRefs               = 0;
+            nStatus             = STATUS_LOADING;
+            pPrev               = NULL;
+            pNext               = NULL;
+        }
+
+        SampleCache::Sample::~Sample()
+        {
+            if (pData != NULL)
+            {
+                free(pData);
+                pData               = NULL;
+            }
+        }
+
+        SampleCache::SampleCache()
+        {
+            pHead               = NULL;
+            pTail               = NULL;
+
+            sStats.hits         = 0;
+            sStats.misses       = 0;
+            sStats.coalesced    = 0;
+            sStats.evictions    = 0;
+            sStats.items        = 0;
+            sStats.used         = 0;
+            sStats.bytes        = 0;
+            sStats.limit        = DEFAULT_LIMIT;
+        }
+
+        SampleCache::~SampleCache()
+        {
+            lltl::parray<Sample> items;
+            vItems.values(&items);
+            vItems.flush();
+
+            // Samples can not outlive the cache: release() requires the cache to exist,
+            // so referenced samples at this point indicate the violation of the contract
+            for (size_t i=0, n=items.size(); i<n; ++i)
+            {
+                Sample *s           = items.uget(i);
+                if (s->nRefs > 0)
+                    lsp_error("Sample %s is still referenced %d times", s->sKey.get_native(), int(s->nRefs));
+                delete s;
+            }
+
+            pHead               = NULL;
+            pTail               = NULL;
+        }
+
+        static ssize_t read_frames(IInAudioStream *is, void *dst, size_t nframes, size_t fmt)
+        {
+            switch (sformat_format(fmt))
+            {
+                case SFMT_U8:   return is->read_u8(dst, nframes);
+                case SFMT_S8:   return is->read_s8(dst, nframes);
+                case SFMT_U16:  return is->read_u16(dst, nframes);
+                case SFMT_S16:  return is->read_s16(dst, nframes);
+                case SFMT_U32:  return is->read_u32(dst, nframes);
+                case SFMT_S32:  return is->read_s32(dst, nframes);
+                case SFMT_F32:  return is->read_f32(dst, nframes);
+                case SFMT_F64:  return is->read_f64(dst, nframes);
+                default: break;
+            }
+            return -STATUS_UNSUPPORTED_FORMAT;
+        }
+
+        status_t SampleCache::make_key(LSPString *key, const io::Path *path, size_t format, size_t srate)
+        {
+            io::fattr_t attr;
+            status_t res = path->stat(&attr);
+            if (res != STATUS_OK)
+                return res;
+            if (attr.type == io::fattr_t::FT_DIRECTORY)
+                return STATUS_IS_DIRECTORY;
+
+            // The modification time and the size of the file invalidate the cached data
+            if (key->fmt_ascii("%llx:%llx:%x:%x:",
+                    (unsigned long long)(attr.mtime), (unsigned long long)(attr.size),
+                    int(format), int(srate)) <= 0)
+                return STATUS_NO_MEM;
+
+            return (key->append(path->as_string())) ? STATUS_OK : STATUS_NO_MEM;
+        }
+
+        status_t SampleCache::decode(Sample *s, const io::Path *path, size_t format, size_t srate)
+        {
+            InAudioFileStream fs;
+            InAudioResampler rs;
+            IInAudioStream *is  = &fs;
+
+            status_t res        = fs.open(path);
+            if (res != STATUS_OK)
+                return res;
+            if ((srate > 0) && (srate != fs.sample_rate()))
+            {
+                if ((res = rs.wrap(&fs, srate)) != STATUS_OK)
+                    return res;
+                is                  = &rs;
+            }
+
+            s->sFormat.srate    = is->sample_rate();
+            s->sFormat.channels = is->channels();
+            s->sFormat.format   = format;
+
+            size_t fsize        = sformat_size_of(format) * is->channels();
+            wsize_t capacity    = (is->length() > 0) ? is->length() : DECODE_FRAMES;
+            wsize_t frames      = 0;
+            uint8_t *data       = NULL;
+
+            while (true)
+            {
+                // Grow the buffer if the length of the stream is unknown or wrong
+                if (frames >= capacity)
+                    capacity           += lsp_max(capacity >> 1, DECODE_FRAMES);
+                uint8_t *ptr        = static_cast<uint8_t *>(realloc(data, capacity * fsize));
+                if (ptr == NULL)
+                {
+                    res                 = STATUS_NO_MEM;
+                    break;
+                }
+                data                = ptr;
+
+                // Read frames
+                ssize_t n           = read_frames(is, &data[frames * fsize], capacity - frames, format);
+                if (n <= 0)
+                {
+                    res                 = ((n == 0) || (n == -STATUS_EOF)) ? STATUS_OK : status_t(-n);
+                    break;
+                }
+                frames             += n;
+            }
+
+            rs.close();
+            fs.close();
+            if (res != STATUS_OK)
+            {
+                if (data != NULL)
+                    free(data);
+                return res;
+            }
+
+            // Release unused memory
+            if ((frames < capacity) && (frames > 0))
+            {
+                uint8_t *ptr        = static_cast<uint8_t *>(realloc(data, frames * fsize));
+                if (ptr != NULL)
+                    data                = ptr;
+            }
+
+            s->sFormat.frames   = frames;
+            s->pData            = data;
+            s->nBytes           = frames * fsize;
+
+            return STATUS_OK;
+        }
+
+        void SampleCache::lru_link(Sample *s)
+        {
+            s->pPrev            = NULL;
+            s->pNext            = pHead;
+            if (pHead != NULL)
+                pHead->pPrev        = s;
+            else
+                pTail               = s;
+            pHead               = s;
+        }
+
+        void SampleCache::lru_unlink(Sample *s)
+        {
+            if (s->pPrev != NULL)
+                s->pPrev->pNext     = s->pNext;
+            else
+                pHead               = s->pNext;
+            if (s->pNext != NULL)
+                s->pNext->pPrev     = s->pPrev;
+            else
+                pTail               = s->pPrev;
+
+            s->pPrev            = NULL;
+            s->pNext            = NULL;
+        }
+
+        void SampleCache::drop(Sample *s)
+        {
+            vItems.remove(&s->sKey);
+            sStats.bytes       -= s->nBytes;
+            delete s;
+        }
+
+        void SampleCache::evict(wsize_t limit)
+        {
+            while ((pTail != NULL) && ((sStats.bytes > limit) || (limit <= 0)))
+            {
+                Sample *s           = pTail;
+                lru_unlink(s);
+                drop(s);
+                ++sStats.evictions;
+            }
+        }
+
+        status_t SampleCache::acquire(Sample **dst, const char *path, size_t format, size_t srate)
+        {
+            if (path == NULL)
+                return STATUS_BAD_ARGUMENTS;
+            io::Path xpath;
+            status_t res = xpath.set(path);
+            return (res == STATUS_OK) ? acquire(dst, &xpath, format, srate) : res;
+        }
+
+        status_t SampleCache::acquire(Sample **dst, const LSPString *path, size_t format, size_t srate)
+        {
+            if (path == NULL)
+                return STATUS_BAD_ARGUMENTS;
+            io::Path xpath;
+            status_t res = xpath.set(path);
+            return (res == STATUS_OK) ? acquire(dst, &xpath, format, srate) : res;
+        }
+
+        status_t SampleCache::acquire(Sample **dst, const io::Path *path, size_t format, size_t srate)
+        {
+            if ((dst == NULL) || (path == NULL))
+                return STATUS_BAD_ARGUMENTS;
+
+            // Only formats with CPU byte order supported by IInAudioStream::read() are allowed
+            size_t endian       = sformat_endian(format);
+            format              = sformat_format(format);
+            if (((endian != SFMT_DFL) && (endian != SFMT_CPU)) ||
+                (format == SFMT_U24) || (format == SFMT_S24) ||
+                (sformat_size_of(format) <= 0))
+                return STATUS_UNSUPPORTED_FORMAT;
+
+            // Compute the canonical path and the key
+            io::Path cpath;
+            status_t res        = STATUS_OK;
+            if (!path->is_absolute())
+            {
+                if ((res = system::get_current_dir(&cpath)) == STATUS_OK)
+                    res                 = cpath.append_child(path);
+            }
+            else
+                res                 = cpath.set(path);
+            if (res == STATUS_OK)
+                res                 = cpath.canonicalize();
+
+            LSPString key;
+            if (res == STATUS_OK)
+                res                 = make_key(&key, &cpath, format, srate);
+            if (res != STATUS_OK)
+                return res;
+
+            // Lookup the cache, wait while the sample is being decoded by another request
+            bool waited         = false;
+            sCond.lock();
+            Sample *s;
+            while ((s = vItems.get(&key)) != NULL)
+            {
+                if (s->nStatus == STATUS_LOADING)
+                {
+                    waited              = true;
+                    sCond.wait();
+                    continue;
+                }
+
+                if ((s->nRefs++) == 0)
+                {
+                    lru_unlink(s);
+                    ++sStats.used;
+                }
+                ++sStats.hits;
+                if (waited)
+                    ++sStats.coalesced;
+                sCond.unlock();
+
+                *dst                = s;
+                return STATUS_OK;
+            }
+
+            // Create the placeholder for concurrent requests
+            s                   = new Sample();
+            if ((s == NULL) || (!s->sKey.set(&key)) || (!vItems.create(&s->sKey, s)))
+            {
+                sCond.unlock();
+                if (s != NULL)
+                    delete s;
+                return STATUS_NO_MEM;
+            }
+            s->nRefs            = 1;
+            ++sStats.misses;
+            ++sStats.used;
+            sCond.unlock();
+
+            // Decode the sample outside of the critical section
+            res                 = decode(s, &cpath, format, srate);
+
+            sCond.lock();
+            if (res == STATUS_OK)
+            {
+                s->nStatus          = STATUS_OK;
+                sStats.bytes       += s->nBytes;
+                evict(sStats.limit);
+            }
+            else
+            {
+                --sStats.used;
+                drop(s);
+                s                   = NULL;
+            }
+            sCond.notify_all();
+            sCond.unlock();
+
+            *dst                = s;
+            return res;
+        }
+
+        status_t SampleCache::release(Sample *s)
+        {
+            if (s == NULL)
+                return STATUS_BAD_ARGUMENTS;
+
+            status_t res        = STATUS_OK;
+            sCond.lock();
+            if ((s->nRefs <= 0) || (s->nStatus != STATUS_OK))
+                res                 = STATUS_BAD_STATE;
+            else if ((--s->nRefs) == 0)
+            {
+                lru_link(s);
+                --sStats.used;
+                evict(sStats.limit);
+            }
+            sCond.unlock();
+
+            return res;
+        }
+
+        void SampleCache::set_limit(wsize_t bytes)
+        {
+            sCond.lock();
+            sStats.limit        = bytes;
+            evict(sStats.limit);
+            sCond.unlock();
+        }
+
+        wsize_t SampleCache::limit() const
+        {
+            sCond.lock();
+            wsize_t res         = sStats.limit;
+            sCond.unlock();
+            return res;
+        }
+
+        void SampleCache::get_stats(stats_t *dst) const
+        {
+            if (dst == NULL)
+                return;
+
+            sCond.lock();
+            *dst                = sStats;
+            dst->items          = vItems.size();
+            sCond.unlock();
+        }
+
+        void SampleCache::reset_stats()
+        {
+            sCond.lock();
+            sStats.hits         = 0;
+            sStats.misses       = 0;
+            sStats.coalesced    = 0;
+            sStats.evictions    = 0;
+            sCond.unlock();
+        }
+
+        void SampleCache::clear()
+        {
+            sCond.lock();
+            evict(0);
+            sCond.unlock();
+        }
+
+    } /* namespace mm */
+} /* namespace lsp */
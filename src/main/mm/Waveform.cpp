@@ -0,0 +1,531 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 2 апр. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/mm/Waveform.h>
+#include <lsp-plug.in/common/alloc.h>
+#include <lsp-plug.in/common/endian.h>
+#include <lsp-plug.in/fmt/lspc/lspc.h>
+#include <lsp-plug.in/stdlib/math.h>
+#include <lsp-plug.in/stdlib/string.h>
+#include <private/mm/cvt.h>
+
+#include <float.h>
+#include <stdlib.h>
+
+#define BUF_FRAMES          0x400
+#define GROW_ITEMS          0x40
+
+namespace lsp
+{
+    namespace mm
+    {
+        /*
+         * The layout of the LSPC_CHUNK_WAVEFORM chunk:
+         *   - lspc::chunk_waveform_header_t header;
+         *   - entries of each level starting with the first one, the level L contains
+         *     ceil(frames / (base << L)) entries, each entry contains the peak_t
+         *     record for each channel, values are stored in big-endian byte order.
+         */
+        static inline void zero_peak(Waveform::peak_t *p)
+        {
+            p->min          = 0.0f;
+            p->max          = 0.0f;
+            p->rms          = 0.0f;
+        }
+
+        static wsize_t count_entries(wsize_t frames, size_t base, size_t level)
+        {
+            wsize_t step    = wsize_t(base) << level;
+            return frames / step + ((frames % step) ? 1 : 0);
+        }
+
+        static size_t count_levels(wsize_t frames, size_t base)
+        {
+            if (frames <= 0)
+                return 0;
+
+            for (size_t i=0; i<Waveform::MAX_LEVELS; ++i)
+                if (count_entries(frames, base, i) <= 1)
+                    return i + 1;
+            return Waveform::MAX_LEVELS;
+        }
+
+        Waveform::Waveform()
+        {
+            nChannels       = 0;
+            nSampleRate     = 0;
+            nBase           = DEFAULT_BASE;
+            nLevels         = 0;
+            nFrames         = 0;
+            bFinished       = false;
+            vAcc            = NULL;
+            vBuf            = NULL;
+            pData           = NULL;
+
+            for (size_t i=0; i<MAX_LEVELS; ++i)
+            {
+                level_t *l      = &vLevels[i];
+                l->vData        = NULL;
+                l->nItems       = 0;
+                l->nCap         = 0;
+                l->nFrames      = 0;
+            }
+        }
+
+        Waveform::~Waveform()
+        {
+            do_close();
+        }
+
+        void Waveform::do_close()
+        {
+            for (size_t i=0; i<MAX_LEVELS; ++i)
+            {
+                level_t *l      = &vLevels[i];
+                if (l->vData != NULL)
+                {
+                    ::free(l->vData);
+                    l->vData        = NULL;
+                }
+                l->nItems       = 0;
+                l->nCap         = 0;
+                l->nFrames      = 0;
+            }
+
+            if (pData != NULL)
+            {
+                ::free(pData);
+                pData           = NULL;
+            }
+            vAcc            = NULL;
+            vBuf            = NULL;
+
+            nChannels       = 0;
+            nSampleRate     = 0;
+            nLevels         = 0;
+            nFrames         = 0;
+            bFinished       = false;
+        }
+
+        void Waveform::destroy()
+        {
+            do_close();
+        }
+
+        status_t Waveform::init(size_t channels, size_t srate, size_t base)
+        {
+            if ((channels <= 0) || (channels > 0xffff) || (srate <= 0))
+                return STATUS_BAD_ARGUMENTS;
+            if ((base < MIN_BASE) || (base > MAX_BASE))
+                return STATUS_BAD_ARGUMENTS;
+
+            do_close();
+
+            size_t szof_acc     = align_size(MAX_LEVELS * channels * sizeof(acc_t), DEFAULT_ALIGN);
+            size_t szof_ptrs    = align_size(channels * sizeof(f32_t *), DEFAULT_ALIGN);
+            size_t szof_buf     = align_size(BUF_FRAMES * sizeof(f32_t), DEFAULT_ALIGN);
+            uint8_t *ptr        = static_cast<uint8_t *>(::malloc(szof_acc + szof_ptrs + szof_buf * channels));
+            if (ptr == NULL)
+                return STATUS_NO_MEM;
+            pData               = ptr;
+
+            vAcc                = reinterpret_cast<acc_t *>(ptr);
+            ptr                += szof_acc;
+            vBuf                = reinterpret_cast<f32_t **>(ptr);
+            ptr                += szof_ptrs;
+            for (size_t i=0; i<channels; ++i)
+            {
+                vBuf[i]             = reinterpret_cast<f32_t *>(ptr);
+                ptr                += szof_buf;
+            }
+
+            for (size_t i=0, n=MAX_LEVELS * channels; i<n; ++i)
+            {
+                acc_t *a            = &vAcc[i];
+                a->min              = FLT_MAX;
+                a->max              = -FLT_MAX;
+                a->sum              = 0.0;
+            }
+
+            nChannels           = channels;
+            nSampleRate         = srate;
+            nBase               = base;
+
+            return STATUS_OK;
+        }
+
+        bool Waveform::emit(size_t level)
+        {
+            level_t *l          = &vLevels[level];
+
+            // Ensure capacity
+            if (l->nItems >= l->nCap)
+            {
+                size_t cap          = l->nCap + lsp_max(l->nCap >> 1, size_t(GROW_ITEMS));
+                peak_t *data        = static_cast<peak_t *>(::realloc(l->vData, cap * nChannels * sizeof(peak_t)));
+                if (data == NULL)
+                    return false;
+                l->vData            = data;
+                l->nCap             = cap;
+            }
+
+            // Store the entry and fold it into the pending entry of the next level
+            acc_t *acc          = &vAcc[level * nChannels];
+            acc_t *next         = (level + 1 < MAX_LEVELS) ? &acc[nChannels] : NULL;
+            peak_t *p           = &l->vData[l->nItems * nChannels];
+            double k            = 1.0 / double(l->nFrames);
+
+            for (size_t i=0; i<nChannels; ++i)
+            {
+                acc_t *a            = &acc[i];
+                p[i].min            = a->min;
+                p[i].max            = a->max;
+                p[i].rms            = sqrt(a->sum * k);
+
+                if (next != NULL)
+                {
+                    acc_t *n            = &next[i];
+                    n->min              = lsp_min(n->min, a->min);
+                    n->max              = lsp_max(n->max, a->max);
+                    n->sum             += a->sum;
+                }
+
+                a->min              = FLT_MAX;
+                a->max              = -FLT_MAX;
+                a->sum              = 0.0;
+            }
+
+            ++l->nItems;
+            nLevels             = lsp_max(nLevels, level + 1);
+            if (next == NULL)
+            {
+                l->nFrames          = 0;
+                return true;
+            }
+
+            level_t *nl         = &vLevels[level + 1];
+            nl->nFrames        += l->nFrames;
+            l->nFrames          = 0;
+
+            return (nl->nFrames >= (wsize_t(nBase) << (level + 1))) ? emit(level + 1) : true;
+        }
+
+        status_t Waveform::process(const f32_t *src, size_t frames)
+        {
+            if ((pData == NULL) || (bFinished))
+                return STATUS_BAD_STATE;
+            else if (src == NULL)
+                return STATUS_BAD_ARGUMENTS;
+
+            const cvt_kernels_t *k  = cvt_kernels();
+            level_t *l              = &vLevels[0];
+            f32_t s[3];
+
+            while (frames > 0)
+            {
+                size_t n                = lsp_min(frames, size_t(BUF_FRAMES));
+                k->f32_to_f32_planar(vBuf, 0, src, nChannels, n);
+
+                for (size_t off=0; off < n; )
+                {
+                    // Update the pending entry of the first level
+                    size_t count            = lsp_min(size_t(n - off), size_t(nBase - l->nFrames));
+                    for (size_t i=0; i<nChannels; ++i)
+                    {
+                        acc_t *a                = &vAcc[i];
+                        s[0]                    = a->min;
+                        s[1]                    = a->max;
+                        s[2]                    = 0.0f;
+                        k->peak_f32(s, &vBuf[i][off], count);
+                        a->min                  = s[0];
+                        a->max                  = s[1];
+                        a->sum                 += s[2];
+                    }
+
+                    off                    += count;
+                    l->nFrames             += count;
+                    if ((l->nFrames >= wsize_t(nBase)) && (!emit(0)))
+                        return STATUS_NO_MEM;
+                }
+
+                src                    += n * nChannels;
+                frames                 -= n;
+                nFrames                += n;
+            }
+
+            return STATUS_OK;
+        }
+
+        status_t Waveform::finish()
+        {
+            if (pData == NULL)
+                return STATUS_BAD_STATE;
+            else if (bFinished)
+                return STATUS_OK;
+
+            // Store all pending entries
+            for (size_t i=0; i<MAX_LEVELS; ++i)
+            {
+                if ((vLevels[i].nFrames > 0) && (!emit(i)))
+                    return STATUS_NO_MEM;
+            }
+
+            // Drop the levels which do not improve the overview
+            nLevels             = count_levels(nFrames, nBase);
+            for (size_t i=nLevels; i<MAX_LEVELS; ++i)
+            {
+                level_t *l          = &vLevels[i];
+                if (l->vData != NULL)
+                {
+                    ::free(l->vData);
+                    l->vData            = NULL;
+                }
+                l->nItems           = 0;
+                l->nCap             = 0;
+            }
+
+            bFinished           = true;
+            return STATUS_OK;
+        }
+
+        status_t Waveform::query(peak_t *dst, size_t channel, wsize_t first, wsize_t count, size_t columns) const
+        {
+            if ((dst == NULL) || (channel >= nChannels) || (columns <= 0))
+                return STATUS_BAD_ARGUMENTS;
+
+            // Select the level with entries not wider than the column
+            wsize_t width       = count / columns;
+            size_t level        = 0;
+            while ((level + 1 < nLevels) && ((wsize_t(nBase) << (level + 1)) <= width))
+                ++level;
+
+            const level_t *l    = &vLevels[level];
+            wsize_t step        = wsize_t(nBase) << level;
+            wsize_t items       = (level < nLevels) ? l->nItems : 0;
+
+            for (size_t i=0; i<columns; ++i)
+            {
+                peak_t *p           = &dst[i];
+                wsize_t start       = first + (count * i) / columns;
+                wsize_t end         = first + (count * (i + 1)) / columns;
+                wsize_t i0          = start / step;
+                wsize_t i1          = lsp_min(lsp_max((end + step - 1) / step, i0 + 1), items);
+                if (i0 >= i1)
+                {
+                    zero_peak(p);
+                    continue;
+                }
+
+                // Combine entries covered by the column
+                const peak_t *s     = &l->vData[i0 * nChannels + channel];
+                f32_t vmin          = s->min;
+                f32_t vmax          = s->max;
+                double sum          = double(s->rms) * s->rms;
+                for (wsize_t j=i0+1; j<i1; ++j)
+                {
+                    s                  += nChannels;
+                    vmin                = lsp_min(vmin, s->min);
+                    vmax                = lsp_max(vmax, s->max);
+                    sum                += double(s->rms) * s->rms;
+                }
+
+                p->min              = vmin;
+                p->max              = vmax;
+                p->rms              = sqrt(sum / double(i1 - i0));
+            }
+
+            return STATUS_OK;
+        }
+
+        status_t Waveform::save(lspc::File *fd, uint32_t chunk_id, uint32_t *uid) const
+        {
+            if (fd == NULL)
+                return STATUS_BAD_ARGUMENTS;
+            else if ((pData == NULL) || (!bFinished))
+                return STATUS_BAD_STATE;
+
+            lspc::ChunkWriter *wr   = fd->write_chunk(LSPC_CHUNK_WAVEFORM);
+            if (wr == NULL)
+                return STATUS_NO_MEM;
+
+            lspc::chunk_waveform_header_t hdr;
+            ::memset(&hdr, 0, sizeof(hdr));
+            hdr.common.size     = sizeof(lspc::chunk_waveform_header_t);
+            hdr.common.version  = 1;
+            hdr.channels        = CPU_TO_BE(uint16_t(nChannels));
+            hdr.levels          = CPU_TO_BE(uint16_t(nLevels));
+            hdr.chunk_id        = CPU_TO_BE(uint32_t(chunk_id));
+            hdr.sample_rate     = CPU_TO_BE(uint32_t(nSampleRate));
+            hdr.base            = CPU_TO_BE(uint32_t(nBase));
+            hdr.frames          = CPU_TO_BE(uint64_t(nFrames));
+
+            status_t res        = wr->write_header(&hdr);
+
+            // Write entries of all levels
+            peak_t buf[BUF_FRAMES];
+            for (size_t i=0; (res == STATUS_OK) && (i<nLevels); ++i)
+            {
+                const level_t *l    = &vLevels[i];
+                const peak_t *src   = l->vData;
+                for (size_t n = l->nItems * nChannels; (res == STATUS_OK) && (n > 0); )
+                {
+                    size_t count        = lsp_min(n, size_t(BUF_FRAMES));
+                    ::memcpy(buf, src, count * sizeof(peak_t));
+                #ifdef ARCH_LE
+                    byte_swap(reinterpret_cast<uint32_t *>(buf), count * (sizeof(peak_t) / sizeof(uint32_t)));
+                #endif /* ARCH_LE */
+                    res                 = wr->write(buf, count * sizeof(peak_t));
+                    src                += count;
+                    n                  -= count;
+                }
+            }
+
+            status_t xr         = wr->close();
+            if ((res == STATUS_OK) && (uid != NULL))
+                *uid                = wr->unique_id();
+            delete wr;
+
+            return (res == STATUS_OK) ? xr : res;
+        }
+
+        status_t Waveform::read_levels(lspc::ChunkReader *rd, const uint32_t *chunk_id)
+        {
+            lspc::chunk_waveform_header_t hdr;
+            ssize_t nread       = rd->read_header(&hdr, sizeof(lspc::chunk_waveform_header_t));
+            if (nread < 0)
+                return status_t(-nread);
+
+            // Check version and decode header
+            if (hdr.common.version < 1)
+                return STATUS_CORRUPTED_FILE;
+            if (hdr.common.size < sizeof(lspc::chunk_waveform_header_t))
+                return STATUS_CORRUPTED_FILE;
+
+            size_t channels     = BE_TO_CPU(hdr.channels);
+            size_t levels       = BE_TO_CPU(hdr.levels);
+            size_t srate        = BE_TO_CPU(hdr.sample_rate);
+            size_t base         = BE_TO_CPU(hdr.base);
+            wsize_t frames      = BE_TO_CPU(hdr.frames);
+            if ((chunk_id != NULL) && (*chunk_id != BE_TO_CPU(hdr.chunk_id)))
+                return STATUS_NOT_FOUND;
+
+            if ((base < MIN_BASE) || (base > MAX_BASE))
+                return STATUS_CORRUPTED_FILE;
+            if (levels != count_levels(frames, base))
+                return STATUS_CORRUPTED_FILE;
+            if ((channels <= 0) || (channels > 0xffff))
+                return STATUS_CORRUPTED_FILE;
+
+            // The entries of all levels should fill the rest of the chunk
+            wsize_t total       = 0;
+            wsize_t max_items   = wsize_t(SIZE_MAX) / (channels * sizeof(peak_t));
+            for (size_t i=0; i<levels; ++i)
+            {
+                wsize_t items       = count_entries(frames, base, i);
+                if (items > max_items)
+                    return STATUS_CORRUPTED_FILE;
+                wsize_t bytes       = items * channels * sizeof(peak_t);
+                if (bytes > wsize_t(SIZE_MAX) - total)
+                    return STATUS_CORRUPTED_FILE;
+                total              += bytes;
+            }
+            wssize_t avail      = rd->remaining();
+            if (avail < 0)
+                return status_t(-avail);
+            if (wsize_t(avail) != total)
+                return STATUS_CORRUPTED_FILE;
+
+            status_t res        = init(channels, srate, base);
+            if (res != STATUS_OK)
+                return (res == STATUS_BAD_ARGUMENTS) ? STATUS_CORRUPTED_FILE : res;
+
+            // Read entries of all levels
+            for (size_t i=0; i<levels; ++i)
+            {
+                level_t *l          = &vLevels[i];
+                size_t items        = size_t(count_entries(frames, base, i));
+                size_t bytes        = items * channels * sizeof(peak_t);
+                l->vData            = static_cast<peak_t *>(::malloc(bytes));
+                if (l->vData == NULL)
+                {
+                    do_close();
+                    return STATUS_NO_MEM;
+                }
+                l->nCap             = items;
+
+                nread               = rd->read(l->vData, bytes);
+                if ((nread < 0) || (size_t(nread) != bytes))
+                {
+                    do_close();
+                    return (nread < 0) ? status_t(-nread) : STATUS_CORRUPTED_FILE;
+                }
+            #ifdef ARCH_LE
+                byte_swap(reinterpret_cast<uint32_t *>(l->vData), bytes / sizeof(uint32_t));
+            #endif /* ARCH_LE */
+                l->nItems           = items;
+            }
+
+            nLevels             = levels;
+            nFrames             = frames;
+            bFinished           = true;
+
+            return STATUS_OK;
+        }
+
+        status_t Waveform::load(lspc::File *fd, uint32_t uid)
+        {
+            if (fd == NULL)
+                return STATUS_BAD_ARGUMENTS;
+
+            lspc::ChunkReader *rd   = fd->read_chunk(uid, LSPC_CHUNK_WAVEFORM);
+            if (rd == NULL)
+                return STATUS_NOT_FOUND;
+
+            status_t res        = read_levels(rd, NULL);
+            rd->close();
+            delete rd;
+
+            return res;
+        }
+
+        status_t Waveform::load_related(lspc::File *fd, uint32_t chunk_id)
+        {
+            if (fd == NULL)
+                return STATUS_BAD_ARGUMENTS;
+
+            uint32_t uid        = 0;
+            while (true)
+            {
+                lspc::ChunkReader *rd   = fd->find_chunk(LSPC_CHUNK_WAVEFORM, &uid, uid + 1);
+                if (rd == NULL)
+                    return STATUS_NOT_FOUND;
+
+                status_t res        = read_levels(rd, &chunk_id);
+                rd->close();
+                delete rd;
+
+                if (res != STATUS_NOT_FOUND)
+                    return res;
+            }
+        }
+
+    } /* namespace mm */
+} /* namespace lsp */
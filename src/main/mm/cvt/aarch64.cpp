@@ -0,0 +1,748 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 28 мар. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/common/types.h>
+
+#if defined(ARCH_AARCH64) && defined(ARCH_LE)
+
+#include <private/mm/cvt.h>
+
+#include <arm_neon.h>
+
+/*
+ * Advanced SIMD is always available on AArch64, so there is no need
+ * in runtime checks. The conversion of floating-point values truncates
+ * towards zero like the generic implementation, samples out of the
+ * [-1, 1] range are saturated. Rounding routines use the round to nearest
+ * even conversion and generate the same dither noise sequence as the generic
+ * implementation.
+ */
+
+#define K_U8                (lsp::mm::f32_t(1.0 / 0x7f))
+#define K_S16               (lsp::mm::f32_t(1.0 / 0x7fff))
+#define K_S24               (lsp::mm::f32_t(1.0) / 0x7fffff)
+#define K_S32               (lsp::mm::f32_t(1.0 / 0x7fffffff))
+#define K_TPDF              (lsp::mm::f32_t(1.0 / 0x1000000))
+
+namespace lsp
+{
+    namespace mm
+    {
+        namespace asimd
+        {
+            static void u8_to_f32(void *dst, const void *src, size_t samples)
+            {
+                f32_t *d            = static_cast<f32_t *>(dst);
+                const uint8_t *s    = static_cast<const uint8_t *>(src);
+                const uint8x8_t sign = vdup_n_u8(0x80);
+
+                for ( ; samples >= 8; samples -= 8, s += 8, d += 8)
+                {
+                    int16x8_t x = vmovl_s8(vreinterpret_s8_u8(veor_u8(vld1_u8(s), sign)));
+
+                    vst1q_f32(&d[0], vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), K_U8));
+                    vst1q_f32(&d[4], vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))), K_U8));
+                }
+
+                generic::u8_to_f32(d, s, samples);
+            }
+
+            static void s16_to_f32(void *dst, const void *src, size_t samples)
+            {
+                f32_t *d            = static_cast<f32_t *>(dst);
+                const int16_t *s    = static_cast<const int16_t *>(src);
+
+                for ( ; samples >= 8; samples -= 8, s += 8, d += 8)
+                {
+                    int16x8_t x = vld1q_s16(s);
+
+                    vst1q_f32(&d[0], vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), K_S16));
+                    vst1q_f32(&d[4], vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))), K_S16));
+                }
+
+                generic::s16_to_f32(d, s, samples);
+            }
+
+            static void s24_to_f32(void *dst, const void *src, size_t samples)
+            {
+                f32_t *d            = static_cast<f32_t *>(dst);
+                const uint8_t *s    = static_cast<const uint8_t *>(src);
+
+                for ( ; samples >= 8; samples -= 8, s += 24, d += 8)
+                {
+                    // De-interleave bytes of 8 samples
+                    uint8x8x3_t b   = vld3_u8(s);
+                    uint16x8_t lo   = vorrq_u16(vmovl_u8(b.val[0]), vshlq_n_u16(vmovl_u8(b.val[1]), 8));
+                    int16x8_t hi    = vmovl_s8(vreinterpret_s8_u8(b.val[2]));
+
+                    int32x4_t x0    = vorrq_s32(vshlq_n_s32(vmovl_s16(vget_low_s16(hi)), 16),
+                                                vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(lo))));
+                    int32x4_t x1    = vorrq_s32(vshlq_n_s32(vmovl_s16(vget_high_s16(hi)), 16),
+                                                vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(lo))));
+
+                    vst1q_f32(&d[0], vmulq_n_f32(vcvtq_f32_s32(x0), K_S24));
+                    vst1q_f32(&d[4], vmulq_n_f32(vcvtq_f32_s32(x1), K_S24));
+                }
+
+                generic::s24_to_f32(d, s, samples);
+            }
+
+            static void s32_to_f32(void *dst, const void *src, size_t samples)
+            {
+                f32_t *d            = static_cast<f32_t *>(dst);
+                const int32_t *s    = static_cast<const int32_t *>(src);
+
+                for ( ; samples >= 8; samples -= 8, s += 8, d += 8)
+                {
+                    vst1q_f32(&d[0], vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(&s[0])), K_S32));
+                    vst1q_f32(&d[4], vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(&s[4])), K_S32));
+                }
+
+                generic::s32_to_f32(d, s, samples);
+            }
+
+            static void f64_to_f32(void *dst, const void *src, size_t samples)
+            {
+                f32_t *d            = static_cast<f32_t *>(dst);
+                const f64_t *s      = static_cast<const f64_t *>(src);
+
+                for ( ; samples >= 4; samples -= 4, s += 4, d += 4)
+                    vst1q_f32(d, vcvt_high_f32_f64(vcvt_f32_f64(vld1q_f64(&s[0])), vld1q_f64(&s[2])));
+
+                generic::f64_to_f32(d, s, samples);
+            }
+
+            static void f32_to_u8(void *dst, const void *src, size_t samples)
+            {
+                uint8_t *d          = static_cast<uint8_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+                const int32x4_t bias = vdupq_n_s32(0x80);
+
+                for ( ; samples >= 8; samples -= 8, s += 8, d += 8)
+                {
+                    int32x4_t x0    = vaddq_s32(vcvtq_s32_f32(vmulq_n_f32(vld1q_f32(&s[0]), 0x7f)), bias);
+                    int32x4_t x1    = vaddq_s32(vcvtq_s32_f32(vmulq_n_f32(vld1q_f32(&s[4]), 0x7f)), bias);
+
+                    vst1_u8(d, vqmovun_s16(vcombine_s16(vqmovn_s32(x0), vqmovn_s32(x1))));
+                }
+
+                generic::f32_to_u8(d, s, samples);
+            }
+
+            static void f32_to_s16(void *dst, const void *src, size_t samples)
+            {
+                int16_t *d          = static_cast<int16_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+
+                for ( ; samples >= 8; samples -= 8, s += 8, d += 8)
+                {
+                    int32x4_t x0    = vcvtq_s32_f32(vmulq_n_f32(vld1q_f32(&s[0]), 0x7fff));
+                    int32x4_t x1    = vcvtq_s32_f32(vmulq_n_f32(vld1q_f32(&s[4]), 0x7fff));
+
+                    vst1q_s16(d, vcombine_s16(vqmovn_s32(x0), vqmovn_s32(x1)));
+                }
+
+                generic::f32_to_s16(d, s, samples);
+            }
+
+            static void f32_to_s24(void *dst, const void *src, size_t samples)
+            {
+                uint8_t *d          = static_cast<uint8_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+
+                for ( ; samples >= 8; samples -= 8, s += 8, d += 24)
+                {
+                    uint32x4_t x0   = vreinterpretq_u32_s32(vcvtq_s32_f32(vmulq_n_f32(vld1q_f32(&s[0]), 0x7fffff)));
+                    uint32x4_t x1   = vreinterpretq_u32_s32(vcvtq_s32_f32(vmulq_n_f32(vld1q_f32(&s[4]), 0x7fffff)));
+
+                    // Interleave 3 lower bytes of each sample
+                    uint8x8x3_t b;
+                    b.val[0]        = vmovn_u16(vcombine_u16(vmovn_u32(x0), vmovn_u32(x1)));
+                    b.val[1]        = vmovn_u16(vcombine_u16(vshrn_n_u32(x0, 8), vshrn_n_u32(x1, 8)));
+                    b.val[2]        = vmovn_u16(vcombine_u16(vshrn_n_u32(x0, 16), vshrn_n_u32(x1, 16)));
+                    vst3_u8(d, b);
+                }
+
+                generic::f32_to_s24(d, s, samples);
+            }
+
+            static void f32_to_s32(void *dst, const void *src, size_t samples)
+            {
+                int32_t *d          = static_cast<int32_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+                const float64x2_t klo = vdupq_n_f64(-2147483647.0);
+                const float64x2_t khi = vdupq_n_f64(2147483647.0);
+
+                // The scaling is performed with double precision to keep 32-bit resolution,
+                // vminnmq returns the upper bound for NaN like SSE2 and generic implementations do
+                for ( ; samples >= 4; samples -= 4, s += 4, d += 4)
+                {
+                    float32x4_t x   = vld1q_f32(s);
+                    int64x2_t lo    = vcvtq_s64_f64(vmaxq_f64(vminnmq_f64(vmulq_n_f64(vcvt_f64_f32(vget_low_f32(x)), 0x7fffffff), khi), klo));
+                    int64x2_t hi    = vcvtq_s64_f64(vmaxq_f64(vminnmq_f64(vmulq_n_f64(vcvt_high_f64_f32(x), 0x7fffffff), khi), klo));
+
+                    vst1q_s32(d, vcombine_s32(vqmovn_s64(lo), vqmovn_s64(hi)));
+                }
+
+                generic::f32_to_s32(d, s, samples);
+            }
+
+            static void f32_to_f64(void *dst, const void *src, size_t samples)
+            {
+                f64_t *d            = static_cast<f64_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+
+                for ( ; samples >= 4; samples -= 4, s += 4, d += 4)
+                {
+                    float32x4_t x   = vld1q_f32(s);
+                    vst1q_f64(&d[0], vcvt_f64_f32(vget_low_f32(x)));
+                    vst1q_f64(&d[2], vcvt_high_f64_f32(x));
+                }
+
+                generic::f32_to_f64(d, s, samples);
+            }
+
+            static inline float32x4_t tpdf(uint32x4_t & seed)
+            {
+                uint32x4_t a    = seed;
+                a               = veorq_u32(a, vshlq_n_u32(a, 13));
+                a               = veorq_u32(a, vshrq_n_u32(a, 17));
+                a               = veorq_u32(a, vshlq_n_u32(a, 5));
+                uint32x4_t b    = a;
+                b               = veorq_u32(b, vshlq_n_u32(b, 13));
+                b               = veorq_u32(b, vshrq_n_u32(b, 17));
+                b               = veorq_u32(b, vshlq_n_u32(b, 5));
+                seed            = b;
+
+                int32x4_t x     = vsubq_s32(vreinterpretq_s32_u32(vshrq_n_u32(a, 8)), vreinterpretq_s32_u32(vshrq_n_u32(b, 8)));
+                return vmulq_n_f32(vcvtq_f32_s32(x), K_TPDF);
+            }
+
+            static inline int32x4_t quantize(float32x4_t x, float k, float32x4_t n, float lo, float hi)
+            {
+                float32x4_t y   = vaddq_f32(vmulq_n_f32(x, k), n);
+                y               = vminq_f32(vmaxq_f32(y, vdupq_n_f32(lo)), vdupq_n_f32(hi));
+                return vcvtnq_s32_f32(y);
+            }
+
+            static void f32_to_u8_round(void *dst, const void *src, size_t samples, cvt_dither_t *dither)
+            {
+                uint8_t *d          = static_cast<uint8_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+                const int32x4_t bias = vdupq_n_s32(0x80);
+                float32x4_t n0      = vdupq_n_f32(0.0f), n1 = n0;
+                uint32x4_t s0       = vdupq_n_u32(0), s1 = s0;
+
+                if (dither != NULL)
+                {
+                    s0                  = vld1q_u32(&dither->seed[0]);
+                    s1                  = vld1q_u32(&dither->seed[4]);
+                }
+
+                for ( ; samples >= 8; samples -= 8, s += 8, d += 8)
+                {
+                    if (dither != NULL)
+                    {
+                        n0          = tpdf(s0);
+                        n1          = tpdf(s1);
+                    }
+
+                    int32x4_t x0    = vaddq_s32(quantize(vld1q_f32(&s[0]), 0x7f, n0, -0x80, 0x7f), bias);
+                    int32x4_t x1    = vaddq_s32(quantize(vld1q_f32(&s[4]), 0x7f, n1, -0x80, 0x7f), bias);
+
+                    vst1_u8(d, vqmovun_s16(vcombine_s16(vqmovn_s32(x0), vqmovn_s32(x1))));
+                }
+
+                if (dither != NULL)
+                {
+                    vst1q_u32(&dither->seed[0], s0);
+                    vst1q_u32(&dither->seed[4], s1);
+                }
+
+                generic::f32_to_u8_round(d, s, samples, dither);
+            }
+
+            static void f32_to_s16_round(void *dst, const void *src, size_t samples, cvt_dither_t *dither)
+            {
+                int16_t *d          = static_cast<int16_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+                float32x4_t n0      = vdupq_n_f32(0.0f), n1 = n0;
+                uint32x4_t s0       = vdupq_n_u32(0), s1 = s0;
+
+                if (dither != NULL)
+                {
+                    s0                  = vld1q_u32(&dither->seed[0]);
+                    s1                  = vld1q_u32(&dither->seed[4]);
+                }
+
+                for ( ; samples >= 8; samples -= 8, s += 8, d += 8)
+                {
+                    if (dither != NULL)
+                    {
+                        n0          = tpdf(s0);
+                        n1          = tpdf(s1);
+                    }
+
+                    int32x4_t x0    = quantize(vld1q_f32(&s[0]), 0x7fff, n0, -0x8000, 0x7fff);
+                    int32x4_t x1    = quantize(vld1q_f32(&s[4]), 0x7fff, n1, -0x8000, 0x7fff);
+
+                    vst1q_s16(d, vcombine_s16(vqmovn_s32(x0), vqmovn_s32(x1)));
+                }
+
+                if (dither != NULL)
+                {
+                    vst1q_u32(&dither->seed[0], s0);
+                    vst1q_u32(&dither->seed[4], s1);
+                }
+
+                generic::f32_to_s16_round(d, s, samples, dither);
+            }
+
+            static void f32_to_s24_round(void *dst, const void *src, size_t samples, cvt_dither_t *dither)
+            {
+                uint8_t *d          = static_cast<uint8_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+                float32x4_t n0      = vdupq_n_f32(0.0f), n1 = n0;
+                uint32x4_t s0       = vdupq_n_u32(0), s1 = s0;
+
+                if (dither != NULL)
+                {
+                    s0                  = vld1q_u32(&dither->seed[0]);
+                    s1                  = vld1q_u32(&dither->seed[4]);
+                }
+
+                for ( ; samples >= 8; samples -= 8, s += 8, d += 24)
+                {
+                    if (dither != NULL)
+                    {
+                        n0          = tpdf(s0);
+                        n1          = tpdf(s1);
+                    }
+
+                    uint32x4_t x0   = vreinterpretq_u32_s32(quantize(vld1q_f32(&s[0]), 0x7fffff, n0, -0x800000, 0x7fffff));
+                    uint32x4_t x1   = vreinterpretq_u32_s32(quantize(vld1q_f32(&s[4]), 0x7fffff, n1, -0x800000, 0x7fffff));
+
+                    // Interleave 3 lower bytes of each sample
+                    uint8x8x3_t b;
+                    b.val[0]        = vmovn_u16(vcombine_u16(vmovn_u32(x0), vmovn_u32(x1)));
+                    b.val[1]        = vmovn_u16(vcombine_u16(vshrn_n_u32(x0, 8), vshrn_n_u32(x1, 8)));
+                    b.val[2]        = vmovn_u16(vcombine_u16(vshrn_n_u32(x0, 16), vshrn_n_u32(x1, 16)));
+                    vst3_u8(d, b);
+                }
+
+                if (dither != NULL)
+                {
+                    vst1q_u32(&dither->seed[0], s0);
+                    vst1q_u32(&dither->seed[4], s1);
+                }
+
+                generic::f32_to_s24_round(d, s, samples, dither);
+            }
+
+            static inline int32x2_t quantize_s32(float32x2_t x, float32x2_t n)
+            {
+                float64x2_t y   = vaddq_f64(vmulq_n_f64(vcvt_f64_f32(x), 0x7fffffff), vcvt_f64_f32(n));
+                y               = vminq_f64(vmaxq_f64(y, vdupq_n_f64(-2147483648.0)), vdupq_n_f64(2147483647.0));
+                return vqmovn_s64(vcvtnq_s64_f64(y));
+            }
+
+            static void f32_to_s32_round(void *dst, const void *src, size_t samples, cvt_dither_t *dither)
+            {
+                int32_t *d          = static_cast<int32_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+                float32x4_t n0      = vdupq_n_f32(0.0f), n1 = n0;
+                uint32x4_t s0       = vdupq_n_u32(0), s1 = s0;
+
+                if (dither != NULL)
+                {
+                    s0                  = vld1q_u32(&dither->seed[0]);
+                    s1                  = vld1q_u32(&dither->seed[4]);
+                }
+
+                // The scaling is performed with double precision to keep 32-bit resolution
+                for ( ; samples >= 8; samples -= 8, s += 8, d += 8)
+                {
+                    if (dither != NULL)
+                    {
+                        n0          = tpdf(s0);
+                        n1          = tpdf(s1);
+                    }
+
+                    float32x4_t x0  = vld1q_f32(&s[0]);
+                    float32x4_t x1  = vld1q_f32(&s[4]);
+
+                    vst1q_s32(&d[0], vcombine_s32(
+                        quantize_s32(vget_low_f32(x0), vget_low_f32(n0)),
+                        quantize_s32(vget_high_f32(x0), vget_high_f32(n0))));
+                    vst1q_s32(&d[4], vcombine_s32(
+                        quantize_s32(vget_low_f32(x1), vget_low_f32(n1)),
+                        quantize_s32(vget_high_f32(x1), vget_high_f32(n1))));
+                }
+
+                if (dither != NULL)
+                {
+                    vst1q_u32(&dither->seed[0], s0);
+                    vst1q_u32(&dither->seed[4], s1);
+                }
+
+                generic::f32_to_s32_round(d, s, samples, dither);
+            }
+
+            static void xs16_to_f32(void *dst, const void *src, size_t samples)
+            {
+                f32_t *d            = static_cast<f32_t *>(dst);
+                const uint8_t *s    = static_cast<const uint8_t *>(src);
+
+                for ( ; samples >= 8; samples -= 8, s += 16, d += 8)
+                {
+                    int16x8_t x = vreinterpretq_s16_u8(vrev16q_u8(vld1q_u8(s)));
+
+                    vst1q_f32(&d[0], vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), K_S16));
+                    vst1q_f32(&d[4], vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))), K_S16));
+                }
+
+                generic::xs16_to_f32(d, s, samples);
+            }
+
+            static void xs24_to_f32(void *dst, const void *src, size_t samples)
+            {
+                f32_t *d            = static_cast<f32_t *>(dst);
+                const uint8_t *s    = static_cast<const uint8_t *>(src);
+
+                for ( ; samples >= 8; samples -= 8, s += 24, d += 8)
+                {
+                    // De-interleave bytes of 8 samples, the most significant byte goes first
+                    uint8x8x3_t b   = vld3_u8(s);
+                    uint16x8_t lo   = vorrq_u16(vmovl_u8(b.val[2]), vshlq_n_u16(vmovl_u8(b.val[1]), 8));
+                    int16x8_t hi    = vmovl_s8(vreinterpret_s8_u8(b.val[0]));
+
+                    int32x4_t x0    = vorrq_s32(vshlq_n_s32(vmovl_s16(vget_low_s16(hi)), 16),
+                                                vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(lo))));
+                    int32x4_t x1    = vorrq_s32(vshlq_n_s32(vmovl_s16(vget_high_s16(hi)), 16),
+                                                vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(lo))));
+
+                    vst1q_f32(&d[0], vmulq_n_f32(vcvtq_f32_s32(x0), K_S24));
+                    vst1q_f32(&d[4], vmulq_n_f32(vcvtq_f32_s32(x1), K_S24));
+                }
+
+                generic::xs24_to_f32(d, s, samples);
+            }
+
+            static void xs32_to_f32(void *dst, const void *src, size_t samples)
+            {
+                f32_t *d            = static_cast<f32_t *>(dst);
+                const uint8_t *s    = static_cast<const uint8_t *>(src);
+
+                for ( ; samples >= 8; samples -= 8, s += 32, d += 8)
+                {
+                    int32x4_t x0    = vreinterpretq_s32_u8(vrev32q_u8(vld1q_u8(&s[0])));
+                    int32x4_t x1    = vreinterpretq_s32_u8(vrev32q_u8(vld1q_u8(&s[16])));
+
+                    vst1q_f32(&d[0], vmulq_n_f32(vcvtq_f32_s32(x0), K_S32));
+                    vst1q_f32(&d[4], vmulq_n_f32(vcvtq_f32_s32(x1), K_S32));
+                }
+
+                generic::xs32_to_f32(d, s, samples);
+            }
+
+            static void f32_to_xs16(void *dst, const void *src, size_t samples)
+            {
+                uint8_t *d          = static_cast<uint8_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+
+                for ( ; samples >= 8; samples -= 8, s += 8, d += 16)
+                {
+                    int32x4_t x0    = vcvtq_s32_f32(vmulq_n_f32(vld1q_f32(&s[0]), 0x7fff));
+                    int32x4_t x1    = vcvtq_s32_f32(vmulq_n_f32(vld1q_f32(&s[4]), 0x7fff));
+                    int16x8_t x     = vcombine_s16(vqmovn_s32(x0), vqmovn_s32(x1));
+
+                    vst1q_u8(d, vrev16q_u8(vreinterpretq_u8_s16(x)));
+                }
+
+                generic::f32_to_xs16(d, s, samples);
+            }
+
+            static void f32_to_xs24(void *dst, const void *src, size_t samples)
+            {
+                uint8_t *d          = static_cast<uint8_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+
+                for ( ; samples >= 8; samples -= 8, s += 8, d += 24)
+                {
+                    uint32x4_t x0   = vreinterpretq_u32_s32(vcvtq_s32_f32(vmulq_n_f32(vld1q_f32(&s[0]), 0x7fffff)));
+                    uint32x4_t x1   = vreinterpretq_u32_s32(vcvtq_s32_f32(vmulq_n_f32(vld1q_f32(&s[4]), 0x7fffff)));
+
+                    // Interleave 3 lower bytes of each sample, the most significant byte goes first
+                    uint8x8x3_t b;
+                    b.val[2]        = vmovn_u16(vcombine_u16(vmovn_u32(x0), vmovn_u32(x1)));
+                    b.val[1]        = vmovn_u16(vcombine_u16(vshrn_n_u32(x0, 8), vshrn_n_u32(x1, 8)));
+                    b.val[0]        = vmovn_u16(vcombine_u16(vshrn_n_u32(x0, 16), vshrn_n_u32(x1, 16)));
+                    vst3_u8(d, b);
+                }
+
+                generic::f32_to_xs24(d, s, samples);
+            }
+
+            static void f32_to_xs32(void *dst, const void *src, size_t samples)
+            {
+                uint8_t *d          = static_cast<uint8_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+                const float64x2_t klo = vdupq_n_f64(-2147483647.0);
+                const float64x2_t khi = vdupq_n_f64(2147483647.0);
+
+                // The scaling is performed with double precision to keep 32-bit resolution,
+                // vminnmq returns the upper bound for NaN like SSE2 and generic implementations do
+                for ( ; samples >= 4; samples -= 4, s += 4, d += 16)
+                {
+                    float32x4_t x   = vld1q_f32(s);
+                    int64x2_t lo    = vcvtq_s64_f64(vmaxq_f64(vminnmq_f64(vmulq_n_f64(vcvt_f64_f32(vget_low_f32(x)), 0x7fffffff), khi), klo));
+                    int64x2_t hi    = vcvtq_s64_f64(vmaxq_f64(vminnmq_f64(vmulq_n_f64(vcvt_high_f64_f32(x), 0x7fffffff), khi), klo));
+                    int32x4_t v     = vcombine_s32(vqmovn_s64(lo), vqmovn_s64(hi));
+
+                    vst1q_u8(d, vrev32q_u8(vreinterpretq_u8_s32(v)));
+                }
+
+                generic::f32_to_xs32(d, s, samples);
+            }
+
+            static void swap_f32(void *dst, const void *src, size_t samples)
+            {
+                uint8_t *d          = static_cast<uint8_t *>(dst);
+                const uint8_t *s    = static_cast<const uint8_t *>(src);
+
+                for ( ; samples >= 8; samples -= 8, s += 32, d += 32)
+                {
+                    uint8x16_t x0   = vld1q_u8(&s[0]);
+                    uint8x16_t x1   = vld1q_u8(&s[16]);
+
+                    vst1q_u8(&d[0], vrev32q_u8(x0));
+                    vst1q_u8(&d[16], vrev32q_u8(x1));
+                }
+
+                generic::swap_f32(d, s, samples);
+            }
+
+            static void s16_to_f32_planar(f32_t * const *dst, size_t off, const void *src, size_t channels, size_t frames)
+            {
+                // Only stereo streams are processed with SIMD
+                if ((channels != 2) || (dst[0] == NULL) || (dst[1] == NULL))
+                {
+                    generic::s16_to_f32_planar(dst, off, src, channels, frames);
+                    return;
+                }
+
+                f32_t *l            = &dst[0][off];
+                f32_t *r            = &dst[1][off];
+                const int16_t *s    = static_cast<const int16_t *>(src);
+                size_t i            = 0;
+
+                for ( ; (i + 8) <= frames; i += 8, s += 16)
+                {
+                    int16x8x2_t x   = vld2q_s16(s);
+
+                    vst1q_f32(&l[i],   vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x.val[0]))), K_S16));
+                    vst1q_f32(&l[i+4], vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(x.val[0]))), K_S16));
+                    vst1q_f32(&r[i],   vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x.val[1]))), K_S16));
+                    vst1q_f32(&r[i+4], vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(x.val[1]))), K_S16));
+                }
+
+                generic::s16_to_f32_planar(dst, off + i, s, channels, frames - i);
+            }
+
+            static void f32_to_f32_planar(f32_t * const *dst, size_t off, const void *src, size_t channels, size_t frames)
+            {
+                if ((channels != 2) || (dst[0] == NULL) || (dst[1] == NULL))
+                {
+                    generic::f32_to_f32_planar(dst, off, src, channels, frames);
+                    return;
+                }
+
+                f32_t *l            = &dst[0][off];
+                f32_t *r            = &dst[1][off];
+                const f32_t *s      = static_cast<const f32_t *>(src);
+                size_t i            = 0;
+
+                for ( ; (i + 4) <= frames; i += 4, s += 8)
+                {
+                    float32x4x2_t x = vld2q_f32(s);
+
+                    vst1q_f32(&l[i], x.val[0]);
+                    vst1q_f32(&r[i], x.val[1]);
+                }
+
+                generic::f32_to_f32_planar(dst, off + i, s, channels, frames - i);
+            }
+
+            static void f32_planar_to_s16(void *dst, const f32_t * const *src, size_t off, size_t channels, size_t frames)
+            {
+                if ((channels != 2) || (src[0] == NULL) || (src[1] == NULL))
+                {
+                    generic::f32_planar_to_s16(dst, src, off, channels, frames);
+                    return;
+                }
+
+                int16_t *d          = static_cast<int16_t *>(dst);
+                const f32_t *l      = &src[0][off];
+                const f32_t *r      = &src[1][off];
+                size_t i            = 0;
+
+                for ( ; (i + 8) <= frames; i += 8, d += 16)
+                {
+                    int32x4_t l0    = vcvtq_s32_f32(vmulq_n_f32(vld1q_f32(&l[i]), 0x7fff));
+                    int32x4_t l1    = vcvtq_s32_f32(vmulq_n_f32(vld1q_f32(&l[i+4]), 0x7fff));
+                    int32x4_t r0    = vcvtq_s32_f32(vmulq_n_f32(vld1q_f32(&r[i]), 0x7fff));
+                    int32x4_t r1    = vcvtq_s32_f32(vmulq_n_f32(vld1q_f32(&r[i+4]), 0x7fff));
+
+                    int16x8x2_t x;
+                    x.val[0]        = vcombine_s16(vqmovn_s32(l0), vqmovn_s32(l1));
+                    x.val[1]        = vcombine_s16(vqmovn_s32(r0), vqmovn_s32(r1));
+                    vst2q_s16(d, x);
+                }
+
+                generic::f32_planar_to_s16(d, src, off + i, channels, frames - i);
+            }
+
+            static void f32_planar_to_f32(void *dst, const f32_t * const *src, size_t off, size_t channels, size_t frames)
+            {
+                if ((channels != 2) || (src[0] == NULL) || (src[1] == NULL))
+                {
+                    generic::f32_planar_to_f32(dst, src, off, channels, frames);
+                    return;
+                }
+
+                f32_t *d            = static_cast<f32_t *>(dst);
+                const f32_t *l      = &src[0][off];
+                const f32_t *r      = &src[1][off];
+                size_t i            = 0;
+
+                for ( ; (i + 4) <= frames; i += 4, d += 8)
+                {
+                    float32x4x2_t x;
+                    x.val[0]        = vld1q_f32(&l[i]);
+                    x.val[1]        = vld1q_f32(&r[i]);
+                    vst2q_f32(d, x);
+                }
+
+                generic::f32_planar_to_f32(d, src, off + i, channels, frames - i);
+            }
+
+            static f32_t dot_f32(const f32_t *a, const f32_t *b, size_t count)
+            {
+                float32x4_t s0  = vdupq_n_f32(0.0f);
+                float32x4_t s1  = vdupq_n_f32(0.0f);
+
+                for ( ; count >= 8; count -= 8, a += 8, b += 8)
+                {
+                    s0              = vmlaq_f32(s0, vld1q_f32(&a[0]), vld1q_f32(&b[0]));
+                    s1              = vmlaq_f32(s1, vld1q_f32(&a[4]), vld1q_f32(&b[4]));
+                }
+                if (count >= 4)
+                {
+                    s0              = vmlaq_f32(s0, vld1q_f32(a), vld1q_f32(b));
+                    count          -= 4;
+                    a              += 4;
+                    b              += 4;
+                }
+
+                return vaddvq_f32(vaddq_f32(s0, s1)) + generic::dot_f32(a, b, count);
+            }
+
+            static void peak_f32(f32_t *dst, const f32_t *src, size_t count)
+            {
+                if (count < 4)
+                {
+                    generic::peak_f32(dst, src, count);
+                    return;
+                }
+
+                float32x4_t vmin    = vdupq_n_f32(dst[0]);
+                float32x4_t vmax    = vdupq_n_f32(dst[1]);
+                float32x4_t s0      = vdupq_n_f32(0.0f);
+                float32x4_t s1      = vdupq_n_f32(0.0f);
+
+                for ( ; count >= 8; count -= 8, src += 8)
+                {
+                    float32x4_t x0      = vld1q_f32(&src[0]);
+                    float32x4_t x1      = vld1q_f32(&src[4]);
+                    vmin                = vminq_f32(vmin, vminq_f32(x0, x1));
+                    vmax                = vmaxq_f32(vmax, vmaxq_f32(x0, x1));
+                    s0                  = vmlaq_f32(s0, x0, x0);
+                    s1                  = vmlaq_f32(s1, x1, x1);
+                }
+                if (count >= 4)
+                {
+                    float32x4_t x0      = vld1q_f32(src);
+                    vmin                = vminq_f32(vmin, x0);
+                    vmax                = vmaxq_f32(vmax, x0);
+                    s0                  = vmlaq_f32(s0, x0, x0);
+                    count              -= 4;
+                    src                += 4;
+                }
+
+                dst[0]              = vminvq_f32(vmin);
+                dst[1]              = vmaxvq_f32(vmax);
+                dst[2]             += vaddvq_f32(vaddq_f32(s0, s1));
+
+                generic::peak_f32(dst, src, count);
+            }
+
+            const cvt_kernels_t kernels =
+            {
+                "asimd",
+
+                u8_to_f32,
+                s16_to_f32,
+                s24_to_f32,
+                s32_to_f32,
+                f64_to_f32,
+
+                f32_to_u8,
+                f32_to_s16,
+                f32_to_s24,
+                f32_to_s32,
+                f32_to_f64,
+
+                f32_to_u8_round,
+                f32_to_s16_round,
+                f32_to_s24_round,
+                f32_to_s32_round,
+
+                xs16_to_f32,
+                xs24_to_f32,
+                xs32_to_f32,
+                f32_to_xs16,
+                f32_to_xs24,
+                f32_to_xs32,
+                swap_f32,
+
+                s16_to_f32_planar,
+                f32_to_f32_planar,
+                f32_planar_to_s16,
+                f32_planar_to_f32,
+
+                dot_f32,
+                peak_f32
+            };
+        }
+    }
+}
+
+#endif /* ARCH_AARCH64 && ARCH_LE */
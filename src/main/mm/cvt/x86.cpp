@@ -0,0 +1,1669 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 28 мар. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/common/types.h>
+
+#if defined(ARCH_X86)
+
+#include <lsp-plug.in/stdlib/string.h>
+#include <private/mm/cvt.h>
+
+#include <immintrin.h>
+
+/*
+ * Each routine processes the data with SIMD instructions and passes the tail
+ * to the generic implementation. The scaling factors and the truncation of the
+ * floating-point values match the generic implementation for all samples
+ * within the [-1, 1] range. Samples out of range are saturated.
+ *
+ * Rounding routines rely on the default rounding mode (round to nearest even)
+ * and generate the same dither noise sequence as the generic implementation:
+ * each 32-bit lane of the generator state corresponds to one of eight xorshift32
+ * generators used by the generic code.
+ */
+
+#define SSE2_TARGET         __attribute__ ((target("sse2")))
+#define SSSE3_TARGET        __attribute__ ((target("ssse3")))
+#define AVX2_TARGET         __attribute__ ((target("avx2")))
+
+#define K_U8                (lsp::mm::f32_t(1.0 / 0x7f))
+#define K_S16               (lsp::mm::f32_t(1.0 / 0x7fff))
+#define K_S24               (lsp::mm::f32_t(1.0) / 0x7fffff)
+#define K_S32               (lsp::mm::f32_t(1.0 / 0x7fffffff))
+#define K_TPDF              (lsp::mm::f32_t(1.0 / 0x1000000))
+
+namespace lsp
+{
+    namespace mm
+    {
+        namespace sse2
+        {
+            SSE2_TARGET
+            static void u8_to_f32(void *dst, const void *src, size_t samples)
+            {
+                f32_t *d            = static_cast<f32_t *>(dst);
+                const uint8_t *s    = static_cast<const uint8_t *>(src);
+                const __m128 k      = _mm_set1_ps(K_U8);
+                const __m128i sign  = _mm_set1_epi8(char(0x80));
+
+                for ( ; samples >= 16; samples -= 16, s += 16, d += 16)
+                {
+                    __m128i x   = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(s)), sign);
+                    __m128i lo  = _mm_unpacklo_epi8(x, x);
+                    __m128i hi  = _mm_unpackhi_epi8(x, x);
+
+                    _mm_storeu_ps(&d[0],  _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(lo, lo), 24)), k));
+                    _mm_storeu_ps(&d[4],  _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(lo, lo), 24)), k));
+                    _mm_storeu_ps(&d[8],  _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(hi, hi), 24)), k));
+                    _mm_storeu_ps(&d[12], _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(hi, hi), 24)), k));
+                }
+
+                generic::u8_to_f32(d, s, samples);
+            }
+
+            SSE2_TARGET
+            static void s16_to_f32(void *dst, const void *src, size_t samples)
+            {
+                f32_t *d            = static_cast<f32_t *>(dst);
+                const int16_t *s    = static_cast<const int16_t *>(src);
+                const __m128 k      = _mm_set1_ps(K_S16);
+
+                for ( ; samples >= 8; samples -= 8, s += 8, d += 8)
+                {
+                    __m128i x   = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s));
+
+                    _mm_storeu_ps(&d[0], _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16)), k));
+                    _mm_storeu_ps(&d[4], _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16)), k));
+                }
+
+                generic::s16_to_f32(d, s, samples);
+            }
+
+            SSE2_TARGET
+            static void s32_to_f32(void *dst, const void *src, size_t samples)
+            {
+                f32_t *d            = static_cast<f32_t *>(dst);
+                const int32_t *s    = static_cast<const int32_t *>(src);
+                const __m128 k      = _mm_set1_ps(K_S32);
+
+                for ( ; samples >= 8; samples -= 8, s += 8, d += 8)
+                {
+                    __m128i x0  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&s[0]));
+                    __m128i x1  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&s[4]));
+
+                    _mm_storeu_ps(&d[0], _mm_mul_ps(_mm_cvtepi32_ps(x0), k));
+                    _mm_storeu_ps(&d[4], _mm_mul_ps(_mm_cvtepi32_ps(x1), k));
+                }
+
+                generic::s32_to_f32(d, s, samples);
+            }
+
+            SSE2_TARGET
+            static void f64_to_f32(void *dst, const void *src, size_t samples)
+            {
+                f32_t *d            = static_cast<f32_t *>(dst);
+                const f64_t *s      = static_cast<const f64_t *>(src);
+
+                for ( ; samples >= 4; samples -= 4, s += 4, d += 4)
+                {
+                    __m128 lo   = _mm_cvtpd_ps(_mm_loadu_pd(&s[0]));
+                    __m128 hi   = _mm_cvtpd_ps(_mm_loadu_pd(&s[2]));
+
+                    _mm_storeu_ps(d, _mm_movelh_ps(lo, hi));
+                }
+
+                generic::f64_to_f32(d, s, samples);
+            }
+
+            SSE2_TARGET
+            static void f32_to_u8(void *dst, const void *src, size_t samples)
+            {
+                uint8_t *d          = static_cast<uint8_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+                const __m128 k      = _mm_set1_ps(0x7f);
+                const __m128i bias  = _mm_set1_epi32(0x80);
+
+                for ( ; samples >= 16; samples -= 16, s += 16, d += 16)
+                {
+                    __m128i x0  = _mm_add_epi32(_mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(&s[0]), k)), bias);
+                    __m128i x1  = _mm_add_epi32(_mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(&s[4]), k)), bias);
+                    __m128i x2  = _mm_add_epi32(_mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(&s[8]), k)), bias);
+                    __m128i x3  = _mm_add_epi32(_mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(&s[12]), k)), bias);
+
+                    x0          = _mm_packs_epi32(x0, x1);
+                    x2          = _mm_packs_epi32(x2, x3);
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(d), _mm_packus_epi16(x0, x2));
+                }
+
+                generic::f32_to_u8(d, s, samples);
+            }
+
+            SSE2_TARGET
+            static void f32_to_s16(void *dst, const void *src, size_t samples)
+            {
+                int16_t *d          = static_cast<int16_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+                const __m128 k      = _mm_set1_ps(0x7fff);
+
+                for ( ; samples >= 8; samples -= 8, s += 8, d += 8)
+                {
+                    __m128i x0  = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(&s[0]), k));
+                    __m128i x1  = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(&s[4]), k));
+
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(d), _mm_packs_epi32(x0, x1));
+                }
+
+                generic::f32_to_s16(d, s, samples);
+            }
+
+            SSE2_TARGET
+            static void f32_to_s32(void *dst, const void *src, size_t samples)
+            {
+                int32_t *d          = static_cast<int32_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+                const __m128d k     = _mm_set1_pd(0x7fffffff);
+                const __m128d lo    = _mm_set1_pd(-2147483647.0);
+                const __m128d hi    = _mm_set1_pd(2147483647.0);
+
+                // The scaling is performed with double precision to keep 32-bit resolution
+                for ( ; samples >= 4; samples -= 4, s += 4, d += 4)
+                {
+                    __m128 x    = _mm_loadu_ps(s);
+                    __m128d y0  = _mm_mul_pd(_mm_cvtps_pd(x), k);
+                    __m128d y1  = _mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(x, x)), k);
+                    __m128i i0  = _mm_cvttpd_epi32(_mm_max_pd(_mm_min_pd(y0, hi), lo));
+                    __m128i i1  = _mm_cvttpd_epi32(_mm_max_pd(_mm_min_pd(y1, hi), lo));
+
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(d), _mm_unpacklo_epi64(i0, i1));
+                }
+
+                generic::f32_to_s32(d, s, samples);
+            }
+
+            SSE2_TARGET
+            static void f32_to_f64(void *dst, const void *src, size_t samples)
+            {
+                f64_t *d            = static_cast<f64_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+
+                for ( ; samples >= 4; samples -= 4, s += 4, d += 4)
+                {
+                    __m128 x    = _mm_loadu_ps(s);
+                    _mm_storeu_pd(&d[0], _mm_cvtps_pd(x));
+                    _mm_storeu_pd(&d[2], _mm_cvtps_pd(_mm_movehl_ps(x, x)));
+                }
+
+                generic::f32_to_f64(d, s, samples);
+            }
+
+            SSE2_TARGET
+            static inline __m128 tpdf(__m128i & seed)
+            {
+                __m128i a   = seed;
+                a           = _mm_xor_si128(a, _mm_slli_epi32(a, 13));
+                a           = _mm_xor_si128(a, _mm_srli_epi32(a, 17));
+                a           = _mm_xor_si128(a, _mm_slli_epi32(a, 5));
+                __m128i b   = a;
+                b           = _mm_xor_si128(b, _mm_slli_epi32(b, 13));
+                b           = _mm_xor_si128(b, _mm_srli_epi32(b, 17));
+                b           = _mm_xor_si128(b, _mm_slli_epi32(b, 5));
+                seed        = b;
+
+                __m128i x   = _mm_sub_epi32(_mm_srli_epi32(a, 8), _mm_srli_epi32(b, 8));
+                return _mm_mul_ps(_mm_cvtepi32_ps(x), _mm_set1_ps(K_TPDF));
+            }
+
+            SSE2_TARGET
+            static void f32_to_u8_round(void *dst, const void *src, size_t samples, cvt_dither_t *dither)
+            {
+                uint8_t *d          = static_cast<uint8_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+                const __m128 k      = _mm_set1_ps(0x7f);
+                const __m128 lo     = _mm_set1_ps(-0x80);
+                const __m128 hi     = _mm_set1_ps(0x7f);
+                const __m128i bias  = _mm_set1_epi32(0x80);
+                __m128 n0           = _mm_setzero_ps(), n1 = n0, n2 = n0, n3 = n0;
+                __m128i s0          = _mm_setzero_si128(), s1 = s0;
+
+                if (dither != NULL)
+                {
+                    s0                  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&dither->seed[0]));
+                    s1                  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&dither->seed[4]));
+                }
+
+                for ( ; samples >= 16; samples -= 16, s += 16, d += 16)
+                {
+                    if (dither != NULL)
+                    {
+                        n0          = tpdf(s0);
+                        n1          = tpdf(s1);
+                        n2          = tpdf(s0);
+                        n3          = tpdf(s1);
+                    }
+
+                    __m128 y0   = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&s[0]), k), n0);
+                    __m128 y1   = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&s[4]), k), n1);
+                    __m128 y2   = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&s[8]), k), n2);
+                    __m128 y3   = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&s[12]), k), n3);
+
+                    __m128i x0  = _mm_add_epi32(_mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(y0, lo), hi)), bias);
+                    __m128i x1  = _mm_add_epi32(_mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(y1, lo), hi)), bias);
+                    __m128i x2  = _mm_add_epi32(_mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(y2, lo), hi)), bias);
+                    __m128i x3  = _mm_add_epi32(_mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(y3, lo), hi)), bias);
+
+                    x0          = _mm_packs_epi32(x0, x1);
+                    x2          = _mm_packs_epi32(x2, x3);
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(d), _mm_packus_epi16(x0, x2));
+                }
+
+                if (dither != NULL)
+                {
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(&dither->seed[0]), s0);
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(&dither->seed[4]), s1);
+                }
+
+                generic::f32_to_u8_round(d, s, samples, dither);
+            }
+
+            SSE2_TARGET
+            static void f32_to_s16_round(void *dst, const void *src, size_t samples, cvt_dither_t *dither)
+            {
+                int16_t *d          = static_cast<int16_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+                const __m128 k      = _mm_set1_ps(0x7fff);
+                const __m128 lo     = _mm_set1_ps(-0x8000);
+                const __m128 hi     = _mm_set1_ps(0x7fff);
+                __m128 n0           = _mm_setzero_ps(), n1 = n0;
+                __m128i s0          = _mm_setzero_si128(), s1 = s0;
+
+                if (dither != NULL)
+                {
+                    s0                  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&dither->seed[0]));
+                    s1                  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&dither->seed[4]));
+                }
+
+                for ( ; samples >= 8; samples -= 8, s += 8, d += 8)
+                {
+                    if (dither != NULL)
+                    {
+                        n0          = tpdf(s0);
+                        n1          = tpdf(s1);
+                    }
+
+                    __m128 y0   = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&s[0]), k), n0);
+                    __m128 y1   = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&s[4]), k), n1);
+
+                    __m128i x0  = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(y0, lo), hi));
+                    __m128i x1  = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(y1, lo), hi));
+
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(d), _mm_packs_epi32(x0, x1));
+                }
+
+                if (dither != NULL)
+                {
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(&dither->seed[0]), s0);
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(&dither->seed[4]), s1);
+                }
+
+                generic::f32_to_s16_round(d, s, samples, dither);
+            }
+
+            SSE2_TARGET
+            static void f32_to_s32_round(void *dst, const void *src, size_t samples, cvt_dither_t *dither)
+            {
+                int32_t *d          = static_cast<int32_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+                const __m128d k     = _mm_set1_pd(0x7fffffff);
+                const __m128d lo    = _mm_set1_pd(-2147483648.0);
+                const __m128d hi    = _mm_set1_pd(2147483647.0);
+                __m128 n0           = _mm_setzero_ps(), n1 = n0;
+                __m128i s0          = _mm_setzero_si128(), s1 = s0;
+
+                if (dither != NULL)
+                {
+                    s0                  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&dither->seed[0]));
+                    s1                  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&dither->seed[4]));
+                }
+
+                // The scaling is performed with double precision to keep 32-bit resolution
+                for ( ; samples >= 8; samples -= 8, s += 8, d += 8)
+                {
+                    if (dither != NULL)
+                    {
+                        n0          = tpdf(s0);
+                        n1          = tpdf(s1);
+                    }
+
+                    __m128 x0   = _mm_loadu_ps(&s[0]);
+                    __m128 x1   = _mm_loadu_ps(&s[4]);
+                    __m128d y0  = _mm_add_pd(_mm_mul_pd(_mm_cvtps_pd(x0), k), _mm_cvtps_pd(n0));
+                    __m128d y1  = _mm_add_pd(_mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(x0, x0)), k), _mm_cvtps_pd(_mm_movehl_ps(n0, n0)));
+                    __m128d y2  = _mm_add_pd(_mm_mul_pd(_mm_cvtps_pd(x1), k), _mm_cvtps_pd(n1));
+                    __m128d y3  = _mm_add_pd(_mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(x1, x1)), k), _mm_cvtps_pd(_mm_movehl_ps(n1, n1)));
+
+                    __m128i i0  = _mm_cvtpd_epi32(_mm_min_pd(_mm_max_pd(y0, lo), hi));
+                    __m128i i1  = _mm_cvtpd_epi32(_mm_min_pd(_mm_max_pd(y1, lo), hi));
+                    __m128i i2  = _mm_cvtpd_epi32(_mm_min_pd(_mm_max_pd(y2, lo), hi));
+                    __m128i i3  = _mm_cvtpd_epi32(_mm_min_pd(_mm_max_pd(y3, lo), hi));
+
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(&d[0]), _mm_unpacklo_epi64(i0, i1));
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(&d[4]), _mm_unpacklo_epi64(i2, i3));
+                }
+
+                if (dither != NULL)
+                {
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(&dither->seed[0]), s0);
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(&dither->seed[4]), s1);
+                }
+
+                generic::f32_to_s32_round(d, s, samples, dither);
+            }
+
+            SSE2_TARGET
+            static void s16_to_f32_planar(f32_t * const *dst, size_t off, const void *src, size_t channels, size_t frames)
+            {
+                // Only stereo streams are processed with SIMD
+                if ((channels != 2) || (dst[0] == NULL) || (dst[1] == NULL))
+                {
+                    generic::s16_to_f32_planar(dst, off, src, channels, frames);
+                    return;
+                }
+
+                f32_t *l            = &dst[0][off];
+                f32_t *r            = &dst[1][off];
+                const int16_t *s    = static_cast<const int16_t *>(src);
+                const __m128 k      = _mm_set1_ps(K_S16);
+                size_t i            = 0;
+
+                // Each 32-bit word contains left sample in the lower half and right sample in the upper half
+                for ( ; (i + 4) <= frames; i += 4, s += 8)
+                {
+                    __m128i x   = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s));
+
+                    _mm_storeu_ps(&l[i], _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(x, 16), 16)), k));
+                    _mm_storeu_ps(&r[i], _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(x, 16)), k));
+                }
+
+                generic::s16_to_f32_planar(dst, off + i, s, channels, frames - i);
+            }
+
+            SSE2_TARGET
+            static void f32_to_f32_planar(f32_t * const *dst, size_t off, const void *src, size_t channels, size_t frames)
+            {
+                if ((channels != 2) || (dst[0] == NULL) || (dst[1] == NULL))
+                {
+                    generic::f32_to_f32_planar(dst, off, src, channels, frames);
+                    return;
+                }
+
+                f32_t *l            = &dst[0][off];
+                f32_t *r            = &dst[1][off];
+                const f32_t *s      = static_cast<const f32_t *>(src);
+                size_t i            = 0;
+
+                for ( ; (i + 4) <= frames; i += 4, s += 8)
+                {
+                    __m128 x0   = _mm_loadu_ps(&s[0]);
+                    __m128 x1   = _mm_loadu_ps(&s[4]);
+
+                    _mm_storeu_ps(&l[i], _mm_shuffle_ps(x0, x1, 0x88));
+                    _mm_storeu_ps(&r[i], _mm_shuffle_ps(x0, x1, 0xdd));
+                }
+
+                generic::f32_to_f32_planar(dst, off + i, s, channels, frames - i);
+            }
+
+            SSE2_TARGET
+            static void f32_planar_to_s16(void *dst, const f32_t * const *src, size_t off, size_t channels, size_t frames)
+            {
+                if ((channels != 2) || (src[0] == NULL) || (src[1] == NULL))
+                {
+                    generic::f32_planar_to_s16(dst, src, off, channels, frames);
+                    return;
+                }
+
+                int16_t *d          = static_cast<int16_t *>(dst);
+                const f32_t *l      = &src[0][off];
+                const f32_t *r      = &src[1][off];
+                const __m128 k      = _mm_set1_ps(0x7fff);
+                size_t i            = 0;
+
+                for ( ; (i + 4) <= frames; i += 4, d += 8)
+                {
+                    __m128i xl  = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(&l[i]), k));
+                    __m128i xr  = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(&r[i]), k));
+
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(d),
+                        _mm_packs_epi32(_mm_unpacklo_epi32(xl, xr), _mm_unpackhi_epi32(xl, xr)));
+                }
+
+                generic::f32_planar_to_s16(d, src, off + i, channels, frames - i);
+            }
+
+            SSE2_TARGET
+            static void f32_planar_to_f32(void *dst, const f32_t * const *src, size_t off, size_t channels, size_t frames)
+            {
+                if ((channels != 2) || (src[0] == NULL) || (src[1] == NULL))
+                {
+                    generic::f32_planar_to_f32(dst, src, off, channels, frames);
+                    return;
+                }
+
+                f32_t *d            = static_cast<f32_t *>(dst);
+                const f32_t *l      = &src[0][off];
+                const f32_t *r      = &src[1][off];
+                size_t i            = 0;
+
+                for ( ; (i + 4) <= frames; i += 4, d += 8)
+                {
+                    __m128 xl   = _mm_loadu_ps(&l[i]);
+                    __m128 xr   = _mm_loadu_ps(&r[i]);
+
+                    _mm_storeu_ps(&d[0], _mm_unpacklo_ps(xl, xr));
+                    _mm_storeu_ps(&d[4], _mm_unpackhi_ps(xl, xr));
+                }
+
+                generic::f32_planar_to_f32(d, src, off + i, channels, frames - i);
+            }
+
+            SSE2_TARGET
+            static f32_t dot_f32(const f32_t *a, const f32_t *b, size_t count)
+            {
+                __m128 s0   = _mm_setzero_ps();
+                __m128 s1   = _mm_setzero_ps();
+
+                for ( ; count >= 8; count -= 8, a += 8, b += 8)
+                {
+                    s0          = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(&a[0]), _mm_loadu_ps(&b[0])));
+                    s1          = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(&a[4]), _mm_loadu_ps(&b[4])));
+                }
+                if (count >= 4)
+                {
+                    s0          = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(a), _mm_loadu_ps(b)));
+                    count      -= 4;
+                    a          += 4;
+                    b          += 4;
+                }
+
+                // Horizontal sum
+                s0          = _mm_add_ps(s0, s1);
+                s0          = _mm_add_ps(s0, _mm_movehl_ps(s0, s0));
+                s0          = _mm_add_ss(s0, _mm_shuffle_ps(s0, s0, 0x55));
+
+                return _mm_cvtss_f32(s0) + generic::dot_f32(a, b, count);
+            }
+
+            SSE2_TARGET
+            static void peak_f32(f32_t *dst, const f32_t *src, size_t count)
+            {
+                if (count < 4)
+                {
+                    generic::peak_f32(dst, src, count);
+                    return;
+                }
+
+                __m128 vmin = _mm_set1_ps(dst[0]);
+                __m128 vmax = _mm_set1_ps(dst[1]);
+                __m128 s0   = _mm_setzero_ps();
+                __m128 s1   = _mm_setzero_ps();
+
+                for ( ; count >= 8; count -= 8, src += 8)
+                {
+                    __m128 x0   = _mm_loadu_ps(&src[0]);
+                    __m128 x1   = _mm_loadu_ps(&src[4]);
+                    vmin        = _mm_min_ps(vmin, _mm_min_ps(x0, x1));
+                    vmax        = _mm_max_ps(vmax, _mm_max_ps(x0, x1));
+                    s0          = _mm_add_ps(s0, _mm_mul_ps(x0, x0));
+                    s1          = _mm_add_ps(s1, _mm_mul_ps(x1, x1));
+                }
+                if (count >= 4)
+                {
+                    __m128 x0   = _mm_loadu_ps(src);
+                    vmin        = _mm_min_ps(vmin, x0);
+                    vmax        = _mm_max_ps(vmax, x0);
+                    s0          = _mm_add_ps(s0, _mm_mul_ps(x0, x0));
+                    count      -= 4;
+                    src        += 4;
+                }
+
+                // Horizontal reduction
+                vmin        = _mm_min_ps(vmin, _mm_movehl_ps(vmin, vmin));
+                vmin        = _mm_min_ss(vmin, _mm_shuffle_ps(vmin, vmin, 0x55));
+                vmax        = _mm_max_ps(vmax, _mm_movehl_ps(vmax, vmax));
+                vmax        = _mm_max_ss(vmax, _mm_shuffle_ps(vmax, vmax, 0x55));
+                s0          = _mm_add_ps(s0, s1);
+                s0          = _mm_add_ps(s0, _mm_movehl_ps(s0, s0));
+                s0          = _mm_add_ss(s0, _mm_shuffle_ps(s0, s0, 0x55));
+
+                dst[0]      = _mm_cvtss_f32(vmin);
+                dst[1]      = _mm_cvtss_f32(vmax);
+                dst[2]     += _mm_cvtss_f32(s0);
+
+                generic::peak_f32(dst, src, count);
+            }
+
+            const cvt_kernels_t kernels =
+            {
+                "sse2",
+
+                u8_to_f32,
+                s16_to_f32,
+                generic::s24_to_f32,
+                s32_to_f32,
+                f64_to_f32,
+
+                f32_to_u8,
+                f32_to_s16,
+                generic::f32_to_s24,
+                f32_to_s32,
+                f32_to_f64,
+
+                f32_to_u8_round,
+                f32_to_s16_round,
+                generic::f32_to_s24_round,
+                f32_to_s32_round,
+
+                generic::xs16_to_f32,
+                generic::xs24_to_f32,
+                generic::xs32_to_f32,
+                generic::f32_to_xs16,
+                generic::f32_to_xs24,
+                generic::f32_to_xs32,
+                generic::swap_f32,
+
+                s16_to_f32_planar,
+                f32_to_f32_planar,
+                f32_planar_to_s16,
+                f32_planar_to_f32,
+
+                dot_f32,
+                peak_f32
+            };
+        }
+
+        namespace ssse3
+        {
+            SSSE3_TARGET
+            static void s24_to_f32(void *dst, const void *src, size_t samples)
+            {
+                f32_t *d            = static_cast<f32_t *>(dst);
+                const uint8_t *s    = static_cast<const uint8_t *>(src);
+                const __m128 k      = _mm_set1_ps(K_S24);
+
+                // Place 3 bytes of each sample to the upper bytes of 32-bit word
+                const __m128i shuf  = _mm_setr_epi8(
+                    -1, 0, 1, 2,   -1, 3, 4, 5,   -1, 6, 7, 8,   -1, 9, 10, 11);
+
+                // Each load reads 16 bytes for 4 samples, keep 2 samples as a margin
+                for ( ; samples >= 6; samples -= 4, s += 12, d += 4)
+                {
+                    __m128i x   = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(s)), shuf);
+                    _mm_storeu_ps(d, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(x, 8)), k));
+                }
+
+                generic::s24_to_f32(d, s, samples);
+            }
+
+            SSSE3_TARGET
+            static void f32_to_s24(void *dst, const void *src, size_t samples)
+            {
+                uint8_t *d          = static_cast<uint8_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+                const __m128 k      = _mm_set1_ps(0x7fffff);
+
+                // Pack 3 lower bytes of each 32-bit word
+                const __m128i shuf  = _mm_setr_epi8(
+                    0, 1, 2,   4, 5, 6,   8, 9, 10,   12, 13, 14,   -1, -1, -1, -1);
+
+                for ( ; samples >= 4; samples -= 4, s += 4, d += 12)
+                {
+                    __m128i x   = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(s), k));
+                    x           = _mm_shuffle_epi8(x, shuf);
+
+                    _mm_storel_epi64(reinterpret_cast<__m128i *>(d), x);
+                    int32_t tail    = _mm_cvtsi128_si32(_mm_srli_si128(x, 8));
+                    ::memcpy(&d[8], &tail, sizeof(tail));
+                }
+
+                generic::f32_to_s24(d, s, samples);
+            }
+
+            SSSE3_TARGET
+            static void f32_to_s24_round(void *dst, const void *src, size_t samples, cvt_dither_t *dither)
+            {
+                uint8_t *d          = static_cast<uint8_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+                const __m128 k      = _mm_set1_ps(0x7fffff);
+                const __m128 lo     = _mm_set1_ps(-0x800000);
+                const __m128 hi     = _mm_set1_ps(0x7fffff);
+                __m128 n0           = _mm_setzero_ps(), n1 = n0;
+                __m128i s0          = _mm_setzero_si128(), s1 = s0;
+
+                // Pack 3 lower bytes of each 32-bit word
+                const __m128i shuf  = _mm_setr_epi8(
+                    0, 1, 2,   4, 5, 6,   8, 9, 10,   12, 13, 14,   -1, -1, -1, -1);
+
+                if (dither != NULL)
+                {
+                    s0                  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&dither->seed[0]));
+                    s1                  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&dither->seed[4]));
+                }
+
+                for ( ; samples >= 8; samples -= 8, s += 8, d += 24)
+                {
+                    if (dither != NULL)
+                    {
+                        n0          = sse2::tpdf(s0);
+                        n1          = sse2::tpdf(s1);
+                    }
+
+                    __m128 y0   = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&s[0]), k), n0);
+                    __m128 y1   = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&s[4]), k), n1);
+                    __m128i x0  = _mm_shuffle_epi8(_mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(y0, lo), hi)), shuf);
+                    __m128i x1  = _mm_shuffle_epi8(_mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(y1, lo), hi)), shuf);
+
+                    // Merge 12 bytes of each vector into 24 contiguous bytes
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(d), _mm_or_si128(x0, _mm_slli_si128(x1, 12)));
+                    _mm_storel_epi64(reinterpret_cast<__m128i *>(&d[16]), _mm_srli_si128(x1, 4));
+                }
+
+                if (dither != NULL)
+                {
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(&dither->seed[0]), s0);
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(&dither->seed[4]), s1);
+                }
+
+                generic::f32_to_s24_round(d, s, samples, dither);
+            }
+
+            SSSE3_TARGET
+            static void xs16_to_f32(void *dst, const void *src, size_t samples)
+            {
+                f32_t *d            = static_cast<f32_t *>(dst);
+                const uint16_t *s   = static_cast<const uint16_t *>(src);
+                const __m128 k      = _mm_set1_ps(K_S16);
+                const __m128i shuf  = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+
+                for ( ; samples >= 8; samples -= 8, s += 8, d += 8)
+                {
+                    __m128i x   = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(s)), shuf);
+
+                    _mm_storeu_ps(&d[0], _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16)), k));
+                    _mm_storeu_ps(&d[4], _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16)), k));
+                }
+
+                generic::xs16_to_f32(d, s, samples);
+            }
+
+            SSSE3_TARGET
+            static void xs24_to_f32(void *dst, const void *src, size_t samples)
+            {
+                f32_t *d            = static_cast<f32_t *>(dst);
+                const uint8_t *s    = static_cast<const uint8_t *>(src);
+                const __m128 k      = _mm_set1_ps(K_S24);
+
+                // Place 3 bytes of each sample in reverse order to the upper bytes of 32-bit word
+                const __m128i shuf  = _mm_setr_epi8(
+                    -1, 2, 1, 0,   -1, 5, 4, 3,   -1, 8, 7, 6,   -1, 11, 10, 9);
+
+                // Each load reads 16 bytes for 4 samples, keep 2 samples as a margin
+                for ( ; samples >= 6; samples -= 4, s += 12, d += 4)
+                {
+                    __m128i x   = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(s)), shuf);
+                    _mm_storeu_ps(d, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(x, 8)), k));
+                }
+
+                generic::xs24_to_f32(d, s, samples);
+            }
+
+            SSSE3_TARGET
+            static void xs32_to_f32(void *dst, const void *src, size_t samples)
+            {
+                f32_t *d            = static_cast<f32_t *>(dst);
+                const uint32_t *s   = static_cast<const uint32_t *>(src);
+                const __m128 k      = _mm_set1_ps(K_S32);
+                const __m128i shuf  = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+                for ( ; samples >= 8; samples -= 8, s += 8, d += 8)
+                {
+                    __m128i x0  = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(&s[0])), shuf);
+                    __m128i x1  = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(&s[4])), shuf);
+
+                    _mm_storeu_ps(&d[0], _mm_mul_ps(_mm_cvtepi32_ps(x0), k));
+                    _mm_storeu_ps(&d[4], _mm_mul_ps(_mm_cvtepi32_ps(x1), k));
+                }
+
+                generic::xs32_to_f32(d, s, samples);
+            }
+
+            SSSE3_TARGET
+            static void f32_to_xs16(void *dst, const void *src, size_t samples)
+            {
+                uint16_t *d         = static_cast<uint16_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+                const __m128 k      = _mm_set1_ps(0x7fff);
+                const __m128i shuf  = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+
+                for ( ; samples >= 8; samples -= 8, s += 8, d += 8)
+                {
+                    __m128i x0  = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(&s[0]), k));
+                    __m128i x1  = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(&s[4]), k));
+
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(d), _mm_shuffle_epi8(_mm_packs_epi32(x0, x1), shuf));
+                }
+
+                generic::f32_to_xs16(d, s, samples);
+            }
+
+            SSSE3_TARGET
+            static void f32_to_xs24(void *dst, const void *src, size_t samples)
+            {
+                uint8_t *d          = static_cast<uint8_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+                const __m128 k      = _mm_set1_ps(0x7fffff);
+
+                // Pack 3 lower bytes of each 32-bit word in reverse order
+                const __m128i shuf  = _mm_setr_epi8(
+                    2, 1, 0,   6, 5, 4,   10, 9, 8,   14, 13, 12,   -1, -1, -1, -1);
+
+                for ( ; samples >= 4; samples -= 4, s += 4, d += 12)
+                {
+                    __m128i x   = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(s), k));
+                    x           = _mm_shuffle_epi8(x, shuf);
+
+                    _mm_storel_epi64(reinterpret_cast<__m128i *>(d), x);
+                    int32_t tail    = _mm_cvtsi128_si32(_mm_srli_si128(x, 8));
+                    ::memcpy(&d[8], &tail, sizeof(tail));
+                }
+
+                generic::f32_to_xs24(d, s, samples);
+            }
+
+            SSSE3_TARGET
+            static void f32_to_xs32(void *dst, const void *src, size_t samples)
+            {
+                uint32_t *d         = static_cast<uint32_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+                const __m128d k     = _mm_set1_pd(0x7fffffff);
+                const __m128d lo    = _mm_set1_pd(-2147483647.0);
+                const __m128d hi    = _mm_set1_pd(2147483647.0);
+                const __m128i shuf  = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+                // The scaling is performed with double precision to keep 32-bit resolution
+                for ( ; samples >= 4; samples -= 4, s += 4, d += 4)
+                {
+                    __m128 x    = _mm_loadu_ps(s);
+                    __m128d y0  = _mm_mul_pd(_mm_cvtps_pd(x), k);
+                    __m128d y1  = _mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(x, x)), k);
+                    __m128i i0  = _mm_cvttpd_epi32(_mm_max_pd(_mm_min_pd(y0, hi), lo));
+                    __m128i i1  = _mm_cvttpd_epi32(_mm_max_pd(_mm_min_pd(y1, hi), lo));
+
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(d), _mm_shuffle_epi8(_mm_unpacklo_epi64(i0, i1), shuf));
+                }
+
+                generic::f32_to_xs32(d, s, samples);
+            }
+
+            SSSE3_TARGET
+            static void swap_f32(void *dst, const void *src, size_t samples)
+            {
+                uint32_t *d         = static_cast<uint32_t *>(dst);
+                const uint32_t *s   = static_cast<const uint32_t *>(src);
+                const __m128i shuf  = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+                for ( ; samples >= 8; samples -= 8, s += 8, d += 8)
+                {
+                    __m128i x0  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&s[0]));
+                    __m128i x1  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&s[4]));
+
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(&d[0]), _mm_shuffle_epi8(x0, shuf));
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(&d[4]), _mm_shuffle_epi8(x1, shuf));
+                }
+
+                generic::swap_f32(d, s, samples);
+            }
+
+            const cvt_kernels_t kernels =
+            {
+                "ssse3",
+
+                sse2::u8_to_f32,
+                sse2::s16_to_f32,
+                s24_to_f32,
+                sse2::s32_to_f32,
+                sse2::f64_to_f32,
+
+                sse2::f32_to_u8,
+                sse2::f32_to_s16,
+                f32_to_s24,
+                sse2::f32_to_s32,
+                sse2::f32_to_f64,
+
+                sse2::f32_to_u8_round,
+                sse2::f32_to_s16_round,
+                f32_to_s24_round,
+                sse2::f32_to_s32_round,
+
+                xs16_to_f32,
+                xs24_to_f32,
+                xs32_to_f32,
+                f32_to_xs16,
+                f32_to_xs24,
+                f32_to_xs32,
+                swap_f32,
+
+                sse2::s16_to_f32_planar,
+                sse2::f32_to_f32_planar,
+                sse2::f32_planar_to_s16,
+                sse2::f32_planar_to_f32,
+
+                sse2::dot_f32,
+                sse2::peak_f32
+            };
+        }
+
+        namespace avx2
+        {
+            AVX2_TARGET
+            static void u8_to_f32(void *dst, const void *src, size_t samples)
+            {
+                f32_t *d            = static_cast<f32_t *>(dst);
+                const uint8_t *s    = static_cast<const uint8_t *>(src);
+                const __m256 k      = _mm256_set1_ps(K_U8);
+                const __m128i sign  = _mm_set1_epi8(char(0x80));
+
+                for ( ; samples >= 16; samples -= 16, s += 16, d += 16)
+                {
+                    __m128i x   = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(s)), sign);
+
+                    _mm256_storeu_ps(&d[0], _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(x)), k));
+                    _mm256_storeu_ps(&d[8], _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_srli_si128(x, 8))), k));
+                }
+
+                generic::u8_to_f32(d, s, samples);
+            }
+
+            AVX2_TARGET
+            static void s16_to_f32(void *dst, const void *src, size_t samples)
+            {
+                f32_t *d            = static_cast<f32_t *>(dst);
+                const int16_t *s    = static_cast<const int16_t *>(src);
+                const __m256 k      = _mm256_set1_ps(K_S16);
+
+                for ( ; samples >= 16; samples -= 16, s += 16, d += 16)
+                {
+                    __m128i x0  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&s[0]));
+                    __m128i x1  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&s[8]));
+
+                    _mm256_storeu_ps(&d[0], _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(x0)), k));
+                    _mm256_storeu_ps(&d[8], _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(x1)), k));
+                }
+
+                generic::s16_to_f32(d, s, samples);
+            }
+
+            AVX2_TARGET
+            static void s24_to_f32(void *dst, const void *src, size_t samples)
+            {
+                f32_t *d            = static_cast<f32_t *>(dst);
+                const uint8_t *s    = static_cast<const uint8_t *>(src);
+                const __m256 k      = _mm256_set1_ps(K_S24);
+                const __m256i shuf  = _mm256_setr_epi8(
+                    -1, 0, 1, 2,   -1, 3, 4, 5,   -1, 6, 7, 8,   -1, 9, 10, 11,
+                    -1, 0, 1, 2,   -1, 3, 4, 5,   -1, 6, 7, 8,   -1, 9, 10, 11);
+
+                // The last load reads 16 bytes at offset 12, keep 2 samples as a margin
+                for ( ; samples >= 10; samples -= 8, s += 24, d += 8)
+                {
+                    __m128i lo  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&s[0]));
+                    __m128i hi  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&s[12]));
+                    __m256i x   = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+
+                    x           = _mm256_srai_epi32(_mm256_shuffle_epi8(x, shuf), 8);
+                    _mm256_storeu_ps(d, _mm256_mul_ps(_mm256_cvtepi32_ps(x), k));
+                }
+
+                ssse3::s24_to_f32(d, s, samples);
+            }
+
+            AVX2_TARGET
+            static void s32_to_f32(void *dst, const void *src, size_t samples)
+            {
+                f32_t *d            = static_cast<f32_t *>(dst);
+                const int32_t *s    = static_cast<const int32_t *>(src);
+                const __m256 k      = _mm256_set1_ps(K_S32);
+
+                for ( ; samples >= 16; samples -= 16, s += 16, d += 16)
+                {
+                    __m256i x0  = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&s[0]));
+                    __m256i x1  = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&s[8]));
+
+                    _mm256_storeu_ps(&d[0], _mm256_mul_ps(_mm256_cvtepi32_ps(x0), k));
+                    _mm256_storeu_ps(&d[8], _mm256_mul_ps(_mm256_cvtepi32_ps(x1), k));
+                }
+
+                generic::s32_to_f32(d, s, samples);
+            }
+
+            AVX2_TARGET
+            static void f64_to_f32(void *dst, const void *src, size_t samples)
+            {
+                f32_t *d            = static_cast<f32_t *>(dst);
+                const f64_t *s      = static_cast<const f64_t *>(src);
+
+                for ( ; samples >= 8; samples -= 8, s += 8, d += 8)
+                {
+                    __m128 lo   = _mm256_cvtpd_ps(_mm256_loadu_pd(&s[0]));
+                    __m128 hi   = _mm256_cvtpd_ps(_mm256_loadu_pd(&s[4]));
+
+                    _mm256_storeu_ps(d, _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1));
+                }
+
+                generic::f64_to_f32(d, s, samples);
+            }
+
+            AVX2_TARGET
+            static void f32_to_u8(void *dst, const void *src, size_t samples)
+            {
+                uint8_t *d          = static_cast<uint8_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+                const __m256 k      = _mm256_set1_ps(0x7f);
+                const __m256i bias  = _mm256_set1_epi32(0x80);
+
+                for ( ; samples >= 32; samples -= 32, s += 32, d += 32)
+                {
+                    __m256i x0  = _mm256_add_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(&s[0]), k)), bias);
+                    __m256i x1  = _mm256_add_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(&s[8]), k)), bias);
+                    __m256i x2  = _mm256_add_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(&s[16]), k)), bias);
+                    __m256i x3  = _mm256_add_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(&s[24]), k)), bias);
+
+                    // Packing operates on 128-bit lanes, restore the order of 32-bit words at the end
+                    x0          = _mm256_packs_epi32(x0, x1);
+                    x2          = _mm256_packs_epi32(x2, x3);
+                    x0          = _mm256_packus_epi16(x0, x2);
+                    x0          = _mm256_permutevar8x32_epi32(x0, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(d), x0);
+                }
+
+                sse2::f32_to_u8(d, s, samples);
+            }
+
+            AVX2_TARGET
+            static void f32_to_s16(void *dst, const void *src, size_t samples)
+            {
+                int16_t *d          = static_cast<int16_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+                const __m256 k      = _mm256_set1_ps(0x7fff);
+
+                for ( ; samples >= 16; samples -= 16, s += 16, d += 16)
+                {
+                    __m256i x0  = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(&s[0]), k));
+                    __m256i x1  = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(&s[8]), k));
+
+                    // Packing operates on 128-bit lanes, restore the order of 64-bit words at the end
+                    x0          = _mm256_permute4x64_epi64(_mm256_packs_epi32(x0, x1), 0xd8);
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(d), x0);
+                }
+
+                generic::f32_to_s16(d, s, samples);
+            }
+
+            AVX2_TARGET
+            static void f32_to_s24(void *dst, const void *src, size_t samples)
+            {
+                uint8_t *d          = static_cast<uint8_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+                const __m256 k      = _mm256_set1_ps(0x7fffff);
+                const __m256i shuf  = _mm256_setr_epi8(
+                    0, 1, 2,   4, 5, 6,   8, 9, 10,   12, 13, 14,   -1, -1, -1, -1,
+                    0, 1, 2,   4, 5, 6,   8, 9, 10,   12, 13, 14,   -1, -1, -1, -1);
+
+                for ( ; samples >= 8; samples -= 8, s += 8, d += 24)
+                {
+                    __m256i x   = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(s), k));
+                    x           = _mm256_shuffle_epi8(x, shuf);
+                    __m128i lo  = _mm256_castsi256_si128(x);
+                    __m128i hi  = _mm256_extracti128_si256(x, 1);
+
+                    // Merge 12 bytes of each lane into 24 contiguous bytes
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(d), _mm_or_si128(lo, _mm_slli_si128(hi, 12)));
+                    _mm_storel_epi64(reinterpret_cast<__m128i *>(&d[16]), _mm_srli_si128(hi, 4));
+                }
+
+                ssse3::f32_to_s24(d, s, samples);
+            }
+
+            AVX2_TARGET
+            static void f32_to_s32(void *dst, const void *src, size_t samples)
+            {
+                int32_t *d          = static_cast<int32_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+                const __m256d k     = _mm256_set1_pd(0x7fffffff);
+                const __m256d lo    = _mm256_set1_pd(-2147483647.0);
+                const __m256d hi    = _mm256_set1_pd(2147483647.0);
+
+                // The scaling is performed with double precision to keep 32-bit resolution
+                for ( ; samples >= 8; samples -= 8, s += 8, d += 8)
+                {
+                    __m256d y0  = _mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(&s[0])), k);
+                    __m256d y1  = _mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(&s[4])), k);
+                    __m128i i0  = _mm256_cvttpd_epi32(_mm256_max_pd(_mm256_min_pd(y0, hi), lo));
+                    __m128i i1  = _mm256_cvttpd_epi32(_mm256_max_pd(_mm256_min_pd(y1, hi), lo));
+
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(d),
+                        _mm256_inserti128_si256(_mm256_castsi128_si256(i0), i1, 1));
+                }
+
+                generic::f32_to_s32(d, s, samples);
+            }
+
+            AVX2_TARGET
+            static void f32_to_f64(void *dst, const void *src, size_t samples)
+            {
+                f64_t *d            = static_cast<f64_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+
+                for ( ; samples >= 8; samples -= 8, s += 8, d += 8)
+                {
+                    _mm256_storeu_pd(&d[0], _mm256_cvtps_pd(_mm_loadu_ps(&s[0])));
+                    _mm256_storeu_pd(&d[4], _mm256_cvtps_pd(_mm_loadu_ps(&s[4])));
+                }
+
+                generic::f32_to_f64(d, s, samples);
+            }
+
+            AVX2_TARGET
+            static inline __m256 tpdf(__m256i & seed)
+            {
+                __m256i a   = seed;
+                a           = _mm256_xor_si256(a, _mm256_slli_epi32(a, 13));
+                a           = _mm256_xor_si256(a, _mm256_srli_epi32(a, 17));
+                a           = _mm256_xor_si256(a, _mm256_slli_epi32(a, 5));
+                __m256i b   = a;
+                b           = _mm256_xor_si256(b, _mm256_slli_epi32(b, 13));
+                b           = _mm256_xor_si256(b, _mm256_srli_epi32(b, 17));
+                b           = _mm256_xor_si256(b, _mm256_slli_epi32(b, 5));
+                seed        = b;
+
+                __m256i x   = _mm256_sub_epi32(_mm256_srli_epi32(a, 8), _mm256_srli_epi32(b, 8));
+                return _mm256_mul_ps(_mm256_cvtepi32_ps(x), _mm256_set1_ps(K_TPDF));
+            }
+
+            AVX2_TARGET
+            static void f32_to_u8_round(void *dst, const void *src, size_t samples, cvt_dither_t *dither)
+            {
+                uint8_t *d          = static_cast<uint8_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+                const __m256 k      = _mm256_set1_ps(0x7f);
+                const __m256 lo     = _mm256_set1_ps(-0x80);
+                const __m256 hi     = _mm256_set1_ps(0x7f);
+                const __m256i bias  = _mm256_set1_epi32(0x80);
+                __m256 n0           = _mm256_setzero_ps(), n1 = n0, n2 = n0, n3 = n0;
+                __m256i st          = _mm256_setzero_si256();
+
+                if (dither != NULL)
+                    st                  = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dither->seed));
+
+                for ( ; samples >= 32; samples -= 32, s += 32, d += 32)
+                {
+                    if (dither != NULL)
+                    {
+                        n0          = tpdf(st);
+                        n1          = tpdf(st);
+                        n2          = tpdf(st);
+                        n3          = tpdf(st);
+                    }
+
+                    __m256 y0   = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(&s[0]), k), n0);
+                    __m256 y1   = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(&s[8]), k), n1);
+                    __m256 y2   = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(&s[16]), k), n2);
+                    __m256 y3   = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(&s[24]), k), n3);
+
+                    __m256i x0  = _mm256_add_epi32(_mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(y0, lo), hi)), bias);
+                    __m256i x1  = _mm256_add_epi32(_mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(y1, lo), hi)), bias);
+                    __m256i x2  = _mm256_add_epi32(_mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(y2, lo), hi)), bias);
+                    __m256i x3  = _mm256_add_epi32(_mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(y3, lo), hi)), bias);
+
+                    // Packing operates on 128-bit lanes, restore the order of 32-bit words at the end
+                    x0          = _mm256_packs_epi32(x0, x1);
+                    x2          = _mm256_packs_epi32(x2, x3);
+                    x0          = _mm256_packus_epi16(x0, x2);
+                    x0          = _mm256_permutevar8x32_epi32(x0, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(d), x0);
+                }
+
+                if (dither != NULL)
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dither->seed), st);
+
+                sse2::f32_to_u8_round(d, s, samples, dither);
+            }
+
+            AVX2_TARGET
+            static void f32_to_s16_round(void *dst, const void *src, size_t samples, cvt_dither_t *dither)
+            {
+                int16_t *d          = static_cast<int16_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+                const __m256 k      = _mm256_set1_ps(0x7fff);
+                const __m256 lo     = _mm256_set1_ps(-0x8000);
+                const __m256 hi     = _mm256_set1_ps(0x7fff);
+                __m256 n0           = _mm256_setzero_ps(), n1 = n0;
+                __m256i st          = _mm256_setzero_si256();
+
+                if (dither != NULL)
+                    st                  = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dither->seed));
+
+                for ( ; samples >= 16; samples -= 16, s += 16, d += 16)
+                {
+                    if (dither != NULL)
+                    {
+                        n0          = tpdf(st);
+                        n1          = tpdf(st);
+                    }
+
+                    __m256 y0   = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(&s[0]), k), n0);
+                    __m256 y1   = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(&s[8]), k), n1);
+                    __m256i x0  = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(y0, lo), hi));
+                    __m256i x1  = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(y1, lo), hi));
+
+                    // Packing operates on 128-bit lanes, restore the order of 64-bit words at the end
+                    x0          = _mm256_permute4x64_epi64(_mm256_packs_epi32(x0, x1), 0xd8);
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(d), x0);
+                }
+
+                if (dither != NULL)
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dither->seed), st);
+
+                generic::f32_to_s16_round(d, s, samples, dither);
+            }
+
+            AVX2_TARGET
+            static void f32_to_s24_round(void *dst, const void *src, size_t samples, cvt_dither_t *dither)
+            {
+                uint8_t *d          = static_cast<uint8_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+                const __m256 k      = _mm256_set1_ps(0x7fffff);
+                const __m256 lo     = _mm256_set1_ps(-0x800000);
+                const __m256 hi     = _mm256_set1_ps(0x7fffff);
+                const __m256i shuf  = _mm256_setr_epi8(
+                    0, 1, 2,   4, 5, 6,   8, 9, 10,   12, 13, 14,   -1, -1, -1, -1,
+                    0, 1, 2,   4, 5, 6,   8, 9, 10,   12, 13, 14,   -1, -1, -1, -1);
+                __m256 n            = _mm256_setzero_ps();
+                __m256i st          = _mm256_setzero_si256();
+
+                if (dither != NULL)
+                    st                  = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dither->seed));
+
+                for ( ; samples >= 8; samples -= 8, s += 8, d += 24)
+                {
+                    if (dither != NULL)
+                        n           = tpdf(st);
+
+                    __m256 y    = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(s), k), n);
+                    __m256i x   = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(y, lo), hi));
+                    x           = _mm256_shuffle_epi8(x, shuf);
+                    __m128i xl  = _mm256_castsi256_si128(x);
+                    __m128i xh  = _mm256_extracti128_si256(x, 1);
+
+                    // Merge 12 bytes of each lane into 24 contiguous bytes
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(d), _mm_or_si128(xl, _mm_slli_si128(xh, 12)));
+                    _mm_storel_epi64(reinterpret_cast<__m128i *>(&d[16]), _mm_srli_si128(xh, 4));
+                }
+
+                if (dither != NULL)
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dither->seed), st);
+
+                generic::f32_to_s24_round(d, s, samples, dither);
+            }
+
+            AVX2_TARGET
+            static void f32_to_s32_round(void *dst, const void *src, size_t samples, cvt_dither_t *dither)
+            {
+                int32_t *d          = static_cast<int32_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+                const __m256d k     = _mm256_set1_pd(0x7fffffff);
+                const __m256d lo    = _mm256_set1_pd(-2147483648.0);
+                const __m256d hi    = _mm256_set1_pd(2147483647.0);
+                __m256 n            = _mm256_setzero_ps();
+                __m256i st          = _mm256_setzero_si256();
+
+                if (dither != NULL)
+                    st                  = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dither->seed));
+
+                // The scaling is performed with double precision to keep 32-bit resolution
+                for ( ; samples >= 8; samples -= 8, s += 8, d += 8)
+                {
+                    if (dither != NULL)
+                        n           = tpdf(st);
+
+                    __m256d y0  = _mm256_add_pd(
+                                    _mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(&s[0])), k),
+                                    _mm256_cvtps_pd(_mm256_castps256_ps128(n)));
+                    __m256d y1  = _mm256_add_pd(
+                                    _mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(&s[4])), k),
+                                    _mm256_cvtps_pd(_mm256_extractf128_ps(n, 1)));
+                    __m128i i0  = _mm256_cvtpd_epi32(_mm256_min_pd(_mm256_max_pd(y0, lo), hi));
+                    __m128i i1  = _mm256_cvtpd_epi32(_mm256_min_pd(_mm256_max_pd(y1, lo), hi));
+
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(d),
+                        _mm256_inserti128_si256(_mm256_castsi128_si256(i0), i1, 1));
+                }
+
+                if (dither != NULL)
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dither->seed), st);
+
+                generic::f32_to_s32_round(d, s, samples, dither);
+            }
+
+            AVX2_TARGET
+            static void xs16_to_f32(void *dst, const void *src, size_t samples)
+            {
+                f32_t *d            = static_cast<f32_t *>(dst);
+                const uint16_t *s   = static_cast<const uint16_t *>(src);
+                const __m256 k      = _mm256_set1_ps(K_S16);
+                const __m128i shuf  = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+
+                for ( ; samples >= 16; samples -= 16, s += 16, d += 16)
+                {
+                    __m128i x0  = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(&s[0])), shuf);
+                    __m128i x1  = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(&s[8])), shuf);
+
+                    _mm256_storeu_ps(&d[0], _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(x0)), k));
+                    _mm256_storeu_ps(&d[8], _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(x1)), k));
+                }
+
+                generic::xs16_to_f32(d, s, samples);
+            }
+
+            AVX2_TARGET
+            static void xs24_to_f32(void *dst, const void *src, size_t samples)
+            {
+                f32_t *d            = static_cast<f32_t *>(dst);
+                const uint8_t *s    = static_cast<const uint8_t *>(src);
+                const __m256 k      = _mm256_set1_ps(K_S24);
+                const __m256i shuf  = _mm256_setr_epi8(
+                    -1, 2, 1, 0,   -1, 5, 4, 3,   -1, 8, 7, 6,   -1, 11, 10, 9,
+                    -1, 2, 1, 0,   -1, 5, 4, 3,   -1, 8, 7, 6,   -1, 11, 10, 9);
+
+                // The last load reads 16 bytes at offset 12, keep 2 samples as a margin
+                for ( ; samples >= 10; samples -= 8, s += 24, d += 8)
+                {
+                    __m128i lo  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&s[0]));
+                    __m128i hi  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&s[12]));
+                    __m256i x   = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+
+                    x           = _mm256_srai_epi32(_mm256_shuffle_epi8(x, shuf), 8);
+                    _mm256_storeu_ps(d, _mm256_mul_ps(_mm256_cvtepi32_ps(x), k));
+                }
+
+                ssse3::xs24_to_f32(d, s, samples);
+            }
+
+            AVX2_TARGET
+            static void xs32_to_f32(void *dst, const void *src, size_t samples)
+            {
+                f32_t *d            = static_cast<f32_t *>(dst);
+                const uint32_t *s   = static_cast<const uint32_t *>(src);
+                const __m256 k      = _mm256_set1_ps(K_S32);
+                const __m256i shuf  = _mm256_setr_epi8(
+                    3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                    3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+                for ( ; samples >= 16; samples -= 16, s += 16, d += 16)
+                {
+                    __m256i x0  = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(&s[0])), shuf);
+                    __m256i x1  = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(&s[8])), shuf);
+
+                    _mm256_storeu_ps(&d[0], _mm256_mul_ps(_mm256_cvtepi32_ps(x0), k));
+                    _mm256_storeu_ps(&d[8], _mm256_mul_ps(_mm256_cvtepi32_ps(x1), k));
+                }
+
+                generic::xs32_to_f32(d, s, samples);
+            }
+
+            AVX2_TARGET
+            static void f32_to_xs16(void *dst, const void *src, size_t samples)
+            {
+                uint16_t *d         = static_cast<uint16_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+                const __m256 k      = _mm256_set1_ps(0x7fff);
+                const __m256i shuf  = _mm256_setr_epi8(
+                    1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                    1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+
+                for ( ; samples >= 16; samples -= 16, s += 16, d += 16)
+                {
+                    __m256i x0  = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(&s[0]), k));
+                    __m256i x1  = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(&s[8]), k));
+
+                    // Packing operates on 128-bit lanes, restore the order of 64-bit words at the end
+                    x0          = _mm256_permute4x64_epi64(_mm256_packs_epi32(x0, x1), 0xd8);
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(d), _mm256_shuffle_epi8(x0, shuf));
+                }
+
+                generic::f32_to_xs16(d, s, samples);
+            }
+
+            AVX2_TARGET
+            static void f32_to_xs24(void *dst, const void *src, size_t samples)
+            {
+                uint8_t *d          = static_cast<uint8_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+                const __m256 k      = _mm256_set1_ps(0x7fffff);
+                const __m256i shuf  = _mm256_setr_epi8(
+                    2, 1, 0,   6, 5, 4,   10, 9, 8,   14, 13, 12,   -1, -1, -1, -1,
+                    2, 1, 0,   6, 5, 4,   10, 9, 8,   14, 13, 12,   -1, -1, -1, -1);
+
+                for ( ; samples >= 8; samples -= 8, s += 8, d += 24)
+                {
+                    __m256i x   = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(s), k));
+                    x           = _mm256_shuffle_epi8(x, shuf);
+                    __m128i lo  = _mm256_castsi256_si128(x);
+                    __m128i hi  = _mm256_extracti128_si256(x, 1);
+
+                    // Merge 12 bytes of each lane into 24 contiguous bytes
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(d), _mm_or_si128(lo, _mm_slli_si128(hi, 12)));
+                    _mm_storel_epi64(reinterpret_cast<__m128i *>(&d[16]), _mm_srli_si128(hi, 4));
+                }
+
+                ssse3::f32_to_xs24(d, s, samples);
+            }
+
+            AVX2_TARGET
+            static void f32_to_xs32(void *dst, const void *src, size_t samples)
+            {
+                uint32_t *d         = static_cast<uint32_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+                const __m256d k     = _mm256_set1_pd(0x7fffffff);
+                const __m256d lo    = _mm256_set1_pd(-2147483647.0);
+                const __m256d hi    = _mm256_set1_pd(2147483647.0);
+                const __m256i shuf  = _mm256_setr_epi8(
+                    3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                    3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+                // The scaling is performed with double precision to keep 32-bit resolution
+                for ( ; samples >= 8; samples -= 8, s += 8, d += 8)
+                {
+                    __m256d y0  = _mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(&s[0])), k);
+                    __m256d y1  = _mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(&s[4])), k);
+                    __m128i i0  = _mm256_cvttpd_epi32(_mm256_max_pd(_mm256_min_pd(y0, hi), lo));
+                    __m128i i1  = _mm256_cvttpd_epi32(_mm256_max_pd(_mm256_min_pd(y1, hi), lo));
+                    __m256i x   = _mm256_inserti128_si256(_mm256_castsi128_si256(i0), i1, 1);
+
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(d), _mm256_shuffle_epi8(x, shuf));
+                }
+
+                generic::f32_to_xs32(d, s, samples);
+            }
+
+            AVX2_TARGET
+            static void swap_f32(void *dst, const void *src, size_t samples)
+            {
+                uint32_t *d         = static_cast<uint32_t *>(dst);
+                const uint32_t *s   = static_cast<const uint32_t *>(src);
+                const __m256i shuf  = _mm256_setr_epi8(
+                    3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                    3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+                for ( ; samples >= 16; samples -= 16, s += 16, d += 16)
+                {
+                    __m256i x0  = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&s[0]));
+                    __m256i x1  = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&s[8]));
+
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(&d[0]), _mm256_shuffle_epi8(x0, shuf));
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(&d[8]), _mm256_shuffle_epi8(x1, shuf));
+                }
+
+                ssse3::swap_f32(d, s, samples);
+            }
+
+            AVX2_TARGET
+            static void s16_to_f32_planar(f32_t * const *dst, size_t off, const void *src, size_t channels, size_t frames)
+            {
+                if ((channels != 2) || (dst[0] == NULL) || (dst[1] == NULL))
+                {
+                    generic::s16_to_f32_planar(dst, off, src, channels, frames);
+                    return;
+                }
+
+                f32_t *l            = &dst[0][off];
+                f32_t *r            = &dst[1][off];
+                const int16_t *s    = static_cast<const int16_t *>(src);
+                const __m256 k      = _mm256_set1_ps(K_S16);
+                size_t i            = 0;
+
+                for ( ; (i + 8) <= frames; i += 8, s += 16)
+                {
+                    __m256i x   = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s));
+
+                    _mm256_storeu_ps(&l[i], _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srai_epi32(_mm256_slli_epi32(x, 16), 16)), k));
+                    _mm256_storeu_ps(&r[i], _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srai_epi32(x, 16)), k));
+                }
+
+                sse2::s16_to_f32_planar(dst, off + i, s, channels, frames - i);
+            }
+
+            AVX2_TARGET
+            static void f32_to_f32_planar(f32_t * const *dst, size_t off, const void *src, size_t channels, size_t frames)
+            {
+                if ((channels != 2) || (dst[0] == NULL) || (dst[1] == NULL))
+                {
+                    generic::f32_to_f32_planar(dst, off, src, channels, frames);
+                    return;
+                }
+
+                f32_t *l            = &dst[0][off];
+                f32_t *r            = &dst[1][off];
+                const f32_t *s      = static_cast<const f32_t *>(src);
+                size_t i            = 0;
+
+                // Shuffling operates on 128-bit lanes, restore the order of 64-bit words at the end
+                for ( ; (i + 8) <= frames; i += 8, s += 16)
+                {
+                    __m256 x0   = _mm256_loadu_ps(&s[0]);
+                    __m256 x1   = _mm256_loadu_ps(&s[8]);
+                    __m256d xl  = _mm256_castps_pd(_mm256_shuffle_ps(x0, x1, 0x88));
+                    __m256d xr  = _mm256_castps_pd(_mm256_shuffle_ps(x0, x1, 0xdd));
+
+                    _mm256_storeu_ps(&l[i], _mm256_castpd_ps(_mm256_permute4x64_pd(xl, 0xd8)));
+                    _mm256_storeu_ps(&r[i], _mm256_castpd_ps(_mm256_permute4x64_pd(xr, 0xd8)));
+                }
+
+                sse2::f32_to_f32_planar(dst, off + i, s, channels, frames - i);
+            }
+
+            AVX2_TARGET
+            static void f32_planar_to_s16(void *dst, const f32_t * const *src, size_t off, size_t channels, size_t frames)
+            {
+                if ((channels != 2) || (src[0] == NULL) || (src[1] == NULL))
+                {
+                    generic::f32_planar_to_s16(dst, src, off, channels, frames);
+                    return;
+                }
+
+                int16_t *d          = static_cast<int16_t *>(dst);
+                const f32_t *l      = &src[0][off];
+                const f32_t *r      = &src[1][off];
+                const __m256 k      = _mm256_set1_ps(0x7fff);
+                size_t i            = 0;
+
+                // Interleaving and packing both operate on 128-bit lanes, so the order of frames is kept
+                for ( ; (i + 8) <= frames; i += 8, d += 16)
+                {
+                    __m256i xl  = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(&l[i]), k));
+                    __m256i xr  = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(&r[i]), k));
+
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(d),
+                        _mm256_packs_epi32(_mm256_unpacklo_epi32(xl, xr), _mm256_unpackhi_epi32(xl, xr)));
+                }
+
+                sse2::f32_planar_to_s16(d, src, off + i, channels, frames - i);
+            }
+
+            AVX2_TARGET
+            static void f32_planar_to_f32(void *dst, const f32_t * const *src, size_t off, size_t channels, size_t frames)
+            {
+                if ((channels != 2) || (src[0] == NULL) || (src[1] == NULL))
+                {
+                    generic::f32_planar_to_f32(dst, src, off, channels, frames);
+                    return;
+                }
+
+                f32_t *d            = static_cast<f32_t *>(dst);
+                const f32_t *l      = &src[0][off];
+                const f32_t *r      = &src[1][off];
+                size_t i            = 0;
+
+                for ( ; (i + 8) <= frames; i += 8, d += 16)
+                {
+                    __m256 xl   = _mm256_loadu_ps(&l[i]);
+                    __m256 xr   = _mm256_loadu_ps(&r[i]);
+                    __m256 lo   = _mm256_unpacklo_ps(xl, xr);
+                    __m256 hi   = _mm256_unpackhi_ps(xl, xr);
+
+                    _mm256_storeu_ps(&d[0], _mm256_permute2f128_ps(lo, hi, 0x20));
+                    _mm256_storeu_ps(&d[8], _mm256_permute2f128_ps(lo, hi, 0x31));
+                }
+
+                sse2::f32_planar_to_f32(d, src, off + i, channels, frames - i);
+            }
+
+            AVX2_TARGET
+            static f32_t dot_f32(const f32_t *a, const f32_t *b, size_t count)
+            {
+                __m256 s0   = _mm256_setzero_ps();
+                __m256 s1   = _mm256_setzero_ps();
+
+                for ( ; count >= 16; count -= 16, a += 16, b += 16)
+                {
+                    s0          = _mm256_add_ps(s0, _mm256_mul_ps(_mm256_loadu_ps(&a[0]), _mm256_loadu_ps(&b[0])));
+                    s1          = _mm256_add_ps(s1, _mm256_mul_ps(_mm256_loadu_ps(&a[8]), _mm256_loadu_ps(&b[8])));
+                }
+                if (count >= 8)
+                {
+                    s0          = _mm256_add_ps(s0, _mm256_mul_ps(_mm256_loadu_ps(a), _mm256_loadu_ps(b)));
+                    count      -= 8;
+                    a          += 8;
+                    b          += 8;
+                }
+
+                // Horizontal sum
+                s0          = _mm256_add_ps(s0, s1);
+                __m128 x    = _mm_add_ps(_mm256_castps256_ps128(s0), _mm256_extractf128_ps(s0, 1));
+                x           = _mm_add_ps(x, _mm_movehl_ps(x, x));
+                x           = _mm_add_ss(x, _mm_shuffle_ps(x, x, 0x55));
+
+                return _mm_cvtss_f32(x) + sse2::dot_f32(a, b, count);
+            }
+
+            AVX2_TARGET
+            static void peak_f32(f32_t *dst, const f32_t *src, size_t count)
+            {
+                if (count < 8)
+                {
+                    sse2::peak_f32(dst, src, count);
+                    return;
+                }
+
+                __m256 vmin = _mm256_set1_ps(dst[0]);
+                __m256 vmax = _mm256_set1_ps(dst[1]);
+                __m256 s0   = _mm256_setzero_ps();
+                __m256 s1   = _mm256_setzero_ps();
+
+                for ( ; count >= 16; count -= 16, src += 16)
+                {
+                    __m256 x0   = _mm256_loadu_ps(&src[0]);
+                    __m256 x1   = _mm256_loadu_ps(&src[8]);
+                    vmin        = _mm256_min_ps(vmin, _mm256_min_ps(x0, x1));
+                    vmax        = _mm256_max_ps(vmax, _mm256_max_ps(x0, x1));
+                    s0          = _mm256_add_ps(s0, _mm256_mul_ps(x0, x0));
+                    s1          = _mm256_add_ps(s1, _mm256_mul_ps(x1, x1));
+                }
+                if (count >= 8)
+                {
+                    __m256 x0   = _mm256_loadu_ps(src);
+                    vmin        = _mm256_min_ps(vmin, x0);
+                    vmax        = _mm256_max_ps(vmax, x0);
+                    s0          = _mm256_add_ps(s0, _mm256_mul_ps(x0, x0));
+                    count      -= 8;
+                    src        += 8;
+                }
+
+                // Horizontal reduction
+                s0          = _mm256_add_ps(s0, s1);
+                __m128 xmin = _mm_min_ps(_mm256_castps256_ps128(vmin), _mm256_extractf128_ps(vmin, 1));
+                __m128 xmax = _mm_max_ps(_mm256_castps256_ps128(vmax), _mm256_extractf128_ps(vmax, 1));
+                __m128 x    = _mm_add_ps(_mm256_castps256_ps128(s0), _mm256_extractf128_ps(s0, 1));
+                xmin        = _mm_min_ps(xmin, _mm_movehl_ps(xmin, xmin));
+                xmin        = _mm_min_ss(xmin, _mm_shuffle_ps(xmin, xmin, 0x55));
+                xmax        = _mm_max_ps(xmax, _mm_movehl_ps(xmax, xmax));
+                xmax        = _mm_max_ss(xmax, _mm_shuffle_ps(xmax, xmax, 0x55));
+                x           = _mm_add_ps(x, _mm_movehl_ps(x, x));
+                x           = _mm_add_ss(x, _mm_shuffle_ps(x, x, 0x55));
+
+                dst[0]      = _mm_cvtss_f32(xmin);
+                dst[1]      = _mm_cvtss_f32(xmax);
+                dst[2]     += _mm_cvtss_f32(x);
+
+                sse2::peak_f32(dst, src, count);
+            }
+
+            const cvt_kernels_t kernels =
+            {
+                "avx2",
+
+                u8_to_f32,
+                s16_to_f32,
+                s24_to_f32,
+                s32_to_f32,
+                f64_to_f32,
+
+                f32_to_u8,
+                f32_to_s16,
+                f32_to_s24,
+                f32_to_s32,
+                f32_to_f64,
+
+                f32_to_u8_round,
+                f32_to_s16_round,
+                f32_to_s24_round,
+                f32_to_s32_round,
+
+                xs16_to_f32,
+                xs24_to_f32,
+                xs32_to_f32,
+                f32_to_xs16,
+                f32_to_xs24,
+                f32_to_xs32,
+                swap_f32,
+
+                s16_to_f32_planar,
+                f32_to_f32_planar,
+                f32_planar_to_s16,
+                f32_planar_to_f32,
+
+                dot_f32,
+                peak_f32
+            };
+        }
+    }
+}
+
+#endif /* ARCH_X86 */
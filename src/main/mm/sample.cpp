@@ -21,10 +21,16 @@
 
 #include <lsp-plug.in/common/endian.h>
 #include <lsp-plug.in/mm/sample.h>
+#include <lsp-plug.in/stdlib/math.h>
 #include <lsp-plug.in/stdlib/string.h>
 
+#include <private/mm/cvt.h>
+
 /*
- * TODO: fix floating-point rounding
+ * NOTE: floating-point rounding
+ *
+ * By default samples are truncated towards zero for compatibility reasons. The QUANTIZE_ROUND
+ * and QUANTIZE_DITHER modes of convert_samples() perform proper rounding as described below.
  *
  * https://www.cs.cmu.edu/~rbd/papers/cmj-float-to-int.html
  *
@@ -75,8 +81,6 @@ namespace lsp
 {
     namespace mm
     {
-        typedef void (*cvt_sample_t) (void *dst, const void *src, size_t samples);
-
         static inline uint32_t read24bit(const uint8_t *p)
         {
             uint32_t res =
@@ -101,6 +105,30 @@ namespace lsp
             )
         }
 
+        static inline uint32_t read24bit_swap(const uint8_t *p)
+        {
+            uint32_t res =
+                __IF_LEBE(
+                    (uint32_t(p[2])) | (uint32_t(p[1]) << 8) | (uint32_t(p[0]) << 16),
+                    (uint32_t(p[0])) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16)
+                );
+            return res;
+        }
+
+        static inline void write24bit_swap(uint8_t *p, uint32_t x)
+        {
+            __IF_LE(
+                p[0] = uint8_t(x >> 16);
+                p[1] = uint8_t(x >> 8);
+                p[2] = uint8_t(x);
+            )
+            __IF_BE(
+                p[0] = uint8_t(x);
+                p[1] = uint8_t(x >> 8);
+                p[2] = uint8_t(x >> 16);
+            )
+        }
+
         bool sample_endian_swap(void *buf, size_t samples, size_t format)
         {
             size_t fmt = sformat_endian(format);
@@ -154,27 +182,27 @@ namespace lsp
 
         // Integer conversions
         #define CVT_UI_TO_UI(DTYPE, STYPE, SHIFT) \
-            for (STYPE *sptr = static_cast<STYPE *>(src); samples > 0; --samples, ++sptr, ++dptr) \
+            for (const STYPE *sptr = static_cast<const STYPE *>(src); samples > 0; --samples, ++sptr, ++dptr) \
                 *dptr   = (DTYPE)((*sptr) SHIFT);
 
         #define CVT_UI_TO_SI(DTYPE, STYPE, SHIFT) \
-            for (STYPE *sptr = static_cast<STYPE *>(src); samples > 0; --samples, ++sptr, ++dptr) \
+            for (const STYPE *sptr = static_cast<const STYPE *>(src); samples > 0; --samples, ++sptr, ++dptr) \
                 *dptr   = (DTYPE)((*sptr - CVT_SHIFT(STYPE)) SHIFT);
 
         #define CVT_SI_TO_UI(DTYPE, STYPE, SHIFT) \
-            for (STYPE *sptr = static_cast<STYPE *>(src); samples > 0; --samples, ++sptr, ++dptr) \
+            for (const STYPE *sptr = static_cast<const STYPE *>(src); samples > 0; --samples, ++sptr, ++dptr) \
                 *dptr   = (DTYPE)((*sptr + CVT_SHIFT(STYPE)) SHIFT);
 
         #define CVT_SI_TO_SI(DTYPE, STYPE, SHIFT) \
-            for (STYPE *sptr = static_cast<STYPE *>(src); samples > 0; --samples, ++sptr, ++dptr) \
+            for (const STYPE *sptr = static_cast<const STYPE *>(src); samples > 0; --samples, ++sptr, ++dptr) \
                 *dptr   = (DTYPE)((*sptr) SHIFT);
 
         #define CVT_UI_TO_FX(DTYPE, STYPE) \
-            for (STYPE *sptr = static_cast<STYPE *>(src); samples > 0; --samples, ++sptr, ++dptr) \
+            for (const STYPE *sptr = static_cast<const STYPE *>(src); samples > 0; --samples, ++sptr, ++dptr) \
                 *dptr   = ((STYPE)(*sptr - CVT_SHIFT(STYPE))) * (DTYPE(1.0 / CVT_RANGE(STYPE)));
 
         #define CVT_SI_TO_FX(DTYPE, STYPE) \
-            for (STYPE *sptr = static_cast<STYPE *>(src); samples > 0; --samples, ++sptr, ++dptr) \
+            for (const STYPE *sptr = static_cast<const STYPE *>(src); samples > 0; --samples, ++sptr, ++dptr) \
                 *dptr   = ((STYPE)(*sptr)) * (DTYPE(1.0 / CVT_RANGE(STYPE)));
 
         #define CVT_UI_TO_XI(DTYPE, STYPE, SHIFT) \
@@ -191,27 +219,27 @@ namespace lsp
 
         // Integer 24-bit conversions
         #define CVT_U24_TO_UI(DTYPE, SHIFT) \
-            for (uint8_t *sptr = static_cast<uint8_t *>(src); samples > 0; --samples, sptr += 3, ++dptr) \
+            for (const uint8_t *sptr = static_cast<const uint8_t *>(src); samples > 0; --samples, sptr += 3, ++dptr) \
                 *dptr   = (DTYPE)(read24bit(sptr) SHIFT);
 
         #define CVT_U24_TO_SI(DTYPE, SHIFT) \
-            for (uint8_t *sptr = static_cast<uint8_t *>(src); samples > 0; --samples, sptr += 3, ++dptr) \
+            for (const uint8_t *sptr = static_cast<const uint8_t *>(src); samples > 0; --samples, sptr += 3, ++dptr) \
                 *dptr   = (DTYPE)((read24bit(sptr) - 0x800000) SHIFT);
 
         #define CVT_S24_TO_UI(DTYPE, SHIFT) \
-            for (uint8_t *sptr = static_cast<uint8_t *>(src); samples > 0; --samples, sptr += 3, ++dptr) \
+            for (const uint8_t *sptr = static_cast<const uint8_t *>(src); samples > 0; --samples, sptr += 3, ++dptr) \
                 *dptr   = (DTYPE)((read24bit(sptr) + 0x800000) SHIFT);
 
         #define CVT_S24_TO_SI(DTYPE, SHIFT) \
-            for (uint8_t *sptr = static_cast<uint8_t *>(src); samples > 0; --samples, sptr += 3, ++dptr) \
+            for (const uint8_t *sptr = static_cast<const uint8_t *>(src); samples > 0; --samples, sptr += 3, ++dptr) \
                 *dptr   = (DTYPE)(read24bit(sptr) SHIFT);
 
         #define CVT_U24_TO_FX(DTYPE) \
-            for (uint8_t *sptr = static_cast<uint8_t *>(src); samples > 0; --samples, sptr += 3, ++dptr) \
+            for (const uint8_t *sptr = static_cast<const uint8_t *>(src); samples > 0; --samples, sptr += 3, ++dptr) \
                 *dptr   = (int32_t(read24bit(sptr) - 0x800000) * (DTYPE(1.0)/0x7fffff));
 
         #define CVT_S24_TO_FX(DTYPE) \
-            for (uint8_t *sptr = static_cast<uint8_t *>(src); samples > 0; --samples, sptr += 3, ++dptr) \
+            for (const uint8_t *sptr = static_cast<const uint8_t *>(src); samples > 0; --samples, sptr += 3, ++dptr) \
                 *dptr   = ((int32_t(read24bit(sptr) << 8) >> 8) * (DTYPE(1.0)/0x7fffff));
 
         #define CVT_U24_TO_XI(DTYPE, SHIFT) \
@@ -228,19 +256,19 @@ namespace lsp
 
 
         #define CVT_UI_TO_UI24(STYPE, SHIFT) \
-            for (STYPE *sptr = static_cast<STYPE *>(src); samples > 0; --samples, ++sptr, dptr += 3) \
+            for (const STYPE *sptr = static_cast<const STYPE *>(src); samples > 0; --samples, ++sptr, dptr += 3) \
                 write24bit(dptr, uint32_t((*sptr) SHIFT));
 
         #define CVT_UI_TO_SI24(STYPE, SHIFT) \
-            for (STYPE *sptr = static_cast<STYPE *>(src); samples > 0; --samples, ++sptr, dptr += 3) \
+            for (const STYPE *sptr = static_cast<const STYPE *>(src); samples > 0; --samples, ++sptr, dptr += 3) \
                 write24bit(dptr, uint32_t((*sptr - CVT_SHIFT(STYPE)) SHIFT));
 
         #define CVT_SI_TO_UI24(STYPE, SHIFT) \
-            for (STYPE *sptr = static_cast<STYPE *>(src); samples > 0; --samples, ++sptr, dptr += 3) \
+            for (const STYPE *sptr = static_cast<const STYPE *>(src); samples > 0; --samples, ++sptr, dptr += 3) \
                 write24bit(dptr, uint32_t((*sptr + CVT_SHIFT(STYPE)) SHIFT));
 
         #define CVT_SI_TO_SI24(STYPE, SHIFT) \
-            for (STYPE *sptr = static_cast<STYPE *>(src); samples > 0; --samples, ++sptr, dptr += 3) \
+            for (const STYPE *sptr = static_cast<const STYPE *>(src); samples > 0; --samples, ++sptr, dptr += 3) \
                 write24bit(dptr, uint32_t((*sptr) SHIFT));
 
         #define CVT_UI_TO_XI24(STYPE, SHIFT) \
@@ -256,19 +284,19 @@ namespace lsp
                 CVT_SI_TO_UI24(STYPE, SHIFT)
 
         #define CVT_SI24_TO_UI24() \
-            for (uint8_t *sptr = static_cast<uint8_t *>(src); samples > 0; --samples, sptr += 3, dptr += 3) \
+            for (const uint8_t *sptr = static_cast<const uint8_t *>(src); samples > 0; --samples, sptr += 3, dptr += 3) \
                 write24bit(dptr, read24bit(sptr) + 0x800000);
 
         #define CVT_UI24_TO_SI24() \
-            for (uint8_t *sptr = static_cast<uint8_t *>(src); samples > 0; --samples, sptr += 3, dptr += 3) \
+            for (const uint8_t *sptr = static_cast<const uint8_t *>(src); samples > 0; --samples, sptr += 3, dptr += 3) \
                 write24bit(dptr, read24bit(sptr) - 0x800000);
 
         // Float conversions
         #define CVT_F32_TO_UI(STYPE, DTYPE) \
-            for (f32_t *sptr = static_cast<f32_t *>(src); samples > 0; --samples, ++sptr, ++dptr) \
+            for (const f32_t *sptr = static_cast<const f32_t *>(src); samples > 0; --samples, ++sptr, ++dptr) \
                 *dptr   = (STYPE)(*sptr * f32_t(CVT_RANGE(DTYPE))) + (DTYPE)CVT_SHIFT(DTYPE);
         #define CVT_F32_TO_SI(DTYPE) \
-            for (f32_t *sptr = static_cast<f32_t *>(src); samples > 0; --samples, ++sptr, ++dptr) \
+            for (const f32_t *sptr = static_cast<const f32_t *>(src); samples > 0; --samples, ++sptr, ++dptr) \
                 *dptr   = (DTYPE)(*sptr * f32_t(CVT_RANGE(DTYPE)));
 
         #define CVT_F32_TO_XI(STYPE, DTYPE) \
@@ -280,10 +308,10 @@ namespace lsp
 
         // Double conversions
         #define CVT_F64_TO_UI(STYPE, DTYPE) \
-            for (f64_t *sptr = static_cast<f64_t *>(src); samples > 0; --samples, ++sptr, ++dptr) \
+            for (const f64_t *sptr = static_cast<const f64_t *>(src); samples > 0; --samples, ++sptr, ++dptr) \
                 *dptr   = (STYPE)(*sptr * f64_t(CVT_RANGE(DTYPE))) + (DTYPE)CVT_SHIFT(DTYPE);
         #define CVT_F64_TO_SI(DTYPE) \
-            for (f64_t *sptr = static_cast<f64_t *>(src); samples > 0; --samples, ++sptr, ++dptr) \
+            for (const f64_t *sptr = static_cast<const f64_t *>(src); samples > 0; --samples, ++sptr, ++dptr) \
                 *dptr   = (DTYPE)(*sptr * f64_t(CVT_RANGE(DTYPE)));
 
         #define CVT_F64_TO_XI(STYPE, DTYPE) \
@@ -294,10 +322,10 @@ namespace lsp
 
         // Floating-point conversions
         #define CVT_FX_TO_SI24(STYPE) \
-            for (STYPE *sptr = static_cast<STYPE *>(src); samples > 0; --samples, ++sptr, dptr += 3) \
+            for (const STYPE *sptr = static_cast<const STYPE *>(src); samples > 0; --samples, ++sptr, dptr += 3) \
                 write24bit(dptr, int32_t(*sptr * 0x7fffff));
         #define CVT_FX_TO_UI24(STYPE) \
-            for (STYPE *sptr = static_cast<STYPE *>(src); samples > 0; --samples, ++sptr, dptr += 3) \
+            for (const STYPE *sptr = static_cast<const STYPE *>(src); samples > 0; --samples, ++sptr, dptr += 3) \
                 write24bit(dptr, int32_t(*sptr * 0x7fffff) - 0x800000);
         #define CVT_FX_TO_XI24(STYPE) \
             if (sign) \
@@ -306,11 +334,11 @@ namespace lsp
                 CVT_FX_TO_UI24(STYPE)
 
         #define CVT_FX_TO_UI32(STYPE) \
-            for (STYPE *sptr = static_cast<STYPE *>(src); samples > 0; --samples, ++sptr, ++dptr) \
-                *dptr   = (int32_t)(*sptr * f64_t(CVT_RANGE(uint32_t))) + (uint32_t)CVT_SHIFT(uint32_t);
+            for (const STYPE *sptr = static_cast<const STYPE *>(src); samples > 0; --samples, ++sptr, ++dptr) \
+                *dptr   = saturate_s32(*sptr * f64_t(CVT_RANGE(uint32_t))) + (uint32_t)CVT_SHIFT(uint32_t);
         #define CVT_FX_TO_SI32(STYPE) \
-            for (STYPE *sptr = static_cast<STYPE *>(src); samples > 0; --samples, ++sptr, ++dptr) \
-                *dptr   = (int32_t)(*sptr * f64_t(CVT_RANGE(uint32_t)));
+            for (const STYPE *sptr = static_cast<const STYPE *>(src); samples > 0; --samples, ++sptr, ++dptr) \
+                *dptr   = saturate_s32(*sptr * f64_t(CVT_RANGE(uint32_t)));
 
         #define CVT_FX_TO_XI32(STYPE) \
             if (sign) \
@@ -319,10 +347,448 @@ namespace lsp
                 CVT_FX_TO_UI32(STYPE)
 
         #define CVT_FX_TO_FX(DTYPE, STYPE) \
-            for (STYPE *sptr = static_cast<STYPE *>(src); samples > 0; --samples, ++sptr, ++dptr) \
+            for (const STYPE *sptr = static_cast<const STYPE *>(src); samples > 0; --samples, ++sptr, ++dptr) \
                 *dptr   = (DTYPE)(*sptr);
 
 
+        static inline uint32_t dither_next(uint32_t x)
+        {
+            x      ^= x << 13;
+            x      ^= x >> 17;
+            x      ^= x << 5;
+            return x;
+        }
+
+        static inline f32_t dither_tpdf(cvt_dither_t *dither, size_t lane)
+        {
+            // Difference of two uniformly distributed values gives triangular distribution in (-1, 1)
+            uint32_t a          = dither_next(dither->seed[lane]);
+            uint32_t b          = dither_next(a);
+            dither->seed[lane]  = b;
+            return f32_t(int32_t(a >> 8) - int32_t(b >> 8)) * f32_t(1.0 / 0x1000000);
+        }
+
+        static inline int32_t quantize_f32(f32_t x, f32_t lo, f32_t hi)
+        {
+            x       = (x < lo) ? lo : x;
+            x       = (x > hi) ? hi : x;
+            return int32_t(::lrintf(x));
+        }
+
+        static inline int32_t quantize_f64(f64_t x, f64_t lo, f64_t hi)
+        {
+            x       = (x < lo) ? lo : x;
+            x       = (x > hi) ? hi : x;
+            return int32_t(::lrint(x));
+        }
+
+        static inline int32_t saturate_s32(f64_t x)
+        {
+            // NaN values are saturated to the upper bound like SIMD implementations do
+            x       = (x < 2147483647.0) ? x : 2147483647.0;
+            x       = (x > -2147483647.0) ? x : -2147483647.0;
+            return int32_t(x);
+        }
+
+        namespace generic
+        {
+            void u8_to_f32(void *dst, const void *src, size_t samples)
+            {
+                f32_t *dptr = static_cast<f32_t *>(dst);
+                CVT_UI_TO_FX(f32_t, int8_t)
+            }
+
+            void s16_to_f32(void *dst, const void *src, size_t samples)
+            {
+                f32_t *dptr = static_cast<f32_t *>(dst);
+                CVT_SI_TO_FX(f32_t, int16_t)
+            }
+
+            void s24_to_f32(void *dst, const void *src, size_t samples)
+            {
+                f32_t *dptr = static_cast<f32_t *>(dst);
+                CVT_S24_TO_FX(f32_t)
+            }
+
+            void s32_to_f32(void *dst, const void *src, size_t samples)
+            {
+                f32_t *dptr = static_cast<f32_t *>(dst);
+                CVT_SI_TO_FX(f32_t, int32_t)
+            }
+
+            void f64_to_f32(void *dst, const void *src, size_t samples)
+            {
+                f32_t *dptr = static_cast<f32_t *>(dst);
+                CVT_FX_TO_FX(f32_t, f64_t)
+            }
+
+            void f32_to_u8(void *dst, const void *src, size_t samples)
+            {
+                uint8_t *dptr = static_cast<uint8_t *>(dst);
+                CVT_F32_TO_UI(int8_t, uint8_t)
+            }
+
+            void f32_to_s16(void *dst, const void *src, size_t samples)
+            {
+                uint16_t *dptr = static_cast<uint16_t *>(dst);
+                CVT_F32_TO_SI(int16_t)
+            }
+
+            void f32_to_s24(void *dst, const void *src, size_t samples)
+            {
+                uint8_t *dptr = static_cast<uint8_t *>(dst);
+                CVT_FX_TO_SI24(f32_t)
+            }
+
+            void f32_to_s32(void *dst, const void *src, size_t samples)
+            {
+                uint32_t *dptr = static_cast<uint32_t *>(dst);
+                CVT_FX_TO_SI32(f32_t)
+            }
+
+            void f32_to_f64(void *dst, const void *src, size_t samples)
+            {
+                f64_t *dptr = static_cast<f64_t *>(dst);
+                CVT_FX_TO_FX(f64_t, f32_t)
+            }
+
+            void f32_to_u8_round(void *dst, const void *src, size_t samples, cvt_dither_t *dither)
+            {
+                uint8_t *d      = static_cast<uint8_t *>(dst);
+                const f32_t *s  = static_cast<const f32_t *>(src);
+
+                if (dither == NULL)
+                {
+                    for (size_t i=0; i<samples; ++i)
+                        d[i]    = uint8_t(quantize_f32(s[i] * 0x7f, -0x80, 0x7f) + 0x80);
+                }
+                else
+                {
+                    for (size_t i=0; i<samples; ++i)
+                        d[i]    = uint8_t(quantize_f32(s[i] * 0x7f + dither_tpdf(dither, i & 7), -0x80, 0x7f) + 0x80);
+                }
+            }
+
+            void f32_to_s16_round(void *dst, const void *src, size_t samples, cvt_dither_t *dither)
+            {
+                int16_t *d      = static_cast<int16_t *>(dst);
+                const f32_t *s  = static_cast<const f32_t *>(src);
+
+                if (dither == NULL)
+                {
+                    for (size_t i=0; i<samples; ++i)
+                        d[i]    = int16_t(quantize_f32(s[i] * 0x7fff, -0x8000, 0x7fff));
+                }
+                else
+                {
+                    for (size_t i=0; i<samples; ++i)
+                        d[i]    = int16_t(quantize_f32(s[i] * 0x7fff + dither_tpdf(dither, i & 7), -0x8000, 0x7fff));
+                }
+            }
+
+            void f32_to_s24_round(void *dst, const void *src, size_t samples, cvt_dither_t *dither)
+            {
+                uint8_t *d      = static_cast<uint8_t *>(dst);
+                const f32_t *s  = static_cast<const f32_t *>(src);
+
+                if (dither == NULL)
+                {
+                    for (size_t i=0; i<samples; ++i, d += 3)
+                        write24bit(d, quantize_f32(s[i] * 0x7fffff, -0x800000, 0x7fffff));
+                }
+                else
+                {
+                    for (size_t i=0; i<samples; ++i, d += 3)
+                        write24bit(d, quantize_f32(s[i] * 0x7fffff + dither_tpdf(dither, i & 7), -0x800000, 0x7fffff));
+                }
+            }
+
+            void f32_to_s32_round(void *dst, const void *src, size_t samples, cvt_dither_t *dither)
+            {
+                int32_t *d      = static_cast<int32_t *>(dst);
+                const f32_t *s  = static_cast<const f32_t *>(src);
+
+                // The scaling is performed with double precision to keep 32-bit resolution
+                if (dither == NULL)
+                {
+                    for (size_t i=0; i<samples; ++i)
+                        d[i]    = quantize_f64(f64_t(s[i]) * 0x7fffffff, -2147483648.0, 2147483647.0);
+                }
+                else
+                {
+                    for (size_t i=0; i<samples; ++i)
+                        d[i]    = quantize_f64(f64_t(s[i]) * 0x7fffffff + f64_t(dither_tpdf(dither, i & 7)), -2147483648.0, 2147483647.0);
+                }
+            }
+
+            void xs16_to_f32(void *dst, const void *src, size_t samples)
+            {
+                f32_t *d            = static_cast<f32_t *>(dst);
+                const uint16_t *s   = static_cast<const uint16_t *>(src);
+
+                for (size_t i=0; i<samples; ++i)
+                    d[i]    = int16_t(byte_swap(s[i])) * f32_t(1.0 / 0x7fff);
+            }
+
+            void xs24_to_f32(void *dst, const void *src, size_t samples)
+            {
+                f32_t *d            = static_cast<f32_t *>(dst);
+                const uint8_t *s    = static_cast<const uint8_t *>(src);
+
+                for (size_t i=0; i<samples; ++i, s += 3)
+                    d[i]    = (int32_t(read24bit_swap(s) << 8) >> 8) * (f32_t(1.0)/0x7fffff);
+            }
+
+            void xs32_to_f32(void *dst, const void *src, size_t samples)
+            {
+                f32_t *d            = static_cast<f32_t *>(dst);
+                const uint32_t *s   = static_cast<const uint32_t *>(src);
+
+                for (size_t i=0; i<samples; ++i)
+                    d[i]    = int32_t(byte_swap(s[i])) * f32_t(1.0 / 0x7fffffff);
+            }
+
+            void f32_to_xs16(void *dst, const void *src, size_t samples)
+            {
+                uint16_t *d         = static_cast<uint16_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+
+                for (size_t i=0; i<samples; ++i)
+                    d[i]    = byte_swap(uint16_t(int16_t(s[i] * f32_t(0x7fff))));
+            }
+
+            void f32_to_xs24(void *dst, const void *src, size_t samples)
+            {
+                uint8_t *d          = static_cast<uint8_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+
+                for (size_t i=0; i<samples; ++i, d += 3)
+                    write24bit_swap(d, int32_t(s[i] * 0x7fffff));
+            }
+
+            void f32_to_xs32(void *dst, const void *src, size_t samples)
+            {
+                uint32_t *d         = static_cast<uint32_t *>(dst);
+                const f32_t *s      = static_cast<const f32_t *>(src);
+
+                for (size_t i=0; i<samples; ++i)
+                    d[i]    = byte_swap(uint32_t(saturate_s32(s[i] * f64_t(0x7fffffff))));
+            }
+
+            void swap_f32(void *dst, const void *src, size_t samples)
+            {
+                uint32_t *d         = static_cast<uint32_t *>(dst);
+                const uint32_t *s   = static_cast<const uint32_t *>(src);
+
+                for (size_t i=0; i<samples; ++i)
+                    d[i]    = byte_swap(s[i]);
+            }
+
+            void s16_to_f32_planar(f32_t * const *dst, size_t off, const void *src, size_t channels, size_t frames)
+            {
+                const int16_t *s    = static_cast<const int16_t *>(src);
+
+                for (size_t i=0; i<channels; ++i)
+                {
+                    f32_t *d            = dst[i];
+                    if (d == NULL)
+                        continue;
+                    d                  += off;
+                    for (size_t j=0, k=i; j<frames; ++j, k += channels)
+                        d[j]    = s[k] * f32_t(1.0 / 0x7fff);
+                }
+            }
+
+            void f32_to_f32_planar(f32_t * const *dst, size_t off, const void *src, size_t channels, size_t frames)
+            {
+                const f32_t *s      = static_cast<const f32_t *>(src);
+
+                for (size_t i=0; i<channels; ++i)
+                {
+                    f32_t *d            = dst[i];
+                    if (d == NULL)
+                        continue;
+                    d                  += off;
+                    for (size_t j=0, k=i; j<frames; ++j, k += channels)
+                        d[j]    = s[k];
+                }
+            }
+
+            void f32_planar_to_s16(void *dst, const f32_t * const *src, size_t off, size_t channels, size_t frames)
+            {
+                int16_t *d          = static_cast<int16_t *>(dst);
+
+                for (size_t i=0; i<channels; ++i)
+                {
+                    const f32_t *s      = src[i];
+                    if (s == NULL)
+                    {
+                        for (size_t j=0, k=i; j<frames; ++j, k += channels)
+                            d[k]    = 0;
+                        continue;
+                    }
+                    s                  += off;
+                    for (size_t j=0, k=i; j<frames; ++j, k += channels)
+                        d[k]    = int16_t(s[j] * f32_t(0x7fff));
+                }
+            }
+
+            void f32_planar_to_f32(void *dst, const f32_t * const *src, size_t off, size_t channels, size_t frames)
+            {
+                f32_t *d            = static_cast<f32_t *>(dst);
+
+                for (size_t i=0; i<channels; ++i)
+                {
+                    const f32_t *s      = src[i];
+                    if (s == NULL)
+                    {
+                        for (size_t j=0, k=i; j<frames; ++j, k += channels)
+                            d[k]    = 0.0f;
+                        continue;
+                    }
+                    s                  += off;
+                    for (size_t j=0, k=i; j<frames; ++j, k += channels)
+                        d[k]    = s[j];
+                }
+            }
+
+            f32_t dot_f32(const f32_t *a, const f32_t *b, size_t count)
+            {
+                f32_t s     = 0.0f;
+                for (size_t i=0; i<count; ++i)
+                    s          += a[i] * b[i];
+                return s;
+            }
+
+            void peak_f32(f32_t *dst, const f32_t *src, size_t count)
+            {
+                f32_t vmin  = dst[0];
+                f32_t vmax  = dst[1];
+                f32_t sum   = 0.0f;
+
+                for (size_t i=0; i<count; ++i)
+                {
+                    f32_t s     = src[i];
+                    vmin        = (s < vmin) ? s : vmin;
+                    vmax        = (s > vmax) ? s : vmax;
+                    sum        += s * s;
+                }
+
+                dst[0]      = vmin;
+                dst[1]      = vmax;
+                dst[2]     += sum;
+            }
+
+            const cvt_kernels_t kernels =
+            {
+                "generic",
+
+                u8_to_f32,
+                s16_to_f32,
+                s24_to_f32,
+                s32_to_f32,
+                f64_to_f32,
+
+                f32_to_u8,
+                f32_to_s16,
+                f32_to_s24,
+                f32_to_s32,
+                f32_to_f64,
+
+                f32_to_u8_round,
+                f32_to_s16_round,
+                f32_to_s24_round,
+                f32_to_s32_round,
+
+                xs16_to_f32,
+                xs24_to_f32,
+                xs32_to_f32,
+                f32_to_xs16,
+                f32_to_xs24,
+                f32_to_xs32,
+                swap_f32,
+
+                s16_to_f32_planar,
+                f32_to_f32_planar,
+                f32_planar_to_s16,
+                f32_planar_to_f32,
+
+                dot_f32,
+                peak_f32
+            };
+        }
+
+        size_t cvt_supported_kernels(const cvt_kernels_t **sets, size_t max)
+        {
+            size_t n = 0;
+
+            #define ADD_KERNELS(k) \
+                if (n < max) \
+                    sets[n++]   = &(k);
+
+            ADD_KERNELS(generic::kernels);
+
+        #if defined(ARCH_X86)
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("sse2"))
+                ADD_KERNELS(sse2::kernels);
+            if (__builtin_cpu_supports("ssse3"))
+                ADD_KERNELS(ssse3::kernels);
+            if (__builtin_cpu_supports("avx2"))
+                ADD_KERNELS(avx2::kernels);
+        #endif /* ARCH_X86 */
+
+        #if defined(ARCH_AARCH64) && defined(ARCH_LE)
+            ADD_KERNELS(asimd::kernels);
+        #endif /* ARCH_AARCH64 && ARCH_LE */
+
+            #undef ADD_KERNELS
+
+            return n;
+        }
+
+        const cvt_kernels_t *cvt_kernels()
+        {
+            static const cvt_kernels_t *selected = NULL;
+
+            // The selection is idempotent, so concurrent first calls are harmless
+            const cvt_kernels_t *k = selected;
+            if (k == NULL)
+            {
+                const cvt_kernels_t *sets[8];
+                size_t n    = cvt_supported_kernels(sets, sizeof(sets)/sizeof(sets[0]));
+                k           = sets[n - 1];
+                selected    = k;
+            }
+
+            return k;
+        }
+
+        void cvt_init_dither(cvt_dither_t *dither, uint32_t seed)
+        {
+            for (size_t i=0; i<8; ++i)
+            {
+                // Mix the seed to obtain different non-zero states for each generator
+                seed           += 0x9e3779b9;
+                uint32_t x      = seed;
+                x               = (x ^ (x >> 16)) * 0x85ebca6b;
+                x               = (x ^ (x >> 13)) * 0xc2b2ae35;
+                x              ^= x >> 16;
+                dither->seed[i] = (x != 0) ? x : 0x6d2b79f5;
+            }
+        }
+
+        static cvt_dither_t *thread_dither()
+        {
+            static __thread cvt_dither_t dither;
+
+            // The generator never produces zero state, so zero means non-initialized state
+            if (dither.seed[0] == 0)
+                cvt_init_dither(&dither, uint32_t(reinterpret_cast<uintptr_t>(&dither)));
+
+            return &dither;
+        }
+
         bool convert_to_8bit(void *dst, void *src, size_t samples, size_t to, size_t from)
         {
             int sign = sformat_sign(to);
@@ -347,7 +813,10 @@ namespace lsp
                 case SFMT_S24: CVT_S24_TO_XI(uint8_t, >> 16)            return true;
                 case SFMT_U32: CVT_UI_TO_XI(uint8_t, uint32_t, >> 24)   return true;
                 case SFMT_S32: CVT_SI_TO_XI(uint8_t, uint32_t, >> 24)   return true;
-                case SFMT_F32: CVT_F32_TO_XI(int8_t, uint8_t)           return true;
+                case SFMT_F32:
+                    if (sign)   CVT_F32_TO_SI(int8_t)
+                    else        cvt_kernels()->f32_to_u8(dptr, src, samples);
+                    return true;
                 case SFMT_F64: CVT_F64_TO_XI(int8_t, uint8_t)           return true;
 
                 default:
@@ -382,7 +851,10 @@ namespace lsp
                 case SFMT_S24: CVT_S24_TO_XI(uint16_t, >> 8)            return true;
                 case SFMT_U32: CVT_UI_TO_XI(uint16_t, uint32_t, >> 16)  return true;
                 case SFMT_S32: CVT_SI_TO_XI(uint16_t, uint32_t, >> 16)  return true;
-                case SFMT_F32: CVT_F32_TO_XI(int16_t, uint16_t)         return true;
+                case SFMT_F32:
+                    if (sign)   cvt_kernels()->f32_to_s16(dptr, src, samples);
+                    else        CVT_F32_TO_UI(int16_t, uint16_t)
+                    return true;
                 case SFMT_F64: CVT_F64_TO_XI(int16_t, uint16_t)         return true;
 
                 default:
@@ -418,7 +890,10 @@ namespace lsp
 
                 case SFMT_U32: CVT_UI_TO_XI24(uint32_t, >> 8)           return true;
                 case SFMT_S32: CVT_SI_TO_XI24(uint32_t, >> 8)           return true;
-                case SFMT_F32: CVT_FX_TO_XI24(f32_t)                    return true;
+                case SFMT_F32:
+                    if (sign)   cvt_kernels()->f32_to_s24(dptr, src, samples);
+                    else        CVT_FX_TO_UI24(f32_t)
+                    return true;
                 case SFMT_F64: CVT_FX_TO_XI24(f64_t)                    return true;
 
                 default:
@@ -455,7 +930,10 @@ namespace lsp
                     else        CVT_SI_TO_UI(uint32_t, uint32_t, )
                     return true;
 
-                case SFMT_F32: CVT_FX_TO_XI32(f32_t)                    return true;
+                case SFMT_F32:
+                    if (sign)   cvt_kernels()->f32_to_s32(dptr, src, samples);
+                    else        CVT_FX_TO_UI32(f32_t)
+                    return true;
                 case SFMT_F64: CVT_FX_TO_XI32(f64_t)                    return true;
 
                 default:
@@ -471,21 +949,21 @@ namespace lsp
 
             switch (sformat_format(from))
             {
-                case SFMT_U8:  CVT_UI_TO_FX(f32_t, int8_t)              return true;
+                case SFMT_U8:  cvt_kernels()->u8_to_f32(dptr, src, samples);    return true;
                 case SFMT_S8:  CVT_SI_TO_FX(f32_t, int8_t)              return true;
                 case SFMT_U16: CVT_UI_TO_FX(f32_t, int16_t)             return true;
-                case SFMT_S16: CVT_SI_TO_FX(f32_t, int16_t)             return true;
+                case SFMT_S16: cvt_kernels()->s16_to_f32(dptr, src, samples);   return true;
 
                 case SFMT_U24: CVT_U24_TO_FX(f32_t)                     return true;
-                case SFMT_S24: CVT_S24_TO_FX(f32_t)                     return true;
+                case SFMT_S24: cvt_kernels()->s24_to_f32(dptr, src, samples);   return true;
 
                 case SFMT_U32: CVT_UI_TO_FX(f32_t, int32_t)             return true;
-                case SFMT_S32: CVT_SI_TO_FX(f32_t, int32_t)             return true;
+                case SFMT_S32: cvt_kernels()->s32_to_f32(dptr, src, samples);   return true;
 
                 case SFMT_F32:
                     ::memcpy(dptr, src, samples * sizeof(f32_t));
                     return true;
-                case SFMT_F64: CVT_FX_TO_FX(f32_t, f64_t)               return true;
+                case SFMT_F64: cvt_kernels()->f64_to_f32(dptr, src, samples);   return true;
 
                 default:
                     break;
@@ -512,7 +990,7 @@ namespace lsp
                 case SFMT_U32: CVT_UI_TO_FX(f64_t, int32_t)             return true;
                 case SFMT_S32: CVT_SI_TO_FX(f64_t, int32_t)             return true;
 
-                case SFMT_F32: CVT_FX_TO_FX(f64_t, f32_t)               return true;
+                case SFMT_F32: cvt_kernels()->f32_to_f64(dptr, src, samples);   return true;
                 case SFMT_F64:
                     ::memcpy(dptr, src, samples * sizeof(f64_t));
                     return true;
@@ -524,50 +1002,243 @@ namespace lsp
             return false;
         }
 
+        static bool convert_swapped(void *dst, const void *src, size_t samples, size_t to, size_t from)
+        {
+            const size_t foreign    = __IF_LEBE(SFMT_BE, SFMT_LE);
+            size_t ffmt             = sformat_format(from);
+            size_t tfmt             = sformat_format(to);
+            const cvt_kernels_t *k;
+
+            if ((sformat_endian(from) == foreign) && (sformat_endian(to) == SFMT_CPU) && (tfmt == SFMT_F32))
+            {
+                k = cvt_kernels();
+                switch (ffmt)
+                {
+                    case SFMT_S16: k->xs16_to_f32(dst, src, samples); return true;
+                    case SFMT_S24: k->xs24_to_f32(dst, src, samples); return true;
+                    case SFMT_S32: k->xs32_to_f32(dst, src, samples); return true;
+                    case SFMT_F32: k->swap_f32(dst, src, samples); return true;
+                    default: break;
+                }
+            }
+            else if ((sformat_endian(from) == SFMT_CPU) && (sformat_endian(to) == foreign) && (ffmt == SFMT_F32))
+            {
+                k = cvt_kernels();
+                switch (tfmt)
+                {
+                    case SFMT_S16: k->f32_to_xs16(dst, src, samples); return true;
+                    case SFMT_S24: k->f32_to_xs24(dst, src, samples); return true;
+                    case SFMT_S32: k->f32_to_xs32(dst, src, samples); return true;
+                    case SFMT_F32: k->swap_f32(dst, src, samples); return true;
+                    default: break;
+                }
+            }
+
+            return false;
+        }
+
         bool convert_samples(void *dst, void *src, size_t samples, size_t to, size_t from)
         {
+            // Most common conversions of samples in foreign byte order are performed in one pass
+            if (convert_swapped(dst, src, samples, to, from))
+                return true;
+
             // Convert source sample endianess
             if (!sample_endian_swap(src, samples, from))
                 return false;
 
             // Apply sample conversion
+            bool res;
             switch (sformat_format(to))
             {
                 case SFMT_U8:
                 case SFMT_S8:
-                    return convert_to_8bit(dst, src, samples, to, from);
+                    res = convert_to_8bit(dst, src, samples, to, from);
+                    break;
 
                 case SFMT_U16:
                 case SFMT_S16:
-                    return convert_to_16bit(dst, src, samples, to, from);
+                    res = convert_to_16bit(dst, src, samples, to, from);
+                    break;
 
                 case SFMT_U24:
                 case SFMT_S24:
-                    return convert_to_24bit(dst, src, samples, to, from);
+                    res = convert_to_24bit(dst, src, samples, to, from);
+                    break;
 
                 case SFMT_U32:
                 case SFMT_S32:
-                    return convert_to_32bit(dst, src, samples, to, from);
+                    res = convert_to_32bit(dst, src, samples, to, from);
+                    break;
 
                 case SFMT_F32:
-                    return convert_to_f32(dst, src, samples, to, from);
+                    res = convert_to_f32(dst, src, samples, to, from);
+                    break;
 
                 case SFMT_F64:
-                    return convert_to_f64(dst, src, samples, to, from);
+                    res = convert_to_f64(dst, src, samples, to, from);
+                    break;
 
                 default:
-                    break;
+                    return false;
             }
 
             // Convert target sample endianess
-            if (!sample_endian_swap(dst, samples, to))
-                return false;
+            return (res) ? sample_endian_swap(dst, samples, to) : false;
+        }
 
-            return false;
+        static void flip_sign(void *buf, size_t samples, size_t fmt)
+        {
+            switch (fmt)
+            {
+                case SFMT_U8: case SFMT_S8:
+                {
+                    uint8_t *p = static_cast<uint8_t *>(buf);
+                    for (size_t i=0; i<samples; ++i)
+                        p[i]   ^= 0x80;
+                    break;
+                }
+                case SFMT_U16: case SFMT_S16:
+                {
+                    uint16_t *p = static_cast<uint16_t *>(buf);
+                    for (size_t i=0; i<samples; ++i)
+                        p[i]   ^= 0x8000;
+                    break;
+                }
+                case SFMT_U24: case SFMT_S24:
+                {
+                    uint8_t *p = static_cast<uint8_t *>(buf) + __IF_LEBE(2, 0);
+                    for (size_t i=0; i<samples; ++i, p += 3)
+                        *p     ^= 0x80;
+                    break;
+                }
+                case SFMT_U32: case SFMT_S32:
+                {
+                    uint32_t *p = static_cast<uint32_t *>(buf);
+                    for (size_t i=0; i<samples; ++i)
+                        p[i]   ^= 0x80000000;
+                    break;
+                }
+                default:
+                    break;
+            }
         }
 
+        static void quantize_samples(void *dst, const f32_t *src, size_t samples, size_t to, cvt_dither_t *dither)
+        {
+            const cvt_kernels_t *k = cvt_kernels();
 
-    }
-}
+            switch (to)
+            {
+                case SFMT_U8:
+                    k->f32_to_u8_round(dst, src, samples, dither);
+                    break;
+                case SFMT_S8:
+                    k->f32_to_u8_round(dst, src, samples, dither);
+                    flip_sign(dst, samples, to);
+                    break;
+                case SFMT_S16:
+                    k->f32_to_s16_round(dst, src, samples, dither);
+                    break;
+                case SFMT_U16:
+                    k->f32_to_s16_round(dst, src, samples, dither);
+                    flip_sign(dst, samples, to);
+                    break;
+                case SFMT_S24:
+                    k->f32_to_s24_round(dst, src, samples, dither);
+                    break;
+                case SFMT_U24:
+                    k->f32_to_s24_round(dst, src, samples, dither);
+                    flip_sign(dst, samples, to);
+                    break;
+                case SFMT_S32:
+                    k->f32_to_s32_round(dst, src, samples, dither);
+                    break;
+                case SFMT_U32:
+                    k->f32_to_s32_round(dst, src, samples, dither);
+                    flip_sign(dst, samples, to);
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        static void quantize_f64_to_s32(void *dst, const f64_t *src, size_t samples, cvt_dither_t *dither)
+        {
+            int32_t *d      = static_cast<int32_t *>(dst);
+
+            // Samples are scaled directly to keep full 32-bit resolution
+            if (dither == NULL)
+            {
+                for (size_t i=0; i<samples; ++i)
+                    d[i]    = quantize_f64(src[i] * 0x7fffffff, -2147483648.0, 2147483647.0);
+            }
+            else
+            {
+                for (size_t i=0; i<samples; ++i)
+                    d[i]    = quantize_f64(src[i] * 0x7fffffff + f64_t(dither_tpdf(dither, i & 7)), -2147483648.0, 2147483647.0);
+            }
+        }
+
+        bool convert_samples(void *dst, void *src, size_t samples, size_t to, size_t from, size_t quantize)
+        {
+            switch (quantize)
+            {
+                case QUANTIZE_TRUNCATE:
+                    return convert_samples(dst, src, samples, to, from);
+                case QUANTIZE_ROUND:
+                case QUANTIZE_DITHER:
+                    break;
+                default:
+                    return false;
+            }
+
+            // Quantization is applied only for floating-point to integer conversion
+            size_t ffmt     = sformat_format(from);
+            size_t tfmt     = sformat_format(to);
+            if ((ffmt != SFMT_F32) && (ffmt != SFMT_F64))
+                return convert_samples(dst, src, samples, to, from);
+            if ((tfmt == SFMT_F32) || (tfmt == SFMT_F64))
+                return convert_samples(dst, src, samples, to, from);
+            if (sformat_sign(to) < 0)
+                return false;
+
+            // Convert source sample endianess
+            if (!sample_endian_swap(src, samples, from))
+                return false;
 
+            cvt_dither_t *dither = (quantize == QUANTIZE_DITHER) ? thread_dither() : NULL;
+            if (ffmt == SFMT_F32)
+                quantize_samples(dst, static_cast<const f32_t *>(src), samples, tfmt, dither);
+            else if ((tfmt == SFMT_S32) || (tfmt == SFMT_U32))
+            {
+                // Narrowing to 32-bit floating point would lose the lower bits of 32-bit samples
+                quantize_f64_to_s32(dst, static_cast<const f64_t *>(src), samples, dither);
+                if (tfmt == SFMT_U32)
+                    flip_sign(dst, samples, tfmt);
+            }
+            else
+            {
+                // Convert 64-bit samples to 32-bit samples by chunks
+                f32_t buf[0x100];
+                size_t ssize        = (tfmt == SFMT_U24) || (tfmt == SFMT_S24) ? 3 : sformat_size_of(tfmt);
+                uint8_t *dptr       = static_cast<uint8_t *>(dst);
+                const f64_t *sptr   = static_cast<const f64_t *>(src);
 
+                for (size_t n=samples; n > 0; )
+                {
+                    size_t count        = lsp_min(n, sizeof(buf)/sizeof(f32_t));
+                    cvt_kernels()->f64_to_f32(buf, sptr, count);
+                    quantize_samples(dptr, buf, count, tfmt, dither);
+
+                    n                  -= count;
+                    sptr               += count;
+                    dptr               += count * ssize;
+                }
+            }
+
+            // Convert target sample endianess
+            return sample_endian_swap(dst, samples, to);
+        }
+    }
+}
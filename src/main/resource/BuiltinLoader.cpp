@@ -23,10 +23,24 @@
 #include <lsp-plug.in/resource/BuiltinLoader.h>
 #include <lsp-plug.in/resource/Decompressor.h>
 
+#include <stdlib.h>
+#include <string.h>
+
 namespace lsp
 {
     namespace resource
     {
+        static const uint32_t HASH_SEED         = 0x811c9dc5;
+        static const uint32_t HASH_PRIME        = 0x01000193;
+
+        static inline uint32_t hash_bytes(uint32_t hash, const char *s, size_t len)
+        {
+            // FNV-1a, the hash of the full path is computed incrementally from the parent's hash
+            for (size_t i=0; i<len; ++i)
+                hash    = (hash ^ uint8_t(s[i])) * HASH_PRIME;
+            return hash;
+        }
+
         BuiltinLoader::BuiltinLoader()
         {
             pData       = NULL;
@@ -34,10 +48,18 @@ namespace lsp
             pCatalog    = NULL;
             nCatSize    = 0;
             nBufSize    = 0;
+            vChildren   = NULL;
+            vFirst      = NULL;
+            vHash       = NULL;
+            vKeys       = NULL;
+            nHashCap    = 0;
+            pIndex      = NULL;
         }
 
         BuiltinLoader::~BuiltinLoader()
         {
+            drop_index();
+
             pData       = NULL;
             nDataSize   = 0;
             pCatalog    = NULL;
@@ -51,60 +73,177 @@ namespace lsp
             size_t buf_size
         )
         {
+            drop_index();
+
             pData       = reinterpret_cast<const uint8_t *>(data);
             nDataSize   = data_size;
             pCatalog    = catalog;
-            nCatSize    = catalog_size;
+            nCatSize    = (catalog != NULL) ? catalog_size : 0;
             nBufSize    = buf_size;
 
-            return STATUS_OK;
+            return build_index();
         }
 
-        status_t BuiltinLoader::find_entry(ssize_t *out, const io::Path *path)
+        void BuiltinLoader::drop_index()
         {
-            status_t res;
-            ssize_t index = -1;
-            LSPString item;
-            io::Path tmp;
+            if (pIndex != NULL)
+            {
+                free(pIndex);
+                pIndex      = NULL;
+            }
 
-            // Copy path data
-            if ((res = tmp.set(path)) != STATUS_OK)
-                return res;
+            vChildren   = NULL;
+            vFirst      = NULL;
+            vHash       = NULL;
+            vKeys       = NULL;
+            nHashCap    = 0;
+        }
 
-            while (true)
+        status_t BuiltinLoader::build_index()
+        {
+            if (nCatSize <= 0)
+                return STATUS_OK;
+
+            // Allocate the index
+            size_t cap          = 0x10;
+            while (cap < (nCatSize << 1))
+                cap               <<= 1;
+
+            size_t szof_children    = nCatSize * sizeof(size_t);
+            size_t szof_first       = (nCatSize + 2) * sizeof(size_t);
+            size_t szof_hash        = cap * sizeof(ssize_t);
+            size_t szof_keys        = nCatSize * sizeof(uint32_t);
+            size_t szof_queue       = nCatSize * sizeof(size_t);
+
+            uint8_t *ptr        = static_cast<uint8_t *>(malloc(szof_children + szof_first + szof_hash + szof_keys + szof_queue));
+            if (ptr == NULL)
+                return STATUS_NO_MEM;
+
+            pIndex              = ptr;
+            vChildren           = reinterpret_cast<size_t *>(ptr);
+            ptr                += szof_children;
+            vFirst              = reinterpret_cast<size_t *>(ptr);
+            ptr                += szof_first;
+            vHash               = reinterpret_cast<ssize_t *>(ptr);
+            ptr                += szof_hash;
+            size_t *queue       = reinterpret_cast<size_t *>(ptr);
+            ptr                += szof_queue;
+            vKeys               = reinterpret_cast<uint32_t *>(ptr);
+            nHashCap            = cap;
+
+            // Group entries by the parent directory: the group 0 is root, the group i+1
+            // contains children of the entry i. The catalog order is kept within the group.
+            for (size_t i=0; i<nCatSize+2; ++i)
+                vFirst[i]           = 0;
+            for (size_t i=0; i<nCatSize; ++i)
             {
-                // Get first item and remove it
-                if ((res = tmp.pop_first(&item)) != STATUS_OK)
-                    return res;
+                const raw_resource_t *ent   = &pCatalog[i];
+                if ((ent->name != NULL) && (ent->parent >= -1) && (ent->parent < ssize_t(nCatSize)))
+                    ++vFirst[ent->parent + 1];
+            }
+            for (size_t i=1; i<nCatSize+2; ++i)
+                vFirst[i]          += vFirst[i-1];
+            for (size_t i=nCatSize; (i--) > 0; )
+            {
+                const raw_resource_t *ent   = &pCatalog[i];
+                if ((ent->name != NULL) && (ent->parent >= -1) && (ent->parent < ssize_t(nCatSize)))
+                    vChildren[--vFirst[ent->parent + 1]]    = i;
+            }
 
-                // Lookup for existing directory/create yet another one
-                const raw_resource_t *found = NULL;
-                for (size_t i=0; i<nCatSize; ++i)
+            // Walk the tree from root and put each reachable entry to the hash table
+            for (size_t i=0; i<cap; ++i)
+                vHash[i]            = -1;
+
+            ssize_t dir         = -1;
+            size_t head         = 0;
+            size_t tail         = 0;
+            while (true)
+            {
+                // Only directories may have nested entries
+                if ((dir < 0) || (pCatalog[dir].type == RES_DIR))
                 {
-                    const raw_resource_t *ent   = &pCatalog[i];
-                    if ((ent == NULL) || (ent->parent != index) || (ent->name == NULL))
-                        continue;
-                    if (item.equals_utf8(ent->name))
+                    uint32_t base       = (dir >= 0) ? hash_bytes(vKeys[dir], FILE_SEPARATOR_S, 1) : HASH_SEED;
+
+                    for (size_t j=vFirst[dir+1], last=vFirst[dir+2]; j<last; ++j)
                     {
-                        found                   = ent;
-                        index                   = i;
-                        break;
+                        size_t index        = vChildren[j];
+                        const char *name    = pCatalog[index].name;
+                        size_t len          = strlen(name);
+                        if ((len <= 0) || (strchr(name, FILE_SEPARATOR_C) != NULL))
+                            continue;
+
+                        uint32_t key        = hash_bytes(base, name, len);
+                        vKeys[index]        = key;
+                        queue[tail++]       = index;
+
+                        // Keep the first entry if there are duplicates
+                        size_t k            = key & (cap - 1);
+                        for ( ; vHash[k] >= 0; k = (k + 1) & (cap - 1))
+                        {
+                            const raw_resource_t *ent   = &pCatalog[vHash[k]];
+                            if ((vKeys[vHash[k]] == key) && (ent->parent == pCatalog[index].parent) && (!strcmp(ent->name, name)))
+                                break;
+                        }
+                        if (vHash[k] < 0)
+                            vHash[k]            = index;
                     }
                 }
 
-                // Check that item exists
-                if (found == NULL)
-                    return STATUS_NOT_FOUND;
+                if (head >= tail)
+                    break;
+                dir                 = queue[head++];
+            }
+
+            return STATUS_OK;
+        }
+
+        bool BuiltinLoader::match_entry(size_t index, const char *path, size_t len) const
+        {
+            // Compare the path with names of the entry and its parents from the tail
+            while (true)
+            {
+                const raw_resource_t *ent   = &pCatalog[index];
+                size_t nlen                 = strlen(ent->name);
+                if ((nlen > len) || (memcmp(&path[len - nlen], ent->name, nlen) != 0))
+                    return false;
+                len                        -= nlen;
+
+                if (ent->parent < 0)
+                    return len <= 0;
+                if ((len <= 0) || (path[--len] != FILE_SEPARATOR_C))
+                    return false;
+                index                       = ent->parent;
+            }
+        }
 
-                // Last entry?
-                if (tmp.is_empty())
+        status_t BuiltinLoader::find_entry(ssize_t *out, const io::Path *path)
+        {
+            if (vHash == NULL)
+                return STATUS_NOT_FOUND;
+
+            const char *s   = path->as_utf8();
+            if (s == NULL)
+                return STATUS_NO_MEM;
+
+            // Ignore the single trailing separator
+            size_t len      = strlen(s);
+            if ((len > 1) && (s[len-1] == FILE_SEPARATOR_C) && (s[len-2] != FILE_SEPARATOR_C))
+                --len;
+            if (len <= 0)
+                return STATUS_NOT_FOUND;
+
+            uint32_t key    = hash_bytes(HASH_SEED, s, len);
+            for (size_t k = key & (nHashCap - 1); vHash[k] >= 0; k = (k + 1) & (nHashCap - 1))
+            {
+                ssize_t index   = vHash[k];
+                if ((vKeys[index] == key) && (match_entry(index, s, len)))
                 {
-                    *out    = index;
+                    *out            = index;
                     return STATUS_OK;
                 }
-                else if (found->type != RES_DIR)
-                    return STATUS_NOT_FOUND;
             }
+
+            return STATUS_NOT_FOUND;
         }
 
         io::IInStream *BuiltinLoader::read_stream(const io::Path *name)
@@ -136,7 +275,7 @@ namespace lsp
             }
 
             // Initialize decompressor and skip the desired amount of data to access the entry
-            res = d->init(&pData[ent->segment], ent->offset + ent->length, nBufSize);
+            res = d->init(&pData[ent->segment], nDataSize - ent->segment, ent->offset + ent->length, nBufSize);
             if (res == STATUS_OK)
             {
                 wssize_t skipped = d->skip(ent->offset);
@@ -154,35 +293,36 @@ namespace lsp
 
         ssize_t BuiltinLoader::enumerate(const io::Path *path, resource_t **list)
         {
-            ssize_t index = 0;
+            ssize_t index = -1;
             lltl::darray<resource_t> xlist;
             const raw_resource_t *ent;
 
             // Root directory?
-            if ((path->is_empty()) || (path->equals(FILE_SEPARATOR_S)))
-                index = -1;
-            else
+            if ((!path->is_empty()) && (!path->equals(FILE_SEPARATOR_S)))
             {
                 // Find entry and check that it is of directory type
                 status_t res = find_entry(&index, path);
                 if (res != STATUS_OK)
-                    return res;
+                    return -res;
 
                 ent = &pCatalog[index];
                 if (ent->type != RES_DIR)
-                    return STATUS_NOT_DIRECTORY;
+                    return -STATUS_NOT_DIRECTORY;
             }
 
             // Now create list of nested items
-            for (size_t i=0; i<nCatSize; ++i)
+            size_t first    = (vFirst != NULL) ? vFirst[index + 1] : 0;
+            size_t last     = (vFirst != NULL) ? vFirst[index + 2] : 0;
+            if ((last > first) && (!xlist.reserve(last - first)))
+                return -STATUS_NO_MEM;
+
+            for (size_t i=first; i<last; ++i)
             {
-                ent = &pCatalog[i];
-                if ((ent == NULL) || (ent->parent != index) || (ent->name == NULL))
-                    continue;
+                ent = &pCatalog[vChildren[i]];
 
                 resource_t *item = xlist.add();
                 if (item == NULL)
-                    return STATUS_NO_MEM;
+                    return -STATUS_NO_MEM;
 
                 strncpy(item->name, ent->name, RESOURCE_NAME_MAX);
                 item->name[RESOURCE_NAME_MAX - 1] = '\0';
@@ -196,5 +336,3 @@ namespace lsp
         }
     }
 }
-
-
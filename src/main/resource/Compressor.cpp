@@ -26,6 +26,8 @@
 #include <lsp-plug.in/io/OutBitStream.h>
 #include <lsp-plug.in/common/bits.h>
 #include <lsp-plug.in/common/alloc.h>
+#include <lsp-plug.in/ipc/Thread.h>
+#include <lsp-plug.in/ipc/Condition.h>
 #include <lsp-plug.in/resource/Compressor.h>
 #include <lsp-plug.in/resource/OutProxyStream.h>
 
@@ -42,10 +44,63 @@ namespace lsp
 
     namespace resource
     {
+        /**
+         * Block of the parallel mode: source data of entries that are compressed
+         * with the independent dictionary window
+         */
+        struct Compressor::block_t
+        {
+            io::OutMemoryStream     sData;          // Source data of entries
+            io::OutMemoryStream     sOut;           // Compressed data
+            lltl::darray<size_t>    vItems;         // Indices of entries stored in the block
+        };
+
+        /**
+         * State of the flush_blocks() call. Blocks are taken by workers in ascending order,
+         * all fields except constant parameters are protected by sCond
+         */
+        struct Compressor::task_t
+        {
+            ipc::Condition          sCond;          // Synchronization primitive
+            block_t               **vBlocks;        // Blocks to compress
+            const raw_resource_t   *vEntries;       // Resource entries
+            size_t                  nBlocks;        // Number of blocks
+            size_t                  nBufSize;       // Size of the dictionary window
+            size_t                  nDepth;         // Maximum number of candidates per lookup
+            size_t                  nNext;          // Index of the next block to compress
+            size_t                  nActive;        // Number of active workers
+            status_t                nError;         // Error code
+
+            explicit task_t()
+            {
+                vBlocks         = NULL;
+                vEntries        = NULL;
+                nBlocks         = 0;
+                nBufSize        = 0;
+                nDepth          = 0;
+                nNext           = 0;
+                nActive         = 0;
+                nError          = STATUS_OK;
+            }
+        };
+
+        struct Compressor::worker_t
+        {
+            ipc::Thread             sThread;        // Worker thread
+            task_t                 *pTask;          // Task to process
+
+            explicit worker_t(): sThread(worker_proc, this)
+            {
+                pTask           = NULL;
+            }
+        };
+
         Compressor::Compressor()
         {
             nSegment        = 0;
             nOffset         = 0;
+            nThreads        = 0;
+            nBlockSize      = 0;
         }
 
         Compressor::~Compressor()
@@ -55,6 +110,10 @@ namespace lsp
 
         status_t Compressor::close()
         {
+            // Write pending blocks
+            status_t bres   = (vBlocks.size() > 0) ? flush_blocks() : STATUS_OK;
+            drop_blocks();
+
             // Drop nodes
             sBuffer.destroy();
 
@@ -81,7 +140,18 @@ namespace lsp
             if (res == STATUS_OK)
                 res         = res2;
 
-            return res;
+            return (bres != STATUS_OK) ? bres : res;
+        }
+
+        void Compressor::drop_blocks()
+        {
+            for (size_t i=0, n=vBlocks.size(); i<n; ++i)
+            {
+                block_t *b      = vBlocks.uget(i);
+                if (b != NULL)
+                    delete b;
+            }
+            vBlocks.flush();
         }
 
         status_t Compressor::init(size_t buf_size, io::IOutStream *os, size_t flags)
@@ -190,24 +260,12 @@ namespace lsp
             }
         }
 
-        wssize_t Compressor::write_entry(raw_resource_t *r, io::IInStream *is)
+        status_t Compressor::compress(cbuffer_t *buf, io::OutBitStream *out, const uint8_t *head, const uint8_t *tail)
         {
-            if (sBuffer.data == NULL)
-                return -STATUS_BAD_STATE;
-
-            // Clear data
-            sTemp.clear();
-            wssize_t flength    = is->sink(&sTemp);
-            if (flength < 0)
-                return flength;
-
-            status_t res;
-            const uint8_t *head = sTemp.data();
-            const uint8_t *tail = &head[flength];
+            status_t res = STATUS_OK;
             ssize_t offset = 0, length = 0, rep = 0, append = 0;
 
             IF_TRACE(
-                wssize_t coffset    = sOS.position();
                 size_t octets       = 0;
                 size_t replays      = 0;
                 size_t repeats      = 0;
@@ -216,7 +274,7 @@ namespace lsp
             while (head < tail)
             {
                 // Estimate the length of match
-                length      = sBuffer.lookup(&offset, head, tail-head);
+                length      = buf->lookup(&offset, head, tail-head);
                 if (length == 0)
                     length      = 1;
 
@@ -225,7 +283,7 @@ namespace lsp
                 append      = length + lsp_min(rep, 4);
 
                 // Estimate size of output
-                size_t est1 = (est_uint(sBuffer.size() + *head, 5, 5) + est_uint(rep, 0, 4)) * length;     // How many bits per octet
+                size_t est1 = (est_uint(buf->size() + *head, 5, 5) + est_uint(rep, 0, 4)) * length;     // How many bits per octet
                 size_t est2 = (offset < 0) ? est1 + 1 :
                                 est_uint(offset, 5, 5) +
                                 est_uint(length - 1, 5, 5) +
@@ -235,17 +293,17 @@ namespace lsp
                 {
                     // REPLAY
                     // Offset
-                    if ((res = emit_uint(offset, 5, 5)) != STATUS_OK)
+                    if ((res = out->write_uint(offset, 5, 5)) != STATUS_OK)
                         break;
                     // Length
-                    if ((res = emit_uint(length - 1, 5, 5)) != STATUS_OK)
+                    if ((res = out->write_uint(length - 1, 5, 5)) != STATUS_OK)
                         break;
                     // Repeat
-                    if ((res = emit_uint(rep, 0, 4)) != STATUS_OK)
+                    if ((res = out->write_uint(rep, 0, 4)) != STATUS_OK)
                         break;
 
                     // Append data to buffer
-                    sBuffer.append(head, append);
+                    buf->append(head, append);
                     head           += length + rep;
 
                     IF_TRACE(
@@ -257,22 +315,53 @@ namespace lsp
                 else
                 {
                     // OCTET
+                    // Only the first octet of the match is emitted, count repeats for it
+                    if (length > 1)
+                    {
+                        rep         = calc_repeats(&head[1], tail);
+                        append      = 1 + lsp_min(rep, 4);
+                    }
+
                     // Value
-                    if ((res = emit_uint(sBuffer.size() + *head, 5, 5)) != STATUS_OK)
+                    if ((res = out->write_uint(buf->size() + *head, 5, 5)) != STATUS_OK)
                         break;
                     // Repeat
-                    if ((res = emit_uint(rep, 0, 4)) != STATUS_OK)
+                    if ((res = out->write_uint(rep, 0, 4)) != STATUS_OK)
                         break;
 
-                    // Append data to buffer
-                    sBuffer.append(head, append);
-                    head           += append;
+                    // Append data to buffer, the decompressor emits the octet and all repeats
+                    buf->append(head, append);
+                    head           += 1 + rep;
 
                     IF_TRACE(++octets);
                 }
             }
 
-            // Flush the bit sequence
+            lsp_trace("  octets: %d, replays: %d, repeats: %d",
+                    int(octets), int(replays), int(repeats));
+
+            return res;
+        }
+
+        wssize_t Compressor::write_entry(raw_resource_t *r, io::IInStream *is)
+        {
+            if (sBuffer.data == NULL)
+                return -STATUS_BAD_STATE;
+            if (nBlockSize > 0)
+                return buffer_entry(r, is);
+
+            // Clear data
+            sTemp.clear();
+            wssize_t flength    = is->sink(&sTemp);
+            if (flength < 0)
+                return flength;
+
+            IF_TRACE(
+                wssize_t coffset    = sOS.position();
+            )
+
+            const uint8_t *head = sTemp.data();
+            status_t res        = compress(&sBuffer, &sOut, head, &head[flength]);
             if (res != STATUS_OK)
                 return -res;
 
@@ -280,8 +369,6 @@ namespace lsp
             IF_TRACE(
                 size_t cbytes   = sOS.position() - coffset;
 
-                lsp_trace("  octets: %d, replays: %d, repeats: %d",
-                        int(octets), int(replays), int(repeats));
                 lsp_trace("  original size: %d, compressed size: %d, ratio: %.2f",
                         int(flength), int(cbytes), double(flength) / double(cbytes));
             )
@@ -298,6 +385,43 @@ namespace lsp
             return r->length;
         }
 
+        wssize_t Compressor::buffer_entry(raw_resource_t *r, io::IInStream *is)
+        {
+            // Start a new block if the current one is full
+            block_t *b          = vBlocks.last();
+            if ((b == NULL) || (b->sData.size() >= nBlockSize))
+            {
+                if ((b = new block_t()) == NULL)
+                    return -STATUS_NO_MEM;
+                if (!vBlocks.add(b))
+                {
+                    delete b;
+                    return -STATUS_NO_MEM;
+                }
+            }
+
+            // Append data of the entry to the block, the segment is assigned on flush
+            size_t index        = r - vEntries.array();
+            wssize_t offset     = b->sData.size();
+            if (!b->vItems.add(&index))
+                return -STATUS_NO_MEM;
+            wssize_t flength    = is->sink(&b->sData);
+            if (flength < 0)
+            {
+                b->vItems.pop();
+                return flength;
+            }
+
+            r->segment          = -1;
+            r->offset           = offset;
+            r->length           = flength;
+
+            lsp_trace("  buffered entry block=%d, offset=%d length=%d",
+                    int(vBlocks.size() - 1), int(r->offset), int(r->length));
+
+            return r->length;
+        }
+
         wssize_t Compressor::create_file(const char *name, io::IInStream *is)
         {
             io::Path tmp;
@@ -367,29 +491,6 @@ namespace lsp
             return res;
         }
 
-        status_t Compressor::emit_uint(size_t value, size_t initial, size_t stepping)
-        {
-            status_t res;
-            size_t bits     = initial;
-
-            while (true)
-            {
-                size_t max  = (1 << bits);
-                if (value < max)
-                    break;
-                if ((res = sOut.writeb(true)) != STATUS_OK)
-                    return res;
-
-                value      -= max;
-                bits       += stepping;
-            }
-
-            if ((res = sOut.writeb(false)) != STATUS_OK)
-                return res;
-
-            return (bits > 0) ? sOut.writev(value, bits) : STATUS_OK;
-        }
-
         size_t Compressor::est_uint(size_t value, size_t initial, size_t stepping)
         {
             size_t bits     = initial;
@@ -418,11 +519,160 @@ namespace lsp
             return s - head;
         }
 
+        status_t Compressor::compress_block(cbuffer_t *buf, block_t *b, const raw_resource_t *entries)
+        {
+            io::OutBitStream os;
+            status_t res        = os.wrap(&b->sOut, WRAP_NONE);
+
+            // Entries are compressed separately with the shared window, so commands
+            // never cross the boundary of the entry, like in the sequential mode
+            const uint8_t *data = b->sData.data();
+            for (size_t i=0, n=b->vItems.size(); (i < n) && (res == STATUS_OK); ++i)
+            {
+                const raw_resource_t *r = &entries[*b->vItems.uget(i)];
+                const uint8_t *head     = &data[r->offset];
+                res                     = compress(buf, &os, head, &head[r->length]);
+            }
+            status_t res2       = os.close();
+            if (res == STATUS_OK)
+                res                 = res2;
+
+            // Source data is not needed anymore
+            b->sData.drop();
+            buf->clear();
+
+            return res;
+        }
+
+        status_t Compressor::worker_proc(void *arg)
+        {
+            worker_t *w     = static_cast<worker_t *>(arg);
+            task_t *t       = w->pTask;
+
+            // Each worker compresses blocks with its own dictionary window
+            cbuffer_t buf;
+            status_t res    = buf.init(t->nBufSize);
+            buf.depth       = t->nDepth;
+
+            t->sCond.lock();
+            if ((res != STATUS_OK) && (t->nError == STATUS_OK))
+                t->nError       = res;
+
+            while ((t->nError == STATUS_OK) && (t->nNext < t->nBlocks))
+            {
+                // Take the next block and compress it outside of the critical section
+                block_t *b      = t->vBlocks[t->nNext++];
+                t->sCond.unlock();
+
+                res             = compress_block(&buf, b, t->vEntries);
+
+                t->sCond.lock();
+                if ((res != STATUS_OK) && (t->nError == STATUS_OK))
+                    t->nError       = res;
+            }
+
+            --t->nActive;
+            t->sCond.notify_all();
+            t->sCond.unlock();
+
+            buf.destroy();
+
+            return STATUS_OK;
+        }
+
+        status_t Compressor::flush_blocks()
+        {
+            size_t nblocks      = vBlocks.size();
+            size_t threads      = (nThreads > 0) ? nThreads : ipc::Thread::system_cores();
+            threads             = lsp_min(threads, nblocks);
+            status_t res        = STATUS_OK;
+
+            if (threads <= 1)
+            {
+                // Single thread: compress blocks by the caller's thread
+                sBuffer.clear();
+                for (size_t i=0; (i < nblocks) && (res == STATUS_OK); ++i)
+                    res                 = compress_block(&sBuffer, vBlocks.uget(i), vEntries.array());
+            }
+            else
+            {
+                task_t t;
+                t.vBlocks           = vBlocks.array();
+                t.vEntries          = vEntries.array();
+                t.nBlocks           = nblocks;
+                t.nBufSize          = sBuffer.cap;
+                t.nDepth            = sBuffer.depth;
+
+                // Launch workers
+                worker_t *workers   = new worker_t[threads];
+                if (workers == NULL)
+                    return STATUS_NO_MEM;
+
+                size_t started      = 0;
+                t.sCond.lock();
+                for ( ; started < threads; ++started)
+                {
+                    workers[started].pTask  = &t;
+                    if ((res = workers[started].sThread.start()) != STATUS_OK)
+                        break;
+                    ++t.nActive;
+                }
+
+                // Wait until all workers finish
+                if (started > 0)
+                {
+                    while (t.nActive > 0)
+                        t.sCond.wait();
+                    res                 = t.nError;
+                }
+                t.sCond.unlock();
+
+                for (size_t i=0; i<started; ++i)
+                    workers[i].sThread.join();
+                delete [] workers;
+            }
+
+            // Write blocks to the output, each block starts a new segment
+            for (size_t i=0; (i < nblocks) && (res == STATUS_OK); ++i)
+            {
+                block_t *b          = vBlocks.uget(i);
+                if ((res = sOut.flush()) != STATUS_OK)
+                    break;
+
+                wssize_t segment    = sOS.position();
+                if (segment < 0)
+                {
+                    res                 = status_t(-segment);
+                    break;
+                }
+                if (b->sOut.size() > 0)
+                {
+                    ssize_t written     = sOS.write(b->sOut.data(), b->sOut.size());
+                    if (written < 0)
+                        res                 = status_t(-written);
+                    else if (size_t(written) != b->sOut.size())
+                        res                 = STATUS_IO_ERROR;
+                }
+
+                for (size_t j=0, n=b->vItems.size(); j<n; ++j)
+                {
+                    raw_resource_t *r   = vEntries.uget(*b->vItems.uget(j));
+                    r->segment          = segment;
+                }
+            }
+
+            drop_blocks();
+
+            return res;
+        }
+
         status_t Compressor::flush()
         {
-            status_t res = sOut.flush();
+            status_t res = (vBlocks.size() > 0) ? flush_blocks() : STATUS_OK;
             if (res != STATUS_OK)
                 return res;
+            if ((res = sOut.flush()) != STATUS_OK)
+                return res;
 
             nSegment        = sOS.position();
             nOffset         = 0;
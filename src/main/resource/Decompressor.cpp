@@ -20,17 +20,61 @@
  */
 
 #include <lsp-plug.in/common/alloc.h>
-#include <lsp-plug.in/io/InMemoryStream.h>
+#include <lsp-plug.in/common/bits.h>
+#include <lsp-plug.in/common/endian.h>
 #include <lsp-plug.in/resource/Decompressor.h>
+#include <lsp-plug.in/stdlib/string.h>
 
 #define BUFFER_QUANTITY         0x1000
+#define BITBUF_SIZE             64
+#define MAX_REPEAT_APPEND       4
+#define SHORT_COMMAND           16
 
 namespace lsp
 {
     namespace resource
     {
+        // Codes emitted by OutBitStream::write_uint(): the prefix of N '1' bits terminated by '0' bit
+        // is followed by (initial + N * stepping) bits of the value, the value is offset by the sum of
+        // ranges of all shorter prefixes. Prefixes are limited to make any code fit the refilled buffer
+        const Decompressor::ucode_t Decompressor::vValueCodes[VALUE_CODES] =
+        {
+            // initial = 5, stepping = 5
+            { 0LL,              5,  6  },
+            { 32LL,             10, 12 },
+            { 1056LL,           15, 18 },
+            { 33824LL,          20, 24 },
+            { 1082400LL,        25, 30 },
+            { 34636832LL,       30, 36 },
+            { 1108378656LL,     35, 42 },
+            { 35468117024LL,    40, 48 },
+            { 1134979744800LL,  45, 54 }
+        };
+
+        const Decompressor::ucode_t Decompressor::vRepeatCodes[REPEAT_CODES] =
+        {
+            // initial = 0, stepping = 4
+            { 0LL,              0,  1  },
+            { 1LL,              4,  6  },
+            { 17LL,             8,  11 },
+            { 273LL,            12, 16 },
+            { 4369LL,           16, 21 },
+            { 69905LL,          20, 26 },
+            { 1118481LL,        24, 31 },
+            { 17895697LL,       28, 36 },
+            { 286331153LL,      32, 41 },
+            { 4581298449LL,     36, 46 },
+            { 73300775185LL,    40, 51 },
+            { 1172812402961LL,  44, 56 }
+        };
+
         Decompressor::Decompressor()
         {
+            pData           = NULL;
+            nAvail          = 0;
+            nBitBuf         = 0;
+            nBits           = 0;
+
             sReplay.data    = NULL;
             sReplay.off     = 0;
             sReplay.size    = 0;
@@ -56,6 +100,11 @@ namespace lsp
                 free(sReplay.data);
 
             // Clear values
+            pData           = NULL;
+            nAvail          = 0;
+            nBitBuf         = 0;
+            nBits           = 0;
+
             sReplay.data    = NULL;
             sReplay.off     = 0;
             sReplay.size    = 0;
@@ -65,28 +114,30 @@ namespace lsp
             nOffset         = 0;
             nLast           = 0;
 
-            return sIn.close();
+            return STATUS_OK;
         }
 
         status_t Decompressor::init(const void *data, size_t last, size_t buf_sz)
         {
+            // The size of data is unknown, the data is read only as far as needed
+            return init(data, SIZE_MAX, last, buf_sz);
+        }
+
+        status_t Decompressor::init(const void *data, size_t size, size_t last, size_t buf_sz)
+        {
+            if (data == NULL)
+                return STATUS_BAD_ARGUMENTS;
+
             // Create buffer
             status_t res = sBuffer.init(buf_sz);
             if (res != STATUS_OK)
                 return res;
 
-            // Create inpute memory stream
-            io::InMemoryStream *ims = new io::InMemoryStream(data, SIZE_MAX);
-            if (ims == NULL)
-                return STATUS_NO_MEM;
-
-            // Wrap input memory stream
-            res = sIn.wrap(ims, WRAP_CLOSE | WRAP_DELETE);
-            if (res != STATUS_OK)
-            {
-                ims->close();
-                delete ims;
-            }
+            // Bind the compressed data
+            pData           = static_cast<const uint8_t *>(data);
+            nAvail          = size;
+            nBitBuf         = 0;
+            nBits           = 0;
 
             // Update positions
             nOffset         = 0;
@@ -95,35 +146,81 @@ namespace lsp
             // Clear replay buffer
             sReplay.off     = 0;
             sReplay.size    = 0;
-            sReplay.cap     = 0;
+            sReplay.rep     = 0;
 
             return res;
         }
 
-        status_t Decompressor::read_uint(size_t *out, size_t initial, size_t stepping)
+        void Decompressor::refill()
         {
-            ssize_t res;
-            ssize_t bits    = initial;
-            size_t value    = 0;
-            bool flag;
-
-            while (true)
+            if (nAvail >= sizeof(uint64_t))
             {
-                if ((res = sIn.readb(&flag)) != 1)
-                    return (res < 0) ? -res : STATUS_IO_ERROR;
-                if (!flag)
-                    break;
+                // Load the whole word but account only complete bytes: the rest
+                // bits of the word are the same data and will be merged again on next refill
+                uint64_t v;
+                ::memcpy(&v, pData, sizeof(v));
+
+                size_t bytes    = (BITBUF_SIZE - nBits) >> 3;
+                nBitBuf        |= BE_TO_CPU(v) >> nBits;
+                pData          += bytes;
+                nAvail         -= bytes;
+                nBits          += bytes << 3;
+                return;
+            }
 
-                value      += 1 << bits;
-                bits       += stepping;
+            // Tail of the data, read with bytes
+            for ( ; (nAvail > 0) && (nBits <= (BITBUF_SIZE - 8)); --nAvail)
+            {
+                nBitBuf        |= uint64_t(*(pData++)) << (BITBUF_SIZE - 8 - nBits);
+                nBits          += 8;
             }
+        }
 
-            size_t v        = 0;
-            if ((res = sIn.readv(&v, bits)) != bits)
-                return (res < 0) ? -res : STATUS_IO_ERROR;
+        inline bool Decompressor::take_code(uint64_t *buf, size_t *bits, wsize_t *out, const ucode_t *codes, size_t count)
+        {
+            // The number of leading '1' bits selects the code
+            uint64_t inv        = ~(*buf);
+            size_t prefix       = (inv != 0) ? BITBUF_SIZE - 1 - int_log2(inv) : BITBUF_SIZE;
+            if (prefix >= count)
+                return false;
 
-            *out            = value + v;
-            return STATUS_OK;
+            const ucode_t *c    = &codes[prefix];
+            if (c->length > *bits)
+                return false;
+
+            *out                = c->base + ((c->bits > 0) ? ((*buf) << (prefix + 1)) >> (BITBUF_SIZE - c->bits) : 0);
+            *buf              <<= c->length;
+            *bits              -= c->length;
+
+            return true;
+        }
+
+        status_t Decompressor::read_code(wsize_t *out, const ucode_t *codes, size_t count)
+        {
+            if (nBits < (BITBUF_SIZE - 8))
+                refill();
+            if (take_code(&nBitBuf, &nBits, out, codes, count))
+                return STATUS_OK;
+
+            // Distinguish the end of data from the corrupted code
+            uint64_t inv        = ~nBitBuf;
+            size_t prefix       = (inv != 0) ? BITBUF_SIZE - 1 - int_log2(inv) : BITBUF_SIZE;
+            return ((prefix >= count) && (prefix < nBits)) ? STATUS_CORRUPTED : STATUS_EOF;
+        }
+
+        inline void Decompressor::append_buf(const uint8_t *src, size_t count)
+        {
+            // Avoid the call for the most common case when the buffer does not need to be shifted
+            ssize_t tail        = sBuffer.tail + count;
+            if (tail > (sBuffer.cap << 1))
+            {
+                sBuffer.append(src, count);
+                return;
+            }
+
+            memcpy(&sBuffer.data[sBuffer.tail], src, count);
+            sBuffer.tail        = tail;
+            sBuffer.head        = lsp_max(sBuffer.head, tail - sBuffer.cap);
         }
 
         status_t Decompressor::close()
@@ -218,62 +315,169 @@ namespace lsp
             return sReplay.data[sReplay.off-1];
         }
 
-        status_t Decompressor::fill_buf()
+        status_t Decompressor::fill_buf(uint8_t *dst, size_t avail, size_t *emitted)
         {
+            *emitted            = 0;
+
             // Check that data is present in the buffer
             if ((sReplay.off < sReplay.size) || (sReplay.rep > 0))
                 return STATUS_OK;
 
             status_t res;
-            size_t offset, length, rep, append;
+            wsize_t offset, length, rep, fill;
             uint8_t b;
 
             // Read offset
-            if ((res = read_uint(&offset, 5, 5)) != STATUS_OK)
+            if ((res = read_code(&offset, vValueCodes, VALUE_CODES)) != STATUS_OK)
                 return res;
 
             if (offset < sBuffer.size())
             {
                 // REPLAY
                 // Length
-                if ((res = read_uint(&length, 5, 5)) != STATUS_OK)
+                if ((res = read_code(&length, vValueCodes, VALUE_CODES)) != STATUS_OK)
                     return res;
                 // Repeat
-                if ((res = read_uint(&rep, 0, 4)) != STATUS_OK)
+                if ((res = read_code(&rep, vRepeatCodes, REPEAT_CODES)) != STATUS_OK)
                     return res;
 
-                // Fill replay buffer with data
-                length += 1;
-                if ((res = set_buf(offset, length, rep)) != STATUS_OK)
-                    return res;
-
-                // Append decompression buffer
-                b           = sReplay.data[length - 1];
-                append      = lsp_min(rep, 4u);
-                sBuffer.append(sReplay.data, length);
+                length         += 1;
+                if (length > (sBuffer.size() - offset))
+                    return STATUS_CORRUPTED;
+                b               = sBuffer.data[sBuffer.head + offset + length - 1];
+                fill            = rep;
             }
             else
             {
                 // OCTET
                 // Repeat
-                if ((res = read_uint(&rep, 0, 4)) != STATUS_OK)
+                if ((res = read_code(&rep, vRepeatCodes, REPEAT_CODES)) != STATUS_OK)
                     return res;
 
-                b           = offset - sBuffer.size();
-                append      = lsp_min(rep, 4u) + 1;
+                if ((offset - sBuffer.size()) > 0xff)
+                    return STATUS_CORRUPTED;
+                b               = offset - sBuffer.size();
+                length          = 0;
+                fill            = rep + 1;
+            }
 
-                // Fill replay buffer with data
-                if ((res = set_bufc(b, rep)) != STATUS_OK)
+            // The buffer is appended with the data and at most MAX_REPEAT_APPEND repeats
+            size_t extra        = fill - (rep - lsp_min(rep, wsize_t(MAX_REPEAT_APPEND)));
+            if ((dst != NULL) && ((length + fill) <= avail))
+            {
+                // The whole command fits into the destination buffer, emit it directly
+                // and append the decompression buffer from the destination buffer
+                if (length > 0)
+                    memcpy(dst, &sBuffer.data[sBuffer.head + offset], length);
+                memset(&dst[length], b, fill);
+                append_buf(dst, length + extra);
+                *emitted            = length + fill;
+                return STATUS_OK;
+            }
+
+            // Fill replay buffer with data and append decompression buffer
+            uint8_t tail[MAX_REPEAT_APPEND + 1];
+            if (length > 0)
+            {
+                if ((res = set_buf(offset, length, rep)) != STATUS_OK)
                     return res;
+                append_buf(sReplay.data, length);
             }
+            else if ((res = set_bufc(b, rep)) != STATUS_OK)
+                return res;
 
-            // Append decompression buffer
-            while (append--)
-                sBuffer.append(b);
+            memset(tail, b, extra);
+            append_buf(tail, extra);
 
             return STATUS_OK;
         }
 
+        size_t Decompressor::decode_direct(uint8_t *dst, size_t avail)
+        {
+            size_t done         = 0;
+
+            // Decode commands while they completely fit into the destination buffer, the bit buffer
+            // is committed only for fully decoded commands, the rest is left to fill_buf()
+            while (done < avail)
+            {
+                if (nBits < (BITBUF_SIZE - 8))
+                    refill();
+
+                uint64_t buf        = nBitBuf;
+                size_t bits         = nBits;
+                size_t size         = sBuffer.size();
+                wsize_t offset, length, rep, fill;
+                uint8_t b;
+
+                if (!take_code(&buf, &bits, &offset, vValueCodes, VALUE_CODES))
+                    break;
+
+                if (offset < size)
+                {
+                    // REPLAY
+                    if ((!take_code(&buf, &bits, &length, vValueCodes, VALUE_CODES)) ||
+                        (!take_code(&buf, &bits, &rep, vRepeatCodes, REPEAT_CODES)))
+                        break;
+                    length         += 1;
+                    if (length > (size - offset))
+                        break;
+                    b               = sBuffer.data[sBuffer.head + offset + length - 1];
+                    fill            = rep;
+                }
+                else
+                {
+                    // OCTET
+                    if (!take_code(&buf, &bits, &rep, vRepeatCodes, REPEAT_CODES))
+                        break;
+                    if ((offset - size) > 0xff)
+                        break;
+                    b               = offset - size;
+                    length          = 0;
+                    fill            = rep + 1;
+                }
+
+                if ((length + fill) > (avail - done))
+                    break;
+
+                // Commit the command
+                nBitBuf             = buf;
+                nBits               = bits;
+
+                uint8_t *d          = &dst[done];
+                size_t n            = length + fill - (rep - lsp_min(rep, wsize_t(MAX_REPEAT_APPEND)));
+                if ((length <= SHORT_COMMAND) && (fill <= SHORT_COMMAND) &&
+                    ((done + length + SHORT_COMMAND) <= avail) &&
+                    ((sBuffer.tail + length + SHORT_COMMAND) <= (sBuffer.cap << 1)))
+                {
+                    // Short command: copy and fill with fixed-size blocks, extra bytes are
+                    // overwritten later or lie beyond the valid data
+                    uint8_t *t          = &sBuffer.data[sBuffer.tail];
+                    if (length > 0)
+                    {
+                        // The source may overlap the tail of the buffer, copy it through the temporary storage
+                        uint8_t tmp[SHORT_COMMAND];
+                        memcpy(tmp, &sBuffer.data[sBuffer.head + offset], SHORT_COMMAND);
+                        memcpy(d, tmp, SHORT_COMMAND);
+                        memcpy(t, tmp, SHORT_COMMAND);
+                    }
+                    memset(&d[length], b, SHORT_COMMAND);
+                    memset(&t[length], b, SHORT_COMMAND);
+                    sBuffer.tail       += n;
+                    sBuffer.head        = lsp_max(sBuffer.head, sBuffer.tail - sBuffer.cap);
+                }
+                else
+                {
+                    if (length > 0)
+                        memcpy(d, &sBuffer.data[sBuffer.head + offset], length);
+                    memset(&d[length], b, fill);
+                    append_buf(d, n);
+                }
+                done               += length + fill;
+            }
+
+            return done;
+        }
+
         ssize_t Decompressor::read(void *dst, size_t count)
         {
             status_t res;
@@ -299,14 +503,25 @@ namespace lsp
                     continue;
                 }
 
-                // There is no data in the buffer, try to get new data
-                if ((res = fill_buf()) != STATUS_OK)
+                // There is no data in the buffer, try to decode new data directly to the destination
+                size_t avail    = lsp_min(count - nread, nLast - nOffset);
+                if ((bufrd = decode_direct(&d[nread], avail)) > 0)
+                {
+                    nOffset        += bufrd;
+                    nread          += bufrd;
+                    continue;
+                }
+
+                // Decode the command with the replay buffer
+                if ((res = fill_buf(&d[nread], avail, &bufrd)) != STATUS_OK)
                 {
                     if (nread > 0)
                         break;
                     set_error(res);
                     return -res;
                 }
+                nOffset        += bufrd;
+                nread          += bufrd;
             }
 
             set_error(STATUS_OK);
@@ -316,6 +531,7 @@ namespace lsp
         ssize_t Decompressor::read_byte()
         {
             status_t res;
+            size_t emitted;
 
             if (nOffset >= nLast)
                 return -set_error(STATUS_EOF);
@@ -329,10 +545,11 @@ namespace lsp
                     ++nOffset;
                     return b;
                 }
-            } while ((res = fill_buf()) != STATUS_OK);
+            } while ((res = fill_buf(NULL, 0, &emitted)) == STATUS_OK);
 
             set_error(res);
-            return res;
+            return -res;
         }
     }
 }
+
@@ -27,13 +27,41 @@ namespace lsp
 {
     namespace resource
     {
+        static inline size_t prefix_hash(const uint8_t *p)
+        {
+            uint32_t v      = (uint32_t(p[0]) << 16) | (uint32_t(p[1]) << 8) | p[2];
+            return (v * 2654435761U) >> (32 - cbuffer_t::HASH_BITS);
+        }
+
+        static inline size_t key2(const uint8_t *p)
+        {
+            return (size_t(p[0]) << 8) | p[1];
+        }
+
+        static void rebase(int32_t *v, size_t count, ssize_t delta)
+        {
+            for (size_t i=0; i<count; ++i)
+                v[i]    = (v[i] >= delta) ? v[i] - delta : -1;
+        }
+
         cbuffer_t::cbuffer_t()
         {
             data        = NULL;
-            index       = NULL;
+            prev3       = NULL;
+            next2       = NULL;
+            next1       = NULL;
+            hash3       = NULL;
+            first2      = NULL;
+            last2       = NULL;
+            first1      = NULL;
+            last1       = NULL;
             head        = 0;
             tail        = 0;
             cap         = 0;
+            ix3         = 0;
+            ix2         = 0;
+            ix1         = 0;
+            depth       = 0;
         }
 
         cbuffer_t::~cbuffer_t()
@@ -43,19 +71,30 @@ namespace lsp
 
         status_t cbuffer_t::init(size_t capacity)
         {
-            size_t dbuf     = capacity * 2 * sizeof(uint8_t);
-            size_t ibuf     = capacity * 2 * sizeof(uint32_t);
+            size_t dbuf     = align_size(capacity * 2 * sizeof(uint8_t), sizeof(int32_t));
+            size_t lbuf     = capacity * 2 * sizeof(int32_t);
+            size_t tbuf     = (HASH_SIZE + PAIR_SIZE * 2 + BYTE_SIZE * 2) * sizeof(int32_t);
 
-            uint8_t *ptr    = static_cast<uint8_t *>(realloc(data, dbuf + ibuf));
+            uint8_t *ptr    = static_cast<uint8_t *>(realloc(data, dbuf + lbuf * 3 + tbuf));
             if (ptr == NULL)
                 return STATUS_NO_MEM;
 
             data            = ptr;
-            index           = reinterpret_cast<uint32_t *>(&ptr[dbuf]);
+            ptr            += dbuf;
+            prev3           = reinterpret_cast<int32_t *>(ptr);
+            next2           = &prev3[capacity * 2];
+            next1           = &next2[capacity * 2];
+            hash3           = &next1[capacity * 2];
+            first2          = &hash3[HASH_SIZE];
+            last2           = &first2[PAIR_SIZE];
+            first1          = &last2[PAIR_SIZE];
+            last1           = &first1[BYTE_SIZE];
             head            = 0;
             tail            = 0;
             cap             = capacity;
 
+            reset_index();
+
             return STATUS_OK;
         }
 
@@ -64,115 +103,222 @@ namespace lsp
             if (data != NULL)
                 free(data);
             data            = NULL;
-            index           = NULL;
+            prev3           = NULL;
+            next2           = NULL;
+            next1           = NULL;
+            hash3           = NULL;
+            first2          = NULL;
+            last2           = NULL;
+            first1          = NULL;
+            last1           = NULL;
             head            = 0;
             tail            = 0;
             cap             = 0;
+            ix3             = 0;
+            ix2             = 0;
+            ix1             = 0;
         }
 
-        void cbuffer_t::append(const void *src, ssize_t count)
+        void cbuffer_t::reset_index()
         {
-            const uint8_t *v    = reinterpret_cast<const uint8_t *>(src);
-            ssize_t avail       = ((cap << 1) - tail);
-            if (count < avail)
+            // All tables are stored sequentially, fill them with -1
+            memset(hash3, 0xff, (HASH_SIZE + PAIR_SIZE * 2 + BYTE_SIZE * 2) * sizeof(int32_t));
+            ix3             = 0;
+            ix2             = 0;
+            ix1             = 0;
+        }
+
+        void cbuffer_t::update_index()
+        {
+            // Index bytes
+            for (ssize_t i=lsp_max(ix1, head); i < tail; ++i)
             {
-                memcpy(&data[tail], v, count * sizeof(uint8_t));
-                bzero(&index[tail], count * sizeof(uint32_t));
-                tail      += count;
-                head       = lsp_max(head, tail - cap);
+                size_t k        = data[i];
+                next1[i]        = -1;
+                if (last1[k] >= 0)
+                    next1[last1[k]] = i;
+                else
+                    first1[k]       = i;
+                last1[k]        = i;
             }
-            else if (count < cap)
+            ix1             = tail;
+
+            // Index 2-byte prefixes
+            for (ssize_t i=lsp_max(ix2, head), n=tail-1; i < n; ++i)
             {
-                ssize_t head    = tail + count - cap;
-                memmove(data, &data[head], tail - head);
-                memcpy(&data[tail - head], v, count);
+                size_t k        = key2(&data[i]);
+                next2[i]        = -1;
+                if (last2[k] >= 0)
+                    next2[last2[k]] = i;
+                else
+                    first2[k]       = i;
+                last2[k]        = i;
+            }
+            ix2             = lsp_max(tail - 1, ssize_t(0));
 
-                memmove(index, &index[head], (tail - head) * sizeof(uint32_t));
-                bzero(&index[tail - head], count * sizeof(uint32_t));
+            // Index 3-byte prefixes
+            for (ssize_t i=lsp_max(ix3, head), n=tail-2; i < n; ++i)
+            {
+                size_t h        = prefix_hash(&data[i]);
+                prev3[i]        = hash3[h];
+                hash3[h]        = i;
+            }
+            ix3             = lsp_max(tail - 2, ssize_t(0));
+        }
+
+        ssize_t cbuffer_t::first_of(int32_t *first, int32_t *last, const int32_t *next, size_t key)
+        {
+            // Skip positions that have left the window
+            ssize_t f       = first[key];
+            while ((f >= 0) && (f < head))
+                f               = next[f];
+
+            if (f < 0)
+            {
+                first[key]      = -1;
+                last[key]       = -1;
             }
             else
+                first[key]      = f;
+
+            return f;
+        }
+
+        void cbuffer_t::shift()
+        {
+            // Drop the expired positions from the lists, head is always not less than cap here
+            for (size_t i=0; i<PAIR_SIZE; ++i)
+                first_of(first2, last2, next2, i);
+            for (size_t i=0; i<BYTE_SIZE; ++i)
+                first_of(first1, last1, next1, i);
+
+            // Move the data and the links
+            size_t count    = tail - cap;
+            memmove(data, &data[cap], count * sizeof(uint8_t));
+            memmove(prev3, &prev3[cap], count * sizeof(int32_t));
+            memmove(next2, &next2[cap], count * sizeof(int32_t));
+            memmove(next1, &next1[cap], count * sizeof(int32_t));
+
+            rebase(prev3, count, cap);
+            rebase(next2, count, cap);
+            rebase(next1, count, cap);
+            rebase(hash3, HASH_SIZE + PAIR_SIZE * 2 + BYTE_SIZE * 2, cap);
+
+            head           -= cap;
+            tail           -= cap;
+            ix3             = lsp_max(ix3 - cap, ssize_t(0));
+            ix2             = lsp_max(ix2 - cap, ssize_t(0));
+            ix1             = lsp_max(ix1 - cap, ssize_t(0));
+        }
+
+        void cbuffer_t::append(const void *src, ssize_t count)
+        {
+            const uint8_t *v    = reinterpret_cast<const uint8_t *>(src);
+            if (count <= 0)
+                return;
+
+            // Only the last cap bytes are kept in the buffer
+            if (count >= cap)
             {
                 memcpy(data, &v[count - cap], cap * sizeof(uint8_t));
-                bzero(index, cap * sizeof(uint32_t));
-
                 head       = 0;
                 tail       = cap;
+                reset_index();
+                return;
             }
+
+            head       = lsp_max(head, tail + count - cap);
+            if ((tail + count) > (cap << 1))
+                shift();
+
+            memcpy(&data[tail], v, count * sizeof(uint8_t));
+            tail      += count;
         }
 
         void cbuffer_t::append(uint8_t v)
         {
             // Shift buffer if needed
+            head            = lsp_max(head, tail + 1 - cap);
             if (tail >= (cap << 1))
-            {
-                memmove(data, &data[cap],   cap * sizeof(uint8_t));
-                memmove(index, &index[cap], cap * sizeof(uint32_t));
-                head  -= cap;
-                tail  -= cap;
-            }
+                shift();
 
             // Append byte
-            data[tail]      = v;        // Data byte
-            index[tail]     = 0;        // No index
+            data[tail]      = v;
             ++tail;
-            head            = lsp_max(head, tail - cap);
+        }
+
+        size_t cbuffer_t::match(ssize_t pos, const uint8_t *s, size_t avail) const
+        {
+            const uint8_t *p    = &data[pos];
+            size_t count        = lsp_min(avail, size_t(tail - pos));
+            size_t len          = 0;
+            while ((len < count) && (p[len] == s[len]))
+                ++len;
+            return len;
         }
 
         size_t cbuffer_t::lookup(ssize_t *out, const void *src, size_t avail)
         {
             ssize_t offset      = -1;
             size_t len          = 0;
-
             const uint8_t *s    = reinterpret_cast<const uint8_t *>(src);
-            const uint8_t *p    = &data[head];
-            uint32_t *ix        = &index[head];
-            ssize_t ixp         = -1;
-            size_t di           = 0;
 
-            for (size_t i=0, n=tail - head; i<(n - len); i += di)
+            update_index();
+
+            // Walk the hash chain from the most recent position to the oldest one,
+            // the earliest position wins among matches of the same length
+            if (avail >= 3)
             {
-                // Find first character match
-                if (p[i] != *s)
+                size_t left         = depth;
+                for (ssize_t i = hash3[prefix_hash(s)]; i >= head; i = prev3[i])
                 {
-                    di          = 1;
-                    continue;
+                    if (depth > 0)
+                    {
+                        if (left <= 0)
+                            break;
+                        --left;
+                    }
+
+                    // Quick test
+                    if (len >= 3)
+                    {
+                        if ((tail - i) < ssize_t(len))
+                            continue;
+                        if (data[i + len - 1] != s[len - 1])
+                            continue;
+                    }
+
+                    // Perform full test
+                    size_t slen         = match(i, s, avail);
+                    if ((slen >= 3) && (slen >= len))
+                    {
+                        offset              = i;
+                        len                 = slen;
+                    }
                 }
+            }
 
-                // Symbol matched, update index it if needed
-                if ((ixp >= 0) && (!ix[ixp]))
-                    ix[ixp]     = i - ixp;
-                ixp = i;                            // Save index as previous match
-                di  = (ix[i]) ? ix[i] : 1;
-
-                // Quick test
-                if (len >= 3)
+            // Find the earliest match of 2-byte prefix or the earliest byte
+            if ((len < 3) && (avail >= 2))
+            {
+                ssize_t f           = first_of(first2, last2, next2, key2(s));
+                if (f >= 0)
                 {
-                    // Check last byte
-                    size_t last   = len - 1;
-                    if (p[i + last] != s[last])
-                        continue;
-
-                    // Check middle byte
-                    last >>= 1;
-                    if (p[i + last] != s[last])
-                        continue;
+                    offset              = f;
+                    len                 = match(f, s, avail);
                 }
-
-                // Perform full test
-                size_t slen     = 1; // Sequence length
-                size_t count    = lsp_min(avail, n - i);
-                for (size_t j=1; j<count; ++j, ++slen)
-                    if (p[i+j] != s[j])
-                        break;
-
-                if (len < slen)
+            }
+            if ((len <= 0) && (avail >= 1))
+            {
+                ssize_t f           = first_of(first1, last1, next1, s[0]);
+                if (f >= 0)
                 {
-                    offset          = i;
-                    len             = slen;
+                    offset              = f;
+                    len                 = match(f, s, avail);
                 }
             }
 
-            *out        = offset;
+            *out        = (offset >= 0) ? offset - head : -1;
             return len;
         }
 
@@ -180,6 +326,8 @@ namespace lsp
         {
             head            = 0;
             tail            = 0;
+            if (data != NULL)
+                reset_index();
         }
 
         dbuffer_t::dbuffer_t()
@@ -223,25 +371,28 @@ namespace lsp
         void dbuffer_t::append(const void *src, ssize_t count)
         {
             const uint8_t *v    = reinterpret_cast<const uint8_t *>(src);
-            ssize_t avail       = ((cap << 1) - tail);
-            if (count < avail)
-            {
-                memcpy(&data[tail], v, count * sizeof(uint8_t));
-                tail      += count;
-                head       = lsp_max(head, tail - cap);
-            }
-            else if (count < cap)
-            {
-                ssize_t head    = tail + count - cap;
-                memmove(data, &data[head], tail - head);
-                memcpy(&data[tail - head], v, count);
-            }
-            else
+            if (count <= 0)
+                return;
+
+            // Only the last cap bytes are kept in the buffer
+            if (count >= cap)
             {
                 memcpy(data, &v[count - cap], cap * sizeof(uint8_t));
                 head       = 0;
                 tail       = cap;
+                return;
             }
+
+            head       = lsp_max(head, tail + count - cap);
+            if ((tail + count) > (cap << 1))
+            {
+                memmove(data, &data[cap], (tail - cap) * sizeof(uint8_t));
+                head      -= cap;
+                tail      -= cap;
+            }
+
+            memcpy(&data[tail], v, count * sizeof(uint8_t));
+            tail      += count;
         }
 
         void dbuffer_t::append(uint8_t v)
@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 3 апр. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <lsp-plug.in/test-fw/ptest.h>
+#include <lsp-plug.in/fmt/lspc/lspc.h>
+#include <lsp-plug.in/fmt/lspc/AudioReader.h>
+#include <lsp-plug.in/fmt/lspc/AudioWriter.h>
+#include <lsp-plug.in/io/Path.h>
+#include <stdlib.h>
+
+#define CHANNELS        2
+#define FRAMES          0x40000
+#define BLK_SIZE        0x1000
+
+using namespace lsp;
+
+namespace
+{
+    typedef struct format_t
+    {
+        const char     *name;
+        size_t          format;
+        size_t          bps;
+    } format_t;
+
+    static const format_t formats[] =
+    {
+        { "u8le",       LSPC_SAMPLE_FMT_U8LE,   1 },
+        { "u8be",       LSPC_SAMPLE_FMT_U8BE,   1 },
+        { "s8le",       LSPC_SAMPLE_FMT_S8LE,   1 },
+        { "s8be",       LSPC_SAMPLE_FMT_S8BE,   1 },
+        { "u16le",      LSPC_SAMPLE_FMT_U16LE,  2 },
+        { "u16be",      LSPC_SAMPLE_FMT_U16BE,  2 },
+        { "s16le",      LSPC_SAMPLE_FMT_S16LE,  2 },
+        { "s16be",      LSPC_SAMPLE_FMT_S16BE,  2 },
+        { "u24le",      LSPC_SAMPLE_FMT_U24LE,  3 },
+        { "u24be",      LSPC_SAMPLE_FMT_U24BE,  3 },
+        { "s24le",      LSPC_SAMPLE_FMT_S24LE,  3 },
+        { "s24be",      LSPC_SAMPLE_FMT_S24BE,  3 },
+        { "u32le",      LSPC_SAMPLE_FMT_U32LE,  4 },
+        { "u32be",      LSPC_SAMPLE_FMT_U32BE,  4 },
+        { "s32le",      LSPC_SAMPLE_FMT_S32LE,  4 },
+        { "s32be",      LSPC_SAMPLE_FMT_S32BE,  4 },
+        { "f32le",      LSPC_SAMPLE_FMT_F32LE,  4 },
+        { "f32be",      LSPC_SAMPLE_FMT_F32BE,  4 },
+        { "f64le",      LSPC_SAMPLE_FMT_F64LE,  8 },
+        { "f64be",      LSPC_SAMPLE_FMT_F64BE,  8 }
+    };
+}
+
+PTEST_BEGIN("runtime.fmt.lspc", audio, 5, 1)
+
+    status_t write_file(const io::Path *path, size_t format, float * const *data)
+    {
+        lspc::File fd;
+        lspc::AudioWriter aw;
+        lspc::audio_parameters_t p;
+
+        p.channels          = CHANNELS;
+        p.sample_format     = format;
+        p.sample_rate       = 48000;
+        p.codec             = LSPC_CODEC_PCM;
+        p.frames            = FRAMES;
+
+        status_t res        = fd.create(path);
+        if (res != STATUS_OK)
+            return res;
+        if ((res = aw.open(&fd, &p)) != STATUS_OK)
+        {
+            fd.close();
+            return res;
+        }
+
+        const float *vp[CHANNELS];
+        for (size_t off=0; (off < FRAMES) && (res == STATUS_OK); off += BLK_SIZE)
+        {
+            for (size_t i=0; i<CHANNELS; ++i)
+                vp[i]               = &data[i][off];
+            res                 = aw.write_samples(vp, BLK_SIZE);
+        }
+
+        status_t xres       = aw.close();
+        if (res == STATUS_OK)
+            res                 = xres;
+        xres                = fd.close();
+        return (res == STATUS_OK) ? xres : res;
+    }
+
+    status_t read_file(const io::Path *path, float * const *data)
+    {
+        lspc::File fd;
+        lspc::AudioReader ar;
+
+        status_t res        = fd.open(path);
+        if (res != STATUS_OK)
+            return res;
+        if ((res = ar.open(&fd)) != STATUS_OK)
+        {
+            fd.close();
+            return res;
+        }
+
+        float *vp[CHANNELS];
+        for (size_t off=0; off < FRAMES; off += BLK_SIZE)
+        {
+            for (size_t i=0; i<CHANNELS; ++i)
+                vp[i]               = &data[i][off];
+            ssize_t n           = ar.read_samples(vp, BLK_SIZE);
+            if (n != BLK_SIZE)
+            {
+                res                 = (n < 0) ? status_t(-n) : STATUS_CORRUPTED_FILE;
+                break;
+            }
+        }
+
+        status_t xres       = ar.close();
+        if (res == STATUS_OK)
+            res                 = xres;
+        xres                = fd.close();
+        return (res == STATUS_OK) ? xres : res;
+    }
+
+    PTEST_MAIN
+    {
+        char key[0x40];
+        io::Path path;
+        if (!path.fmt("%s/ptest-%s.lspc", tempdir(), full_name()))
+            PTEST_FAIL_MSG("Could not format path");
+
+        float *data     = static_cast<float *>(malloc(CHANNELS * FRAMES * sizeof(float)));
+        if (data == NULL)
+            PTEST_FAIL_MSG("Could not allocate buffers");
+
+        float *vp[CHANNELS];
+        for (size_t i=0; i<CHANNELS; ++i)
+            vp[i]           = &data[i * FRAMES];
+        for (size_t i=0; i<CHANNELS * FRAMES; ++i)
+            data[i]         = float(rand()) / RAND_MAX * 1.8f - 0.9f;
+
+        for (size_t i=0, n=sizeof(formats)/sizeof(format_t); i<n; ++i)
+        {
+            const format_t *f = &formats[i];
+
+            // Amount of data passed through the stream per one iteration, in megabytes
+            double mb   = double(CHANNELS * FRAMES * (sizeof(float) + f->bps)) / (1024.0 * 1024.0);
+            printf("Transferring %s: %.2f MB per iteration...\n", f->name, mb);
+
+            status_t res = STATUS_OK;
+
+            snprintf(key, sizeof(key), "write_samples::%s", f->name);
+            PTEST_LOOP(key,
+                if (res == STATUS_OK)
+                    res = write_file(&path, f->format, vp);
+            );
+            if (res != STATUS_OK)
+            {
+                free(data);
+                PTEST_FAIL_MSG("Error writing file for format %s: %d", f->name, int(res));
+            }
+
+            snprintf(key, sizeof(key), "read_samples::%s", f->name);
+            PTEST_LOOP(key,
+                if (res == STATUS_OK)
+                    res = read_file(&path, vp);
+            );
+            if (res != STATUS_OK)
+            {
+                free(data);
+                PTEST_FAIL_MSG("Error reading file for format %s: %d", f->name, int(res));
+            }
+
+            PTEST_SEPARATOR;
+        }
+
+        path.remove();
+        free(data);
+    }
+
+PTEST_END
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 24 мар. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/test-fw/ptest.h>
+#include <lsp-plug.in/io/Path.h>
+#include <lsp-plug.in/io/PathView.h>
+#include <stdlib.h>
+
+#define POOL_SIZE       0x400
+#define PATH_COUNT      (1 << 20)
+
+using namespace lsp;
+using namespace lsp::io;
+
+static const char *components[] =
+{
+    "usr", "share", "lib", "local", "bin", "home", "user", "project",
+    "src", "main", "include", "test", "resources", "audio", "samples", "presets",
+    ".", "..", ".", ".."
+};
+
+PTEST_BEGIN("runtime.io", path, 5, 1)
+
+    void generate(LSPString *pool, size_t count)
+    {
+        size_t n_comp = sizeof(components) / sizeof(const char *);
+
+        for (size_t i=0; i<count; ++i)
+        {
+            LSPString *s = &pool[i];
+            size_t items = 4 + (rand() % 8);
+
+            if (rand() & 1)
+                s->append(FILE_SEPARATOR_C);
+            for (size_t j=0; j<items; ++j)
+            {
+                if (j > 0)
+                {
+                    s->append(FILE_SEPARATOR_C);
+                    if ((rand() & 0x7) == 0)
+                        s->append(FILE_SEPARATOR_C);
+                }
+                s->append_ascii(components[rand() % n_comp]);
+            }
+            s->append_ascii(".ext");
+        }
+    }
+
+    size_t process_legacy(const LSPString *pool)
+    {
+        size_t items = 0;
+
+        for (size_t i=0; i<PATH_COUNT; ++i)
+        {
+            Path p, c;
+            LSPString item;
+
+            p.set(&pool[i % POOL_SIZE]);
+            p.get_canonical(&c);
+            while (c.pop_first(&item) == STATUS_OK)
+                ++items;
+        }
+
+        return items;
+    }
+
+    size_t process_inplace(const LSPString *pool)
+    {
+        size_t items = 0;
+        Path p;
+        PathView v, item;
+
+        for (size_t i=0; i<PATH_COUNT; ++i)
+        {
+            p.set(&pool[i % POOL_SIZE]);
+            p.canonicalize();
+            v.set(&p);
+            while (v.pop_first(&item) == STATUS_OK)
+                ++items;
+        }
+
+        return items;
+    }
+
+    PTEST_MAIN
+    {
+        LSPString *pool = new LSPString[POOL_SIZE];
+        generate(pool, POOL_SIZE);
+
+        size_t n1 = process_legacy(pool);
+        size_t n2 = process_inplace(pool);
+        if (n1 != n2)
+        {
+            delete [] pool;
+            PTEST_FAIL_MSG("Number of path items differs: %d vs %d", int(n1), int(n2));
+        }
+
+        printf("Canonicalizing and splitting %d paths...\n", int(PATH_COUNT));
+        PTEST_LOOP("legacy",
+            process_legacy(pool);
+        );
+        PTEST_LOOP("inplace",
+            process_inplace(pool);
+        );
+
+        delete [] pool;
+    }
+
+PTEST_END
@@ -0,0 +1,259 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 28 мар. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/test-fw/ptest.h>
+#include <lsp-plug.in/stdlib/string.h>
+#include <private/mm/cvt.h>
+#include <stdlib.h>
+
+#define SAMPLES         0x4000
+#define ITERATIONS      0x800
+#define MAX_SETS        8
+
+using namespace lsp;
+using namespace lsp::mm;
+
+namespace
+{
+    typedef struct kernel_t
+    {
+        const char             *name;
+        cvt_sample_t cvt_kernels_t::*func;
+        size_t                  ssize;
+        size_t                  dsize;
+    } kernel_t;
+
+    static const kernel_t kernels[] =
+    {
+        { "u8_to_f32",  &cvt_kernels_t::u8_to_f32,  1, 4 },
+        { "s16_to_f32", &cvt_kernels_t::s16_to_f32, 2, 4 },
+        { "s24_to_f32", &cvt_kernels_t::s24_to_f32, 3, 4 },
+        { "s32_to_f32", &cvt_kernels_t::s32_to_f32, 4, 4 },
+        { "f64_to_f32", &cvt_kernels_t::f64_to_f32, 8, 4 },
+        { "f32_to_u8",  &cvt_kernels_t::f32_to_u8,  4, 1 },
+        { "f32_to_s16", &cvt_kernels_t::f32_to_s16, 4, 2 },
+        { "f32_to_s24", &cvt_kernels_t::f32_to_s24, 4, 3 },
+        { "f32_to_s32", &cvt_kernels_t::f32_to_s32, 4, 4 },
+        { "f32_to_f64", &cvt_kernels_t::f32_to_f64, 4, 8 },
+        { "xs16_to_f32", &cvt_kernels_t::xs16_to_f32, 2, 4 },
+        { "xs24_to_f32", &cvt_kernels_t::xs24_to_f32, 3, 4 },
+        { "xs32_to_f32", &cvt_kernels_t::xs32_to_f32, 4, 4 },
+        { "f32_to_xs16", &cvt_kernels_t::f32_to_xs16, 4, 2 },
+        { "f32_to_xs24", &cvt_kernels_t::f32_to_xs24, 4, 3 },
+        { "f32_to_xs32", &cvt_kernels_t::f32_to_xs32, 4, 4 },
+        { "swap_f32",   &cvt_kernels_t::swap_f32,   4, 4 }
+    };
+
+    typedef struct quant_kernel_t
+    {
+        const char             *name;
+        cvt_quant_t cvt_kernels_t::*func;
+        size_t                  dsize;
+    } quant_kernel_t;
+
+    static const quant_kernel_t quant_kernels[] =
+    {
+        { "f32_to_u8_round",  &cvt_kernels_t::f32_to_u8_round,  1 },
+        { "f32_to_s16_round", &cvt_kernels_t::f32_to_s16_round, 2 },
+        { "f32_to_s24_round", &cvt_kernels_t::f32_to_s24_round, 3 },
+        { "f32_to_s32_round", &cvt_kernels_t::f32_to_s32_round, 4 }
+    };
+}
+
+PTEST_BEGIN("runtime.mm", sample, 5, 1)
+
+    void convert(cvt_sample_t func, void *dst, const void *src)
+    {
+        for (size_t i=0; i<ITERATIONS; ++i)
+            func(dst, src, SAMPLES);
+    }
+
+    void quantize(cvt_quant_t func, void *dst, const void *src, cvt_dither_t *dither)
+    {
+        for (size_t i=0; i<ITERATIONS; ++i)
+            func(dst, src, SAMPLES, dither);
+    }
+
+    void deinterleave(cvt_deinterleave_t func, f32_t * const *dst, const void *src)
+    {
+        for (size_t i=0; i<ITERATIONS; ++i)
+            func(dst, 0, src, 2, SAMPLES / 2);
+    }
+
+    void interleave(cvt_interleave_t func, void *dst, const f32_t * const *src)
+    {
+        for (size_t i=0; i<ITERATIONS; ++i)
+            func(dst, src, 0, 2, SAMPLES / 2);
+    }
+
+    void dot(cvt_dot_t func, const f32_t *a, const f32_t *b)
+    {
+        for (size_t i=0; i<ITERATIONS; ++i)
+            func(a, b, SAMPLES);
+    }
+
+    PTEST_MAIN
+    {
+        const cvt_kernels_t *sets[MAX_SETS];
+        size_t n_sets   = cvt_supported_kernels(sets, MAX_SETS);
+        char key[0x40];
+
+        uint8_t *src    = static_cast<uint8_t *>(malloc(SAMPLES * 8));
+        uint8_t *dst    = static_cast<uint8_t *>(malloc(SAMPLES * 8));
+        if ((src == NULL) || (dst == NULL))
+        {
+            free(src);
+            free(dst);
+            PTEST_FAIL_MSG("Could not allocate buffers");
+        }
+
+        for (size_t i=0, n=sizeof(kernels)/sizeof(kernel_t); i<n; ++i)
+        {
+            const kernel_t *k = &kernels[i];
+
+            // Fill source buffer with valid sample values
+            if (k->ssize == sizeof(f32_t))
+            {
+                f32_t *s = reinterpret_cast<f32_t *>(src);
+                for (size_t j=0; j<SAMPLES; ++j)
+                    s[j]    = f32_t(rand()) / RAND_MAX * 2.0f - 1.0f;
+            }
+            else if (k->ssize == sizeof(f64_t))
+            {
+                f64_t *s = reinterpret_cast<f64_t *>(src);
+                for (size_t j=0; j<SAMPLES; ++j)
+                    s[j]    = f64_t(rand()) / RAND_MAX * 2.0 - 1.0;
+            }
+            else
+            {
+                for (size_t j=0, m=SAMPLES * k->ssize; j<m; ++j)
+                    src[j]  = uint8_t(rand());
+            }
+
+            // Amount of data passed through the routine per one iteration, in megabytes
+            double mb   = double(SAMPLES * (k->ssize + k->dsize) * ITERATIONS) / (1024.0 * 1024.0);
+            printf("Converting %s: %.2f MB per iteration...\n", k->name, mb);
+
+            for (size_t j=0; j<n_sets; ++j)
+            {
+                cvt_sample_t func = sets[j]->*(k->func);
+                snprintf(key, sizeof(key), "%s::%s", sets[j]->name, k->name);
+
+                PTEST_LOOP(key,
+                    convert(func, dst, src);
+                );
+            }
+
+            PTEST_SEPARATOR;
+        }
+
+        // Quantizing routines
+        f32_t *fsrc     = reinterpret_cast<f32_t *>(src);
+        for (size_t j=0; j<SAMPLES; ++j)
+            fsrc[j]     = f32_t(rand()) / RAND_MAX * 2.0f - 1.0f;
+
+        cvt_dither_t dither;
+        cvt_init_dither(&dither, 0);
+
+        for (size_t i=0, n=sizeof(quant_kernels)/sizeof(quant_kernel_t); i<n; ++i)
+        {
+            const quant_kernel_t *k = &quant_kernels[i];
+
+            double mb   = double(SAMPLES * (sizeof(f32_t) + k->dsize) * ITERATIONS) / (1024.0 * 1024.0);
+            printf("Converting %s: %.2f MB per iteration...\n", k->name, mb);
+
+            for (size_t j=0; j<n_sets; ++j)
+            {
+                cvt_quant_t func = sets[j]->*(k->func);
+
+                snprintf(key, sizeof(key), "%s::%s", sets[j]->name, k->name);
+                PTEST_LOOP(key,
+                    quantize(func, dst, src, NULL);
+                );
+
+                snprintf(key, sizeof(key), "%s::%s_dither", sets[j]->name, k->name);
+                PTEST_LOOP(key,
+                    quantize(func, dst, src, &dither);
+                );
+            }
+
+            PTEST_SEPARATOR;
+        }
+
+        // Stereo (de)interleaving routines
+        f32_t *vdst[2]  = { reinterpret_cast<f32_t *>(dst), reinterpret_cast<f32_t *>(&dst[SAMPLES * 2 + 0x100]) };
+        const f32_t *vsrc[2] = { fsrc, &fsrc[SAMPLES / 2] };
+
+        printf("Converting stereo s16 to planar f32...\n");
+        for (size_t j=0; j<n_sets; ++j)
+        {
+            snprintf(key, sizeof(key), "%s::s16_to_f32_planar", sets[j]->name);
+            PTEST_LOOP(key,
+                deinterleave(sets[j]->s16_to_f32_planar, vdst, src);
+            );
+        }
+        PTEST_SEPARATOR;
+
+        printf("Converting stereo f32 to planar f32...\n");
+        for (size_t j=0; j<n_sets; ++j)
+        {
+            snprintf(key, sizeof(key), "%s::f32_to_f32_planar", sets[j]->name);
+            PTEST_LOOP(key,
+                deinterleave(sets[j]->f32_to_f32_planar, vdst, src);
+            );
+        }
+        PTEST_SEPARATOR;
+
+        printf("Converting planar f32 to stereo s16...\n");
+        for (size_t j=0; j<n_sets; ++j)
+        {
+            snprintf(key, sizeof(key), "%s::f32_planar_to_s16", sets[j]->name);
+            PTEST_LOOP(key,
+                interleave(sets[j]->f32_planar_to_s16, dst, vsrc);
+            );
+        }
+        PTEST_SEPARATOR;
+
+        printf("Converting planar f32 to stereo f32...\n");
+        for (size_t j=0; j<n_sets; ++j)
+        {
+            snprintf(key, sizeof(key), "%s::f32_planar_to_f32", sets[j]->name);
+            PTEST_LOOP(key,
+                interleave(sets[j]->f32_planar_to_f32, dst, vsrc);
+            );
+        }
+        PTEST_SEPARATOR;
+
+        printf("Computing scalar product of f32 vectors...\n");
+        for (size_t j=0; j<n_sets; ++j)
+        {
+            snprintf(key, sizeof(key), "%s::dot_f32", sets[j]->name);
+            PTEST_LOOP(key,
+                dot(sets[j]->dot_f32, fsrc, reinterpret_cast<f32_t *>(dst));
+            );
+        }
+        PTEST_SEPARATOR;
+
+        free(src);
+        free(dst);
+    }
+
+PTEST_END
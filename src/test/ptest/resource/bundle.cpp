@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 3 апр. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <lsp-plug.in/test-fw/ptest.h>
+#include <lsp-plug.in/io/Dir.h>
+#include <lsp-plug.in/io/InFileStream.h>
+#include <lsp-plug.in/io/InMemoryStream.h>
+#include <lsp-plug.in/io/OutMemoryStream.h>
+#include <lsp-plug.in/io/Path.h>
+#include <lsp-plug.in/lltl/darray.h>
+#include <lsp-plug.in/lltl/parray.h>
+#include <lsp-plug.in/resource/Compressor.h>
+
+#define BUFFER_SIZE     0x100000
+
+using namespace lsp;
+
+namespace
+{
+    typedef struct config_t
+    {
+        size_t      block_size;
+        size_t      threads;
+    } config_t;
+
+    static const config_t configs[] =
+    {
+        { 0,            1 },
+        { 0x100000,     1 },
+        { 0x100000,     0 },
+        { 0x40000,      1 },
+        { 0x40000,      2 },
+        { 0x40000,      4 },
+        { 0x40000,      0 },
+        { 0x10000,      1 },
+        { 0x10000,      0 },
+    };
+}
+
+PTEST_BEGIN("runtime.resource", bundle, 5, 1)
+
+    void load_files(io::OutMemoryStream *os, lltl::parray<LSPString> *names, lltl::darray<size_t> *sizes,
+        const io::Path *base, const io::Path *path)
+    {
+        io::Dir dir;
+        LSPString str;
+        io::Path child, relative;
+        io::fattr_t fattr;
+
+        if (dir.open(path) != STATUS_OK)
+            return;
+        while (dir.reads(&str, &fattr, false) == STATUS_OK)
+        {
+            if (io::Path::is_dots(&str))
+                continue;
+            if (child.set(path, &str) != STATUS_OK)
+                continue;
+
+            if (fattr.type == io::fattr_t::FT_REGULAR)
+            {
+                if ((relative.set(&child) != STATUS_OK) || (relative.remove_base(base) != STATUS_OK))
+                    continue;
+
+                io::InFileStream ifs;
+                if (ifs.open(&child) != STATUS_OK)
+                    continue;
+                wssize_t size   = ifs.sink(os);
+                ifs.close();
+
+                LSPString *name = relative.as_string()->clone();
+                if (name == NULL)
+                    continue;
+                if ((size < 0) || (!names->add(name)) || (!sizes->add(size_t(size))))
+                {
+                    delete name;
+                    continue;
+                }
+            }
+            else if (fattr.type == io::fattr_t::FT_DIRECTORY)
+                load_files(os, names, sizes, base, &child);
+        }
+        dir.close();
+    }
+
+    size_t build_bundle(io::OutMemoryStream *os, const uint8_t *data,
+        lltl::parray<LSPString> *names, lltl::darray<size_t> *sizes, const config_t *cfg)
+    {
+        resource::Compressor c;
+
+        os->clear();
+        c.init(BUFFER_SIZE, os);
+        c.set_block_size(cfg->block_size);
+        c.set_threads(cfg->threads);
+
+        for (size_t i=0, n=names->size(); i<n; ++i)
+        {
+            size_t size     = *sizes->uget(i);
+            io::InMemoryStream is(data, size);
+            c.create_file(names->uget(i), &is);
+            data           += size;
+        }
+
+        c.flush();
+        c.close();
+
+        return os->size();
+    }
+
+    PTEST_MAIN
+    {
+        io::Path path;
+        io::OutMemoryStream src, dst;
+        lltl::parray<LSPString> names;
+        lltl::darray<size_t> sizes;
+        char key[0x40];
+
+        if (path.set(resources()) != STATUS_OK)
+            PTEST_FAIL_MSG("Could not set path");
+        load_files(&src, &names, &sizes, &path, &path);
+
+        const uint8_t *data = src.data();
+        size_t size         = src.size();
+        if (size <= 0)
+            PTEST_FAIL_MSG("No source data at %s", path.as_native());
+        printf("Source data: %d files, %d bytes\n", int(names.size()), int(size));
+
+        for (size_t i=0, n=sizeof(configs)/sizeof(configs[0]); i<n; ++i)
+        {
+            const config_t *cfg = &configs[i];
+            size_t csize        = build_bundle(&dst, data, &names, &sizes, cfg);
+            printf("Block size %d, threads %d: compressed size %d bytes, ratio %.2f\n",
+                int(cfg->block_size), int(cfg->threads), int(csize), double(size) / double(csize));
+
+            snprintf(key, sizeof(key), "bundle::block_%x_threads_%d", int(cfg->block_size), int(cfg->threads));
+            PTEST_LOOP(key,
+                build_bundle(&dst, data, &names, &sizes, cfg);
+            );
+        }
+
+        PTEST_SEPARATOR;
+
+        for (size_t i=0, n=names.size(); i<n; ++i)
+            delete names.uget(i);
+        names.flush();
+    }
+
+PTEST_END
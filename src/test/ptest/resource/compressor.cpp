@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 3 апр. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <lsp-plug.in/test-fw/ptest.h>
+#include <lsp-plug.in/common/alloc.h>
+#include <lsp-plug.in/io/Dir.h>
+#include <lsp-plug.in/io/InFileStream.h>
+#include <lsp-plug.in/io/InMemoryStream.h>
+#include <lsp-plug.in/io/OutMemoryStream.h>
+#include <lsp-plug.in/io/Path.h>
+#include <lsp-plug.in/resource/buffer.h>
+#include <lsp-plug.in/resource/Compressor.h>
+#include <lsp-plug.in/stdlib/string.h>
+
+#define BUFFER_SIZE     0x10000
+
+using namespace lsp;
+
+namespace
+{
+    // The exhaustive search over the whole window, used as the reference
+    size_t legacy_lookup(ssize_t *out, const uint8_t *p, size_t n, const uint8_t *s, size_t avail)
+    {
+        ssize_t offset  = -1;
+        size_t len      = 0;
+
+        for (size_t i=0; i<(n - len); ++i)
+        {
+            if (p[i] != *s)
+                continue;
+
+            size_t count    = lsp_min(avail, n - i);
+            size_t slen     = 1;
+            while ((slen < count) && (p[i + slen] == s[slen]))
+                ++slen;
+            if (len < slen)
+            {
+                offset          = i;
+                len             = slen;
+            }
+        }
+
+        *out            = offset;
+        return len;
+    }
+
+    static const size_t depths[] = { 0, 256, 64, 16, 4 };
+}
+
+PTEST_BEGIN("runtime.resource", compressor, 5, 1)
+
+    void load_files(io::OutMemoryStream *os, const io::Path *path)
+    {
+        io::Dir dir;
+        LSPString str;
+        io::Path child;
+        io::fattr_t fattr;
+
+        if (dir.open(path) != STATUS_OK)
+            return;
+        while (dir.reads(&str, &fattr, false) == STATUS_OK)
+        {
+            if (io::Path::is_dots(&str))
+                continue;
+            if (child.set(path, &str) != STATUS_OK)
+                continue;
+
+            if (fattr.type == io::fattr_t::FT_REGULAR)
+            {
+                io::InFileStream ifs;
+                if (ifs.open(&child) == STATUS_OK)
+                {
+                    ifs.sink(os);
+                    ifs.close();
+                }
+            }
+            else if (fattr.type == io::fattr_t::FT_DIRECTORY)
+                load_files(os, &child);
+        }
+        dir.close();
+    }
+
+    size_t match_legacy(const uint8_t *data, size_t size, ssize_t *offsets, size_t *lengths)
+    {
+        size_t n = 0;
+        for (size_t pos=0; pos < size; ++n)
+        {
+            size_t w        = lsp_min(pos, size_t(BUFFER_SIZE));
+            lengths[n]      = legacy_lookup(&offsets[n], &data[pos - w], w, &data[pos], size - pos);
+            pos            += lsp_max(lengths[n], size_t(1));
+        }
+        return n;
+    }
+
+    size_t match_chains(resource::cbuffer_t *cb, const uint8_t *data, size_t size, ssize_t *offsets, size_t *lengths)
+    {
+        size_t n = 0;
+        cb->clear();
+        for (size_t pos=0; pos < size; ++n)
+        {
+            lengths[n]      = cb->lookup(&offsets[n], &data[pos], size - pos);
+            size_t count    = lsp_max(lengths[n], size_t(1));
+            cb->append(&data[pos], count);
+            pos            += count;
+        }
+        return n;
+    }
+
+    size_t compress(io::OutMemoryStream *os, const uint8_t *data, size_t size, size_t depth)
+    {
+        resource::Compressor c;
+        io::InMemoryStream is(data, size);
+
+        os->clear();
+        c.init(BUFFER_SIZE, os);
+        c.set_chain_depth(depth);
+        c.create_file("data.bin", &is);
+        c.flush();
+        c.close();
+
+        return os->size();
+    }
+
+    PTEST_MAIN
+    {
+        io::Path path;
+        io::OutMemoryStream src, dst, ref;
+        char key[0x40];
+
+        if (path.fmt("%s/compressor", resources()) <= 0)
+            PTEST_FAIL_MSG("Could not format path");
+        load_files(&src, &path);
+
+        const uint8_t *data = src.data();
+        size_t size         = src.size();
+        if (size <= 0)
+            PTEST_FAIL_MSG("No source data at %s", path.as_native());
+        printf("Source data size: %d bytes\n", int(size));
+
+        // Compare the matches with the exhaustive search
+        ssize_t *offsets1   = static_cast<ssize_t *>(malloc(size * sizeof(ssize_t)));
+        ssize_t *offsets2   = static_cast<ssize_t *>(malloc(size * sizeof(ssize_t)));
+        size_t *lengths1    = static_cast<size_t *>(malloc(size * sizeof(size_t)));
+        size_t *lengths2    = static_cast<size_t *>(malloc(size * sizeof(size_t)));
+        resource::cbuffer_t cb;
+        if ((offsets1 == NULL) || (offsets2 == NULL) || (lengths1 == NULL) || (lengths2 == NULL) ||
+            (cb.init(BUFFER_SIZE) != STATUS_OK))
+        {
+            free(offsets1);
+            free(offsets2);
+            free(lengths1);
+            free(lengths2);
+            PTEST_FAIL_MSG("Could not allocate buffers");
+        }
+
+        size_t n1 = 0, n2 = 0;
+        PTEST_LOOP("lookup::exhaustive",
+            n1 = match_legacy(data, size, offsets1, lengths1);
+        );
+        PTEST_LOOP("lookup::hash_chains",
+            n2 = match_chains(&cb, data, size, offsets2, lengths2);
+        );
+
+        bool exact  = (n1 == n2);
+        for (size_t i=0; (exact) && (i<n1); ++i)
+            exact       = (offsets1[i] == offsets2[i]) && (lengths1[i] == lengths2[i]);
+
+        cb.destroy();
+        free(offsets1);
+        free(offsets2);
+        free(lengths1);
+        free(lengths2);
+        if (!exact)
+            PTEST_FAIL_MSG("Hash chains produce the matches different from the exhaustive search");
+        printf("Matches of hash chains are equal to the exhaustive search: %d matches\n", int(n1));
+
+        PTEST_SEPARATOR;
+
+        // Measure the compression time for different chain depths
+        size_t ref_size     = compress(&ref, data, size, 0);
+        for (size_t i=0, n=sizeof(depths)/sizeof(depths[0]); i<n; ++i)
+        {
+            size_t depth        = depths[i];
+            size_t csize        = compress(&dst, data, size, depth);
+            printf("Chain depth %d: compressed size %d bytes, ratio %.2f, same as unlimited depth: %s\n",
+                int(depth), int(csize), double(size) / double(csize),
+                ((csize == ref_size) && (memcmp(dst.data(), ref.data(), csize) == 0)) ? "yes" : "no");
+
+            snprintf(key, sizeof(key), "compress::depth_%d", int(depth));
+            PTEST_LOOP(key,
+                compress(&dst, data, size, depth);
+            );
+        }
+
+        PTEST_SEPARATOR;
+    }
+
+PTEST_END
@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 3 апр. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <lsp-plug.in/test-fw/ptest.h>
+#include <lsp-plug.in/common/alloc.h>
+#include <lsp-plug.in/io/Dir.h>
+#include <lsp-plug.in/io/InBitStream.h>
+#include <lsp-plug.in/io/InFileStream.h>
+#include <lsp-plug.in/io/InMemoryStream.h>
+#include <lsp-plug.in/io/OutMemoryStream.h>
+#include <lsp-plug.in/io/Path.h>
+#include <lsp-plug.in/resource/buffer.h>
+#include <lsp-plug.in/resource/Compressor.h>
+#include <lsp-plug.in/resource/Decompressor.h>
+#include <lsp-plug.in/stdlib/string.h>
+
+#define BUFFER_SIZE     0x10000
+#define CHUNK_SIZE      0x1000
+
+using namespace lsp;
+
+namespace
+{
+    // The decoder that reads each code with InBitStream::read_uint() and passes
+    // all data through the replay buffer, used as the reference
+    ssize_t legacy_decompress(uint8_t *dst, size_t count, const uint8_t *data, size_t size,
+        resource::dbuffer_t *buf, uint8_t *replay)
+    {
+        io::InBitStream is;
+        if (is.wrap(data, size) != STATUS_OK)
+            return -STATUS_UNKNOWN_ERR;
+        buf->clear();
+
+        size_t nread = 0;
+        while (nread < count)
+        {
+            size_t offset, length, rep, append;
+            uint8_t b;
+
+            if (is.read_uint(&offset, 5, 5) != STATUS_OK)
+                break;
+
+            if (offset < buf->size())
+            {
+                if ((is.read_uint(&length, 5, 5) != STATUS_OK) ||
+                    (is.read_uint(&rep, 0, 4) != STATUS_OK))
+                    break;
+
+                length     += 1;
+                memcpy(replay, &buf->data[buf->head + offset], length);
+                b           = replay[length - 1];
+                append      = lsp_min(rep, size_t(4));
+                buf->append(replay, length);
+            }
+            else
+            {
+                if (is.read_uint(&rep, 0, 4) != STATUS_OK)
+                    break;
+
+                b           = offset - buf->size();
+                replay[0]   = b;
+                length      = 1;
+                append      = lsp_min(rep, size_t(4)) + 1;
+            }
+
+            while (append--)
+                buf->append(b);
+
+            length      = lsp_min(length, count - nread);
+            memcpy(&dst[nread], replay, length);
+            nread      += length;
+            rep         = lsp_min(rep, count - nread);
+            for (size_t i=0; i<rep; ++i)
+                dst[nread++] = b;
+        }
+
+        is.close();
+        return nread;
+    }
+}
+
+PTEST_BEGIN("runtime.resource", decompressor, 5, 1)
+
+    void load_files(io::OutMemoryStream *os, const io::Path *path)
+    {
+        io::Dir dir;
+        LSPString str;
+        io::Path child;
+        io::fattr_t fattr;
+
+        if (dir.open(path) != STATUS_OK)
+            return;
+        while (dir.reads(&str, &fattr, false) == STATUS_OK)
+        {
+            if (io::Path::is_dots(&str))
+                continue;
+            if (child.set(path, &str) != STATUS_OK)
+                continue;
+
+            if (fattr.type == io::fattr_t::FT_REGULAR)
+            {
+                io::InFileStream ifs;
+                if (ifs.open(&child) == STATUS_OK)
+                {
+                    ifs.sink(os);
+                    ifs.close();
+                }
+            }
+            else if (fattr.type == io::fattr_t::FT_DIRECTORY)
+                load_files(os, &child);
+        }
+        dir.close();
+    }
+
+    ssize_t decompress_bytes(uint8_t *dst, size_t count, const uint8_t *data, size_t size)
+    {
+        resource::Decompressor d;
+        if (d.init(data, size, count, BUFFER_SIZE) != STATUS_OK)
+            return -STATUS_UNKNOWN_ERR;
+
+        size_t nread = 0;
+        for ( ; nread < count; ++nread)
+        {
+            ssize_t b = d.read_byte();
+            if (b < 0)
+                break;
+            dst[nread]  = b;
+        }
+
+        d.close();
+        return nread;
+    }
+
+    ssize_t decompress_chunks(uint8_t *dst, size_t count, const uint8_t *data, size_t size, size_t chunk)
+    {
+        resource::Decompressor d;
+        if (d.init(data, size, count, BUFFER_SIZE) != STATUS_OK)
+            return -STATUS_UNKNOWN_ERR;
+
+        size_t nread = 0;
+        while (nread < count)
+        {
+            ssize_t n = d.read(&dst[nread], lsp_min(chunk, count - nread));
+            if (n <= 0)
+                break;
+            nread      += n;
+        }
+
+        d.close();
+        return nread;
+    }
+
+    PTEST_MAIN
+    {
+        io::Path path;
+        io::OutMemoryStream src, dst;
+        resource::Compressor c;
+        resource::dbuffer_t buf;
+
+        if (path.set(resources()) != STATUS_OK)
+            PTEST_FAIL_MSG("Could not set path");
+        load_files(&src, &path);
+
+        size_t size         = src.size();
+        if (size <= 0)
+            PTEST_FAIL_MSG("No source data at %s", path.as_native());
+
+        // Compress all data as a single entry
+        io::InMemoryStream is(src.data(), size);
+        if ((c.init(BUFFER_SIZE, &dst) != STATUS_OK) ||
+            (c.create_file("data.bin", &is) != wssize_t(size)) ||
+            (c.flush() != STATUS_OK))
+            PTEST_FAIL_MSG("Could not compress data");
+        c.close();
+
+        const uint8_t *data = dst.data();
+        size_t csize        = dst.size();
+        double mb           = double(size) / (1024.0 * 1024.0);
+        printf("Decompressing: %d -> %d bytes, %.2f MB per iteration...\n", int(csize), int(size), mb);
+
+        uint8_t *out        = static_cast<uint8_t *>(malloc(size));
+        uint8_t *replay     = static_cast<uint8_t *>(malloc(BUFFER_SIZE));
+        bool valid          = (out != NULL) && (replay != NULL) && (buf.init(BUFFER_SIZE) == STATUS_OK);
+
+        // Verify the decoders
+        if (valid)
+        {
+            bzero(out, size);
+            valid               = (legacy_decompress(out, size, data, csize, &buf, replay) == ssize_t(size)) &&
+                                  (memcmp(out, src.data(), size) == 0);
+        }
+        if (valid)
+        {
+            bzero(out, size);
+            valid               = (decompress_bytes(out, size, data, csize) == ssize_t(size)) &&
+                                  (memcmp(out, src.data(), size) == 0);
+        }
+        if (valid)
+        {
+            bzero(out, size);
+            valid               = (decompress_chunks(out, size, data, csize, CHUNK_SIZE) == ssize_t(size)) &&
+                                  (memcmp(out, src.data(), size) == 0);
+        }
+        if (valid)
+        {
+            bzero(out, size);
+            valid               = (decompress_chunks(out, size, data, csize, size) == ssize_t(size)) &&
+                                  (memcmp(out, src.data(), size) == 0);
+        }
+
+        if (valid)
+        {
+            PTEST_LOOP("decompress::legacy",
+                legacy_decompress(out, size, data, csize, &buf, replay);
+            );
+            PTEST_LOOP("decompress::read_byte",
+                decompress_bytes(out, size, data, csize);
+            );
+            PTEST_LOOP("decompress::read_chunks",
+                decompress_chunks(out, size, data, csize, CHUNK_SIZE);
+            );
+            PTEST_LOOP("decompress::read_bulk",
+                decompress_chunks(out, size, data, csize, size);
+            );
+
+            PTEST_SEPARATOR;
+        }
+
+        buf.destroy();
+        free(out);
+        free(replay);
+
+        if (!valid)
+            PTEST_FAIL_MSG("Decompressed data does not match the source data");
+    }
+
+PTEST_END
@@ -0,0 +1,253 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 4 апр. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <lsp-plug.in/test-fw/ptest.h>
+#include <lsp-plug.in/io/Path.h>
+#include <lsp-plug.in/lltl/darray.h>
+#include <lsp-plug.in/lltl/parray.h>
+#include <lsp-plug.in/resource/BuiltinLoader.h>
+
+#define NAME_SIZE       0x20
+
+using namespace lsp;
+
+namespace
+{
+    typedef struct config_t
+    {
+        size_t      dirs;
+        size_t      files;
+    } config_t;
+
+    static const config_t configs[] =
+    {
+        { 4,        16  },
+        { 16,       64  },
+        { 64,       64  },
+        { 256,      64  },
+    };
+
+    class TestLoader: public resource::BuiltinLoader
+    {
+        public:
+            status_t lookup(ssize_t *out, const io::Path *path)
+            {
+                return find_entry(out, path);
+            }
+    };
+
+    // The lookup that scans the catalog for each component of the path, used as the reference
+    status_t legacy_lookup(ssize_t *out, const resource::raw_resource_t *catalog, size_t count, const io::Path *path)
+    {
+        status_t res;
+        ssize_t index = -1;
+        LSPString item;
+        io::Path tmp;
+
+        if ((res = tmp.set(path)) != STATUS_OK)
+            return res;
+
+        while (true)
+        {
+            if ((res = tmp.pop_first(&item)) != STATUS_OK)
+                return res;
+
+            const resource::raw_resource_t *found = NULL;
+            for (size_t i=0; i<count; ++i)
+            {
+                const resource::raw_resource_t *ent = &catalog[i];
+                if ((ent->parent != index) || (ent->name == NULL))
+                    continue;
+                if (item.equals_utf8(ent->name))
+                {
+                    found       = ent;
+                    index       = i;
+                    break;
+                }
+            }
+
+            if (found == NULL)
+                return STATUS_NOT_FOUND;
+            if (tmp.is_empty())
+            {
+                *out        = index;
+                return STATUS_OK;
+            }
+            else if (found->type != resource::RES_DIR)
+                return STATUS_NOT_FOUND;
+        }
+    }
+}
+
+PTEST_BEGIN("runtime.resource", loader, 5, 1)
+
+    bool build_catalog(lltl::darray<resource::raw_resource_t> *catalog, char *names,
+        lltl::parray<io::Path> *paths, const config_t *cfg)
+    {
+        for (size_t i=0; i<cfg->dirs; ++i)
+        {
+            ssize_t parent  = catalog->size();
+            resource::raw_resource_t *ent = catalog->add();
+            if (ent == NULL)
+                return false;
+
+            snprintf(names, NAME_SIZE, "dir%03d", int(i));
+            ent->type       = resource::RES_DIR;
+            ent->name       = names;
+            ent->parent     = -1;
+            ent->segment    = -1;
+            ent->offset     = -1;
+            ent->length     = 0;
+            names          += NAME_SIZE;
+
+            for (size_t j=0; j<cfg->files; ++j)
+            {
+                if ((ent = catalog->add()) == NULL)
+                    return false;
+
+                snprintf(names, NAME_SIZE, "file%04d.svg", int(j));
+                ent->type       = resource::RES_FILE;
+                ent->name       = names;
+                ent->parent     = parent;
+                ent->segment    = 0;
+                ent->offset     = 0;
+                ent->length     = 0;
+
+                io::Path *path  = new io::Path();
+                if ((path == NULL) || (!paths->add(path)))
+                {
+                    delete path;
+                    return false;
+                }
+                if (path->fmt("dir%03d" FILE_SEPARATOR_S "%s", int(i), names) <= 0)
+                    return false;
+                names          += NAME_SIZE;
+            }
+        }
+
+        return true;
+    }
+
+    size_t legacy_resolve(const lltl::darray<resource::raw_resource_t> *catalog, lltl::parray<io::Path> *paths)
+    {
+        size_t found = 0;
+        ssize_t index;
+        for (size_t i=0, n=paths->size(); i<n; ++i)
+        {
+            if (legacy_lookup(&index, catalog->array(), catalog->size(), paths->uget(i)) == STATUS_OK)
+                ++found;
+        }
+        return found;
+    }
+
+    size_t resolve(TestLoader *load, lltl::parray<io::Path> *paths)
+    {
+        size_t found = 0;
+        ssize_t index;
+        for (size_t i=0, n=paths->size(); i<n; ++i)
+        {
+            if (load->lookup(&index, paths->uget(i)) == STATUS_OK)
+                ++found;
+        }
+        return found;
+    }
+
+    size_t enumerate(TestLoader *load, size_t dirs)
+    {
+        size_t found = 0;
+        io::Path path;
+        for (size_t i=0; i<dirs; ++i)
+        {
+            resource::resource_t *list = NULL;
+            if (path.fmt("dir%03d", int(i)) <= 0)
+                continue;
+            ssize_t count   = load->enumerate(&path, &list);
+            if (count > 0)
+                found          += count;
+            if (list != NULL)
+                free(list);
+        }
+        return found;
+    }
+
+    PTEST_MAIN
+    {
+        char key[0x40];
+
+        for (size_t i=0, n=sizeof(configs)/sizeof(configs[0]); i<n; ++i)
+        {
+            const config_t *cfg = &configs[i];
+            size_t entries      = cfg->dirs * (cfg->files + 1);
+            lltl::darray<resource::raw_resource_t> catalog;
+            lltl::parray<io::Path> paths;
+            TestLoader load;
+
+            char *names         = static_cast<char *>(malloc(entries * NAME_SIZE));
+            bool valid          = (names != NULL) && (build_catalog(&catalog, names, &paths, cfg));
+            if (valid)
+                valid               = load.init(NULL, 0, catalog.array(), catalog.size(), 0) == STATUS_OK;
+            if (valid)
+                valid               =
+                    (legacy_resolve(&catalog, &paths) == paths.size()) &&
+                    (resolve(&load, &paths) == paths.size()) &&
+                    (enumerate(&load, cfg->dirs) == paths.size());
+
+            if (valid)
+            {
+                printf("Catalog: %d entries, %d paths\n", int(catalog.size()), int(paths.size()));
+
+                snprintf(key, sizeof(key), "legacy::resolve_%d", int(entries));
+                PTEST_LOOP(key,
+                    legacy_resolve(&catalog, &paths);
+                );
+
+                snprintf(key, sizeof(key), "index::init_%d", int(entries));
+                PTEST_LOOP(key,
+                    load.init(NULL, 0, catalog.array(), catalog.size(), 0);
+                );
+
+                snprintf(key, sizeof(key), "index::resolve_%d", int(entries));
+                PTEST_LOOP(key,
+                    resolve(&load, &paths);
+                );
+
+                snprintf(key, sizeof(key), "index::enumerate_%d", int(entries));
+                PTEST_LOOP(key,
+                    enumerate(&load, cfg->dirs);
+                );
+
+                PTEST_SEPARATOR;
+            }
+
+            for (size_t j=0, m=paths.size(); j<m; ++j)
+                delete paths.uget(j);
+            paths.flush();
+            if (names != NULL)
+                free(names);
+
+            if (!valid)
+                PTEST_FAIL_MSG("Could not resolve entries of the catalog");
+        }
+    }
+
+PTEST_END
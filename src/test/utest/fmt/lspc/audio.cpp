@@ -249,6 +249,21 @@ UTEST_BEGIN("runtime.fmt.lspc", audio)
         // Drop buffers
         drop_buffers(src);
         drop_buffers(dst);
+
+        // Single-channel streams in CPU byte order are transferred without conversion
+        add_buffer(src, cvalues[1]);
+        add_buffer(dst, INVALID_VALUE);
+
+        for (size_t i=0, n = sizeof(formats) / sizeof(size_t); i<n; ++i)
+        {
+            printf("Testing LSPC mono audio creation sample_format=%d\n", int(formats[i]));
+            create_lspc_file(src, formats[i]);
+            parse_lspc_file(dst, formats[i]);
+            validate_contents(src, dst);
+        }
+
+        drop_buffers(src);
+        drop_buffers(dst);
     }
 
 UTEST_END
@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 3 апр. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/common/endian.h>
+#include <lsp-plug.in/test-fw/utest.h>
+#include <lsp-plug.in/fmt/lspc/File.h>
+#include <lsp-plug.in/fmt/lspc/lspc.h>
+#include <lsp-plug.in/io/InFileStream.h>
+#include <lsp-plug.in/stdlib/string.h>
+
+#define CHUNKS          5
+#define FRAGMENTS       40
+#define MAGIC_A         0x41414141
+#define MAGIC_B         0x42424242
+
+UTEST_BEGIN("runtime.fmt.lspc", index)
+
+    static inline uint8_t pattern(size_t chunk, size_t offset)
+    {
+        return uint8_t((chunk + 1) * 37 + offset * 13 + (offset >> 8));
+    }
+
+    static inline size_t fragment_size(size_t chunk, size_t fragment)
+    {
+        return 0x10 + ((chunk * 131 + fragment * 71) % 0x300);
+    }
+
+    static inline uint32_t chunk_magic(size_t chunk)
+    {
+        return (chunk & 1) ? MAGIC_B : MAGIC_A;
+    }
+
+    /**
+     * Write chunks with interleaved fragments, the last chunk is left open
+     * if it should be completed after the file is closed
+     */
+    void write_file(const io::Path *path, bool emit_index, bool append, size_t *sizes, uint32_t *uids)
+    {
+        lspc::File fd;
+        lspc::ChunkWriter *wr[CHUNKS];
+        uint8_t buf[0x400];
+
+        printf("Writing file %s ...\n", path->as_native());
+        UTEST_ASSERT(fd.create(path) == STATUS_OK);
+        fd.set_emit_index(emit_index);
+        UTEST_ASSERT(fd.emit_index() == emit_index);
+
+        for (size_t i=0; i<CHUNKS; ++i)
+        {
+            wr[i]       = fd.write_chunk(chunk_magic(i));
+            UTEST_ASSERT(wr[i] != NULL);
+            uids[i]     = wr[i]->unique_id();
+            sizes[i]    = 0;
+        }
+
+        // Write fragments of chunks in turn
+        for (size_t j=0; j<FRAGMENTS; ++j)
+            for (size_t i=0; i<CHUNKS; ++i)
+            {
+                // Some chunks start later than others
+                if ((j < i * 2) || ((append) && (i == CHUNKS-1) && (j >= FRAGMENTS/2)))
+                    continue;
+
+                size_t n    = fragment_size(i, j);
+                for (size_t k=0; k<n; ++k)
+                    buf[k]      = pattern(i, sizes[i] + k);
+                UTEST_ASSERT(wr[i]->write(buf, n) == STATUS_OK);
+                UTEST_ASSERT(wr[i]->flush() == STATUS_OK);
+                sizes[i]   += n;
+            }
+
+        for (size_t i=0; i<CHUNKS-1; ++i)
+        {
+            UTEST_ASSERT(wr[i]->close() == STATUS_OK);
+            delete wr[i];
+        }
+        if (!append)
+        {
+            UTEST_ASSERT(wr[CHUNKS-1]->close() == STATUS_OK);
+            delete wr[CHUNKS-1];
+        }
+
+        UTEST_ASSERT(fd.close() == STATUS_OK);
+
+        // Write data after the index chunk
+        if (append)
+        {
+            size_t i = CHUNKS-1;
+            for (size_t j=FRAGMENTS/2; j<FRAGMENTS; ++j)
+            {
+                size_t n    = fragment_size(i, j);
+                for (size_t k=0; k<n; ++k)
+                    buf[k]      = pattern(i, sizes[i] + k);
+                UTEST_ASSERT(wr[i]->write(buf, n) == STATUS_OK);
+                UTEST_ASSERT(wr[i]->flush() == STATUS_OK);
+                sizes[i]   += n;
+            }
+            UTEST_ASSERT(wr[i]->close() == STATUS_OK);
+            delete wr[i];
+        }
+    }
+
+    bool has_index(const io::Path *path)
+    {
+        io::InFileStream is;
+        lspc::chunk_index_footer_t ftr;
+
+        UTEST_ASSERT(is.open(path) == STATUS_OK);
+        wssize_t size = is.avail();
+        UTEST_ASSERT(size > wssize_t(sizeof(ftr)));
+        UTEST_ASSERT(is.seek(size - sizeof(ftr)) == wssize_t(size - sizeof(ftr)));
+        UTEST_ASSERT(is.read_fully(&ftr, sizeof(ftr)) == ssize_t(sizeof(ftr)));
+        UTEST_ASSERT(is.close() == STATUS_OK);
+
+        return BE_TO_CPU(ftr.magic) == LSPC_CHUNK_INDEX;
+    }
+
+    void check_chunk(lspc::ChunkReader *rd, size_t chunk, size_t size)
+    {
+        uint8_t buf[0x1000];
+        size_t offset = 0;
+
+        // Skip some data at the start
+        UTEST_ASSERT(rd->skip(0x123) == 0x123);
+        offset     += 0x123;
+
+        while (true)
+        {
+            ssize_t n = rd->read(buf, sizeof(buf));
+            if (n <= 0)
+                break;
+            for (ssize_t k=0; k<n; ++k)
+                UTEST_ASSERT_MSG(buf[k] == pattern(chunk, offset + k),
+                    "Invalid data for chunk %d at offset %d", int(chunk), int(offset + k));
+            offset     += n;
+        }
+
+        UTEST_ASSERT_MSG(offset == size, "Read %d bytes of %d bytes for chunk %d", int(offset), int(size), int(chunk));
+        UTEST_ASSERT(rd->last_error() == STATUS_EOF);
+    }
+
+    void read_file(const io::Path *path, const size_t *sizes, const uint32_t *uids)
+    {
+        lspc::File fd;
+        lspc::ChunkReader *rd;
+
+        printf("Reading file %s ...\n", path->as_native());
+        UTEST_ASSERT(fd.open(path) == STATUS_OK);
+
+        // Read chunks in the reverse order
+        for (ssize_t i=CHUNKS-1; i>=0; --i)
+        {
+            rd = fd.read_chunk(uids[i]);
+            UTEST_ASSERT(rd != NULL);
+            UTEST_ASSERT(rd->unique_id() == uids[i]);
+            UTEST_ASSERT(rd->magic() == chunk_magic(i));
+            check_chunk(rd, i, sizes[i]);
+            UTEST_ASSERT(rd->close() == STATUS_OK);
+            delete rd;
+
+            rd = fd.read_chunk(uids[i], chunk_magic(i + 1));
+            UTEST_ASSERT(rd == NULL);
+            rd = fd.read_chunk(uids[i], chunk_magic(i));
+            UTEST_ASSERT(rd != NULL);
+            check_chunk(rd, i, sizes[i]);
+            UTEST_ASSERT(rd->close() == STATUS_OK);
+            delete rd;
+        }
+
+        // Non-existing chunks
+        UTEST_ASSERT(fd.read_chunk(0) == NULL);
+        UTEST_ASSERT(fd.read_chunk(uids[CHUNKS-1] + 10) == NULL);
+        UTEST_ASSERT(fd.find_chunk(LSPC_CHUNK_INDEX) == NULL);
+
+        // Find chunks in the order of appearance
+        uint32_t id = 0;
+        for (size_t i=0; i<CHUNKS; i += 2)
+        {
+            rd = fd.find_chunk(MAGIC_A, &id, id + 1);
+            UTEST_ASSERT(rd != NULL);
+            UTEST_ASSERT(id == uids[i]);
+            check_chunk(rd, i, sizes[i]);
+            UTEST_ASSERT(rd->close() == STATUS_OK);
+            delete rd;
+        }
+        UTEST_ASSERT(fd.find_chunk(MAGIC_A, &id, id + 1) == NULL);
+
+        rd = fd.find_chunk(MAGIC_B, &id);
+        UTEST_ASSERT(rd != NULL);
+        UTEST_ASSERT(id == uids[1]);
+        delete rd;
+
+        // The reader remains valid after the file is closed
+        rd = fd.read_chunk(uids[3]);
+        UTEST_ASSERT(rd != NULL);
+        UTEST_ASSERT(fd.close() == STATUS_OK);
+        check_chunk(rd, 3, sizes[3]);
+        UTEST_ASSERT(rd->close() == STATUS_OK);
+        delete rd;
+    }
+
+    UTEST_MAIN
+    {
+        size_t sizes[CHUNKS];
+        uint32_t uids[CHUNKS];
+        io::Path path;
+
+        printf("Testing file without index\n");
+        UTEST_ASSERT(path.fmt("%s/utest-%s-noindex.lspc", tempdir(), full_name()));
+        write_file(&path, false, false, sizes, uids);
+        UTEST_ASSERT(!has_index(&path));
+        read_file(&path, sizes, uids);
+
+        printf("Testing file with index\n");
+        UTEST_ASSERT(path.fmt("%s/utest-%s-index.lspc", tempdir(), full_name()));
+        write_file(&path, true, false, sizes, uids);
+        UTEST_ASSERT(has_index(&path));
+        read_file(&path, sizes, uids);
+
+        printf("Testing file with outdated index\n");
+        UTEST_ASSERT(path.fmt("%s/utest-%s-outdated.lspc", tempdir(), full_name()));
+        write_file(&path, true, true, sizes, uids);
+        UTEST_ASSERT(!has_index(&path));
+        read_file(&path, sizes, uids);
+    }
+
+UTEST_END
@@ -0,0 +1,236 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 3 апр. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <lsp-plug.in/test-fw/utest.h>
+#include <lsp-plug.in/fmt/lspc/AudioReader.h>
+#include <lsp-plug.in/fmt/lspc/AudioWriter.h>
+#include <lsp-plug.in/fmt/lspc/File.h>
+#include <lsp-plug.in/stdlib/math.h>
+#include <lsp-plug.in/stdlib/string.h>
+
+#define CHANNELS        3
+#define FRAMES          (LSPC_LOSSLESS_BLOCK_FRAMES * 5 + 1234)
+#define BLOCK           0x3ff
+#define SEEKS           200
+
+using namespace lsp;
+
+static const size_t formats[] =
+{
+    LSPC_SAMPLE_FMT_U8LE,
+    LSPC_SAMPLE_FMT_S8BE,
+    LSPC_SAMPLE_FMT_U16BE,
+    LSPC_SAMPLE_FMT_S16LE,
+    LSPC_SAMPLE_FMT_U24LE,
+    LSPC_SAMPLE_FMT_U24BE,
+    LSPC_SAMPLE_FMT_S24LE,
+    LSPC_SAMPLE_FMT_S24BE,
+    LSPC_SAMPLE_FMT_U32LE,
+    LSPC_SAMPLE_FMT_S32BE,
+    LSPC_SAMPLE_FMT_F32LE,
+    LSPC_SAMPLE_FMT_F32BE
+};
+
+UTEST_BEGIN("runtime.fmt.lspc", lossless)
+
+    UTEST_TIMELIMIT(300)
+
+    static inline size_t next_random(size_t *seed)
+    {
+        *seed           = *seed * 1103515245 + 12345;
+        return (*seed >> 8) & 0xffffff;
+    }
+
+    void make_signal(float *dst)
+    {
+        size_t seed     = 1;
+        for (size_t i=0; i<FRAMES; ++i)
+            for (size_t j=0; j<CHANNELS; ++j)
+            {
+                float noise     = (float(next_random(&seed) & 0xffff) / 0x10000 - 0.5f) * 1e-3f;
+                dst[i*CHANNELS + j] =
+                    0.5f * sinf(i * 0.01f * (j + 1)) +
+                    0.2f * sinf(i * 0.0713f + j) + noise;
+            }
+    }
+
+    wsize_t write_file(const io::Path *path, const float *data, size_t format, size_t codec, uint32_t *uid)
+    {
+        lspc::File fd;
+        lspc::AudioWriter wr;
+        lspc::audio_parameters_t params;
+
+        params.channels         = CHANNELS;
+        params.sample_format    = format;
+        params.sample_rate      = 48000;
+        params.codec            = codec;
+        params.frames           = FRAMES;
+
+        UTEST_ASSERT(fd.create(path) == STATUS_OK);
+        UTEST_ASSERT(wr.open(&fd, &params) == STATUS_OK);
+        *uid            = wr.unique_id();
+
+        // Write data with different block sizes
+        size_t seed     = format + 1;
+        for (size_t off=0; off < FRAMES; )
+        {
+            size_t count    = lsp_min(next_random(&seed) % BLOCK + 1, size_t(FRAMES - off));
+            UTEST_ASSERT(wr.write_frames(&data[off * CHANNELS], count) == STATUS_OK);
+            off            += count;
+        }
+
+        UTEST_ASSERT(wr.close() == STATUS_OK);
+        UTEST_ASSERT(fd.close() == STATUS_OK);
+
+        io::fattr_t attr;
+        UTEST_ASSERT(path->stat(&attr) == STATUS_OK);
+        return attr.size;
+    }
+
+    void read_file(const io::Path *path, float *dst, uint32_t uid, size_t codec)
+    {
+        lspc::File fd;
+        lspc::AudioReader rd;
+        lspc::audio_parameters_t params;
+
+        UTEST_ASSERT(fd.open(path) == STATUS_OK);
+        UTEST_ASSERT(rd.open(&fd, uid) == STATUS_OK);
+        UTEST_ASSERT(rd.get_parameters(&params) == STATUS_OK);
+        UTEST_ASSERT(params.codec == codec);
+        UTEST_ASSERT(params.frames == FRAMES);
+
+        size_t off      = 0;
+        while (true)
+        {
+            ssize_t n       = rd.read_frames(&dst[off * CHANNELS], lsp_min(size_t(BLOCK), size_t(FRAMES + 1 - off)));
+            if (n <= 0)
+                break;
+            off            += n;
+        }
+        UTEST_ASSERT_MSG(off == FRAMES, "Read %d frames instead of %d", int(off), int(FRAMES));
+
+        UTEST_ASSERT(rd.close() == STATUS_OK);
+        UTEST_ASSERT(fd.close() == STATUS_OK);
+    }
+
+    void check_seek(const io::Path *path, const float *ref, uint32_t uid)
+    {
+        lspc::File fd;
+        lspc::AudioReader rd;
+        float buf[BLOCK * CHANNELS];
+        size_t seed     = 7;
+
+        UTEST_ASSERT(fd.open(path) == STATUS_OK);
+        UTEST_ASSERT(rd.open(&fd, uid) == STATUS_OK);
+
+        // Seek to the end of the stream first to check that unknown blocks are discovered
+        UTEST_ASSERT(rd.seek(FRAMES) == STATUS_OK);
+        UTEST_ASSERT(rd.position() == FRAMES);
+        UTEST_ASSERT(rd.read_frames(buf, BLOCK) <= 0);
+        UTEST_ASSERT(rd.seek(FRAMES + 1) != STATUS_OK);
+
+        for (size_t i=0; i<SEEKS; ++i)
+        {
+            size_t offset   = next_random(&seed) % FRAMES;
+            UTEST_ASSERT_MSG(rd.seek(offset) == STATUS_OK, "Failed to seek to frame %d", int(offset));
+            UTEST_ASSERT(rd.position() == wssize_t(offset));
+
+            size_t count    = next_random(&seed) % BLOCK + 1;
+            size_t avail    = lsp_min(count, size_t(FRAMES - offset));
+            ssize_t n       = rd.read_frames(buf, count);
+            UTEST_ASSERT_MSG(n == ssize_t(avail), "Read %d frames instead of %d at frame %d", int(n), int(avail), int(offset));
+            UTEST_ASSERT_MSG(memcmp(buf, &ref[offset * CHANNELS], n * CHANNELS * sizeof(float)) == 0,
+                "Data mismatch at frame %d", int(offset));
+            UTEST_ASSERT(rd.position() == wssize_t(offset + n));
+        }
+
+        UTEST_ASSERT(rd.close() == STATUS_OK);
+        UTEST_ASSERT(fd.close() == STATUS_OK);
+    }
+
+    void check_format(const float *src, float *pcm, float *lossless, size_t format)
+    {
+        io::Path pcm_path, ll_path;
+        uint32_t pcm_uid, ll_uid;
+
+        UTEST_ASSERT(pcm_path.fmt("%s/utest-%s-%d-pcm.lspc", tempdir(), full_name(), int(format)));
+        UTEST_ASSERT(ll_path.fmt("%s/utest-%s-%d-lossless.lspc", tempdir(), full_name(), int(format)));
+
+        wsize_t pcm_size    = write_file(&pcm_path, src, format, LSPC_CODEC_PCM, &pcm_uid);
+        wsize_t ll_size     = write_file(&ll_path, src, format, LSPC_CODEC_LOSSLESS, &ll_uid);
+        printf("Sample format 0x%02x: PCM size: %d, lossless size: %d (%.1f%%)\n",
+            int(format), int(pcm_size), int(ll_size), float(ll_size * 100.0f) / pcm_size);
+
+        // The lossless codec should produce exactly the same samples as PCM
+        read_file(&pcm_path, pcm, pcm_uid, LSPC_CODEC_PCM);
+        read_file(&ll_path, lossless, ll_uid, LSPC_CODEC_LOSSLESS);
+        for (size_t i=0; i<FRAMES * CHANNELS; ++i)
+            UTEST_ASSERT_MSG(memcmp(&pcm[i], &lossless[i], sizeof(float)) == 0,
+                "Sample mismatch at index %d: %g vs %g", int(i), pcm[i], lossless[i]);
+
+        // Integer samples of the smooth signal should be compressed
+        if ((format != LSPC_SAMPLE_FMT_F32LE) && (format != LSPC_SAMPLE_FMT_F32BE))
+        {
+            UTEST_ASSERT_MSG(ll_size < pcm_size, "Data has not been compressed");
+        }
+        else
+        {
+            UTEST_ASSERT(ll_size <= pcm_size + (FRAMES / LSPC_LOSSLESS_BLOCK_FRAMES + 1) * 0x10);
+        }
+
+        check_seek(&ll_path, pcm, ll_uid);
+    }
+
+    UTEST_MAIN
+    {
+        float *src      = new float[FRAMES * CHANNELS];
+        float *pcm      = new float[FRAMES * CHANNELS];
+        float *lossless = new float[FRAMES * CHANNELS];
+        UTEST_ASSERT((src != NULL) && (pcm != NULL) && (lossless != NULL));
+
+        make_signal(src);
+        for (size_t i=0; i<sizeof(formats)/sizeof(size_t); ++i)
+            check_format(src, pcm, lossless, formats[i]);
+
+        // 64-bit samples are not supported by the lossless codec
+        lspc::File fd;
+        lspc::AudioWriter wr;
+        lspc::audio_parameters_t params;
+        io::Path path;
+
+        params.channels         = CHANNELS;
+        params.sample_format    = LSPC_SAMPLE_FMT_F64LE;
+        params.sample_rate      = 48000;
+        params.codec            = LSPC_CODEC_LOSSLESS;
+        params.frames           = FRAMES;
+
+        UTEST_ASSERT(path.fmt("%s/utest-%s-f64.lspc", tempdir(), full_name()));
+        UTEST_ASSERT(fd.create(&path) == STATUS_OK);
+        UTEST_ASSERT(wr.open(&fd, &params) == STATUS_UNSUPPORTED_FORMAT);
+        UTEST_ASSERT(fd.close() == STATUS_OK);
+
+        delete [] src;
+        delete [] pcm;
+        delete [] lossless;
+    }
+
+UTEST_END
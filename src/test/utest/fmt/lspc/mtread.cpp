@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 3 апр. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/test-fw/utest.h>
+#include <lsp-plug.in/fmt/lspc/AudioReader.h>
+#include <lsp-plug.in/fmt/lspc/AudioWriter.h>
+#include <lsp-plug.in/fmt/lspc/File.h>
+#include <lsp-plug.in/ipc/Thread.h>
+
+#define CHUNKS          4
+#define THREADS         8
+#define FRAMES          200003
+#define BLOCK           0x1000
+
+using namespace lsp;
+
+UTEST_BEGIN("runtime.fmt.lspc", mtread)
+
+    static inline float sample(size_t chunk, size_t frame)
+    {
+        return float((((frame + chunk * 977) * 2654435761U) >> 8) & 0xffff);
+    }
+
+    status_t read_chunk(lspc::File *fd, size_t chunk, uint32_t uid, size_t seed)
+    {
+        lspc::AudioReader rd;
+        float buf[BLOCK];
+
+        UTEST_ASSERT(rd.open(fd, uid) == STATUS_OK);
+
+        lspc::audio_parameters_t params;
+        UTEST_ASSERT(rd.get_parameters(&params) == STATUS_OK);
+        UTEST_ASSERT(params.channels == 1);
+        UTEST_ASSERT(params.frames == FRAMES);
+
+        // Read frames with different block sizes, skip some frames
+        size_t offset   = 0;
+        while (offset < FRAMES)
+        {
+            seed            = seed * 1103515245 + 12345;
+            size_t count    = ((seed >> 16) % BLOCK) + 1;
+
+            if (((seed >> 8) & 0x7) == 0)
+            {
+                ssize_t n       = rd.skip_frames(count);
+                UTEST_ASSERT(n > 0);
+                offset         += n;
+                continue;
+            }
+
+            ssize_t n       = rd.read_frames(buf, count);
+            UTEST_ASSERT_MSG(n > 0, "Read error %d for chunk %d at frame %d", int(n), int(chunk), int(offset));
+            for (ssize_t i=0; i<n; ++i)
+                UTEST_ASSERT_MSG(buf[i] == sample(chunk, offset + i),
+                    "Invalid sample of chunk %d at frame %d", int(chunk), int(offset + i));
+            offset         += n;
+        }
+
+        UTEST_ASSERT(offset == FRAMES);
+        UTEST_ASSERT(rd.read_frames(buf, BLOCK) <= 0);
+        UTEST_ASSERT(rd.close() == STATUS_OK);
+
+        return STATUS_OK;
+    }
+
+    class TestThread: public ipc::Thread
+    {
+        private:
+            test_type_t    *test;
+            lspc::File     *fd;
+            size_t          chunk;
+            uint32_t        uid;
+            size_t          seed;
+
+        public:
+            explicit TestThread() { test = NULL; fd = NULL; chunk = 0; uid = 0; seed = 0; }
+            virtual ~TestThread() {}
+
+            void bind(test_type_t *test, lspc::File *fd, size_t chunk, uint32_t uid, size_t seed)
+            {
+                this->test  = test;
+                this->fd    = fd;
+                this->chunk = chunk;
+                this->uid   = uid;
+                this->seed  = seed;
+            }
+
+            virtual status_t run()
+            {
+                // Each thread reads the chunk several times
+                for (size_t i=0; i<3; ++i)
+                {
+                    status_t res = test->read_chunk(fd, chunk, uid, seed + i);
+                    if (res != STATUS_OK)
+                        return res;
+                }
+                return STATUS_OK;
+            }
+    };
+
+    void write_file(const io::Path *path, uint32_t *uids)
+    {
+        lspc::File fd;
+        lspc::AudioWriter wr[CHUNKS];
+        float buf[BLOCK];
+
+        printf("Writing file %s ...\n", path->as_native());
+        UTEST_ASSERT(fd.create(path) == STATUS_OK);
+
+        lspc::audio_parameters_t params;
+        params.channels         = 1;
+        params.sample_format    = LSPC_SAMPLE_FMT_F32BE;
+        params.sample_rate      = 48000;
+        params.codec            = LSPC_CODEC_PCM;
+        params.frames           = FRAMES;
+
+        for (size_t i=0; i<CHUNKS; ++i)
+        {
+            UTEST_ASSERT(wr[i].open(&fd, &params) == STATUS_OK);
+            uids[i]     = wr[i].unique_id();
+        }
+
+        // Interleave the fragments of chunks
+        for (size_t offset=0; offset < FRAMES; offset += BLOCK)
+        {
+            size_t count    = lsp_min(size_t(FRAMES - offset), size_t(BLOCK));
+            for (size_t i=0; i<CHUNKS; ++i)
+            {
+                for (size_t j=0; j<count; ++j)
+                    buf[j]      = sample(i, offset + j);
+                UTEST_ASSERT(wr[i].write_frames(buf, count) == STATUS_OK);
+            }
+        }
+
+        for (size_t i=0; i<CHUNKS; ++i)
+            UTEST_ASSERT(wr[i].close() == STATUS_OK);
+        UTEST_ASSERT(fd.close() == STATUS_OK);
+    }
+
+    UTEST_MAIN
+    {
+        uint32_t uids[CHUNKS];
+        io::Path path;
+        lspc::File fd;
+        TestThread t[THREADS];
+
+        UTEST_ASSERT(path.fmt("%s/utest-%s.lspc", tempdir(), full_name()));
+        write_file(&path, uids);
+
+        printf("Reading file %s from %d threads...\n", path.as_native(), int(THREADS));
+        UTEST_ASSERT(fd.open(&path) == STATUS_OK);
+        for (size_t i=0; i<THREADS; ++i)
+        {
+            t[i].bind(this, &fd, i % CHUNKS, uids[i % CHUNKS], i * 7919);
+            UTEST_ASSERT(t[i].start() == STATUS_OK);
+        }
+
+        for (size_t i=0; i<THREADS; ++i)
+            t[i].join();
+
+        for (size_t i=0; i<THREADS; ++i)
+            UTEST_ASSERT_MSG(t[i].get_result() == STATUS_OK, "Thread %d failed with code %d", int(i), int(t[i].get_result()));
+
+        UTEST_ASSERT(fd.close() == STATUS_OK);
+    }
+
+UTEST_END
@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 3 апр. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <lsp-plug.in/test-fw/utest.h>
+#include <lsp-plug.in/fmt/lspc/AudioReader.h>
+#include <lsp-plug.in/fmt/lspc/AudioWriter.h>
+#include <lsp-plug.in/fmt/lspc/File.h>
+#include <lsp-plug.in/ipc/Thread.h>
+
+#define THREADS         8
+#define FRAMES          100003
+#define BYTES           400009
+#define BLOCK           0x1000
+#define RAW_MAGIC       0x52415754
+
+using namespace lsp;
+
+UTEST_BEGIN("runtime.fmt.lspc", mtwrite)
+
+    static inline float sample(size_t chunk, size_t frame)
+    {
+        return float((((frame + chunk * 977) * 2654435761U) >> 8) & 0xffff);
+    }
+
+    static inline uint8_t byte(size_t chunk, size_t offset)
+    {
+        return uint8_t(((offset + chunk * 7919) * 2654435761U) >> 16);
+    }
+
+    status_t write_audio(lspc::File *fd, size_t chunk, uint32_t *uid, size_t seed)
+    {
+        lspc::AudioWriter wr;
+        float buf[BLOCK];
+
+        lspc::audio_parameters_t params;
+        params.channels         = 1;
+        params.sample_format    = (chunk & 2) ? LSPC_SAMPLE_FMT_F32BE : LSPC_SAMPLE_FMT_F32LE;
+        params.sample_rate      = 48000;
+        params.codec            = LSPC_CODEC_PCM;
+        params.frames           = FRAMES;
+
+        UTEST_ASSERT(wr.open(fd, &params) == STATUS_OK);
+        *uid            = wr.unique_id();
+
+        // Write frames with different block sizes
+        size_t offset   = 0;
+        while (offset < FRAMES)
+        {
+            seed            = seed * 1103515245 + 12345;
+            size_t count    = lsp_min(((seed >> 16) % BLOCK) + 1, size_t(FRAMES - offset));
+            for (size_t i=0; i<count; ++i)
+                buf[i]          = sample(chunk, offset + i);
+            UTEST_ASSERT(wr.write_frames(buf, count) == STATUS_OK);
+            offset         += count;
+        }
+
+        UTEST_ASSERT(wr.close() == STATUS_OK);
+        return STATUS_OK;
+    }
+
+    status_t write_raw(lspc::File *fd, size_t chunk, uint32_t *uid, size_t seed)
+    {
+        uint8_t buf[BLOCK];
+
+        lspc::ChunkWriter *wr = fd->write_chunk(RAW_MAGIC);
+        UTEST_ASSERT(wr != NULL);
+        UTEST_ASSERT(wr->last_error() == STATUS_OK);
+        *uid            = wr->unique_id();
+
+        // Write data with different block sizes and flush some of them to produce small fragments
+        size_t offset   = 0;
+        while (offset < BYTES)
+        {
+            seed            = seed * 1103515245 + 12345;
+            size_t count    = lsp_min(((seed >> 16) % BLOCK) + 1, size_t(BYTES - offset));
+            for (size_t i=0; i<count; ++i)
+                buf[i]          = byte(chunk, offset + i);
+            UTEST_ASSERT(wr->write(buf, count) == STATUS_OK);
+            if (((seed >> 8) & 0x3) == 0)
+                UTEST_ASSERT(wr->flush() == STATUS_OK);
+            offset         += count;
+        }
+
+        UTEST_ASSERT(wr->close() == STATUS_OK);
+        delete wr;
+        return STATUS_OK;
+    }
+
+    class TestThread: public ipc::Thread
+    {
+        private:
+            test_type_t    *test;
+            lspc::File     *fd;
+            size_t          chunk;
+            uint32_t        uid;
+
+        public:
+            explicit TestThread() { test = NULL; fd = NULL; chunk = 0; uid = 0; }
+            virtual ~TestThread() {}
+
+            void bind(test_type_t *test, lspc::File *fd, size_t chunk)
+            {
+                this->test  = test;
+                this->fd    = fd;
+                this->chunk = chunk;
+                this->uid   = 0;
+            }
+
+            inline uint32_t unique_id() const { return uid; }
+
+            virtual status_t run()
+            {
+                // Each thread writes its own chunk
+                return (chunk & 1) ?
+                    test->write_raw(fd, chunk, &uid, chunk * 7919) :
+                    test->write_audio(fd, chunk, &uid, chunk * 7919);
+            }
+    };
+
+    void check_audio(lspc::File *fd, size_t chunk, uint32_t uid)
+    {
+        lspc::AudioReader rd;
+        float buf[BLOCK];
+
+        UTEST_ASSERT(rd.open(fd, uid) == STATUS_OK);
+
+        lspc::audio_parameters_t params;
+        UTEST_ASSERT(rd.get_parameters(&params) == STATUS_OK);
+        UTEST_ASSERT(params.channels == 1);
+        UTEST_ASSERT(params.frames == FRAMES);
+
+        size_t offset   = 0;
+        while (offset < FRAMES)
+        {
+            ssize_t n       = rd.read_frames(buf, BLOCK);
+            UTEST_ASSERT_MSG(n > 0, "Read error %d for chunk %d at frame %d", int(n), int(chunk), int(offset));
+            for (ssize_t i=0; i<n; ++i)
+                UTEST_ASSERT_MSG(buf[i] == sample(chunk, offset + i),
+                    "Invalid sample of chunk %d at frame %d", int(chunk), int(offset + i));
+            offset         += n;
+        }
+
+        UTEST_ASSERT(offset == FRAMES);
+        UTEST_ASSERT(rd.read_frames(buf, BLOCK) <= 0);
+        UTEST_ASSERT(rd.close() == STATUS_OK);
+    }
+
+    void check_raw(lspc::File *fd, size_t chunk, uint32_t uid)
+    {
+        uint8_t buf[BLOCK];
+
+        lspc::ChunkReader *rd = fd->read_chunk(uid, RAW_MAGIC);
+        UTEST_ASSERT(rd != NULL);
+
+        size_t offset   = 0;
+        while (offset < BYTES)
+        {
+            ssize_t n       = rd->read(buf, BLOCK);
+            UTEST_ASSERT_MSG(n > 0, "Read error %d for chunk %d at offset %d", int(n), int(chunk), int(offset));
+            for (ssize_t i=0; i<n; ++i)
+                UTEST_ASSERT_MSG(buf[i] == byte(chunk, offset + i),
+                    "Invalid byte of chunk %d at offset %d", int(chunk), int(offset + i));
+            offset         += n;
+        }
+
+        UTEST_ASSERT(offset == BYTES);
+        UTEST_ASSERT(rd->read(buf, BLOCK) <= 0);
+        UTEST_ASSERT(rd->close() == STATUS_OK);
+        delete rd;
+    }
+
+    void test_write(bool index)
+    {
+        io::Path path;
+        lspc::File fd;
+        TestThread t[THREADS];
+
+        UTEST_ASSERT(path.fmt("%s/utest-%s-%s.lspc", tempdir(), full_name(), (index) ? "index" : "scan"));
+        printf("Writing file %s from %d threads...\n", path.as_native(), int(THREADS));
+
+        UTEST_ASSERT(fd.create(&path) == STATUS_OK);
+        fd.set_emit_index(index);
+        for (size_t i=0; i<THREADS; ++i)
+        {
+            t[i].bind(this, &fd, i);
+            UTEST_ASSERT(t[i].start() == STATUS_OK);
+        }
+
+        for (size_t i=0; i<THREADS; ++i)
+            t[i].join();
+
+        for (size_t i=0; i<THREADS; ++i)
+            UTEST_ASSERT_MSG(t[i].get_result() == STATUS_OK, "Thread %d failed with code %d", int(i), int(t[i].get_result()));
+        UTEST_ASSERT(fd.close() == STATUS_OK);
+
+        // Check that all identifiers are unique
+        for (size_t i=0; i<THREADS; ++i)
+            for (size_t j=i+1; j<THREADS; ++j)
+                UTEST_ASSERT(t[i].unique_id() != t[j].unique_id());
+
+        printf("Verifying file %s ...\n", path.as_native());
+        UTEST_ASSERT(fd.open(&path) == STATUS_OK);
+        for (size_t i=0; i<THREADS; ++i)
+        {
+            if (i & 1)
+                check_raw(&fd, i, t[i].unique_id());
+            else
+                check_audio(&fd, i, t[i].unique_id());
+        }
+        UTEST_ASSERT(fd.close() == STATUS_OK);
+    }
+
+    UTEST_MAIN
+    {
+        test_write(true);
+        test_write(false);
+    }
+
+UTEST_END
@@ -0,0 +1,220 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 3 апр. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <lsp-plug.in/test-fw/utest.h>
+#include <lsp-plug.in/fmt/lspc/AudioReader.h>
+#include <lsp-plug.in/fmt/lspc/AudioWriter.h>
+#include <lsp-plug.in/fmt/lspc/File.h>
+
+#define CHUNKS          3
+#define CHANNELS        2
+#define FRAMES          100003
+#define BLOCK           0x800
+#define SEEKS           1000
+
+using namespace lsp;
+
+UTEST_BEGIN("runtime.fmt.lspc", seek)
+
+    static inline float sample(size_t chunk, size_t channel, size_t frame)
+    {
+        return float((((frame * CHANNELS + channel + chunk * 977) * 2654435761U) >> 8) & 0xffff);
+    }
+
+    static inline size_t next_random(size_t *seed)
+    {
+        *seed           = *seed * 1103515245 + 12345;
+        return (*seed >> 8) & 0xffffff;
+    }
+
+    void write_file(const io::Path *path, uint32_t *uids)
+    {
+        lspc::File fd;
+        lspc::AudioWriter wr[CHUNKS];
+        float buf[BLOCK * CHANNELS];
+        size_t offset[CHUNKS];
+        size_t seed     = 1;
+
+        printf("Writing file %s ...\n", path->as_native());
+        UTEST_ASSERT(fd.create(path) == STATUS_OK);
+
+        lspc::audio_parameters_t params;
+        params.channels         = CHANNELS;
+        params.sample_rate      = 48000;
+        params.codec            = LSPC_CODEC_PCM;
+        params.frames           = FRAMES;
+
+        for (size_t i=0; i<CHUNKS; ++i)
+        {
+            // Check both native and reversed byte order
+            params.sample_format    = (i & 1) ? LSPC_SAMPLE_FMT_F32BE : LSPC_SAMPLE_FMT_F32LE;
+            UTEST_ASSERT(wr[i].open(&fd, &params) == STATUS_OK);
+            uids[i]     = wr[i].unique_id();
+            offset[i]   = 0;
+        }
+
+        // Interleave the fragments of chunks, fragments have different sizes
+        bool done = false;
+        while (!done)
+        {
+            done = true;
+            for (size_t i=0; i<CHUNKS; ++i)
+            {
+                size_t count    = lsp_min(size_t(FRAMES - offset[i]), next_random(&seed) % BLOCK + 1);
+                if (count <= 0)
+                    continue;
+
+                for (size_t j=0; j<count; ++j)
+                    for (size_t k=0; k<CHANNELS; ++k)
+                        buf[j*CHANNELS + k] = sample(i, k, offset[i] + j);
+                UTEST_ASSERT(wr[i].write_frames(buf, count) == STATUS_OK);
+                offset[i]  += count;
+                done        = false;
+            }
+        }
+
+        for (size_t i=0; i<CHUNKS; ++i)
+            UTEST_ASSERT(wr[i].close() == STATUS_OK);
+        UTEST_ASSERT(fd.close() == STATUS_OK);
+    }
+
+    void check_frames(size_t chunk, const float *buf, size_t offset, size_t count)
+    {
+        for (size_t i=0; i<count; ++i)
+            for (size_t k=0; k<CHANNELS; ++k)
+                UTEST_ASSERT_MSG(buf[i*CHANNELS + k] == sample(chunk, k, offset + i),
+                    "Invalid sample of chunk %d channel %d at frame %d", int(chunk), int(k), int(offset + i));
+    }
+
+    void check_chunk(lspc::File *fd, size_t chunk, uint32_t uid)
+    {
+        lspc::AudioReader rd;
+        float buf[BLOCK * CHANNELS];
+        float c[CHANNELS][BLOCK];
+        float *vc[CHANNELS];
+        size_t seed     = chunk * 7919 + 1;
+
+        for (size_t k=0; k<CHANNELS; ++k)
+            vc[k]           = c[k];
+
+        printf("Seeking in chunk %d\n", int(chunk));
+        UTEST_ASSERT(rd.open(fd, uid) == STATUS_OK);
+        UTEST_ASSERT(rd.position() == 0);
+
+        size_t offset   = 0;
+        for (size_t i=0; i<SEEKS; ++i)
+        {
+            // Select the position: random, slightly backward or slightly forward
+            size_t mode     = next_random(&seed) & 0x3;
+            size_t delta    = next_random(&seed) % (BLOCK * 2);
+            if (mode == 0)
+                offset          = (offset > delta) ? offset - delta : 0;
+            else if (mode == 1)
+                offset          = lsp_min(size_t(offset + delta), size_t(FRAMES));
+            else
+                offset          = next_random(&seed) % (FRAMES + 1);
+
+            UTEST_ASSERT_MSG(rd.seek(offset) == STATUS_OK, "Failed to seek to frame %d", int(offset));
+            UTEST_ASSERT(rd.position() == wssize_t(offset));
+
+            // Read data and validate it
+            size_t count    = next_random(&seed) % BLOCK + 1;
+            size_t avail    = lsp_min(count, size_t(FRAMES - offset));
+            ssize_t n;
+            if (next_random(&seed) & 1)
+            {
+                n               = rd.read_frames(buf, count);
+                if (avail <= 0)
+                {
+                    UTEST_ASSERT(n <= 0);
+                    continue;
+                }
+                UTEST_ASSERT_MSG(n == ssize_t(avail), "Read %d frames instead of %d at frame %d", int(n), int(avail), int(offset));
+                check_frames(chunk, buf, offset, n);
+            }
+            else
+            {
+                n               = rd.read_samples(vc, count);
+                if (avail <= 0)
+                {
+                    UTEST_ASSERT(n <= 0);
+                    continue;
+                }
+                UTEST_ASSERT_MSG(n == ssize_t(avail), "Read %d samples instead of %d at frame %d", int(n), int(avail), int(offset));
+                for (ssize_t j=0; j<n; ++j)
+                    for (size_t k=0; k<CHANNELS; ++k)
+                        buf[j*CHANNELS + k] = c[k][j];
+                check_frames(chunk, buf, offset, n);
+            }
+
+            offset         += n;
+            UTEST_ASSERT(rd.position() == wssize_t(offset));
+        }
+
+        // Seek to the beginning and read the whole chunk
+        UTEST_ASSERT(rd.seek(0) == STATUS_OK);
+        for (offset = 0; offset < FRAMES; )
+        {
+            ssize_t n       = rd.read_frames(buf, BLOCK);
+            UTEST_ASSERT(n > 0);
+            check_frames(chunk, buf, offset, n);
+            offset         += n;
+        }
+        UTEST_ASSERT(rd.read_frames(buf, BLOCK) <= 0);
+
+        // Seek beyond the end of the stream
+        UTEST_ASSERT(rd.seek(FRAMES + 1) != STATUS_OK);
+        UTEST_ASSERT(rd.seek(FRAMES / 2) == STATUS_OK);
+        UTEST_ASSERT(rd.skip_frames(BLOCK) == BLOCK);
+        UTEST_ASSERT(rd.read_frames(buf, BLOCK) == BLOCK);
+        check_frames(chunk, buf, FRAMES / 2 + BLOCK, BLOCK);
+
+        // Failed seek should keep the position and the buffered data
+        UTEST_ASSERT(rd.seek(FRAMES / 4) == STATUS_OK);
+        UTEST_ASSERT(rd.read_frames(buf, 1) == 1);
+        check_frames(chunk, buf, FRAMES / 4, 1);
+        UTEST_ASSERT(rd.seek(FRAMES + 1) != STATUS_OK);
+        UTEST_ASSERT(rd.position() == FRAMES / 4 + 1);
+        UTEST_ASSERT(rd.read_frames(buf, BLOCK) == BLOCK);
+        check_frames(chunk, buf, FRAMES / 4 + 1, BLOCK);
+        UTEST_ASSERT(rd.position() == FRAMES / 4 + 1 + BLOCK);
+
+        UTEST_ASSERT(rd.close() == STATUS_OK);
+        UTEST_ASSERT(rd.seek(0) == STATUS_CLOSED);
+    }
+
+    UTEST_MAIN
+    {
+        uint32_t uids[CHUNKS];
+        io::Path path;
+        lspc::File fd;
+
+        UTEST_ASSERT(path.fmt("%s/utest-%s.lspc", tempdir(), full_name()));
+        write_file(&path, uids);
+
+        UTEST_ASSERT(fd.open(&path) == STATUS_OK);
+        for (size_t i=0; i<CHUNKS; ++i)
+            check_chunk(&fd, i, uids[i]);
+        UTEST_ASSERT(fd.close() == STATUS_OK);
+    }
+
+UTEST_END
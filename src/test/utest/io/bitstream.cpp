@@ -26,6 +26,8 @@
 #include <lsp-plug.in/io/OutMemoryStream.h>
 #include <lsp-plug.in/stdlib/string.h>
 
+#include <stdlib.h>
+
 using namespace lsp;
 
 namespace
@@ -37,6 +39,28 @@ namespace
         0xa8, 0xfd, 0xcf, 0xb2, 0xf1, 0xf1, 0xd0, 0x42,
         0xe5, 0x8d, 0x05, 0x88, 0xf7, 0x32, 0x79, 0xe8
     };
+
+    // The stream that writes at most 5 bytes per call and fails after the limit is reached
+    class FailingStream: public io::OutMemoryStream
+    {
+        public:
+            size_t      nLimit;
+
+        public:
+            explicit FailingStream()
+            {
+                nLimit      = 0;
+            }
+
+        public:
+            virtual ssize_t write(const void *buf, size_t count)
+            {
+                if (size() >= nLimit)
+                    return -STATUS_IO_ERROR;
+                count       = lsp_min(lsp_min(count, nLimit - size()), size_t(5));
+                return io::OutMemoryStream::write(buf, count);
+            }
+    };
 }
 
 UTEST_BEGIN("runtime.io", bitstream)
@@ -88,7 +112,19 @@ UTEST_BEGIN("runtime.io", bitstream)
     {
         io::InBitStream ibs;
         UTEST_ASSERT(ibs.wrap(is, WRAP_NONE) == STATUS_OK);
+        read_bits(ibs);
+    }
+
+    void test_read_block(const void *data, size_t size)
+    {
+        io::InBitStream ibs;
+        UTEST_ASSERT(ibs.wrap(data, size) == STATUS_OK);
+        UTEST_ASSERT(ibs.wrap(data, size) == STATUS_BAD_STATE);
+        read_bits(ibs);
+    }
 
+    void read_bits(io::InBitStream & ibs)
+    {
         union
         {
             bool        b;
@@ -158,6 +194,118 @@ UTEST_BEGIN("runtime.io", bitstream)
         UTEST_ASSERT(ibs.close() == STATUS_OK);
     }
 
+    void test_uint()
+    {
+        static const size_t count = 0x4000;
+        io::OutMemoryStream oms;
+        io::OutBitStream obs;
+        size_t *values = new size_t[count];
+        UTEST_ASSERT(values != NULL);
+
+        printf("Testing write_uint() and read_uint()...\n");
+
+        // Generate values of different magnitude
+        for (size_t i=0; i<count; ++i)
+        {
+            size_t v    = (size_t(rand()) << 16) ^ size_t(rand());
+            values[i]   = v >> (rand() % 32);
+        }
+
+        // Write values
+        UTEST_ASSERT(obs.wrap(&oms, WRAP_NONE) == STATUS_OK);
+        for (size_t i=0; i<count; ++i)
+        {
+            UTEST_ASSERT(obs.write_uint(values[i], 5, 5) == STATUS_OK);
+            UTEST_ASSERT(obs.write_uint(values[i] & 0x3ff, 0, 4) == STATUS_OK);
+            UTEST_ASSERT(obs.writev(uint32_t(i), 3) == STATUS_OK);
+        }
+        UTEST_ASSERT(obs.close() == STATUS_OK);
+
+        // Read values from the stream and from the memory block
+        for (size_t pass=0; pass<2; ++pass)
+        {
+            io::InMemoryStream ims(oms.data(), oms.size());
+            io::InBitStream ibs;
+            if (pass == 0)
+            {
+                UTEST_ASSERT(ibs.wrap(&ims, WRAP_NONE) == STATUS_OK);
+            }
+            else
+            {
+                UTEST_ASSERT(ibs.wrap(oms.data(), oms.size()) == STATUS_OK);
+            }
+
+            for (size_t i=0; i<count; ++i)
+            {
+                size_t v = 0;
+                uint8_t b = 0;
+                UTEST_ASSERT(ibs.read_uint(&v, 5, 5) == STATUS_OK);
+                UTEST_ASSERT_MSG(v == values[i], "pass=%d, index=%d: 0x%lx vs 0x%lx",
+                        int(pass), int(i), (unsigned long)v, (unsigned long)values[i]);
+                UTEST_ASSERT(ibs.read_uint(&v, 0, 4) == STATUS_OK);
+                UTEST_ASSERT(v == (values[i] & 0x3ff));
+                UTEST_ASSERT(ibs.readv(&b, 3) == 3);
+                UTEST_ASSERT(b == (i & 0x7));
+            }
+
+            UTEST_ASSERT(ibs.close() == STATUS_OK);
+        }
+
+        delete [] values;
+        oms.drop();
+    }
+
+    void test_failed_write()
+    {
+        static const size_t count = 0x2000;
+        FailingStream fs;
+        io::OutBitStream obs;
+        size_t failed = count;
+
+        printf("Testing write to the failing stream...\n");
+
+        // Write values until the stream fails
+        fs.nLimit       = 0x1803;
+        UTEST_ASSERT(obs.wrap(&fs, WRAP_NONE) == STATUS_OK);
+        for (size_t i=0; i<count; ++i)
+        {
+            if ((obs.writev(uint8_t(i), 3) != STATUS_OK) ||
+                (obs.writev(uint32_t(i * 0x9e3779b1), 32) != STATUS_OK))
+            {
+                failed          = i;
+                break;
+            }
+        }
+        UTEST_ASSERT(failed < count);
+
+        // All next writes should be refused even if the stream accepts data
+        fs.nLimit       = size_t(-1);
+        for (size_t i=0; i<0x1000; ++i)
+            UTEST_ASSERT(obs.writev(uint32_t(i), 32) == STATUS_IO_ERROR);
+        UTEST_ASSERT(obs.write(test_data, sizeof(test_data)) == -STATUS_IO_ERROR);
+        UTEST_ASSERT(obs.flush() == STATUS_IO_ERROR);
+        UTEST_ASSERT(obs.close() == STATUS_IO_ERROR);
+        UTEST_ASSERT(fs.size() == 0x1803);
+
+        // The written data should be valid
+        io::InBitStream ibs;
+        UTEST_ASSERT(ibs.wrap(fs.data(), fs.size()) == STATUS_OK);
+        for (size_t i=0; i<failed; ++i)
+        {
+            uint8_t b = 0;
+            uint32_t v = 0;
+            if (ibs.readv(&b, 3) != 3)
+                break;
+            UTEST_ASSERT(b == (i & 0x7));
+            if (ibs.readv(&v) != 32)
+                break;
+            UTEST_ASSERT_MSG(v == uint32_t(i * 0x9e3779b1), "index=%d", int(i));
+        }
+        UTEST_ASSERT(ibs.close() == STATUS_OK);
+
+        fs.drop();
+    }
+
     UTEST_MAIN
     {
         io::OutMemoryStream oms;
@@ -204,10 +352,14 @@ UTEST_BEGIN("runtime.io", bitstream)
 
         io::InMemoryStream ims(oms.data(), oms.size());
         test_read_bits(&ims);
+        test_read_block(oms.data(), oms.size());
 
 
         // Drop the array
         oms.drop();
+
+        test_uint();
+        test_failed_write();
     }
 
 UTEST_END
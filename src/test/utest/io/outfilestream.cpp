@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 27 мар. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/test-fw/utest.h>
+#include <lsp-plug.in/io/OutFileStream.h>
+#include <lsp-plug.in/io/InFileStream.h>
+#include <lsp-plug.in/stdlib/string.h>
+
+#include <stdlib.h>
+
+#define DATA_SIZE       0x54321
+
+using namespace lsp;
+
+UTEST_BEGIN("runtime.io", outfilestream)
+
+    void write_file(const io::Path *path, const uint8_t *data, size_t size, bool async)
+    {
+        io::OutFileStream os;
+
+        printf("Writing file %s in %s mode...\n", path->as_native(), (async) ? "async" : "sync");
+        UTEST_ASSERT(os.open(path, io::File::FM_WRITE_NEW) == STATUS_OK);
+        if (async)
+        {
+            UTEST_ASSERT(os.start_async(1, 0x1000) == STATUS_BAD_ARGUMENTS);
+            UTEST_ASSERT(os.start_async(4, 0x1000) == STATUS_OK);
+            UTEST_ASSERT(os.start_async(4, 0x1000) == STATUS_BAD_STATE);
+            UTEST_ASSERT(os.async());
+        }
+
+        // Write the data with blocks of different size
+        for (size_t off = 0; off < size; )
+        {
+            size_t n = lsp_min(size_t(rand() % 0x3000), size - off);
+            UTEST_ASSERT(os.write(&data[off], n) == ssize_t(n));
+            off    += n;
+            UTEST_ASSERT(os.position() == wssize_t(off));
+        }
+
+        // Overwrite some data
+        UTEST_ASSERT(os.seek(0x1234) == 0x1234);
+        UTEST_ASSERT(os.write(&data[0x4321], 0x2000) == 0x2000);
+        UTEST_ASSERT(os.seek(0x1234) == 0x1234);
+        UTEST_ASSERT(os.write(&data[0x1234], 0x2000) == 0x2000);
+        UTEST_ASSERT(os.position() == 0x3234);
+        UTEST_ASSERT(os.seek(size) == wssize_t(size));
+
+        UTEST_ASSERT(os.flush() == STATUS_OK);
+
+        if (async)
+        {
+            io::OutFileStream::latency_stats_t st;
+            UTEST_ASSERT(os.get_latency(&st) == STATUS_OK);
+
+            wsize_t calls = 0;
+            for (size_t i=0; i<io::OutFileStream::LATENCY_BUCKETS; ++i)
+                calls          += st.histogram[i];
+            UTEST_ASSERT(calls == st.calls);
+            UTEST_ASSERT(st.blocked == st.calls - st.histogram[0]);
+            printf("  calls: %d, blocked: %d, blocking time: %d us\n",
+                    int(st.calls), int(st.blocked), int(st.time));
+
+            // Write the tail in synchronous mode
+            UTEST_ASSERT(os.write(data, 0x100) == 0x100);
+            UTEST_ASSERT(os.stop_async() == STATUS_OK);
+            UTEST_ASSERT(!os.async());
+            UTEST_ASSERT(os.get_latency(&st) == STATUS_BAD_STATE);
+        }
+        else
+            UTEST_ASSERT(os.write(data, 0x100) == 0x100);
+
+        UTEST_ASSERT(os.write(&data[0x100], 0x100) == 0x100);
+        UTEST_ASSERT(os.position() == wssize_t(size + 0x200));
+        UTEST_ASSERT(os.close() == STATUS_OK);
+        os.write(data, 0x100);
+        UTEST_ASSERT(os.last_error() == STATUS_CLOSED);
+    }
+
+    void check_file(const io::Path *path, const uint8_t *data, size_t size)
+    {
+        io::InFileStream is;
+        uint8_t *buf = static_cast<uint8_t *>(malloc(size + 0x200));
+        UTEST_ASSERT(buf != NULL);
+
+        UTEST_ASSERT(is.open(path) == STATUS_OK);
+        UTEST_ASSERT(is.read_fully(buf, size + 0x200) == ssize_t(size + 0x200));
+        UTEST_ASSERT(is.read_byte() == -STATUS_EOF);
+        UTEST_ASSERT(is.close() == STATUS_OK);
+
+        UTEST_ASSERT(memcmp(buf, data, size) == 0);
+        UTEST_ASSERT(memcmp(&buf[size], data, 0x200) == 0);
+
+        free(buf);
+    }
+
+    UTEST_MAIN
+    {
+        uint8_t *data = static_cast<uint8_t *>(malloc(DATA_SIZE));
+        UTEST_ASSERT(data != NULL);
+        for (size_t i=0; i<DATA_SIZE; ++i)
+            data[i]     = uint8_t(rand());
+
+        io::Path path;
+        UTEST_ASSERT(path.fmt("%s/utest-%s.bin", tempdir(), full_name()) > 0);
+
+        write_file(&path, data, DATA_SIZE, false);
+        check_file(&path, data, DATA_SIZE);
+
+        write_file(&path, data, DATA_SIZE, true);
+        check_file(&path, data, DATA_SIZE);
+
+        free(data);
+    }
+
+UTEST_END
@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 26 мар. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/test-fw/utest.h>
+#include <lsp-plug.in/io/OutMemoryStream.h>
+#include <lsp-plug.in/stdlib/string.h>
+
+#include <stdlib.h>
+
+#define DATA_SIZE       0x12345
+
+using namespace lsp;
+
+UTEST_BEGIN("runtime.io", outmemorystream)
+
+    class FullStream: public io::OutMemoryStream
+    {
+        private:
+            size_t      nLimit;
+
+        public:
+            explicit FullStream(size_t limit): io::OutMemoryStream()
+            {
+                nLimit      = limit;
+            }
+
+        public:
+            virtual ssize_t write(const void *buf, size_t count)
+            {
+                count       = lsp_min(count, nLimit - size());
+                return (count > 0) ? io::OutMemoryStream::write(buf, count) : 0;
+            }
+    };
+
+    void test_full_sink(const uint8_t *data, size_t size)
+    {
+        io::OutMemoryStream os;
+        FullStream full(0x1234), empty(0);
+
+        printf("Testing sink to the full stream...\n");
+        UTEST_ASSERT(os.write(data, size) == ssize_t(size));
+        UTEST_ASSERT(os.sink(&full) == 0x1234);
+        UTEST_ASSERT(os.last_error() == STATUS_IO_ERROR);
+        UTEST_ASSERT(memcmp(full.data(), data, 0x1234) == 0);
+        UTEST_ASSERT(os.sink(&empty) == -STATUS_IO_ERROR);
+        UTEST_ASSERT(os.last_error() == STATUS_IO_ERROR);
+    }
+
+    void write_data(io::OutMemoryStream *os, const uint8_t *data, size_t size)
+    {
+        // Write the data with blocks of different size
+        for (size_t off = 0; off < size; )
+        {
+            size_t n = lsp_min(size_t(rand() % 0x300), size - off);
+            if (n <= 0)
+            {
+                UTEST_ASSERT(os->writeb(data[off]) == 1);
+                ++off;
+                continue;
+            }
+
+            UTEST_ASSERT(os->write(&data[off], n) == ssize_t(n));
+            off    += n;
+        }
+
+        UTEST_ASSERT(os->size() == size);
+    }
+
+    void test_stream(const uint8_t *data, size_t size, bool segmented)
+    {
+        io::OutMemoryStream os(0x1000, segmented), dst;
+        UTEST_ASSERT(os.segmented() == segmented);
+
+        printf("Testing %s stream...\n", (segmented) ? "segmented" : "contiguous");
+
+        // Empty writes to the stream without allocated data
+        UTEST_ASSERT(os.write(data, 0) == 0);
+        UTEST_ASSERT(os.size() == 0);
+        UTEST_ASSERT(os.segments() == 0);
+        UTEST_ASSERT(os.segment(0, NULL) == NULL);
+
+        write_data(&os, data, size);
+        if (segmented)
+            UTEST_ASSERT(os.segments() == (size + 0xfff) / 0x1000);
+
+        // Check segments
+        size_t off = 0;
+        for (size_t i=0, n=os.segments(); i<n; ++i)
+        {
+            size_t count = 0;
+            const uint8_t *ptr = os.segment(i, &count);
+            UTEST_ASSERT(ptr != NULL);
+            UTEST_ASSERT(memcmp(ptr, &data[off], count) == 0);
+            off    += count;
+        }
+        UTEST_ASSERT(off == size);
+        UTEST_ASSERT(os.segment(os.segments(), &off) == NULL);
+
+        // Overwrite the data at the segment boundary
+        UTEST_ASSERT(os.seek(0xffe) == 0xffe);
+        UTEST_ASSERT(os.write(&data[0x1ffe], 4) == 4);
+        UTEST_ASSERT(os.seek(0xffe) == 0xffe);
+        UTEST_ASSERT(os.write(&data[0xffe], 4) == 4);
+        UTEST_ASSERT(os.seek(size) == wssize_t(size));
+        UTEST_ASSERT(os.size() == size);
+
+        // Sink the data
+        UTEST_ASSERT(os.sink(&dst) == wssize_t(size));
+        UTEST_ASSERT(dst.size() == size);
+        UTEST_ASSERT(memcmp(dst.data(), data, size) == 0);
+
+        // Flatten the data and continue writing
+        const uint8_t *ptr = os.data();
+        UTEST_ASSERT(ptr != NULL);
+        UTEST_ASSERT(memcmp(ptr, data, size) == 0);
+        UTEST_ASSERT(os.segments() == 1);
+        UTEST_ASSERT(os.write(data, size) == ssize_t(size));
+        UTEST_ASSERT(os.size() == size * 2);
+        UTEST_ASSERT(memcmp(os.data(), data, size) == 0);
+        UTEST_ASSERT(memcmp(&os.data()[size], data, size) == 0);
+
+        // Release the data
+        uint8_t *buf = os.release();
+        UTEST_ASSERT(buf != NULL);
+        UTEST_ASSERT(memcmp(&buf[size], data, size) == 0);
+        UTEST_ASSERT(os.size() == 0);
+        UTEST_ASSERT(os.segments() == 0);
+        free(buf);
+
+        // Re-use the stream after clear()
+        write_data(&os, data, size);
+        os.clear();
+        UTEST_ASSERT(os.size() == 0);
+        write_data(&os, data, size);
+        UTEST_ASSERT(memcmp(os.data(), data, size) == 0);
+
+        os.drop();
+        dst.drop();
+    }
+
+    UTEST_MAIN
+    {
+        uint8_t *data = new uint8_t[DATA_SIZE];
+        UTEST_ASSERT(data != NULL);
+        for (size_t i=0; i<DATA_SIZE; ++i)
+            data[i]     = uint8_t(rand());
+
+        test_stream(data, DATA_SIZE, false);
+        test_stream(data, DATA_SIZE, true);
+        test_full_sink(data, DATA_SIZE);
+
+        delete [] data;
+    }
+
+UTEST_END
@@ -357,6 +357,35 @@ UTEST_BEGIN("runtime.io", path)
         UTEST_ASSERT(p.equals(TEST_ROOT));
     }
 
+//    status_t    remove_first();
+//    status_t    remove_first(LSPString *path);
+//    status_t    remove_first(Path *path);
+    void test_remove_first()
+    {
+        Path p, spath;
+        LSPString sstr;
+
+        UTEST_ASSERT(p.set("a/b/c") == STATUS_OK);
+        UTEST_ASSERT(p.remove_first(&sstr) == STATUS_OK);
+        UTEST_ASSERT(p.remove_first(snull) == STATUS_BAD_ARGUMENTS);
+        UTEST_ASSERT(p.remove_first(&spath) == STATUS_OK);
+        UTEST_ASSERT(p.remove_first(pnull) == STATUS_BAD_ARGUMENTS);
+        UTEST_ASSERT(spath.equals(&sstr));
+        UTEST_ASSERT(p.equals("a" FILE_SEPARATOR_S "b" FILE_SEPARATOR_S "c"));
+
+        UTEST_ASSERT(p.remove_first() == STATUS_OK);
+        UTEST_ASSERT(p.equals("b" FILE_SEPARATOR_S "c"));
+        UTEST_ASSERT(spath.equals(&p));
+        UTEST_ASSERT(p.remove_first() == STATUS_OK);
+        UTEST_ASSERT(p.equals("c"));
+        UTEST_ASSERT(p.remove_first() == STATUS_OK);
+        UTEST_ASSERT(p.is_empty());
+
+        UTEST_ASSERT(p.set(TEST_ROOT) == STATUS_OK);
+        UTEST_ASSERT(p.remove_first() == STATUS_OK);
+        UTEST_ASSERT(p.is_empty());
+    }
+
 //    status_t    remove_base(const char *path);
 //    status_t    remove_base(const LSPString *path);
 //    status_t    remove_base(const Path *path);
@@ -668,6 +697,7 @@ UTEST_BEGIN("runtime.io", path)
         test_concat();
         test_append_child();
         test_remove_last();
+        test_remove_first();
         test_remove_base();
         test_flags();
         test_canonical();
@@ -111,6 +111,22 @@ UTEST_BEGIN("runtime.io", pathpattern)
             {
                 return (pRoot != NULL) ? do_dump(0, pRoot) : STATUS_OK;
             }
+
+            bool compiled() const
+            {
+                return pDFA != NULL;
+            }
+
+            bool interpret(const char *path)
+            {
+                io::Path tmp;
+                if (tmp.set(path) != STATUS_OK)
+                    return false;
+                if ((!(nFlags & FULL_PATH)) && (tmp.remove_base() != STATUS_OK))
+                    return false;
+
+                return match_full(tmp.as_string());
+            }
     };
 
     void test_parse()
@@ -176,6 +192,86 @@ UTEST_BEGIN("runtime.io", pathpattern)
         bool match;
     } match_t;
 
+    void test_match_case()
+    {
+        TestPathPattern p(this);
+
+        printf("Testing character case sensitivity\n");
+
+        UTEST_ASSERT(p.set("*.TXT|ReadMe") == STATUS_OK);
+        UTEST_ASSERT(p.test("file.txt"));
+        UTEST_ASSERT(p.test("FILE.Txt"));
+        UTEST_ASSERT(p.test("README"));
+        UTEST_ASSERT(!p.test("README.md"));
+
+        p.set_flags(io::PathPattern::MATCH_CASE);
+        UTEST_ASSERT(p.compiled());
+        UTEST_ASSERT(!p.test("file.txt"));
+        UTEST_ASSERT(p.test("file.TXT"));
+        UTEST_ASSERT(p.test("ReadMe"));
+        UTEST_ASSERT(!p.test("README"));
+
+        p.set_flags(io::PathPattern::NONE);
+        UTEST_ASSERT(p.compiled());
+        UTEST_ASSERT(p.test("file.txt"));
+        UTEST_ASSERT(p.test("README"));
+    }
+
+    void test_compiled()
+    {
+        static const char *patterns[] =
+        {
+            "*",
+            "!*",
+            "**/",
+            "**/*",
+            "!(**/*)",
+            "**/*.c",
+            "a/**/b",
+            "a/**/**/b*",
+            "!(**/)x*",
+            "(!**/)ab/**/cd*",
+            "*a*b*",
+            "*ab*&!(*b)",
+            "!(ab)*",
+            "*!(ab)",
+            "?*`?*",
+            "(a*|*b)(c|!(d))",
+            "a!(b*)c",
+            "!(a|b)*/**/!(c*)",
+            "**/!(**/)*",
+            NULL
+        };
+        static const char *values[] =
+        {
+            "", "a", "b", "ab", "ba", "abc", "acb", "abab", "a/b", "a//b", "a/x/b", "a/x/y/bz",
+            "/", "//", "/a", "a/", "x", "xab", "x/ab", "12ab/x/cd", "/ab/x/cd", "ab/cd",
+            "?`?", "a`?b", "d", "ac", "ad", "bc", "bd", "abd", "abbc", "src/main.c", "main.c/",
+            "a\\b", "a\\x/b", "\\x",
+            NULL
+        };
+
+        TestPathPattern p(this);
+        for (const char * const *pat = patterns; *pat != NULL; ++pat)
+        {
+            for (size_t flags = 0; flags <= (io::PathPattern::MATCH_CASE | io::PathPattern::FULL_PATH); ++flags)
+            {
+                UTEST_ASSERT(p.set(*pat, flags) == STATUS_OK);
+                UTEST_ASSERT(p.compiled());
+
+                for (const char * const *v = values; *v != NULL; ++v)
+                {
+                    if (p.test(*v) != p.interpret(*v))
+                    {
+                        p.dump();
+                        UTEST_FAIL_MSG("Compiled and interpreted results differ for pattern \"%s\", value=\"%s\", flags=0x%x",
+                            *pat, *v, int(flags));
+                    }
+                }
+            }
+        }
+    }
+
     void test_match_patterns(const match_t *matches)
     {
         TestPathPattern p(this);
@@ -193,6 +289,14 @@ UTEST_BEGIN("runtime.io", pathpattern)
 
             // Test direct
             UTEST_ASSERT(p.set(m->pattern, flags) == STATUS_OK);
+            UTEST_ASSERT(p.compiled());
+            if (p.interpret(m->value) != m->match)
+            {
+                p.dump();
+                UTEST_FAIL_MSG("Falied interpreted match for pattern \"%s\", value=\"%s\", match=%s",
+                    m->pattern, m->value, (m->match) ? "true" : "false"
+                )
+            }
             if (p.test(m->value) != m->match)
             {
                 p.dump();
@@ -584,6 +688,8 @@ UTEST_BEGIN("runtime.io", pathpattern)
         test_match_sequence_only();
         test_match_brute();
         test_match_examples();
+        test_match_case();
+        test_compiled();
     }
 
 UTEST_END
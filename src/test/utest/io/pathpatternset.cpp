@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 22 мар. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/test-fw/utest.h>
+#include <lsp-plug.in/common/status.h>
+#include <lsp-plug.in/io/PathPatternSet.h>
+
+UTEST_BEGIN("runtime.io", pathpatternset)
+
+    void test_basic()
+    {
+        io::PathPatternSet set;
+        io::PathPattern pat;
+        bool matched[8];
+
+        printf("Testing basic functions\n");
+
+        UTEST_ASSERT(set.size() == 0);
+        UTEST_ASSERT(set.test("file.c") < 0);
+        UTEST_ASSERT(set.match("file.c", matched) == 0);
+
+        UTEST_ASSERT(pat.set("*.h", io::PathPattern::MATCH_CASE) == STATUS_OK);
+        UTEST_ASSERT(set.add("*.c|*.cpp") == STATUS_OK);
+        UTEST_ASSERT(set.add(&pat) == STATUS_OK);
+        UTEST_ASSERT(set.add("**/test/**", io::PathPattern::FULL_PATH) == STATUS_OK);
+        UTEST_ASSERT(set.add("*.log", io::PathPattern::INVERSE) == STATUS_OK);
+        UTEST_ASSERT(set.add("(*.c") != STATUS_OK);
+        UTEST_ASSERT(set.size() == 4);
+        UTEST_ASSERT(set.get(1)->flags() == io::PathPattern::MATCH_CASE);
+        UTEST_ASSERT(set.get(4) == NULL);
+
+        UTEST_ASSERT(set.test("src/main.c") == 0);
+        UTEST_ASSERT(set.test("src/main.h") == 1);
+        UTEST_ASSERT(set.test("src/main.H") == 3);
+        UTEST_ASSERT(set.test("src/test/main.log") == 2);
+        UTEST_ASSERT(set.test("src/main.log") < 0);
+
+        UTEST_ASSERT(set.match("src/test/main.cpp", matched) == 3);
+        UTEST_ASSERT(matched[0]);
+        UTEST_ASSERT(!matched[1]);
+        UTEST_ASSERT(matched[2]);
+        UTEST_ASSERT(matched[3]);
+
+        UTEST_ASSERT(set.match("src/main.log", matched) == 0);
+        UTEST_ASSERT(set.match("src/main.log", NULL) == 0);
+        UTEST_ASSERT(set.match("test/main.log", matched) == 1);
+        UTEST_ASSERT(matched[2]);
+        UTEST_ASSERT(set.match("mytest/main.log", matched) == 0);
+
+        UTEST_ASSERT(set.remove(0) == STATUS_OK);
+        UTEST_ASSERT(set.remove(5) != STATUS_OK);
+        UTEST_ASSERT(set.size() == 3);
+        UTEST_ASSERT(set.test("src/main.c") == 2);
+
+        set.clear();
+        UTEST_ASSERT(set.size() == 0);
+        UTEST_ASSERT(set.test("src/main.c") < 0);
+    }
+
+    void test_consistency()
+    {
+        static const char *patterns[] =
+        {
+            "*",
+            "!*",
+            "*.c|*.h",
+            "**/*.c",
+            "*.c&test-*",
+            "!(*.c|*.h)&!(test-*)",
+            "file*(!test).log",
+            "(!**/)ab/**/cd*",
+            "**/path/**/file.ext",
+            "?file.???",
+            "``quoted`?``.file",
+            "path/**/file.ext",
+            NULL
+        };
+        static const char *values[] =
+        {
+            "",
+            "file.c",
+            "test-file.c",
+            "test-file.cpp",
+            "src/test-file.h",
+            "file-test.log",
+            "file-data.log",
+            "/ab/x/cd",
+            "12ab/x/cd",
+            "ab/cd/ef",
+            "path/to/file.ext",
+            "/some/path/to/file.ext",
+            "xfile.ext",
+            "`quoted?`.file",
+            "dir\\file.c",
+            NULL
+        };
+
+        io::PathPatternSet set;
+        io::PathPattern pat;
+        bool matched[0x80];
+        size_t n = 0;
+
+        printf("Testing consistency with single patterns\n");
+
+        // Add many patterns to exceed the static limit of the set
+        for (size_t flags = 0; flags <= (io::PathPattern::INVERSE | io::PathPattern::MATCH_CASE | io::PathPattern::FULL_PATH); ++flags)
+        {
+            for (const char * const *p = patterns; *p != NULL; ++p)
+            {
+                UTEST_ASSERT(set.add(*p, flags) == STATUS_OK);
+                ++n;
+            }
+        }
+        UTEST_ASSERT(set.size() == n);
+
+        for (const char * const *v = values; *v != NULL; ++v)
+        {
+            size_t count = 0;
+            ssize_t first = -1;
+
+            for (size_t i=0; i<n; ++i)
+            {
+                const io::PathPattern *p = set.get(i);
+                UTEST_ASSERT(pat.set(p) == STATUS_OK);
+                matched[i] = pat.test(*v);
+                if (matched[i])
+                {
+                    ++count;
+                    if (first < 0)
+                        first = i;
+                }
+            }
+
+            bool xmatched[0x80];
+            UTEST_ASSERT(set.match(*v, xmatched) == count);
+            UTEST_ASSERT(set.test(*v) == first);
+            for (size_t i=0; i<n; ++i)
+            {
+                if (matched[i] != xmatched[i])
+                    UTEST_FAIL_MSG("Match result differs for pattern \"%s\", flags=0x%x, value=\"%s\"",
+                        set.get(i)->get_utf8(), int(set.get(i)->flags()), *v);
+            }
+        }
+    }
+
+    UTEST_MAIN
+    {
+        test_basic();
+        test_consistency();
+    }
+
+UTEST_END
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 24 мар. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/test-fw/utest.h>
+#include <lsp-plug.in/common/status.h>
+#include <lsp-plug.in/io/Path.h>
+#include <lsp-plug.in/io/PathView.h>
+
+#ifdef PLATFORM_WINDOWS
+    #define TEST_PATH1      "C:\\Windows\\system\\lib.dll"
+    #define TEST_PATH2      "C:\\Windows\\system"
+    #define TEST_ROOT       "C:\\"
+    #define TEST_FIRST      "C:\\"
+#else
+    #define TEST_PATH1      "/usr/share/lib.so"
+    #define TEST_PATH2      "/usr/share"
+    #define TEST_ROOT       "/"
+    #define TEST_FIRST      "/"
+#endif
+
+using namespace lsp;
+using namespace lsp::io;
+
+UTEST_BEGIN("runtime.io", pathview)
+
+    void test_split()
+    {
+        Path p, xp;
+        PathView v, item;
+        LSPString s;
+
+        printf("Testing get_*() methods...\n");
+        UTEST_ASSERT(p.set(TEST_PATH1) == STATUS_OK);
+        v.set(&p);
+        UTEST_ASSERT(v.length() == p.length());
+        UTEST_ASSERT(v.equals(&p));
+        UTEST_ASSERT(p.equals(&v));
+        UTEST_ASSERT(v.hash() == p.as_string()->hash());
+        UTEST_ASSERT(v.is_absolute());
+        UTEST_ASSERT(!v.is_root());
+        UTEST_ASSERT(v.is_canonical());
+
+        UTEST_ASSERT(v.get_last(&item) == STATUS_OK);
+        UTEST_ASSERT(item.get(&s) == STATUS_OK);
+        UTEST_ASSERT(s.equals_ascii("lib.so") || s.equals_ascii("lib.dll"));
+        UTEST_ASSERT(v.get_ext(&item) == STATUS_OK);
+        UTEST_ASSERT(item.get(&s) == STATUS_OK);
+        UTEST_ASSERT(s.equals_ascii("so") || s.equals_ascii("dll"));
+        UTEST_ASSERT(v.get_noext(&item) == STATUS_OK);
+        UTEST_ASSERT(item.get(&s) == STATUS_OK);
+        UTEST_ASSERT(s.equals_ascii("lib"));
+        UTEST_ASSERT(v.get_parent(&item) == STATUS_OK);
+        UTEST_ASSERT(item.get(&xp) == STATUS_OK);
+        UTEST_ASSERT(xp.equals(TEST_PATH2));
+        UTEST_ASSERT(v.get_root(&item) == STATUS_OK);
+        UTEST_ASSERT(item.get(&xp) == STATUS_OK);
+        UTEST_ASSERT(xp.equals(TEST_ROOT));
+        UTEST_ASSERT(item.is_root());
+
+        printf("Testing pop_first() method...\n");
+        UTEST_ASSERT(v.pop_first(&item) == STATUS_OK);
+        UTEST_ASSERT(item.get(&xp) == STATUS_OK);
+        UTEST_ASSERT(xp.equals(TEST_FIRST));
+        size_t n = 0;
+        while (v.pop_first(&item) == STATUS_OK)
+            ++n;
+        UTEST_ASSERT(n == 3);
+        UTEST_ASSERT(v.is_empty());
+
+        printf("Testing pop_last() method...\n");
+        UTEST_ASSERT(p.set("a/b/c") == STATUS_OK);
+        p.view(&v);
+        UTEST_ASSERT(v.pop_last(&item) == STATUS_OK);
+        UTEST_ASSERT(item.get(&s) == STATUS_OK);
+        UTEST_ASSERT(s.equals_ascii("c"));
+        UTEST_ASSERT(v.pop_last(&item) == STATUS_OK);
+        UTEST_ASSERT(item.get(&s) == STATUS_OK);
+        UTEST_ASSERT(s.equals_ascii("b"));
+        UTEST_ASSERT(v.get(&s) == STATUS_OK);
+        UTEST_ASSERT(s.equals_ascii("a"));
+        UTEST_ASSERT(v.pop_last(&item) == STATUS_OK);
+        UTEST_ASSERT(v.is_empty());
+    }
+
+    void test_modify()
+    {
+        Path p, xp;
+        PathView v;
+
+        printf("Testing remove_*() methods...\n");
+        UTEST_ASSERT(p.set("a/b/./c") == STATUS_OK);
+        v.set(&p);
+        UTEST_ASSERT(!v.is_canonical());
+        UTEST_ASSERT(v.remove_first() == STATUS_OK);
+        UTEST_ASSERT(v.get(&xp) == STATUS_OK);
+        UTEST_ASSERT(xp.equals("b" FILE_SEPARATOR_S "." FILE_SEPARATOR_S "c"));
+        UTEST_ASSERT(v.remove_last() == STATUS_OK);
+        UTEST_ASSERT(v.get(&xp) == STATUS_OK);
+        UTEST_ASSERT(xp.equals("b" FILE_SEPARATOR_S "."));
+        UTEST_ASSERT(v.remove_base() == STATUS_OK);
+        UTEST_ASSERT(v.is_dot());
+        UTEST_ASSERT(v.is_dots());
+        UTEST_ASSERT(!v.is_dotdot());
+        UTEST_ASSERT(v.remove_first() == STATUS_OK);
+        UTEST_ASSERT(v.is_empty());
+
+        UTEST_ASSERT(p.set(TEST_PATH2) == STATUS_OK);
+        v.set(&p);
+        UTEST_ASSERT(v.remove_root() == STATUS_OK);
+        UTEST_ASSERT(v.is_relative());
+        UTEST_ASSERT(v.parent() == STATUS_OK);
+        UTEST_ASSERT(v.get(&xp) == STATUS_OK);
+        UTEST_ASSERT(xp.equals("usr") || xp.equals("Windows"));
+
+        printf("Testing assignment of the own sub-view...\n");
+        UTEST_ASSERT(p.set(TEST_PATH1) == STATUS_OK);
+        v.set(&p);
+        UTEST_ASSERT(v.remove_root() == STATUS_OK);
+        UTEST_ASSERT(p.set(&v) == STATUS_OK);
+        UTEST_ASSERT(p.is_relative());
+        v.set(&p);
+        UTEST_ASSERT(v.remove_first() == STATUS_OK);
+        UTEST_ASSERT(p.append_child(&v) == STATUS_OK);
+        v.set(&p);
+        UTEST_ASSERT(v.remove_last() == STATUS_OK);
+        UTEST_ASSERT(p.set(&v) == STATUS_OK);
+        UTEST_ASSERT(p.get_last(&xp) == STATUS_OK);
+        UTEST_ASSERT(xp.equals("system") || xp.equals("share"));
+        UTEST_ASSERT(p.get_first(&xp) == STATUS_OK);
+        UTEST_ASSERT(xp.equals("usr") || xp.equals("Windows"));
+    }
+
+    UTEST_MAIN
+    {
+        test_split();
+        test_modify();
+    }
+UTEST_END;
@@ -0,0 +1,290 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 3 апр. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/test-fw/utest.h>
+#include <lsp-plug.in/ipc/Thread.h>
+#include <lsp-plug.in/mm/AudioRecorder.h>
+#include <lsp-plug.in/stdlib/math.h>
+#include <lsp-plug.in/stdlib/string.h>
+
+#include <stdlib.h>
+
+#define CHANNELS        2
+#define SAMPLE_RATE     48000
+
+namespace
+{
+    using namespace lsp;
+
+    /**
+     * Audio stream that simulates the slow disk: each write is delayed,
+     * and every few writes the stream stalls for the long period
+     */
+    class ThrottledStream: public mm::IOutAudioStream
+    {
+        protected:
+            mm::f32_t          *pData;
+            size_t              nCapacity;
+            size_t              nPos;
+            size_t              nDelay;
+            size_t              nStall;
+            size_t              nCalls;
+            size_t              nFlushes;
+
+        protected:
+            virtual ssize_t direct_write(const void *src, size_t nframes, size_t fmt)
+            {
+                ++nCalls;
+                ipc::Thread::sleep((nCalls % 8) ? nDelay : nStall);
+
+                if (nPos >= nCapacity)
+                    return -STATUS_OVERFLOW;
+                nframes     = lsp_min(nframes, nCapacity - nPos);
+                ::memcpy(&pData[nPos * sFormat.channels], src, nframes * sFormat.channels * sizeof(mm::f32_t));
+                nPos       += nframes;
+                return nframes;
+            }
+
+            virtual size_t  select_format(size_t fmt)
+            {
+                return mm::SFMT_F32_CPU;
+            }
+
+        public:
+            explicit ThrottledStream(size_t frames, size_t delay, size_t stall)
+            {
+                pData               = static_cast<mm::f32_t *>(::malloc(frames * CHANNELS * sizeof(mm::f32_t)));
+                nCapacity           = frames;
+                nPos                = 0;
+                nDelay              = delay;
+                nStall              = stall;
+                nCalls              = 0;
+                nFlushes            = 0;
+                nOffset             = 0;
+                sFormat.srate       = SAMPLE_RATE;
+                sFormat.channels    = CHANNELS;
+                sFormat.frames      = frames;
+                sFormat.format      = mm::SFMT_F32_CPU;
+            }
+
+            virtual ~ThrottledStream()
+            {
+                ::free(pData);
+            }
+
+            virtual status_t flush()
+            {
+                ++nFlushes;
+                return IOutAudioStream::flush();
+            }
+
+        public:
+            inline const mm::f32_t *data() const    { return pData;     }
+            inline size_t           frames() const  { return nPos;      }
+            inline size_t           flushes() const { return nFlushes;  }
+    };
+}
+
+UTEST_BEGIN("runtime.mm", audiorecorder)
+
+    static void fill_block(mm::f32_t *dst, size_t first, size_t frames)
+    {
+        for (size_t i=0; i<frames; ++i)
+        {
+            dst[i*CHANNELS]     = first + i + 1;
+            dst[i*CHANNELS + 1] = -mm::f32_t(first + i + 1);
+        }
+    }
+
+    /**
+     * Write blocks to the recorder at the realtime rate
+     * @return number of frames passed to the recorder
+     */
+    size_t produce(mm::AudioRecorder *rec, size_t block, size_t blocks)
+    {
+        mm::f32_t *buf  = static_cast<mm::f32_t *>(::malloc(block * CHANNELS * sizeof(mm::f32_t)));
+        UTEST_ASSERT(buf != NULL);
+        size_t period   = (block * 1000) / SAMPLE_RATE;
+        mm::AudioRecorder::stats_t st;
+        wsize_t stored  = 0;
+
+        for (size_t i=0; i<blocks; ++i)
+        {
+            fill_block(buf, i * block, block);
+            ssize_t n       = rec->write(buf, block);
+            UTEST_ASSERT(n >= 0);
+
+            // Statistics should be consistent while the writer thread is running
+            rec->get_stats(&st);
+            UTEST_ASSERT(st.written + st.dropped == (i + 1) * block);
+            UTEST_ASSERT(st.stored <= st.written);
+            UTEST_ASSERT(st.stored >= stored);
+            stored          = st.stored;
+
+            ipc::Thread::sleep(period);
+        }
+
+        ::free(buf);
+        return block * blocks;
+    }
+
+    void test_realtime()
+    {
+        static const size_t BLOCK   = 480;      // 10 ms
+        static const size_t BLOCKS  = 150;      // 1.5 s
+
+        ThrottledStream os(BLOCK * BLOCKS, 20, 150);
+        mm::AudioRecorder rec;
+        mm::AudioRecorder::stats_t st;
+
+        UTEST_ASSERT(rec.open(&os, 0x8000) == STATUS_OK);
+        UTEST_ASSERT(rec.is_opened());
+        UTEST_ASSERT(rec.channels() == CHANNELS);
+        UTEST_ASSERT(rec.capacity() == 0x8000);
+        UTEST_ASSERT(rec.start() == STATUS_OK);
+        UTEST_ASSERT(rec.is_running());
+
+        size_t total    = produce(&rec, BLOCK, BLOCKS);
+        UTEST_ASSERT(rec.stop() == STATUS_OK);
+        UTEST_ASSERT(!rec.is_running());
+        UTEST_ASSERT(os.flushes() == 1);
+
+        // The buffer is large enough to survive the stalls
+        rec.get_stats(&st);
+        UTEST_ASSERT(st.error == STATUS_OK);
+        UTEST_ASSERT(st.dropped == 0);
+        UTEST_ASSERT(st.overflows == 0);
+        UTEST_ASSERT(st.written == total);
+        UTEST_ASSERT(st.stored == total);
+        UTEST_ASSERT(st.peak <= st.capacity);
+        UTEST_ASSERT(os.frames() == total);
+
+        const mm::f32_t *data = os.data();
+        for (size_t i=0; i<total; ++i)
+        {
+            UTEST_ASSERT_MSG(data[i*CHANNELS] == mm::f32_t(i + 1), "Invalid frame %d", int(i));
+            UTEST_ASSERT_MSG(data[i*CHANNELS + 1] == -mm::f32_t(i + 1), "Invalid frame %d", int(i));
+        }
+
+        UTEST_ASSERT(rec.close() == STATUS_OK);
+        UTEST_ASSERT(!rec.is_opened());
+    }
+
+    void test_overflow()
+    {
+        static const size_t BLOCK   = 240;      // 5 ms
+        static const size_t BLOCKS  = 100;      // 0.5 s
+
+        ThrottledStream os(BLOCK * BLOCKS, 50, 100);
+        mm::AudioRecorder rec;
+        mm::AudioRecorder::stats_t st;
+
+        UTEST_ASSERT(rec.open(&os, 1000) == STATUS_OK);
+        UTEST_ASSERT(rec.capacity() == 0x400);
+        UTEST_ASSERT(rec.start() == STATUS_OK);
+        size_t total    = produce(&rec, BLOCK, BLOCKS);
+        UTEST_ASSERT(rec.stop() == STATUS_OK);
+
+        // The buffer is too small, some frames should be dropped
+        rec.get_stats(&st);
+        UTEST_ASSERT(st.error == STATUS_OK);
+        UTEST_ASSERT(st.overflows > 0);
+        UTEST_ASSERT(st.dropped > 0);
+        UTEST_ASSERT(st.written + st.dropped == total);
+        UTEST_ASSERT(st.stored == st.written);
+        UTEST_ASSERT(st.peak == st.capacity);
+        UTEST_ASSERT(os.frames() == st.stored);
+
+        // Stored frames should keep the order
+        const mm::f32_t *data = os.data();
+        for (size_t i=0; i<os.frames(); ++i)
+        {
+            UTEST_ASSERT(data[i*CHANNELS + 1] == -data[i*CHANNELS]);
+            if (i > 0)
+                UTEST_ASSERT_MSG(data[i*CHANNELS] > data[(i-1)*CHANNELS], "Invalid frame %d", int(i));
+        }
+
+        UTEST_ASSERT(rec.close() == STATUS_OK);
+    }
+
+    void test_planar_and_errors()
+    {
+        static const size_t FRAMES  = 0x1000;
+
+        ThrottledStream *os = new ThrottledStream(FRAMES - 1, 0, 0);
+        mm::AudioRecorder rec;
+        mm::AudioRecorder::stats_t st;
+        mm::f32_t l[FRAMES], r[FRAMES];
+        const mm::f32_t *planes[CHANNELS] = { l, r };
+
+        UTEST_ASSERT(rec.write(l, FRAMES) == -STATUS_CLOSED);
+        UTEST_ASSERT(rec.start() == STATUS_CLOSED);
+        UTEST_ASSERT(rec.open(NULL, FRAMES) == STATUS_BAD_ARGUMENTS);
+        UTEST_ASSERT(rec.open(os, 0) == STATUS_BAD_ARGUMENTS);
+        UTEST_ASSERT(rec.open(os, FRAMES, WRAP_CLOSE | WRAP_DELETE) == STATUS_OK);
+        UTEST_ASSERT(rec.open(os, FRAMES) == STATUS_OPENED);
+        UTEST_ASSERT(rec.stop() == STATUS_BAD_STATE);
+
+        for (size_t i=0; i<FRAMES; ++i)
+        {
+            l[i]    = i + 1;
+            r[i]    = -mm::f32_t(i + 1);
+        }
+
+        // Frames written before start() are kept in the buffer
+        UTEST_ASSERT(rec.write_planar(planes, FRAMES/2) == FRAMES/2);
+        UTEST_ASSERT(rec.start() == STATUS_OK);
+        UTEST_ASSERT(rec.start() == STATUS_BAD_STATE);
+        const mm::f32_t *tail[CHANNELS] = { &l[FRAMES/2], &r[FRAMES/2] };
+        UTEST_ASSERT(rec.write_planar(tail, FRAMES/2) == FRAMES/2);
+
+        // The stream does not fit all frames, the error should be reported
+        UTEST_ASSERT(rec.stop() == STATUS_OVERFLOW);
+        rec.get_stats(&st);
+        UTEST_ASSERT(st.error == STATUS_OVERFLOW);
+        UTEST_ASSERT(st.written == FRAMES);
+        UTEST_ASSERT(st.dropped == 0);
+        UTEST_ASSERT(st.stored == FRAMES - 1);
+        UTEST_ASSERT(os->frames() == FRAMES - 1);
+
+        const mm::f32_t *data = os->data();
+        for (size_t i=0; i<FRAMES-1; ++i)
+        {
+            UTEST_ASSERT_MSG(data[i*CHANNELS] == l[i], "Invalid frame %d", int(i));
+            UTEST_ASSERT_MSG(data[i*CHANNELS + 1] == r[i], "Invalid frame %d", int(i));
+        }
+
+        // The stream is deleted by the recorder
+        UTEST_ASSERT(rec.close() == STATUS_OK);
+        UTEST_ASSERT(rec.close() == STATUS_OK);
+    }
+
+    UTEST_MAIN
+    {
+        printf("Testing real-time recording with throttled output\n");
+        test_realtime();
+        printf("Testing buffer overflow\n");
+        test_overflow();
+        printf("Testing planar data and error handling\n");
+        test_planar_and_errors();
+    }
+
+UTEST_END
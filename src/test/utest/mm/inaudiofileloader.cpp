@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 31 мар. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/test-fw/utest.h>
+#include <lsp-plug.in/test-fw/FloatBuffer.h>
+#include <lsp-plug.in/test-fw/ByteBuffer.h>
+#include <lsp-plug.in/mm/InAudioFileLoader.h>
+#include <lsp-plug.in/mm/OutAudioFileStream.h>
+
+#define FRAMES          400000
+#define CHANNELS        3
+
+namespace
+{
+    typedef struct progress_t
+    {
+        lsp::wsize_t    nCalls;
+        lsp::wsize_t    nLoaded;
+        lsp::wsize_t    nCancel;
+        bool            bValid;
+    } progress_t;
+
+    lsp::status_t on_progress(lsp::wsize_t loaded, lsp::wsize_t total, void *arg)
+    {
+        progress_t *p = static_cast<progress_t *>(arg);
+
+        if ((loaded <= p->nLoaded) || (loaded > total))
+            p->bValid   = false;
+        ++p->nCalls;
+        p->nLoaded  = loaded;
+
+        return ((p->nCancel > 0) && (loaded >= p->nCancel)) ? lsp::STATUS_CANCELLED : lsp::STATUS_OK;
+    }
+}
+
+UTEST_BEGIN("runtime.mm", inaudiofileloader)
+
+    void write_file(const io::Path *path, FloatBuffer &buf)
+    {
+        printf("Writing audio file %s\n", path->as_native());
+
+        mm::audio_stream_t fmt;
+        fmt.srate       = 48000;
+        fmt.channels    = CHANNELS;
+        fmt.frames      = FRAMES;
+        fmt.format      = mm::SFMT_F32;
+
+        mm::OutAudioFileStream os;
+        UTEST_ASSERT(os.open(path, &fmt, mm::AFMT_WAV | mm::CFMT_PCM) == STATUS_OK);
+        UTEST_ASSERT(os.write(buf.data(), FRAMES) == FRAMES);
+        UTEST_ASSERT(os.close() == STATUS_OK);
+    }
+
+    void test_load(const io::Path *path, FloatBuffer &src, size_t threads)
+    {
+        printf("Loading audio file with threads=%d\n", int(threads));
+
+        mm::InAudioFileLoader ld;
+        mm::audio_stream_t fmt;
+        ld.set_threads(threads);
+        UTEST_ASSERT(ld.load(src.data(), mm::SFMT_F32_CPU, 0, FRAMES) == -STATUS_CLOSED);
+        UTEST_ASSERT(ld.open(path) == STATUS_OK);
+        UTEST_ASSERT(ld.open(path) == STATUS_OPENED);
+        UTEST_ASSERT(ld.info(&fmt) == STATUS_OK);
+        UTEST_ASSERT(fmt.srate == 48000);
+        UTEST_ASSERT(fmt.channels == CHANNELS);
+        UTEST_ASSERT(fmt.frames == FRAMES);
+        UTEST_ASSERT(ld.is_seekable());
+
+        // Load the whole file
+        progress_t p;
+        p.nCalls        = 0;
+        p.nLoaded       = 0;
+        p.nCancel       = 0;
+        p.bValid        = true;
+
+        FloatBuffer dst(FRAMES * CHANNELS);
+        UTEST_ASSERT(ld.load(dst.data(), mm::SFMT_F32_CPU, 0, FRAMES, on_progress, &p) == FRAMES);
+        UTEST_ASSERT(dst.valid());
+        UTEST_ASSERT_MSG(src.equals_absolute(dst), "Loaded samples differ at index %d: %f vs %f",
+            int(dst.last_diff()), src.get_diff(), dst.get_diff());
+        UTEST_ASSERT(p.bValid);
+        UTEST_ASSERT(p.nCalls > 0);
+        UTEST_ASSERT(p.nLoaded == FRAMES);
+
+        // Load the range which exceeds the length of the file
+        FloatBuffer part(FRAMES * CHANNELS);
+        size_t first    = 123457;
+        UTEST_ASSERT(ld.load(part.data(), mm::SFMT_F32_CPU, first, FRAMES) == FRAMES - first);
+        UTEST_ASSERT(part.valid());
+        for (size_t i=0; i<(FRAMES - first) * CHANNELS; ++i)
+            UTEST_ASSERT_MSG(part[i] == src[first * CHANNELS + i], "Sample %d differs", int(i));
+        UTEST_ASSERT(ld.load(part.data(), mm::SFMT_F32_CPU, FRAMES + 10, 10) == 0);
+
+        // Load samples in integer format
+        ByteBuffer s16(FRAMES * CHANNELS * sizeof(int16_t));
+        UTEST_ASSERT(ld.load(s16.data(), mm::SFMT_S16_CPU, 0, FRAMES) == FRAMES);
+        UTEST_ASSERT(s16.valid());
+        const int16_t *sp = s16.data<int16_t>();
+        for (size_t i=0; i<FRAMES * CHANNELS; ++i)
+        {
+            float s = sp[i] / 32767.0f;
+            UTEST_ASSERT_MSG(fabsf(s - src[i]) < 1e-3f, "Sample %d differs: %f vs %f", int(i), s, src[i]);
+        }
+
+        // Unsupported formats
+        UTEST_ASSERT(ld.load(s16.data(), mm::SFMT_S24_CPU, 0, FRAMES) == -STATUS_UNSUPPORTED_FORMAT);
+        UTEST_ASSERT(ld.load(s16.data(), __IF_LEBE(mm::SFMT_S16_BE, mm::SFMT_S16_LE), 0, FRAMES) == -STATUS_UNSUPPORTED_FORMAT);
+
+        // Cancel loading
+        p.nCalls        = 0;
+        p.nLoaded       = 0;
+        p.nCancel       = FRAMES / 4;
+        p.bValid        = true;
+        UTEST_ASSERT(ld.load(dst.data(), mm::SFMT_F32_CPU, 0, FRAMES, on_progress, &p) == -STATUS_CANCELLED);
+        UTEST_ASSERT(p.bValid);
+        UTEST_ASSERT(p.nLoaded >= FRAMES / 4);
+
+        UTEST_ASSERT(ld.close() == STATUS_OK);
+        UTEST_ASSERT(ld.load(dst.data(), mm::SFMT_F32_CPU, 0, FRAMES) == -STATUS_CLOSED);
+    }
+
+    UTEST_MAIN
+    {
+        // Generate data and write file
+        FloatBuffer src(FRAMES * CHANNELS);
+        src.randomize_sign();
+
+        io::Path path;
+        UTEST_ASSERT(path.fmt("%s/utest-%s.wav", tempdir(), full_name()) > 0);
+        write_file(&path, src);
+
+        // Test loading
+        test_load(&path, src, 1);
+        test_load(&path, src, 4);
+        test_load(&path, src, 0);
+    }
+
+UTEST_END
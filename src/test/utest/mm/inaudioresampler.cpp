@@ -0,0 +1,229 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 29 мар. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/test-fw/utest.h>
+#include <lsp-plug.in/test-fw/FloatBuffer.h>
+#include <lsp-plug.in/mm/InAudioResampler.h>
+#include <lsp-plug.in/stdlib/math.h>
+
+#define FRAMES          12345
+
+namespace
+{
+    using namespace lsp;
+
+    /**
+     * Audio stream that generates sine wave at the left channel
+     * and cosine wave at the right channel
+     */
+    class SineStream: public mm::IInAudioStream
+    {
+        protected:
+            double      fFreq;
+            wssize_t    nPos;
+
+        protected:
+            virtual ssize_t direct_read(void *dst, size_t nframes, size_t fmt)
+            {
+                if (nPos >= sFormat.frames)
+                    return -STATUS_EOF;
+                nframes     = lsp_min(wssize_t(nframes), sFormat.frames - nPos);
+
+                mm::f32_t *d = static_cast<mm::f32_t *>(dst);
+                for (size_t i=0; i<nframes; ++i, d += 2)
+                {
+                    double t    = double(nPos + i) / sFormat.srate;
+                    d[0]        = sin(2.0 * M_PI * fFreq * t);
+                    d[1]        = cos(2.0 * M_PI * fFreq * t);
+                }
+
+                nPos       += nframes;
+                return nframes;
+            }
+
+            virtual size_t  select_format(size_t fmt)
+            {
+                return mm::SFMT_F32_CPU;
+            }
+
+        public:
+            explicit SineStream(size_t srate, size_t frames, double freq)
+            {
+                fFreq               = freq;
+                nPos                = 0;
+                nOffset             = 0;
+                sFormat.srate       = srate;
+                sFormat.channels    = 2;
+                sFormat.frames      = frames;
+                sFormat.format      = mm::SFMT_F32_CPU;
+            }
+
+            virtual wssize_t seek(wsize_t nframes)
+            {
+                nPos        = lsp_min(wssize_t(nframes), sFormat.frames);
+                nOffset     = nPos;
+                return nOffset;
+            }
+    };
+}
+
+UTEST_BEGIN("runtime.mm", inaudioresampler)
+
+    void read_all(mm::IInAudioStream *is, FloatBuffer &buf, size_t frames)
+    {
+        size_t off = 0;
+        while (true)
+        {
+            size_t to_read  = lsp_min(size_t(rand() % 0x300) + 1, frames + 0x10 - off);
+            ssize_t n       = is->read(buf.data() + off * 2, to_read);
+            if (n < 0)
+            {
+                UTEST_ASSERT(n == -STATUS_EOF);
+                break;
+            }
+            off            += n;
+            UTEST_ASSERT(is->position() == wssize_t(off));
+        }
+        UTEST_ASSERT_MSG(off == frames, "Read %d frames, expected %d", int(off), int(frames));
+    }
+
+    void test_convert(size_t from, size_t to, double freq, size_t quality, float tol)
+    {
+        printf("Testing conversion %d -> %d, quality=%d\n", int(from), int(to), int(quality));
+
+        SineStream src(from, FRAMES, freq);
+        mm::InAudioResampler rs;
+        UTEST_ASSERT(rs.wrap(&src, to, quality) == STATUS_OK);
+        UTEST_ASSERT(rs.wrap(&src, to, quality) == STATUS_BAD_STATE);
+        UTEST_ASSERT(rs.sample_rate() == to);
+        UTEST_ASSERT(rs.channels() == 2);
+        UTEST_ASSERT(rs.format() == mm::SFMT_F32_CPU);
+
+        size_t frames   = (wsize_t(FRAMES) * to + from - 1) / from;
+        UTEST_ASSERT(rs.length() == wssize_t(frames));
+
+        FloatBuffer buf((frames + 0x10) * 2);
+        read_all(&rs, buf, frames);
+        UTEST_ASSERT(buf.valid());
+
+        // Check the signal except the edges
+        size_t edge     = 0x80 * to / from + 0x80;
+        for (size_t i=edge; i<frames - edge; ++i)
+        {
+            double t    = double(i) / to;
+            float l     = sin(2.0 * M_PI * freq * t);
+            float r     = cos(2.0 * M_PI * freq * t);
+            UTEST_ASSERT_MSG(fabs(buf[i*2] - l) < tol, "Left sample #%d: exp=%f, act=%f", int(i), l, buf[i*2]);
+            UTEST_ASSERT_MSG(fabs(buf[i*2+1] - r) < tol, "Right sample #%d: exp=%f, act=%f", int(i), r, buf[i*2+1]);
+        }
+
+        // Check seek and skip, the result should be the same
+        FloatBuffer tmp(0x100 * 2);
+        const size_t positions[] = { 0, 1, 1000, 10, frames / 2, frames - 0x100, 7 };
+        for (size_t i=0; i<sizeof(positions)/sizeof(size_t); ++i)
+        {
+            size_t pos  = positions[i];
+            UTEST_ASSERT(rs.seek(pos) == wssize_t(pos));
+            UTEST_ASSERT(rs.position() == wssize_t(pos));
+            UTEST_ASSERT(rs.read(tmp.data(), 0x80) == 0x80);
+            UTEST_ASSERT(rs.skip(0x10) == 0x10);
+            UTEST_ASSERT(rs.read(&tmp[0x100], 0x10) == 0x10);
+            UTEST_ASSERT(rs.position() == wssize_t(pos + 0xa0));
+            UTEST_ASSERT(tmp.valid());
+
+            UTEST_ASSERT_MSG(::memcmp(tmp.data(), &buf[pos * 2], 0x80 * 2 * sizeof(float)) == 0, "Data differs after seek to %d", int(pos));
+            UTEST_ASSERT_MSG(::memcmp(&tmp[0x100], &buf[(pos + 0x90) * 2], 0x10 * 2 * sizeof(float)) == 0, "Data differs after skip at %d", int(pos));
+        }
+
+        // Seek to the end
+        UTEST_ASSERT(rs.seek(frames + 100) == wssize_t(frames));
+        UTEST_ASSERT(rs.read(tmp.data(), 0x10) == -STATUS_EOF);
+
+        UTEST_ASSERT(rs.close() == STATUS_OK);
+        UTEST_ASSERT(rs.read(tmp.data(), 0x10) == -STATUS_CLOSED);
+    }
+
+    void test_aliasing(size_t from, size_t to, double freq, float tol)
+    {
+        printf("Testing suppression of %.1f Hz tone at conversion %d -> %d\n", freq, int(from), int(to));
+
+        SineStream src(from, FRAMES, freq);
+        mm::InAudioResampler rs;
+        UTEST_ASSERT(rs.wrap(&src, to, mm::RESAMPLE_HIGH) == STATUS_OK);
+
+        size_t frames   = (wsize_t(FRAMES) * to + from - 1) / from;
+        FloatBuffer buf((frames + 0x10) * 2);
+        read_all(&rs, buf, frames);
+        UTEST_ASSERT(buf.valid());
+
+        size_t edge     = 0x200;
+        for (size_t i=edge; i<frames - edge; ++i)
+            UTEST_ASSERT_MSG(fabs(buf[i*2]) < tol, "Sample #%d is too loud: %f", int(i), buf[i*2]);
+
+        UTEST_ASSERT(rs.close() == STATUS_OK);
+    }
+
+    void test_wrap()
+    {
+        SineStream src(48000, FRAMES, 1000.0);
+        mm::InAudioResampler rs;
+        FloatBuffer a((FRAMES + 0x10) * 2), b(FRAMES * 2);
+
+        UTEST_ASSERT(rs.wrap(NULL, 48000) == STATUS_BAD_ARGUMENTS);
+        UTEST_ASSERT(rs.wrap(&src, 0) == STATUS_BAD_ARGUMENTS);
+        UTEST_ASSERT(rs.wrap(&src, 44100, 100) == STATUS_BAD_ARGUMENTS);
+        UTEST_ASSERT(rs.wrap(&src, 1000) == STATUS_UNSUPPORTED_FORMAT);
+
+        // Same sample rate, the data should be passed as is
+        UTEST_ASSERT(rs.wrap(&src, 48000) == STATUS_OK);
+        UTEST_ASSERT(rs.length() == FRAMES);
+        read_all(&rs, a, FRAMES);
+        UTEST_ASSERT(rs.close() == STATUS_OK);
+
+        UTEST_ASSERT(src.seek(0) == 0);
+        UTEST_ASSERT(src.read(b.data(), FRAMES) == FRAMES);
+        UTEST_ASSERT(::memcmp(a.data(), b.data(), FRAMES * 2 * sizeof(float)) == 0);
+
+        // Position of the wrapped stream becomes the beginning
+        UTEST_ASSERT(src.seek(FRAMES - 100) == FRAMES - 100);
+        UTEST_ASSERT(rs.wrap(&src, 96000) == STATUS_OK);
+        UTEST_ASSERT(rs.length() == 200);
+        read_all(&rs, a, 200);
+        UTEST_ASSERT(rs.close() == STATUS_OK);
+    }
+
+    UTEST_MAIN
+    {
+        test_wrap();
+
+        test_convert(44100, 48000, 1000.0, mm::RESAMPLE_FAST, 2e-3f);
+        test_convert(44100, 48000, 1000.0, mm::RESAMPLE_NORMAL, 1e-3f);
+        test_convert(44100, 48000, 1000.0, mm::RESAMPLE_HIGH, 1e-3f);
+        test_convert(48000, 44100, 5000.0, mm::RESAMPLE_NORMAL, 1e-3f);
+        test_convert(96000, 44100, 2000.0, mm::RESAMPLE_HIGH, 1e-3f);
+        test_convert(22050, 96000, 3000.0, mm::RESAMPLE_NORMAL, 1e-3f);
+        test_convert(44100, 44099, 1000.0, mm::RESAMPLE_FAST, 2e-3f);
+
+        test_aliasing(96000, 44100, 30000.0, 1e-3f);
+        test_aliasing(48000, 32000, 20000.0, 1e-3f);
+    }
+
+UTEST_END
@@ -186,6 +186,104 @@ UTEST_BEGIN("runtime.mm", outaudiofilestream)
         validate_file(&path, src, srate, tol);
     }
 
+    void test_write_quantized(const char *file, const float *src, size_t codec, size_t srate, size_t quantize, float tol)
+    {
+        io::Path path;
+        UTEST_ASSERT(path.fmt("%s/%s-%s", tempdir(), full_name(), file));
+        printf("Writing PCM audio file %s as quantized floating-point samples\n", path.as_native());
+
+        mm::OutAudioFileStream os;
+        mm::audio_stream_t info;
+        info.srate      = srate;
+        info.channels   = 2;
+        info.frames     = FRAMES;
+        info.format     = mm::SFMT_S16;
+
+        UTEST_ASSERT(os.quantize() == mm::QUANTIZE_TRUNCATE);
+        UTEST_ASSERT(os.set_quantize(100) == STATUS_BAD_ARGUMENTS);
+        UTEST_ASSERT(os.set_quantize(quantize) == STATUS_OK);
+        UTEST_ASSERT(os.quantize() == quantize);
+        UTEST_ASSERT(os.open(&path, &info, codec) == STATUS_OK);
+
+        for (ssize_t off=0; off<FRAMES; off += BUF_SAMPLES)
+        {
+            // Check position
+            UTEST_ASSERT(os.position() == off);
+            ByteBuffer buf(&src[off * 2], BUF_SAMPLES * 2 * sizeof(float));
+            size_t to_write = ((FRAMES - off) > BUF_SAMPLES) ? BUF_SAMPLES : FRAMES-off;
+
+            // Write frames
+            ssize_t written = os.write(buf.data<mm::f32_t>(), to_write);
+            UTEST_ASSERT(written >= 0);
+            UTEST_ASSERT(buf.valid());
+        }
+
+        UTEST_ASSERT(os.close() == STATUS_OK);
+
+        validate_file(&path, src, srate, tol);
+    }
+
+    void test_write_planar(const char *file, const float *src, size_t codec, size_t srate, size_t format, float tol)
+    {
+        io::Path path;
+        UTEST_ASSERT(path.fmt("%s/%s-%s", tempdir(), full_name(), file));
+        printf("Writing PCM audio file %s as planar floating-point samples\n", path.as_native());
+
+        // De-interleave source samples
+        FloatBuffer l(FRAMES), r(FRAMES);
+        for (size_t i=0; i<FRAMES; ++i)
+        {
+            l[i]        = src[i*2];
+            r[i]        = src[i*2 + 1];
+        }
+
+        mm::OutAudioFileStream os;
+        mm::audio_stream_t info;
+        info.srate      = srate;
+        info.channels   = 2;
+        info.frames     = FRAMES;
+        info.format     = format;
+
+        UTEST_ASSERT(os.open(&path, &info, codec) == STATUS_OK);
+
+        for (ssize_t off=0; off<FRAMES; off += BUF_SAMPLES)
+        {
+            UTEST_ASSERT(os.position() == off);
+            const mm::f32_t *vp[2] = { &l[off], &r[off] };
+            size_t to_write = ((FRAMES - off) > BUF_SAMPLES) ? BUF_SAMPLES : FRAMES-off;
+
+            ssize_t written = os.write_planar(vp, to_write);
+            UTEST_ASSERT(written == ssize_t(to_write));
+        }
+
+        UTEST_ASSERT(os.close() == STATUS_OK);
+        UTEST_ASSERT(l.valid());
+        UTEST_ASSERT(r.valid());
+
+        validate_file(&path, src, srate, tol);
+
+        // Read the file back as planar samples, skip the left channel
+        mm::InAudioFileStream is;
+        FloatBuffer rr(FRAMES);
+        rr.fill_zero();
+        UTEST_ASSERT(is.open(&path) == STATUS_OK);
+
+        for (ssize_t off=0; off<FRAMES; )
+        {
+            mm::f32_t *vp[2] = { NULL, &rr[off] };
+            ssize_t read = is.read_planar(vp, BUF_SAMPLES);
+            UTEST_ASSERT(read > 0);
+            off        += read;
+            UTEST_ASSERT(is.position() == off);
+        }
+        UTEST_ASSERT(is.read_planar(NULL, BUF_SAMPLES) == -STATUS_BAD_ARGUMENTS);
+        UTEST_ASSERT(is.close() == STATUS_OK);
+        UTEST_ASSERT(rr.valid());
+
+        for (size_t i=0; i<FRAMES; ++i)
+            UTEST_ASSERT_MSG(float_equals_absolute(r[i], rr[i], tol), "Samples for channel 1[%d] differ: exp=%e, act=%e", int(i), r[i], rr[i]);
+    }
+
     UTEST_MAIN
     {
         // Generate buffer
@@ -202,6 +300,11 @@ UTEST_BEGIN("runtime.mm", outaudiofilestream)
         test_write_f32("pcm-f32.wav", buf, mm::AFMT_WAV | mm::CFMT_PCM, 48000, 1e-5f);
         test_write_s16("pcm-s16.wav", buf, mm::AFMT_WAV | mm::CFMT_PCM, 48000, 5e-5);
         test_write_u16("pcm-u16.wav", buf, mm::AFMT_WAV | mm::CFMT_PCM, 48000, 5e-5);
+        test_write_quantized("pcm-round.wav", buf, mm::AFMT_WAV | mm::CFMT_PCM, 48000, mm::QUANTIZE_ROUND, 2e-5);
+        test_write_quantized("pcm-dither.wav", buf, mm::AFMT_WAV | mm::CFMT_PCM, 48000, mm::QUANTIZE_DITHER, 6e-5);
+        test_write_planar("pcm-planar-f32.wav", buf, mm::AFMT_WAV | mm::CFMT_PCM, 48000, mm::SFMT_F32, 1e-5f);
+        test_write_planar("pcm-planar-s16.wav", buf, mm::AFMT_WAV | mm::CFMT_PCM, 48000, mm::SFMT_S16, 5e-5);
+        test_write_planar("pcm-planar-s24.wav", buf, mm::AFMT_WAV | mm::CFMT_PCM, 48000, mm::SFMT_S24, 1e-5f);
 
         // Call tests
         test_write_f32("alaw-f32.wav", buf, mm::AFMT_WAV | mm::CFMT_ALAW, 48000, 3e-2);
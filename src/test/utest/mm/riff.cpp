@@ -0,0 +1,296 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 30 мар. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/test-fw/utest.h>
+#include <lsp-plug.in/test-fw/ByteBuffer.h>
+#include <lsp-plug.in/common/endian.h>
+#include <lsp-plug.in/io/NativeFile.h>
+#include <private/mm/riff.h>
+#include <private/mm/RIFFReader.h>
+#include <private/mm/RIFFWriter.h>
+
+#define FRAMES          1001
+#define BLOCK           0x7f
+
+UTEST_BEGIN("runtime.mm", riff)
+
+    void check_data(mm::RIFFReader *rd, ByteBuffer &data, size_t bytes)
+    {
+        const uint8_t *src  = data.data<uint8_t>();
+        size_t fsize        = rd->frame_size();
+        ByteBuffer tmp(BLOCK * fsize);
+
+        // Read the whole data by blocks
+        UTEST_ASSERT(rd->seek(0) == 0);
+        for (size_t off=0; off < bytes; )
+        {
+            ssize_t n = rd->read(tmp.data(), BLOCK * fsize);
+            UTEST_ASSERT(n > 0);
+            UTEST_ASSERT(::memcmp(tmp.data(), &src[off], n) == 0);
+            off    += n;
+        }
+        UTEST_ASSERT(rd->read(tmp.data(), fsize) == -STATUS_EOF);
+        UTEST_ASSERT(tmp.valid());
+
+        // Read data after seek
+        size_t pos = (FRAMES / 3) * fsize;
+        UTEST_ASSERT(rd->seek(pos) == wssize_t(pos));
+        UTEST_ASSERT(rd->read(tmp.data(), fsize * 3) == ssize_t(fsize * 3));
+        UTEST_ASSERT(::memcmp(tmp.data(), &src[pos], fsize * 3) == 0);
+        UTEST_ASSERT(rd->seek(bytes + 100) == wssize_t(bytes));
+
+        // Fetch the data directly from memory
+        if (!rd->mapped())
+        {
+            const void *ptr;
+            UTEST_ASSERT(rd->fetch(&ptr, fsize) == -STATUS_NOT_SUPPORTED);
+            return;
+        }
+
+        UTEST_ASSERT(rd->seek(0) == 0);
+        for (size_t off=0; off < bytes; )
+        {
+            const void *ptr = NULL;
+            ssize_t n = rd->fetch(&ptr, BLOCK * fsize);
+            UTEST_ASSERT(n > 0);
+            UTEST_ASSERT(::memcmp(ptr, &src[off], n) == 0);
+            off    += n;
+        }
+    }
+
+    void test_format(size_t format, size_t channels, size_t expected, size_t ssize, bool mmap)
+    {
+        io::Path path;
+        UTEST_ASSERT(path.fmt("%s/utest-%s-%x-%d.wav", tempdir(), full_name(), int(format), int(channels)) > 0);
+        printf("Testing format=0x%x, channels=%d, mmap=%s\n", int(format), int(channels), (mmap) ? "true" : "false");
+
+        size_t fsize    = ssize * channels;
+        size_t bytes    = fsize * FRAMES;
+        ByteBuffer data(bytes);
+        data.randomize();
+
+        // Write the file by blocks
+        mm::audio_stream_t fmt;
+        fmt.srate       = 44100;
+        fmt.channels    = channels;
+        fmt.frames      = -1;
+        fmt.format      = format;
+
+        mm::RIFFWriter wr;
+        UTEST_ASSERT(wr.open(path.as_string(), &fmt) == STATUS_OK);
+        UTEST_ASSERT(wr.format() == expected);
+        UTEST_ASSERT(wr.frame_size() == fsize);
+
+        for (size_t off=0; off < bytes; )
+        {
+            size_t count = lsp_min(size_t(BLOCK * fsize), bytes - off);
+            UTEST_ASSERT(wr.write(data.data<uint8_t>() + off, count) == ssize_t(count));
+            off    += count;
+        }
+        UTEST_ASSERT(wr.frames() == FRAMES);
+
+        // Overwrite some data after seek
+        uint8_t *src = data.data<uint8_t>();
+        for (size_t i=0; i<fsize; ++i)
+            src[fsize * 10 + i] ^= 0x5a;
+        UTEST_ASSERT(wr.seek(fsize * 10) == wssize_t(fsize * 10));
+        UTEST_ASSERT(wr.write(&src[fsize * 10], fsize) == ssize_t(fsize));
+        UTEST_ASSERT(wr.seek(bytes * 2) == wssize_t(bytes));
+        UTEST_ASSERT(wr.frames() == FRAMES);
+        UTEST_ASSERT(wr.close() == STATUS_OK);
+
+        // Read the file
+        mm::RIFFReader rd;
+        UTEST_ASSERT(rd.open(path.as_string(), mmap) == STATUS_OK);
+        UTEST_ASSERT(rd.mapped() == mmap);
+        UTEST_ASSERT(rd.format() == expected);
+        UTEST_ASSERT(rd.channels() == channels);
+        UTEST_ASSERT(rd.sample_rate() == 44100);
+        UTEST_ASSERT(rd.frame_size() == fsize);
+        UTEST_ASSERT(rd.frames() == FRAMES);
+
+        check_data(&rd, data, bytes);
+
+        UTEST_ASSERT(rd.close() == STATUS_OK);
+        UTEST_ASSERT(rd.read(data.data(), fsize) == -STATUS_CLOSED);
+        UTEST_ASSERT(data.valid());
+    }
+
+    void append(ByteBuffer &buf, size_t &off, const void *data, size_t size)
+    {
+        ::memcpy(buf.data<uint8_t>() + off, data, size);
+        off    += size;
+    }
+
+    void append_chunk(ByteBuffer &buf, size_t &off, uint32_t id, uint32_t size)
+    {
+        mm::riff_chunk_t chunk;
+        chunk.id    = CPU_TO_LE(id);
+        chunk.size  = CPU_TO_LE(size);
+        append(buf, off, &chunk, sizeof(chunk));
+    }
+
+    void test_hand_made(bool mmap)
+    {
+        io::Path path;
+        UTEST_ASSERT(path.fmt("%s/utest-%s-hand-made.wav", tempdir(), full_name()) > 0);
+        printf("Testing hand-made file, mmap=%s\n", (mmap) ? "true" : "false");
+
+        // Build the file that contains extensible format, additional chunks with padding,
+        // invalid size of the data chunk and incomplete frame at the end
+        ByteBuffer buf(0x1000);
+        ByteBuffer data(FRAMES * 3 * 3);
+        data.randomize();
+        size_t off = 0;
+
+        mm::riff_header_t hdr;
+        hdr.chunk.id    = CPU_TO_LE(uint32_t(mm::RIFF_ID_RIFF));
+        hdr.chunk.size  = CPU_TO_LE(uint32_t(0xffffffff));
+        hdr.type        = CPU_TO_LE(uint32_t(mm::RIFF_ID_WAVE));
+        append(buf, off, &hdr, sizeof(hdr));
+
+        append_chunk(buf, off, RIFF_FOURCC('J', 'U', 'N', 'K'), 3);
+        append(buf, off, "abc\0", 4);
+
+        mm::wav_format_t fmt;
+        ::memset(&fmt, 0, sizeof(fmt));
+        fmt.format_tag      = CPU_TO_LE(uint16_t(mm::WAV_FORMAT_EXTENSIBLE));
+        fmt.channels        = CPU_TO_LE(uint16_t(3));
+        fmt.srate           = CPU_TO_LE(uint32_t(96000));
+        fmt.byte_rate       = CPU_TO_LE(uint32_t(96000 * 9));
+        fmt.block_align     = CPU_TO_LE(uint16_t(9));
+        fmt.bits            = CPU_TO_LE(uint16_t(24));
+        fmt.ext_size        = CPU_TO_LE(uint16_t(22));
+        fmt.valid_bits      = CPU_TO_LE(uint16_t(20));
+        fmt.sub_format[0]   = mm::WAV_FORMAT_PCM;
+        ::memcpy(&fmt.sub_format[2], mm::wav_subformat_guid, sizeof(mm::wav_subformat_guid));
+        append_chunk(buf, off, mm::RIFF_ID_FMT, sizeof(fmt));
+        append(buf, off, &fmt, sizeof(fmt));
+
+        append_chunk(buf, off, RIFF_FOURCC('L', 'I', 'S', 'T'), 5);
+        append(buf, off, "12345\0", 6);
+
+        append_chunk(buf, off, mm::RIFF_ID_DATA, 0xffffffff);
+
+        io::NativeFile fd;
+        UTEST_ASSERT(fd.open(&path, io::File::FM_WRITE_NEW) == STATUS_OK);
+        UTEST_ASSERT(fd.write(buf.data(), off) == ssize_t(off));
+        UTEST_ASSERT(fd.write(data.data(), FRAMES * 9 + 4) == FRAMES * 9 + 4);
+        UTEST_ASSERT(fd.close() == STATUS_OK);
+
+        mm::RIFFReader rd;
+        UTEST_ASSERT(rd.open(path.as_string(), mmap) == STATUS_OK);
+        UTEST_ASSERT(rd.format() == mm::SFMT_S24_LE);
+        UTEST_ASSERT(rd.channels() == 3);
+        UTEST_ASSERT(rd.sample_rate() == 96000);
+        UTEST_ASSERT(rd.frame_size() == 9);
+        UTEST_ASSERT(rd.frames() == FRAMES);
+
+        check_data(&rd, data, FRAMES * 9);
+
+        UTEST_ASSERT(rd.close() == STATUS_OK);
+        UTEST_ASSERT(buf.valid());
+    }
+
+    void test_resource(bool mmap)
+    {
+        io::Path path;
+        UTEST_ASSERT(path.fmt("%s/mm/pcm.wav", resources()) > 0);
+        printf("Testing resource file %s, mmap=%s\n", path.as_native(), (mmap) ? "true" : "false");
+
+        mm::RIFFReader rd;
+        UTEST_ASSERT(rd.open(path.as_string(), mmap) == STATUS_OK);
+        UTEST_ASSERT(rd.format() == mm::SFMT_S16_LE);
+        UTEST_ASSERT(rd.channels() == 2);
+        UTEST_ASSERT(rd.sample_rate() == 48000);
+        UTEST_ASSERT(rd.frames() == 2048);
+
+        // The first frame of the file is known
+        int16_t frame[2];
+        UTEST_ASSERT(rd.read(frame, sizeof(frame)) == sizeof(frame));
+        UTEST_ASSERT(LE_TO_CPU(frame[0]) == 0);
+        UTEST_ASSERT(LE_TO_CPU(frame[1]) == 0x7fff);
+
+        UTEST_ASSERT(rd.close() == STATUS_OK);
+    }
+
+    void test_errors()
+    {
+        io::Path path;
+        mm::RIFFReader rd;
+
+        printf("Testing errors\n");
+
+        // Non-existing file
+        UTEST_ASSERT(path.fmt("%s/utest-%s-missing.wav", tempdir(), full_name()) > 0);
+        UTEST_ASSERT(rd.open(path.as_string()) == STATUS_NOT_FOUND);
+        UTEST_ASSERT(rd.open(path.as_string(), false) == STATUS_NOT_FOUND);
+
+        // Not a WAV file
+        UTEST_ASSERT(path.fmt("%s/utest-%s-text.wav", tempdir(), full_name()) > 0);
+        io::NativeFile fd;
+        UTEST_ASSERT(fd.open(&path, io::File::FM_WRITE_NEW) == STATUS_OK);
+        UTEST_ASSERT(fd.write("This is not a WAV file", 22) == 22);
+        UTEST_ASSERT(fd.close() == STATUS_OK);
+        UTEST_ASSERT(rd.open(path.as_string()) == STATUS_BAD_FORMAT);
+        UTEST_ASSERT(rd.open(path.as_string(), false) == STATUS_BAD_FORMAT);
+
+        // Compressed WAV file
+        UTEST_ASSERT(path.fmt("%s/mm/alaw.wav", resources()) > 0);
+        UTEST_ASSERT(rd.open(path.as_string()) == STATUS_UNSUPPORTED_FORMAT);
+
+        // Unsupported output format
+        mm::RIFFWriter wr;
+        mm::audio_stream_t fmt;
+        fmt.srate       = 44100;
+        fmt.channels    = 2;
+        fmt.frames      = -1;
+        fmt.format      = mm::SFMT_F32_BE;
+        UTEST_ASSERT(mm::RIFFWriter::select_format(mm::SFMT_F32_BE) == mm::SFMT_NONE);
+        UTEST_ASSERT(wr.open(path.as_string(), &fmt) == STATUS_UNSUPPORTED_FORMAT);
+        UTEST_ASSERT(wr.write(&fmt, 4) == -STATUS_CLOSED);
+    }
+
+    UTEST_MAIN
+    {
+        for (size_t i=0; i<2; ++i)
+        {
+            bool mmap = (i == 0);
+
+            test_format(mm::SFMT_U8, 1, mm::SFMT_U8_LE, 1, mmap);
+            test_format(mm::SFMT_S8, 2, mm::SFMT_U8_LE, 1, mmap);
+            test_format(mm::SFMT_S16, 2, mm::SFMT_S16_LE, 2, mmap);
+            test_format(mm::SFMT_U16_LE, 1, mm::SFMT_S16_LE, 2, mmap);
+            test_format(mm::SFMT_S24_LE, 1, mm::SFMT_S24_LE, 3, mmap);
+            test_format(mm::SFMT_S32_DFL, 2, mm::SFMT_S32_LE, 4, mmap);
+            test_format(mm::SFMT_F32, 2, mm::SFMT_F32_LE, 4, mmap);
+            test_format(mm::SFMT_F64_LE, 1, mm::SFMT_F64_LE, 8, mmap);
+            test_format(mm::SFMT_S16, 6, mm::SFMT_S16_LE, 2, mmap);
+            test_format(mm::SFMT_F32, 3, mm::SFMT_F32_LE, 4, mmap);
+
+            test_hand_made(mmap);
+            test_resource(mmap);
+        }
+
+        test_errors();
+    }
+
+UTEST_END
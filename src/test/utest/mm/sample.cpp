@@ -22,6 +22,9 @@
 #include <lsp-plug.in/test-fw/utest.h>
 #include <lsp-plug.in/test-fw/ByteBuffer.h>
 #include <lsp-plug.in/mm/sample.h>
+#include <lsp-plug.in/stdlib/math.h>
+
+#include <private/mm/cvt.h>
 
 namespace lsp
 {
@@ -382,6 +385,622 @@ UTEST_BEGIN("runtime.mm", sample)
         #undef CVT
     }
 
+    void test_kernels()
+    {
+        typedef struct kernel_t
+        {
+            const char             *name;
+            mm::cvt_sample_t        mm::cvt_kernels_t::*func;
+            size_t                  ssize;
+            size_t                  dsize;
+            int                     sfloat;     // 0 - integer, 1 - f32, 2 - f64
+        } kernel_t;
+
+        static const kernel_t kernels[] =
+        {
+            { "u8_to_f32",  &mm::cvt_kernels_t::u8_to_f32,    1, 4, 0 },
+            { "s16_to_f32", &mm::cvt_kernels_t::s16_to_f32,   2, 4, 0 },
+            { "s24_to_f32", &mm::cvt_kernels_t::s24_to_f32,   3, 4, 0 },
+            { "s32_to_f32", &mm::cvt_kernels_t::s32_to_f32,   4, 4, 0 },
+            { "f64_to_f32", &mm::cvt_kernels_t::f64_to_f32,   8, 4, 2 },
+            { "f32_to_u8",  &mm::cvt_kernels_t::f32_to_u8,    4, 1, 1 },
+            { "f32_to_s16", &mm::cvt_kernels_t::f32_to_s16,   4, 2, 1 },
+            { "f32_to_s24", &mm::cvt_kernels_t::f32_to_s24,   4, 3, 1 },
+            { "f32_to_s32", &mm::cvt_kernels_t::f32_to_s32,   4, 4, 1 },
+            { "f32_to_f64", &mm::cvt_kernels_t::f32_to_f64,   4, 8, 1 },
+            { "xs16_to_f32", &mm::cvt_kernels_t::xs16_to_f32, 2, 4, 0 },
+            { "xs24_to_f32", &mm::cvt_kernels_t::xs24_to_f32, 3, 4, 0 },
+            { "xs32_to_f32", &mm::cvt_kernels_t::xs32_to_f32, 4, 4, 0 },
+            { "f32_to_xs16", &mm::cvt_kernels_t::f32_to_xs16, 4, 2, 1 },
+            { "f32_to_xs24", &mm::cvt_kernels_t::f32_to_xs24, 4, 3, 1 },
+            { "f32_to_xs32", &mm::cvt_kernels_t::f32_to_xs32, 4, 4, 1 },
+            { "swap_f32",   &mm::cvt_kernels_t::swap_f32,     4, 4, 1 },
+        };
+
+        const mm::cvt_kernels_t *sets[8];
+        size_t nsets = mm::cvt_supported_kernels(sets, sizeof(sets)/sizeof(sets[0]));
+        UTEST_ASSERT(nsets > 0);
+        UTEST_ASSERT(sets[0] == &mm::generic::kernels);
+        UTEST_ASSERT(mm::cvt_kernels() == sets[nsets - 1]);
+
+        for (size_t i=1; i<nsets; ++i)
+        {
+            const mm::cvt_kernels_t *set = sets[i];
+
+            for (size_t j=0; j<sizeof(kernels)/sizeof(kernel_t); ++j)
+            {
+                const kernel_t *k = &kernels[j];
+                printf("  checking %s::%s...\n", set->name, k->name);
+
+                // Check all lengths around the block sizes and buffers not aligned to the vector size
+                for (size_t n=0; n<=0x50; ++n)
+                {
+                    size_t soff     = (n & 0x3) * k->ssize;
+                    size_t doff     = (n & 0x3) * k->dsize;
+                    ByteBuffer sb(n * k->ssize + soff);
+                    ByteBuffer gb(n * k->dsize + doff);
+                    ByteBuffer db(n * k->dsize + doff);
+
+                    uint8_t *src    = &sb.data<uint8_t>()[soff];
+                    for (size_t l=0; l<n; ++l)
+                    {
+                        if (k->sfloat == 1)
+                            reinterpret_cast<mm::f32_t *>(src)[l] = (float(rand()) / RAND_MAX) * 2.0f - 1.0f;
+                        else if (k->sfloat == 2)
+                            reinterpret_cast<mm::f64_t *>(src)[l] = (double(rand()) / RAND_MAX) * 2.0 - 1.0;
+                        else
+                            for (size_t b=0; b<k->ssize; ++b)
+                                src[l * k->ssize + b]   = uint8_t(rand());
+                    }
+                    gb.fill_zero();
+                    db.fill_zero();
+
+                    (mm::generic::kernels.*(k->func))(&gb.data<uint8_t>()[doff], src, n);
+                    (set->*(k->func))(&db.data<uint8_t>()[doff], src, n);
+
+                    UTEST_ASSERT(sb.valid());
+                    UTEST_ASSERT(gb.valid());
+                    UTEST_ASSERT(db.valid());
+                    UTEST_ASSERT_MSG(::memcmp(gb.data<uint8_t>(), db.data<uint8_t>(), n * k->dsize + doff) == 0, "%s::%s failed for %d samples", set->name, k->name, int(n));
+                }
+            }
+        }
+    }
+
+    void test_saturate_kernels()
+    {
+        // NaN values should be saturated to the upper bound by all implementations
+        static const mm::f32_t src[] = { 1.0f, -1.0f, 1.5f, -1.5f, INFINITY, -INFINITY, 0.5f, 0.0f, NAN };
+        static const int32_t exp[] = { 0x7fffffff, -0x7fffffff, 0x7fffffff, -0x7fffffff, 0x7fffffff, -0x7fffffff, 0x3fffffff, 0, 0x7fffffff };
+        static const size_t m = sizeof(src) / sizeof(src[0]);
+        static const size_t n = 0x25;
+        mm::f32_t xs[n];
+        mm::f64_t xd[n];
+        int32_t s32[n], x32[n];
+        uint32_t u32[n];
+
+        for (size_t i=0; i<n; ++i)
+        {
+            xs[i]   = src[i % m];
+            xd[i]   = src[i % m];
+        }
+
+        // Check all kernel sets
+        const mm::cvt_kernels_t *sets[8];
+        size_t nsets = mm::cvt_supported_kernels(sets, sizeof(sets)/sizeof(sets[0]));
+        for (size_t i=0; i<nsets; ++i)
+        {
+            const mm::cvt_kernels_t *set = sets[i];
+            printf("  checking saturation of %s kernels...\n", set->name);
+
+            set->f32_to_s32(s32, xs, n);
+            set->f32_to_xs32(x32, xs, n);
+            for (size_t j=0; j<n; ++j)
+            {
+                UTEST_ASSERT_MSG(s32[j] == exp[j % m], "%s::f32_to_s32: src=%f, dst=%d, exp=%d",
+                    set->name, xs[j], int(s32[j]), int(exp[j % m]));
+                UTEST_ASSERT_MSG(int32_t(byte_swap(uint32_t(x32[j]))) == exp[j % m], "%s::f32_to_xs32: src=%f",
+                    set->name, xs[j]);
+            }
+        }
+
+        // Check conversion of samples
+        UTEST_ASSERT(mm::convert_samples(s32, xs, n, mm::SFMT_S32_CPU, mm::SFMT_F32_CPU));
+        for (size_t j=0; j<n; ++j)
+            UTEST_ASSERT_MSG(s32[j] == exp[j % m], "f32 -> s32: src=%f, dst=%d", xs[j], int(s32[j]));
+        UTEST_ASSERT(mm::convert_samples(s32, xd, n, mm::SFMT_S32_CPU, mm::SFMT_F64_CPU));
+        for (size_t j=0; j<n; ++j)
+            UTEST_ASSERT_MSG(s32[j] == exp[j % m], "f64 -> s32: src=%f, dst=%d", xd[j], int(s32[j]));
+        UTEST_ASSERT(mm::convert_samples(u32, xs, n, mm::SFMT_U32_CPU, mm::SFMT_F32_CPU));
+        for (size_t j=0; j<n; ++j)
+            UTEST_ASSERT_MSG(u32[j] == uint32_t(exp[j % m]) + 0x80000000U, "f32 -> u32: src=%f, dst=0x%x", xs[j], unsigned(u32[j]));
+        UTEST_ASSERT(mm::convert_samples(u32, xd, n, mm::SFMT_U32_CPU, mm::SFMT_F64_CPU));
+        for (size_t j=0; j<n; ++j)
+            UTEST_ASSERT_MSG(u32[j] == uint32_t(exp[j % m]) + 0x80000000U, "f64 -> u32: src=%f, dst=0x%x", xd[j], unsigned(u32[j]));
+    }
+
+    static void reverse_bytes(uint8_t *buf, size_t samples, size_t size)
+    {
+        for (size_t i=0; i<samples; ++i, buf += size)
+            for (size_t l=0, h=size-1; l < h; ++l, --h)
+            {
+                uint8_t tmp     = buf[l];
+                buf[l]          = buf[h];
+                buf[h]          = tmp;
+            }
+    }
+
+    void test_swap_kernels()
+    {
+        typedef struct kernel_t
+        {
+            const char             *name;
+            mm::cvt_sample_t        mm::cvt_kernels_t::*func;
+            mm::cvt_sample_t        mm::cvt_kernels_t::*ref;    // Reference routine without byte order swap
+            size_t                  ssize;
+            size_t                  dsize;
+            bool                    sswap;      // Swap byte order of source (true) or destination (false)
+        } kernel_t;
+
+        static const kernel_t kernels[] =
+        {
+            { "xs16_to_f32", &mm::cvt_kernels_t::xs16_to_f32, &mm::cvt_kernels_t::s16_to_f32, 2, 4, true  },
+            { "xs24_to_f32", &mm::cvt_kernels_t::xs24_to_f32, &mm::cvt_kernels_t::s24_to_f32, 3, 4, true  },
+            { "xs32_to_f32", &mm::cvt_kernels_t::xs32_to_f32, &mm::cvt_kernels_t::s32_to_f32, 4, 4, true  },
+            { "f32_to_xs16", &mm::cvt_kernels_t::f32_to_xs16, &mm::cvt_kernels_t::f32_to_s16, 4, 2, false },
+            { "f32_to_xs24", &mm::cvt_kernels_t::f32_to_xs24, &mm::cvt_kernels_t::f32_to_s24, 4, 3, false },
+            { "f32_to_xs32", &mm::cvt_kernels_t::f32_to_xs32, &mm::cvt_kernels_t::f32_to_s32, 4, 4, false },
+        };
+
+        const mm::cvt_kernels_t *sets[8];
+        size_t nsets = mm::cvt_supported_kernels(sets, sizeof(sets)/sizeof(sets[0]));
+
+        for (size_t i=0; i<nsets; ++i)
+        {
+            const mm::cvt_kernels_t *set = sets[i];
+
+            for (size_t j=0; j<sizeof(kernels)/sizeof(kernel_t); ++j)
+            {
+                const kernel_t *k = &kernels[j];
+                printf("  checking %s::%s...\n", set->name, k->name);
+
+                for (size_t n=0; n<=0x50; ++n)
+                {
+                    ByteBuffer sb(n * k->ssize);
+                    ByteBuffer xb(n * k->ssize);
+                    ByteBuffer gb(n * k->dsize);
+                    ByteBuffer db(n * k->dsize);
+
+                    uint8_t *src    = sb.data<uint8_t>();
+                    for (size_t l=0; l<n; ++l)
+                    {
+                        if (k->sswap)
+                            for (size_t b=0; b<k->ssize; ++b)
+                                src[l * k->ssize + b]   = uint8_t(rand());
+                        else
+                            sb.data<mm::f32_t>()[l] = (float(rand()) / RAND_MAX) * 2.0f - 1.0f;
+                    }
+                    gb.fill_zero();
+                    db.fill_zero();
+
+                    // Compute the reference result
+                    if (k->sswap)
+                    {
+                        ::memcpy(xb.data<uint8_t>(), src, n * k->ssize);
+                        reverse_bytes(xb.data<uint8_t>(), n, k->ssize);
+                        (mm::generic::kernels.*(k->ref))(gb.data<uint8_t>(), xb.data<uint8_t>(), n);
+                    }
+                    else
+                    {
+                        (mm::generic::kernels.*(k->ref))(gb.data<uint8_t>(), src, n);
+                        reverse_bytes(gb.data<uint8_t>(), n, k->dsize);
+                    }
+
+                    (set->*(k->func))(db.data<uint8_t>(), src, n);
+
+                    UTEST_ASSERT(sb.valid());
+                    UTEST_ASSERT(xb.valid());
+                    UTEST_ASSERT(gb.valid());
+                    UTEST_ASSERT(db.valid());
+                    UTEST_ASSERT_MSG(::memcmp(gb.data<uint8_t>(), db.data<uint8_t>(), n * k->dsize) == 0, "%s::%s failed for %d samples", set->name, k->name, int(n));
+                }
+            }
+
+            // Plain byte order swap
+            printf("  checking %s::swap_f32...\n", set->name);
+            for (size_t n=0; n<=0x50; ++n)
+            {
+                ByteBuffer sb(n * sizeof(mm::f32_t));
+                ByteBuffer db(n * sizeof(mm::f32_t));
+                sb.randomize();
+
+                (set->swap_f32)(db.data<uint8_t>(), sb.data<uint8_t>(), n);
+                reverse_bytes(db.data<uint8_t>(), n, sizeof(mm::f32_t));
+
+                UTEST_ASSERT(sb.valid());
+                UTEST_ASSERT(db.valid());
+                UTEST_ASSERT_MSG(::memcmp(sb.data<uint8_t>(), db.data<uint8_t>(), n * sizeof(mm::f32_t)) == 0, "%s::swap_f32 failed for %d samples", set->name, int(n));
+            }
+        }
+    }
+
+    void test_planar_kernels()
+    {
+        static const size_t MAX_CHANNELS = 3;
+
+        const mm::cvt_kernels_t *sets[8];
+        size_t nsets = mm::cvt_supported_kernels(sets, sizeof(sets)/sizeof(sets[0]));
+
+        for (size_t i=1; i<nsets; ++i)
+        {
+            const mm::cvt_kernels_t *set = sets[i];
+            printf("  checking %s planar routines...\n", set->name);
+
+            // Check different number of channels, the second channel may be missing
+            for (size_t ch=1; ch <= MAX_CHANNELS + 1; ++ch)
+            {
+                size_t channels = lsp_min(ch, MAX_CHANNELS);
+                bool skip       = ch > MAX_CHANNELS;
+
+                for (size_t n=0; n<=0x50; ++n)
+                {
+                    size_t off      = n & 0x3;
+                    ByteBuffer ib(n * channels * sizeof(int16_t));
+                    ByteBuffer fb(n * channels * sizeof(mm::f32_t));
+                    ByteBuffer gb(n * channels * sizeof(mm::f32_t));
+                    ByteBuffer db(n * channels * sizeof(mm::f32_t));
+                    ByteBuffer pb((n + off) * channels * sizeof(mm::f32_t));
+                    ByteBuffer qb((n + off) * channels * sizeof(mm::f32_t));
+
+                    mm::f32_t *pg[MAX_CHANNELS], *pd[MAX_CHANNELS];
+                    for (size_t j=0; j<channels; ++j)
+                    {
+                        pg[j]   = &pb.data<mm::f32_t>()[j * (n + off)];
+                        pd[j]   = &qb.data<mm::f32_t>()[j * (n + off)];
+                    }
+                    if (skip)
+                        pg[1] = pd[1] = NULL;
+
+                    ib.randomize();
+                    for (size_t j=0; j<n*channels; ++j)
+                        fb.data<mm::f32_t>()[j] = (float(rand()) / RAND_MAX) * 2.0f - 1.0f;
+
+                    // De-interleaving of 16-bit samples
+                    pb.fill_zero();
+                    qb.fill_zero();
+                    mm::generic::kernels.s16_to_f32_planar(pg, off, ib.data(), channels, n);
+                    set->s16_to_f32_planar(pd, off, ib.data(), channels, n);
+                    UTEST_ASSERT_MSG(::memcmp(pb.data(), qb.data(), (n + off) * channels * sizeof(mm::f32_t)) == 0, "%s::s16_to_f32_planar failed for %d channels, %d frames", set->name, int(channels), int(n));
+
+                    // De-interleaving of floating-point samples
+                    pb.fill_zero();
+                    qb.fill_zero();
+                    mm::generic::kernels.f32_to_f32_planar(pg, off, fb.data(), channels, n);
+                    set->f32_to_f32_planar(pd, off, fb.data(), channels, n);
+                    UTEST_ASSERT_MSG(::memcmp(pb.data(), qb.data(), (n + off) * channels * sizeof(mm::f32_t)) == 0, "%s::f32_to_f32_planar failed for %d channels, %d frames", set->name, int(channels), int(n));
+
+                    // Interleaving of floating-point samples
+                    for (size_t j=0; j<channels; ++j)
+                        if (pg[j] != NULL)
+                            for (size_t k=0; k<n; ++k)
+                                pg[j][k + off]  = fb.data<mm::f32_t>()[j*n + k];
+
+                    gb.fill_zero();
+                    db.randomize();
+                    mm::generic::kernels.f32_planar_to_f32(gb.data(), pg, off, channels, n);
+                    set->f32_planar_to_f32(db.data(), pg, off, channels, n);
+                    UTEST_ASSERT_MSG(::memcmp(gb.data(), db.data(), n * channels * sizeof(mm::f32_t)) == 0, "%s::f32_planar_to_f32 failed for %d channels, %d frames", set->name, int(channels), int(n));
+
+                    gb.fill_zero();
+                    db.randomize();
+                    mm::generic::kernels.f32_planar_to_s16(gb.data(), pg, off, channels, n);
+                    set->f32_planar_to_s16(db.data(), pg, off, channels, n);
+                    UTEST_ASSERT_MSG(::memcmp(gb.data(), db.data(), n * channels * sizeof(int16_t)) == 0, "%s::f32_planar_to_s16 failed for %d channels, %d frames", set->name, int(channels), int(n));
+
+                    UTEST_ASSERT(ib.valid());
+                    UTEST_ASSERT(fb.valid());
+                    UTEST_ASSERT(gb.valid());
+                    UTEST_ASSERT(db.valid());
+                    UTEST_ASSERT(pb.valid());
+                    UTEST_ASSERT(qb.valid());
+                }
+            }
+        }
+
+        // Check the generic implementation against the plain conversion
+        int16_t s[6]        = { 0x7fff, -0x7fff, 0x4000, 0, -0x4000, 0x1234 };
+        mm::f32_t l[3], r[3], e[6];
+        mm::f32_t *vp[2]    = { l, r };
+        mm::generic::kernels.s16_to_f32(e, s, 6);
+        mm::generic::kernels.s16_to_f32_planar(vp, 0, s, 2, 3);
+        for (size_t i=0; i<3; ++i)
+        {
+            UTEST_ASSERT(l[i] == e[i*2]);
+            UTEST_ASSERT(r[i] == e[i*2 + 1]);
+        }
+    }
+
+    void test_dot_kernels()
+    {
+        const mm::cvt_kernels_t *sets[8];
+        size_t nsets = mm::cvt_supported_kernels(sets, sizeof(sets)/sizeof(sets[0]));
+
+        for (size_t i=1; i<nsets; ++i)
+        {
+            const mm::cvt_kernels_t *set = sets[i];
+            printf("  checking %s::dot_f32...\n", set->name);
+
+            for (size_t n=0; n<=0x50; ++n)
+            {
+                // Check unaligned data
+                size_t off      = n & 0x3;
+                ByteBuffer ab((n + off) * sizeof(mm::f32_t));
+                ByteBuffer bb((n + off) * sizeof(mm::f32_t));
+                mm::f32_t *a    = &ab.data<mm::f32_t>()[off];
+                mm::f32_t *b    = &bb.data<mm::f32_t>()[off];
+
+                for (size_t j=0; j<n; ++j)
+                {
+                    a[j]            = (float(rand()) / RAND_MAX) * 2.0f - 1.0f;
+                    b[j]            = (float(rand()) / RAND_MAX) * 2.0f - 1.0f;
+                }
+
+                // The order of summation differs, compare with tolerance
+                mm::f32_t g     = mm::generic::kernels.dot_f32(a, b, n);
+                mm::f32_t d     = set->dot_f32(a, b, n);
+                UTEST_ASSERT(ab.valid());
+                UTEST_ASSERT(bb.valid());
+                UTEST_ASSERT_MSG(fabs(g - d) <= 1e-5f * (n + 1), "%s::dot_f32 failed for %d elements: %f vs %f", set->name, int(n), g, d);
+            }
+        }
+
+        // Check the generic implementation
+        mm::f32_t a[5]      = { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f };
+        mm::f32_t b[5]      = { 0.5f, -1.0f, 2.0f, 0.0f, 1.0f };
+        UTEST_ASSERT(mm::generic::kernels.dot_f32(a, b, 0) == 0.0f);
+        UTEST_ASSERT(mm::generic::kernels.dot_f32(a, b, 5) == 9.5f);
+    }
+
+    void test_peak_kernels()
+    {
+        const mm::cvt_kernels_t *sets[8];
+        size_t nsets = mm::cvt_supported_kernels(sets, sizeof(sets)/sizeof(sets[0]));
+
+        for (size_t i=1; i<nsets; ++i)
+        {
+            const mm::cvt_kernels_t *set = sets[i];
+            printf("  checking %s::peak_f32...\n", set->name);
+
+            for (size_t n=0; n<=0x50; ++n)
+            {
+                // Check unaligned data
+                size_t off      = n & 0x3;
+                ByteBuffer sb((n + off) * sizeof(mm::f32_t));
+                mm::f32_t *src  = &sb.data<mm::f32_t>()[off];
+
+                for (size_t j=0; j<n; ++j)
+                    src[j]          = (float(rand()) / RAND_MAX) * 2.0f - 1.0f;
+
+                // Extremes can be at any position, the sum of squares is accumulated
+                mm::f32_t g[3]  = { 0.5f, -0.5f, 1.0f };
+                mm::f32_t d[3]  = { 0.5f, -0.5f, 1.0f };
+                mm::generic::kernels.peak_f32(g, src, n);
+                set->peak_f32(d, src, n);
+                UTEST_ASSERT(sb.valid());
+                UTEST_ASSERT_MSG((g[0] == d[0]) && (g[1] == d[1]),
+                    "%s::peak_f32 failed for %d elements: min %f vs %f, max %f vs %f",
+                    set->name, int(n), g[0], d[0], g[1], d[1]);
+                UTEST_ASSERT_MSG(fabs(g[2] - d[2]) <= 1e-5f * (n + 1),
+                    "%s::peak_f32 failed for %d elements: sum %f vs %f", set->name, int(n), g[2], d[2]);
+            }
+        }
+
+        // Check the generic implementation
+        mm::f32_t s[5]      = { 0.5f, -2.0f, 1.0f, 3.0f, 0.0f };
+        mm::f32_t p[3]      = { 0.0f, 0.0f, 1.0f };
+        mm::generic::kernels.peak_f32(p, s, 0);
+        UTEST_ASSERT((p[0] == 0.0f) && (p[1] == 0.0f) && (p[2] == 1.0f));
+        mm::generic::kernels.peak_f32(p, s, 5);
+        UTEST_ASSERT((p[0] == -2.0f) && (p[1] == 3.0f) && (p[2] == 15.25f));
+    }
+
+    void test_round_kernels()
+    {
+        typedef struct kernel_t
+        {
+            const char             *name;
+            mm::cvt_quant_t         mm::cvt_kernels_t::*func;
+            size_t                  dsize;
+        } kernel_t;
+
+        static const kernel_t kernels[] =
+        {
+            { "f32_to_u8_round",  &mm::cvt_kernels_t::f32_to_u8_round,    1 },
+            { "f32_to_s16_round", &mm::cvt_kernels_t::f32_to_s16_round,   2 },
+            { "f32_to_s24_round", &mm::cvt_kernels_t::f32_to_s24_round,   3 },
+            { "f32_to_s32_round", &mm::cvt_kernels_t::f32_to_s32_round,   4 },
+        };
+
+        const mm::cvt_kernels_t *sets[8];
+        size_t nsets = mm::cvt_supported_kernels(sets, sizeof(sets)/sizeof(sets[0]));
+
+        for (size_t i=1; i<nsets; ++i)
+        {
+            const mm::cvt_kernels_t *set = sets[i];
+
+            for (size_t j=0; j<sizeof(kernels)/sizeof(kernel_t); ++j)
+            {
+                const kernel_t *k = &kernels[j];
+                printf("  checking %s::%s...\n", set->name, k->name);
+
+                for (size_t n=0; n<=0x50; ++n)
+                {
+                    size_t soff     = (n & 0x3) * sizeof(mm::f32_t);
+                    size_t doff     = (n & 0x3) * k->dsize;
+                    ByteBuffer sb(n * sizeof(mm::f32_t) + soff);
+                    ByteBuffer gb(n * k->dsize + doff);
+                    ByteBuffer db(n * k->dsize + doff);
+
+                    // Generate samples slightly out of range to check clipping
+                    mm::f32_t *src  = reinterpret_cast<mm::f32_t *>(&sb.data<uint8_t>()[soff]);
+                    for (size_t l=0; l<n; ++l)
+                        src[l]          = (float(rand()) / RAND_MAX) * 2.5f - 1.25f;
+
+                    for (size_t dither=0; dither < 2; ++dither)
+                    {
+                        mm::cvt_dither_t gd, dd;
+                        mm::cvt_init_dither(&gd, n);
+                        mm::cvt_init_dither(&dd, n);
+
+                        gb.fill_zero();
+                        db.fill_zero();
+                        (mm::generic::kernels.*(k->func))(&gb.data<uint8_t>()[doff], src, n, (dither) ? &gd : NULL);
+                        (set->*(k->func))(&db.data<uint8_t>()[doff], src, n, (dither) ? &dd : NULL);
+
+                        UTEST_ASSERT(sb.valid());
+                        UTEST_ASSERT(gb.valid());
+                        UTEST_ASSERT(db.valid());
+                        UTEST_ASSERT_MSG(::memcmp(gb.data<uint8_t>(), db.data<uint8_t>(), n * k->dsize + doff) == 0,
+                            "%s::%s failed for %d samples, dither=%d", set->name, k->name, int(n), int(dither));
+                        UTEST_ASSERT_MSG(::memcmp(&gd, &dd, sizeof(mm::cvt_dither_t)) == 0,
+                            "%s::%s dither state differs for %d samples", set->name, k->name, int(n));
+                    }
+                }
+            }
+        }
+    }
+
+    void test_quantize()
+    {
+        static const mm::f32_t src[] =
+        {
+            1.5f, 1.0f, 0.6f / 0x7fff, 0.4f / 0x7fff, -0.4f / 0x7fff, -0.6f / 0x7fff, -1.0f, -1.5f
+        };
+        static const int16_t s16r[] = { 0x7fff, 0x7fff, 1, 0, 0, -1, -0x7fff, -0x8000 };
+        static const size_t n = sizeof(src) / sizeof(mm::f32_t);
+
+        mm::f32_t fbuf[n];
+        mm::f64_t dbuf[n];
+        int16_t s16[n];
+        uint16_t u16[n];
+
+        // Rounding of 32-bit floating-point samples
+        ::memcpy(fbuf, src, sizeof(fbuf));
+        UTEST_ASSERT(mm::convert_samples(s16, fbuf, n, mm::SFMT_S16_CPU, mm::SFMT_F32_CPU, mm::QUANTIZE_ROUND));
+        for (size_t i=0; i<n; ++i)
+            UTEST_ASSERT_MSG(s16[i] == s16r[i], "s16[%d]: %d vs %d", int(i), int(s16[i]), int(s16r[i]));
+
+        // Rounding of 64-bit floating-point samples to unsigned samples with opposite byte order
+        for (size_t i=0; i<n; ++i)
+            dbuf[i]     = src[i];
+        UTEST_ASSERT(mm::convert_samples(u16, dbuf, n, __IF_LEBE(mm::SFMT_U16_BE, mm::SFMT_U16_LE), mm::SFMT_F64_CPU, mm::QUANTIZE_ROUND));
+        for (size_t i=0; i<n; ++i)
+        {
+            uint16_t v  = byte_swap(u16[i]);
+            UTEST_ASSERT_MSG(v == uint16_t(s16r[i] + 0x8000), "u16[%d]: %d vs %d", int(i), int(v), int(s16r[i] + 0x8000));
+        }
+
+        // Rounding of 64-bit floating-point samples should keep full 32-bit resolution
+        static const mm::f64_t dsrc[] =
+        {
+            1.5, 1.0, 12345.6 / 0x7fffffff, -12345.4 / 0x7fffffff, 0x7ffffff3 / 2147483647.0, -1.0, -1.5
+        };
+        static const int32_t s32r[] = { 0x7fffffff, 0x7fffffff, 12346, -12345, 0x7ffffff3, -0x7fffffff, int32_t(-0x7fffffff - 1) };
+        static const size_t dn = sizeof(dsrc) / sizeof(mm::f64_t);
+
+        mm::f64_t d64[dn];
+        int32_t s32[dn];
+        uint32_t u32[dn];
+
+        ::memcpy(d64, dsrc, sizeof(d64));
+        UTEST_ASSERT(mm::convert_samples(s32, d64, dn, mm::SFMT_S32_CPU, mm::SFMT_F64_CPU, mm::QUANTIZE_ROUND));
+        for (size_t i=0; i<dn; ++i)
+            UTEST_ASSERT_MSG(s32[i] == s32r[i], "s32[%d]: %d vs %d", int(i), int(s32[i]), int(s32r[i]));
+
+        ::memcpy(d64, dsrc, sizeof(d64));
+        UTEST_ASSERT(mm::convert_samples(u32, d64, dn, mm::SFMT_U32_CPU, mm::SFMT_F64_CPU, mm::QUANTIZE_DITHER));
+        for (size_t i=0; i<dn; ++i)
+        {
+            int32_t v   = int32_t(u32[i] ^ 0x80000000);
+            int32_t d   = v - s32r[i];
+            UTEST_ASSERT_MSG((d >= -1) && (d <= 1), "u32[%d]: %d vs %d", int(i), int(v), int(s32r[i]));
+        }
+
+        // Truncation is kept by default
+        ::memcpy(fbuf, src, sizeof(fbuf));
+        UTEST_ASSERT(mm::convert_samples(s16, fbuf, n, mm::SFMT_S16_CPU, mm::SFMT_F32_CPU, mm::QUANTIZE_TRUNCATE));
+        UTEST_ASSERT(s16[2] == 0);
+        UTEST_ASSERT(!mm::convert_samples(s16, fbuf, n, mm::SFMT_S16_CPU, mm::SFMT_F32_CPU, 100));
+
+        // Dithered signal should keep the DC level below the least significant bit
+        ByteBuffer sb(0x10000 * sizeof(mm::f32_t));
+        ByteBuffer db(0x10000 * sizeof(int16_t));
+        mm::f32_t *fs   = sb.data<mm::f32_t>();
+        int16_t *ds     = db.data<int16_t>();
+        for (size_t i=0; i<0x10000; ++i)
+            fs[i]       = 0.3f / 0x7fff;
+
+        UTEST_ASSERT(mm::convert_samples(ds, fs, 0x10000, mm::SFMT_S16_CPU, mm::SFMT_F32_CPU, mm::QUANTIZE_DITHER));
+        UTEST_ASSERT(sb.valid());
+        UTEST_ASSERT(db.valid());
+
+        double sum = 0.0;
+        for (size_t i=0; i<0x10000; ++i)
+        {
+            UTEST_ASSERT_MSG((ds[i] >= -1) && (ds[i] <= 1), "ds[%d] = %d", int(i), int(ds[i]));
+            sum        += ds[i];
+        }
+        sum        /= 0x10000;
+        UTEST_ASSERT_MSG(fabs(sum - 0.3) < 0.02, "Average dithered value is %f", sum);
+    }
+
+    void test_foreign()
+    {
+        static const size_t n = 0x123;
+        const size_t foreign = __IF_LEBE(mm::SFMT_BE, mm::SFMT_LE);
+
+        ByteBuffer fb(n * sizeof(mm::f32_t));
+        ByteBuffer tb(n * sizeof(mm::f32_t));
+        ByteBuffer nb(n * sizeof(int32_t));
+        ByteBuffer xb(n * sizeof(int32_t));
+        ByteBuffer rb(n * sizeof(mm::f32_t));
+
+        mm::f32_t *fs = fb.data<mm::f32_t>();
+        for (size_t i=0; i<n; ++i)
+            fs[i]       = (float(rand()) / RAND_MAX) * 2.0f - 1.0f;
+
+        static const size_t formats[] = { mm::SFMT_U8, mm::SFMT_S16, mm::SFMT_U16, mm::SFMT_S24, mm::SFMT_S32, mm::SFMT_F32 };
+        for (size_t i=0; i<sizeof(formats)/sizeof(formats[0]); ++i)
+        {
+            size_t fmt      = formats[i];
+            size_t ssize    = mm::sformat_size_of(fmt);
+            size_t bytes    = (fmt == mm::SFMT_S24) ? 3 : ssize;
+            printf("  checking format %d...\n", int(fmt));
+
+            // Conversion to the foreign byte order should produce byte-reversed samples
+            ::memcpy(tb.data<uint8_t>(), fs, n * sizeof(mm::f32_t));
+            UTEST_ASSERT(mm::convert_samples(nb.data<uint8_t>(), tb.data<uint8_t>(), n, fmt | mm::SFMT_CPU, mm::SFMT_F32_CPU));
+            ::memcpy(tb.data<uint8_t>(), fs, n * sizeof(mm::f32_t));
+            UTEST_ASSERT(mm::convert_samples(xb.data<uint8_t>(), tb.data<uint8_t>(), n, fmt | foreign, mm::SFMT_F32_CPU));
+            UTEST_ASSERT(::memcmp(tb.data<uint8_t>(), fs, n * sizeof(mm::f32_t)) == 0);
+
+            reverse_bytes(xb.data<uint8_t>(), n, bytes);
+            UTEST_ASSERT_MSG(::memcmp(nb.data<uint8_t>(), xb.data<uint8_t>(), n * bytes) == 0, "Conversion to foreign format %d failed", int(fmt));
+
+            // Conversion from the foreign byte order should produce the same samples
+            reverse_bytes(xb.data<uint8_t>(), n, bytes);
+            UTEST_ASSERT(mm::convert_samples(tb.data<uint8_t>(), nb.data<uint8_t>(), n, mm::SFMT_F32_CPU, fmt | mm::SFMT_CPU));
+            UTEST_ASSERT(mm::convert_samples(rb.data<uint8_t>(), xb.data<uint8_t>(), n, mm::SFMT_F32_CPU, fmt | foreign));
+            UTEST_ASSERT_MSG(::memcmp(tb.data<uint8_t>(), rb.data<uint8_t>(), n * sizeof(mm::f32_t)) == 0, "Conversion from foreign format %d failed", int(fmt));
+        }
+
+        UTEST_ASSERT(fb.valid());
+        UTEST_ASSERT(tb.valid());
+        UTEST_ASSERT(nb.valid());
+        UTEST_ASSERT(xb.valid());
+        UTEST_ASSERT(rb.valid());
+    }
+
     UTEST_MAIN
     {
         #define CALL(func)  \
@@ -398,6 +1017,15 @@ UTEST_BEGIN("runtime.mm", sample)
         CALL(test_to_s32);
         CALL(test_to_f32);
         CALL(test_to_f64);
+        CALL(test_kernels);
+        CALL(test_swap_kernels);
+        CALL(test_saturate_kernels);
+        CALL(test_planar_kernels);
+        CALL(test_dot_kernels);
+        CALL(test_peak_kernels);
+        CALL(test_round_kernels);
+        CALL(test_quantize);
+        CALL(test_foreign);
     }
 UTEST_END;
 
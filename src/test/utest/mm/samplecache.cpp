@@ -0,0 +1,251 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 1 апр. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/test-fw/utest.h>
+#include <lsp-plug.in/test-fw/FloatBuffer.h>
+#include <lsp-plug.in/mm/SampleCache.h>
+#include <lsp-plug.in/mm/OutAudioFileStream.h>
+#include <lsp-plug.in/ipc/Thread.h>
+
+#define FRAMES          10000
+#define THREADS         8
+
+namespace
+{
+    typedef struct request_t
+    {
+        lsp::mm::SampleCache           *pCache;
+        const lsp::io::Path            *pPath;
+        lsp::mm::SampleCache::Sample   *pSample;
+        lsp::status_t                   nResult;
+    } request_t;
+
+    lsp::status_t acquire_proc(void *arg)
+    {
+        request_t *r    = static_cast<request_t *>(arg);
+        r->nResult      = r->pCache->acquire(&r->pSample, r->pPath, lsp::mm::SFMT_F32_CPU);
+        return lsp::STATUS_OK;
+    }
+}
+
+UTEST_BEGIN("runtime.mm", samplecache)
+
+    void write_file(const io::Path *path, FloatBuffer &buf, size_t frames)
+    {
+        printf("Writing audio file %s\n", path->as_native());
+
+        mm::audio_stream_t fmt;
+        fmt.srate       = 44100;
+        fmt.channels    = 2;
+        fmt.frames      = frames;
+        fmt.format      = mm::SFMT_F32;
+
+        mm::OutAudioFileStream os;
+        UTEST_ASSERT(os.open(path, &fmt, mm::AFMT_WAV | mm::CFMT_PCM) == STATUS_OK);
+        UTEST_ASSERT(os.write(buf.data(), frames) == ssize_t(frames));
+        UTEST_ASSERT(os.close() == STATUS_OK);
+    }
+
+    void check_stats(mm::SampleCache *cache, size_t hits, size_t misses, size_t evictions, size_t items, size_t used)
+    {
+        mm::SampleCache::stats_t st;
+        cache->get_stats(&st);
+        UTEST_ASSERT_MSG((st.hits == hits) && (st.misses == misses) && (st.evictions == evictions) &&
+                         (st.items == items) && (st.used == used),
+            "Statistics differ: hits=%d, misses=%d, evictions=%d, items=%d, used=%d",
+            int(st.hits), int(st.misses), int(st.evictions), int(st.items), int(st.used));
+    }
+
+    void test_basic(const io::Path *p1, const io::Path *p2, FloatBuffer &src)
+    {
+        printf("Testing basic functions\n");
+
+        mm::SampleCache cache;
+        mm::SampleCache::Sample *s1 = NULL, *s2 = NULL, *s3 = NULL, *s4 = NULL;
+
+        // Load the sample
+        UTEST_ASSERT(cache.acquire(&s1, p1, mm::SFMT_F32_CPU) == STATUS_OK);
+        UTEST_ASSERT(s1 != NULL);
+        UTEST_ASSERT(s1->channels() == 2);
+        UTEST_ASSERT(s1->sample_rate() == 44100);
+        UTEST_ASSERT(s1->frames() == FRAMES);
+        UTEST_ASSERT(s1->format() == mm::SFMT_F32);
+        UTEST_ASSERT(s1->bytes() == FRAMES * 2 * sizeof(float));
+        for (size_t i=0; i<FRAMES*2; ++i)
+            UTEST_ASSERT_MSG(s1->data<float>()[i] == src[i], "Sample %d differs", int(i));
+        check_stats(&cache, 0, 1, 0, 1, 1);
+
+        // Load the same sample by the path in another form
+        io::Path xp;
+        UTEST_ASSERT(xp.fmt("%s/./tmp/../utest-%s-1.wav", tempdir(), full_name()) > 0);
+        UTEST_ASSERT(cache.acquire(&s2, xp.as_string(), mm::SFMT_F32_DFL) == STATUS_OK);
+        UTEST_ASSERT(s2 == s1);
+        check_stats(&cache, 1, 1, 0, 1, 1);
+
+        // Load the sample in other format and sample rate
+        UTEST_ASSERT(cache.acquire(&s3, p1, mm::SFMT_S16_CPU) == STATUS_OK);
+        UTEST_ASSERT(s3 != s1);
+        UTEST_ASSERT(s3->format() == mm::SFMT_S16);
+        UTEST_ASSERT(s3->bytes() == FRAMES * 2 * sizeof(int16_t));
+        UTEST_ASSERT(cache.acquire(&s4, p1, mm::SFMT_F32_CPU, 48000) == STATUS_OK);
+        UTEST_ASSERT(s4 != s1);
+        UTEST_ASSERT(s4->sample_rate() == 48000);
+        UTEST_ASSERT(s4->frames() > FRAMES);
+        check_stats(&cache, 1, 3, 0, 3, 3);
+
+        // Release samples
+        UTEST_ASSERT(cache.release(s1) == STATUS_OK);
+        UTEST_ASSERT(cache.release(s2) == STATUS_OK);
+        UTEST_ASSERT(cache.release(s2) == STATUS_BAD_STATE);
+        UTEST_ASSERT(cache.release(s3) == STATUS_OK);
+        UTEST_ASSERT(cache.release(s4) == STATUS_OK);
+        UTEST_ASSERT(cache.release(NULL) == STATUS_BAD_ARGUMENTS);
+        check_stats(&cache, 1, 3, 0, 3, 0);
+
+        // The released sample should be served from the cache
+        UTEST_ASSERT(cache.acquire(&s1, p1, mm::SFMT_F32_CPU) == STATUS_OK);
+        check_stats(&cache, 2, 3, 0, 3, 1);
+        UTEST_ASSERT(cache.release(s1) == STATUS_OK);
+
+        // Errors
+        UTEST_ASSERT(cache.acquire(&s1, p1, mm::SFMT_S24_CPU) == STATUS_UNSUPPORTED_FORMAT);
+        UTEST_ASSERT(cache.acquire(&s1, p1, __IF_LEBE(mm::SFMT_F32_BE, mm::SFMT_F32_LE)) == STATUS_UNSUPPORTED_FORMAT);
+        UTEST_ASSERT(cache.acquire(NULL, p1, mm::SFMT_F32_CPU) == STATUS_BAD_ARGUMENTS);
+        io::Path missing;
+        UTEST_ASSERT(missing.fmt("%s/utest-%s-missing.wav", tempdir(), full_name()) > 0);
+        UTEST_ASSERT(cache.acquire(&s1, &missing, mm::SFMT_F32_CPU) == STATUS_NOT_FOUND);
+        check_stats(&cache, 2, 3, 0, 3, 0);
+
+        // Clear the cache
+        cache.reset_stats();
+        cache.clear();
+        check_stats(&cache, 0, 0, 3, 0, 0);
+
+        // The sample should be decoded again after the file has been modified
+        UTEST_ASSERT(cache.acquire(&s1, p2, mm::SFMT_F32_CPU) == STATUS_OK);
+        UTEST_ASSERT(s1->frames() == FRAMES);
+        write_file(p2, src, FRAMES / 2);
+        UTEST_ASSERT(cache.acquire(&s2, p2, mm::SFMT_F32_CPU) == STATUS_OK);
+        UTEST_ASSERT(s2 != s1);
+        UTEST_ASSERT(s2->frames() == FRAMES / 2);
+        UTEST_ASSERT(s1->frames() == FRAMES);
+        check_stats(&cache, 0, 2, 3, 2, 2);
+        UTEST_ASSERT(cache.release(s1) == STATUS_OK);
+        UTEST_ASSERT(cache.release(s2) == STATUS_OK);
+        write_file(p2, src, FRAMES);
+    }
+
+    void test_eviction(const io::Path *p1, const io::Path *p2)
+    {
+        printf("Testing eviction of samples\n");
+
+        mm::SampleCache cache;
+        mm::SampleCache::Sample *s1 = NULL, *s2 = NULL, *s3 = NULL;
+        size_t bytes = FRAMES * 2 * sizeof(float);
+
+        // Limit the cache with two samples
+        cache.set_limit(bytes * 2);
+        UTEST_ASSERT(cache.limit() == bytes * 2);
+
+        UTEST_ASSERT(cache.acquire(&s1, p1, mm::SFMT_F32_CPU) == STATUS_OK);
+        UTEST_ASSERT(cache.acquire(&s2, p2, mm::SFMT_F32_CPU) == STATUS_OK);
+        UTEST_ASSERT(cache.acquire(&s3, p1, mm::SFMT_S32_CPU) == STATUS_OK);
+        check_stats(&cache, 0, 3, 0, 3, 3);
+
+        // Samples in use should not be evicted
+        UTEST_ASSERT(cache.release(s2) == STATUS_OK);
+        check_stats(&cache, 0, 3, 1, 2, 2);
+        UTEST_ASSERT(cache.release(s1) == STATUS_OK);
+        check_stats(&cache, 0, 3, 1, 2, 1);
+        UTEST_ASSERT(cache.release(s3) == STATUS_OK);
+        check_stats(&cache, 0, 3, 1, 2, 0);
+
+        // The least recently used sample should be evicted first
+        UTEST_ASSERT(cache.acquire(&s2, p2, mm::SFMT_F32_CPU) == STATUS_OK);
+        check_stats(&cache, 0, 4, 2, 2, 1);
+        UTEST_ASSERT(cache.acquire(&s3, p1, mm::SFMT_S32_CPU) == STATUS_OK);
+        check_stats(&cache, 1, 4, 2, 2, 2);
+        UTEST_ASSERT(cache.release(s2) == STATUS_OK);
+        UTEST_ASSERT(cache.release(s3) == STATUS_OK);
+
+        // Shrink the cache
+        cache.set_limit(bytes);
+        check_stats(&cache, 1, 4, 3, 1, 0);
+        UTEST_ASSERT(cache.acquire(&s3, p1, mm::SFMT_S32_CPU) == STATUS_OK);
+        check_stats(&cache, 2, 4, 3, 1, 1);
+        UTEST_ASSERT(cache.release(s3) == STATUS_OK);
+    }
+
+    void test_concurrent(const io::Path *path)
+    {
+        printf("Testing concurrent requests\n");
+
+        mm::SampleCache cache;
+        request_t req[THREADS];
+        ipc::Thread *threads[THREADS];
+
+        for (size_t i=0; i<THREADS; ++i)
+        {
+            req[i].pCache   = &cache;
+            req[i].pPath    = path;
+            req[i].pSample  = NULL;
+            req[i].nResult  = STATUS_UNKNOWN_ERR;
+            threads[i]      = new ipc::Thread(acquire_proc, &req[i]);
+            UTEST_ASSERT(threads[i] != NULL);
+        }
+        for (size_t i=0; i<THREADS; ++i)
+            UTEST_ASSERT(threads[i]->start() == STATUS_OK);
+        for (size_t i=0; i<THREADS; ++i)
+        {
+            UTEST_ASSERT(threads[i]->join() == STATUS_OK);
+            delete threads[i];
+        }
+
+        // All requests should obtain the same sample decoded once
+        for (size_t i=0; i<THREADS; ++i)
+        {
+            UTEST_ASSERT(req[i].nResult == STATUS_OK);
+            UTEST_ASSERT(req[i].pSample == req[0].pSample);
+        }
+        check_stats(&cache, THREADS - 1, 1, 0, 1, 1);
+
+        for (size_t i=0; i<THREADS; ++i)
+            UTEST_ASSERT(cache.release(req[i].pSample) == STATUS_OK);
+        check_stats(&cache, THREADS - 1, 1, 0, 1, 0);
+    }
+
+    UTEST_MAIN
+    {
+        FloatBuffer src(FRAMES * 2);
+        src.randomize_sign();
+
+        io::Path p1, p2;
+        UTEST_ASSERT(p1.fmt("%s/utest-%s-1.wav", tempdir(), full_name()) > 0);
+        UTEST_ASSERT(p2.fmt("%s/utest-%s-2.wav", tempdir(), full_name()) > 0);
+        write_file(&p1, src, FRAMES);
+        write_file(&p2, src, FRAMES);
+
+        test_basic(&p1, &p2, src);
+        test_eviction(&p1, &p2);
+        test_concurrent(&p1);
+    }
+
+UTEST_END
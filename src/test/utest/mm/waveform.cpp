@@ -0,0 +1,459 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 2 апр. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/common/endian.h>
+#include <lsp-plug.in/test-fw/utest.h>
+#include <lsp-plug.in/test-fw/FloatBuffer.h>
+#include <lsp-plug.in/fmt/lspc/AudioWriter.h>
+#include <lsp-plug.in/mm/InAudioWaveform.h>
+#include <lsp-plug.in/mm/OutAudioWaveform.h>
+#include <lsp-plug.in/mm/Waveform.h>
+#include <lsp-plug.in/stdlib/math.h>
+
+#define FRAMES          100003
+#define CHANNELS        2
+#define BASE            0x40
+
+namespace
+{
+    using namespace lsp;
+
+    /**
+     * Audio stream that reads interleaved frames from the buffer
+     */
+    class BufferInStream: public mm::IInAudioStream
+    {
+        protected:
+            const mm::f32_t    *pData;
+            wssize_t            nPos;
+
+        protected:
+            virtual ssize_t direct_read(void *dst, size_t nframes, size_t fmt)
+            {
+                if (nPos >= sFormat.frames)
+                    return -STATUS_EOF;
+                nframes     = lsp_min(wssize_t(nframes), sFormat.frames - nPos);
+                ::memcpy(dst, &pData[nPos * sFormat.channels], nframes * sFormat.channels * sizeof(mm::f32_t));
+                nPos       += nframes;
+                return nframes;
+            }
+
+            virtual size_t  select_format(size_t fmt)
+            {
+                return mm::SFMT_F32_CPU;
+            }
+
+        public:
+            explicit BufferInStream(const mm::f32_t *data, size_t frames)
+            {
+                pData               = data;
+                nPos                = 0;
+                nOffset             = 0;
+                sFormat.srate       = 48000;
+                sFormat.channels    = CHANNELS;
+                sFormat.frames      = frames;
+                sFormat.format      = mm::SFMT_F32_CPU;
+            }
+    };
+
+    /**
+     * Audio stream that writes interleaved frames to the buffer
+     */
+    class BufferOutStream: public mm::IOutAudioStream
+    {
+        protected:
+            mm::f32_t          *pData;
+            size_t              nCapacity;
+            size_t              nPos;
+
+        protected:
+            virtual ssize_t direct_write(const void *src, size_t nframes, size_t fmt)
+            {
+                nframes     = lsp_min(nframes, nCapacity - nPos);
+                ::memcpy(&pData[nPos * sFormat.channels], src, nframes * sFormat.channels * sizeof(mm::f32_t));
+                nPos       += nframes;
+                return nframes;
+            }
+
+            virtual size_t  select_format(size_t fmt)
+            {
+                return mm::SFMT_F32_CPU;
+            }
+
+        public:
+            explicit BufferOutStream(mm::f32_t *data, size_t frames)
+            {
+                pData               = data;
+                nCapacity           = frames;
+                nPos                = 0;
+                nOffset             = 0;
+                sFormat.srate       = 48000;
+                sFormat.channels    = CHANNELS;
+                sFormat.frames      = frames;
+                sFormat.format      = mm::SFMT_F32_CPU;
+            }
+    };
+}
+
+UTEST_BEGIN("runtime.mm", waveform)
+
+    void check_levels(const mm::Waveform *wf, FloatBuffer &src)
+    {
+        size_t levels = 0;
+        while ((FRAMES + (BASE << levels) - 1) / (BASE << levels) > 1)
+            ++levels;
+
+        UTEST_ASSERT(wf->finished());
+        UTEST_ASSERT(wf->channels() == CHANNELS);
+        UTEST_ASSERT(wf->sample_rate() == 48000);
+        UTEST_ASSERT(wf->base() == BASE);
+        UTEST_ASSERT(wf->frames() == FRAMES);
+        UTEST_ASSERT_MSG(wf->levels() == levels + 1, "Levels: %d, expected %d", int(wf->levels()), int(levels + 1));
+        UTEST_ASSERT(wf->data(wf->levels()) == NULL);
+        UTEST_ASSERT(wf->entries(wf->levels() - 1) == 1);
+
+        // Compare each entry with the brute-force computation
+        for (size_t l=0; l<wf->levels(); ++l)
+        {
+            size_t step     = BASE << l;
+            size_t items    = (FRAMES + step - 1) / step;
+            const mm::Waveform::peak_t *p = wf->data(l);
+            UTEST_ASSERT(wf->entries(l) == items);
+
+            for (size_t i=0; i<items; ++i)
+            {
+                size_t first    = i * step;
+                size_t last     = lsp_min(first + step, size_t(FRAMES));
+                for (size_t c=0; c<CHANNELS; ++c, ++p)
+                {
+                    float vmin      = src[first * CHANNELS + c];
+                    float vmax      = vmin;
+                    double sum      = 0.0;
+                    for (size_t j=first; j<last; ++j)
+                    {
+                        float s         = src[j * CHANNELS + c];
+                        vmin            = lsp_min(vmin, s);
+                        vmax            = lsp_max(vmax, s);
+                        sum            += double(s) * s;
+                    }
+                    float rms       = sqrt(sum / (last - first));
+
+                    UTEST_ASSERT_MSG((p->min == vmin) && (p->max == vmax),
+                        "Level %d, entry %d, channel %d: min/max %f/%f, expected %f/%f",
+                        int(l), int(i), int(c), p->min, p->max, vmin, vmax);
+                    UTEST_ASSERT_MSG(fabs(p->rms - rms) <= 1e-4f * rms,
+                        "Level %d, entry %d, channel %d: rms %f, expected %f",
+                        int(l), int(i), int(c), p->rms, rms);
+                }
+            }
+        }
+    }
+
+    void check_equal(const mm::Waveform *a, const mm::Waveform *b, float tol)
+    {
+        UTEST_ASSERT(a->levels() == b->levels());
+        UTEST_ASSERT(a->frames() == b->frames());
+        UTEST_ASSERT(a->channels() == b->channels());
+        UTEST_ASSERT(a->sample_rate() == b->sample_rate());
+        UTEST_ASSERT(a->base() == b->base());
+
+        for (size_t l=0; l<a->levels(); ++l)
+        {
+            UTEST_ASSERT(a->entries(l) == b->entries(l));
+            const mm::Waveform::peak_t *pa = a->data(l);
+            const mm::Waveform::peak_t *pb = b->data(l);
+            for (size_t i=0, n=a->entries(l) * a->channels(); i<n; ++i)
+            {
+                UTEST_ASSERT_MSG((pa[i].min == pb[i].min) && (pa[i].max == pb[i].max) &&
+                    (fabs(pa[i].rms - pb[i].rms) <= tol * pa[i].rms),
+                    "Level %d, record %d differs", int(l), int(i));
+            }
+        }
+    }
+
+    void test_in_stream(mm::Waveform *wf, FloatBuffer &src)
+    {
+        printf("Building overview from input stream\n");
+
+        BufferInStream bs(src.data(), FRAMES);
+        mm::InAudioWaveform is;
+        FloatBuffer dst((FRAMES + 0x1000) * CHANNELS);
+
+        UTEST_ASSERT(wf->init(1, 44100, BASE) == STATUS_OK);
+        UTEST_ASSERT(is.wrap(&bs, wf) == STATUS_OK);
+        UTEST_ASSERT(is.wrap(&bs, wf) == STATUS_BAD_STATE);
+        UTEST_ASSERT(is.channels() == CHANNELS);
+        UTEST_ASSERT(is.length() == FRAMES);
+        UTEST_ASSERT(!wf->finished());
+
+        // Read with random block sizes, the part of frames is skipped
+        size_t off = 0;
+        while (true)
+        {
+            size_t to_read  = size_t(rand() % 0x1000) + 1;
+            if ((off >= 0x1000) && (off < 0x4000))
+            {
+                wssize_t n      = is.skip(to_read);
+                UTEST_ASSERT(n == wssize_t(to_read));
+                off            += n;
+                continue;
+            }
+
+            ssize_t n       = is.read(dst.data() + off * CHANNELS, to_read);
+            if (n < 0)
+            {
+                UTEST_ASSERT(n == -STATUS_EOF);
+                break;
+            }
+            UTEST_ASSERT(::memcmp(dst.data() + off * CHANNELS, src.data() + off * CHANNELS, n * CHANNELS * sizeof(float)) == 0);
+            off            += n;
+        }
+        UTEST_ASSERT(off == FRAMES);
+        UTEST_ASSERT(dst.valid());
+        UTEST_ASSERT(is.seek(0) == -STATUS_NOT_SUPPORTED);
+        UTEST_ASSERT(is.close() == STATUS_OK);
+
+        check_levels(wf, src);
+        UTEST_ASSERT(wf->process(src.data(), FRAMES) == STATUS_BAD_STATE);
+    }
+
+    void test_out_stream(mm::Waveform *wf, FloatBuffer &src)
+    {
+        printf("Building overview from output stream\n");
+
+        FloatBuffer dst(FRAMES * CHANNELS);
+        BufferOutStream bs(dst.data(), FRAMES);
+        mm::OutAudioWaveform os;
+
+        UTEST_ASSERT(wf->init(1, 44100, BASE) == STATUS_OK);
+        UTEST_ASSERT(os.wrap(&bs, wf) == STATUS_OK);
+        UTEST_ASSERT(wf->channels() == CHANNELS);
+
+        for (size_t off = 0; off < FRAMES; )
+        {
+            size_t to_write = lsp_min(size_t(rand() % 0x1000) + 1, size_t(FRAMES - off));
+            ssize_t n       = os.write(src.data() + off * CHANNELS, to_write);
+            UTEST_ASSERT(n == ssize_t(to_write));
+            off            += n;
+        }
+        UTEST_ASSERT(!wf->finished());
+        UTEST_ASSERT(os.close() == STATUS_OK);
+        UTEST_ASSERT(dst.valid());
+        UTEST_ASSERT(::memcmp(dst.data(), src.data(), FRAMES * CHANNELS * sizeof(float)) == 0);
+
+        check_levels(wf, src);
+    }
+
+    void test_query(const mm::Waveform *wf, FloatBuffer &src)
+    {
+        printf("Querying overview\n");
+
+        mm::Waveform::peak_t cols[100];
+
+        // Single column covers the whole sample
+        for (size_t c=0; c<CHANNELS; ++c)
+        {
+            float vmin = src[c], vmax = src[c];
+            for (size_t i=0; i<FRAMES; ++i)
+            {
+                vmin            = lsp_min(vmin, src[i * CHANNELS + c]);
+                vmax            = lsp_max(vmax, src[i * CHANNELS + c]);
+            }
+
+            UTEST_ASSERT(wf->query(cols, c, 0, FRAMES, 1) == STATUS_OK);
+            UTEST_ASSERT((cols[0].min == vmin) && (cols[0].max == vmax));
+        }
+
+        // Columns cover at least the requested range of frames
+        size_t first = 1234, count = 77777;
+        UTEST_ASSERT(wf->query(cols, 1, first, count, 100) == STATUS_OK);
+        for (size_t i=0; i<100; ++i)
+        {
+            size_t start    = first + (count * i) / 100;
+            size_t end      = first + (count * (i + 1)) / 100;
+            for (size_t j=start; j<end; ++j)
+            {
+                float s         = src[j * CHANNELS + 1];
+                UTEST_ASSERT_MSG((cols[i].min <= s) && (cols[i].max >= s), "Column %d does not cover frame %d", int(i), int(j));
+            }
+            UTEST_ASSERT((cols[i].rms > 0.0f) && (cols[i].rms <= lsp_max(-cols[i].min, cols[i].max)));
+        }
+
+        // Columns beyond the end of the sample are empty
+        UTEST_ASSERT(wf->query(cols, 0, FRAMES - 10, 100, 10) == STATUS_OK);
+        UTEST_ASSERT(cols[0].max > 0.0f);
+        UTEST_ASSERT((cols[9].min == 0.0f) && (cols[9].max == 0.0f) && (cols[9].rms == 0.0f));
+
+        UTEST_ASSERT(wf->query(NULL, 0, 0, FRAMES, 10) == STATUS_BAD_ARGUMENTS);
+        UTEST_ASSERT(wf->query(cols, CHANNELS, 0, FRAMES, 10) == STATUS_BAD_ARGUMENTS);
+        UTEST_ASSERT(wf->query(cols, 0, 0, FRAMES, 0) == STATUS_BAD_ARGUMENTS);
+    }
+
+    void test_lspc(const mm::Waveform *wf, FloatBuffer &src)
+    {
+        io::Path path;
+        UTEST_ASSERT(path.fmt("%s/utest-%s.lspc", tempdir(), full_name()));
+        printf("Storing overview to %s\n", path.as_native());
+
+        // Store audio and two overviews
+        uint32_t audio_id, wf_id, dummy_id;
+        {
+            mm::Waveform dummy;
+            UTEST_ASSERT(dummy.init(CHANNELS, 48000, BASE) == STATUS_OK);
+            UTEST_ASSERT(dummy.process(src.data(), 1000) == STATUS_OK);
+
+            lspc::File fd;
+            UTEST_ASSERT(fd.create(&path) == STATUS_OK);
+            UTEST_ASSERT(dummy.save(&fd, 0) == STATUS_BAD_STATE);
+            UTEST_ASSERT(dummy.finish() == STATUS_OK);
+            UTEST_ASSERT(dummy.save(&fd, 0, &dummy_id) == STATUS_OK);
+
+            lspc::AudioWriter wr;
+            lspc::audio_parameters_t params;
+            params.channels         = CHANNELS;
+            params.sample_format    = __IF_LEBE(LSPC_SAMPLE_FMT_F32LE, LSPC_SAMPLE_FMT_F32BE);
+            params.sample_rate      = 48000;
+            params.codec            = LSPC_CODEC_PCM;
+            params.frames           = FRAMES;
+            UTEST_ASSERT(wr.open(&fd, &params) == STATUS_OK);
+            UTEST_ASSERT(wr.write_frames(src.data(), FRAMES) == STATUS_OK);
+            audio_id                = wr.unique_id();
+            UTEST_ASSERT(wr.close() == STATUS_OK);
+
+            UTEST_ASSERT(wf->save(&fd, audio_id, &wf_id) == STATUS_OK);
+            UTEST_ASSERT(fd.close() == STATUS_OK);
+        }
+
+        // Load overviews
+        lspc::File fd;
+        mm::Waveform xwf;
+        UTEST_ASSERT(fd.open(&path) == STATUS_OK);
+
+        UTEST_ASSERT(xwf.load_related(&fd, audio_id) == STATUS_OK);
+        check_equal(wf, &xwf, 0.0f);
+        check_levels(&xwf, src);
+
+        UTEST_ASSERT(xwf.load(&fd, dummy_id) == STATUS_OK);
+        UTEST_ASSERT(xwf.frames() == 1000);
+        UTEST_ASSERT(xwf.load(&fd, wf_id) == STATUS_OK);
+        check_equal(wf, &xwf, 0.0f);
+
+        UTEST_ASSERT(xwf.load_related(&fd, audio_id + 100) == STATUS_NOT_FOUND);
+        UTEST_ASSERT(xwf.load(&fd, audio_id) == STATUS_NOT_FOUND);
+        check_equal(wf, &xwf, 0.0f);
+
+        UTEST_ASSERT(fd.close() == STATUS_OK);
+    }
+
+    uint32_t write_raw_chunk(lspc::File *fd, size_t channels, size_t base, wsize_t frames, size_t bytes)
+    {
+        lspc::ChunkWriter *wr   = fd->write_chunk(LSPC_CHUNK_WAVEFORM);
+        UTEST_ASSERT(wr != NULL);
+
+        size_t levels = 0;
+        for (wsize_t step = base; (levels < mm::Waveform::MAX_LEVELS) && (frames > 0); step <<= 1)
+        {
+            ++levels;
+            if (frames <= step)
+                break;
+        }
+
+        lspc::chunk_waveform_header_t hdr;
+        ::memset(&hdr, 0, sizeof(hdr));
+        hdr.common.size     = sizeof(lspc::chunk_waveform_header_t);
+        hdr.common.version  = 1;
+        hdr.channels        = CPU_TO_BE(uint16_t(channels));
+        hdr.levels          = CPU_TO_BE(uint16_t(levels));
+        hdr.sample_rate     = CPU_TO_BE(uint32_t(48000));
+        hdr.base            = CPU_TO_BE(uint32_t(base));
+        hdr.frames          = CPU_TO_BE(uint64_t(frames));
+        UTEST_ASSERT(wr->write_header(&hdr) == STATUS_OK);
+
+        uint8_t buf[0x100];
+        ::memset(buf, 0, sizeof(buf));
+        for (size_t n; bytes > 0; bytes -= n)
+        {
+            n = lsp_min(bytes, sizeof(buf));
+            UTEST_ASSERT(wr->write(buf, n) == STATUS_OK);
+        }
+
+        UTEST_ASSERT(wr->close() == STATUS_OK);
+        uint32_t uid = wr->unique_id();
+        delete wr;
+
+        return uid;
+    }
+
+    void test_corrupted()
+    {
+        io::Path path;
+        UTEST_ASSERT(path.fmt("%s/utest-%s-corrupted.lspc", tempdir(), full_name()));
+        printf("Testing corrupted overviews at %s\n", path.as_native());
+
+        // 1000 frames at base 64 give 16 + 8 + 4 + 2 + 1 entries
+        static const size_t valid_bytes = 31 * 2 * sizeof(mm::Waveform::peak_t);
+        uint32_t overflow_id, short_id, long_id, valid_id;
+        {
+            lspc::File fd;
+            UTEST_ASSERT(fd.create(&path) == STATUS_OK);
+            overflow_id     = write_raw_chunk(&fd, 8, 16, wsize_t(1) << 63, 0);
+            short_id        = write_raw_chunk(&fd, 2, 64, 1000, valid_bytes - 1);
+            long_id         = write_raw_chunk(&fd, 2, 64, 1000, valid_bytes + 12);
+            valid_id        = write_raw_chunk(&fd, 2, 64, 1000, valid_bytes);
+            UTEST_ASSERT(fd.close() == STATUS_OK);
+        }
+
+        lspc::File fd;
+        mm::Waveform wf;
+        UTEST_ASSERT(fd.open(&path) == STATUS_OK);
+        UTEST_ASSERT(wf.load(&fd, overflow_id) == STATUS_CORRUPTED_FILE);
+        UTEST_ASSERT(wf.load(&fd, short_id) == STATUS_CORRUPTED_FILE);
+        UTEST_ASSERT(wf.load(&fd, long_id) == STATUS_CORRUPTED_FILE);
+        UTEST_ASSERT(wf.load(&fd, valid_id) == STATUS_OK);
+        UTEST_ASSERT(wf.frames() == 1000);
+        UTEST_ASSERT(wf.levels() == 5);
+        UTEST_ASSERT(wf.entries(0) == 16);
+        UTEST_ASSERT(fd.close() == STATUS_OK);
+    }
+
+    UTEST_MAIN
+    {
+        // Generate data: the second channel is quieter than the first one
+        FloatBuffer src(FRAMES * CHANNELS);
+        src.randomize_sign();
+        for (size_t i=0; i<FRAMES; ++i)
+            src[i * CHANNELS + 1]  *= 0.5f;
+
+        mm::Waveform wf, xwf;
+        UTEST_ASSERT(wf.process(src.data(), FRAMES) == STATUS_BAD_STATE);
+        UTEST_ASSERT(wf.finish() == STATUS_BAD_STATE);
+        UTEST_ASSERT(wf.init(CHANNELS, 48000, mm::Waveform::MIN_BASE - 1) == STATUS_BAD_ARGUMENTS);
+        UTEST_ASSERT(wf.init(0, 48000) == STATUS_BAD_ARGUMENTS);
+
+        test_in_stream(&wf, src);
+        test_out_stream(&xwf, src);
+        check_equal(&wf, &xwf, 1e-5f);
+        test_query(&wf, src);
+        test_lspc(&wf, src);
+        test_corrupted();
+    }
+
+UTEST_END
@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2021 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2021 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-runtime-lib
+ * Created on: 3 апр. 2021 г.
+ *
+ * lsp-runtime-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-runtime-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-runtime-lib. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <lsp-plug.in/test-fw/utest.h>
+#include <lsp-plug.in/common/alloc.h>
+#include <lsp-plug.in/stdlib/string.h>
+#include <lsp-plug.in/resource/buffer.h>
+
+#define STREAM_SIZE     0x20000
+
+using namespace lsp;
+
+UTEST_BEGIN("runtime.resource", buffer)
+
+    // Reference lookup: the longest match, the earliest one among matches of the same length
+    size_t ref_lookup(ssize_t *out, const uint8_t *w, size_t n, const uint8_t *s, size_t avail)
+    {
+        ssize_t offset  = -1;
+        size_t len      = 0;
+
+        for (size_t i=0; i<n; ++i)
+        {
+            size_t count    = lsp_min(avail, n - i);
+            size_t slen     = 0;
+            while ((slen < count) && (w[i + slen] == s[slen]))
+                ++slen;
+            if (slen > len)
+            {
+                offset          = i;
+                len             = slen;
+            }
+        }
+
+        *out            = offset;
+        return len;
+    }
+
+    void generate(uint8_t *dst, size_t count, uint32_t seed)
+    {
+        // Generate data with a lot of repetitions of different lengths
+        for (size_t i=0; i<count; )
+        {
+            seed            = seed * 1103515245 + 12345;
+            size_t len      = lsp_min(size_t((seed >> 8) % 40) + 1, count - i);
+            if ((i >= 0x40) && (seed & 0x40000000))
+            {
+                size_t dist     = ((seed >> 16) % lsp_min(i, size_t(0x3000))) + 1;
+                for (size_t j=0; j<len; ++j, ++i)
+                    dst[i]          = dst[i - dist];
+            }
+            else
+            {
+                for (size_t j=0; j<len; ++j, ++i)
+                {
+                    seed            = seed * 1103515245 + 12345;
+                    dst[i]          = uint8_t('a' + ((seed >> 16) % 12));
+                }
+            }
+        }
+    }
+
+    void check_window(const resource::cbuffer_t *cb, const resource::dbuffer_t *db, const uint8_t *stream, size_t pos)
+    {
+        size_t n        = lsp_min(pos, size_t(cb->cap));
+        UTEST_ASSERT(cb->size() == n);
+        UTEST_ASSERT(db->size() == n);
+        UTEST_ASSERT(memcmp(&cb->data[cb->head], &stream[pos - n], n) == 0);
+        UTEST_ASSERT(memcmp(&db->data[db->head], &stream[pos - n], n) == 0);
+    }
+
+    void test_lookup(size_t cap, uint32_t seed)
+    {
+        resource::cbuffer_t cb;
+        resource::dbuffer_t db;
+        uint8_t *stream = static_cast<uint8_t *>(malloc(STREAM_SIZE));
+        UTEST_ASSERT(stream != NULL);
+        generate(stream, STREAM_SIZE, seed);
+
+        printf("Testing lookup for capacity=%d, seed=%d\n", int(cap), int(seed));
+        UTEST_ASSERT(cb.init(cap) == STATUS_OK);
+        UTEST_ASSERT(db.init(cap) == STATUS_OK);
+
+        size_t pos      = 0, lookups = 0;
+        while (pos < STREAM_SIZE)
+        {
+            // Compare the match with the reference one
+            size_t avail    = STREAM_SIZE - pos;
+            size_t n        = lsp_min(pos, size_t(cap));
+            ssize_t off1 = -1, off2 = -1;
+            size_t len1     = cb.lookup(&off1, &stream[pos], avail);
+            size_t len2     = ref_lookup(&off2, &stream[pos - n], n, &stream[pos], avail);
+            UTEST_ASSERT_MSG((len1 == len2) && (off1 == off2),
+                "Lookup mismatch at position %d: got offset=%d length=%d, expected offset=%d length=%d",
+                int(pos), int(off1), int(len1), int(off2), int(len2));
+            ++lookups;
+
+            // Append the data in different ways
+            seed            = seed * 1103515245 + 12345;
+            size_t count    = lsp_max(len1, size_t(1)) + ((seed >> 16) & 0x3);
+            if ((seed & 0xff) == 0)
+                count          += cap + ((seed >> 8) % cap);
+            count           = lsp_min(count, avail);
+
+            if (seed & 0x100)
+            {
+                cb.append(&stream[pos], count);
+                db.append(&stream[pos], count);
+            }
+            else
+            {
+                for (size_t i=0; i<count; ++i)
+                {
+                    cb.append(stream[pos + i]);
+                    db.append(stream[pos + i]);
+                }
+            }
+            pos            += count;
+            check_window(&cb, &db, stream, pos);
+        }
+
+        printf("  performed %d lookups\n", int(lookups));
+
+        cb.destroy();
+        db.destroy();
+        free(stream);
+    }
+
+    void test_clear()
+    {
+        resource::cbuffer_t cb;
+        ssize_t off;
+        static const char *text = "abcdefgh";
+
+        printf("Testing clear\n");
+        UTEST_ASSERT(cb.init(0x100) == STATUS_OK);
+        cb.append(text, 8);
+        UTEST_ASSERT(cb.lookup(&off, "cdef", 4) == 4);
+        UTEST_ASSERT(off == 2);
+
+        cb.clear();
+        UTEST_ASSERT(cb.size() == 0);
+        UTEST_ASSERT(cb.lookup(&off, "cdef", 4) == 0);
+        UTEST_ASSERT(off == -1);
+
+        cb.append(&text[2], 6);
+        UTEST_ASSERT(cb.lookup(&off, "efgx", 4) == 3);
+        UTEST_ASSERT(off == 2);
+    }
+
+    void test_depth()
+    {
+        resource::cbuffer_t cb;
+        ssize_t off;
+
+        printf("Testing limited chain depth\n");
+        UTEST_ASSERT(cb.init(0x1000) == STATUS_OK);
+        cb.depth        = 1;
+        cb.append("abcdefgh", 8);
+        cb.append("abcdxyzw", 8);
+
+        // The most recent match is checked only
+        UTEST_ASSERT(cb.lookup(&off, "abcdefgh", 8) == 4);
+        UTEST_ASSERT(off == 8);
+
+        // The exhaustive search finds the longest one
+        cb.depth        = 0;
+        UTEST_ASSERT(cb.lookup(&off, "abcdefgh", 8) == 8);
+        UTEST_ASSERT(off == 0);
+    }
+
+    UTEST_MAIN
+    {
+        test_clear();
+        test_depth();
+        test_lookup(0x100, 1);
+        test_lookup(0x1000, 2);
+        test_lookup(0x1000, 3);
+        test_lookup(0x8000, 4);
+    }
+
+UTEST_END
@@ -24,6 +24,7 @@
 #include <lsp-plug.in/io/Path.h>
 #include <lsp-plug.in/io/Dir.h>
 #include <lsp-plug.in/io/InFileStream.h>
+#include <lsp-plug.in/io/InMemoryStream.h>
 #include <lsp-plug.in/io/OutFileStream.h>
 #include <lsp-plug.in/resource/Compressor.h>
 #include <lsp-plug.in/resource/Decompressor.h>
@@ -62,7 +63,7 @@ UTEST_BEGIN("runtime.resource", compressor)
                 io::InFileStream ifs;
                 UTEST_ASSERT(ifs.open(&child) == STATUS_OK);
                 wssize_t len = c->create_file(&relative, &ifs);
-                UTEST_ASSERT(c >= 0);
+                UTEST_ASSERT(len >= 0);
                 UTEST_ASSERT(ifs.close() == STATUS_OK);
 
                 *data_size += len;
@@ -111,6 +112,17 @@ UTEST_BEGIN("runtime.resource", compressor)
             UTEST_ASSERT(oms1.size() == size_t(sz1));
             printf("  decompressed entry size: %ld bytes\n", long(sz1));
 
+            // Decompress the item byte by byte
+            UTEST_ASSERT((irs = load->read_stream(&child)) != NULL);
+            for (wssize_t j=0; j<sz1; ++j)
+            {
+                ssize_t b = irs->read_byte();
+                UTEST_ASSERT(b == oms1.data()[j]);
+            }
+            UTEST_ASSERT(irs->read_byte() == -STATUS_EOF);
+            UTEST_ASSERT(irs->close() == STATUS_OK);
+            delete irs;
+
             // Save the decompressed entry
             UTEST_ASSERT(out.set(temp, rel) == STATUS_OK);
             UTEST_ASSERT(out.append_child(item->name) == STATUS_OK);
@@ -142,7 +154,7 @@ UTEST_BEGIN("runtime.resource", compressor)
         free(rlist);
     }
 
-    void test_compress_data(const io::Path *path, resource::Compressor *c, io::OutMemoryStream *os)
+    void test_compress_data(const char *mode, const io::Path *path, resource::Compressor *c, io::OutMemoryStream *os)
     {
         wsize_t data_size = 0;
         io::Path tmp;
@@ -163,45 +175,183 @@ UTEST_BEGIN("runtime.resource", compressor)
             ratio
         );
 
-        UTEST_ASSERT(tmp.fmt("%s/%s.commands", tempdir(), full_name()) > 0);
+        UTEST_ASSERT(tmp.fmt("%s/%s-%s.commands", tempdir(), full_name(), mode) > 0);
         printf("Dumping commands to: %s\n", tmp.as_native());
         UTEST_ASSERT(ofs.open(&tmp, io::File::FM_WRITE_NEW) == STATUS_OK);
         ofs.write(os->data(), os->size());
         UTEST_ASSERT(ofs.close() == STATUS_OK);
     }
 
-    void test_decompress_data(const io::Path *path, resource::Compressor *c, io::OutMemoryStream *os)
+    void test_decompress_data(const char *mode, const io::Path *path, resource::Compressor *c, io::OutMemoryStream *os)
     {
         resource::BuiltinLoader load;
         io::Path rel;
         io::Path tmp;
 
-        UTEST_ASSERT(tmp.fmt("%s/utest-%s", tempdir(), full_name()) > 0);
+        UTEST_ASSERT(tmp.fmt("%s/utest-%s-%s", tempdir(), full_name(), mode) > 0);
         UTEST_ASSERT(load.init(os->data(), os->size(), c->entries(), c->num_entires(), BUFFER_SIZE) == STATUS_OK);
         printf("Scanning resource registry...\n");
         scan_resources(&load, path, &tmp, &rel);
     }
 
-    UTEST_MAIN
+    void test_mode(const char *mode, const io::Path *path, size_t block_size, size_t threads)
     {
-        io::Path path;
         resource::Compressor c;
         io::OutMemoryStream oms;
 
-        UTEST_ASSERT(path.fmt("%s/compressor", resources()) > 0);
-        printf("Resource directory: %s\n", path.as_native());
+        printf("Testing %s mode...\n", mode);
+        c.set_block_size(block_size);
+        c.set_threads(threads);
 
         // Compress data
-        test_compress_data(&path, &c, &oms);
+        test_compress_data(mode, path, &c, &oms);
 
         // Decompress data
-        test_decompress_data(&path, &c, &oms);
+        test_decompress_data(mode, path, &c, &oms);
 
         UTEST_ASSERT(c.close() == STATUS_OK);
         oms.drop();
         UTEST_ASSERT(oms.close() == STATUS_OK);
     }
 
+    void test_runs()
+    {
+        static const size_t sizes[] = { 1, 7, 0x1000, 0x100000 };
+        io::OutMemoryStream src, dst, out;
+        resource::Compressor c;
+        uint8_t buf[0x40];
+
+        printf("Testing runs of octets...\n");
+
+        // Generate the data with runs of different length and short repeating patterns
+        for (size_t i=0; i<0x2000; ++i)
+        {
+            size_t count    = (i * 7) % 41 + 1;
+            memset(buf, (i * 13) & 0xff, count);
+            UTEST_ASSERT(src.write(buf, count) == ssize_t(count));
+            if ((i % 5) == 0)
+            {
+                count           = lsp_min(src.size(), sizeof(buf));
+                memcpy(buf, src.data(), count);
+                UTEST_ASSERT(src.write(buf, count) == ssize_t(count));
+            }
+        }
+
+        io::InMemoryStream is(src.data(), src.size());
+        UTEST_ASSERT(c.init(0x1000, &dst) == STATUS_OK);
+        UTEST_ASSERT(c.create_file("runs.bin", &is) == wssize_t(src.size()));
+        UTEST_ASSERT(c.flush() == STATUS_OK);
+        UTEST_ASSERT(c.close() == STATUS_OK);
+        printf("  compressed %d -> %d bytes\n", int(src.size()), int(dst.size()));
+
+        // Decompress with different sizes of the destination buffer
+        uint8_t *data = static_cast<uint8_t *>(malloc(src.size()));
+        UTEST_ASSERT(data != NULL);
+        for (size_t i=0, n=sizeof(sizes)/sizeof(sizes[0]); i<n; ++i)
+        {
+            resource::Decompressor d;
+            UTEST_ASSERT(d.init(dst.data(), dst.size(), src.size(), 0x1000) == STATUS_OK);
+
+            size_t nread = 0;
+            while (nread < src.size())
+            {
+                ssize_t count = d.read(&data[nread], lsp_min(sizes[i], src.size() - nread));
+                UTEST_ASSERT(count > 0);
+                nread      += count;
+            }
+            UTEST_ASSERT(d.read(data, 1) == -STATUS_EOF);
+            UTEST_ASSERT(d.close() == STATUS_OK);
+            UTEST_ASSERT_MSG(memcmp(data, src.data(), src.size()) == 0,
+                "Decompressed data differs for chunk size %d", int(sizes[i]));
+        }
+        free(data);
+    }
+
+    void test_lookup()
+    {
+        static const char *files[] = { "a/b/x.txt", "a/y.txt", "z.txt" };
+        resource::Compressor c;
+        resource::BuiltinLoader load;
+        resource::resource_t *rlist = NULL;
+        io::OutMemoryStream dst;
+        io::IInStream *irs;
+
+        printf("Testing lookup of entries...\n");
+
+        // Create the catalog
+        UTEST_ASSERT(c.init(0x1000, &dst) == STATUS_OK);
+        UTEST_ASSERT(c.create_dir("a") == STATUS_OK);
+        UTEST_ASSERT(c.create_dir("a/b") == STATUS_OK);
+        for (size_t i=0, n=sizeof(files)/sizeof(files[0]); i<n; ++i)
+        {
+            io::InMemoryStream is(files[i], strlen(files[i]));
+            UTEST_ASSERT(c.create_file(files[i], &is) == wssize_t(strlen(files[i])));
+        }
+        UTEST_ASSERT(c.flush() == STATUS_OK);
+        UTEST_ASSERT(load.init(dst.data(), dst.size(), c.entries(), c.num_entires(), 0x1000) == STATUS_OK);
+        resource::ILoader *ld = &load;
+
+        // Read files
+        for (size_t i=0, n=sizeof(files)/sizeof(files[0]); i<n; ++i)
+        {
+            char buf[0x20];
+            UTEST_ASSERT((irs = ld->read_stream(files[i])) != NULL);
+            UTEST_ASSERT(irs->read_fully(buf, strlen(files[i])) == ssize_t(strlen(files[i])));
+            UTEST_ASSERT(irs->read_byte() == -STATUS_EOF);
+            UTEST_ASSERT(memcmp(buf, files[i], strlen(files[i])) == 0);
+            UTEST_ASSERT(irs->close() == STATUS_OK);
+            delete irs;
+        }
+
+        // Lookup missing entries
+        UTEST_ASSERT(ld->read_stream("") == NULL);
+        UTEST_ASSERT(ld->read_stream("a") == NULL);
+        UTEST_ASSERT(ld->last_error() == STATUS_IS_DIRECTORY);
+        UTEST_ASSERT(ld->read_stream("a/b/y.txt") == NULL);
+        UTEST_ASSERT(ld->last_error() == STATUS_NOT_FOUND);
+        UTEST_ASSERT(ld->read_stream("/z.txt") == NULL);
+        UTEST_ASSERT(ld->read_stream("a//y.txt") == NULL);
+        UTEST_ASSERT(ld->read_stream("z.txt/a") == NULL);
+        UTEST_ASSERT(ld->read_stream("x.txt") == NULL);
+
+        // Enumerate directories
+        UTEST_ASSERT(ld->enumerate("", &rlist) == 2);
+        UTEST_ASSERT(strcmp(rlist[0].name, "a") == 0);
+        UTEST_ASSERT(rlist[0].type == resource::RES_DIR);
+        UTEST_ASSERT(strcmp(rlist[1].name, "z.txt") == 0);
+        UTEST_ASSERT(rlist[1].type == resource::RES_FILE);
+        free(rlist);
+
+        UTEST_ASSERT(ld->enumerate("a/", &rlist) == 2);
+        UTEST_ASSERT(strcmp(rlist[0].name, "b") == 0);
+        UTEST_ASSERT(strcmp(rlist[1].name, "y.txt") == 0);
+        free(rlist);
+
+        UTEST_ASSERT(ld->enumerate("a/b", &rlist) == 1);
+        UTEST_ASSERT(strcmp(rlist[0].name, "x.txt") == 0);
+        free(rlist);
+
+        UTEST_ASSERT(ld->enumerate("z.txt", &rlist) == -STATUS_NOT_DIRECTORY);
+        UTEST_ASSERT(ld->enumerate("a/c", &rlist) == -STATUS_NOT_FOUND);
+
+        UTEST_ASSERT(c.close() == STATUS_OK);
+    }
+
+    UTEST_MAIN
+    {
+        test_runs();
+        test_lookup();
+
+        io::Path path;
+
+        UTEST_ASSERT(path.fmt("%s/compressor", resources()) > 0);
+        printf("Resource directory: %s\n", path.as_native());
+
+        test_mode("sequential", &path, 0, 0);
+        test_mode("parallel", &path, 0x4000, 4);
+        test_mode("blocks", &path, 0x4000, 1);
+    }
+
 UTEST_END
 
 